@@ -33,9 +33,12 @@
  * description: The BackendDAEEXT.cpp file is the external implementation of
  *              MetaModelica package: Compiler/BackendDAEEXT.mo.
  *              This is used for the BLT and index reduction algorithms in BackendDAE.
- *              The implementation mainly consists of several bitvectors implemented
- *              using std::vector<bool> since such functionality is not available in
- *              MetaModelica Compiler (MMC).
+ *              All state lives in a BackendDAEEXT_Workspace: marks are
+ *              epoch-stamped index arrays, the matching works on a CSR copy
+ *              of the incidence matrix, and the strong components are found
+ *              with an iterative Tarjan over CSR adjacency. Functions without
+ *              an explicit workspace use one workspace per thread, so backend
+ *              passes on different equation systems may run concurrently.
  *
  *
  */
@@ -43,308 +46,416 @@
 #include <iostream>
 #include <fstream>
 #include <map>
-#include <set>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
 
+using namespace std;
 
-static std::set<int> e_mark;
-static std::set<int> differentiated_mark;
-static std::set<int> v_mark;
+/* A set of non-negative indices. Marking and testing are array lookups;
+ * clearing bumps the epoch instead of touching the stamps. */
+class IndexMarks
+{
+public:
+  IndexMarks() : epoch(1) {}
 
-static std::vector<int> number;
-static std::vector<int> lowlink;
-static std::vector<int> v;
-static std::vector<int> f;
+  void reserve(int size)
+  {
+    if (size > 0 && (size_t)size >= stamp.size()) {
+      stamp.resize(size+1, 0);
+    }
+  }
 
-using namespace std;
+  void clear()
+  {
+    marked.clear();
+    if (++epoch == 0) {
+      std::fill(stamp.begin(), stamp.end(), 0);
+      epoch = 1;
+    }
+  }
+
+  void mark(int i)
+  {
+    if (i < 0) return;
+    if ((size_t)i >= stamp.size()) {
+      stamp.resize(std::max((size_t)i+1, 2*stamp.size()), 0);
+    }
+    if (stamp[i] != epoch) {
+      stamp[i] = epoch;
+      marked.push_back(i);
+    }
+  }
+
+  bool get(int i) const
+  {
+    return i >= 0 && (size_t)i < stamp.size() && stamp[i] == epoch;
+  }
+
+  /* The marked indices in increasing order */
+  const std::vector<int>& sorted()
+  {
+    std::sort(marked.begin(), marked.end());
+    return marked;
+  }
+
+private:
+  std::vector<unsigned int> stamp;
+  std::vector<int> marked;
+  unsigned int epoch;
+};
 
 extern "C" {
 #include "matchmaker.h"
 
-static unsigned int n=0; /* size of match */
-static unsigned int m=0; /* size of row_match */
-static int* match=NULL;
-static int* row_match=NULL;
-static int* col_ptrs=NULL;
-static int* col_ids=NULL;
+typedef struct BackendDAEEXT_Workspace
+{
+  BackendDAEEXT_Workspace() : n(0), m(0), match(NULL), row_match(NULL), nvars(0), neqns(0), col_ptrs(NULL), col_ids(NULL) {}
+  ~BackendDAEEXT_Workspace()
+  {
+    if (match) free(match);
+    if (row_match) free(row_match);
+    if (col_ptrs) free(col_ptrs);
+    if (col_ids) free(col_ids);
+  }
 
-void BackendDAEEXTImpl__initMarks(int nvars, int neqns)
+  IndexMarks e_mark;
+  IndexMarks differentiated_mark;
+  IndexMarks v_mark;
+
+  std::vector<int> number;
+  std::vector<int> lowlink;
+  std::vector<int> v;
+  std::vector<int> f;
+
+  unsigned int n; /* size of match */
+  unsigned int m; /* size of row_match */
+  int* match;
+  int* row_match;
+  int nvars; /* size of the incidence matrix in col_ptrs/col_ids */
+  int neqns;
+  int* col_ptrs;
+  int* col_ids;
+
+  /* CSR graph and scratch space of BackendDAEEXTImpl__tarjan */
+  std::vector<int> graph_ptr;
+  std::vector<int> graph_adj;
+  std::vector<int> roots;
+  std::vector<int> scc_number;
+  std::vector<int> scc_lowlink;
+  std::vector<char> scc_onstack;
+  std::vector<int> scc_stack;
+  std::vector<std::pair<int,int> > scc_frames;
+  std::vector<int> comp_ptr;   /* component i is comp_nodes[comp_ptr[i]:comp_ptr[i+1]] */
+  std::vector<int> comp_nodes;
+} BackendDAEEXT_Workspace;
+
+static pthread_once_t backenddaeext_once_create_key = PTHREAD_ONCE_INIT;
+static pthread_key_t backenddaeextKey;
+
+static void free_workspace(void *data)
 {
-// Why are the inputs not even used?
-  v_mark.clear();
-  e_mark.clear();
+  delete (BackendDAEEXT_Workspace*) data;
 }
 
-void BackendDAEEXTImpl__eMark(int i)
+static void make_key()
 {
-  e_mark.insert(e_mark.begin(),i);
+  pthread_key_create(&backenddaeextKey,free_workspace);
 }
 
-void BackendDAEEXTImpl__vMark(int i)
+/* The workspace used by the functions that do not take one explicitly */
+static BackendDAEEXT_Workspace* BackendDAEEXTImpl__defaultWorkspace()
 {
-  v_mark.insert(v_mark.begin(),i);
+  pthread_once(&backenddaeext_once_create_key,make_key);
+  BackendDAEEXT_Workspace *ws = (BackendDAEEXT_Workspace*) pthread_getspecific(backenddaeextKey);
+  if (ws == NULL) {
+    ws = new BackendDAEEXT_Workspace();
+    pthread_setspecific(backenddaeextKey,ws);
+  }
+  return ws;
 }
 
-int BackendDAEEXTImpl__getVMark(int i)
+static void* BackendDAEEXTImpl__newWorkspace()
 {
-  return v_mark.find(i) != v_mark.end();
+  return new BackendDAEEXT_Workspace();
 }
 
-int BackendDAEEXTImpl__getEMark(int i)
+static void BackendDAEEXTImpl__freeWorkspace(void *ws)
 {
-  //cout << "get_e_mark[" << i << "] == " << e_mark[i-1] << endl;
-  return e_mark.find(i) != e_mark.end();
+  delete (BackendDAEEXT_Workspace*) ws;
 }
 
-void* BackendDAEEXTImpl__getMarkedEqns()
+static void* marksToList(IndexMarks &marks)
 {
-  std::set<int>::iterator it;
+  const std::vector<int> &lst = marks.sorted();
   void *res = mmc_mk_nil();
-  for (it=e_mark.begin(); it != e_mark.end(); it++) {
+  for (std::vector<int>::const_iterator it=lst.begin(); it != lst.end(); it++) {
     res = mmc_mk_cons(mmc_mk_icon(*it),res);
   }
   return res;
 }
 
-void BackendDAEEXTImpl__markDifferentiated(int i)
+void BackendDAEEXTImpl__initMarks(BackendDAEEXT_Workspace *ws, int nvars, int neqns)
 {
-  differentiated_mark.insert(differentiated_mark.begin(),i);
+  ws->v_mark.clear();
+  ws->e_mark.clear();
+  ws->v_mark.reserve(nvars);
+  ws->e_mark.reserve(neqns);
 }
 
-void BackendDAEEXTImpl__clearDifferentiated()
+void BackendDAEEXTImpl__eMark(BackendDAEEXT_Workspace *ws, int i)
 {
-  differentiated_mark.clear();
+  ws->e_mark.mark(i);
 }
 
-void* BackendDAEEXTImpl__getDifferentiatedEqns()
+void BackendDAEEXTImpl__vMark(BackendDAEEXT_Workspace *ws, int i)
 {
-  std::set<int>::iterator it;
-  void *res = mmc_mk_nil();
-  for (it=differentiated_mark.begin(); it != differentiated_mark.end(); it++) {
-    res = mmc_mk_cons(mmc_mk_icon(*it),res);
-  }
-  return res;
+  ws->v_mark.mark(i);
 }
 
-void* BackendDAEEXTImpl__getMarkedVariables()
+int BackendDAEEXTImpl__getVMark(BackendDAEEXT_Workspace *ws, int i)
 {
-  std::set<int>::iterator it;
-  void *res = mmc_mk_nil();
-  for (it=v_mark.begin(); it != v_mark.end(); it++) {
-    res = mmc_mk_cons(mmc_mk_icon(*it),res);
-  }
-  return res;
+  return ws->v_mark.get(i);
 }
 
-void BackendDAEEXTImpl__initLowLink(int nvars)
+int BackendDAEEXTImpl__getEMark(BackendDAEEXT_Workspace *ws, int i)
 {
-  //cout << "init lowlink n= " << nvars << endl;
-  lowlink.reserve(nvars);
+  return ws->e_mark.get(i);
+}
 
-  while (lowlink.size() < (unsigned int)nvars)
-    lowlink.push_back(0);
-  for (int i =0; i < nvars; i++)
-    lowlink[i]=0;
+void* BackendDAEEXTImpl__getMarkedEqns(BackendDAEEXT_Workspace *ws)
+{
+  return marksToList(ws->e_mark);
 }
 
-void BackendDAEEXTImpl__initNumber(int nvars)
+void BackendDAEEXTImpl__markDifferentiated(BackendDAEEXT_Workspace *ws, int i)
 {
-  //cout << "init number n= " << nvars << endl;
-  number.reserve(nvars);
+  ws->differentiated_mark.mark(i);
+}
 
-  while (number.size() < (unsigned int)nvars)
-    number.push_back(0);
-  for (int i =0; i < nvars; i++)
-    number[i]=0;
+void BackendDAEEXTImpl__clearDifferentiated(BackendDAEEXT_Workspace *ws)
+{
+  ws->differentiated_mark.clear();
 }
 
-void BackendDAEEXTImpl__setLowLink(int i, int val)
+void* BackendDAEEXTImpl__getDifferentiatedEqns(BackendDAEEXT_Workspace *ws)
 {
-  lowlink[i-1]=val;
+  return marksToList(ws->differentiated_mark);
 }
 
-void BackendDAEEXTImpl__setNumber(int i, int val)
+void* BackendDAEEXTImpl__getMarkedVariables(BackendDAEEXT_Workspace *ws)
 {
-  number[i-1]=val;
+  return marksToList(ws->v_mark);
 }
 
-int BackendDAEEXTImpl__getNumber(int i)
+void BackendDAEEXTImpl__initLowLink(BackendDAEEXT_Workspace *ws, int nvars)
 {
-  return number[i-1];
+  ws->lowlink.assign(std::max(nvars,0), 0);
 }
 
-int BackendDAEEXTImpl__getLowLink(int i)
+void BackendDAEEXTImpl__initNumber(BackendDAEEXT_Workspace *ws, int nvars)
 {
-  return lowlink[i-1];
+  ws->number.assign(std::max(nvars,0), 0);
 }
 
-void BackendDAEEXTImpl__dumpMarkedEquations(int nvars)
+void BackendDAEEXTImpl__setLowLink(BackendDAEEXT_Workspace *ws, int i, int val)
 {
+  ws->lowlink[i-1]=val;
+}
+
+void BackendDAEEXTImpl__setNumber(BackendDAEEXT_Workspace *ws, int i, int val)
+{
+  ws->number[i-1]=val;
+}
+
+int BackendDAEEXTImpl__getNumber(BackendDAEEXT_Workspace *ws, int i)
+{
+  return ws->number[i-1];
+}
+
+int BackendDAEEXTImpl__getLowLink(BackendDAEEXT_Workspace *ws, int i)
+{
+  return ws->lowlink[i-1];
+}
+
+void BackendDAEEXTImpl__dumpMarkedEquations(BackendDAEEXT_Workspace *ws, int nvars)
+{
+  const std::vector<int> &lst = ws->e_mark.sorted();
   cout << "marked equations" << endl << "================" << endl;
-  for (std::set<int>::iterator i =e_mark.begin() ; i != e_mark.end(); i++)
+  for (std::vector<int>::const_iterator i =lst.begin() ; i != lst.end(); i++)
     cout << "eqn " << *i << endl;
 }
 
-void BackendDAEEXTImpl__dumpMarkedVariables(int nvars)
+void BackendDAEEXTImpl__dumpMarkedVariables(BackendDAEEXT_Workspace *ws, int nvars)
 {
+  const std::vector<int> &lst = ws->v_mark.sorted();
   cout << "marked variables" << endl << "================" << endl;
-  for (std::set<int>::iterator i =v_mark.begin() ; i != v_mark.end(); i++)
+  for (std::vector<int>::const_iterator i =lst.begin() ; i != lst.end(); i++)
     cout << "var " << *i << endl;
 }
 
-void BackendDAEEXTImpl__initV(int size)
+void BackendDAEEXTImpl__initV(BackendDAEEXT_Workspace *ws, int size)
 {
-  v.reserve(size);
+  ws->v.reserve(size);
 }
 
-void BackendDAEEXTImpl__initF(int size)
+void BackendDAEEXTImpl__initF(BackendDAEEXT_Workspace *ws, int size)
 {
-  f.reserve(size);
+  ws->f.reserve(size);
 }
 
-void BackendDAEEXTImpl__setF(int i, int val)
+void BackendDAEEXTImpl__setF(BackendDAEEXT_Workspace *ws, int i, int val)
 {
-  if (i > f.size()) { f.resize(i); }
-  f[i-1]=val;
+  if (i > ws->f.size()) { ws->f.resize(i); }
+  ws->f[i-1]=val;
 }
 
-int BackendDAEEXTImpl__getF(int i)
+int BackendDAEEXTImpl__getF(BackendDAEEXT_Workspace *ws, int i)
 {
-  assert(i <= f.size());
-  return f[i-1];
+  assert(i <= ws->f.size());
+  return ws->f[i-1];
 }
 
-void BackendDAEEXTImpl__setV(int i, int val)
+void BackendDAEEXTImpl__setV(BackendDAEEXT_Workspace *ws, int i, int val)
 {
-  if ( i > v.size() ) { v.resize(i); }
-  v[i-1]=val;
+  if ( i > ws->v.size() ) { ws->v.resize(i); }
+  ws->v[i-1]=val;
 }
 
-int BackendDAEEXTImpl__getV(int i)
+int BackendDAEEXTImpl__getV(BackendDAEEXT_Workspace *ws, int i)
 {
-  assert(i <= v.size());
-  return v[i-1];
+  assert(i <= ws->v.size());
+  return ws->v[i-1];
 }
 
-void BackendDAEExtImpl__cheapmatching(int nvars, int neqns, int cheapID, int clear_match)
+/* Makes match/row_match hold at least neqns/nvars entries. Unless
+ * clear_match is set, existing assignments are kept and new entries are
+ * unassigned (-1); otherwise everything is unassigned. */
+static void BackendDAEExtImpl__prepareMatching(BackendDAEEXT_Workspace *ws, int nvars, int neqns, int clear_match)
 {
-  int i=0;
-  if (clear_match==0){
-    if (neqns>n) {
-      if(match)
-      {
-        int* tmp = (int*) malloc(neqns * sizeof(int));
-        memcpy(tmp,match,n*sizeof(int));
-        free(match);
-        match = tmp;
-        for (i = n; i < neqns; i++) {
-          match[i] = -1;
-        }
-      } else {
-         match = (int*) malloc(neqns * sizeof(int));
-         memset(match,-1,neqns * sizeof(int));
+  unsigned int i;
+  if (clear_match==0) {
+    if (neqns>ws->n) {
+      ws->match = (int*) realloc(ws->match, neqns * sizeof(int));
+      for (i = ws->n; i < neqns; i++) {
+        ws->match[i] = -1;
       }
-      n = neqns;
+      ws->n = neqns;
     }
-    if (nvars>m) {
-      if(row_match)
-      {
-        int* tmp = (int*) malloc(nvars * sizeof(int));
-        memcpy(tmp,row_match,m*sizeof(int));
-        free(row_match);
-        row_match = tmp;
-        for (i = m; i < nvars; i++) {
-          row_match[i] = -1;
-        }
-      } else {
-        row_match = (int*) malloc(nvars * sizeof(int));
-         memset(row_match,-1,nvars * sizeof(int));
+    if (nvars>ws->m) {
+      ws->row_match = (int*) realloc(ws->row_match, nvars * sizeof(int));
+      for (i = ws->m; i < nvars; i++) {
+        ws->row_match[i] = -1;
       }
-      m = nvars;
+      ws->m = nvars;
     }
-  }
-  else {
-  if (neqns>n) {
-      if (match) free(match);
-      match = (int*) malloc(neqns * sizeof(int));
-      memset(match,-1,neqns * sizeof(int));
   } else {
-      memset(match,-1,n * sizeof(int));
-  }
-    n = neqns;
-    if (nvars>m) {
-      if (row_match) free(row_match);
-      row_match = (int*) malloc(nvars * sizeof(int));
-      memset(row_match,-1,nvars * sizeof(int));
+    if (neqns>ws->n || ws->match == NULL) {
+      if (ws->match) free(ws->match);
+      ws->match = (int*) malloc(std::max(neqns,1) * sizeof(int));
+      memset(ws->match,-1,neqns * sizeof(int));
+    } else {
+      memset(ws->match,-1,ws->n * sizeof(int));
+    }
+    ws->n = neqns;
+    if (nvars>ws->m || ws->row_match == NULL) {
+      if (ws->row_match) free(ws->row_match);
+      ws->row_match = (int*) malloc(std::max(nvars,1) * sizeof(int));
+      memset(ws->row_match,-1,nvars * sizeof(int));
     } else {
-      memset(row_match,-1,m * sizeof(int));
+      memset(ws->row_match,-1,ws->m * sizeof(int));
     }
-    m = nvars;
+    ws->m = nvars;
   }
-  if ((match != NULL) && (row_match != NULL)) {
-    cheapmatching(col_ptrs,col_ids,match,row_match,neqns,nvars,cheapID,0 /*clear_match already done*/);
+}
+
+void BackendDAEExtImpl__cheapmatching(BackendDAEEXT_Workspace *ws, int nvars, int neqns, int cheapID, int clear_match)
+{
+  BackendDAEExtImpl__prepareMatching(ws, nvars, neqns, clear_match);
+  if ((ws->match != NULL) && (ws->row_match != NULL)) {
+    cheapmatching(ws->col_ptrs,ws->col_ids,ws->match,ws->row_match,neqns,nvars,cheapID,0 /*clear_match already done*/);
+  }
+}
+
+void BackendDAEExtImpl__matching(BackendDAEEXT_Workspace *ws, int nvars, int neqns, int matchingID, int cheapID, double relabel_period, int clear_match)
+{
+  BackendDAEExtImpl__prepareMatching(ws, nvars, neqns, clear_match);
+  if ((ws->match != NULL) && (ws->row_match != NULL)) {
+    matching(ws->col_ptrs,ws->col_ids,ws->match,ws->row_match,neqns,nvars,matchingID,cheapID,relabel_period,0 /*clear_match already done*/);
   }
 }
 
-void BackendDAEExtImpl__matching(int nvars, int neqns, int matchingID, int cheapID, double relabel_period, int clear_match)
+/* Strongly connected components of the graph with nodes 0..N-1 stored in
+ * ws->graph_ptr/graph_adj (CSR), visiting the nodes ws->roots in order.
+ * The components are stored in ws->comp_ptr/comp_nodes in the order they are
+ * completed, the nodes of each component in the order they leave the stack.
+ * This is Tarjan's algorithm with an explicit stack of (node, next edge)
+ * frames, giving exactly the result of the recursive formulation. */
+static void BackendDAEEXTImpl__tarjan(BackendDAEEXT_Workspace *ws, int N)
 {
-  int i=0;
-  if (clear_match==0){
-    if (neqns>n) {
-      if(match)
-      {
-        int* tmp = (int*) malloc(neqns * sizeof(int));
-        memcpy(tmp,match,n*sizeof(int));
-        free(match);
-        match = tmp;
-        for (i = n; i < neqns; i++) {
-          match[i] = -1;
+  const int *ptr = ws->graph_ptr.empty() ? NULL : &ws->graph_ptr[0];
+  const int *adj = ws->graph_adj.empty() ? NULL : &ws->graph_adj[0];
+  std::vector<int> &number = ws->scc_number;
+  std::vector<int> &lowlink = ws->scc_lowlink;
+  std::vector<char> &onStack = ws->scc_onstack;
+  std::vector<int> &stack = ws->scc_stack;
+  std::vector<std::pair<int,int> > &frames = ws->scc_frames;
+  int index = 0;
+
+  number.assign(N, -1);
+  lowlink.assign(N, -1);
+  onStack.assign(N, 0);
+  stack.clear();
+  frames.clear();
+  ws->comp_ptr.assign(1, 0);
+  ws->comp_nodes.clear();
+
+  for (std::vector<int>::const_iterator root = ws->roots.begin(); root != ws->roots.end(); root++) {
+    if (number[*root] != -1) continue;
+    number[*root] = lowlink[*root] = index++;
+    onStack[*root] = 1;
+    stack.push_back(*root);
+    frames.push_back(std::make_pair(*root, ptr[*root]));
+
+    while (!frames.empty()) {
+      int v = frames.back().first;
+      int pos = frames.back().second;
+      if (pos < ptr[v+1]) {
+        int w = adj[pos];
+        frames.back().second = pos+1;
+        if (number[w] == -1) {
+          /* Successor w has not yet been visited; descend into it */
+          number[w] = lowlink[w] = index++;
+          onStack[w] = 1;
+          stack.push_back(w);
+          frames.push_back(std::make_pair(w, ptr[w]));
+        } else if (onStack[w]) {
+          /* Successor w is in the stack and hence in the current SCC */
+          lowlink[v] = std::min(lowlink[v], number[w]);
         }
-      } else {
-         match = (int*) malloc(neqns * sizeof(int));
-         memset(match,-1,neqns * sizeof(int));
+        continue;
       }
-      n = neqns;
-    }
-    if (nvars>m) {
-      if(row_match)
-      {
-        int* tmp = (int*) malloc(nvars * sizeof(int));
-        memcpy(tmp,row_match,m*sizeof(int));
-        free(row_match);
-        row_match = tmp;
-        for (i = m; i < nvars; i++) {
-          row_match[i] = -1;
-        }
-      } else {
-        row_match = (int*) malloc(nvars * sizeof(int));
-         memset(row_match,-1,nvars * sizeof(int));
+      /* If v is a root node, pop the stack and generate an SCC */
+      if (lowlink[v] == number[v]) {
+        int w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          onStack[w] = 0;
+          ws->comp_nodes.push_back(w);
+        } while (w != v);
+        ws->comp_ptr.push_back(ws->comp_nodes.size());
+      }
+      frames.pop_back();
+      if (!frames.empty()) {
+        int u = frames.back().first;
+        lowlink[u] = std::min(lowlink[u], lowlink[v]);
       }
-      m = nvars;
-    }
-  }
-  else {
-    if (neqns>n) {
-      if (match) free(match);
-      match = (int*) malloc(neqns * sizeof(int));
-      memset(match,-1,neqns * sizeof(int));
-    } else {
-      memset(match,-1,n * sizeof(int));
-    }
-    n = neqns;
-    if (nvars>m) {
-      if (row_match) free(row_match);
-      row_match = (int*) malloc(nvars * sizeof(int));
-      memset(row_match,-1,nvars * sizeof(int));
-    } else {
-      memset(row_match,-1,m * sizeof(int));
     }
-    m = nvars;
-  }
-  if ((match != NULL) && (row_match != NULL)) {
-    matching(col_ptrs,col_ids,match,row_match,neqns,nvars,matchingID,cheapID,relabel_period,0 /*clear_match already done*/);
   }
 }
 
@@ -33,9 +33,8 @@
  * description: The BackendDAEEXT.cpp file is the external implementation of
  *              MetaModelica package: Compiler/BackendDAEEXT.mo.
  *              This is used for the BLT and index reduction algorithms in BackendDAE.
- *              The implementation mainly consists of several bitvectors implemented
- *              using std::vector<bool> since such functionality is not available in
- *              MetaModelica Compiler (MMC).
+ *              The functions taking a Workspace operate on that handle; all
+ *              others use the workspace of the calling thread.
  *
  *
  */
@@ -47,162 +46,332 @@
 
 extern "C" {
 
+#define DEFAULT_WS BackendDAEEXTImpl__defaultWorkspace()
+
 extern int BackendDAEEXT_getVMark(int _inInteger)
 {
-  return BackendDAEEXTImpl__getVMark(_inInteger);
+  return BackendDAEEXTImpl__getVMark(DEFAULT_WS, _inInteger);
 }
 extern void* BackendDAEEXT_getMarkedEqns()
 {
-  return BackendDAEEXTImpl__getMarkedEqns();
+  return BackendDAEEXTImpl__getMarkedEqns(DEFAULT_WS);
 }
 extern void BackendDAEEXT_eMark(int _inInteger)
 {
-  BackendDAEEXTImpl__eMark(_inInteger);
+  BackendDAEEXTImpl__eMark(DEFAULT_WS, _inInteger);
 }
 extern void BackendDAEEXT_clearDifferentiated()
 {
-  BackendDAEEXTImpl__clearDifferentiated();
+  BackendDAEEXTImpl__clearDifferentiated(DEFAULT_WS);
 }
 extern void* BackendDAEEXT_getDifferentiatedEqns()
 {
-  return BackendDAEEXTImpl__getDifferentiatedEqns();
+  return BackendDAEEXTImpl__getDifferentiatedEqns(DEFAULT_WS);
 }
 extern int BackendDAEEXT_getLowLink(int _inInteger)
 {
-  return BackendDAEEXTImpl__getLowLink(_inInteger);
+  return BackendDAEEXTImpl__getLowLink(DEFAULT_WS, _inInteger);
 }
 extern void* BackendDAEEXT_getMarkedVariables()
 {
-  return BackendDAEEXTImpl__getMarkedVariables();
+  return BackendDAEEXTImpl__getMarkedVariables(DEFAULT_WS);
 }
 extern int BackendDAEEXT_getNumber(int _inInteger)
 {
-  return BackendDAEEXTImpl__getNumber(_inInteger);
+  return BackendDAEEXTImpl__getNumber(DEFAULT_WS, _inInteger);
 }
 extern void BackendDAEEXT_setNumber(int _inInteger1, int _inInteger2)
 {
-  BackendDAEEXTImpl__setNumber(_inInteger1, _inInteger2);
+  BackendDAEEXTImpl__setNumber(DEFAULT_WS, _inInteger1, _inInteger2);
 }
 extern void BackendDAEEXT_initMarks(int _inInteger1, int _inInteger2)
 {
-  BackendDAEEXTImpl__initMarks(_inInteger1, _inInteger2);
+  BackendDAEEXTImpl__initMarks(DEFAULT_WS, _inInteger1, _inInteger2);
 }
 extern void BackendDAEEXT_initLowLink(int _inInteger)
 {
-  BackendDAEEXTImpl__initLowLink(_inInteger);
+  BackendDAEEXTImpl__initLowLink(DEFAULT_WS, _inInteger);
 }
 extern void BackendDAEEXT_markDifferentiated(int _inInteger)
 {
-  BackendDAEEXTImpl__markDifferentiated(_inInteger);
+  BackendDAEEXTImpl__markDifferentiated(DEFAULT_WS, _inInteger);
 }
 extern void BackendDAEEXT_initNumber(int _inInteger)
 {
-  BackendDAEEXTImpl__initNumber(_inInteger);
+  BackendDAEEXTImpl__initNumber(DEFAULT_WS, _inInteger);
 }
 extern void BackendDAEEXT_setLowLink(int _inInteger1, int _inInteger2)
 {
-  BackendDAEEXTImpl__setLowLink(_inInteger1, _inInteger2);
+  BackendDAEEXTImpl__setLowLink(DEFAULT_WS, _inInteger1, _inInteger2);
 }
 extern void BackendDAEEXT_vMark(int _inInteger)
 {
-  BackendDAEEXTImpl__vMark(_inInteger);
+  BackendDAEEXTImpl__vMark(DEFAULT_WS, _inInteger);
 }
 
-extern void BackendDAEEXT_setIncidenceMatrix(modelica_integer nvars, modelica_integer neqns, modelica_integer nz, modelica_metatype incidencematrix)
+extern void* BackendDAEEXT_newWorkspace()
+{
+  return BackendDAEEXTImpl__newWorkspace();
+}
+
+extern void BackendDAEEXT_freeWorkspace(void *ws)
+{
+  BackendDAEEXTImpl__freeWorkspace(ws);
+}
+
+static void setIncidenceMatrix(BackendDAEEXT_Workspace *ws, modelica_integer nvars, modelica_integer neqns, modelica_integer nz, modelica_metatype incidencematrix)
 {
   int i=0;
   mmc_sint_t i1;
   int j=0;
-  modelica_integer nelts = MMC_HDRSLOTS(MMC_GETHDR(incidencematrix));
 
-  if (col_ptrs) free(col_ptrs);
-  col_ptrs = (int*) malloc((neqns+1) * sizeof(int));
-  col_ptrs[neqns]=nz;
-  if (col_ids) free(col_ids);
-  col_ids = (int*) malloc(nz * sizeof(int));
+  ws->nvars = nvars;
+  ws->neqns = neqns;
+  if (ws->col_ptrs) free(ws->col_ptrs);
+  ws->col_ptrs = (int*) malloc((neqns+1) * sizeof(int));
+  ws->col_ptrs[neqns]=nz;
+  if (ws->col_ids) free(ws->col_ids);
+  ws->col_ids = (int*) malloc(nz * sizeof(int));
 
   for(i=0; i<neqns; ++i) {
     modelica_metatype ie = MMC_STRUCTDATA(incidencematrix)[i];
-    col_ptrs[i] = j;
+    ws->col_ptrs[i] = j;
     while(MMC_GETHDR(ie) == MMC_CONSHDR) {
       i1 = MMC_UNTAGFIXNUM(MMC_CAR(ie));
       if (i1>0) {
-        col_ids[j++] = (int)i1-1;
+        ws->col_ids[j++] = (int)i1-1;
       }
       ie = MMC_CDR(ie);
     }
   }
 }
 
-extern void BackendDAEEXT_matching(modelica_integer nv, modelica_integer ne, modelica_integer matchingID, modelica_integer cheapID, modelica_real relabel_period, modelica_integer clear_match)
-{
-  int i=0;
-  BackendDAEExtImpl__matching(nv, ne, matchingID, cheapID, relabel_period, clear_match);
-}
-
-extern void BackendDAEEXT_getAssignment(modelica_metatype ass1, modelica_metatype ass2)
+static void getAssignment(BackendDAEEXT_Workspace *ws, modelica_metatype ass1, modelica_metatype ass2)
 {
   int i=0;
   mmc_uint_t len1 = MMC_HDRSLOTS(MMC_GETHDR(ass1));
   mmc_uint_t len2 = MMC_HDRSLOTS(MMC_GETHDR(ass2));
-  if (n > len1 || m > len2) {
+  if (ws->n > len1 || ws->m > len2) {
     char nstr[64],mstr[64],len1str[64],len2str[64];
     const char *tokens[4] = {len2str,mstr,len1str,nstr};
-    snprintf(nstr,64,"%ld", (long) n);
-    snprintf(mstr,64,"%ld", (long) m);
+    snprintf(nstr,64,"%ld", (long) ws->n);
+    snprintf(mstr,64,"%ld", (long) ws->m);
     snprintf(len1str,64,"%ld", (long) len1);
     snprintf(len2str,64,"%ld", (long) len2);
     c_add_message(NULL,-1,ErrorType_symbolic,ErrorLevel_internal,"BackendDAEEXT.getAssignment failed because n=%s>arrayLength(ass1)=%s or m=%s>arrayLength(ass2)=%s",tokens,4);
     MMC_THROW();
   }
-  if (match != NULL) {
-    for(i=0; i<n; ++i) {
-      if (match[i] >= 0)
-        MMC_STRUCTDATA(ass1)[i] = mmc_mk_icon(match[i]+1);
+  if (ws->match != NULL) {
+    for(i=0; i<ws->n; ++i) {
+      if (ws->match[i] >= 0)
+        MMC_STRUCTDATA(ass1)[i] = mmc_mk_icon(ws->match[i]+1);
       else
         MMC_STRUCTDATA(ass1)[i] = mmc_mk_icon(-1);
     }
   }
-  if (row_match != NULL) {
-    for(i=0; i<m; ++i) {
-      if (row_match[i] >= 0)
-        MMC_STRUCTDATA(ass2)[i] = mmc_mk_icon(row_match[i]+1);
+  if (ws->row_match != NULL) {
+    for(i=0; i<ws->m; ++i) {
+      if (ws->row_match[i] >= 0)
+        MMC_STRUCTDATA(ass2)[i] = mmc_mk_icon(ws->row_match[i]+1);
       else
         MMC_STRUCTDATA(ass2)[i] = mmc_mk_icon(-1);
     }
   }
 }
 
-extern int BackendDAEEXT_setAssignment(int lenass1, int lenass2, modelica_metatype ass1, modelica_metatype ass2)
+static int setAssignment(BackendDAEEXT_Workspace *ws, int lenass1, int lenass2, modelica_metatype ass1, modelica_metatype ass2)
 {
   int nelts=0;
   int i=0;
 
   nelts = MMC_HDRSLOTS(MMC_GETHDR(ass1));
   if (nelts > 0) {
-    n = lenass1;
-    if(match) {
-      free(match);
+    ws->n = lenass1;
+    if(ws->match) {
+      free(ws->match);
     }
-    match = (int*) malloc(n * sizeof(int));
-    for(i=0; i<n; ++i) {
-      match[i] = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[i])-1;
-      if (match[i]<0) match[i] = -1;
+    ws->match = (int*) malloc(ws->n * sizeof(int));
+    for(i=0; i<ws->n; ++i) {
+      ws->match[i] = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[i])-1;
+      if (ws->match[i]<0) ws->match[i] = -1;
     }
   }
   nelts = MMC_HDRSLOTS(MMC_GETHDR(ass2));
   if (nelts > 0) {
-    m = lenass2;
-    if(row_match) {
-      free(row_match);
+    ws->m = lenass2;
+    if(ws->row_match) {
+      free(ws->row_match);
     }
-    row_match = (int*) malloc(m * sizeof(int));
-    for(i=0; i<m; ++i) {
-      row_match[i] = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass2)[i])-1;
-      if (row_match[i]<0) row_match[i] = -1;
+    ws->row_match = (int*) malloc(ws->m * sizeof(int));
+    for(i=0; i<ws->m; ++i) {
+      ws->row_match[i] = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass2)[i])-1;
+      if (ws->row_match[i]<0) ws->row_match[i] = -1;
     }
   }
   return 1;
 }
 
+extern void BackendDAEEXT_setIncidenceMatrix(modelica_integer nvars, modelica_integer neqns, modelica_integer nz, modelica_metatype incidencematrix)
+{
+  setIncidenceMatrix(DEFAULT_WS, nvars, neqns, nz, incidencematrix);
+}
+
+extern void BackendDAEEXT_matching(modelica_integer nv, modelica_integer ne, modelica_integer matchingID, modelica_integer cheapID, modelica_real relabel_period, modelica_integer clear_match)
+{
+  BackendDAEExtImpl__matching(DEFAULT_WS, nv, ne, matchingID, cheapID, relabel_period, clear_match);
+}
+
+extern void BackendDAEEXT_getAssignment(modelica_metatype ass1, modelica_metatype ass2)
+{
+  getAssignment(DEFAULT_WS, ass1, ass2);
+}
+
+extern void BackendDAEEXT_setMatchingThreads(modelica_integer numThreads)
+{
+  matching_set_num_threads(numThreads);
+}
+
+extern void BackendDAEEXT_writeIncidenceMatrix(const char *fileName)
+{
+  BackendDAEEXT_Workspace *ws = DEFAULT_WS;
+  FILE *file;
+  int i, j, neqns = ws->neqns;
+
+  if (ws->col_ptrs == NULL) return;
+  file = fopen(fileName, "w");
+  if (file == NULL) {
+    const char *tokens[1] = {fileName};
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,"Failed to open file %s for writing.",tokens,1);
+    MMC_THROW();
+  }
+  fprintf(file, "%%%%MatrixMarket matrix coordinate pattern general\n%d %d %d\n", ws->nvars, neqns, ws->col_ptrs[neqns]);
+  for (i=0; i<neqns; ++i) {
+    for (j=ws->col_ptrs[i]; j<ws->col_ptrs[i+1]; ++j) {
+      fprintf(file, "%d %d\n", ws->col_ids[j]+1, i+1);
+    }
+  }
+  fclose(file);
+}
+
+extern int BackendDAEEXT_setAssignment(int lenass1, int lenass2, modelica_metatype ass1, modelica_metatype ass2)
+{
+  return setAssignment(DEFAULT_WS, lenass1, lenass2, ass1, ass2);
+}
+
+extern void BackendDAEEXT_wsSetIncidenceMatrix(void *ws, modelica_integer nvars, modelica_integer neqns, modelica_integer nz, modelica_metatype incidencematrix)
+{
+  setIncidenceMatrix((BackendDAEEXT_Workspace*) ws, nvars, neqns, nz, incidencematrix);
+}
+
+extern void BackendDAEEXT_wsMatching(void *ws, modelica_integer nv, modelica_integer ne, modelica_integer matchingID, modelica_integer cheapID, modelica_real relabel_period, modelica_integer clear_match)
+{
+  BackendDAEExtImpl__matching((BackendDAEEXT_Workspace*) ws, nv, ne, matchingID, cheapID, relabel_period, clear_match);
+}
+
+extern void BackendDAEEXT_wsGetAssignment(void *ws, modelica_metatype ass1, modelica_metatype ass2)
+{
+  getAssignment((BackendDAEEXT_Workspace*) ws, ass1, ass2);
+}
+
+extern int BackendDAEEXT_wsSetAssignment(void *ws, int lenass1, int lenass2, modelica_metatype ass1, modelica_metatype ass2)
+{
+  return setAssignment((BackendDAEEXT_Workspace*) ws, lenass1, lenass2, ass1, ass2);
+}
+
+static void tarjanIndexError(const char *fn, const char *what, mmc_sint_t index, mmc_uint_t len)
+{
+  char indexstr[64],lenstr[64];
+  const char *tokens[4] = {lenstr,indexstr,what,fn};
+  snprintf(indexstr,64,"%ld", (long) index);
+  snprintf(lenstr,64,"%ld", (long) len);
+  c_add_message(NULL,-1,ErrorType_symbolic,ErrorLevel_internal,"BackendDAEEXT.%s failed because %s %s is out of range 1..%s",tokens,4);
+  MMC_THROW();
+}
+
+/* Builds a list of the components found by BackendDAEEXTImpl__tarjan, in the
+ * order they were completed (or the reverse order), with 1-based indices. */
+static modelica_metatype componentsToList(BackendDAEEXT_Workspace *ws, int reverse)
+{
+  modelica_metatype res = mmc_mk_nil();
+  int ncomps = ws->comp_ptr.size()-1;
+  for (int k=0; k<ncomps; ++k) {
+    int c = reverse ? k : ncomps-1-k;
+    modelica_metatype comp = mmc_mk_nil();
+    for (int j=ws->comp_ptr[c+1]-1; j>=ws->comp_ptr[c]; --j) {
+      comp = mmc_mk_cons(mmc_mk_icon(ws->comp_nodes[j]+1), comp);
+    }
+    res = mmc_mk_cons(comp, res);
+  }
+  return res;
+}
+
+/* Same result as the recursive Tarjan on equations e = ass1[v]: the edges
+ * of equation e go to the equations ass1[v] solving the variables v in m[e]. */
+extern modelica_metatype BackendDAEEXT_tarjan(modelica_metatype m, modelica_metatype ass1)
+{
+  BackendDAEEXT_Workspace *ws = DEFAULT_WS;
+  mmc_uint_t neqns = MMC_HDRSLOTS(MMC_GETHDR(m));
+  mmc_uint_t nvars = MMC_HDRSLOTS(MMC_GETHDR(ass1));
+  mmc_uint_t i;
+
+  ws->graph_ptr.resize(neqns+1);
+  ws->graph_adj.clear();
+  for (i=0; i<neqns; ++i) {
+    modelica_metatype ie = MMC_STRUCTDATA(m)[i];
+    ws->graph_ptr[i] = ws->graph_adj.size();
+    for (; MMC_GETHDR(ie) == MMC_CONSHDR; ie = MMC_CDR(ie)) {
+      mmc_sint_t var = MMC_UNTAGFIXNUM(MMC_CAR(ie)), eqn;
+      if (var <= 0) continue;
+      if (var > nvars) tarjanIndexError("tarjan", "variable", var, nvars);
+      eqn = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[var-1]);
+      if (eqn <= 0 || eqn == i+1) continue;
+      if (eqn > neqns) tarjanIndexError("tarjan", "equation", eqn, neqns);
+      ws->graph_adj.push_back(eqn-1);
+    }
+  }
+  ws->graph_ptr[neqns] = ws->graph_adj.size();
+
+  ws->roots.clear();
+  for (i=0; i<nvars; ++i) {
+    mmc_sint_t eqn = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[i]);
+    if (eqn <= 0) continue;
+    if (eqn > neqns) tarjanIndexError("tarjan", "equation", eqn, neqns);
+    ws->roots.push_back(eqn-1);
+  }
+
+  BackendDAEEXTImpl__tarjan(ws, neqns);
+  return componentsToList(ws, 0);
+}
+
+/* Same result as the recursive TarjanTransposed on equations e with
+ * ass2[e] > 0: the edges of equation e go to the other equations in mT[ass2[e]]. */
+extern modelica_metatype BackendDAEEXT_tarjanTransposed(modelica_metatype mT, modelica_metatype ass2)
+{
+  BackendDAEEXT_Workspace *ws = DEFAULT_WS;
+  mmc_uint_t nvars = MMC_HDRSLOTS(MMC_GETHDR(mT));
+  mmc_uint_t neqns = MMC_HDRSLOTS(MMC_GETHDR(ass2));
+  mmc_uint_t i;
+
+  ws->graph_ptr.resize(neqns+1);
+  ws->graph_adj.clear();
+  ws->roots.clear();
+  for (i=0; i<neqns; ++i) {
+    mmc_sint_t var = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass2)[i]);
+    ws->graph_ptr[i] = ws->graph_adj.size();
+    if (var <= 0) continue;
+    if (var > nvars) tarjanIndexError("tarjanTransposed", "variable", var, nvars);
+    ws->roots.push_back(i);
+    for (modelica_metatype ie = MMC_STRUCTDATA(mT)[var-1]; MMC_GETHDR(ie) == MMC_CONSHDR; ie = MMC_CDR(ie)) {
+      mmc_sint_t eqn = MMC_UNTAGFIXNUM(MMC_CAR(ie));
+      if (eqn <= 0 || eqn == i+1) continue;
+      if (eqn > neqns) tarjanIndexError("tarjanTransposed", "equation", eqn, neqns);
+      ws->graph_adj.push_back(eqn-1);
+    }
+  }
+  ws->graph_ptr[neqns] = ws->graph_adj.size();
+
+  BackendDAEEXTImpl__tarjan(ws, neqns);
+  return componentsToList(ws, 1);
+}
+
 }
@@ -28,128 +28,292 @@
  *
  */
 
-#include <list>
+#include <string.h>
 #include <string>
-#include <sstream>
 #include <iostream>
 
 #include "ErrorMessage.hpp"
 
-  /* Implementation of ErrorMessage class. */
+#define POOL_CHUNK_SIZE 65536
+#define POOL_INITIAL_TABLE_SIZE 1024
+
+  /* Implementation of ErrorStringPool class. */
+
+static size_t hashString(const char *str, size_t *len)
+{
+  const unsigned char *s = (const unsigned char*) str;
+  size_t hash = 5381;
+  while (*s) {
+    hash = hash*33 + *s++;
+  }
+  *len = (const char*) s - str;
+  return hash;
+}
+
+ErrorStringPool::ErrorStringPool()
+  : table_(POOL_INITIAL_TABLE_SIZE),
+    used_(0),
+    chunkUsed_(0)
+{
+  chunks_.push_back(new char[POOL_CHUNK_SIZE]);
+}
+
+ErrorStringPool::~ErrorStringPool()
+{
+  for (size_t i = 0; i < chunks_.size(); i++) {
+    delete [] chunks_[i];
+  }
+  for (size_t i = 0; i < largeChunks_.size(); i++) {
+    delete [] largeChunks_[i];
+  }
+}
+
+char* ErrorStringPool::allocate(size_t len, size_t align)
+{
+  size_t offset = (chunkUsed_ + align - 1) & ~(align - 1);
+  if (offset + len > POOL_CHUNK_SIZE) {
+    if (len > POOL_CHUNK_SIZE / 4) {
+      largeChunks_.push_back(new char[len]);
+      return largeChunks_.back();
+    }
+    chunks_.push_back(new char[POOL_CHUNK_SIZE]);
+    offset = 0;
+  }
+  chunkUsed_ = offset + len;
+  return chunks_.back() + offset;
+}
 
+void ErrorStringPool::grow()
+{
+  std::vector<Entry> table(table_.size() * 2);
+  size_t mask = table.size() - 1;
+  for (size_t i = 0; i < table_.size(); i++) {
+    if (table_[i].str) {
+      size_t j = table_[i].hash & mask;
+      while (table[j].str) {
+        j = (j + 1) & mask;
+      }
+      table[j] = table_[i];
+    }
+  }
+  table_.swap(table);
+}
 
-  ErrorMessage::ErrorMessage(long errorID,
-           ErrorType type,
-           ErrorLevel severity,
-           const std::string &message,
-           const TokenList &tokens)
-    : errorID_(errorID),
-      messageType_(type),
-      severity_(severity),
-      message_(message),
-      tokens_(tokens)
+const char* ErrorStringPool::intern(const char *str)
+{
+  size_t len, hash = hashString(str, &len);
+  size_t mask = table_.size() - 1;
+  size_t i = hash & mask;
+  char *copy;
 
+  while (table_[i].str) {
+    if (table_[i].hash == hash && 0 == strcmp(table_[i].str, str)) {
+      return table_[i].str;
+    }
+    i = (i + 1) & mask;
+  }
+  copy = allocate(len + 1, 1);
+  memcpy(copy, str, len + 1);
+  table_[i].str = copy;
+  table_[i].hash = hash;
+  if (++used_ * 2 > table_.size()) {
+    grow();
+  }
+  return copy;
+}
+
+const char** ErrorStringPool::internTokens(const char * const *tokens, int n)
 {
-  startLineNo_ = 0;
-  startColumnNo_ = 0;
-  endLineNo_ = 0;
-  endColumnNo_ = 0;
-  isReadOnly_ = false;
-  filename_ = std::string("");
-  shortMessage = getMessage_(0);
-  fullMessage = getFullMessage_();
+  const char **res;
+  if (n <= 0) {
+    return NULL;
+  }
+  res = (const char**) allocate(n * sizeof(const char*), sizeof(const char*));
+  for (int i = 0; i < n; i++) {
+    res[i] = intern(tokens[i]);
+  }
+  return res;
 }
 
+void ErrorStringPool::clear()
+{
+  for (size_t i = 1; i < chunks_.size(); i++) {
+    delete [] chunks_[i];
+  }
+  chunks_.resize(1);
+  for (size_t i = 0; i < largeChunks_.size(); i++) {
+    delete [] largeChunks_[i];
+  }
+  largeChunks_.clear();
+  chunkUsed_ = 0;
+  if (table_.size() > POOL_INITIAL_TABLE_SIZE) {
+    std::vector<Entry>(POOL_INITIAL_TABLE_SIZE).swap(table_);
+  } else if (used_ > 0) {
+    std::fill(table_.begin(), table_.end(), Entry());
+  }
+  used_ = 0;
+}
+
+  /* Implementation of ErrorMessage class. */
+
 ErrorMessage::ErrorMessage(long errorID,
          ErrorType type,
          ErrorLevel severity,
-         const std::string &message,
-         const TokenList &tokens,
+         const char *message,
+         const char * const *tokens,
+         int nTokens,
          long startLineNo,
          long startColumnNo,
          long endLineNo,
          long endColumnNo,
          bool isReadOnly,
-         const std::string &filename)
+         const char *filename)
     :
     errorID_(errorID),
     messageType_(type),
     severity_(severity),
+    message_(message),
+    tokens_(tokens),
+    nTokens_(nTokens),
+    count_(1),
     startLineNo_(startLineNo),
     startColumnNo_(startColumnNo),
     endLineNo_(endLineNo),
     endColumnNo_(endColumnNo),
     isReadOnly_(isReadOnly),
-    filename_(filename),
-    message_(message),
-    tokens_(tokens)
+    filename_(filename)
 {
-  shortMessage = getMessage_(0);
-  fullMessage = getFullMessage_();
+  valid_ = checkTokens();
 }
 
-std::string ErrorMessage::getMessage_(int warningsAsErrors)
+/* Checks that the message has a token for each %s and %n. The message is
+ * printed as an empty string otherwise. */
+bool ErrorMessage::checkTokens() const
 {
-  std::string::size_type str_pos = 0;
-  TokenList::iterator tok = tokens_.begin();
-  char index_symbol;
-  int index;
-
-  while((str_pos = message_.find('%', str_pos)) != std::string::npos) {
-    index_symbol = message_[str_pos + 1];
-
-    if(index_symbol == 's') {
-      if(tok == tokens_.end()) {
+  int tok = 0;
+  for (const char *str = message_; (str = strchr(str, '%')) != NULL; str += 2) {
+    char index_symbol = str[1];
+    if (index_symbol == 's') {
+      if (tok == nTokens_) {
         std::cerr << "Internal error: no tokens left to replace %s with.\n";
         std::cerr << "Given message was: " << message_ << "\n";
-        return "";
+        return false;
       }
-      message_.replace(str_pos, 2, *tok);
-      str_pos += tok->size();
-      *tok++;
-    } else if(index_symbol >= '0' || index_symbol <= '9') {
-      index = index_symbol - '0' - 1;
-
-      if(index >= tokens_.size() || index < 0) {
+      tok++;
+    } else {
+      int index = index_symbol - '0' - 1;
+      if (index >= nTokens_ || index < 0) {
         std::cerr << "Internal error: Invalid positional index %" << index + 1
           << " in error message.\n";
         std::cerr << "Given message was: " << message_ << "\n";
-        return "";
+        return false;
       }
+    }
+  }
+  return true;
+}
 
-      message_.replace(str_pos, 2, tokens_[index]);
-      str_pos += tokens_[index].size();
+void ErrorMessage::appendShortMessage(std::string &buf) const
+{
+  const char *str = message_, *next;
+  int tok = 0;
+  if (!valid_) {
+    return;
+  }
+  while ((next = strchr(str, '%')) != NULL) {
+    buf.append(str, next - str);
+    if (next[1] == 's') {
+      buf.append(tokens_[tok++]);
+    } else {
+      buf.append(tokens_[next[1] - '0' - 1]);
     }
+    str = next + 2;
   }
-  veryshort_msg = message_;
+  buf.append(str);
+}
 
-  std::string ret_msg;
+void ErrorMessage::appendMessage(std::string &buf, int warningsAsErrors) const
+{
+  size_t start = buf.size();
   const char* severityStr = ErrorLevel_toStr(warningsAsErrors && severity_ == ErrorLevel_warning ? ErrorLevel_error : severity_);
+  char num[32];
 
-  if(filename_ == "" && startLineNo_ == 0 && startColumnNo_ == 0 &&
+  if (!valid_) {
+    return;
+  }
+  if (*filename_ == '\0' && startLineNo_ == 0 && startColumnNo_ == 0 &&
       endLineNo_ == 0 && endColumnNo_ == 0) {
-    ret_msg = severityStr + (": " + message_);
+    buf.append(severityStr);
+    buf.append(": ");
   } else {
-    std::stringstream str;
-    str << "[" << filename_ << ":" << startLineNo_ << ":" << startColumnNo_ <<
-      "-" << endLineNo_ << ":" << endColumnNo_ << ":" <<
-      (isReadOnly_ ? "readonly" : "writable") << "] " << severityStr << ": ";
-    std::string positionInfo = str.str();
-    ret_msg = positionInfo + message_;
+    buf.append("[");
+    buf.append(filename_);
+    snprintf(num, sizeof(num), ":%ld:%ld-%ld:%ld:", startLineNo_, startColumnNo_, endLineNo_, endColumnNo_);
+    buf.append(num);
+    buf.append(isReadOnly_ ? "readonly" : "writable");
+    buf.append("] ");
+    buf.append(severityStr);
+    buf.append(": ");
   }
+  appendShortMessage(buf);
   // trim trailing whitespace
-  ret_msg.erase(ret_msg.find_last_not_of(" \n\r\t")+1);
-  return ret_msg;
+  size_t end = buf.size();
+  while (end > start && strchr(" \n\r\t", buf[end-1])) {
+    end--;
+  }
+  buf.resize(end);
+}
+
+void ErrorMessage::appendFullMessage(std::string &buf) const
+{
+  char num[32];
+  buf.append("{\"");
+  appendMessage(buf, 0);
+  buf.append("\", \"");
+  buf.append(ErrorType_toStr(messageType_));
+  buf.append("\", \"");
+  buf.append(ErrorLevel_toStr(severity_));
+  snprintf(num, sizeof(num), "\", \"%ld\"}", errorID_);
+  buf.append(num);
+}
+
+std::string ErrorMessage::getShortMessage() const
+{
+  std::string res;
+  appendShortMessage(res);
+  return res;
 }
 
-std::string ErrorMessage::getFullMessage_()
+std::string ErrorMessage::getMessage(int warningsAsErrors) const
 {
-  std::stringstream strbuf;
+  std::string res;
+  appendMessage(res, warningsAsErrors);
+  return res;
+}
 
-  strbuf << "{\"" << shortMessage << "\", \"" <<
-    ErrorType_toStr(messageType_) << "\", \"" <<
-    ErrorLevel_toStr(severity_) << "\", \"" <<
-    errorID_ <<  "\"}";
+std::string ErrorMessage::getFullMessage() const
+{
+  std::string res;
+  appendFullMessage(res);
+  return res;
+}
 
-  return strbuf.str();
+/* Messages with the same template and tokens share the interned strings, so
+ * comparing the pointers compares the printed messages. */
+bool ErrorMessage::sameMessage(const ErrorMessage &other) const
+{
+  if (errorID_ != other.errorID_ || messageType_ != other.messageType_ ||
+      severity_ != other.severity_ || message_ != other.message_ ||
+      nTokens_ != other.nTokens_ || filename_ != other.filename_ ||
+      startLineNo_ != other.startLineNo_ || startColumnNo_ != other.startColumnNo_ ||
+      endLineNo_ != other.endLineNo_ || endColumnNo_ != other.endColumnNo_ ||
+      isReadOnly_ != other.isReadOnly_) {
+    return false;
+  }
+  for (int i = 0; i < nTokens_; i++) {
+    if (tokens_[i] != other.tokens_[i]) {
+      return false;
+    }
+  }
+  return true;
 }
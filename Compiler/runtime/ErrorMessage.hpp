@@ -35,28 +35,67 @@
 #include <string>
 #include "errorext.h"
 
-class ErrorMessage {
+/* Interned strings and token arrays of the messages of one thread. They live
+ * in large chunks and are all released at once by clear(), when no message
+ * refers to them any more. Equal strings get the same pointer.
+ */
+class ErrorStringPool {
 
 public:
-  typedef std::vector<std::string> TokenList;
+  ErrorStringPool();
+  ~ErrorStringPool();
 
-  ErrorMessage(long errorID,
-         ErrorType type,
-         ErrorLevel severity,
-         const std::string &message,
-         const TokenList &tokens);
+  // Returns the interned copy of str.
+  const char* intern(const char *str);
+
+  // Returns a copy of the array of n tokens with all tokens interned.
+  const char** internTokens(const char * const *tokens, int n);
+
+  // Releases all strings, keeping one chunk for reuse.
+  void clear();
+
+  size_t size() const { return used_; };
+
+private:
+  struct Entry {
+    const char *str;
+    size_t hash;
+  };
+
+  std::vector<Entry> table_;
+  size_t used_;
+  std::vector<char*> chunks_;
+  std::vector<char*> largeChunks_;
+  size_t chunkUsed_;
+
+  char* allocate(size_t len, size_t align);
+  void grow();
+
+  ErrorStringPool(const ErrorStringPool&);
+  ErrorStringPool& operator=(const ErrorStringPool&);
+};
 
+/* A message in the error queue. All strings and the token array are kept in
+ * the ErrorStringPool of the queue, so a message is a small value that needs
+ * no allocation of its own. The message text is only formatted when it is
+ * printed. Identical messages added right after each other are collapsed into
+ * one message with a count.
+ */
+class ErrorMessage {
+
+public:
   ErrorMessage(long errorID,
          ErrorType type,
          ErrorLevel severity,
-         const std::string &message,
-         const TokenList &tokens,
+         const char *message,
+         const char * const *tokens,
+         int nTokens,
          long startLineNo,
          long startColumnNo,
          long endLineNo,
          long endColumnNo,
          bool isReadOnly,
-         const std::string &filename);
+         const char *filename);
 
   long getID() const { return errorID_; };
 
@@ -65,13 +104,21 @@ public:
   ErrorLevel getSeverity() const { return severity_; };
 
   // Returns the expanded message with inserted tokens.
-  std::string getShortMessage() const {return veryshort_msg;};
+  std::string getShortMessage() const;
 
-  // Returns the expanded message with inserted tokens.
-  std::string getMessage(int warningsAsErrors) {if (!warningsAsErrors) {return shortMessage;} else {return getMessage_(warningsAsErrors);}};
+  // Returns the expanded message with position information and severity.
+  std::string getMessage(int warningsAsErrors) const;
 
-  // Returns the complete message in string format corresponding to a Modeica vector.
-  std::string getFullMessage() const {return fullMessage;};
+  // Returns the complete message in string format corresponding to a Modelica vector.
+  std::string getFullMessage() const;
+
+  // The same as above, but appending to buf.
+  void appendShortMessage(std::string &buf) const;
+  void appendMessage(std::string &buf, int warningsAsErrors) const;
+  void appendFullMessage(std::string &buf) const;
+
+  // True if both messages print the same.
+  bool sameMessage(const ErrorMessage &other) const;
 
   long getLineNo() const { return startLineNo_; };
   long getColumnNo() const { return startColumnNo_; };
@@ -81,17 +128,24 @@ public:
   long getEndLineNo() const { return endLineNo_; };
   long getEndColumnNo() const { return endColumnNo_; };
   bool getIsFileReadOnly() const { return isReadOnly_; };
-  std::string getFileName() const { return filename_; };
-  TokenList getTokens() const { return tokens_; };
+  const char* getFileName() const { return filename_; };
+  const char* getMessageTemplate() const { return message_; };
+  const char * const* getTokens() const { return tokens_; };
+  int getNumTokens() const { return nTokens_; };
+
+  // Number of identical messages collapsed into this one.
+  int getCount() const { return count_; };
+  void addDuplicates(int n) { count_ += n; };
+
 private:
   long errorID_;
   ErrorType messageType_;
   ErrorLevel severity_;
-  std::string message_;
-  TokenList tokens_;
-  std::string shortMessage;
-  std::string veryshort_msg;
-  std::string fullMessage;
+  const char *message_;
+  const char * const *tokens_;
+  int nTokens_;
+  int count_;
+  bool valid_;
 
   /* adrpo 2006-02-05 changed the ones below */
   long startLineNo_;
@@ -99,12 +153,9 @@ private:
   long endLineNo_;
   long endColumnNo_;
   bool isReadOnly_;
-  std::string filename_;
-
-  std::string getShortMessage_();
-  std::string getMessage_(int warningsAsErrors);
-  std::string getFullMessage_();
+  const char *filename_;
 
+  bool checkTokens() const;
 };
 
 
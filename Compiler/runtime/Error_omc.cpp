@@ -69,35 +69,36 @@ extern const char* Error_printMessagesStr(threadData_t *threadData,int warningsA
 #if defined(OPENMODELICA_BOOTSTRAPPING_STAGE_1)
 extern void Error_addMessage(threadData_t *threadData,int errorID, void *msg_type, void *severity, const char* message, modelica_metatype tokenlst)
 {
-  ErrorMessage::TokenList tokens;
+  ErrorTokenArray tokens(listLength(tokenlst));
+  int nTokens = 0;
   while (MMC_GETHDR(tokenlst) != MMC_NILHDR) {
-    const char* token = MMC_STRINGDATA(MMC_CAR(tokenlst));
-    tokens.push_back(string(token));
+    tokens[nTokens++] = MMC_STRINGDATA(MMC_CAR(tokenlst));
     tokenlst=MMC_CDR(tokenlst);
   }
   add_source_message(threadData,errorID,
               (ErrorType) (MMC_HDRCTOR(MMC_GETHDR(msg_type))-Error__SYNTAX_3dBOX0),
               (ErrorLevel) (MMC_HDRCTOR(MMC_GETHDR(severity))-Error__INTERNAL_3dBOX0),
-              message,tokens,0,0,0,0,0,"");
+              message,tokens.data(),nTokens,0,0,0,0,0,"");
 }
 #endif
 
 extern void Error_addSourceMessage(threadData_t *threadData,int _id, void *msg_type, void *severity, int _sline, int _scol, int _eline, int _ecol, int _read_only, const char* _filename, const char* _msg, void* tokenlst)
 {
-  ErrorMessage::TokenList tokens;
+  ErrorTokenArray tokens(listLength(tokenlst));
+  int nTokens = 0;
   while(MMC_GETHDR(tokenlst) != MMC_NILHDR) {
-    tokens.push_back(string(MMC_STRINGDATA(MMC_CAR(tokenlst))));
+    tokens[nTokens++] = MMC_STRINGDATA(MMC_CAR(tokenlst));
     tokenlst=MMC_CDR(tokenlst);
   }
   add_source_message(threadData,_id,
                      (ErrorType) (MMC_HDRCTOR(MMC_GETHDR(msg_type))-Error__SYNTAX_3dBOX0),
                      (ErrorLevel) (MMC_HDRCTOR(MMC_GETHDR(severity))-Error__INTERNAL_3dBOX0),
-                     _msg,tokens,_sline,_scol,_eline,_ecol,_read_only,_filename);
+                     _msg,tokens.data(),nTokens,_sline,_scol,_eline,_ecol,_read_only,_filename);
 }
 
 extern int Error_getNumMessages(threadData_t *threadData)
 {
-  return getMembers(threadData)->errorMessageQueue->size();
+  return getMembers(threadData)->numMessages;
 }
 
 void Error_setShowErrorMessages(threadData_t *threadData,int show)
@@ -34,8 +34,10 @@
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "systemimpl.h"
+#include "rtclock.h"
 
 /* Size of the buffer for warnings and other messages */
 #define WARNINGBUFFSIZE 4096
@@ -60,6 +62,13 @@ typedef struct {
   unsigned int n_max;
 } DiffDataField;
 
+/* The outcome of comparing one variable */
+typedef struct {
+  unsigned int ndiff; /* number of points outside the tolerance */
+  double maxError; /* the largest error of these points */
+  DiffDataField ddf; /* the points themselves, for compareSimulationResults */
+} CmpResult;
+
 #define DOUBLEEQUAL_TOTAL 0.0000000001
 #define DOUBLEEQUAL_REL 0.00001
 
@@ -159,8 +168,12 @@ static char almostEqualWithDefaultTolerance(double a, double b)
   return almostEqualRelativeAndAbs(a,b,DOUBLEEQUAL_REL,DOUBLEEQUAL_TOTAL);
 }
 
-static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double abstol, DiffDataField *ddf, char **cmpdiffvars, unsigned int vardiffindx, int keepEqualResults, void **diffLst, const char *prefix)
+/* Compares one variable point by point. Does not use the garbage collector
+ * or the error queue, so that it can run in any thread.
+ */
+static void cmpData(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double abstol, int keepEqualResults, const char *prefix, CmpResult *result)
 {
+  DiffDataField *ddf = &result->ddf;
   unsigned int i,j,k,j_event;
   double t,tr,d,dr,err,d_left,d_right,dr_left,dr_right,t_event;
   char increased = 0;
@@ -452,6 +465,8 @@ static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, Dat
       }
 
       isdifferent = 1;
+      result->ndiff++;
+      result->maxError = fmax(result->maxError, err);
       if (isResultCmp) { /* If we produce the full diff, this data has already been output */
         if (ddf->n >= ddf->n_max) {
           DiffData *newData;
@@ -470,13 +485,6 @@ static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, Dat
       }
     }
   }
-  if (isdifferent) {
-    cmpdiffvars[vardiffindx] = varname;
-    vardiffindx++;
-    if (!isResultCmp) {
-      *diffLst = mmc_mk_cons(mmc_mk_scon(varname),*diffLst);
-    }
-  }
   if (fout) {
     fclose(fout);
   }
@@ -486,7 +494,6 @@ static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, Dat
   if (fname) {
     free(fname);
   }
-  return vardiffindx;
 }
 
 static int writeLogFile(const char *filename,DiffDataField *ddf,const char *f,const char *reff,double reltol,double abstol)
@@ -526,28 +533,295 @@ static const char* getTimeVarName(void *vars) {
   return res;
 }
 
+/* Reads the values of a variable without going through a list of boxed
+ * values. The data of MATLAB and CSV files stays owned by the reader, which
+ * keeps it until the file is closed; otherwise *owned is set and the data
+ * must be free'd.
+ */
+static DataField getColumn(const char *varname, const char *filename, unsigned int size, SimulationResult_Globals* srg, int runningTestsuite, int *owned)
+{
+  DataField res;
+  const char *msg[2] = {"",""};
+  unsigned int i;
+  res.n = 0;
+  res.data = NULL;
+  *owned = 0;
+  switch (srg->curFormat) {
+  case MATLAB4: {
+    ModelicaMatVariable_t *mat_var = omc_matlab4_find_var(&srg->matReader,varname);
+    if (mat_var == NULL) {
+      break;
+    }
+    if (mat_var->isParam) {
+      double val = srg->matReader.params[abs(mat_var->index)-1];
+      res.data = (double*) malloc(sizeof(double)*(size ? size : 1));
+      for (i=0; i<size; i++) {
+        res.data[i] = mat_var->index < 0 ? -val : val;
+      }
+      res.n = size;
+      *owned = 1;
+    } else {
+      res.data = omc_matlab4_read_vals(&srg->matReader,mat_var->index);
+      res.n = res.data ? srg->matReader.nrows : 0;
+    }
+    return res;
+  }
+  case CSV: {
+    res.data = srg->csvReader ? read_csv_dataset(srg->csvReader,varname) : NULL;
+    if (res.data == NULL) {
+      break;
+    }
+    res.n = srg->csvReader->numsteps;
+    return res;
+  }
+  default:
+    res = getData(varname,filename,size,0,srg,runningTestsuite);
+    *owned = 1;
+    return res;
+  }
+  msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
+  msg[1] = varname;
+  c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Could not read variable %s in file %s."), msg, 2);
+  return res;
+}
+
+/* Reads the columns of all the given variables of a MATLAB file in one pass
+ * over the file, so that getColumn finds them in memory.
+ */
+static void prefetchColumns(SimulationResult_Globals* srg, char **names, unsigned int n)
+{
+  int *indices;
+  unsigned int i, count = 0;
+  if (srg->curFormat != MATLAB4) {
+    return;
+  }
+  indices = (int*) malloc(sizeof(int)*(n ? n : 1));
+  for (i=0; i<n; i++) {
+    ModelicaMatVariable_t *mat_var = names[i] ? omc_matlab4_find_var(&srg->matReader,names[i]) : NULL;
+    if (mat_var && !mat_var->isParam) {
+      indices[count++] = mat_var->index;
+    }
+  }
+  /* Errors are reported when the columns are read */
+  omc_matlab4_read_vars_vals(&srg->matReader, indices, count);
+  free(indices);
+}
+
 #include "SimulationResultsCmpTubes.c"
 
-/* Common, huge function, for both result comparison and result diff */
-void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success, int isHtml, char **htmlOut)
+/* A variable to compare, with its data and the outcome of the comparison */
+typedef struct {
+  char *name; /* as given by the user */
+  char *unquoted; /* as found in the files */
+  DataField data, refdata;
+  int ownsData, ownsRefData;
+  CmpResult res;
+} CmpVar;
+
+/* The variables compared by the threads and the shared, read-only settings */
+typedef struct {
+  CmpVar *vars;
+  unsigned int nvars;
+  unsigned int next; /* the next variable to compare, protected by mutex */
+  pthread_mutex_t mutex;
+  int isResultCmp, isHtml, keepEqualResults;
+  DataField *time, *timeref;
+  double reltol, abstol, reltolDiffMaxMin, rangeDelta;
+  const char *prefix;
+  char **htmlOut;
+} CmpJobs;
+
+/* Compares variables until none are left; each thread has its own buffers */
+static void* compareVariables(void *arg)
+{
+  CmpJobs *jobs = (CmpJobs*) arg;
+  tubesScratch scratch;
+  memset(&scratch, 0, sizeof(tubesScratch));
+  while (1) {
+    CmpVar *var;
+    unsigned int i;
+    pthread_mutex_lock(&jobs->mutex);
+    i = jobs->next++;
+    pthread_mutex_unlock(&jobs->mutex);
+    if (i >= jobs->nvars) {
+      break;
+    }
+    var = &jobs->vars[i];
+    if (var->data.n == 0 || var->refdata.n == 0) {
+      continue;
+    }
+    if (jobs->isHtml) {
+      cmpDataTubes(jobs->isResultCmp,var->name,jobs->time,jobs->timeref,&var->data,&var->refdata,jobs->reltol,jobs->rangeDelta,jobs->reltolDiffMaxMin,jobs->keepEqualResults,jobs->prefix,1,jobs->htmlOut,&scratch,&var->res);
+    } else if (jobs->isResultCmp) {
+      cmpData(jobs->isResultCmp,var->name,jobs->time,jobs->timeref,&var->data,&var->refdata,jobs->reltol,jobs->abstol,jobs->keepEqualResults,jobs->prefix,&var->res);
+    } else {
+      cmpDataTubes(jobs->isResultCmp,var->name,jobs->time,jobs->timeref,&var->data,&var->refdata,jobs->reltol,jobs->rangeDelta,jobs->reltolDiffMaxMin,jobs->keepEqualResults,jobs->prefix,0,NULL,&scratch,&var->res);
+    }
+  }
+  freeTubesScratch(&scratch);
+  return NULL;
+}
+
+/* Compares all variables using up to nthreads threads, including the calling
+ * one. Returns the number of threads used. The tube comparison allocates from
+ * the garbage collector, so the workers are registered with it.
+ */
+static int compareVariablesParallel(CmpJobs *jobs, int nthreads)
+{
+  pthread_t *threads;
+  int i, nstarted = 0;
+  if (nthreads > (int) jobs->nvars) {
+    nthreads = jobs->nvars;
+  }
+  if (nthreads <= 1 || jobs->isHtml) {
+    compareVariables(jobs);
+    return 1;
+  }
+  threads = (pthread_t*) malloc(sizeof(pthread_t)*(nthreads-1));
+  for (i=0; i<nthreads-1; i++) {
+    if (0 == GC_pthread_create(&threads[nstarted], NULL, compareVariables, jobs)) {
+      nstarted++;
+    }
+  }
+  compareVariables(jobs);
+  for (i=0; i<nstarted; i++) {
+    GC_pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  return nstarted+1;
+}
+
+static void fputsJSON(const char *str, FILE *fout)
+{
+  fputc('"', fout);
+  for (; *str; str++) {
+    switch (*str) {
+    case '"': fputs("\\\"", fout); break;
+    case '\\': fputs("\\\\", fout); break;
+    case '\n': fputs("\\n", fout); break;
+    case '\r': fputs("\\r", fout); break;
+    case '\t': fputs("\\t", fout); break;
+    default:
+      if ((unsigned char)*str < 0x20) {
+        fprintf(fout, "\\u%04x", (unsigned char)*str);
+      } else {
+        fputc(*str, fout);
+      }
+    }
+  }
+  fputc('"', fout);
+}
+
+static void fputsJSONNumber(double d, FILE *fout)
+{
+  if (isfinite(d)) {
+    fprintf(fout, "%.15g", d);
+  } else {
+    fputs("null", fout);
+  }
+}
+
+/* Appends one line of JSON with the outcome of the comparison to summaryFile.
+ * If error is set, the comparison could not be done.
+ */
+static void writeSummary(const char *summaryFile, int isResultCmp, const char *filename, const char *reffilename, const char *error, CmpVar *vars, unsigned int nvars, int equal, int nthreads, double seconds)
+{
+  FILE *fout;
+  unsigned int i, ndiff = 0, nfailed = 0;
+  int first;
+  const char *msg[1];
+  if (summaryFile == NULL || summaryFile[0] == '\0') {
+    return;
+  }
+  fout = fopen(summaryFile, "a");
+  if (!fout) {
+    msg[0] = summaryFile;
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Cannot write to the result comparison summary file %s."), msg, 1);
+    return;
+  }
+  fputs("{\"actual\":", fout);
+  fputsJSON(filename, fout);
+  fputs(",\"expected\":", fout);
+  fputsJSON(reffilename, fout);
+  fprintf(fout, ",\"mode\":\"%s\"", isResultCmp ? "compare" : "diff");
+  if (error) {
+    fputs(",\"error\":", fout);
+    fputsJSON(error, fout);
+    fputs("}\n", fout);
+    fclose(fout);
+    return;
+  }
+  for (i=0; i<nvars; i++) {
+    if (vars[i].data.n == 0 || vars[i].refdata.n == 0) {
+      nfailed++;
+    } else if (vars[i].res.ndiff) {
+      ndiff++;
+    }
+  }
+  fprintf(fout, ",\"equal\":%s,\"variables\":%u,\"different\":%u,\"failed\":%u,\"threads\":%d,\"time\":%.6f", equal ? "true" : "false", nvars, ndiff, nfailed, nthreads, seconds);
+  fputs(",\"differentVariables\":[", fout);
+  for (i=0, first=1; i<nvars; i++) {
+    if (vars[i].data.n == 0 || vars[i].refdata.n == 0 || vars[i].res.ndiff == 0) {
+      continue;
+    }
+    fputs(first ? "{\"name\":" : ",{\"name\":", fout);
+    fputsJSON(vars[i].name, fout);
+    fprintf(fout, ",\"points\":%u,\"maxError\":", vars[i].res.ndiff);
+    fputsJSONNumber(vars[i].res.maxError, fout);
+    fputc('}', fout);
+    first = 0;
+  }
+  fputs("],\"failedVariables\":[", fout);
+  for (i=0, first=1; i<nvars; i++) {
+    if (vars[i].data.n == 0 || vars[i].refdata.n == 0) {
+      if (!first) fputc(',', fout);
+      fputsJSON(vars[i].name, fout);
+      first = 0;
+    }
+  }
+  fputs("]}\n", fout);
+  fclose(fout);
+}
+
+static void* compareResultsError(const char *summaryFile, int isResultCmp, const char *filename, const char *reffilename, const char *error)
+{
+  writeSummary(summaryFile, isResultCmp, filename, reffilename, error, NULL, 0, 0, 0, 0);
+  return mmc_mk_cons(mmc_mk_scon(error),mmc_mk_nil());
+}
+
+/* Common, huge function, for both result comparison and result diff.
+ * All the columns are read first, one pass over each file, and the variables
+ * are then compared by up to nthreads threads. If summaryFile is not empty,
+ * a line of JSON with the outcome is appended to it.
+ */
+void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success, int isHtml, char **htmlOut, int nthreads, const char *summaryFile)
 {
   char **cmpvars=NULL;
   char **cmpdiffvars=NULL;
+  char **names=NULL;
   unsigned int vardiffindx=0;
   unsigned int ncmpvars = 0;
   unsigned int ngetfailedvars = 0;
   void *allvars,*allvarsref,*res;
   unsigned int i,size,size_ref,len,j,k;
-  char *var,*var1,*var2;
-  DataField time,timeref,data,dataref;
+  char *var,*var1;
+  DataField time,timeref;
+  int ownsTime,ownsTimeref,equal;
   DiffDataField ddf;
+  CmpVar *cmp;
+  CmpJobs jobs;
   const char *msg[2] = {"",""};
   const char *timeVarName, *timeVarNameRef;
-  int suggestReadAll=0;
+  rtclock_t clock;
   ddf.data=NULL;
   ddf.n=0;
   ddf.n_max=0;
+  time.n=0;
+  timeref.n=0;
+  ownsTime=0;
+  ownsTimeref=0;
   len = 1;
+  rt_ext_tp_tick(&clock);
 
   /* open files */
   /*  fprintf(stderr, "Open File %s\n", filename); */
@@ -556,9 +830,9 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
     void *res = NULL;
     *str = 0;
     strcat(strcat(str,"Error opening file: "), filename);
-    res = mmc_mk_scon(str);
+    res = compareResultsError(summaryFile,isResultCmp,filename,reffilename,str);
     GC_free(str);
-    return mmc_mk_cons(res,mmc_mk_nil());
+    return res;
   }
   /* fprintf(stderr, "Open File %s\n", reffilename); */
   if (UNKNOWN_PLOT == SimulationResultsImpl__openFile(reffilename,&simresglob_ref)) {
@@ -566,9 +840,9 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
     void *res = NULL;
     *str = 0;
     strcat(strcat(str,"Error opening reference file: "), reffilename);
-    res = mmc_mk_scon(str);
+    res = compareResultsError(summaryFile,isResultCmp,filename,reffilename,str);
     GC_free(str);
-    return mmc_mk_cons(res,mmc_mk_nil());
+    return res;
   }
 
   size = SimulationResultsImpl__readSimulationResultSize(filename,&simresglob_c);
@@ -582,27 +856,55 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   allvars = SimulationResultsImpl__readVarsFilterAliases(filename,&simresglob_c);
   allvarsref = SimulationResultsImpl__readVarsFilterAliases(reffilename,&simresglob_ref);
   if (ncmpvars==0) {
-    suggestReadAll = 1;
     cmpvars = getVars(allvarsref,&ncmpvars);
-    if (ncmpvars==0) return mmc_mk_cons(mmc_mk_scon("Error Get Vars!"),mmc_mk_nil());
+    if (ncmpvars==0) return compareResultsError(summaryFile,isResultCmp,filename,reffilename,"Error Get Vars!");
   }
 #ifdef DEBUGOUTPUT
   fprintf(stderr, "Compare Vars:\n");
   for(i=0;i<ncmpvars;i++)
     fprintf(stderr, "Var: %s\n", cmpvars[i]);
 #endif
-  /*  get time */
-  /* fprintf(stderr, "get time\n"); */
   timeVarName = getTimeVarName(allvars);
   timeVarNameRef = getTimeVarName(allvarsref);
-  time = getData(timeVarName,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
+
+  /* the names as found in the files */
+  cmp = (CmpVar*) calloc(ncmpvars, sizeof(CmpVar));
+  names = (char**) malloc(sizeof(char*)*(ncmpvars+1));
+  for (i=0;i<ncmpvars;i++) {
+    var = cmpvars[i];
+    len = strlen(var);
+    var1 = (char*) malloc(len+10);
+    k = 0;
+    for (j=0;j<len;j++) {
+      if (var[j] !='\"' ) {
+        var1[k] = var[j];
+        k +=1;
+      }
+    }
+    var1[k] = 0;
+    cmp[i].name = var;
+    cmp[i].unquoted = var1;
+    names[i+1] = var1;
+  }
+  /* read all the columns in one pass over each file */
+  names[0] = (char*) timeVarNameRef;
+  prefetchColumns(&simresglob_ref, names, ncmpvars+1);
+  names[0] = (char*) timeVarName;
+  prefetchColumns(&simresglob_c, names, ncmpvars+1);
+  free(names);
+
+  /*  get time */
+  /* fprintf(stderr, "get time\n"); */
+  time = getColumn(timeVarName,filename,size,&simresglob_c,runningTestsuite,&ownsTime);
   if (time.n==0) {
-    return mmc_mk_cons(mmc_mk_scon("Error get time!"),mmc_mk_nil());
+    res = compareResultsError(summaryFile,isResultCmp,filename,reffilename,"Error get time!");
+    goto cleanup;
   }
   /* fprintf(stderr, "get reftime\n"); */
-  timeref = getData(timeVarNameRef,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
+  timeref = getColumn(timeVarNameRef,reffilename,size_ref,&simresglob_ref,runningTestsuite,&ownsTimeref);
   if (timeref.n==0) {
-    return mmc_mk_cons(mmc_mk_scon("Error get ref time!"),mmc_mk_nil());
+    res = compareResultsError(summaryFile,isResultCmp,filename,reffilename,"Error get ref time!");
+    goto cleanup;
   }
   cmpdiffvars = (char**)omc_alloc_interface.malloc(sizeof(char*)*(ncmpvars));
   /* check if time is larger or less reftime */
@@ -617,37 +919,12 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
     "File[%d]=%f\n",timeref.n,timeref.data[timeref.n-1],time.n,time.data[time.n-1]);
     c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, buf, NULL, 0);
   }
-  var1=NULL;
-  var2=NULL;
-  /* compare vars */
-  /* fprintf(stderr, "compare vars\n"); */
+  /* get the data of the vars */
   for (i=0;i<ncmpvars;i++) {
-    var = cmpvars[i];
-    len = strlen(var);
-    if (var1) {
-      free(var1);
-      var1 = NULL;
-    }
-    var1 = (char*) omc_alloc_interface.malloc(len+10);
-    k = 0;
-    for (j=0;j<len;j++) {
-      if (var[j] !='\"' ) {
-        var1[k] = var[j];
-        k +=1;
-      }
-    }
-    var1[k] = 0;
-    /* fprintf(stderr, "compare var: %s\n",var); */
+    var = cmp[i].name;
     /* check if in ref_file */
-    dataref = getData(var1,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
-    if (dataref.n==0) {
-      if (dataref.data) {
-        free(dataref.data);
-      }
-      if (var1) {
-        GC_free(var1);
-        var1 = NULL;
-      }
+    cmp[i].refdata = getColumn(cmp[i].unquoted,reffilename,size_ref,&simresglob_ref,runningTestsuite,&cmp[i].ownsRefData);
+    if (cmp[i].refdata.n==0) {
       msg[0] = runningTestsuite ? SystemImpl__basename(reffilename) : reffilename;
       msg[1] = var;
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
@@ -655,39 +932,52 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
       continue;
     }
     /*  check if in file */
-    data = getData(var1,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
-    if (data.n==0)  {
-      if (data.data) {
-        free(data.data);
-      }
-      if (var1) {
-        GC_free(var1);
-        var1 = NULL;
-      }
+    cmp[i].data = getColumn(cmp[i].unquoted,filename,size,&simresglob_c,runningTestsuite,&cmp[i].ownsData);
+    if (cmp[i].data.n==0)  {
       msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
       msg[1] = var;
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
       ngetfailedvars++;
       continue;
     }
-    /* compare */
-    if (isHtml) {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,1,htmlOut);
-    } else if (isResultCmp) {
-      vardiffindx = cmpData(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,abstol,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename);
-    } else {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,0,0);
-    }
-    /* free */
-    if (dataref.data) {
-      free(dataref.data);
-    }
-    if (data.data) {
-      free(data.data);
+  }
+
+  /* compare vars */
+  jobs.vars = cmp;
+  jobs.nvars = ncmpvars;
+  jobs.next = 0;
+  pthread_mutex_init(&jobs.mutex, NULL);
+  jobs.isResultCmp = isResultCmp;
+  jobs.isHtml = isHtml;
+  jobs.keepEqualResults = keepEqualResults;
+  jobs.time = &time;
+  jobs.timeref = &timeref;
+  jobs.reltol = reltol;
+  jobs.abstol = abstol;
+  jobs.reltolDiffMaxMin = reltolDiffMaxMin;
+  jobs.rangeDelta = rangeDelta;
+  jobs.prefix = resultfilename;
+  jobs.htmlOut = htmlOut;
+  nthreads = compareVariablesParallel(&jobs, nthreads);
+  pthread_mutex_destroy(&jobs.mutex);
+
+  /* collect the results in the order of the vars */
+  for (i=0;i<ncmpvars;i++) {
+    DiffDataField *vddf = &cmp[i].res.ddf;
+    if (vddf->n) {
+      if (ddf.n + vddf->n > ddf.n_max) {
+        ddf.n_max = ddf.n + vddf->n > 2*ddf.n_max ? ddf.n + vddf->n : 2*ddf.n_max;
+        ddf.data = (DiffData*) realloc(ddf.data, sizeof(DiffData)*(ddf.n_max));
+      }
+      memcpy(ddf.data + ddf.n, vddf->data, sizeof(DiffData)*vddf->n);
+      ddf.n += vddf->n;
     }
-    if (var1) {
-      GC_free(var1);
-      var1 = NULL;
+    if (cmp[i].res.ndiff) {
+      cmpdiffvars[vardiffindx] = cmp[i].name;
+      vardiffindx++;
+      if (!isResultCmp) {
+        res = mmc_mk_cons(mmc_mk_scon(cmp[i].name),res);
+      }
     }
   }
 
@@ -696,7 +986,8 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Cannot write to the difference (.csv) file!\n"), msg, 0);
     }
 
-    if ((ddf.n > 0) || (ngetfailedvars > 0) || vardiffindx > 0){
+    equal = !((ddf.n > 0) || (ngetfailedvars > 0) || vardiffindx > 0);
+    if (!equal){
       /* fprintf(stderr, "diff: %d\n",ddf.n); */
       /* for (i=0;i<vardiffindx;i++)
       fprintf(stderr, "diffVar: %s\n",cmpdiffvars[i]); */
@@ -709,17 +1000,25 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
       res = mmc_mk_cons(mmc_mk_scon("Files Equal!"),res);
     }
   } else {
+    equal = ((ddf.n == 0) && (vardiffindx == 0));
     if (success) {
-      *success = ((ddf.n == 0) && (vardiffindx == 0));
+      *success = equal;
     }
   }
+  writeSummary(summaryFile,isResultCmp,filename,reffilename,NULL,cmp,ncmpvars,equal,nthreads,rt_ext_tp_tock(&clock));
 
-  // if (var1) free(var1);
-  // if (var2) free(var2);
+cleanup:
+  for (i=0;i<ncmpvars;i++) {
+    if (cmp[i].ownsData) free(cmp[i].data.data);
+    if (cmp[i].ownsRefData) free(cmp[i].refdata.data);
+    free(cmp[i].res.ddf.data);
+    free(cmp[i].unquoted);
+  }
+  free(cmp);
   if (ddf.data) free(ddf.data);
   if (cmpvars) GC_free(cmpvars);
-  if (time.data) free(time.data);
-  if (timeref.data) free(timeref.data);
+  if (time.n && ownsTime) free(time.data);
+  if (timeref.n && ownsTimeref) free(timeref.data);
   if (cmpdiffvars) GC_free(cmpdiffvars);
   /* close files */
   SimulationResultsImpl__close(&simresglob_c);
@@ -727,4 +1026,3 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
 
   return res;
 }
-
@@ -75,6 +75,60 @@ typedef struct {
   size_t countLow,countHigh,length;
 } privates;
 
+/* The buffers of one comparison thread. They grow to the longest reference
+ * signal and are reused for all the variables the thread compares.
+ */
+typedef struct {
+  size_t size;
+  double *mh,*ml,*xHigh,*xLow,*yHigh,*yLow;
+  int *i0h,*i1h,*i0l,*i1l;
+  double *reftime,*calibrated,*high,*low,*error;
+} tubesScratch;
+
+static void growTubesScratch(tubesScratch *scratch, size_t n)
+{
+  if (n <= scratch->size) {
+    return;
+  }
+  n = n > 2*scratch->size ? n : 2*scratch->size;
+  scratch->mh = (double*) realloc(scratch->mh, n*sizeof(double));
+  scratch->ml = (double*) realloc(scratch->ml, n*sizeof(double));
+  scratch->xHigh = (double*) realloc(scratch->xHigh, n*sizeof(double));
+  scratch->xLow = (double*) realloc(scratch->xLow, n*sizeof(double));
+  scratch->yHigh = (double*) realloc(scratch->yHigh, n*sizeof(double));
+  scratch->yLow = (double*) realloc(scratch->yLow, n*sizeof(double));
+  scratch->i0h = (int*) realloc(scratch->i0h, n*sizeof(int));
+  scratch->i1h = (int*) realloc(scratch->i1h, n*sizeof(int));
+  scratch->i0l = (int*) realloc(scratch->i0l, n*sizeof(int));
+  scratch->i1l = (int*) realloc(scratch->i1l, n*sizeof(int));
+  scratch->reftime = (double*) realloc(scratch->reftime, n*sizeof(double));
+  scratch->calibrated = (double*) realloc(scratch->calibrated, n*sizeof(double));
+  scratch->high = (double*) realloc(scratch->high, n*sizeof(double));
+  scratch->low = (double*) realloc(scratch->low, n*sizeof(double));
+  scratch->error = (double*) realloc(scratch->error, n*sizeof(double));
+  scratch->size = n;
+}
+
+static void freeTubesScratch(tubesScratch *scratch)
+{
+  free(scratch->mh);
+  free(scratch->ml);
+  free(scratch->xHigh);
+  free(scratch->xLow);
+  free(scratch->yHigh);
+  free(scratch->yLow);
+  free(scratch->i0h);
+  free(scratch->i1h);
+  free(scratch->i0l);
+  free(scratch->i1l);
+  free(scratch->reftime);
+  free(scratch->calibrated);
+  free(scratch->high);
+  free(scratch->low);
+  free(scratch->error);
+  memset(scratch, 0, sizeof(tubesScratch));
+}
+
 static inline int intmax(int a, int b) {
   return a>b ? a : b;
 }
@@ -199,10 +253,9 @@ static void generateLowTube(privates *priv, double *x, double *y)
   }
 }
 
-static privates* skipCalculateTubes(double *x, double *y, size_t length)
+static void skipCalculateTubes(privates *priv, tubesScratch *scratch, double *x, double *y, size_t length)
 {
-  privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
-
+  int i;
   /* set tStart and tStop */
   priv->length = length;
   priv->tStart = x[0];
@@ -211,17 +264,24 @@ static privates* skipCalculateTubes(double *x, double *y, size_t length)
   priv->xMinStep = ((priv->tStop - priv->tStart) + fabs(priv->tStart)) * priv->xRelEps;
   priv->countLow = length;
   priv->countHigh = length;
-  priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
+  /* The tubes are the signal itself */
+  priv->xHigh = x;
+  priv->xLow = x;
+  priv->yHigh = scratch->yHigh;
+  priv->yLow  = scratch->yLow;
   memcpy(priv->yHigh, y, length * sizeof(double));
   memcpy(priv->yLow, y, length * sizeof(double));
-  return priv;
+  priv->max = y[0];
+  priv->min = y[0];
+  for (i = 1; i < length; i++) {
+    priv->max = fmax(y[i],priv->max);
+    priv->min = fmin(y[i],priv->min);
+  }
 }
 
 /* This method generates tubes around a given curve */
-static privates* calculateTubes(double *x, double *y, size_t length, double r)
+static void calculateTubes(privates *priv, tubesScratch *scratch, double *x, double *y, size_t length, double r)
 {
-  privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
   int i;
   /* set tStart and tStop */
   priv->length = length;
@@ -233,18 +293,18 @@ static privates* calculateTubes(double *x, double *y, size_t length, double r)
   priv->countHigh = 0;
 
   /* Initialize lists (upper tube) */
-  priv->mh  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
+  priv->mh  = scratch->mh;
+  priv->i0h = scratch->i0h;
+  priv->i1h = scratch->i1h;
   /* Initialize lists (lower tube) */
-  priv->ml  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
+  priv->ml  = scratch->ml;
+  priv->i0l = scratch->i0l;
+  priv->i1l = scratch->i1l;
 
-  priv->xHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->xLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
+  priv->xHigh = scratch->xHigh;
+  priv->xLow  = scratch->xLow;
+  priv->yHigh = scratch->yHigh;
+  priv->yLow  = scratch->yLow;
 
   /* calculate the tubes delta */
   priv->delta = r * (priv->tStop - priv->tStart);
@@ -352,7 +412,6 @@ static privates* calculateTubes(double *x, double *y, size_t length, double r)
   priv->xLow[priv->countLow] = priv->x2 + priv->delta;
   priv->yLow[priv->countLow] = priv->y1 + priv->currentSlope * (priv->x2 + priv->delta - priv->x1);
   priv->countLow++;
-  return priv;
 }
 
 static inline double linearInterpolation(double x, double x0, double x1, double y0, double y1, double xabstol)
@@ -368,20 +427,18 @@ static inline double linearInterpolation(double x, double x0, double x1, double
   }
 }
 
-/* Calibrate the target time+value pair onto the source timeline */
-static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol)
+/* Calibrate the target time+value pair onto the source timeline, into interpolatedValues */
+static void calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol, double *interpolatedValues)
 {
-  double* interpolatedValues;
   int j, i;
   double x0, x1, y0, y1;
   size_t n;
 
-  if (0 == nsource) {
-    return NULL;
+  if (0 == *nsource) {
+    return;
   }
 
   n = *nsource;
-  interpolatedValues = (double*) omc_alloc_interface.malloc_atomic(sizeof(double)*n);
 
   j = 1;
   for (i = 0; i < n; i++) {
@@ -413,8 +470,6 @@ static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, d
       interpolatedValues[i] = linearInterpolation(x,x0,x1,y0,y1,xabstol);
     }
   }
-
-  return interpolatedValues;
 }
 
 typedef struct {
@@ -574,17 +629,24 @@ static addTargetEventTimesRes removeUneventfulPoints(addTargetEventTimesRes in,
   return res;
 }
 
-/* Adds a relative tolerance compared to the reference signal. Overwrites the target values vector. */
+/* Adds a relative tolerance compared to the reference signal. Overwrites the target values vector.
+ * Written without fmax/fmin and branches so that the loops are vectorized; a
+ * NaN in the target is replaced, as fmax would.
+ */
 static void addRelativeTolerance(double *targetValues, double *sourceValues, size_t length, double reltol, double abstol, int direction)
 {
   int i;
   if (direction > 0) {
     for (i=0; i<length; i++) {
-      targetValues[i] = fmax(sourceValues[i] + fmax(fabs(sourceValues[i]*reltol),abstol), targetValues[i]);
+      double tol = fabs(sourceValues[i]*reltol);
+      double v = sourceValues[i] + (tol > abstol ? tol : abstol);
+      targetValues[i] = (v > targetValues[i] || targetValues[i] != targetValues[i]) ? v : targetValues[i];
     }
   } else {
     for (i=0; i<length; i++) {
-      targetValues[i] = fmin(sourceValues[i] - fmax(fabs(sourceValues[i]*reltol),abstol), targetValues[i]);
+      double tol = fabs(sourceValues[i]*reltol);
+      double v = sourceValues[i] - (tol > abstol ? tol : abstol);
+      targetValues[i] = (v < targetValues[i] || targetValues[i] != targetValues[i]) ? v : targetValues[i];
     }
   }
 }
@@ -600,12 +662,21 @@ static void assertMonotonic(addTargetEventTimesRes series)
   }
 }
 
-/* Return NULL if there were no errors */
-static double* validate(int n, addTargetEventTimesRes ref, double *low, double *high, double *calibrated_values, double reltol, double abstol, double xabstol)
+/* Writes the distance of each point outside the tubes to error and returns
+ * the number of such points, 0 if there were no errors.
+ */
+static int validate(int n, addTargetEventTimesRes ref, double *low, double *high, double *calibrated_values, double reltol, double abstol, double xabstol, double *error, double *maxError)
 {
-  double *error = omc_alloc_interface.malloc_atomic(n * sizeof(double));
   int isdifferent = 0;
   int i,lastStepError = 1;
+  double maxErr = 0;
+  /* The distance to the tubes, in a loop without branches that is vectorized */
+  for (i=0; i<n; i++) {
+    double below = low[i]-calibrated_values[i];
+    double above = calibrated_values[i]-high[i];
+    error[i] = below > 0 ? below : (above > 0 ? above : 0);
+  }
+  /* Events get a tube around both values, depending on the previous step */
   for (i=0; i<n; i++) {
     int thisStepError = 0;
     int isEvent = (i && almostEqualRelativeAndAbs(ref.time[i],ref.time[i-1],0,xabstol)) || (i+1<n && almostEqualRelativeAndAbs(ref.time[i],ref.time[i+1],0,xabstol));
@@ -618,27 +689,24 @@ static double* validate(int n, addTargetEventTimesRes ref, double *low, double *
       low[i] = (lastStepError ? refv : fmin(refv,val)) - tol;
       error[i] = NAN;
     } else {
-      error[i] = 0;
       thisStepError=lastStepError;
-      if (calibrated_values[i] < low[i]) {
-        error[i] = low[i]-calibrated_values[i];
-        isdifferent++;
-        thisStepError=1;
-      } else if (calibrated_values[i] > high[i]) {
-        error[i] = calibrated_values[i]-high[i];
+      if (error[i] > 0) {
         isdifferent++;
         thisStepError=1;
+        maxErr = fmax(maxErr, error[i]);
       }
     }
     lastStepError = thisStepError;
   }
-  if (isdifferent) {
-    return error;
-  }
-  return NULL;
+  *maxError = maxErr;
+  return isdifferent;
 }
 
-static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, DiffDataField *ddf, char **cmpdiffvars, unsigned int vardiffindx, int keepEqualResults, void **diffLst, const char *prefix, int isHtml, char **htmlOut)
+/* Compares one variable using tubes around the reference. Does not use the
+ * garbage collector or the error queue, except for the html output, so that
+ * it can run in any thread.
+ */
+static void cmpDataTubes(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, int keepEqualResults, const char *prefix, int isHtml, char **htmlOut, tubesScratch *scratch, CmpResult *result)
 {
   int withTubes = 0 == rangeDelta;
   FILE *fout = NULL;
@@ -648,12 +716,15 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   double xabstol = (reftime->data[reftime->n-1]-reftime->data[0])*(withTubes ? rangeDelta : 1e-3) / fmax(time->n,reftime->n);
   /* Calculate the tubes without additional events added */
   addTargetEventTimesRes ref,actual,actualoriginal;
-  privates *priv=NULL;
+  privates tubes, *priv=&tubes;
   size_t n,maxn,html_size=0;
   double *calibrated_values=NULL, *high=NULL, *low=NULL, *error=NULL,maxPlusTol,minMinusTol,abstol;
 
+  growTubesScratch(scratch, reftime->n > time->n ? reftime->n : time->n);
+  /* The tubes may move points of the reference time line; keep the original intact */
+  memcpy(scratch->reftime, reftime->data, reftime->n*sizeof(double));
   ref.values = refdata->data;
-  ref.time = reftime->data;
+  ref.time = scratch->reftime;
   ref.size = reftime->n;
   actualoriginal.values = data->data;
   actualoriginal.time = time->data;
@@ -665,15 +736,22 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   /* actual = removeUneventfulPoints(actual, reltol*reltol, xabstol); */
   /* assertMonotonic(ref); */
   /* assertMonotonic(actual); */
-  priv = withTubes ? skipCalculateTubes(ref.time,ref.values,ref.size) : calculateTubes(ref.time,ref.values,ref.size,rangeDelta);
+  if (withTubes) {
+    skipCalculateTubes(priv,scratch,ref.time,ref.values,ref.size);
+  } else {
+    calculateTubes(priv,scratch,ref.time,ref.values,ref.size,rangeDelta);
+  }
   /* ref = mergeTimelines(ref,actual,xabstol); */
   /* assertMonotonic(ref); */
   n = ref.size;
-  calibrated_values = calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol);
+  calibrated_values = scratch->calibrated;
+  high = scratch->high;
+  low = scratch->low;
+  calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol,calibrated_values);
   maxPlusTol = priv->max + fabs(priv->max) * reltol;
   minMinusTol = priv->min - fabs(priv->min) * reltol;
-  high = calibrateValues(ref.time,priv->xHigh,priv->yHigh,&n,priv->countHigh,xabstol);
-  low  = calibrateValues(ref.time,priv->xLow,priv->yLow,&n,priv->countLow,xabstol);
+  calibrateValues(ref.time,priv->xHigh,priv->yHigh,&n,priv->countHigh,xabstol,high);
+  calibrateValues(ref.time,priv->xLow,priv->yLow,&n,priv->countLow,xabstol,low);
   /* If all values in the reference are ~0 (and the same)... Allow reltolDiffMaxMin^2 as tolerance
    * Maybe we should just treat it differently though
    * Like not creating a tubes and simply check that the other file also has only identical points close to this
@@ -681,14 +759,15 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   abstol = (priv->max-priv->min == 0 && priv->max < reltolDiffMaxMin*reltolDiffMaxMin) ? reltolDiffMaxMin*reltolDiffMaxMin : fabs((priv->max-priv->min)*reltolDiffMaxMin);
   addRelativeTolerance(high,ref.values,n,reltol,abstol,1);
   addRelativeTolerance(low ,ref.values,n,reltol,abstol,-1);
-  error = validate(n,ref,low,high,calibrated_values,reltol,abstol,xabstol);
+  result->ndiff = validate(n,ref,low,high,calibrated_values,reltol,abstol,xabstol,scratch->error,&result->maxError);
+  error = result->ndiff ? scratch->error : NULL;
   if ( isHtml ) {
 
 #if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L
     html_size=0;
     fout = open_memstream(&html, &html_size);
 #else
-    fname = (char*) omc_alloc_interface.malloc_atomic(25 + strlen(varname));
+    fname = (char*) malloc(25 + strlen(varname));
     sprintf(fname, "tmp.%s.html.tmp", varname);
     fout = fopen(fname, "wb+");
     if (!fout)
@@ -740,7 +819,7 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   rangeDelta
 );
   } else if (!isResultCmp && (error || keepEqualResults)) {
-    fname = (char*) omc_alloc_interface.malloc_atomic(25 + strlen(prefix) + strlen(varname));
+    fname = (char*) malloc(25 + strlen(prefix) + strlen(varname));
     sprintf(fname, "%s.%s.csv", prefix, varname);
     fout = fopen(fname,"w");
   }
@@ -780,13 +859,6 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
     }
     fputs(isHtml ? "],\n" : "\n", fout);
   }
-  if (error) {
-    cmpdiffvars[vardiffindx] = varname;
-    vardiffindx++;
-    if (!isResultCmp) {
-      *diffLst = mmc_mk_cons(mmc_mk_scon(varname),*diffLst);
-    }
-  }
   if (fout) {
     if (isHtml) {
 fprintf(fout, "{title: '%s',\n"
@@ -839,24 +911,5 @@ fprintf(fout, "{title: '%s',\n"
       fclose(fout);
     }
   }
-  /* Tell the GC some variables have been free'd */
-  if (error) GC_free(error);
-  if (fname) GC_free(fname);
-  GC_free(low);
-  GC_free(high);
-  if (withTubes) {
-    GC_free(priv->mh);
-    GC_free(priv->i0h);
-    GC_free(priv->i1h);
-    GC_free(priv->ml);
-    GC_free(priv->i0l);
-    GC_free(priv->i1l);
-    GC_free(priv->xHigh);
-    GC_free(priv->xLow);
-  }
-  GC_free(priv->yHigh);
-  GC_free(priv->yLow);
-  GC_free(priv);
-  GC_free(calibrated_values);
-  return vardiffindx;
+  if (fname) free(fname);
 }
@@ -62,7 +62,10 @@ typedef struct errorext_struct {
   bool pop_more_on_rollback;
   int numErrorMessages;
   int numWarningMessages;
-  deque<ErrorMessage*> *errorMessageQueue; // Global variable of all error messages.
+  int numMessages; // including the duplicates collapsed into one queue entry
+  deque<ErrorMessage> *errorMessageQueue; // Global variable of all error messages.
+  ErrorStringPool *strings; // the strings and tokens of the messages in the queue
+  string *buffer; // reused when concatenating and printing messages
   vector<pair<int,string> > *checkPoints; // a checkpoint has a message index no, and a unique identifier
   string *lastDeletedCheckpoint;
   int showErrorMessages;
@@ -78,6 +81,8 @@ static void free_error(void *data)
   errorext_members *members = (errorext_members *) data;
   if (data == NULL) return;
   delete members->errorMessageQueue;
+  delete members->strings;
+  delete members->buffer;
   delete members->checkPoints;
   delete members->lastDeletedCheckpoint;
   free(members);
@@ -101,7 +106,11 @@ static errorext_members* getMembers(threadData_t *threadData)
   res->pop_more_on_rollback = false;
   res->numErrorMessages = 0;
   res->numWarningMessages = 0;
-  res->errorMessageQueue = new deque<ErrorMessage*>;
+  res->numMessages = 0;
+  res->errorMessageQueue = new deque<ErrorMessage>;
+  res->strings = new ErrorStringPool;
+  res->buffer = new string;
+  res->buffer->reserve(4096);
   res->checkPoints = new vector<pair<int,string> >;
   res->lastDeletedCheckpoint = new string;
   res->showErrorMessages = 0;
@@ -115,41 +124,101 @@ static errorext_members* getMembers(threadData_t *threadData)
   return res;
 }
 
-static void push_message(threadData_t *threadData,ErrorMessage *msg)
+static void count_message(errorext_members *members, const ErrorMessage &msg, int n)
+{
+  if (msg.getSeverity() == ErrorLevel_error || msg.getSeverity() == ErrorLevel_internal) members->numErrorMessages += n;
+  if (msg.getSeverity() == ErrorLevel_warning) members->numWarningMessages += n;
+  members->numMessages += n;
+}
+
+static void push_message(threadData_t *threadData,const ErrorMessage &msg)
 {
   errorext_members *members = getMembers(threadData);
+  deque<ErrorMessage> *queue = members->errorMessageQueue;
   if (members->showErrorMessages)
   {
-    std::cerr << msg->getFullMessage() << std::endl;
+    members->buffer->clear();
+    msg.appendFullMessage(*members->buffer);
+    std::cerr << *members->buffer << std::endl;
   }
   // adrpo: ALWAYS PUSH THE ERROR MESSAGE IN THE QUEUE, even if we have showErrorMessages because otherwise the numErrorMessages is completely wrong!
-  members->errorMessageQueue->push_back(msg);
-  if (msg->getSeverity() == ErrorLevel_error || msg->getSeverity() == ErrorLevel_internal) members->numErrorMessages++;
-  if (msg->getSeverity() == ErrorLevel_warning) members->numWarningMessages++;
+  // A repeated message is only counted, unless the previous one is below the top checkpoint and may not be rolled back together with it.
+  if (!queue->empty() && (members->checkPoints->empty() || queue->size() > members->checkPoints->back().first) && queue->back().sameMessage(msg)) {
+    queue->back().addDuplicates(1);
+  } else {
+    queue->push_back(msg);
+  }
+  count_message(members, msg, 1);
 }
 
 /* pop the top of the message stack (and any duplicate messages that have also been added) */
 static void pop_message(threadData_t *threadData, bool rollback)
 {
   errorext_members *members = getMembers(threadData);
+  deque<ErrorMessage> *queue = members->errorMessageQueue;
   bool pop_more;
   do {
-    ErrorMessage *msg = members->errorMessageQueue->back();
-    if (msg->getSeverity() == ErrorLevel_error || msg->getSeverity() == ErrorLevel_internal) members->numErrorMessages--;
-    if (msg->getSeverity() == ErrorLevel_warning) members->numWarningMessages--;
-    members->errorMessageQueue->pop_back();
-    pop_more = (!(members->errorMessageQueue->empty()) && !(rollback && members->errorMessageQueue->size() <= members->checkPoints->back().first) && msg->getFullMessage() == members->errorMessageQueue->back()->getFullMessage());
-    delete msg;
+    ErrorMessage msg = queue->back();
+    count_message(members, msg, -msg.getCount());
+    queue->pop_back();
+    pop_more = (!(queue->empty()) && !(rollback && queue->size() <= members->checkPoints->back().first) && msg.sameMessage(queue->back()));
   } while (pop_more);
+  if (queue->empty()) {
+    members->strings->clear();
+  }
 }
 
-/* Adds a message with file information */
+/* Removes all messages from index first on */
+static void remove_messages(errorext_members *members, size_t first)
+{
+  deque<ErrorMessage> *queue = members->errorMessageQueue;
+  for (size_t i = first; i < queue->size(); i++) {
+    count_message(members, (*queue)[i], -(*queue)[i].getCount());
+  }
+  queue->erase(queue->begin() + first, queue->end());
+  if (queue->empty()) {
+    members->strings->clear();
+  }
+}
+
+/* Prints all messages from index first on into res and removes them. A run of
+ * identical messages is printed once, as pop_message would remove it at once.
+ */
+static void print_messages(errorext_members *members, size_t first, std::string &res, int warningsAsErrors)
+{
+  deque<ErrorMessage> *queue = members->errorMessageQueue;
+  for (size_t i = first; i < queue->size(); i++) {
+    if (i+1 < queue->size() && (*queue)[i].sameMessage((*queue)[i+1])) {
+      continue;
+    }
+    (*queue)[i].appendMessage(res, warningsAsErrors);
+    res += '\n';
+  }
+  remove_messages(members, first);
+}
+
+/* The tokens of a message; short lists are kept on the stack */
+class ErrorTokenArray {
+public:
+  ErrorTokenArray(int n) : tokens_(n <= 16 ? stack_ : new const char*[n]) {};
+  ~ErrorTokenArray() { if (tokens_ != stack_) delete [] tokens_; };
+  const char*& operator[](int i) { return tokens_[i]; };
+  const char* const* data() const { return tokens_; };
+private:
+  const char *stack_[16];
+  const char **tokens_;
+  ErrorTokenArray(const ErrorTokenArray&);
+  ErrorTokenArray& operator=(const ErrorTokenArray&);
+};
+
+/* Adds a message with file information; the tokens are in the order they are inserted */
 void add_source_message(threadData_t *threadData,
       int errorID,
       ErrorType type,
       ErrorLevel severity,
       const char* message,
-      ErrorMessage::TokenList tokens,
+      const char* const* tokens,
+      int nTokens,
       int startLine,
       int startCol,
       int endLine,
@@ -157,18 +226,19 @@ void add_source_message(threadData_t *threadData,
       bool isReadOnly,
       const char* filename)
 {
-  ErrorMessage* msg = new ErrorMessage((long)errorID,
+  ErrorStringPool *strings = getMembers(threadData)->strings;
+  push_message(threadData,ErrorMessage((long)errorID,
        type,
        severity,
-       std::string(message),
-       tokens,
+       strings->intern(message),
+       strings->internTokens(tokens, nTokens),
+       nTokens,
        (long)startLine,
        (long)startCol,
        (long)endLine,
        (long)endCol,
        isReadOnly,
-       std::string(filename));
-  push_message(threadData,msg);
+       strings->intern(filename)));
 }
 
 extern "C"
@@ -191,7 +261,7 @@ static void printCheckpointStack(threadData_t *threadData)
     cp = (*members->checkPoints)[i];
     printf("%5d %s   message:", i, cp.second.c_str());
     while(members->errorMessageQueue->size() > cp.first && !members->errorMessageQueue->empty()){
-      res = members->errorMessageQueue->back()->getMessage(0)+string(" ")+res;
+      res = members->errorMessageQueue->back().getMessage(0)+string(" ")+res;
       pop_message(threadData,false);
     }
     printf("%s\n", res.c_str());
@@ -264,18 +334,9 @@ extern void ErrorImpl__rollBack(threadData_t *threadData,const char* id)
     //std::string res("");
     //printf(res.c_str());
     //printf(" rollback from: %d to: %d\n",errorMessageQueue->size(),checkPoints->back().first);
-    while(members->errorMessageQueue->size() > members->checkPoints->back().first && !members->errorMessageQueue->empty()){
-      //printf("*** %d deleted %d ***\n",errorMessageQueue->size(),checkPoints->back().first);
-      /*if(!errorMessageQueue->empty()){
-        res = res+errorMessageQueue->back()->getMessage()+string("\n");
-        printf( (string("Deleted: ") + res).c_str());
-      }*/
-      pop_message(threadData,true);
+    if (members->errorMessageQueue->size() > members->checkPoints->back().first) {
+      remove_messages(members, members->checkPoints->back().first);
     }
-    /*if(!errorMessageQueue->empty()){
-      res = res+errorMessageQueue->back()->getMessage()+string("\n");
-      printf("(%d)new bottom message: %s\n",checkPoints->size(),res.c_str());
-    }*/
     pair<int,string> cp;
     cp = (*members->checkPoints)[members->checkPoints->size()-1];
     if (0 != strcmp(cp.second.c_str(),id)) {
@@ -300,8 +361,8 @@ extern void ErrorImpl__rollbackNumCheckpoints(threadData_t *threadData, int n)
     exit(1);
   }
   while (--n >= 0) {
-    while(members->errorMessageQueue->size() > members->checkPoints->back().first && !members->errorMessageQueue->empty()){
-      pop_message(threadData,true);
+    if (members->errorMessageQueue->size() > members->checkPoints->back().first) {
+      remove_messages(members, members->checkPoints->back().first);
     }
     members->checkPoints->pop_back();
   }
@@ -310,12 +371,12 @@ extern void ErrorImpl__rollbackNumCheckpoints(threadData_t *threadData, int n)
 extern char* ErrorImpl__rollBackAndPrint(threadData_t *threadData,const char* id)
 {
   errorext_members *members = getMembers(threadData);
-  std::string res("");
+  std::string &res = *members->buffer;
+  res.clear();
   // fprintf(stderr, "rollBackAndPrint(%s)\n",id); fflush(stderr);
   if (members->checkPoints->size() > 0){
-    while(members->errorMessageQueue->size() > members->checkPoints->back().first && !members->errorMessageQueue->empty()){
-      res = members->errorMessageQueue->back()->getMessage(0)+string("\n")+res;
-      pop_message(threadData,true);
+    if (members->errorMessageQueue->size() > members->checkPoints->back().first) {
+      print_messages(members, members->checkPoints->back().first, res, 0);
     }
     pair<int,string> cp;
     cp = (*members->checkPoints)[members->checkPoints->size()-1];
@@ -384,10 +445,6 @@ extern void c_add_message(threadData_t *threadData,int errorID, ErrorType type,
   if (!threadData) {
     threadData = (threadData_t*)pthread_getspecific(mmc_thread_data_key);
   }
-  ErrorMessage::TokenList tokens;
-  for (int i=nTokens-1; i>=0; i--) {
-    tokens.push_back(std::string(ctokens[i]));
-  }
 #if !defined(OPENMODELICA_BOOTSTRAPPING_STAGE_1)
   void *mmc_filename;
   str = MMC_STRINGDATA(omc_Error_getCurrentComponent(threadData, &sline, &scol, &eline, &ecol, &read_only, &mmc_filename));
@@ -401,19 +458,27 @@ extern void c_add_message(threadData_t *threadData,int errorID, ErrorType type,
   str="";
   filename="";
 #endif
-  ErrorMessage *msg = *(const char*)MMC_STRINGDATA(str) ?
-    new ErrorMessage((long)errorID, type, severity, std::string((const char*)MMC_STRINGDATA(str)) + std::string(message), tokens, sline , scol, eline, ecol, read_only, MMC_STRINGDATA(filename)) :
-    new ErrorMessage((long)errorID, type, severity, message, tokens);
-  push_message(threadData,msg);
+  errorext_members *members = getMembers(threadData);
+  ErrorTokenArray tokens(nTokens);
+  for (int i=0; i<nTokens; i++) {
+    tokens[i] = ctokens[nTokens-1-i];
+  }
+  if (*str) {
+    members->buffer->assign(str);
+    members->buffer->append(message);
+    add_source_message(threadData, errorID, type, severity, members->buffer->c_str(), tokens.data(), nTokens, sline, scol, eline, ecol, read_only, filename);
+  } else {
+    add_source_message(threadData, errorID, type, severity, message, tokens.data(), nTokens, 0, 0, 0, 0, false, "");
+  }
 }
 
 extern void c_add_source_message(threadData_t *threadData,int errorID, ErrorType type, ErrorLevel severity, const char* message, const char** ctokens, int nTokens, int startLine, int startCol, int endLine, int endCol, int isReadOnly, const char* filename)
 {
-  ErrorMessage::TokenList tokens;
-  for (int i=nTokens-1; i>=0; i--) {
-    tokens.push_back(std::string(ctokens[i]));
+  ErrorTokenArray tokens(nTokens);
+  for (int i=0; i<nTokens; i++) {
+    tokens[i] = ctokens[nTokens-1-i];
   }
-  add_source_message(threadData,errorID,type,severity,message,tokens,startLine,startCol,endLine,endCol,isReadOnly,filename);
+  add_source_message(threadData,errorID,type,severity,message,tokens.data(),nTokens,startLine,startCol,endLine,endCol,isReadOnly,filename);
 }
 
 extern int ErrorImpl__getNumErrorMessages(threadData_t *threadData) {
@@ -427,26 +492,24 @@ extern int ErrorImpl__getNumWarningMessages(threadData_t *threadData) {
 extern void ErrorImpl__clearMessages(threadData_t *threadData)
 {
   // fprintf(stderr, "-> ErrorImpl__clearMessages error messages: %d queue size: %d\n", numErrorMessages, (int)errorMessageQueue->size()); fflush(NULL);
-  while(!getMembers(threadData)->errorMessageQueue->empty()) {
-    pop_message(threadData,false);
-  }
+  remove_messages(getMembers(threadData), 0);
 }
 
-// TODO: Use a string builder instead of creating intermediate results all the time?
 extern void* ErrorImpl__getMessages(threadData_t *threadData)
 {
   errorext_members *members = getMembers(threadData);
   void *res = mmc_mk_nil();
   while(!members->errorMessageQueue->empty()) {
-    void *id = mmc_mk_icon(members->errorMessageQueue->back()->getID());
+    const ErrorMessage &back = members->errorMessageQueue->back();
+    void *id = mmc_mk_icon(back.getID());
     void *ty,*severity;
-    switch (members->errorMessageQueue->back()->getSeverity()) {
+    switch (back.getSeverity()) {
     case ErrorLevel_internal: severity=Error__INTERNAL; break;
     case ErrorLevel_error: severity=Error__ERROR; break;
     case ErrorLevel_warning: severity=Error__WARNING; break;
     case ErrorLevel_notification: severity=Error__NOTIFICATION; break;
     }
-    switch (members->errorMessageQueue->back()->getType()) {
+    switch (back.getType()) {
     case ErrorType_syntax: ty=Error__SYNTAX; break;
     case ErrorType_grammar: ty=Error__GRAMMAR; break;
     case ErrorType_translation: ty=Error__TRANSLATION; break;
@@ -454,14 +517,16 @@ extern void* ErrorImpl__getMessages(threadData_t *threadData)
     case ErrorType_runtime: ty=Error__SIMULATION; break;
     case ErrorType_scripting: ty=Error__SCRIPTING; break;
     }
-    void *message = Util__notrans(mmc_mk_scon(members->errorMessageQueue->back()->getShortMessage().c_str()));
+    members->buffer->clear();
+    back.appendShortMessage(*members->buffer);
+    void *message = Util__notrans(mmc_mk_scon(members->buffer->c_str()));
     void *msg = Error__MESSAGE(id,ty,severity,message);
-    void *sl = mmc_mk_icon(members->errorMessageQueue->back()->getStartLineNo());
-    void *sc = mmc_mk_icon(members->errorMessageQueue->back()->getStartColumnNo());
-    void *el = mmc_mk_icon(members->errorMessageQueue->back()->getEndLineNo());
-    void *ec = mmc_mk_icon(members->errorMessageQueue->back()->getEndColumnNo());
-    void *filename = mmc_mk_scon(members->errorMessageQueue->back()->getFileName().c_str());
-    void *readonly = mmc_mk_icon(members->errorMessageQueue->back()->getIsFileReadOnly());
+    void *sl = mmc_mk_icon(back.getStartLineNo());
+    void *sc = mmc_mk_icon(back.getStartColumnNo());
+    void *el = mmc_mk_icon(back.getEndLineNo());
+    void *ec = mmc_mk_icon(back.getEndColumnNo());
+    void *filename = mmc_mk_scon(back.getFileName());
+    void *readonly = mmc_mk_icon(back.getIsFileReadOnly());
     void *info = SourceInfo__SOURCEINFO(filename,readonly,sl,sc,el,ec,mmc_mk_rcon(0));
     void *totmsg = Error__TOTALMESSAGE(msg,info);
     res = mmc_mk_cons(totmsg,res);
@@ -472,34 +537,35 @@ extern void* ErrorImpl__getMessages(threadData_t *threadData)
 
 } // extern "C"
 
-// TODO: Use a string builder instead of creating intermediate results all the time?
 extern std::string ErrorImpl__printErrorsNoWarning(threadData_t *threadData)
 {
   errorext_members *members = getMembers(threadData);
-  std::string res("");
-  while(!members->errorMessageQueue->empty()) {
-    //if(strncmp(errorMessageQueue->back()->getSeverity(),"Error")==0){
-    if(members->errorMessageQueue->back()->getSeverity() == ErrorLevel_error
-        || members->errorMessageQueue->back()->getSeverity() == ErrorLevel_internal) {
-      res = members->errorMessageQueue->back()->getMessage(0)+string("\n")+res;
-      members->numErrorMessages--;
+  deque<ErrorMessage> *queue = members->errorMessageQueue;
+  std::string &res = *members->buffer;
+  res.clear();
+  for (deque<ErrorMessage>::const_iterator it = queue->begin(); it != queue->end(); ++it) {
+    if(it->getSeverity() == ErrorLevel_error
+        || it->getSeverity() == ErrorLevel_internal) {
+      for (int i = 0; i < it->getCount(); i++) {
+        it->appendMessage(res, 0);
+        res += '\n';
+      }
+      members->numErrorMessages -= it->getCount();
     }
-    delete members->errorMessageQueue->back();
-    members->errorMessageQueue->pop_back();
   }
+  queue->clear();
+  members->numMessages = 0;
+  members->strings->clear();
   return res;
 }
 
-// TODO: Use a string builder instead of creating intermediate results all the time?
 extern std::string ErrorImpl__printMessagesStr(threadData_t *threadData, int warningsAsErrors)
 {
   errorext_members *members = getMembers(threadData);
   // fprintf(stderr, "-> ErrorImpl__printMessagesStr error messages: %d queue size: %d\n", numErrorMessages, (int)errorMessageQueue->size()); fflush(NULL);
-  std::string res("");
-  while(!members->errorMessageQueue->empty()) {
-    res = members->errorMessageQueue->back()->getMessage(warningsAsErrors)+string("\n")+res;
-    pop_message(threadData,false);
-  }
+  std::string &res = *members->buffer;
+  res.clear();
+  print_messages(members, 0, res, warningsAsErrors);
   return res;
 }
 
@@ -535,10 +601,20 @@ void Error_moveMessagesToParentThread(threadData_t *threadData)
   thread = getMembers(threadData);
   pthread_mutex_lock(&threadData->parent->parentMutex);
   parent = getMembers(threadData->parent);
-  while(!thread->errorMessageQueue->empty()) {
-    parent->errorMessageQueue->push_back(thread->errorMessageQueue->front());
-    thread->errorMessageQueue->pop_front();
+  // the strings of the messages belong to the pool of the thread
+  for (deque<ErrorMessage>::const_iterator it = thread->errorMessageQueue->begin(); it != thread->errorMessageQueue->end(); ++it) {
+    ErrorMessage msg(it->getID(), it->getType(), it->getSeverity(),
+                     parent->strings->intern(it->getMessageTemplate()),
+                     parent->strings->internTokens(it->getTokens(), it->getNumTokens()),
+                     it->getNumTokens(),
+                     it->getStartLineNo(), it->getStartColumnNo(), it->getEndLineNo(), it->getEndColumnNo(),
+                     it->getIsFileReadOnly(),
+                     parent->strings->intern(it->getFileName()));
+    msg.addDuplicates(it->getCount()-1);
+    parent->errorMessageQueue->push_back(msg);
+    count_message(parent, msg, it->getCount());
   }
+  remove_messages(thread, 0);
   pthread_mutex_unlock(&threadData->parent->parentMutex);
 }
 
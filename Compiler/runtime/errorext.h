@@ -67,6 +67,8 @@ void ErrorImpl__setCheckpoint(threadData_t *threadData,const char* id);
 void ErrorImpl__delCheckpoint(threadData_t *threadData,const char* id);
 void ErrorImpl__rollBack(threadData_t *threadData,const char* id);
 char* ErrorImpl__rollBackAndPrint(threadData_t *threadData,const char* id); // Returns the error string that we rolled back. free this resource
+int ErrorImpl__getNumErrorMessages(threadData_t *threadData);
+int ErrorImpl__getNumWarningMessages(threadData_t *threadData);
 
 #ifdef __cplusplus
   }
@@ -0,0 +1,267 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF GPL VERSION 3 LICENSE OR
+ * THIS OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from OSMC, either from the above address,
+ * from the URLs: http://www.ida.liu.se/projects/OpenModelica or
+ * http://www.openmodelica.org, and in the OpenModelica distribution.
+ * GNU version 3 is obtained from: http://www.gnu.org/copyleft/gpl.html.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ * Benchmark of the maximum transversal algorithms in matching.c on an
+ * incidence matrix in Matrix Market coordinate format, rows being variables
+ * and columns equations. omc writes the matrices it matches in this format
+ * with -d=dumpMatchingMatrix.
+ *
+ * Prints one line per matching algorithm, cheap matching and thread count
+ * with the best time of all repetitions and the cardinality of the matching.
+ * The thread count only matters for the parallel algorithms (cheap matching 5,
+ * matching 11); the sequential ones are run once with threads reported as 1.
+ *
+ * Build with "make matching-benchmark" in Compiler/runtime.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "matchmaker.h"
+#include "rtclock.h"
+#include "gc/omc_gc.h"
+#include "util/omc_error.h"
+
+/* rtclock.c is linked without the rest of the runtime; these are the only
+ * parts of it that rtclock.c uses */
+static void benchmark_init(void) {}
+static int benchmark_collect(void) { return 0; }
+static void* benchmark_malloc_zero(size_t size) { return calloc(1, size); }
+static char* benchmark_strdup(const char *str) { return strcpy((char*) malloc(strlen(str)+1), str); }
+
+omc_alloc_interface_t omc_alloc_interface = {
+  benchmark_init,
+  malloc,
+  malloc,
+  (char*(*)(size_t)) malloc,
+  benchmark_strdup,
+  benchmark_collect,
+  benchmark_malloc_zero,
+  free,
+  malloc,
+  free
+};
+
+void throwStreamPrint(threadData_t *threadData, const char *format, ...)
+{
+  va_list ap;
+  va_start(ap, format);
+  vfprintf(stderr, format, ap);
+  va_end(ap);
+  exit(1);
+}
+
+static const char *algorithm_names[] = {
+  "", "DFS", "BFS", "MC21", "PF", "PF+", "HK", "HK-DW", "ABMP", "ABMP-BFS", "PR-FIFO-FAIR", "MS-BFS-PAR"
+};
+
+static void usage(const char *program)
+{
+  fprintf(stderr,
+    "Usage: %s [options] matrix.mtx\n"
+    "  -a list   matching algorithms (matchingID 1-11, default all)\n"
+    "  -c list   cheap matchings (cheapID 0-5, default 3)\n"
+    "  -t list   thread counts for the parallel algorithms (default 1,2,4,... up to the number of processors)\n"
+    "  -r n      repetitions, the best time is reported (default 3)\n"
+    "Lists are comma-separated.\n", program);
+}
+
+static int parse_list(const char *str, int *values, int max)
+{
+  int count = 0;
+  char *end;
+  while (*str && count < max) {
+    values[count++] = (int) strtol(str, &end, 10);
+    if (end == str) return -1;
+    str = (*end == ',') ? end+1 : end;
+  }
+  return count;
+}
+
+/* Reads the pattern of a Matrix Market coordinate matrix into CSC */
+static int read_matrix_market(const char *filename, int **col_ptrs, int **col_ids, int *n, int *m)
+{
+  char line[1024];
+  long rows, cols, nz, k;
+  int *row_of, *col_of, i;
+  FILE *file = fopen(filename, "r");
+
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open %s\n", filename);
+    return 1;
+  }
+  do {
+    if (fgets(line, sizeof(line), file) == NULL) {
+      fprintf(stderr, "%s: missing size line\n", filename);
+      fclose(file);
+      return 1;
+    }
+  } while (line[0] == '%');
+  if (sscanf(line, "%ld %ld %ld", &rows, &cols, &nz) != 3 || rows < 0 || cols < 0 || nz < 0) {
+    fprintf(stderr, "%s: expected 'rows columns entries', got: %s", filename, line);
+    fclose(file);
+    return 1;
+  }
+
+  row_of = (int*) malloc((nz > 0 ? nz : 1) * sizeof(int));
+  col_of = (int*) malloc((nz > 0 ? nz : 1) * sizeof(int));
+  for (k = 0; k < nz; k++) {
+    long r, c;
+    if (fgets(line, sizeof(line), file) == NULL || sscanf(line, "%ld %ld", &r, &c) != 2 || r < 1 || r > rows || c < 1 || c > cols) {
+      fprintf(stderr, "%s: bad entry %ld\n", filename, k+1);
+      free(row_of);
+      free(col_of);
+      fclose(file);
+      return 1;
+    }
+    row_of[k] = (int) r-1;
+    col_of[k] = (int) c-1;
+  }
+  fclose(file);
+
+  *m = (int) rows;
+  *n = (int) cols;
+  *col_ptrs = (int*) calloc(cols+1, sizeof(int));
+  *col_ids = (int*) malloc((nz > 0 ? nz : 1) * sizeof(int));
+  for (k = 0; k < nz; k++) (*col_ptrs)[col_of[k]+1]++;
+  for (i = 0; i < cols; i++) (*col_ptrs)[i+1] += (*col_ptrs)[i];
+  {
+    int *pos = (int*) malloc((cols > 0 ? cols : 1) * sizeof(int));
+    memcpy(pos, *col_ptrs, cols * sizeof(int));
+    for (k = 0; k < nz; k++) (*col_ids)[pos[col_of[k]]++] = row_of[k];
+    free(pos);
+  }
+  free(row_of);
+  free(col_of);
+  return 0;
+}
+
+/* Returns the cardinality of the matching, or -1 if it is inconsistent */
+static int check_matching(const int *col_ptrs, const int *col_ids, const int *match, const int *row_match, int n, int m)
+{
+  int i, j, card = 0;
+  for (i = 0; i < n; i++) {
+    if (match[i] == -1) continue;
+    if (match[i] < 0 || match[i] >= m || row_match[match[i]] != i) return -1;
+    for (j = col_ptrs[i]; j < col_ptrs[i+1] && col_ids[j] != match[i]; j++);
+    if (j == col_ptrs[i+1]) return -1;
+    card++;
+  }
+  for (i = 0; i < m; i++) {
+    if (row_match[i] != -1 && (row_match[i] < 0 || row_match[i] >= n || match[row_match[i]] != i)) return -1;
+  }
+  return card;
+}
+
+int main(int argc, char **argv)
+{
+  int algorithms[64], cheaps[64], threads[64];
+  int nalgorithms = 0, ncheaps = 1, nthreads = 0, repeats = 3;
+  int *col_ptrs, *col_ids, *match, *row_match, n, m;
+  int a, c, t, r, i;
+  rtclock_t clock;
+  const char *filename = NULL;
+
+  cheaps[0] = do_sk_cheap_rand;
+  for (i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "-a") && i+1 < argc) {
+      nalgorithms = parse_list(argv[++i], algorithms, 64);
+    } else if (0 == strcmp(argv[i], "-c") && i+1 < argc) {
+      ncheaps = parse_list(argv[++i], cheaps, 64);
+    } else if (0 == strcmp(argv[i], "-t") && i+1 < argc) {
+      nthreads = parse_list(argv[++i], threads, 64);
+    } else if (0 == strcmp(argv[i], "-r") && i+1 < argc) {
+      repeats = atoi(argv[++i]);
+    } else if (argv[i][0] != '-' && filename == NULL) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (filename == NULL || nalgorithms < 0 || ncheaps <= 0 || nthreads < 0 || repeats < 1) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (nalgorithms == 0) {
+    for (a = do_dfs; a <= do_ms_bfs_par; a++) algorithms[nalgorithms++] = a;
+  }
+  if (nthreads == 0) {
+    int nproc = matching_get_num_threads();
+    for (t = 1; t < nproc && nthreads < 63; t *= 2) threads[nthreads++] = t;
+    threads[nthreads++] = nproc;
+  }
+
+  if (read_matrix_market(filename, &col_ptrs, &col_ids, &n, &m)) {
+    return 1;
+  }
+  match = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+  row_match = (int*) malloc((m > 0 ? m : 1) * sizeof(int));
+  printf("# %s: %d variables, %d equations, %d entries\n", filename, m, n, col_ptrs[n]);
+  printf("%-14s %6s %8s %12s %12s\n", "algorithm", "cheap", "threads", "time[s]", "cardinality");
+
+  for (a = 0; a < nalgorithms; a++) {
+    if (algorithms[a] < do_dfs || algorithms[a] > do_ms_bfs_par) {
+      fprintf(stderr, "Unknown matching algorithm %d\n", algorithms[a]);
+      continue;
+    }
+    for (c = 0; c < ncheaps; c++) {
+      int parallel = algorithms[a] == do_ms_bfs_par || cheaps[c] == do_sk_cheap_par;
+      for (t = 0; t < (parallel ? nthreads : 1); t++) {
+        double best = -1.0;
+        int card = 0;
+        matching_set_num_threads(parallel ? threads[t] : 1);
+        for (r = 0; r < repeats; r++) {
+          double time;
+          rt_ext_tp_tick(&clock);
+          matching(col_ptrs, col_ids, match, row_match, n, m, algorithms[a], cheaps[c], 1.0, 1);
+          time = rt_ext_tp_tock(&clock);
+          if (best < 0 || time < best) best = time;
+        }
+        card = check_matching(col_ptrs, col_ids, match, row_match, n, m);
+        if (card < 0) {
+          fprintf(stderr, "%s with cheap matching %d produced an inconsistent matching\n", algorithm_names[algorithms[a]], cheaps[c]);
+        }
+        printf("%-14s %6d %8d %12.6f %12d\n", algorithm_names[algorithms[a]], cheaps[c], parallel ? threads[t] : 1, best, card);
+        fflush(stdout);
+      }
+    }
+  }
+
+  free(row_match);
+  free(match);
+  free(col_ids);
+  free(col_ptrs);
+  return 0;
+}
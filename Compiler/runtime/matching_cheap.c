@@ -572,6 +572,10 @@ void cheap_matching(int *col_ptrs, int *col_ids, int *row_ptrs, int *row_ids, in
   {
     mind_cheap(col_ptrs, col_ids, row_ptrs, row_ids, match, row_match, n, m);
   }
+  else if(do_sk_cheap_par == cheap_id)
+  {
+    sk_cheap_par(col_ptrs, col_ids, row_ptrs, row_ids, match, row_match, n, m);
+  }
 }
 
 void cheapmatching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int cheap_id, int clear_match) {
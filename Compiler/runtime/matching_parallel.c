@@ -0,0 +1,420 @@
+/*
+ * File: matching_parallel.c
+ * Content: Multithreaded jump-start heuristic and maximum transversal algorithm
+ *
+ * The algorithms follow
+ *
+ *   "A. Azad, M. Halappanavar, S. Rajamanickam, E. G. Boman, A. Khan and A. Pothen.
+ *   'Multithreaded Algorithms for Maximum Matching in Bipartite Graphs'
+ *   IPDPS 2012."
+ *
+ * sk_cheap_par is Karp-Sipser where every thread starts chains of degree-one
+ * rows and claims vertices with compare-and-swap, followed by a parallel
+ * greedy pass. match_ms_bfs_par grows a forest of vertex-disjoint alternating
+ * BFS trees from all unmatched columns at once, one level at a time with the
+ * frontier split between threads, and then augments along all found paths in
+ * parallel. Phases are repeated until no tree reaches an unmatched row.
+ *
+ * Both work on the same data as the sequential algorithms in matching.c and
+ * matching_cheap.c and are selected through cheap_id do_sk_cheap_par and
+ * matching_id do_ms_bfs_par.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "matchmaker.h"
+
+/* Below this many columns per thread the threads only cost time */
+#define MIN_COLUMNS_PER_THREAD 4096
+
+static int matching_num_threads = 0;
+
+void matching_set_num_threads(int num_threads)
+{
+  matching_num_threads = num_threads;
+}
+
+int matching_get_num_threads(void)
+{
+  if (matching_num_threads > 0) {
+    return matching_num_threads;
+  }
+#if defined(_WIN32)
+  {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+  }
+#else
+  {
+    long nproc = sysconf(_SC_NPROCESSORS_ONLN);
+    return nproc > 0 ? (int) nproc : 1;
+  }
+#endif
+}
+
+static int num_threads_for(int n)
+{
+  int nthreads = matching_get_num_threads();
+  int useful = n / MIN_COLUMNS_PER_THREAD;
+  if (nthreads > useful) nthreads = useful;
+  return nthreads < 1 ? 1 : nthreads;
+}
+
+static inline int cas_int(int *ptr, int expected, int desired)
+{
+  return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static inline int load_int(const int *ptr)
+{
+  return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+}
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int count;
+  int waiting;
+  int generation;
+} barrier_t;
+
+static void barrier_init(barrier_t *b, int count)
+{
+  pthread_mutex_init(&b->mutex, NULL);
+  pthread_cond_init(&b->cond, NULL);
+  b->count = count;
+  b->waiting = 0;
+  b->generation = 0;
+}
+
+static void barrier_destroy(barrier_t *b)
+{
+  pthread_cond_destroy(&b->cond);
+  pthread_mutex_destroy(&b->mutex);
+}
+
+static void barrier_wait(barrier_t *b)
+{
+  int generation;
+  if (b->count == 1) return;
+  pthread_mutex_lock(&b->mutex);
+  generation = b->generation;
+  if (++b->waiting == b->count) {
+    b->waiting = 0;
+    b->generation++;
+    pthread_cond_broadcast(&b->cond);
+  } else {
+    while (generation == b->generation) {
+      pthread_cond_wait(&b->cond, &b->mutex);
+    }
+  }
+  pthread_mutex_unlock(&b->mutex);
+}
+
+/* [start,end) of the tid-th of nthreads equal parts of 0..size-1 */
+static inline void chunk(int size, int tid, int nthreads, int *start, int *end)
+{
+  *start = (int) (((long long) size * tid) / nthreads);
+  *end = (int) (((long long) size * (tid+1)) / nthreads);
+}
+
+/* Runs worker(arg, tid) on nthreads threads, tid 0 on the calling thread */
+typedef void (*worker_fn)(void *arg, int tid);
+
+typedef struct {
+  worker_fn worker;
+  void *arg;
+  int tid;
+} thread_start;
+
+static void* thread_main(void *p)
+{
+  thread_start *start = (thread_start*) p;
+  start->worker(start->arg, start->tid);
+  return NULL;
+}
+
+static void run_threads(worker_fn worker, void *arg, int nthreads)
+{
+  pthread_t *threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+  thread_start *starts = (thread_start*) malloc(nthreads * sizeof(thread_start));
+  int i;
+  for (i = 1; i < nthreads; i++) {
+    starts[i].worker = worker;
+    starts[i].arg = arg;
+    starts[i].tid = i;
+    pthread_create(&threads[i], NULL, thread_main, &starts[i]);
+  }
+  worker(arg, 0);
+  for (i = 1; i < nthreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(starts);
+  free(threads);
+}
+
+/* Parallel Karp-Sipser */
+
+typedef struct {
+  int *col_ptrs, *col_ids, *row_ptrs, *row_ids, *match, *row_match;
+  int n, m, nthreads;
+  int *deg;          /* number of free columns of a free row */
+  int *visited_col;  /* 1 if the column is matched or claimed */
+  int *visited_row;  /* 1 if the row is matched or claimed */
+  barrier_t barrier;
+} sk_par_data;
+
+static void sk_cheap_par_worker(void *arg, int tid)
+{
+  sk_par_data *d = (sk_par_data*) arg;
+  int i, j, start, end;
+
+  chunk(d->n, tid, d->nthreads, &start, &end);
+  for (i = start; i < end; i++) {
+    d->visited_col[i] = (d->match[i] != -1);
+  }
+  chunk(d->m, tid, d->nthreads, &start, &end);
+  for (i = start; i < end; i++) {
+    int deg = 0;
+    if (d->row_match[i] == -1) {
+      for (j = d->row_ptrs[i]; j < d->row_ptrs[i+1]; j++) {
+        if (d->match[d->row_ids[j]] == -1) deg++;
+      }
+    }
+    d->deg[i] = deg;
+    d->visited_row[i] = (d->row_match[i] != -1);
+  }
+  barrier_wait(&d->barrier);
+
+  /* Match rows with a single free column and follow the chains of rows that
+   * are left with a single free column */
+  for (i = start; i < end; i++) {
+    int row = i;
+    if (load_int(&d->deg[i]) != 1) continue;
+    while (row != -1) {
+      int col = -1, next = -1;
+      if (!cas_int(&d->visited_row[row], 0, 1)) break;
+      for (j = d->row_ptrs[row]; j < d->row_ptrs[row+1]; j++) {
+        if (cas_int(&d->visited_col[d->row_ids[j]], 0, 1)) {
+          col = d->row_ids[j];
+          break;
+        }
+      }
+      if (col == -1) {
+        /* nothing left to match; give the row back to the greedy pass */
+        __atomic_store_n(&d->visited_row[row], 0, __ATOMIC_RELAXED);
+        break;
+      }
+      d->match[col] = row;
+      d->row_match[row] = col;
+      for (j = d->col_ptrs[col]; j < d->col_ptrs[col+1]; j++) {
+        int r = d->col_ids[j];
+        if (r != row && __atomic_sub_fetch(&d->deg[r], 1, __ATOMIC_ACQ_REL) == 1 && next == -1 && !load_int(&d->visited_row[r])) {
+          next = r;
+        }
+      }
+      row = next;
+    }
+  }
+  barrier_wait(&d->barrier);
+
+  /* Greedy for the remaining columns */
+  chunk(d->n, tid, d->nthreads, &start, &end);
+  for (i = start; i < end; i++) {
+    if (load_int(&d->visited_col[i])) continue;
+    for (j = d->col_ptrs[i]; j < d->col_ptrs[i+1]; j++) {
+      int r = d->col_ids[j];
+      if (cas_int(&d->visited_row[r], 0, 1)) {
+        d->visited_col[i] = 1;
+        d->match[i] = r;
+        d->row_match[r] = i;
+        break;
+      }
+    }
+  }
+}
+
+void sk_cheap_par(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m)
+{
+  sk_par_data d;
+  d.col_ptrs = col_ptrs;
+  d.col_ids = col_ids;
+  d.row_ptrs = row_ptrs;
+  d.row_ids = row_ids;
+  d.match = match;
+  d.row_match = row_match;
+  d.n = n;
+  d.m = m;
+  d.nthreads = num_threads_for(n > m ? n : m);
+  d.deg = (int*) malloc(m * sizeof(int));
+  d.visited_row = (int*) malloc(m * sizeof(int));
+  d.visited_col = (int*) malloc(n * sizeof(int));
+  barrier_init(&d.barrier, d.nthreads);
+
+  run_threads(sk_cheap_par_worker, &d, d.nthreads);
+
+  barrier_destroy(&d.barrier);
+  free(d.visited_col);
+  free(d.visited_row);
+  free(d.deg);
+}
+
+/* Multi-source parallel BFS */
+
+typedef struct {
+  int *items;
+  int size;
+  int capacity;
+} int_buffer;
+
+static inline void buffer_push(int_buffer *b, int item)
+{
+  if (b->size == b->capacity) {
+    b->capacity = b->capacity ? 2*b->capacity : 1024;
+    b->items = (int*) realloc(b->items, b->capacity * sizeof(int));
+  }
+  b->items[b->size++] = item;
+}
+
+typedef struct {
+  int *col_ptrs, *col_ids, *match, *row_match;
+  int n, m, nthreads;
+  int phase;         /* current phase, the value of visited for rows reached in it */
+  int done;
+  int augmented;
+  int *visited;      /* row -> last phase it was reached in */
+  int *parent;       /* row -> column it was reached from */
+  int *root;         /* column -> free column at the root of its tree */
+  int *leaf;         /* free column -> free row found by its tree, or -1 */
+  int *roots;        /* free columns at the start of the phase */
+  int nroots;
+  int *frontier;
+  int frontier_size;
+  int_buffer *next;  /* per thread part of the next frontier */
+  barrier_t barrier;
+} ms_bfs_data;
+
+static void ms_bfs_par_worker(void *arg, int tid)
+{
+  ms_bfs_data *d = (ms_bfs_data*) arg;
+  int i, j, start, end;
+
+  while (1) {
+    if (tid == 0) {
+      d->nroots = 0;
+      for (i = 0; i < d->n; i++) {
+        if (d->match[i] == -1 && d->col_ptrs[i] < d->col_ptrs[i+1]) {
+          d->roots[d->nroots++] = i;
+          d->root[i] = i;
+          d->leaf[i] = -1;
+        }
+      }
+      memcpy(d->frontier, d->roots, d->nroots * sizeof(int));
+      d->frontier_size = d->nroots;
+      d->phase++;
+      d->augmented = 0;
+      d->done = (d->nroots == 0);
+    }
+    barrier_wait(&d->barrier);
+    if (d->done) break;
+
+    /* Grow the trees one level at a time */
+    while (1) {
+      int_buffer *next = &d->next[tid];
+      chunk(d->frontier_size, tid, d->nthreads, &start, &end);
+      for (i = start; i < end; i++) {
+        int col = d->frontier[i];
+        int r0 = d->root[col];
+        if (load_int(&d->leaf[r0]) != -1) continue;
+        for (j = d->col_ptrs[col]; j < d->col_ptrs[col+1]; j++) {
+          int row = d->col_ids[j];
+          int v = load_int(&d->visited[row]);
+          if (v == d->phase || !cas_int(&d->visited[row], v, d->phase)) continue;
+          d->parent[row] = col;
+          if (d->row_match[row] == -1) {
+            cas_int(&d->leaf[r0], -1, row);
+            break;
+          }
+          d->root[d->row_match[row]] = r0;
+          buffer_push(next, d->row_match[row]);
+        }
+      }
+      barrier_wait(&d->barrier);
+      if (tid == 0) {
+        d->frontier_size = 0;
+        for (i = 0; i < d->nthreads; i++) {
+          memcpy(d->frontier + d->frontier_size, d->next[i].items, d->next[i].size * sizeof(int));
+          d->frontier_size += d->next[i].size;
+          d->next[i].size = 0;
+        }
+      }
+      barrier_wait(&d->barrier);
+      if (d->frontier_size == 0) break;
+    }
+
+    /* The trees are vertex-disjoint, so all paths can be flipped at once */
+    chunk(d->nroots, tid, d->nthreads, &start, &end);
+    for (i = start; i < end; i++) {
+      int r0 = d->roots[i];
+      int row = d->leaf[r0];
+      if (row == -1) continue;
+      while (1) {
+        int col = d->parent[row];
+        int next_row = d->match[col];
+        d->match[col] = row;
+        d->row_match[row] = col;
+        if (col == r0) break;
+        row = next_row;
+      }
+      __atomic_store_n(&d->augmented, 1, __ATOMIC_RELAXED);
+    }
+    barrier_wait(&d->barrier);
+    if (!d->augmented) break;
+    barrier_wait(&d->barrier);
+  }
+}
+
+void match_ms_bfs_par(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m)
+{
+  ms_bfs_data d;
+  int i;
+  d.col_ptrs = col_ptrs;
+  d.col_ids = col_ids;
+  d.match = match;
+  d.row_match = row_match;
+  d.n = n;
+  d.m = m;
+  d.nthreads = num_threads_for(n);
+  d.phase = 0;
+  d.visited = (int*) calloc(m > 0 ? m : 1, sizeof(int));
+  d.parent = (int*) malloc((m > 0 ? m : 1) * sizeof(int));
+  d.root = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+  d.leaf = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+  d.roots = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+  d.frontier = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+  d.next = (int_buffer*) calloc(d.nthreads, sizeof(int_buffer));
+  barrier_init(&d.barrier, d.nthreads);
+
+  run_threads(ms_bfs_par_worker, &d, d.nthreads);
+
+  barrier_destroy(&d.barrier);
+  for (i = 0; i < d.nthreads; i++) {
+    free(d.next[i].items);
+  }
+  free(d.next);
+  free(d.frontier);
+  free(d.roots);
+  free(d.leaf);
+  free(d.root);
+  free(d.parent);
+  free(d.visited);
+}
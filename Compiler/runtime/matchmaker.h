@@ -24,6 +24,7 @@
 #define do_sk_cheap 2
 #define do_sk_cheap_rand 3
 #define do_mind_cheap 4
+#define do_sk_cheap_par 5
 
 #define do_dfs 1
 #define do_bfs 2
@@ -35,11 +36,13 @@
 #define do_abmp 8
 #define do_abmp_bfs 9
 #define do_pr_fifo_fair 10
+#define do_ms_bfs_par 11
 
 void old_cheap(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m);
 void sk_cheap(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void sk_cheap_rand(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void mind_cheap(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
+void sk_cheap_par(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 
 void match_dfs(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m);
 void match_bfs(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m);
@@ -51,9 +54,14 @@ void match_hk_dw(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int*
 void match_abmp(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void match_abmp_bfs(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void match_pr_fifo_fair(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m, double relabel_period);
+void match_ms_bfs_par(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m);
 
 void pr_global_relabel(int* l_label, int* r_label, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 
+/* Number of threads of sk_cheap_par and match_ms_bfs_par; 0 means one per processor */
+void matching_set_num_threads(int num_threads);
+int matching_get_num_threads(void);
+
 void cheap_matching(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m, int cheap_id);
 
 void cheapmatching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int cheap_id, int clear_match);
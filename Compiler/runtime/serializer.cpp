@@ -1,13 +1,30 @@
 
 
-#include <stack>
-//#include <unordered_map>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
 #include <fstream>
 #include "meta_modelica.h"
 #include <stdint.h>
+#include <pthread.h>
+#include "serializer.h"
+#include "rtclock.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 extern "C"
 {
@@ -16,6 +33,8 @@ extern "C"
 /* This is used to keep track of generated record_description,
    that way we don't generate new every time something is de-serialized */
 std::map<std::string,record_description*> record_cache;
+/* Cached files may be de-serialized from several parser threads at once */
+static pthread_mutex_t record_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
 static const uint8_t TAG_INT_TINY     = 0x00;
@@ -33,70 +52,199 @@ static const uint8_t TAG_SHARED_BIG   = 0xA0;
 
 /*  SERIALIZATION */
 
+static const uint64_t CHECKSUM_INIT = 14695981039346656037ULL;
+
+/* FNV-1a checksum of data, continued from h */
+static uint64_t cacheChecksum(const unsigned char* data,size_t len,uint64_t h){
+    for(size_t i=0; i<len; i++){
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Output buffer that collects the serialized data in fixed size chunks.
+   Full chunks are either written to a file with fwrite or appended to a string,
+   so serializing large objects never reallocates or copies the whole output. */
+class OutBuffer {
+public:
+    OutBuffer(FILE* file) : chunk(new unsigned char[CHUNK_SIZE]), pos(0), file(file), str(NULL), failed(false), written(0), checksum(CHECKSUM_INIT) {}
+    OutBuffer(std::string& str) : chunk(new unsigned char[CHUNK_SIZE]), pos(0), file(NULL), str(&str), failed(false), written(0), checksum(CHECKSUM_INIT) {}
+    ~OutBuffer(){
+        flush();
+        delete[] chunk;
+    }
+    inline void put(uint8_t v){
+        if(pos==CHUNK_SIZE){
+            flush();
+        }
+        chunk[pos++] = v;
+    }
+    void putBytes(const char* data,size_t size){
+        while(size>0){
+            if(pos==CHUNK_SIZE){
+                flush();
+            }
+            size_t n = std::min(size,CHUNK_SIZE-pos);
+            memcpy(chunk+pos,data,n);
+            pos  += n;
+            data += n;
+            size -= n;
+        }
+    }
+    void flush(){
+        checksum = cacheChecksum(chunk,pos,checksum);
+        written += pos;
+        if(file){
+            failed = failed || fwrite(chunk,1,pos,file)!=pos;
+        } else {
+            str->append((const char*)chunk,pos);
+        }
+        pos = 0;
+    }
+    /* Flushes the buffer and returns false if any write failed */
+    bool ok(){
+        flush();
+        return !failed;
+    }
+    /* Number of bytes and checksum of everything flushed so far */
+    uint64_t bytesWritten() const {
+        return written;
+    }
+    uint64_t dataChecksum() const {
+        return checksum;
+    }
+private:
+    static const size_t CHUNK_SIZE = 1024*1024;
+    unsigned char* chunk;
+    size_t pos;
+    FILE* file;
+    std::string* str;
+    bool failed;
+    uint64_t written;
+    uint64_t checksum;
+};
+
+/* Open addressing (linear probing) hash table from object address to the
+   index the object got in the serialized stream. */
+class PointerTable {
+public:
+    PointerTable() : keys(INITIAL_SIZE,(void*)NULL), values(INITIAL_SIZE), mask(INITIAL_SIZE-1), count(0) {}
+    uint64_t size() const {
+        return count;
+    }
+    /* Inserts ptr with the next free index. Returns false and sets index to
+       the previous index if ptr was already in the table. */
+    bool insert(void* ptr,uint64_t &index){
+        size_t i = hash(ptr) & mask;
+        while(keys[i]){
+            if(keys[i]==ptr){
+                index = values[i];
+                return false;
+            }
+            i = (i+1) & mask;
+        }
+        keys[i]   = ptr;
+        values[i] = index = count++;
+        if(2*count > mask){
+            grow();
+        }
+        return true;
+    }
+private:
+    static const size_t INITIAL_SIZE = 4096;
+    std::vector<void*> keys;
+    std::vector<uint64_t> values;
+    size_t mask;
+    uint64_t count;
+
+    static inline size_t hash(void* ptr){
+        uint64_t h = (uint64_t)(uintptr_t)ptr;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+    void grow(){
+        std::vector<void*> oldKeys(2*keys.size(),(void*)NULL);
+        std::vector<uint64_t> oldValues(2*values.size());
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        mask = keys.size()-1;
+        for(size_t j=0; j<oldKeys.size(); j++){
+            if(oldKeys[j]){
+                size_t i = hash(oldKeys[j]) & mask;
+                while(keys[i]){
+                    i = (i+1) & mask;
+                }
+                keys[i]   = oldKeys[j];
+                values[i] = oldValues[j];
+            }
+        }
+    }
+};
+
 /* Writes 8 bits to the buffer */
-void write8(uint8_t v0,std::string& buffer){
-    buffer.push_back(v0);
-    //printf("%02X ",v0);
+static inline void write8(uint8_t v0,OutBuffer& buffer){
+    buffer.put(v0);
 }
 
 /* Writes 16 bits to the buffer */
-void write16(uint16_t v0,std::string& buffer){
-    uint8_t h = (v0 & 0xFF00)>>8;
-    uint8_t l = v0 & 0xFF;
-    buffer.push_back(h);
-    buffer.push_back(l);
-    //printf("%02X ",h);
-    //printf("%02X ",l);
+static inline void write16(uint16_t v0,OutBuffer& buffer){
+    buffer.put((v0 & 0xFF00)>>8);
+    buffer.put(v0 & 0xFF);
 }
 
 /* Writes 32 bits to the buffer */
-void write32(uint32_t v0,std::string& buffer){
+static inline void write32(uint32_t v0,OutBuffer& buffer){
     write16((v0>>16) & 0xFFFF,buffer);
     write16(v0       & 0xFFFF,buffer);
 }
 
 /* Writes 64 bits to the buffer */
-void write64(uint64_t v0,std::string& buffer){
+static inline void write64(uint64_t v0,OutBuffer& buffer){
     write32((v0>>32) & 0xFFFFFFFF,buffer);
     write32(v0       & 0xFFFFFFFF,buffer);
 }
 
 /* Writes a tag value */
-void writeTag(uint8_t v0,std::string& buffer){
+static inline void writeTag(uint8_t v0,OutBuffer& buffer){
     write8(v0,buffer);
 }
 
 /* Writes an integer considering the required size */
-void writeInt(mmc_sint_t value,std::string& buffer){
+static void writeInt(mmc_sint_t value,OutBuffer& buffer){
     if(value >= -8 && value <= 7){ // tiny integer
         writeTag(TAG_INT_TINY | (0x0F & value),buffer);
     }
-    else if(value >= -2147483648 && value <= 2147483647) // regular 32 signed int
+    else if(value >= -2147483648LL && value <= 2147483647LL) // regular 32 signed int
     {
         int32_t cropped = value;
-        uint32_t* pv    = (uint32_t*)&cropped;
+        uint32_t uvalue;
+        memcpy(&uvalue,&cropped,sizeof(uvalue));
         writeTag(TAG_INT_SMALL,buffer);
-        write32(*pv,buffer);
+        write32(uvalue,buffer);
     }
     else
     {
         int64_t cropped = value;
-        uint64_t* pv    = (uint64_t*)&cropped;
+        uint64_t uvalue;
+        memcpy(&uvalue,&cropped,sizeof(uvalue));
         writeTag(TAG_INT_BIG,buffer);
-        write64(*pv,buffer);
+        write64(uvalue,buffer);
     }
-
 }
 
 /* Writes an real value always as 64 bits */
-void writeReal(double value,std::string& buffer){
-    writeTag(TAG_DOUBLE,buffer);    // double -> 3
-    unsigned long long* ivalue = (unsigned long long*) &value;
-    write64(*ivalue,buffer);
+static void writeReal(double value,OutBuffer& buffer){
+    uint64_t ivalue;
+    memcpy(&ivalue,&value,sizeof(ivalue));
+    writeTag(TAG_DOUBLE,buffer);
+    write64(ivalue,buffer);
 }
 
 /* Writes a string considering the required size */
-void writeString(mmc_uint_t size,const char* data,std::string& buffer){
+static void writeString(mmc_uint_t size,const char* data,OutBuffer& buffer){
     if(size<256){
         writeTag(TAG_STRING_SMALL,buffer);
         write8(size,buffer);
@@ -105,14 +253,10 @@ void writeString(mmc_uint_t size,const char* data,std::string& buffer){
         writeTag(TAG_STRING_BIG,buffer);
         write64(size,buffer);
     }
-    mmc_uint_t i = 0;
-    while(i<size){
-        write8(data[i],buffer);
-        i++;
-    }
+    buffer.putBytes(data,size);
 }
 
-void writeStruct(mmc_uint_t size,mmc_uint_t ctor,std::string& buffer){
+static void writeStruct(mmc_uint_t size,mmc_uint_t ctor,OutBuffer& buffer){
     if(size<16){
         writeTag(TAG_STRUCT_SMALL|(size&0x0F),buffer);
     }
@@ -123,8 +267,7 @@ void writeStruct(mmc_uint_t size,mmc_uint_t ctor,std::string& buffer){
     write8(ctor,buffer);
 }
 
-void writeShared(mmc_uint_t index,std::string& buffer){
-    //printf("shared(%i) -> ",index);
+static void writeShared(uint64_t index,OutBuffer& buffer){
     if(index<=0xFFFF){
         writeTag(TAG_SHARED_TINY,buffer);
         write16(index,buffer);
@@ -139,88 +282,61 @@ void writeShared(mmc_uint_t index,std::string& buffer){
         writeTag(TAG_SHARED_BIG,buffer);
         write64(index,buffer);
     }
-    //printf("\n");
 }
 
 /* Tries to insert the object to the seen-object list. If it has been found before it writes a shared object instead.
    Returns true if the object is new, false if it's shared */
-bool isNewObject(void* ptr,std::string& buffer, std::map<void*,uint64_t> &objcache){
-    std::pair<std::map<void*,uint64_t>::iterator,bool> ret;
-    ret = objcache.insert(std::pair<void*,uint64_t>(ptr,objcache.size()));
-    if(ret.second==false){
-        writeShared(ret.first->second,buffer);
+static inline bool isNewObject(void* ptr,OutBuffer& buffer,PointerTable &objcache){
+    uint64_t index;
+    if(!objcache.insert(ptr,index)){
+        writeShared(index,buffer);
         return false;
     }
-    //printf("%i:",objcache.size()-1);
     return true;
 }
 
 /* Record descriptions are serialized as [path,name,[field1,...,fieldn]] */
-void writeRecordDescription(struct record_description* desc,mmc_uint_t slots,std::string& buffer,std::map<void*,uint64_t> &objcache){
-    mmc_uint_t size = 0;
-    //printf("ctor(%i,%i) -> ", 3,255);
+static void writeRecordDescription(struct record_description* desc,mmc_uint_t slots,OutBuffer& buffer,PointerTable &objcache){
     writeStruct(3,255,buffer); // Serializes the objec as an array.
-    //printf("\n");
 
     // Here's a hack that adds 1 to the pointer (&desc->path+1) since &desc == &desc->path
-    bool new_path = isNewObject((void*)((char*)(&desc->path)+1),buffer,objcache);
-    if(new_path){
-        size = strlen(desc->path);
-        //printf("%s ->", desc->path);
-        writeString(size,desc->path,buffer);
-        //printf("\n");
-    }
-    bool new_name = isNewObject((void*)(&desc->name),buffer,objcache);
-    if(new_name){
-        size = strlen(desc->name);
-        //printf("%s ->", desc->name);
-        writeString(size,desc->name,buffer);
-        //printf("\n");
-    }
-
-    bool new_fields = isNewObject((void*)(&desc->fieldNames),buffer,objcache);
-    if(new_fields){
-        //printf("ctor(%i,%i) -> ", slots-1,255);
+    if(isNewObject((void*)((char*)(&desc->path)+1),buffer,objcache)){
+        writeString(strlen(desc->path),desc->path,buffer);
+    }
+    if(isNewObject((void*)(&desc->name),buffer,objcache)){
+        writeString(strlen(desc->name),desc->name,buffer);
+    }
+    if(isNewObject((void*)(&desc->fieldNames),buffer,objcache)){
         writeStruct(slots-1,255,buffer);
-        //printf("\n");
         for(mmc_uint_t i = 0; i<slots-1; i++){
-            bool new_field = isNewObject((void*)(&desc->fieldNames[i]),buffer,objcache);
-            size = strlen(desc->fieldNames[i]);
-            //printf("%s -> ", desc->fieldNames[i]);
-            writeString(size,desc->fieldNames[i],buffer);
-            //printf("\n");
+            isNewObject((void*)(&desc->fieldNames[i]),buffer,objcache);
+            writeString(strlen(desc->fieldNames[i]),desc->fieldNames[i],buffer);
         }
     }
 }
 
-void serialize(modelica_metatype input_object,std::string& buffer){
+static void serializeTo(modelica_metatype input_object,OutBuffer& buffer){
 
-    std::stack<modelica_metatype> objstack;
-    std::map<void*,uint64_t> objcache;
-    buffer.reserve(1024*1024);
+    std::vector<modelica_metatype> objstack;
+    PointerTable objcache;
     //Inserts the object to the stack
-    objstack.push(input_object);
+    objstack.reserve(1024);
+    objstack.push_back(input_object);
 
     while(!objstack.empty()){
         // Takes the next object in the stack
-        modelica_metatype object = objstack.top();
-        objstack.pop();
+        modelica_metatype object = objstack.back();
+        objstack.pop_back();
 
         /* Integer */
         if(MMC_IS_IMMEDIATE(object)){
-            mmc_sint_t value = MMC_UNTAGFIXNUM(object);
-            //printf("%i -> ",value);
-            writeInt(value,buffer);
-            //printf("\n");
+            writeInt(MMC_UNTAGFIXNUM(object),buffer);
             continue;
         }
         mmc_uint_t hdr = MMC_GETHDR(object);
         /* Real */
         if(hdr==MMC_REALHDR){
-            double value = mmc_unbox_real(object);
-            //printf("%f -> ",value);
-            writeReal(value,buffer);
-            //printf("\n");
+            writeReal(mmc_unbox_real(object),buffer);
             continue;
         }
 
@@ -229,19 +345,15 @@ void serialize(modelica_metatype input_object,std::string& buffer){
         /* any other value */
         if(isNewObject(ptr,buffer,objcache)){ // the element was not in the map
             if(MMC_HDRISSTRING(hdr)){
-                //printf("%s -> ",MMC_STRINGDATA(object));
                 writeString(MMC_HDRSTRLEN(hdr),MMC_STRINGDATA(object),buffer);
-                //printf("\n");
             }
             else if(MMC_HDRISSTRUCT(hdr)){
                 mmc_uint_t slots = MMC_HDRSLOTS(hdr);
                 mmc_uint_t ctor  = MMC_HDRCTOR(hdr);
-                int count        = slots;
-                int left         = 0;
+                mmc_uint_t count = slots;
+                mmc_uint_t left  = 0;
 
-                //printf("ctor(%i,%i) -> ", slots,ctor);
                 writeStruct(slots,ctor,buffer);
-                //printf("\n");
                 if(ctor>=3 && ctor!=255){ // It's a meta record
                     struct record_description* desc = (struct record_description*) MMC_FETCH(MMC_OFFSET(ptr,1));
                     if(isNewObject((void*)desc,buffer,objcache)){ // it's a new record
@@ -251,58 +363,121 @@ void serialize(modelica_metatype input_object,std::string& buffer){
                 }
                 // Push the sub-objects to the stack
                 while(count>left){
-                    objstack.push(MMC_FETCH(MMC_OFFSET(ptr, count)));
+                    objstack.push_back(MMC_FETCH(MMC_OFFSET(ptr, count)));
                     count--;
                 }
             }
         }
     }
     write64(objcache.size(),buffer);
-    //printf("\nserialized %i objects\n",objcache.size());
 }
 
+void serialize(modelica_metatype input_object,std::string& str){
+    OutBuffer buffer(str);
+    serializeTo(input_object,buffer);
+}
 
-/*  DE-SERIALIZATION */
-
-
-void readFile(char* filename,std::string& buffer){
-    std::ifstream input_file(filename,std::ifstream::in | std::ifstream::binary);
-
-    input_file.seekg(0, std::ios::end);
-    buffer.reserve(input_file.tellg());
-    input_file.seekg(0, std::ios::beg);
 
-    buffer.assign((std::istreambuf_iterator<char>(input_file)),
-                std::istreambuf_iterator<char>());
-}
+/*  DE-SERIALIZATION */
 
 /* Reads 16 bits from the buffer and moves the index forward */
-uint16_t read16(mmc_uint_t &index,unsigned char* data){
+static inline uint16_t read16(mmc_uint_t &index,const unsigned char* data){
     uint16_t value = (uint16_t)data[index]<<8 | data[index+1];
     index+=2;
     return value;
 }
 
 /* Reads 32 bits from the buffer and moves the index forward */
-uint32_t read32(mmc_uint_t &index,unsigned char* data){
+static inline uint32_t read32(mmc_uint_t &index,const unsigned char* data){
     uint32_t value = (uint32_t)data[index]<<24 | (uint32_t)data[index+1]<<16 | (uint32_t)data[index+2]<<8 | (uint32_t)data[index+3];
     index+=4;
     return value;
 }
 
-/* Reads 32 bits from the buffer and moves the index forward */
-uint64_t read64(mmc_uint_t &index,unsigned char* data){
-    uint64_t value =
-            (uint64_t)data[index]<<56 | (uint64_t)data[index+1]<<48 | (uint64_t)data[index+2]<<32 | (uint64_t)data[index+3] | (uint64_t)data[index+4]<<24 | (uint64_t)data[index+5]<<16 | (uint64_t)data[index+6]<<8 | (uint64_t)data[index+7];
-    index+=8;
-    return value;
+/* Reads 64 bits from the buffer and moves the index forward */
+static inline uint64_t read64(mmc_uint_t &index,const unsigned char* data){
+    uint64_t value = (uint64_t)read32(index,data)<<32;
+    return value | read32(index,data);
 }
 
-modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+/* Allocates the de-serialized objects. Small structures are taken from per
+   size class free lists filled with GC_malloc_many, which amortizes the
+   allocator overhead over many objects of the same size. */
+class ObjectAllocator {
+public:
+    ObjectAllocator(){
+        memset(freeLists,0,sizeof(freeLists));
+    }
+    inline void* allocWords(mmc_uint_t words){
+        if(words>MAX_POOLED_WORDS){
+            return mmc_alloc_words(words);
+        }
+        void* p = freeLists[words];
+        if(p==NULL){
+            p = GC_malloc_many(words*sizeof(void*));
+            if(p==NULL){
+                return mmc_alloc_words(words);
+            }
+        }
+        freeLists[words] = GC_NEXT(p);
+        GC_NEXT(p) = NULL;
+        return p;
+    }
+    inline modelica_metatype allocStruct(mmc_uint_t size,mmc_uint_t ctor){
+        struct mmc_struct *p = (struct mmc_struct*) allocWords(size+1);
+        p->header = MMC_STRUCTHDR(size,ctor);
+        return MMC_TAGPTR(p);
+    }
+    inline void* allocAtomicWords(mmc_uint_t words){
+        return mmc_alloc_words_atomic(words);
+    }
+private:
+    static const mmc_uint_t MAX_POOLED_WORDS = 16;
+    /* Heads of the free lists live on the stack of the de-serializer, so the
+       collector sees them as roots until the objects are used */
+    void* freeLists[MAX_POOLED_WORDS+1];
+};
+
+/* True if n bytes can be read at index without passing end */
+static inline bool canRead(mmc_uint_t index,mmc_uint_t end,uint64_t n){
+    return index <= end && n <= end-index;
+}
+
+/* Number of bytes of an item with the given tag up to its string data or
+   fields: the tag byte and the fixed size payload */
+static inline mmc_uint_t itemHeaderSize(uint8_t tag){
+    switch(tag){
+        case TAG_INT_TINY:     return 1;
+        case TAG_INT_SMALL:    return 1+4;
+        case TAG_INT_BIG:      return 1+8;
+        case TAG_DOUBLE:       return 1+8;
+        case TAG_STRING_SMALL: return 1+1;
+        case TAG_STRING_BIG:   return 1+8;
+        case TAG_STRUCT_SMALL: return 1+1;
+        case TAG_STRUCT_BIG:   return 1+8+1;
+        case TAG_SHARED_TINY:  return 1+2;
+        case TAG_SHARED_SMALL: return 1+4;
+        case TAG_SHARED_BIG:   return 1+8;
+        default:               return 1;
+    }
+}
+
+/* True if the item at index has one of the tags and its header is inside the buffer */
+static inline bool nextItemIs(uint8_t tag1,uint8_t tag2,mmc_uint_t index,const unsigned char* data,mmc_uint_t end){
+    if(index>=end){
+        return false;
+    }
+    uint8_t tag = data[index]&0xF0;
+    return (tag==tag1 || tag==tag2) && canRead(index,end,itemHeaderSize(tag));
+}
+
+static modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,const unsigned char* data){
     uint8_t uvalue8;
     int8_t  value8;
     int32_t value32;
     int64_t value64;
+    uint32_t u32;
+    uint64_t u64;
     switch(tag){
         case TAG_INT_TINY:
             uvalue8 = data[index]&0x0F;
@@ -311,116 +486,83 @@ modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,unsigned char* data)
             else
                 value8 = uvalue8;
             index=index+1;
-            //printf("%i\n", value8);
             return mmc_mk_integer(value8);
         case TAG_INT_SMALL:
             index++;
-            value32 = read32(index,data);
-            //printf("%i\n", value32);
+            u32 = read32(index,data);
+            memcpy(&value32,&u32,sizeof(u32));
             return mmc_mk_integer(value32);
         case TAG_INT_BIG:
             index++;
-            value64 = read64(index,data);
-            //printf("%i\n", value64);
+            u64 = read64(index,data);
+            memcpy(&value64,&u64,sizeof(u64));
             return mmc_mk_integer(value64);
         default: return mmc_mk_integer(0);
     }
 }
 
-
-modelica_metatype readReal(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+static modelica_metatype readReal(mmc_uint_t &index,const unsigned char* data,ObjectAllocator &alloc){
     index++;
     uint64_t ivalue = read64(index,data);
-    double* fvalue = (double*)(&ivalue);
-    //printf("%f\n", *fvalue);
-    return mmc_mk_real(*fvalue);
+    struct mmc_real *p = (struct mmc_real*) alloc.allocAtomicWords(MMC_SIZE_DBL/MMC_SIZE_INT+1);
+    p->header = MMC_REALHDR;
+    memcpy(p->data,&ivalue,sizeof(double));
+    return MMC_TAGPTR(p);
 }
 
-
-modelica_metatype readString(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+/* Reads the size of a string and moves the index to its first character */
+static inline uint64_t readStringSize(uint8_t tag,mmc_uint_t &index,const unsigned char* data){
     uint64_t size = 0;
-    switch(tag){
-        case TAG_STRING_SMALL:
-            index++;
-            size = data[index];
-            index++;
-            break;
-        case TAG_STRING_BIG:
-            index++;
-            size = read64(index,data);
-            break;
-        default: break;
+    index++;
+    if(tag==TAG_STRING_SMALL){
+        size = data[index];
+        index++;
+    } else {
+        size = read64(index,data);
     }
+    return size;
+}
 
-    modelica_metatype res = mmc_mk_scon_len(size+1);
-    const char* str = (const char*)&(data[index]);
+static modelica_metatype readString(uint8_t tag,mmc_uint_t &index,const unsigned char* data,mmc_uint_t end,ObjectAllocator &alloc){
+    uint64_t size = readStringSize(tag,index,data);
+    if(size > end-index){
+        return NULL;
+    }
+    mmc_uint_t header = MMC_STRINGHDR(size);
+    struct mmc_string *p = (struct mmc_string*) alloc.allocAtomicWords(MMC_HDRSLOTS(header)+1);
+    p->header = header;
+    memcpy(p->data,&data[index],size);
+    p->data[size] = 0;
     index += size;
-
-    // debug prints
-    //for(int i = 0;i<size;i++){
-    //    putchar(str[i]);
-    //}
-    //printf("\n");
-    memcpy(MMC_STRINGDATA(res), str, size);
-    MMC_STRINGDATA(res)[size]=0;
-    return res;
+    return MMC_TAGPTR(p);
 }
 
-char* readString_raw(uint8_t tag,mmc_uint_t &index,unsigned char* data){
-    uint64_t size = 0;
-    switch(tag){
-        case TAG_STRING_SMALL:
-            index++;
-            size = data[index];
-            index++;
-            break;
-        case TAG_STRING_BIG:
-            index++;
-            size = read64(index,data);
-            break;
-        default: break;
+/* Returns NULL if the string does not fit into the buffer */
+static char* readString_raw(uint8_t tag,mmc_uint_t &index,const unsigned char* data,mmc_uint_t end){
+    uint64_t size = readStringSize(tag,index,data);
+    if(size > end-index){
+        return NULL;
     }
-
     char* res = new char[size+1];
-    const char* str = (const char*)&(data[index]);
-    index += size;
-
-    //for(int i = 0;i<size;i++){
-    //    putchar(str[i]);
-    //}
-    //printf("\n");
-    memcpy(res, str, size);
+    memcpy(res,&data[index],size);
     res[size]=0;
+    index += size;
     return res;
 }
 
-modelica_metatype readShared(uint8_t tag,mmc_uint_t &index,unsigned char* data,std::vector<modelica_metatype> &shared){
-    uint64_t i64;
-    uint16_t i16;
-    uint32_t i32;
+static modelica_metatype readShared(uint8_t tag,mmc_uint_t &index,const unsigned char* data,std::vector<modelica_metatype> &shared){
+    uint64_t i = 0;
     index++;
     switch(tag){
-        case TAG_SHARED_TINY:
-            i16 = read16(index,data);
-            //printf("shared(%i)\n",i16);
-            return shared[i16];
-            break;
-        case TAG_SHARED_SMALL:
-            i32 = read32(index,data);
-            //printf("shared(%i)\n",i32);
-            return shared[i32];
-            break;
-        case TAG_SHARED_BIG:
-            i64 = read64(index,data);
-            //printf("shared(%i)\n",i64);
-            return shared[i64];
-            break;
+        case TAG_SHARED_TINY:  i = read16(index,data); break;
+        case TAG_SHARED_SMALL: i = read32(index,data); break;
+        case TAG_SHARED_BIG:   i = read64(index,data); break;
         default: break;
     }
-    return 0;
+    return i < shared.size() ? shared[i] : NULL;
 }
 
-void readStruct(uint8_t tag, mmc_uint_t &index, uint8_t* data, mmc_uint_t &size, mmc_uint_t &ctor){
+static void readStruct(uint8_t tag, mmc_uint_t &index, const unsigned char* data, mmc_uint_t &size, mmc_uint_t &ctor){
     switch(tag){
         case TAG_STRUCT_SMALL:
             size = data[index] & 0x0F;
@@ -436,158 +578,215 @@ void readStruct(uint8_t tag, mmc_uint_t &index, uint8_t* data, mmc_uint_t &size,
     index++;
 }
 
-modelica_metatype allocValue(mmc_uint_t size,mmc_uint_t ctor){
-  struct mmc_struct *p = (struct mmc_struct *) mmc_alloc_words(size+1);
-  p->header = MMC_STRUCTHDR(size, ctor);
-  return MMC_TAGPTR(p);
-}
-
-void setToNextField(modelica_metatype sub,std::stack<std::pair<modelica_metatype,int> > &stack){
-    std::pair<modelica_metatype,int> next = stack.top();
-    stack.pop();
-    MMC_STRUCTDATA(next.first)[next.second-1]=sub;
+static void deleteStrings(std::vector<char*> &strings){
+    for(size_t i=0;i<strings.size();i++){
+        delete[] strings[i];
+    }
 }
 
-/* This is a special case of the de-serialization to restore the record_descriptions */
-record_description* readRecordDescription(mmc_uint_t &index,unsigned char* data,std::vector<modelica_metatype> &shared){
+/* This is a special case of the de-serialization to restore the record_descriptions.
+   Returns NULL if the description is truncated or malformed. */
+static record_description* readRecordDescription(mmc_uint_t &index,const unsigned char* data,mmc_uint_t end,std::vector<modelica_metatype> &shared){
     mmc_uint_t size,ctor;
-    struct record_description* pdesc;
+    struct record_description* pdesc = NULL;
+    std::vector<char*> strings; // path, name and the field names
+    char* str;
+
+    if(index>=end){
+        return NULL;
+    }
     uint8_t tag = data[index]&0xF0;
     switch(tag){
         case TAG_SHARED_TINY:
         case TAG_SHARED_SMALL:
         case TAG_SHARED_BIG:
+            if(!canRead(index,end,itemHeaderSize(tag))){
+                return NULL;
+            }
             pdesc = (struct record_description*)readShared(tag,index,data,shared);
             break;
 
         case TAG_STRUCT_SMALL:
         case TAG_STRUCT_BIG:
+            if(!canRead(index,end,itemHeaderSize(tag))){
+                return NULL;
+            }
             readStruct(tag,index,data,size,ctor); // skipping since we already know what it is
-            // Read the path
-            char* path = readString_raw(data[index]&0xF0,index,data);
-            // check if we already have a description for this path
-            std::map<std::string,record_description*>::iterator it = record_cache.find(std::string(path));
+            // Read the path and the name
+            for(int i=0;i<2;i++){
+                if(!nextItemIs(TAG_STRING_SMALL,TAG_STRING_BIG,index,data,end) || (str = readString_raw(data[index]&0xF0,index,data,end))==NULL){
+                    deleteStrings(strings);
+                    return NULL;
+                }
+                strings.push_back(str);
+            }
+            // Read the array of field names, every field takes at least 2 bytes
+            if(!nextItemIs(TAG_STRUCT_SMALL,TAG_STRUCT_BIG,index,data,end)){
+                deleteStrings(strings);
+                return NULL;
+            }
+            readStruct(data[index]&0xF0,index,data,size,ctor);
+            if(size > (end-index)/2){
+                deleteStrings(strings);
+                return NULL;
+            }
+            for(mmc_uint_t i=0;i<size;i++){
+                if(!nextItemIs(TAG_STRING_SMALL,TAG_STRING_BIG,index,data,end) || (str = readString_raw(data[index]&0xF0,index,data,end))==NULL){
+                    deleteStrings(strings);
+                    return NULL;
+                }
+                strings.push_back(str);
+            }
 
+            // check if we already have a description for this path
+            pthread_mutex_lock(&record_cache_mutex);
+            std::map<std::string,record_description*>::iterator it = record_cache.find(std::string(strings[0]));
             if(it==record_cache.end()){
-                pdesc = new struct record_description;
-                shared.push_back(pdesc);
-
-                shared.push_back(path);
-                // Read the name
-                char* name = readString_raw(data[index]&0xF0,index,data);
-                shared.push_back(name);
-                // Read the array
-                readStruct(data[index]&0xF0,index,data,size,ctor); // this should be an array
-                shared.push_back(0); // pushes anything since this objects are not reused
                 char** fields = new char*[size];
-                // Now read the fields
-                for(int i=0;i<size;i++){
-                    char* field = readString_raw(data[index]&0xF0,index,data);
-                    shared.push_back(field);
-                    fields[i] = field;
-                }
-                pdesc->path = path;
-                pdesc->name = name;
+                std::copy(strings.begin()+2,strings.end(),fields);
+                pdesc = new struct record_description;
+                pdesc->path = strings[0];
+                pdesc->name = strings[1];
                 pdesc->fieldNames = (const char**) fields;
                 // Insert the record description to the global cache of descriptions
-                record_cache.insert( std::pair<std::string,record_description*>(std::string(path),pdesc));
+                record_cache.insert( std::pair<std::string,record_description*>(std::string(strings[0]),pdesc));
             }
             else {
+                // We already have the description, drop the strings read
                 pdesc = it->second;
-                // Now we read the data but we release the memory since we are not gonna use it
-                // (This part can be optimized)
-                shared.push_back(pdesc);
-                shared.push_back(0);
-                // Read the name
-                char* name = readString_raw(data[index]&0xF0,index,data);
-                shared.push_back(0);
-                // Read the array
-                readStruct(data[index]&0xF0,index,data,size,ctor); // this should be an array
-                shared.push_back(0); // pushes anything since this objects are not reused
-                // Now read the fields
-                for(int i=0;i<size;i++){
-                    char* field = readString_raw(data[index]&0xF0,index,data);
-                    delete[] field;
-                    shared.push_back(0);
-                }
-                delete[] path;
-                delete[] name;
+                deleteStrings(strings);
+                strings.assign(strings.size(),(char*)NULL);
+            }
+            pthread_mutex_unlock(&record_cache_mutex);
+
+            // The shared objects in the order they were written: the
+            // description, path, name, the array and the fields. Only the
+            // description is referenced again.
+            shared.push_back(pdesc);
+            shared.push_back(strings[0]);
+            shared.push_back(strings[1]);
+            shared.push_back(0);
+            for(size_t i=2;i<strings.size();i++){
+                shared.push_back(strings[i]);
             }
             break;
     }
     return pdesc;
 }
 
-modelica_metatype deserialize(std::string& buffer){
-    modelica_metatype  result,current;
-    result = allocValue(1,0);
-    unsigned char* data = (unsigned char*) buffer.c_str();
+/* A structure whose fields are being filled in */
+struct PendingStruct {
+    modelica_metatype object;
+    mmc_uint_t next;
+    mmc_uint_t size;
+};
+
+/* De-serializes size bytes at data in a single forward pass. The data is
+   only read, so it can be a read-only mapping of a file.
+   Returns NULL if the data is truncated or malformed. */
+modelica_metatype deserializeData(const unsigned char* data,mmc_uint_t size){
+    modelica_metatype result,current;
     mmc_uint_t index = 0;
-    mmc_uint_t size=0;
-    mmc_uint_t ctor=0;
+    mmc_uint_t ssize = 0;
+    mmc_uint_t ctor = 0;
+    mmc_uint_t end;
+    uint64_t total;
+    ObjectAllocator alloc;
     std::vector<modelica_metatype> shared;
-    std::stack<std::pair<modelica_metatype,int> > stack;
+    std::vector<PendingStruct> stack;
+    PendingStruct root;
 
-    stack.push(std::make_pair(result,1));
+    if(size<8){
+        return NULL;
+    }
+    // The number of shared objects is stored at the end
+    end = size-8;
+    index = end;
+    total = read64(index,data);
+    index = 0;
+    shared.reserve(total <= size ? total : 0);
+
+    result = alloc.allocStruct(1,0);
+    root.object = result;
+    root.next = 0;
+    root.size = 1;
+    stack.reserve(256);
+    stack.push_back(root);
 
     while(!stack.empty()){
+       if(index>=end){
+           return NULL;
+       }
        unsigned char tag = data[index] & 0xF0;
+       if(!canRead(index,end,itemHeaderSize(tag))){
+           return NULL;
+       }
        switch(tag){ // integer
           case TAG_INT_TINY:
           case TAG_INT_SMALL:
           case TAG_INT_BIG:
             current = readInteger(tag,index,data);
-            setToNextField(current,stack);
             break;
           case TAG_DOUBLE:
-            current = readReal(tag,index,data);
-            setToNextField(current,stack);
+            current = readReal(index,data,alloc);
             break;
           case TAG_STRING_SMALL:
           case TAG_STRING_BIG:
-            current = readString(tag,index,data);
-            setToNextField(current,stack);
+            current = readString(tag,index,data,end,alloc);
+            if(current==NULL){
+                return NULL;
+            }
             shared.push_back(current);
             break;
           case TAG_SHARED_TINY:
           case TAG_SHARED_SMALL:
           case TAG_SHARED_BIG:
             current = readShared(tag,index,data,shared);
-            setToNextField(current,stack);
+            if(current==NULL){
+                return NULL;
+            }
             break;
           case TAG_STRUCT_SMALL:
           case TAG_STRUCT_BIG:
-            size = 0;
+            ssize = 0;
             ctor = 0;
-            readStruct(tag,index,data,size,ctor);
-            //printf("%i:ctor(%i,%i)\n",shared.size(),size,ctor);
-            if(ctor>=3 && ctor!=255){ // not an array
-                current = allocValue(size,ctor);
-                shared.push_back(current);
-                setToNextField(current,stack);
-                while(size>0){
-                    stack.push(std::make_pair(current,size));
-                    size--;
-                }
-                modelica_metatype record_desc = readRecordDescription(index,data,shared);
-                setToNextField(record_desc,stack);
-            }
-            else {
-                current = allocValue(size,ctor);
-                shared.push_back(current);
-                setToNextField(current,stack);
-                while(size>0){
-                    stack.push(std::make_pair(current,size));
-                    size--;
-                }
+            readStruct(tag,index,data,ssize,ctor);
+            if(ssize > end-index){
+                return NULL;
             }
+            current = alloc.allocStruct(ssize,ctor);
+            shared.push_back(current);
             break;
-          default: break;
+          default:
+            return NULL;
+       }
+       // Store the value in the next field of the innermost pending structure
+       MMC_STRUCTDATA(stack.back().object)[stack.back().next++] = current;
+       if((tag==TAG_STRUCT_SMALL || tag==TAG_STRUCT_BIG) && ssize>0){
+           PendingStruct pending;
+           pending.object = current;
+           pending.next = 0;
+           pending.size = ssize;
+           stack.push_back(pending);
+           if(ctor>=3 && ctor!=255){ // a record, the first field is the description
+               stack.back().next = 1;
+               record_description* desc = readRecordDescription(index,data,end,shared);
+               if(desc==NULL){
+                   return NULL;
+               }
+               MMC_STRUCTDATA(current)[0] = desc;
+           }
+       }
+       // Closes the structures that are complete
+       while(!stack.empty() && stack.back().next==stack.back().size){
+           stack.pop_back();
        }
     }
-    uint64_t total = read64(index,data);
-    //printf("Sent %i :  Received %i\n",total,shared.size());
-    return MMC_FETCH(MMC_OFFSET(MMC_UNTAGPTR(result), 1));
+    return MMC_STRUCTDATA(result)[0];
+}
+
+modelica_metatype deserialize(std::string& buffer){
+    return deserializeData((const unsigned char*)buffer.data(),buffer.size());
 }
 
 
@@ -658,12 +857,66 @@ void Serializer_showBlocks(modelica_metatype object){
 
 
 void Serializer_outputFile(modelica_metatype input_object,char* filename){
-    std::fstream fs;
+    FILE* file = fopen(filename,"wb");
+    if(file==NULL){
+        return;
+    }
+    {
+        OutBuffer buffer(file);
+        serializeTo(input_object,buffer);
+    }
+    fclose(file);
+}
+
+typedef modelica_metatype (*ContentsFunction)(const unsigned char* data,mmc_uint_t size,const void* arg);
+
+/* Maps the file into memory (or reads it where mmap is not available) and
+   calls fn on its contents */
+static modelica_metatype withFileContents(const char* filename,ContentsFunction fn,const void* arg){
+    modelica_metatype res = NULL;
+#if !defined(_WIN32)
+    struct stat st;
+    void* data;
+    int fd = open(filename,O_RDONLY);
+    if(fd<0){
+        return NULL;
+    }
+    if(fstat(fd,&st) || st.st_size==0){
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(data==MAP_FAILED){
+        return NULL;
+    }
+#if defined(MADV_SEQUENTIAL)
+    madvise(data,st.st_size,MADV_SEQUENTIAL);
+#endif
+    res = fn((const unsigned char*)data,(mmc_uint_t)st.st_size,arg);
+    munmap(data,st.st_size);
+#else
     std::string buffer;
-    serialize(input_object,buffer);
-    fs.open (filename,std::fstream::out | std::fstream::binary);
-    fs.write(buffer.c_str(),buffer.size());
-    fs.close();
+    std::ifstream input_file(filename,std::ifstream::in | std::ifstream::binary);
+    if(!input_file.is_open()){
+        return NULL;
+    }
+    buffer.assign((std::istreambuf_iterator<char>(input_file)),std::istreambuf_iterator<char>());
+    res = fn((const unsigned char*)buffer.data(),buffer.size(),arg);
+#endif
+    return res;
+}
+
+static modelica_metatype readObjectData(const unsigned char* data,mmc_uint_t size,const void* arg){
+    return deserializeData(data,size);
+}
+
+modelica_metatype Serializer_inputFile(const char* filename){
+    modelica_metatype res = withFileContents(filename,readObjectData,NULL);
+    if(res==NULL){
+        MMC_THROW();
+    }
+    return res;
 }
 
 modelica_metatype Serializer_bypass(modelica_metatype input_object){
@@ -677,6 +930,116 @@ modelica_metatype Serializer_bypass(modelica_metatype input_object){
     return out;
 }
 
+/* Writes the object to filename and reads it back repeats times, reporting
+   the best write and read times in seconds and the size in bytes. */
+void Serializer_benchmark(modelica_metatype input_object,const char* filename,int repeats,double* writeTime,double* readTime,double* bytes){
+    rtclock_t start;
+    double t;
+    struct stat st;
+    *writeTime = *readTime = *bytes = 0;
+    for(int i=0; i<repeats; i++){
+        rt_ext_tp_tick(&start);
+        Serializer_outputFile(input_object,(char*)filename);
+        t = rt_ext_tp_tock(&start);
+        *writeTime = (i==0 || t<*writeTime) ? t : *writeTime;
+        rt_ext_tp_tick(&start);
+        if(withFileContents(filename,readObjectData,NULL)==NULL){
+            MMC_THROW();
+        }
+        t = rt_ext_tp_tock(&start);
+        *readTime = (i==0 || t<*readTime) ? t : *readTime;
+    }
+    if(0==stat(filename,&st)){
+        *bytes = st.st_size;
+    }
+}
+
+
+/*  CACHE FILES
+ *
+ *  A cache file is a serialized object preceded by a small header:
+ *    magic (8 bytes), key length (32 bits), key, payload size (64 bits),
+ *    payload checksum (64 bits, FNV-1a).
+ *  The key describes everything the object was computed from; a file is only
+ *  used if the stored key matches the requested one exactly.
+ */
 
+static const char CACHE_MAGIC[8] = {'O','M','C','S','E','R','0','1'};
 
-}
\ No newline at end of file
+int Serializer_writeCacheFile(modelica_metatype input_object, const char* filename, const char* key){
+    std::string header;
+    std::string tmpname(filename);
+    char suffix[64];
+    FILE* file;
+    size_t keylen = strlen(key);
+    long sizeOffset;
+    int ok;
+
+    {
+        OutBuffer buffer(header);
+        buffer.putBytes(CACHE_MAGIC,sizeof(CACHE_MAGIC));
+        write32(keylen,buffer);
+        buffer.putBytes(key,keylen);
+    }
+    sizeOffset = header.size();
+
+    /* Write to a private file and rename it, so concurrent readers never see a partial file */
+    snprintf(suffix,sizeof(suffix),".%ld.%lx.tmp",(long)getpid(),(unsigned long)(uintptr_t)&header);
+    tmpname += suffix;
+    file = fopen(tmpname.c_str(),"wb");
+    if(file==NULL){
+        return 0;
+    }
+    header.append(16,'\0'); // payload size and checksum, filled in below
+    ok = fwrite(header.data(),1,header.size(),file)==header.size();
+    if(ok){
+        std::string trailer;
+        OutBuffer buffer(file);
+        serializeTo(input_object,buffer);
+        ok = buffer.ok();
+        {
+            OutBuffer sizes(trailer);
+            write64(buffer.bytesWritten(),sizes);
+            write64(buffer.dataChecksum(),sizes);
+        }
+        ok = ok && 0==fseek(file,sizeOffset,SEEK_SET) &&
+             fwrite(trailer.data(),1,trailer.size(),file)==trailer.size();
+    }
+    ok = (0==fclose(file)) && ok;
+    if(!ok || 0!=rename(tmpname.c_str(),filename)){
+        remove(tmpname.c_str());
+        return 0;
+    }
+    return 1;
+}
+
+static modelica_metatype readCacheData(const unsigned char* data, mmc_uint_t size, const char* key){
+    mmc_uint_t index = sizeof(CACHE_MAGIC);
+    size_t keylen = strlen(key);
+    uint64_t payloadSize, checksum;
+
+    if(size < sizeof(CACHE_MAGIC)+4 || memcmp(data,CACHE_MAGIC,sizeof(CACHE_MAGIC))){
+        return NULL;
+    }
+    if(read32(index,data) != keylen || size < index+keylen+16 || memcmp(data+index,key,keylen)){
+        return NULL;
+    }
+    index += keylen;
+    payloadSize = read64(index,data);
+    checksum = read64(index,data);
+    if(payloadSize != size-index || checksum != cacheChecksum(data+index,payloadSize,CHECKSUM_INIT)){
+        return NULL;
+    }
+    return deserializeData(data+index,payloadSize);
+}
+
+static modelica_metatype readCacheContents(const unsigned char* data,mmc_uint_t size,const void* arg){
+    return readCacheData(data,size,(const char*)arg);
+}
+
+modelica_metatype Serializer_readCacheFile(const char* filename, const char* key){
+    return withFileContents(filename,readCacheContents,key);
+}
+
+
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2010, Linköpings University,
+ * Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THIS OSMC PUBLIC
+ * LICENSE (OSMC-PL). ANY USE, REPRODUCTION OR DISTRIBUTION OF
+ * THIS PROGRAM CONSTITUTES RECIPIENT'S ACCEPTANCE OF THE OSMC
+ * PUBLIC LICENSE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from Linköpings University, either from the above address,
+ * from the URL: http://www.ida.liu.se/projects/OpenModelica
+ * and in the OpenModelica distribution.
+ *
+ * This program is distributed  WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS
+ * OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+#ifndef SERIALIZER__H_
+#define SERIALIZER__H_
+
+#include "meta_modelica.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Writes the object to filename */
+extern void Serializer_outputFile(modelica_metatype input_object, char* filename);
+/* Reads an object written by Serializer_outputFile; throws if the file is missing or malformed */
+extern modelica_metatype Serializer_inputFile(const char* filename);
+/* Best of repeats write and read times in seconds, and the file size in bytes */
+extern void Serializer_benchmark(modelica_metatype input_object, const char* filename, int repeats, double* writeTime, double* readTime, double* bytes);
+
+/* Serializes the object to filename, tagged with key. Returns 1 on success. */
+extern int Serializer_writeCacheFile(modelica_metatype input_object, const char* filename, const char* key);
+/* Maps filename and de-serializes it if it was written with the same key. Returns NULL otherwise. */
+extern modelica_metatype Serializer_readCacheFile(const char* filename, const char* key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
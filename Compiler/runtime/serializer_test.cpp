@@ -0,0 +1,163 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF GPL VERSION 3 LICENSE OR
+ * THIS OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from OSMC, either from the above address,
+ * from the URLs: http://www.ida.liu.se/projects/OpenModelica or
+ * http://www.openmodelica.org, and in the OpenModelica distribution.
+ * GNU version 3 is obtained from: http://www.gnu.org/copyleft/gpl.html.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ * Test of the de-serializer on truncated and malformed input. A list with
+ * records, shared objects and every integer, string and structure encoding
+ * is serialized. Its complete image has to read back equal to the original,
+ * every truncated image has to be rejected with NULL without reading past
+ * the end of the buffer.
+ *
+ * Build and run with "make serializer-test" in Compiler/runtime. Running it
+ * under valgrind also catches reads past the end that happen to succeed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "meta_modelica.h"
+#include "serializer.h"
+
+extern "C" {
+void serialize(modelica_metatype input_object,std::string& str);
+modelica_metatype deserializeData(const unsigned char* data,mmc_uint_t size);
+}
+
+static const char* fieldNames[] = {"x","label","count"};
+static struct record_description recordDesc = {"SerializerTest.R","SerializerTest.R",fieldNames};
+
+static modelica_metatype makeObject()
+{
+  std::string big(1000,'b');
+  modelica_metatype shared = mmc_mk_scon("shared");
+  modelica_metatype lst = mmc_mk_nil();
+  int i;
+
+  for (i = 0; i < 20; i++) {
+    modelica_metatype rec = mmc_mk_box4(3,&recordDesc,mmc_mk_rcon(i*0.25),i%2 ? shared : mmc_mk_scon("own"),mmc_mk_icon(i));
+    lst = mmc_mk_cons(rec,lst);
+  }
+  lst = mmc_mk_cons(mmc_mk_icon(-5),lst);                    /* tiny integer */
+  lst = mmc_mk_cons(mmc_mk_icon(100000),lst);                /* 32 bit integer */
+  lst = mmc_mk_cons(mmc_mk_icon(((modelica_integer)1)<<40),lst); /* 64 bit integer */
+  lst = mmc_mk_cons(mmc_mk_scon(big.c_str()),lst);           /* long string */
+  lst = mmc_mk_cons(mmc_mk_box0(1),lst);                     /* empty structure */
+  lst = mmc_mk_cons(mmc_mk_box(20,255,
+    mmc_mk_icon(1),mmc_mk_icon(2),mmc_mk_icon(3),mmc_mk_icon(4),mmc_mk_icon(5),
+    mmc_mk_icon(6),mmc_mk_icon(7),mmc_mk_icon(8),mmc_mk_icon(9),mmc_mk_icon(10),
+    mmc_mk_icon(11),mmc_mk_icon(12),mmc_mk_icon(13),mmc_mk_icon(14),mmc_mk_icon(15),
+    mmc_mk_icon(16),mmc_mk_icon(17),mmc_mk_icon(18),mmc_mk_icon(19),shared),lst); /* big structure */
+  return lst;
+}
+
+/* De-serializes a copy of exactly size bytes, so reads past the end hit unallocated memory */
+static modelica_metatype deserializeCopy(const std::string& image,size_t size)
+{
+  unsigned char* data = (unsigned char*) malloc(size ? size : 1);
+  modelica_metatype res;
+  memcpy(data,image.data(),size);
+  res = deserializeData(data,size);
+  free(data);
+  return res;
+}
+
+/* The complete image reads back equal to the original */
+int test_roundtrip(modelica_metatype object,const std::string& image)
+{
+  modelica_metatype res = deserializeCopy(image,image.size());
+  if (res == NULL) return 1;
+  if (!valueEq(object,res)) return 2;
+  return 0;
+}
+
+/* Every prefix of the image followed by the original object count is rejected.
+   The prefixes cut the first record description at every byte before it is
+   complete and in the record cache. */
+int test_truncated(const std::string& image)
+{
+  const size_t payload = image.size()-8;
+  size_t n;
+
+  for (n = 0; n < payload; n++) {
+    std::string cut = image.substr(0,n) + image.substr(payload);
+    if (deserializeCopy(cut,cut.size()) != NULL) return 1;
+  }
+  return 0;
+}
+
+/* Plain prefixes lose the object count, they must not be read past their end */
+int test_prefix(const std::string& image)
+{
+  size_t n;
+
+  for (n = 0; n < image.size(); n++) {
+    deserializeCopy(image,n);
+  }
+  return 0;
+}
+
+/* Lengths of strings pointing past the end are rejected */
+int test_string_length(const std::string& image)
+{
+  std::string bad = image;
+  size_t pos = bad.find("SerializerTest.R");
+
+  if (pos == std::string::npos || pos < 1) return 1;
+  bad[pos-1] = (char) 0xFF; /* length of the path of the record description */
+  bad.resize(pos+16);
+  bad += image.substr(image.size()-8);
+  if (deserializeCopy(bad,bad.size()) != NULL) return 2;
+  return 0;
+}
+
+/* main */
+int main(void)
+{
+  /* return code */
+  int rc;
+  modelica_metatype object;
+  std::string image;
+
+  MMC_INIT(0);
+  object = makeObject();
+  serialize(object,image);
+
+  if ( (rc = test_truncated(image)) != 0) return 1000+rc;
+  if ( (rc = test_string_length(image)) != 0) return 2000+rc;
+  if ( (rc = test_prefix(image)) != 0) return 3000+rc;
+  if ( (rc = test_roundtrip(object,image)) != 0) return 4000+rc;
+
+  /* everything OK */
+  printf("serializer test passed\n");
+  return 0;
+}
@@ -73,6 +73,7 @@ goto rule ## func ## Ex; }}
   /* Enable if you don't want to generate the tree */
   void* mmc_mk_box_eat_all(int ix, ...);
   #define mmc_mk_scon(x) x
+  #define mmc_mk_scon_interned(x) x
   #define mmc_mk_rcon(x) mmc_mk_box_eat_all(0,x)
   #define mmc_mk_box0(x1) mmc_mk_box_eat_all(x1)
   #define mmc_mk_box1(x1,x2) mmc_mk_box_eat_all(x1,x2)
@@ -93,7 +94,8 @@ goto rule ## func ## Ex; }}
   #undef MMC_STRUCTHDR
   #define MMC_STRUCTHDR(x,y) 0
 #endif
-  #define token_to_scon(tok) mmc_mk_scon((char*)tok->getText(tok)->chars)
+  /* Identifiers are interned so that the compiler hashes and compares them cheaply */
+  #define token_to_scon(tok) mmc_mk_scon_interned((char*)tok->getText(tok)->chars)
   #define NYI(void) fprintf(stderr, "NYI \%s \%s:\%d\n", __FUNCTION__, __FILE__, __LINE__); exit(1);
 
   #define PARSER_INFO(start) ((void*) SourceInfo__SOURCEINFO(ModelicaParser_filename_OMC, mmc_mk_bcon(ModelicaParser_readonly), mmc_mk_icon(start->line), mmc_mk_icon(start->line == 1 ? start->charPosition+2 : start->charPosition+1), mmc_mk_icon(LT(1)->line), mmc_mk_icon(LT(1)->charPosition+1), ModelicaParser_timeStamp))
@@ -194,12 +196,12 @@ class_specifier returns [void* ast, void* name]
       {
         modelicaParserAssert($spec.s2 == NULL || !strcmp(s1,$spec.s2), "The identifier at start and end are different", class_specifier, $start->line, $start->charPosition+1, LT(1)->line, LT(1)->charPosition);
         $ast = $spec.ast;
-        $name = mmc_mk_scon(s1);
+        $name = mmc_mk_scon_interned(s1);
       }
     | EXTENDS s1=identifier (mod=class_modification)? cmt=string_comment comp=composition s2=END_IDENT
       {
         modelicaParserAssert(!strcmp(s1,(char*)$s2.text->chars), "The identifier at start and end are different", class_specifier, $start->line, $start->charPosition+1, LT(1)->line, LT(1)->charPosition);
-        $name = mmc_mk_scon(s1);
+        $name = mmc_mk_scon_interned(s1);
         $ast = Absyn__CLASS_5fEXTENDS($name, or_nil(mod), mmc_mk_some_or_none(cmt), $comp.ast, $comp.ann);
       }
     )
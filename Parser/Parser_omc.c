@@ -36,7 +36,7 @@
 #include "meta_modelica.h"
 #include "parse.c"
 
-void* ParserExt_parse(const char* filename, const char* infoname, int acceptedGrammar, int langStd, const char* encoding, int runningTestsuite)
+void* ParserExt_parse(const char* filename, const char* infoname, int acceptedGrammar, int langStd, const char* encoding, int runningTestsuite, int useCache)
 {
   int flags = PARSE_MODELICA;
   if(acceptedGrammar == 2) flags |= PARSE_META_MODELICA;
@@ -44,7 +44,8 @@ void* ParserExt_parse(const char* filename, const char* infoname, int acceptedGr
   else if(acceptedGrammar == 4) flags |= PARSE_OPTIMICA;
   else if(acceptedGrammar == 5) flags |= PARSE_PDEMODELICA;
 
-  void *res = parseFile(filename, infoname, flags, encoding, langStd, runningTestsuite);
+  void *res = useCache ? parseFileCached((threadData_t*)pthread_getspecific(mmc_thread_data_key), filename, infoname, flags, encoding, langStd, runningTestsuite)
+                       : parseFile(filename, infoname, flags, encoding, langStd, runningTestsuite);
   if (res == NULL)
     MMC_THROW();
   // printAny(res);
@@ -438,3 +438,10 @@ static void* parseFile(const char* fileName, const char* infoName, int flags, co
   }
   return parseStream(input, langStd, runningTestsuite);
 }
+
+#include "parse_cache.c"
+
+static void* parseFileCached(threadData_t *threadData, const char* fileName, const char* infoName, int flags, const char *encoding, int langStd, int runningTestsuite)
+{
+  return parseCacheLookup(threadData, parseFile, fileName, infoName, flags, encoding, langStd, runningTestsuite);
+}
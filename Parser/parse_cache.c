@@ -0,0 +1,179 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Linköpings University,
+ * Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THIS OSMC PUBLIC
+ * LICENSE (OSMC-PL). ANY USE, REPRODUCTION OR DISTRIBUTION OF
+ * THIS PROGRAM CONSTITUTES RECIPIENT'S ACCEPTANCE OF THE OSMC
+ * PUBLIC LICENSE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from Linköpings University, either from the above address,
+ * from the URL: http://www.ida.liu.se/projects/OpenModelica
+ * and in the OpenModelica distribution.
+ *
+ * This program is distributed  WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS
+ * OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/* Parse cache: the Absyn.Program of a successfully parsed file is serialized
+ * to the user cache directory, keyed by everything that affects the result
+ * (omc version, parser flags, file path and modification time, file contents).
+ *
+ * Only clean parses are cached. A file that gave errors or warnings is parsed
+ * again on every load, so its messages are reported every time.
+ *
+ * Included by parse.c; parse_cache_test.c includes it with a fake parser.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__MINGW32__) || defined(_MSC_VER)
+#include <direct.h>
+#endif
+
+#include "errorext.h"
+#include "systemimpl.h"
+#include "serializer.h"
+#include "omc_config.h"
+
+typedef void* (*parse_file_function)(const char* fileName, const char* infoName, int flags, const char *encoding, int langStd, int runningTestsuite);
+
+static uint64_t parseCacheHash(const unsigned char *data, size_t len, uint64_t h)
+{
+  size_t i;
+  for (i=0; i<len; i++) {
+    h ^= data[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static int parseCacheMakeDirectory(char *path)
+{
+  char *p;
+  for (p = path+1; *p; p++) {
+    if (*p == '/' || *p == '\\') {
+      char c = *p;
+      *p = '\0';
+#if defined(__MINGW32__) || defined(_MSC_VER)
+      mkdir(path);
+#else
+      mkdir(path, 0755);
+#endif
+      *p = c;
+    }
+  }
+#if defined(__MINGW32__) || defined(_MSC_VER)
+  return mkdir(path) == 0 || errno == EEXIST;
+#else
+  return mkdir(path, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+/* Returns the malloc'ed cache directory, or NULL if there is none */
+static char* parseCacheDirectory()
+{
+  const char *dir = getenv("OPENMODELICACACHE");
+  const char *sub = "";
+  char *res;
+  if (dir == NULL || *dir == '\0') {
+#if defined(__MINGW32__) || defined(_MSC_VER)
+    dir = getenv("LOCALAPPDATA");
+    sub = "/openmodelica/cache";
+#else
+    dir = getenv("XDG_CACHE_HOME");
+    sub = "/openmodelica";
+    if (dir == NULL || *dir == '\0') {
+      dir = getenv("HOME");
+      sub = "/.cache/openmodelica";
+    }
+#endif
+  }
+  if (dir == NULL || *dir == '\0') {
+    return NULL;
+  }
+  res = (char*) malloc(strlen(dir) + strlen(sub) + strlen("/parse") + 1);
+  if (res == NULL) {
+    return NULL;
+  }
+  sprintf(res, "%s%s/parse", dir, sub);
+  if (!parseCacheMakeDirectory(res)) {
+    free(res);
+    return NULL;
+  }
+  return res;
+}
+
+/* Returns the program of fileName from the cache, or parses it with parse and
+ * caches the result if the parse added no error or warning to the messages of
+ * threadData.
+ */
+static void* parseCacheLookup(threadData_t *threadData, parse_file_function parse, const char* fileName, const char* infoName, int flags, const char *encoding, int langStd, int runningTestsuite)
+{
+  struct stat st;
+  FILE *file;
+  unsigned char *contents;
+  char *dir, *key, *cacheFile;
+  uint64_t hash;
+  size_t keyLen, len = strlen(fileName);
+  int numMessages;
+  void *res;
+
+  if (stat(fileName, &st) || 0 == st.st_size || (len > 3 && 0==strcmp(fileName+len-4,".mof"))) {
+    return parse(fileName, infoName, flags, encoding, langStd, runningTestsuite);
+  }
+  if (NULL == (dir = parseCacheDirectory())) {
+    return parse(fileName, infoName, flags, encoding, langStd, runningTestsuite);
+  }
+  file = fopen(fileName, "rb");
+  contents = (unsigned char*) malloc(st.st_size);
+  if (file == NULL || fread(contents, 1, st.st_size, file) != (size_t) st.st_size) {
+    if (file) fclose(file);
+    free(contents);
+    free(dir);
+    return parse(fileName, infoName, flags, encoding, langStd, runningTestsuite);
+  }
+  fclose(file);
+  hash = parseCacheHash(contents, st.st_size, 14695981039346656037ULL);
+  free(contents);
+
+  keyLen = strlen(CONFIG_VERSION) + strlen(fileName) + strlen(infoName) + strlen(encoding) + 128;
+  key = (char*) malloc(keyLen);
+  snprintf(key, keyLen, "%s\n%s\n%s\n%s\nflags=%d langStd=%d testsuite=%d readonly=%d mtime=%.0f contents=%016llx",
+    CONFIG_VERSION, fileName, infoName, encoding, flags, langStd, runningTestsuite,
+    !SystemImpl__regularFileWritable(fileName), (double) st.st_mtime, (unsigned long long) hash);
+  hash = parseCacheHash((const unsigned char*) key, strlen(key), 14695981039346656037ULL);
+  cacheFile = (char*) malloc(strlen(dir) + 32);
+  sprintf(cacheFile, "%s/%016llx.ast", dir, (unsigned long long) hash);
+  free(dir);
+
+  res = Serializer_readCacheFile(cacheFile, key);
+  if (res == NULL) {
+    numMessages = ErrorImpl__getNumErrorMessages(threadData) + ErrorImpl__getNumWarningMessages(threadData);
+    res = parse(fileName, infoName, flags, encoding, langStd, runningTestsuite);
+    if (res != NULL && numMessages == ErrorImpl__getNumErrorMessages(threadData) + ErrorImpl__getNumWarningMessages(threadData)) {
+      Serializer_writeCacheFile(res, cacheFile, key);
+    }
+  }
+  free(cacheFile);
+  free(key);
+  return res;
+}
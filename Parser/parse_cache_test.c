@@ -0,0 +1,245 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Linköpings University,
+ * Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THIS OSMC PUBLIC
+ * LICENSE (OSMC-PL). ANY USE, REPRODUCTION OR DISTRIBUTION OF
+ * THIS PROGRAM CONSTITUTES RECIPIENT'S ACCEPTANCE OF THE OSMC
+ * PUBLIC LICENSE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from Linköpings University, either from the above address,
+ * from the URL: http://www.ida.liu.se/projects/OpenModelica
+ * and in the OpenModelica distribution.
+ *
+ * This program is distributed  WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS
+ * OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ * Test of the parse cache of parse_cache.c with a fake parser that returns the
+ * contents of the file and can report warnings: a clean parse is cached and
+ * read back instead of parsing again, any change of the contents, the
+ * modification time or the parser flags misses the cache, a damaged cache
+ * file is parsed again, and a file with warnings is never cached, so the
+ * warnings are reported on every load. The messages are counted on the
+ * threadData of the caller.
+ *
+ * Build and run with "make parse-cache-test" in Parser.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+
+#include "meta_modelica.h"
+#include "parse_cache.c"
+
+static threadData_t testThreadData;
+static int numParses, numWarnings, warningsPerParse, wrongThreadData;
+
+/* the messages of parse_cache.c are counted here */
+int ErrorImpl__getNumErrorMessages(threadData_t *threadData)
+{
+  if (threadData != &testThreadData) wrongThreadData++;
+  return 0;
+}
+
+int ErrorImpl__getNumWarningMessages(threadData_t *threadData)
+{
+  if (threadData != &testThreadData) wrongThreadData++;
+  return numWarnings;
+}
+
+int SystemImpl__regularFileWritable(const char* str)
+{
+  return 1;
+}
+
+static void* fakeParse(const char* fileName, const char* infoName, int flags, const char *encoding, int langStd, int runningTestsuite)
+{
+  char buffer[256];
+  size_t n;
+  FILE *file = fopen(fileName, "rb");
+  if (file == NULL) return NULL;
+  n = fread(buffer, 1, sizeof(buffer)-1, file);
+  fclose(file);
+  buffer[n] = '\0';
+  numParses++;
+  numWarnings += warningsPerParse;
+  return mmc_mk_box2(0, mmc_mk_scon(buffer), mmc_mk_icon(flags));
+}
+
+static char cacheDir[64], parseDir[96];
+
+static int numCacheFiles()
+{
+  int n = 0;
+  struct dirent *entry;
+  DIR *dir = opendir(parseDir);
+  if (dir == NULL) return 0;
+  while ((entry = readdir(dir))) {
+    if (strstr(entry->d_name, ".ast")) n++;
+  }
+  closedir(dir);
+  return n;
+}
+
+static void writeFile(const char *fileName, const char *contents, time_t mtime)
+{
+  struct utimbuf times;
+  FILE *file = fopen(fileName, "wb");
+  fputs(contents, file);
+  fclose(file);
+  times.actime = mtime;
+  times.modtime = mtime;
+  utime(fileName, &times);
+}
+
+/* loads fileName and checks that the program has the expected contents */
+static int load(const char *fileName, int flags, const char *expected)
+{
+  void *res = parseCacheLookup(&testThreadData, fakeParse, fileName, fileName, flags, "UTF-8", 3, 0);
+  if (res == NULL) return 1;
+  if (strcmp(MMC_STRINGDATA(MMC_STRUCTDATA(res)[0]), expected)) return 2;
+  if (mmc_unbox_integer(MMC_STRUCTDATA(res)[1]) != flags) return 3;
+  return 0;
+}
+
+static int test_cacheHit(const char *fileName)
+{
+  writeFile(fileName, "model M end M;", 1000000);
+  numParses = 0;
+  if (load(fileName, 1, "model M end M;")) return 1;
+  if (numParses != 1 || numCacheFiles() != 1) return 2;
+  /* the second load reads the cache file */
+  if (load(fileName, 1, "model M end M;")) return 3;
+  if (numParses != 1) return 4;
+  return 0;
+}
+
+static int test_invalidation(const char *fileName)
+{
+  writeFile(fileName, "model M end M;", 1000000);
+  numParses = 0;
+  if (load(fileName, 1, "model M end M;")) return 1;
+  /* same size and modification time, other contents */
+  writeFile(fileName, "model N end N;", 1000000);
+  if (load(fileName, 1, "model N end N;")) return 2;
+  if (numParses != 1) return 3;
+  /* same contents, other modification time */
+  writeFile(fileName, "model N end N;", 2000000);
+  if (load(fileName, 1, "model N end N;")) return 4;
+  if (numParses != 2) return 5;
+  /* other parser flags */
+  if (load(fileName, 2, "model N end N;")) return 6;
+  if (numParses != 3) return 7;
+  /* unchanged again */
+  if (load(fileName, 1, "model N end N;")) return 8;
+  if (numParses != 3) return 9;
+  return 0;
+}
+
+static int test_damagedCacheFile(const char *fileName)
+{
+  struct dirent *entry;
+  DIR *dir;
+  char path[512];
+  FILE *file;
+
+  writeFile(fileName, "model D end D;", 3000000);
+  numParses = 0;
+  if (load(fileName, 1, "model D end D;")) return 1;
+  /* truncate every cache file */
+  if ((dir = opendir(parseDir)) == NULL) return 2;
+  while ((entry = readdir(dir))) {
+    if (strstr(entry->d_name, ".ast")) {
+      snprintf(path, sizeof(path), "%s/%s", parseDir, entry->d_name);
+      file = fopen(path, "r+b");
+      fseek(file, 0, SEEK_END);
+      if (ftruncate(fileno(file), ftell(file) - 3)) return 3;
+      fclose(file);
+    }
+  }
+  closedir(dir);
+  if (load(fileName, 1, "model D end D;")) return 4;
+  if (numParses != 2) return 5;
+  /* and it is cached again */
+  if (load(fileName, 1, "model D end D;")) return 6;
+  if (numParses != 2) return 7;
+  return 0;
+}
+
+static int test_messageReplay(const char *fileName)
+{
+  int before = numCacheFiles();
+  writeFile(fileName, "model W Real x = 1.0e; end W;", 4000000);
+  numParses = 0;
+  numWarnings = 0;
+  warningsPerParse = 1;
+  if (load(fileName, 1, "model W Real x = 1.0e; end W;")) return 1;
+  if (load(fileName, 1, "model W Real x = 1.0e; end W;")) return 2;
+  warningsPerParse = 0;
+  /* parsed and warned on both loads, nothing cached */
+  if (numParses != 2 || numWarnings != 2) return 3;
+  if (numCacheFiles() != before) return 4;
+  return 0;
+}
+
+static void removeCache()
+{
+  struct dirent *entry;
+  DIR *dir = opendir(parseDir);
+  char path[512];
+  while (dir && (entry = readdir(dir))) {
+    if (strstr(entry->d_name, ".ast")) {
+      snprintf(path, sizeof(path), "%s/%s", parseDir, entry->d_name);
+      unlink(path);
+    }
+  }
+  if (dir) closedir(dir);
+  rmdir(parseDir);
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc = 0;
+  char fileName[128];
+
+  mmc_init_nogc();
+  strcpy(cacheDir, "/tmp/omc-parse-cache-test.XXXXXX");
+  if (mkdtemp(cacheDir) == NULL) return 1;
+  snprintf(parseDir, sizeof(parseDir), "%s/parse", cacheDir);
+  snprintf(fileName, sizeof(fileName), "%s/M.mo", cacheDir);
+  setenv("OPENMODELICACACHE", cacheDir, 1);
+
+  if ( (rc = test_cacheHit(fileName)) != 0) rc += 1000;
+  else if ( (rc = test_invalidation(fileName)) != 0) rc += 2000;
+  else if ( (rc = test_damagedCacheFile(fileName)) != 0) rc += 3000;
+  else if ( (rc = test_messageReplay(fileName)) != 0) rc += 4000;
+  else if (wrongThreadData) rc = 5000;
+
+  removeCache();
+  unlink(fileName);
+  rmdir(cacheDir);
+  if (rc) fprintf(stderr, "parse cache test failed: %d\n", rc);
+  /* everything OK */
+  return rc ? 1 : 0;
+}
@@ -52,16 +52,48 @@ typedef struct list_s {
   struct list_s *next;
 } list;
 
-static pthread_mutex_t memory_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
-static list *memory_pools = NULL;
+/* Every thread allocates from its own list of pools, so that several
+ * simulation instances can run in one process without contention and
+ * without one instance's pool_free releasing memory of another.
+ */
+static pthread_key_t memory_pool_key;
+static pthread_once_t memory_pool_once = PTHREAD_ONCE_INIT;
+
+static void pool_delete(void *pools)
+{
+  list *freelist = (list*) pools;
+  while (freelist) {
+    list *next = freelist->next;
+    free(freelist->memory);
+    free(freelist);
+    freelist = next;
+  }
+}
+
+static void pool_create_key(void)
+{
+  pthread_key_create(&memory_pool_key, pool_delete);
+}
+
+static list* pool_get(void)
+{
+  list *memory_pools;
+  pthread_once(&memory_pool_once, pool_create_key);
+  memory_pools = (list*) pthread_getspecific(memory_pool_key);
+  if (!memory_pools) {
+    memory_pools = (list*) malloc(sizeof(list));
+    memory_pools->used = 0;
+    memory_pools->size = 2*1024*1024; /* 2MB pool by default */
+    memory_pools->memory = malloc(memory_pools->size);
+    memory_pools->next = NULL;
+    pthread_setspecific(memory_pool_key, memory_pools);
+  }
+  return memory_pools;
+}
 
 static void pool_init(void)
 {
-  memory_pools = (list*) malloc(sizeof(list));
-  memory_pools->used = 0;
-  memory_pools->size = 2*1024*1024; /* 2MB pool by default */
-  memory_pools->memory = malloc(memory_pools->size);
-  memory_pools->next = NULL;
+  pool_get();
 }
 
 static unsigned long upper_power_of_two(unsigned long v)
@@ -81,43 +113,38 @@ static inline size_t round_up(size_t num, size_t factor)
   return num + factor - 1 - (num - 1) % factor;
 }
 
-static inline void pool_expand(size_t len)
+static inline list* pool_expand(list *memory_pools, size_t len)
 {
   list *newlist = NULL;
   /* Check if we have enough memory already */
   if (memory_pools->size - memory_pools->used >= len) {
-    return;
+    return memory_pools;
   }
   newlist = (list*) malloc(sizeof(list));
   newlist->next = memory_pools;
-  memory_pools = newlist;
-  memory_pools->used = 0;
-  memory_pools->size = upper_power_of_two(3*memory_pools->next->size/2 + len); /* expand by 1.5x the old memory pool. More if we request a very large array. */
-  memory_pools->memory = malloc(memory_pools->size);
+  newlist->used = 0;
+  newlist->size = upper_power_of_two(3*memory_pools->size/2 + len); /* expand by 1.5x the old memory pool. More if we request a very large array. */
+  newlist->memory = malloc(newlist->size);
+  pthread_setspecific(memory_pool_key, newlist);
+  return newlist;
 }
 
 static void* pool_malloc(size_t sz)
 {
   void *res;
+  list *memory_pools;
   sz = round_up(sz,8);
-  pthread_mutex_lock(&memory_pool_mutex);
-  pool_expand(sz);
+  memory_pools = pool_expand(pool_get(), sz);
   res = (void*)((char*)memory_pools->memory + memory_pools->used);
   memory_pools->used += sz;
-  pthread_mutex_unlock(&memory_pool_mutex);
   memset(res,0,sz);
   return res;
 }
 
 static int pool_free(void)
 {
-  list *freelist = memory_pools->next;
-  while (freelist) {
-    list *next = freelist->next;
-    free(freelist->memory);
-    free(freelist);
-    freelist = next;
-  }
+  list *memory_pools = pool_get();
+  pool_delete(memory_pools->next);
   memory_pools->used = 0;
   memory_pools->next = 0;
   return 0;
@@ -252,6 +279,19 @@ void* generic_alloc(int n, size_t sze)
   return (void*) omc_alloc_interface.malloc(n*sze);
 }
 
+/* Reserves sz bytes for the temporaries of the calling thread, so that the
+ * simulation steps do not have to request memory from the system (used by
+ * the real-time mode, see -rtPrealloc). */
+void omc_alloc_reserve(size_t sz)
+{
+#if !defined(OMC_MINIMAL_RUNTIME)
+  GC_expand_hp(sz);
+#else
+  /* the replaced pools are released by the next pool_free */
+  pool_expand(pool_get(), round_up(sz,8));
+#endif
+}
+
 
 #if defined(__cplusplus)
 } /* end extern "C" */
@@ -66,6 +66,7 @@ typedef struct {
 
 extern omc_alloc_interface_t omc_alloc_interface;
 extern omc_alloc_interface_t omc_alloc_interface_pooled;
+void omc_alloc_reserve(size_t sz);
 
 /*
  * ERROR_STAGE defines different
@@ -130,6 +131,7 @@ typedef struct threadData_s {
   void *plotClassPointer;
   PlotCallback plotCB;
   void *stackBottom; /* Actually offset 64 kB from bottom, just to never reach the bottom */
+  struct SIMULATION_INFO *simulationInfo; /* Simulation running on this thread, receives terminate() of the model */
 } threadData_t;
 
 typedef threadData_t* OpenModelica_threadData_ThreadData;
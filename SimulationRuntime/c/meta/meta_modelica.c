@@ -906,7 +906,7 @@ mmc_uint_t mmc_prim_hash(void *p, mmc_uint_t hash /* start at 5381 */)
 
   if( MMC_HDRISSTRING(phdr) )
   {
-    return djb2_hash_iter((const unsigned char *) MMC_STRINGDATA(p),MMC_STRLEN(p),hash);
+    return mmc_string_djb2(p,hash);
   }
 
   if( MMC_HDRISSTRUCT(phdr) )
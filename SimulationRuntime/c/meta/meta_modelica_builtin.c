@@ -113,15 +113,6 @@ modelica_real nobox_stringReal(threadData_t *threadData,metamodelica_string s)
  * http://www.cse.yorku.ca/~oz/hash.html
  * hash functions which could be useful to replace System__hash:
  */
-/*** djb2 hash ***/
-static inline unsigned long djb2_hash(const unsigned char *str)
-{
-  unsigned long hash = 5381;
-  int c;
-  while (0 != (c = *str++))  hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-  return hash;
-}
-
 /*** sdbm hash ***/
 static inline unsigned long sdbm_hash(const unsigned char* str)
 {
@@ -131,36 +122,252 @@ static inline unsigned long sdbm_hash(const unsigned char* str)
   return hash;
 }
 
-/* adrpo: really bad hash :) */
+/******************** Interned strings ********************/
+/*
+ * Strings interned by stringIntern live outside the GC heap in chunks that are
+ * never freed. Every entry is preceded by its djb2 state:
+ *
+ *   [djb2 of the data with seed 0][33^length][string header][data]
+ *
+ * djb2 with seed h is h*33^length + djb2(data, 0), so hashing an interned
+ * string, also as part of a larger value in mmc_prim_hash, does not look at
+ * the data. Equal interned strings are the same object.
+ *
+ * Chunks are aligned to their size and registered in intern_chunks, so
+ * mmc_string_is_interned only masks the address and probes that set; it is
+ * written under intern_chunk_mutex and read without locking. The table of
+ * strings is split in shards with a lock each, so that the parser threads of
+ * a parallel loadFiles rarely wait for each other.
+ */
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#define INTERN_CHUNK_BITS 16
+#define INTERN_CHUNK_SIZE ((size_t)1 << INTERN_CHUNK_BITS)
+#define INTERN_MAX_LENGTH (INTERN_CHUNK_SIZE/16)
+#define INTERN_CHUNK_SLOTS 65536 /* at most half of them are used; 2GB of strings */
+#define INTERN_SHARDS 64
+
+#if defined(_MSC_VER)
+#define INTERN_LOAD(p) (*(void* volatile*)(p))
+#define INTERN_STORE(p,v) (*(void* volatile*)(p) = (v))
+#else
+#define INTERN_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define INTERN_STORE(p,v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+typedef struct {
+  pthread_mutex_t mutex;
+  mmc_uint_t **slots; /* entries, pointing at the hash prefix */
+  size_t size, used;
+  char *next, *end;   /* free space in the current chunk of this shard */
+} intern_shard;
+
+static void *intern_chunks[INTERN_CHUNK_SLOTS];
+static size_t intern_nchunks = 0;
+static pthread_mutex_t intern_chunk_mutex = PTHREAD_MUTEX_INITIALIZER;
+static intern_shard intern_shards[INTERN_SHARDS];
+static pthread_once_t intern_once = PTHREAD_ONCE_INIT;
+
+static void intern_init(void)
+{
+  int i;
+  for (i=0; i<INTERN_SHARDS; i++) {
+    pthread_mutex_init(&intern_shards[i].mutex, NULL);
+  }
+}
+
+static inline size_t intern_chunk_slot(const void *base)
+{
+  return (size_t) ((((mmc_uint_t) base) >> INTERN_CHUNK_BITS) * 2654435761u) & (INTERN_CHUNK_SLOTS-1);
+}
+
+int mmc_string_is_interned(const void *str)
+{
+  void *base = (void*) (((mmc_uint_t) MMC_UNTAGPTR(str)) & ~((mmc_uint_t) INTERN_CHUNK_SIZE-1));
+  size_t i;
+  void *chunk;
+  for (i = intern_chunk_slot(base); NULL != (chunk = INTERN_LOAD(&intern_chunks[i])); i = (i+1) & (INTERN_CHUNK_SLOTS-1)) {
+    if (chunk == base) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Returns a new chunk, or NULL if out of memory or chunk slots */
+static void* intern_new_chunk(void)
+{
+  void *chunk = NULL;
+  size_t i;
+  pthread_mutex_lock(&intern_chunk_mutex);
+  if (intern_nchunks < INTERN_CHUNK_SLOTS/2) {
+#if defined(_WIN32)
+    chunk = _aligned_malloc(INTERN_CHUNK_SIZE, INTERN_CHUNK_SIZE);
+#else
+    if (posix_memalign(&chunk, INTERN_CHUNK_SIZE, INTERN_CHUNK_SIZE)) {
+      chunk = NULL;
+    }
+#endif
+  }
+  if (chunk) {
+    for (i = intern_chunk_slot(chunk); intern_chunks[i]; i = (i+1) & (INTERN_CHUNK_SLOTS-1));
+    INTERN_STORE(&intern_chunks[i], chunk);
+    intern_nchunks++;
+  }
+  pthread_mutex_unlock(&intern_chunk_mutex);
+  return chunk;
+}
+
+static inline size_t intern_slot(mmc_uint_t hash, size_t size)
+{
+  return (size_t) (hash ^ (hash >> 16)) & (size-1);
+}
+
+static inline mmc_uint_t intern_entry_hash(const mmc_uint_t *entry)
+{
+  return 5381*entry[1] + entry[0];
+}
+
+/* Returns the interned string with the given contents, adding it if needed.
+ * Returns NULL if it could not be added; the caller then uses an ordinary string. */
+static void* intern_lookup(const char *data, size_t len)
+{
+  mmc_uint_t h0 = 0, pow33 = 1, hash, *entry;
+  mmc_uint_t header = MMC_STRINGHDR(len);
+  size_t i, nbytes;
+  intern_shard *shard;
+
+  for (i=0; i<len; i++) {
+    h0 = ((h0 << 5) + h0) + (unsigned char) data[i];
+    pow33 *= 33;
+  }
+  hash = 5381*pow33 + h0;
+  shard = &intern_shards[(hash * 2654435761u >> 10) % INTERN_SHARDS];
+
+  pthread_once(&intern_once, intern_init);
+  pthread_mutex_lock(&shard->mutex);
+  if (shard->size) {
+    for (i = intern_slot(hash, shard->size); NULL != (entry = shard->slots[i]); i = (i+1) & (shard->size-1)) {
+      if (entry[0] == h0 && entry[1] == pow33 && entry[2] == header && 0 == memcmp(entry+3, data, len)) {
+        pthread_mutex_unlock(&shard->mutex);
+        return MMC_TAGPTR(entry+2);
+      }
+    }
+  }
+
+  /* Grow at half load */
+  if (2*(shard->used+1) > shard->size) {
+    size_t j, size = shard->size ? 2*shard->size : 256;
+    mmc_uint_t **slots = (mmc_uint_t**) calloc(size, sizeof(mmc_uint_t*));
+    if (slots == NULL) {
+      pthread_mutex_unlock(&shard->mutex);
+      return NULL;
+    }
+    for (j=0; j<shard->size; j++) {
+      if (shard->slots[j]) {
+        for (i = intern_slot(intern_entry_hash(shard->slots[j]), size); slots[i]; i = (i+1) & (size-1));
+        slots[i] = shard->slots[j];
+      }
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->size = size;
+  }
+
+  nbytes = (2 + MMC_HDRSLOTS(header) + 1) * sizeof(mmc_uint_t);
+  if (shard->next == NULL || (size_t)(shard->end - shard->next) < nbytes) {
+    char *chunk = (char*) intern_new_chunk();
+    if (chunk == NULL) {
+      pthread_mutex_unlock(&shard->mutex);
+      return NULL;
+    }
+    shard->next = chunk;
+    shard->end = chunk + INTERN_CHUNK_SIZE;
+  }
+  entry = (mmc_uint_t*) shard->next;
+  shard->next += nbytes;
+  entry[0] = h0;
+  entry[1] = pow33;
+  entry[2] = header;
+  memcpy(entry+3, data, len);
+  ((char*)(entry+3))[len] = '\0';
+
+  for (i = intern_slot(hash, shard->size); shard->slots[i]; i = (i+1) & (shard->size-1));
+  shard->slots[i] = entry;
+  shard->used++;
+  pthread_mutex_unlock(&shard->mutex);
+  return MMC_TAGPTR(entry+2);
+}
+
+modelica_metatype stringIntern(metamodelica_string_const s)
+{
+  size_t len = MMC_STRLEN(s);
+  void *res;
+  if (len == 0) {
+    return mmc_emptystring;
+  }
+  if (len == 1) {
+    return mmc_strings_len1[(unsigned char) MMC_STRINGDATA(s)[0]];
+  }
+  if (len > INTERN_MAX_LENGTH || mmc_string_is_interned(s)) {
+    return (modelica_metatype) s;
+  }
+  res = intern_lookup(MMC_STRINGDATA(s), len);
+  return res ? res : (modelica_metatype) s;
+}
+
+modelica_metatype mmc_mk_scon_interned(const char *s)
+{
+  size_t len = strlen(s);
+  void *res;
+  if (len <= 1 || len > INTERN_MAX_LENGTH) {
+    return mmc_mk_scon(s);
+  }
+  res = intern_lookup(s, len);
+  return res ? res : mmc_mk_scon(s);
+}
+
+mmc_uint_t mmc_string_djb2(metamodelica_string_const s, mmc_uint_t hash)
+{
+  const unsigned char *str;
+  size_t i, len;
+  if (mmc_string_is_interned(s)) {
+    const mmc_uint_t *entry = ((const mmc_uint_t*) MMC_UNTAGPTR(s)) - 2;
+    return hash*entry[1] + entry[0];
+  }
+  str = (const unsigned char*) MMC_STRINGDATA(s);
+  len = MMC_STRLEN(s);
+  for (i=0; i<len; i++) {
+    hash = ((hash << 5) + hash) + str[i]; /* hash * 33 + c */
+  }
+  return hash;
+}
+
+/* Used to be the sum of the characters, which is a really bad hash */
 modelica_integer stringHash(metamodelica_string_const s)
 {
-  const char* str = MMC_STRINGDATA(s);
-  long res = 0, i=0;
-  while (0 != (str[i])) { res += str[i]; i++; }
-  return res;
+  return stringHashDjb2(s);
 }
 
 /* adrpo: see the comment above about djb2 hash */
 modelica_integer stringHashDjb2(metamodelica_string_const s)
 {
-  const char* str = MMC_STRINGDATA(s);
-  long res = djb2_hash((const unsigned char*)str);
+  long res = (unsigned long) mmc_string_djb2(s, 5381);
   res = labs(res);
-  /* fprintf(stderr, "stringHashDjb2 %s-> %ld %ld %ld\n", str, res, mmc_mk_icon(res), mmc_unbox_integer(mmc_mk_icon(res))); */
   return res;
 }
 
 /* adrpo: see the comment above about djb2 hash */
 modelica_integer stringHashDjb2Mod(metamodelica_string_const s, modelica_integer mod)
 {
-  const char* str = MMC_STRINGDATA(s);
   long res;
   if (mod == 0) {
     MMC_THROW();
   }
-  res = djb2_hash((const unsigned char*)str) % (unsigned int) mod;
+  res = ((unsigned long) mmc_string_djb2(s, 5381)) % (unsigned int) mod;
   res = labs(res);
-  /* fprintf(stderr, "stringHashDjb2Mod %s %ld-> %ld %ld %ld\n", str, mod, res, mmc_mk_icon(res), mmc_unbox_integer(mmc_mk_icon(res))); */
   return res;
 }
 
@@ -84,6 +84,12 @@ extern modelica_integer stringHash(metamodelica_string_const);
 extern modelica_integer stringHashDjb2(metamodelica_string_const s);
 extern modelica_integer stringHashDjb2Mod(metamodelica_string_const s,modelica_integer mod);
 extern modelica_integer stringHashSdbm(metamodelica_string_const str);
+/* Interned strings: equal interned strings are the same object and hash in constant time */
+extern modelica_metatype stringIntern(metamodelica_string_const s);
+extern modelica_metatype mmc_mk_scon_interned(const char *s);
+extern int mmc_string_is_interned(const void *s);
+/* djb2 hash of the string data, continuing from hash (5381 for a plain djb2) */
+extern mmc_uint_t mmc_string_djb2(metamodelica_string_const s, mmc_uint_t hash);
 #define substring(X,Y,Z) boxptr_substring(threadData,X,mmc_mk_icon(Y),mmc_mk_icon(Z))
 extern modelica_metatype boxptr_substring(threadData_t *,metamodelica_string_const str, modelica_metatype start, modelica_metatype stop);
 
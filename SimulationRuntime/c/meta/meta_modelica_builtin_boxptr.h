@@ -117,6 +117,7 @@ boxptr_binFn(boxptr_stringEqual,mmc_mk_bcon,(void*),stringEqual)
 boxptr_unOp(boxptr_stringHash,mmc_mk_icon,(void*),stringHash)
 boxptr_unOp(boxptr_stringHashDjb2,mmc_mk_icon,(void*),stringHashDjb2)
 boxptr_unOp(boxptr_stringHashSdbm,mmc_mk_icon,(void*),stringHashSdbm)
+boxptr_wrapper1Arg(boxptr_stringIntern,stringIntern)
 boxptr_wrapper2Args(boxptr_stringDelimitList,stringDelimitList)
 boxptr_fn2ArgsThreadData(boxptr_stringGet,mmc_mk_icon,(void*),mmc_unbox_integer,nobox_stringGet)
 boxptr_wrapper2Args(boxptr_stringAppend,stringAppend)
@@ -85,6 +85,7 @@ static void* boxvar_fn_stringHashDjb2 = (void*) boxptr_stringHashDjb2;
 static void* boxvar_fn_stringHashDjb2Mod = (void*) boxptr_stringHashDjb2Mod;
 static void* boxvar_fn_stringHashSdbm = (void*) boxptr_stringHashSdbm;
 static void* boxvar_fn_stringInt = (void*) boxptr_stringInt;
+static void* boxvar_fn_stringIntern = (void*) boxptr_stringIntern;
 static void* boxvar_fn_stringLength = (void*) boxptr_stringLength;
 static void* boxvar_fn_stringReal = (void*) boxptr_stringReal;
 static void* boxvar_fn_stringUpdateStringChar = (void*) boxptr_stringUpdateStringChar;
@@ -251,6 +252,8 @@ static const MMC_DEFSTRUCTLIT(boxvar_lit_stringHashSdbm,2,0) {(modelica_metatype
 #define boxvar_stringHashSdbm MMC_REFSTRUCTLIT(boxvar_lit_stringHashSdbm)
 static const MMC_DEFSTRUCTLIT(boxvar_lit_stringInt,2,0) {(modelica_metatype) OMC_SYM_BOXPTR(stringInt),0}};
 #define boxvar_stringInt MMC_REFSTRUCTLIT(boxvar_lit_stringInt)
+static const MMC_DEFSTRUCTLIT(boxvar_lit_stringIntern,2,0) {(modelica_metatype) OMC_SYM_BOXPTR(stringIntern),0}};
+#define boxvar_stringIntern MMC_REFSTRUCTLIT(boxvar_lit_stringIntern)
 static const MMC_DEFSTRUCTLIT(boxvar_lit_stringLength,2,0) {(modelica_metatype) OMC_SYM_BOXPTR(stringLength),0}};
 #define boxvar_stringLength MMC_REFSTRUCTLIT(boxvar_lit_stringLength)
 static const MMC_DEFSTRUCTLIT(boxvar_lit_stringReal,2,0) {(modelica_metatype) OMC_SYM_BOXPTR(stringReal),0}};
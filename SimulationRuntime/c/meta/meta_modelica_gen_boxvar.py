@@ -80,6 +80,7 @@ functions = [
 'stringHashDjb2Mod',
 'stringHashSdbm',
 'stringInt',
+'stringIntern',
 'stringLength',
 'stringReal',
 'stringUpdateStringChar',
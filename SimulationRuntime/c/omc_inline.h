@@ -50,4 +50,16 @@
  * using inline is also static, so it will hold. */
 #endif
 
+/* Thread-local storage for the few globals that must be private to each
+ * simulation instance running in the same process (see -ensemble). */
+#if !defined(OMC_THREAD_LOCAL)
+#if defined(_MSC_VER)
+# define OMC_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+# define OMC_THREAD_LOCAL __thread
+#else
+# define OMC_THREAD_LOCAL
+#endif
+#endif
+
 #endif /* INLINE_H_ */
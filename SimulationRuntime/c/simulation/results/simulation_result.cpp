@@ -37,7 +37,7 @@ static void sim_result_doNothing(simulation_result* self, DATA *data, threadData
   /* Do nothing */
 }
 
-simulation_result sim_result = {
+OMC_THREAD_LOCAL simulation_result sim_result = {
   NULL, /* filename */
   0, /* numpoints */
   0, /* cpuTime */
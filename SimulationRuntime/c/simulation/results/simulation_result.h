@@ -49,7 +49,8 @@ typedef struct simulation_result {
   void (*free)(struct simulation_result*,DATA*,threadData_t *threadData);
 } simulation_result;
 
-extern simulation_result sim_result;
+/* one result per thread, so that several instances can simulate concurrently */
+extern OMC_THREAD_LOCAL simulation_result sim_result;
 
 #ifdef __cplusplus
 }
@@ -35,32 +35,60 @@
 #include "meta/meta_modelica.h"
 #include "simulation_runtime.h"
 
-int terminationTerminate = 0; /* Becomes non-zero when user terminates simulation. */
-FILE_INFO TermInfo;           /* message for termination. */
-char* TermMsg;                /* message for termination. */
+/*! \fn void initializeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+ *
+ *  Resets the state of terminate() for a new run and binds simulationInfo to
+ *  threadData, so terminate() called by the model on this thread only stops
+ *  this run.
+ */
+void initializeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+{
+  simulationInfo->terminationTerminate = 0;
+  simulationInfo->terminationMessage = NULL;
+  simulationInfo->terminationMessageSize = 0;
+  set_struct(FILE_INFO, simulationInfo->terminationInfo, omc_dummyFileInfo);
+  threadData->simulationInfo = simulationInfo;
+}
+
+/*! \fn void freeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+ *
+ *  Frees the message of terminate() and unbinds simulationInfo from threadData.
+ */
+void freeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+{
+  free(simulationInfo->terminationMessage);
+  simulationInfo->terminationMessage = NULL;
+  simulationInfo->terminationMessageSize = 0;
+  if(threadData->simulationInfo == simulationInfo)
+  {
+    threadData->simulationInfo = NULL;
+  }
+}
 
 /*! \fn void setTermMsg(const char* msg)
  *
  *  prints all values as arguments it need data
  *  and which part of the ring should printed.
  */
-static void setTermMsg(const char *msg, va_list ap)
+static void setTermMsg(SIMULATION_INFO *simulationInfo, const char *msg, va_list ap)
 {
   size_t i;
-  static size_t termMsgSize = 0;
-  if(NULL == TermMsg)
+  va_list ap2;
+  if(NULL == simulationInfo->terminationMessage)
   {
-    termMsgSize = modelica_integer_max(strlen(msg)*2+1,(size_t)2048);
-    TermMsg = (char*) malloc(termMsgSize);
+    simulationInfo->terminationMessageSize = modelica_integer_max(strlen(msg)*2+1,(size_t)2048);
+    simulationInfo->terminationMessage = (char*) malloc(simulationInfo->terminationMessageSize);
   }
-  i = vsnprintf(TermMsg,termMsgSize,msg,ap);
-  if(i >= termMsgSize)
+  va_copy(ap2, ap);
+  i = vsnprintf(simulationInfo->terminationMessage,simulationInfo->terminationMessageSize,msg,ap);
+  if(i >= simulationInfo->terminationMessageSize)
   {
-    free(TermMsg);
-    termMsgSize = 2*i+1;
-    TermMsg = (char*)malloc(termMsgSize);
-    vsnprintf(TermMsg,termMsgSize,msg,ap);
+    free(simulationInfo->terminationMessage);
+    simulationInfo->terminationMessageSize = 2*i+1;
+    simulationInfo->terminationMessage = (char*)malloc(simulationInfo->terminationMessageSize);
+    vsnprintf(simulationInfo->terminationMessage,simulationInfo->terminationMessageSize,msg,ap2);
   }
+  va_end(ap2);
 }
 
 static void omc_assert_simulation(threadData_t *threadData, FILE_INFO info, const char *msg, ...) __attribute__ ((noreturn));
@@ -145,30 +173,43 @@ static void omc_assert_warning_simulation_withEquationIndexes(FILE_INFO info, co
 
 static void omc_terminate_simulation(FILE_INFO info, const char *msg, ...)
 {
+  threadData_t *threadData = (threadData_t*)pthread_getspecific(mmc_thread_data_key);
+  SIMULATION_INFO *simulationInfo = threadData ? threadData->simulationInfo : NULL;
   va_list ap;
   va_start(ap,msg);
-  terminationTerminate = 1;
-  setTermMsg(msg,ap);
+  if(simulationInfo)
+  {
+    simulationInfo->terminationTerminate = 1;
+    setTermMsg(simulationInfo,msg,ap);
+    simulationInfo->terminationInfo = info;
+  }
+  else
+  {
+    va_warningStreamPrint(LOG_STDOUT, 0, msg, ap);
+    warningStreamPrint(LOG_STDOUT, 0, "terminate() is ignored outside of a simulation");
+  }
   va_end(ap);
-  TermInfo = info;
 }
 
 /*
  * adrpo: workaround function to call setTermMsg with empty va_list!
  *        removes the uninitialized warning for va_list variable.
  */
-void setTermMsg_empty_va_list(const char *msg, ...) {
+static void setTermMsg_empty_va_list(SIMULATION_INFO *simulationInfo, const char *msg, ...) {
   va_list dummy;
   va_start(dummy, msg);
-  setTermMsg(msg, dummy);
+  setTermMsg(simulationInfo, msg, dummy);
   va_end(dummy);
 }
 
 static void omc_throw_simulation(threadData_t* threadData)
 {
-  setTermMsg_empty_va_list("Assertion triggered by external C function");
-  set_struct(FILE_INFO, TermInfo, omc_dummyFileInfo);
   threadData = threadData ? threadData : (threadData_t*)pthread_getspecific(mmc_thread_data_key);
+  if(threadData->simulationInfo)
+  {
+    setTermMsg_empty_va_list(threadData->simulationInfo, "Assertion triggered by external C function");
+    set_struct(FILE_INFO, threadData->simulationInfo->terminationInfo, omc_dummyFileInfo);
+  }
   longjmp(*threadData->globalJumpBuffer, 1);
 }
 
@@ -45,6 +45,8 @@
 #include <signal.h>
 #include <fstream>
 #include <stdarg.h>
+#include <vector>
+#include <algorithm>
 
 #ifndef _MSC_VER
   #include <regex.h>
@@ -84,6 +86,7 @@
 #include "util/rtclock.h"
 #include "omc_config.h"
 #include "simulation/solver/initialization/initialization.h"
+#include "util/read_csv.h"
 
 #ifdef _OMC_QSS_LIB
   #include "solver_qss/solver_qss.h"
@@ -98,8 +101,6 @@ using namespace std;
 
 extern "C" {
 
-int sim_noemit = 0;           /* Flag for not emitting data */
-
 const std::string *init_method = NULL; /* method for  initialization. */
 
 static int callSolver(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
@@ -587,7 +588,7 @@ int initializeResultData(DATA* simData, threadData_t *threadData, int cpuTime)
   sim_result.filename = strdup(simData->modelData->resultFileName);
   sim_result.numpoints = maxSteps;
   sim_result.cpuTime = cpuTime;
-  if (sim_noemit || 0 == strcmp("empty", simData->simulationInfo->outputFormat)) {
+  if (simData->simulationInfo->noEmit || 0 == strcmp("empty", simData->simulationInfo->outputFormat)) {
     /* Default is set to noemit */
   } else if(0 == strcmp("csv", simData->simulationInfo->outputFormat)) {
     sim_result.init = omc_csv_init;
@@ -786,6 +787,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
     std::cerr << "Error: Could not initialize the global data structure file" << std::endl;
     EXIT(1);
   }
+  initializeTermination(data->simulationInfo, threadData);
 
   data->simulationInfo->nlsMethod = getNonlinearSolverMethod();
   data->simulationInfo->lsMethod = getlinearSolverMethod();
@@ -801,6 +803,14 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
     linearSparseSolverMinSize = atoi(omc_flagValue[FLAG_LSS_MIN_SIZE]);
     infoStreamPrint(LOG_STDOUT, 0, "Maximum system size for using linear sparse solver changed to %d", linearSparseSolverMinSize);
   }
+  if(omc_flag[FLAG_NLSS_MAX_DENSITY]) {
+    nonlinearSparseSolverMaxDensity = atof(omc_flagValue[FLAG_NLSS_MAX_DENSITY]);
+    infoStreamPrint(LOG_STDOUT, 0, "Maximum density for using nonlinear sparse solver changed to %f", nonlinearSparseSolverMaxDensity);
+  }
+  if(omc_flag[FLAG_NLSS_MIN_SIZE]) {
+    nonlinearSparseSolverMinSize = atoi(omc_flagValue[FLAG_NLSS_MIN_SIZE]);
+    infoStreamPrint(LOG_STDOUT, 0, "Minimum system size for using nonlinear sparse solver changed to %d", nonlinearSparseSolverMinSize);
+  }
   if(omc_flag[FLAG_NEWTON_XTOL]) {
     newtonXTol = atof(omc_flagValue[FLAG_NEWTON_XTOL]);
     infoStreamPrint(LOG_STDOUT, 0, "Tolerance for updating solution vector in Newton solver changed to %g", newtonXTol);
@@ -820,7 +830,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
   initializeLinearSystems(data, threadData);
   initializeNonlinearSystems(data, threadData);
 
-  sim_noemit = omc_flag[FLAG_NOEMIT];
+  data->simulationInfo->noEmit = omc_flag[FLAG_NOEMIT];
 
   // ppriv - NO_INTERACTIVE_DEPENDENCY - for simpler debugging in Visual Studio
 
@@ -891,6 +901,243 @@ void communicateMsg(char id, unsigned int size, const char *data)
 }
 
 
+/* ensemble simulation (-ensemble)
+ *
+ * All runs share the read-only model information of the DATA passed to
+ * _main_SimulationRuntime (variable infos, model info xml, callbacks,
+ * command-line flags). Every run gets its own MODEL_DATA and SIMULATION_INFO
+ * with copied static variable data, its own threadData_t and is simulated
+ * on one thread of a small pool.
+ */
+typedef struct ENSEMBLE_DATA
+{
+  DATA *base;
+  struct csv_data *variants;
+  std::vector<int> kind;   /* per csv column: 0 real parameter, 1 integer parameter, 2 boolean parameter, 3 real start value, -1 unknown */
+  std::vector<long> index;
+  int nRuns;
+  int nextRun;
+  int failedRuns;
+  pthread_mutex_t mutex;
+  const char *argv_0;
+} ENSEMBLE_DATA;
+
+static void ensembleResultFileName(DATA *base, int run, std::string &result)
+{
+  const char *result_file = omc_flagValue[FLAG_R];
+  std::ostringstream ss;
+  if (result_file) {
+    std::string name(result_file);
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) {
+      ss << name << "_" << run;
+    } else {
+      ss << name.substr(0, dot) << "_" << run << name.substr(dot);
+    }
+  } else {
+    ss << base->modelData->modelFilePrefix << "_res_" << run << "." << base->simulationInfo->outputFormat;
+  }
+  result = ss.str();
+}
+
+static int ensembleRun(ENSEMBLE_DATA *ens, int run, threadData_t *threadData)
+{
+  DATA *base = ens->base;
+  MODEL_DATA *baseModelData = base->modelData;
+  DATA data = *base;
+  MODEL_DATA modelData = *baseModelData;
+  SIMULATION_INFO simInfo = *base->simulationInfo;
+  std::string resultFile;
+  int retVal = -1;
+  long i;
+
+  data.modelData = &modelData;
+  data.simulationInfo = &simInfo;
+  initializeDataStruc(&data, threadData);
+  initializeTermination(&simInfo, threadData);
+
+  /* copy the static variable data instead of reading the init file again */
+#define ENSEMBLE_COPY_VARS(n,vars) memcpy(modelData.vars, baseModelData->vars, modelData.n*sizeof(*modelData.vars));
+  ENSEMBLE_COPY_VARS(nVariablesReal,realVarsData)
+  ENSEMBLE_COPY_VARS(nVariablesInteger,integerVarsData)
+  ENSEMBLE_COPY_VARS(nVariablesBoolean,booleanVarsData)
+  ENSEMBLE_COPY_VARS(nVariablesString,stringVarsData)
+  ENSEMBLE_COPY_VARS(nParametersReal,realParameterData)
+  ENSEMBLE_COPY_VARS(nParametersInteger,integerParameterData)
+  ENSEMBLE_COPY_VARS(nParametersBoolean,booleanParameterData)
+  ENSEMBLE_COPY_VARS(nParametersString,stringParameterData)
+  ENSEMBLE_COPY_VARS(nAliasReal,realAlias)
+  ENSEMBLE_COPY_VARS(nAliasInteger,integerAlias)
+  ENSEMBLE_COPY_VARS(nAliasBoolean,booleanAlias)
+  ENSEMBLE_COPY_VARS(nAliasString,stringAlias)
+  ENSEMBLE_COPY_VARS(nSamples,samplesInfo)
+  ENSEMBLE_COPY_VARS(nClocks,clocksInfo)
+  ENSEMBLE_COPY_VARS(nSubClocks,subClocksInfo)
+#undef ENSEMBLE_COPY_VARS
+  modelData.modelDataXml = baseModelData->modelDataXml;
+  modelData.sharedVarInfo = 1;
+
+  simInfo.nlsMethod = base->simulationInfo->nlsMethod;
+  simInfo.lsMethod = base->simulationInfo->lsMethod;
+  simInfo.lssMethod = base->simulationInfo->lssMethod;
+  simInfo.newtonStrategy = base->simulationInfo->newtonStrategy;
+  simInfo.nlsCsvInfomation = base->simulationInfo->nlsCsvInfomation;
+  simInfo.noEmit = base->simulationInfo->noEmit;
+
+  /* apply the overrides of this run */
+  for (i = 0; i < ens->variants->numvars; ++i) {
+    double value = ens->variants->data[i*ens->variants->numsteps + run];
+    switch (ens->kind[i]) {
+    case 0: modelData.realParameterData[ens->index[i]].attribute.start = value; break;
+    case 1: modelData.integerParameterData[ens->index[i]].attribute.start = (modelica_integer) value; break;
+    case 2: modelData.booleanParameterData[ens->index[i]].attribute.start = value != 0.0; break;
+    case 3: modelData.realVarsData[ens->index[i]].attribute.start = value; break;
+    default: break;
+    }
+  }
+
+  initializeMixedSystems(&data, threadData);
+  initializeLinearSystems(&data, threadData);
+  initializeNonlinearSystems(&data, threadData);
+
+  simInfo.numSteps = static_cast<modelica_integer>(round((simInfo.stopTime - simInfo.startTime)/simInfo.stepSize));
+  if (omc_flag[FLAG_S] && omc_flagValue[FLAG_S]) {
+    simInfo.solverMethod = omc_flagValue[FLAG_S];
+  }
+  ensembleResultFileName(base, run, resultFile);
+  modelData.resultFileName = GC_strdup(resultFile.c_str());
+
+  retVal = callSolver(&data, threadData,
+                      omc_flag[FLAG_IIM] ? omc_flagValue[FLAG_IIM] : "",
+                      omc_flag[FLAG_IIF] ? omc_flagValue[FLAG_IIF] : "",
+                      omc_flag[FLAG_IIT] ? atof(omc_flagValue[FLAG_IIT]) : 0.0,
+                      omc_flag[FLAG_ILS] ? atoi(omc_flagValue[FLAG_ILS]) : 1,
+                      omc_flag[FLAG_OUTPUT] ? omc_flagValue[FLAG_OUTPUT] : "",
+                      omc_flag[FLAG_CPU], ens->argv_0);
+
+  freeMixedSystems(&data, threadData);
+  freeLinearSystems(&data, threadData);
+  freeNonlinearSystems(&data, threadData);
+  data.callback->callExternalObjectDestructors(&data, threadData);
+  freeTermination(&simInfo, threadData);
+  deInitializeDataStruc(&data);
+
+  infoStreamPrint(LOG_STDOUT, 0, "ensemble run %d of %d %s, result file %s", run, ens->nRuns, retVal ? "failed" : "finished", resultFile.c_str());
+  return retVal;
+}
+
+static void* ensembleWorker(void *arg)
+{
+  ENSEMBLE_DATA *ens = (ENSEMBLE_DATA*) arg;
+  threadData_t threadDataOnStack;
+  threadData_t *threadData = &threadDataOnStack;
+  memset(threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, threadData);
+  omc_alloc_interface.init();
+
+  for (;;) {
+    int run, retVal = 1;
+    pthread_mutex_lock(&ens->mutex);
+    run = ens->nextRun++;
+    pthread_mutex_unlock(&ens->mutex);
+    if (run >= ens->nRuns) {
+      break;
+    }
+    MMC_TRY_INTERNAL(globalJumpBuffer)
+      retVal = ensembleRun(ens, run, threadData);
+    MMC_CATCH_INTERNAL(globalJumpBuffer)
+    if (retVal) {
+      pthread_mutex_lock(&ens->mutex);
+      ens->failedRuns++;
+      pthread_mutex_unlock(&ens->mutex);
+    }
+  }
+  return NULL;
+}
+
+int runEnsemble(int argc, char**argv, DATA *data, threadData_t *threadData)
+{
+  ENSEMBLE_DATA ens;
+  std::vector<pthread_t> threads;
+  long nThreads = 1, i, j;
+  const char *fileName = omc_flagValue[FLAG_ENSEMBLE];
+
+  if (measure_time_flag || omc_flag[FLAG_L] || omc_flag[FLAG_IDAS] || omc_flag[FLAG_EMBEDDED_SERVER]) {
+    throwStreamPrint(threadData, "-ensemble cannot be combined with profiling, -l, -idaSensitivity or -embeddedServer");
+  }
+  ens.variants = read_csv(fileName);
+  if (!ens.variants) {
+    throwStreamPrint(threadData, "Failed to read ensemble file %s", fileName);
+  }
+  ens.base = data;
+  ens.nRuns = ens.variants->numsteps;
+  ens.nextRun = 0;
+  ens.failedRuns = 0;
+  ens.argv_0 = argv[0];
+  pthread_mutex_init(&ens.mutex, NULL);
+
+  /* map the csv columns to variables of the model */
+  for (i = 0; i < ens.variants->numvars; ++i) {
+    const char *name = ens.variants->variables[i];
+    int kind = -1;
+    long index = -1;
+    for (j = 0; kind < 0 && j < data->modelData->nParametersReal; ++j) {
+      if (0 == strcmp(name, data->modelData->realParameterData[j].info.name)) { kind = 0; index = j; }
+    }
+    for (j = 0; kind < 0 && j < data->modelData->nParametersInteger; ++j) {
+      if (0 == strcmp(name, data->modelData->integerParameterData[j].info.name)) { kind = 1; index = j; }
+    }
+    for (j = 0; kind < 0 && j < data->modelData->nParametersBoolean; ++j) {
+      if (0 == strcmp(name, data->modelData->booleanParameterData[j].info.name)) { kind = 2; index = j; }
+    }
+    for (j = 0; kind < 0 && j < data->modelData->nVariablesReal; ++j) {
+      if (0 == strcmp(name, data->modelData->realVarsData[j].info.name)) { kind = 3; index = j; }
+    }
+    if (kind < 0) {
+      warningStreamPrint(LOG_STDOUT, 0, "ensemble: %s is not a parameter or variable of the model and is ignored", name);
+    }
+    ens.kind.push_back(kind);
+    ens.index.push_back(index);
+  }
+
+  if (omc_flag[FLAG_ENSEMBLE_THREADS]) {
+    nThreads = atol(omc_flagValue[FLAG_ENSEMBLE_THREADS]);
+  } else {
+#if defined(_SC_NPROCESSORS_ONLN)
+    nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  }
+  nThreads = std::max(1L, std::min(nThreads, (long) ens.nRuns));
+  infoStreamPrint(LOG_STDOUT, 0, "simulating %d ensemble runs from %s on %ld threads", ens.nRuns, fileName, nThreads);
+
+  threads.resize(nThreads);
+  for (i = 0; i < nThreads; ++i) {
+#if defined(OMC_MINIMAL_RUNTIME)
+    if (pthread_create(&threads[i], NULL, ensembleWorker, &ens)) {
+#else
+    if (GC_pthread_create(&threads[i], NULL, ensembleWorker, &ens)) {
+#endif
+      throwStreamPrint(threadData, "Failed to create ensemble thread %ld", i);
+    }
+  }
+  for (i = 0; i < nThreads; ++i) {
+#if defined(OMC_MINIMAL_RUNTIME)
+    pthread_join(threads[i], NULL);
+#else
+    GC_pthread_join(threads[i], NULL);
+#endif
+  }
+  pthread_setspecific(mmc_thread_data_key, threadData);
+
+  pthread_mutex_destroy(&ens.mutex);
+  omc_free_csv_reader(ens.variants);
+  if (ens.failedRuns) {
+    warningStreamPrint(LOG_STDOUT, 0, "%d of %d ensemble runs failed", ens.failedRuns, ens.nRuns);
+  }
+  return ens.failedRuns ? 1 : 0;
+}
+
+
 /* \brief main function for simulator
  *
  * The arguments for the main function are:
@@ -913,13 +1160,18 @@ int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *thre
     signal(SIGUSR1, SimulationRuntime_printStatus);
 #endif
 
-    retVal = startNonInteractiveSimulation(argc, argv, data, threadData);
+    if (omc_flag[FLAG_ENSEMBLE]) {
+      retVal = runEnsemble(argc, argv, data, threadData);
+    } else {
+      retVal = startNonInteractiveSimulation(argc, argv, data, threadData);
+    }
 
     freeMixedSystems(data, threadData);        /* free mixed system data */
     freeLinearSystems(data, threadData);       /* free linear system data */
     freeNonlinearSystems(data, threadData);    /* free nonlinear system data */
 
     data->callback->callExternalObjectDestructors(data, threadData);
+    freeTermination(data->simulationInfo, threadData);
     deInitializeDataStruc(data);
     fflush(NULL);
   MMC_CATCH_INTERNAL(globalJumpBuffer)
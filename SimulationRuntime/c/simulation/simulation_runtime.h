@@ -58,12 +58,12 @@ extern int initializeResultData(DATA* simData, threadData_t *threadData, int cpu
 #endif /* cplusplus */
 
 extern int modelTermination;     /* Becomes non-zero when simulation terminates. */
-extern int terminationTerminate; /* Becomes non-zero when user terminates simulation. */
 extern int terminationAssert;    /* Becomes non-zero when model call assert simulation. */
 extern int warningLevelAssert;   /* Becomes non-zero when model call assert with warning level. */
-extern FILE_INFO TermInfo;       /* message for termination. */
 
-extern char* TermMsg; /* message for termination. */
+/* terminate() of the model is recorded in the SIMULATION_INFO bound to the calling thread */
+extern void initializeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData);
+extern void freeTermination(SIMULATION_INFO *simulationInfo, threadData_t *threadData);
 
 /* defined in model code. Used to get name of variable by investigating its pointer in the state or alg vectors. */
 extern const char* getNameReal(double* ptr);
@@ -82,6 +82,9 @@ extern void communicateMsg(char id, unsigned int size, const char *data);
  */
 extern int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *threadData);
 
+/* simulates the runs of the -ensemble file, data is initialized like for a single run */
+extern int runEnsemble(int argc, char**argv, DATA *data, threadData_t *threadData);
+
 #if !defined(OMC_MINIMAL_RUNTIME)
 const char* prettyPrintNanoSec(int64_t ns, int *v);
 #endif
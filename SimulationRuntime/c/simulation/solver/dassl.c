@@ -179,6 +179,9 @@ int dassl_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
   dasslData->newdelta = (double*) malloc(N*sizeof(double));
   dasslData->stateDer = (double*) calloc(N, sizeof(double));
   dasslData->states = (double*) malloc(N*sizeof(double));
+  dasslData->jacobianThreads = 1;
+  dasslData->jacobianPool = NULL;
+  dasslData->workerBuffers = NULL;
 
   data->simulationInfo->currentContext = CONTEXT_ALGEBRAIC;
 
@@ -265,6 +268,7 @@ int dassl_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
 
   /* check if Flags FLAG_NOEQUIDISTANT_OUT_FREQ or FLAG_NOEQUIDISTANT_OUT_TIME are set */
   if (dasslData->dasslSteps){
+    dasslData->dasslStepsOutputCounter = 1;
     if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ])
     {
       dasslData->dasslStepsFreq = atoi(omc_flagValue[FLAG_NOEQUIDISTANT_OUT_FREQ]);
@@ -347,6 +351,12 @@ int dassl_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
     case COLOREDNUMJAC:
       data->simulationInfo->jacobianEvals = data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern.maxColors;
       dasslData->jacobianFunction =  JacobianOwnNumColored;
+      dasslData->jacobianThreads = getJacobianThreads(data);
+      if (dasslData->jacobianThreads > 1)
+      {
+        dasslData->workerBuffers = (double*) malloc(4*N*dasslData->jacobianThreads*sizeof(double));
+        assertStreamPrint(threadData, 0 != dasslData->workerBuffers, "out of memory");
+      }
       break;
     case COLOREDSYMJAC:
       data->simulationInfo->jacobianEvals = data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern.maxColors;
@@ -434,6 +444,8 @@ int dassl_deinitial(DASSL_DATA *dasslData)
   free(dasslData->newdelta);
   free(dasslData->states);
   free(dasslData->stateDer);
+  freeParallelJacobian(dasslData->jacobianPool);
+  free(dasslData->workerBuffers);
 
   free(dasslData);
 
@@ -503,7 +515,6 @@ int dassl_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   unsigned int ui = 0;
   int retVal = 0;
   int saveJumpState;
-  static unsigned int dasslStepsOutputCounter = 1;
 
   DASSL_DATA *dasslData = (DASSL_DATA*) solverInfo->solverData;
 
@@ -645,15 +656,15 @@ int dassl_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
     {
       if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ]){
         /* output every n-th time step */
-        if (dasslStepsOutputCounter >= dasslData->dasslStepsFreq){
-          dasslStepsOutputCounter = 1; /* next line set it to one */
+        if (dasslData->dasslStepsOutputCounter >= dasslData->dasslStepsFreq){
+          dasslData->dasslStepsOutputCounter = 1; /* next line set it to one */
           break;
         }
-        dasslStepsOutputCounter++;
+        dasslData->dasslStepsOutputCounter++;
       } else if (omc_flag[FLAG_NOEQUIDISTANT_OUT_TIME]){
         /* output when time>=k*timeValue */
-        if (solverInfo->currentTime > dasslStepsOutputCounter * dasslData->dasslStepsTime){
-          dasslStepsOutputCounter++;
+        if (solverInfo->currentTime > dasslData->dasslStepsOutputCounter * dasslData->dasslStepsTime){
+          dasslData->dasslStepsOutputCounter++;
           break;
         }
       } else {
@@ -1227,6 +1238,77 @@ static int JacobianOwnNum(double *t, double *y, double *yprime, double *deltaD,
 }
 
 
+/* arguments of jacA_numColored for the workers of -jacobianThreads */
+typedef struct DASSL_JACOBIAN_JOB
+{
+  DASSL_DATA *dasslData;
+  SPARSE_PATTERN *sparsePattern;
+  unsigned int sizeRows;
+  unsigned int sizeCols;
+  double *t, *y, *yprime, *delta, *matrixA, *cj, *h, *wt;
+  int *ipar;
+} DASSL_JACOBIAN_JOB;
+
+/*
+ *  evaluates the columns of one color on a worker of -jacobianThreads,
+ *  the columns are stored directly into the shared matrixA
+ */
+static void jacA_numColoredWorker(DATA* data, threadData_t *threadData, int worker, unsigned int color, void *userData)
+{
+  DASSL_JACOBIAN_JOB *job = (DASSL_JACOBIAN_JOB*) userData;
+  DASSL_DATA* dasslData = job->dasslData;
+  SPARSE_PATTERN *sparsePattern = job->sparsePattern;
+  const long N = dasslData->N;
+  double *buffer = dasslData->workerBuffers + 4*N*worker;
+  double *y = dasslData->daeMode ? buffer : data->localData[0]->realVars;
+  double *yprime = buffer + N;
+  double *delta_hh = buffer + 2*N;
+  double *newdelta = buffer + 3*N;
+  double delta_h = dasslData->sqrteps;
+  double delta_hhh;
+  double *rpar[3] = {(double*) data, (double*) dasslData, (double*) threadData};
+  int ires;
+  unsigned int j,l,ii;
+
+  memcpy(y, job->y, N*sizeof(double));
+  memcpy(yprime, job->yprime, N*sizeof(double));
+
+  for(ii=0; ii < job->sizeCols; ii++)
+  {
+    if(sparsePattern->colorCols[ii]-1 == color)
+    {
+      delta_hhh = *job->h * yprime[ii];
+      delta_hh[ii] = delta_h * fmax(fmax(fabs(y[ii]),fabs(delta_hhh)),fabs(1./job->wt[ii]));
+      delta_hh[ii] = (delta_hhh >= 0 ? delta_hh[ii] : -delta_hh[ii]);
+      delta_hh[ii] = y[ii] + delta_hh[ii] - y[ii];
+
+      y[ii] += delta_hh[ii];
+
+      if (dasslData->daeMode){
+        yprime[ii] += *job->cj * delta_hh[ii];
+      }
+
+      delta_hh[ii] = 1. / delta_hh[ii];
+    }
+  }
+
+  (*dasslData->residualFunction)(job->t, y, yprime, job->cj, newdelta, &ires, (double*) rpar, job->ipar);
+
+  for(ii = 0; ii < job->sizeCols; ii++)
+  {
+    if(sparsePattern->colorCols[ii]-1 == color)
+    {
+      j = (ii == 0) ? 0 : sparsePattern->leadindex[ii-1];
+      while(j < sparsePattern->leadindex[ii])
+      {
+        l  =  sparsePattern->index[j];
+        job->matrixA[l + ii*job->sizeRows] = (newdelta[l] - job->delta[l]) * delta_hh[ii];
+        j++;
+      };
+    }
+  }
+}
+
 /*
  *  function calculates a jacobian matrix by
  *  numerical method finite differences
@@ -1245,6 +1327,22 @@ int jacA_numColored(DATA* data, double *t, double *y, double *yprime, double *de
 
   unsigned int i,j,l,k,ii;
 
+  if (dasslData->jacobianThreads > 1)
+  {
+    threadData_t *threadData = (threadData_t*)(void*)((double**)rpar)[2];
+    DASSL_JACOBIAN_JOB job = {dasslData, &data->simulationInfo->analyticJacobians[index].sparsePattern,
+                              data->simulationInfo->analyticJacobians[index].sizeRows,
+                              data->simulationInfo->analyticJacobians[index].sizeCols,
+                              t, y, yprime, delta, matrixA, cj, h, wt, ipar};
+    if (!dasslData->jacobianPool)
+    {
+      dasslData->jacobianPool = allocateParallelJacobian(data, threadData, dasslData->jacobianThreads);
+    }
+    evalParallelJacobianColors(dasslData->jacobianPool, data, threadData, job.sparsePattern->maxColors, jacA_numColoredWorker, &job);
+    TRACE_POP
+    return 0;
+  }
+
   for(i = 0; i < data->simulationInfo->analyticJacobians[index].sparsePattern.maxColors; i++)
   {
     for(ii=0; ii < data->simulationInfo->analyticJacobians[index].sizeCols; ii++)
@@ -32,6 +32,7 @@
 #define DASSL_H
 
 #include "simulation/solver/solver_main.h"
+#include "simulation/solver/parallel_jacobian.h"
 
 #define DDASKR _daskr_ddaskr_
 
@@ -43,6 +44,7 @@ typedef struct DASSL_DATA{
   int dasslSteps;               /* if TRUE then dassl internal steps are used to store results */
   unsigned int dasslStepsFreq;  /* value specifies the output frequency regarding to time steps. Used in dasslSteps mode. */
   double dasslStepsTime;        /* value specifies the time increment when output happens. Used in dasslSteps mode. */
+  unsigned int dasslStepsOutputCounter; /* number of the next output in dasslSteps mode */
   int dasslRootFinding;         /* if TRUE then the internal root finding is used */
   int dasslJacobian;            /* specifices the method to calculate the jacobian matrix */
   int dasslAvoidEventRestart;   /* if TRUE then no restart after an event is performed */
@@ -75,6 +77,11 @@ typedef struct DASSL_DATA{
   double *stateDer;
   double *states;
 
+  /* parallel evaluation of the colored numerical jacobian (-jacobianThreads) */
+  int jacobianThreads;
+  PARALLEL_JACOBIAN *jacobianPool;  /* created at the first evaluation */
+  double *workerBuffers;            /* y, yprime, delta_hh and newdelta of each worker */
+
   /* function pointer of provied functions */
   int (*residualFunction)(double *t, double *x, double *xprime, double *cj, double *delta, int *ires, double *rpar, int* ipar);
   void* jacobianFunction;
@@ -93,4 +100,8 @@ dassl_initial(DATA* simData, threadData_t *threadData, SOLVER_INFO* solverInfo,
 int
 dassl_deinitial(DASSL_DATA *dasslData);
 
+/* colored numerical jacobian of the ODE residual, rpar holds data, dasslData and threadData */
+int
+jacA_numColored(DATA* data, double *t, double *y, double *yprime, double *delta, double *matrixA, double *cj, double *h, double *wt, double *rpar, int *ipar);
+
 #endif
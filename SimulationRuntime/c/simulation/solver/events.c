@@ -300,18 +300,15 @@ double findRoot(DATA* data, threadData_t *threadData, LIST *eventList)
   long event_id;
   LIST_NODE* it;
   fortran_integer i=0;
-  static LIST *tmpEventList = NULL;
+  LIST *tmpEventList = data->simulationInfo->rootEventList;
 
-  double *states_right = (double*) malloc(data->modelData->nStates * sizeof(double));
-  double *states_left = (double*) malloc(data->modelData->nStates * sizeof(double));
+  double *states_right = data->simulationInfo->rootStatesRight;
+  double *states_left = data->simulationInfo->rootStatesLeft;
 
   double time_left = data->simulationInfo->timeValueOld;
   double time_right = data->localData[0]->timeValue;
 
-  tmpEventList = allocList(sizeof(long));
-
-  assert(states_right);
-  assert(states_left);
+  listClear(tmpEventList);
 
   for(it=listFirstNode(eventList); it; it=listNextNode(it))
   {
@@ -389,9 +386,6 @@ double findRoot(DATA* data, threadData_t *threadData, LIST *eventList)
     data->localData[0]->realVars[i] = states_right[i];
   }
 
-  free(states_left);
-  free(states_right);
-
   TRACE_POP
   return eventTime;
 }
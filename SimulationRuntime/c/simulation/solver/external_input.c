@@ -43,6 +43,7 @@
 
 #include "simulation/simulation_runtime.h"
 #include "simulation/solver/solver_main.h"
+#include "simulation/solver/external_input_stream.h"
 #include "simulation/solver/model_help.h"
 #include "simulation/options.h"
 
@@ -56,6 +57,12 @@ int externalInputallocate(DATA* data)
   short useLibCsvH = 1;
   char * cflags = NULL;
 
+  data->simulationInfo->external_input.stream = NULL;
+  cflags = (char*)omc_flagValue[FLAG_INPUT_STREAM];
+  if(cflags){
+    externalInputStreamAllocate(data, cflags);
+    return 0;
+  }
 
   cflags = (char*)omc_flagValue[FLAG_INPUT_CSV];
   if(!cflags){
@@ -202,6 +209,9 @@ static inline void externalInputallocate1(DATA* data, FILE * pFile){
 
 int externalInputFree(DATA* data)
 {
+  if(data->simulationInfo->external_input.stream){
+    return externalInputStreamFree(data);
+  }
   if(data->simulationInfo->external_input.active){
     int j;
 
@@ -225,6 +235,9 @@ int externalInputUpdate(DATA* data)
   if(!data->simulationInfo->external_input.active){
     return -1;
   }
+  if(data->simulationInfo->external_input.stream){
+    return externalInputStreamUpdate(data);
+  }
 
   t = data->localData[0]->timeValue;
   t1 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i];
@@ -0,0 +1,564 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file external_input_stream.c
+ *
+ * The whole input file is never held in memory. A background thread reads
+ * and parses the file ahead of the simulation and stores the rows in one
+ * contiguous ring buffer in structure-of-arrays layout:
+ *
+ *   buffer[0*window + slot]     time of the row
+ *   buffer[(j+1)*window + slot] value of input j
+ *
+ * with slot = row % window. The producer may fill all rows that are no
+ * longer needed by the simulation (row < tail); the consumer only reads
+ * rows in [tail, head). Both counters are guarded by one mutex.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+
+#include "util/omc_error.h"
+#include "util/omc_mmap.h"
+#include "util/libcsv.h"
+#include "util/read_csv.h"
+#include "util/read_matlab4.h"
+
+#include "simulation/options.h"
+#include "simulation/solver/external_input_stream.h"
+
+#define EXTERNAL_INPUT_STREAM_DEFAULT_WINDOW 4096
+#define EXTERNAL_INPUT_STREAM_MIN_WINDOW 16
+#define EXTERNAL_INPUT_STREAM_CHUNK 65536
+
+typedef enum
+{
+  EXTERNAL_INPUT_STREAM_CSV = 0,
+  EXTERNAL_INPUT_STREAM_MAT,
+  EXTERNAL_INPUT_STREAM_RAW
+} EXTERNAL_INPUT_STREAM_FORMAT;
+
+typedef struct EXTERNAL_INPUT_STREAM
+{
+  EXTERNAL_INPUT_STREAM_FORMAT format;
+  char *filename;
+  int nu;                     /* number of model inputs */
+  size_t window;              /* number of rows in the ring buffer */
+  size_t history;             /* rows kept behind the current interval for solvers stepping back */
+  double *buffer;             /* (nu+1)*window values, see above */
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t rowsAvailable;
+  pthread_cond_t spaceAvailable;
+  size_t head;                /* rows published by the producer */
+  size_t tail;                /* oldest row still needed by the consumer */
+  int eof;
+  int stop;
+  char *error;
+
+  /* producer local */
+  size_t pending;             /* rows written to the buffer but not yet published */
+  size_t knownTail;           /* value of tail at the last publish */
+  int stopped;                /* value of stop at the last publish */
+  double *row;                /* staging row, time followed by the file columns */
+  int ncols;                  /* number of columns in the file */
+  int *column;                /* column in the file for each input; -1 if missing */
+  double *scale;              /* +1 or -1 (negated alias in MAT files); 0 if constant */
+  double *constant;           /* value used if the column is missing or a parameter */
+  int timeColumn;
+
+  /* csv */
+  FILE *file;
+  struct csv_parser parser;
+  int cell;
+  int headerDone;
+
+  /* mat and raw */
+  omc_mmap_read map;
+  size_t offset;
+  size_t nrows;
+  size_t elementSize;
+
+  /* consumer local */
+  size_t i;                   /* current interval is [i, i+1] */
+  size_t knownHead;
+  int knownEof;
+} EXTERNAL_INPUT_STREAM;
+
+#define ROW_TIME(S,K) ((S)->buffer[(K) % (S)->window])
+#define ROW_VALUE(S,K,J) ((S)->buffer[((J)+1)*(S)->window + (K) % (S)->window])
+
+static void streamSetError(EXTERNAL_INPUT_STREAM *stream, const char *msg)
+{
+  pthread_mutex_lock(&stream->mutex);
+  if (!stream->error) {
+    stream->error = strdup(msg);
+  }
+  stream->eof = 1;
+  pthread_cond_broadcast(&stream->rowsAvailable);
+  pthread_mutex_unlock(&stream->mutex);
+}
+
+/* Makes the rows written since the last call visible to the consumer and
+ * blocks while the ring buffer is full. Returns 0 if the producer should stop.
+ */
+static int streamPublish(EXTERNAL_INPUT_STREAM *stream, int wait)
+{
+  int cont;
+  pthread_mutex_lock(&stream->mutex);
+  if (stream->pending) {
+    stream->head += stream->pending;
+    stream->pending = 0;
+    pthread_cond_broadcast(&stream->rowsAvailable);
+  }
+  while (wait && !stream->stop && stream->head - stream->tail >= stream->window) {
+    pthread_cond_wait(&stream->spaceAvailable, &stream->mutex);
+  }
+  stream->knownTail = stream->tail;
+  stream->stopped = stream->stop;
+  cont = !stream->stop;
+  pthread_mutex_unlock(&stream->mutex);
+  return cont;
+}
+
+/* Copies the staging row into the ring buffer. */
+static int streamPushRow(EXTERNAL_INPUT_STREAM *stream)
+{
+  size_t slot;
+  int j;
+  /* tail only grows, so the last known value is conservative */
+  if (stream->pending >= stream->window/8 || stream->head + stream->pending - stream->knownTail >= stream->window) {
+    if (!streamPublish(stream, 1)) {
+      return 0;
+    }
+  }
+  slot = (stream->head + stream->pending) % stream->window;
+  stream->buffer[slot] = stream->row[stream->timeColumn];
+  for (j = 0; j < stream->nu; ++j) {
+    stream->buffer[(j+1)*stream->window + slot] = stream->column[j] >= 0 ? stream->scale[j]*stream->row[stream->column[j]] : stream->constant[j];
+  }
+  stream->pending++;
+  return 1;
+}
+
+/* csv: the first row is the header and is handled in externalInputStreamAllocate */
+static void streamCsvCell(void *s, size_t len, void *data)
+{
+  EXTERNAL_INPUT_STREAM *stream = (EXTERNAL_INPUT_STREAM*) data;
+  char *endptr = "";
+  if (!stream->headerDone || stream->error) {
+    return;
+  }
+  if (stream->cell < stream->ncols) {
+    stream->row[stream->cell] = s ? strtod((const char*)s, &endptr) : 0.0;
+    if (*endptr) {
+      char msg[256];
+      snprintf(msg, 256, "Found non-double data in input file: %.128s", (const char*) s);
+      streamSetError(stream, msg);
+    }
+  }
+  stream->cell++;
+}
+
+static void streamCsvRow(int c, void *data)
+{
+  EXTERNAL_INPUT_STREAM *stream = (EXTERNAL_INPUT_STREAM*) data;
+  if (!stream->headerDone) {
+    stream->headerDone = 1;
+    return;
+  }
+  if (stream->error) {
+    return;
+  }
+  if (stream->cell != stream->ncols) {
+    char msg[256];
+    snprintf(msg, 256, "Expected %d columns but found %d in row %ld of the input file", stream->ncols, stream->cell, (long) (stream->head + stream->pending + 1));
+    streamSetError(stream, msg);
+    return;
+  }
+  stream->cell = 0;
+  streamPushRow(stream);
+}
+
+static void streamReadCsv(EXTERNAL_INPUT_STREAM *stream)
+{
+  char *buf = (char*) malloc(EXTERNAL_INPUT_STREAM_CHUNK);
+  size_t len;
+  while (!stream->stopped && !stream->error && (len = fread(buf, 1, EXTERNAL_INPUT_STREAM_CHUNK, stream->file)) > 0) {
+    if (csv_parse(&stream->parser, buf, len, streamCsvCell, streamCsvRow, stream) != len) {
+      streamSetError(stream, csv_strerror(csv_error(&stream->parser)));
+    }
+  }
+  if (!stream->stopped && !stream->error) {
+    csv_fini(&stream->parser, streamCsvCell, streamCsvRow, stream);
+  }
+  free(buf);
+}
+
+/* mat and raw: row k starts at offset + k*ncols*elementSize in the mapped file */
+static void streamReadMapped(EXTERNAL_INPUT_STREAM *stream)
+{
+  size_t k;
+  int c;
+  const char *base = stream->map.data + stream->offset;
+#if HAVE_MMAP
+  posix_madvise((void*)stream->map.data, stream->map.size, POSIX_MADV_SEQUENTIAL);
+#endif
+  for (k = 0; k < stream->nrows && !stream->stopped; ++k) {
+    const char *p = base + k*stream->ncols*stream->elementSize;
+    if (stream->elementSize == sizeof(double)) {
+      memcpy(stream->row, p, stream->ncols*sizeof(double));
+    } else {
+      for (c = 0; c < stream->ncols; ++c) {
+        float f;
+        memcpy(&f, p + c*sizeof(float), sizeof(float));
+        stream->row[c] = f;
+      }
+    }
+    if (!streamPushRow(stream)) {
+      return;
+    }
+  }
+}
+
+static void* streamProducer(void *arg)
+{
+  EXTERNAL_INPUT_STREAM *stream = (EXTERNAL_INPUT_STREAM*) arg;
+  if (stream->format == EXTERNAL_INPUT_STREAM_CSV) {
+    streamReadCsv(stream);
+  } else {
+    streamReadMapped(stream);
+  }
+  pthread_mutex_lock(&stream->mutex);
+  stream->head += stream->pending;
+  stream->pending = 0;
+  stream->eof = 1;
+  pthread_cond_broadcast(&stream->rowsAvailable);
+  pthread_mutex_unlock(&stream->mutex);
+  return NULL;
+}
+
+/* Waits until row k has been read or the end of the file is reached.
+ * Returns 1 if row k is available.
+ */
+static int streamEnsureRow(EXTERNAL_INPUT_STREAM *stream, size_t k)
+{
+  if (k < stream->knownHead) {
+    return 1;
+  }
+  if (stream->knownEof) {
+    return 0;
+  }
+  pthread_mutex_lock(&stream->mutex);
+  while (k >= stream->head && !stream->eof) {
+    pthread_cond_wait(&stream->rowsAvailable, &stream->mutex);
+  }
+  stream->knownHead = stream->head;
+  stream->knownEof = stream->eof;
+  pthread_mutex_unlock(&stream->mutex);
+  if (stream->error) {
+    throwStreamPrint(NULL, "Failed to read input file %s: %s", stream->filename, stream->error);
+  }
+  return k < stream->knownHead;
+}
+
+/* Releases rows that are more than history rows behind the current interval. */
+static void streamRelease(EXTERNAL_INPUT_STREAM *stream)
+{
+  size_t tail = stream->i > stream->history ? stream->i - stream->history : 0;
+  if (tail >= stream->tail + stream->window/8) {
+    pthread_mutex_lock(&stream->mutex);
+    stream->tail = tail;
+    pthread_cond_signal(&stream->spaceAvailable);
+    pthread_mutex_unlock(&stream->mutex);
+  }
+}
+
+static int streamColumnIndex(char **names, int n, const char *name)
+{
+  int i;
+  for (i = 0; i < n; ++i) {
+    if (0 == strcmp(names[i], name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void streamOpenCsv(EXTERNAL_INPUT_STREAM *stream, const char **inputNames)
+{
+  char **header;
+  int ncols = 0, j;
+  stream->file = fopen(stream->filename, "r");
+  if (!stream->file) {
+    throwStreamPrint(NULL, "Failed to open input file %s", stream->filename);
+  }
+  header = read_csv_variables(stream->file, &ncols);
+  if (!header) {
+    fclose(stream->file);
+    throwStreamPrint(NULL, "Failed to read the header of input file %s", stream->filename);
+  }
+  stream->ncols = ncols + 1;
+  stream->timeColumn = 0;
+  for (j = 0; j < stream->nu; ++j) {
+    stream->column[j] = streamColumnIndex(header, stream->ncols, inputNames[j]);
+    stream->scale[j] = 1.0;
+  }
+  for (j = 0; j < stream->ncols; ++j) {
+    free(header[j]);
+  }
+  free(header);
+  fseek(stream->file, 0, SEEK_SET);
+  csv_init(&stream->parser, CSV_STRICT | CSV_REPALL_NL | CSV_STRICT_FINI | CSV_APPEND_NULL | CSV_EMPTY_IS_NULL);
+  csv_set_realloc_func(&stream->parser, realloc);
+  csv_set_free_func(&stream->parser, free);
+}
+
+static void streamOpenMat(EXTERNAL_INPUT_STREAM *stream, const char **inputNames)
+{
+  ModelicaMatReader reader;
+  ModelicaMatVariable_t *var;
+  const char *msg;
+  int j;
+  if (0 != (msg = omc_new_matlab4_reader(stream->filename, &reader))) {
+    throwStreamPrint(NULL, "Failed to open input file %s: %s", stream->filename, msg);
+  }
+  var = omc_matlab4_find_var(&reader, "time");
+  if (!var || var->isParam) {
+    omc_free_matlab4_reader(&reader);
+    throwStreamPrint(NULL, "Input file %s does not contain a time trajectory", stream->filename);
+  }
+  stream->timeColumn = abs(var->index) - 1;
+  for (j = 0; j < stream->nu; ++j) {
+    var = omc_matlab4_find_var(&reader, inputNames[j]);
+    stream->scale[j] = 1.0;
+    if (!var) {
+      continue;
+    }
+    if (var->isParam) {
+      omc_matlab4_val(&stream->constant[j], &reader, var, omc_matlab4_startTime(&reader));
+      stream->scale[j] = 0.0;
+    } else {
+      stream->column[j] = abs(var->index) - 1;
+      stream->scale[j] = var->index < 0 ? -1.0 : 1.0;
+    }
+  }
+  stream->ncols = reader.nvar;
+  stream->nrows = reader.nrows;
+  stream->offset = reader.var_offset;
+  stream->elementSize = reader.doublePrecision == 1 ? sizeof(double) : sizeof(float);
+  omc_free_matlab4_reader(&reader);
+  stream->map = omc_mmap_open_read(stream->filename);
+  if (stream->offset + stream->nrows*stream->ncols*stream->elementSize > stream->map.size) {
+    omc_mmap_close_read(stream->map);
+    throwStreamPrint(NULL, "Input file %s is truncated", stream->filename);
+  }
+}
+
+static void streamOpenRaw(EXTERNAL_INPUT_STREAM *stream)
+{
+  int j;
+  stream->map = omc_mmap_open_read(stream->filename);
+  stream->ncols = stream->nu + 1;
+  stream->timeColumn = 0;
+  stream->offset = 0;
+  stream->elementSize = sizeof(double);
+  stream->nrows = stream->map.size / (stream->ncols*sizeof(double));
+  for (j = 0; j < stream->nu; ++j) {
+    stream->column[j] = j + 1;
+    stream->scale[j] = 1.0;
+  }
+}
+
+int externalInputStreamAllocate(DATA* data, const char *filename)
+{
+  EXTERNAL_INPUT_STREAM *stream = (EXTERNAL_INPUT_STREAM*) calloc(1, sizeof(EXTERNAL_INPUT_STREAM));
+  const int nu = data->modelData->nInputVars;
+  const char **inputNames = (const char**) malloc(modelica_integer_max(1,nu)*sizeof(char*));
+  const char *ext = strrchr(filename, '.');
+  const char *flag = omc_flagValue[FLAG_INPUT_STREAM_WINDOW];
+  int j;
+
+  stream->filename = strdup(filename);
+  stream->nu = nu;
+  stream->window = flag ? (size_t) atol(flag) : EXTERNAL_INPUT_STREAM_DEFAULT_WINDOW;
+  if (stream->window < EXTERNAL_INPUT_STREAM_MIN_WINDOW) {
+    warningStreamPrint(LOG_STDOUT, 0, "-inputStreamWindow=%s is too small, using %d rows.", flag, EXTERNAL_INPUT_STREAM_MIN_WINDOW);
+    stream->window = EXTERNAL_INPUT_STREAM_MIN_WINDOW;
+  }
+  stream->history = stream->window/4;
+  stream->column = (int*) malloc(modelica_integer_max(1,nu)*sizeof(int));
+  stream->scale = (double*) malloc(modelica_integer_max(1,nu)*sizeof(double));
+  stream->constant = (double*) calloc(modelica_integer_max(1,nu), sizeof(double));
+  for (j = 0; j < nu; ++j) {
+    stream->column[j] = -1;
+  }
+  data->callback->inputNames(data, (char**) inputNames);
+
+  if (ext && 0 == strcmp(ext, ".mat")) {
+    stream->format = EXTERNAL_INPUT_STREAM_MAT;
+    streamOpenMat(stream, inputNames);
+  } else if (ext && (0 == strcmp(ext, ".bin") || 0 == strcmp(ext, ".raw"))) {
+    stream->format = EXTERNAL_INPUT_STREAM_RAW;
+    streamOpenRaw(stream);
+  } else {
+    stream->format = EXTERNAL_INPUT_STREAM_CSV;
+    streamOpenCsv(stream, inputNames);
+  }
+
+  for (j = 0; j < nu; ++j) {
+    if (stream->column[j] < 0 && stream->scale[j] != 0.0) {
+      warningStreamPrint(LOG_STDOUT, 0, "Input %s not found in %s, using %g.", inputNames[j], filename, stream->constant[j]);
+    }
+  }
+  free(inputNames);
+
+  stream->row = (double*) calloc(stream->ncols, sizeof(double));
+  stream->buffer = (double*) malloc((nu+1)*stream->window*sizeof(double));
+  pthread_mutex_init(&stream->mutex, NULL);
+  pthread_cond_init(&stream->rowsAvailable, NULL);
+  pthread_cond_init(&stream->spaceAvailable, NULL);
+  if (pthread_create(&stream->thread, NULL, streamProducer, stream)) {
+    throwStreamPrint(NULL, "Failed to start the input reader thread for %s", filename);
+  }
+
+  data->simulationInfo->external_input.stream = stream;
+  data->simulationInfo->external_input.u = NULL;
+  data->simulationInfo->external_input.t = NULL;
+  data->simulationInfo->external_input.n = 0;
+  data->simulationInfo->external_input.N = 0;
+  data->simulationInfo->external_input.i = 0;
+
+  if (!streamEnsureRow(stream, 1)) {
+    externalInputStreamFree(data);
+    warningStreamPrint(LOG_STDOUT, 0, "Input file %s contains less than two rows and is ignored.", filename);
+    return 1;
+  }
+  data->simulationInfo->external_input.active = 1;
+  infoStreamPrint(LOG_SIMULATION, 0, "Streaming %d inputs from %s using a window of %ld rows.", nu, filename, (long) stream->window);
+  return 0;
+}
+
+int externalInputStreamFree(DATA* data)
+{
+  EXTERNAL_INPUT_STREAM *stream = data->simulationInfo->external_input.stream;
+  if (!stream) {
+    return 0;
+  }
+  pthread_mutex_lock(&stream->mutex);
+  stream->stop = 1;
+  pthread_cond_broadcast(&stream->spaceAvailable);
+  pthread_mutex_unlock(&stream->mutex);
+  pthread_join(stream->thread, NULL);
+  pthread_mutex_destroy(&stream->mutex);
+  pthread_cond_destroy(&stream->rowsAvailable);
+  pthread_cond_destroy(&stream->spaceAvailable);
+
+  if (stream->format == EXTERNAL_INPUT_STREAM_CSV) {
+    csv_free(&stream->parser);
+    fclose(stream->file);
+  } else {
+    omc_mmap_close_read(stream->map);
+  }
+  free(stream->buffer);
+  free(stream->row);
+  free(stream->column);
+  free(stream->scale);
+  free(stream->constant);
+  free(stream->error);
+  free(stream->filename);
+  free(stream);
+  data->simulationInfo->external_input.stream = NULL;
+  data->simulationInfo->external_input.active = 0;
+  return 0;
+}
+
+/* Same interpolation as externalInputUpdate, but on the ring buffer. */
+int externalInputStreamUpdate(DATA* data)
+{
+  EXTERNAL_INPUT_STREAM *stream = data->simulationInfo->external_input.stream;
+  const int nu = data->modelData->nInputVars;
+  double t, t1, t2, u1, u2;
+  long double dt;
+  int j;
+
+  t = data->localData[0]->timeValue;
+  t1 = ROW_TIME(stream, stream->i);
+  t2 = ROW_TIME(stream, stream->i+1);
+
+  while (stream->i > stream->tail && t < t1) {
+    --stream->i;
+    t1 = ROW_TIME(stream, stream->i);
+    t2 = ROW_TIME(stream, stream->i+1);
+  }
+  if (t < t1 && stream->i > 0) {
+    warningStreamPrint(LOG_SOLVER, 0, "Input at time %g is outside the window kept by -inputStream, using time %g.", t, t1);
+  }
+
+  /* rows are released while advancing, the reader blocks on a full window */
+  while (t > t2 && streamEnsureRow(stream, stream->i+2)) {
+    ++stream->i;
+    t1 = t2;
+    t2 = ROW_TIME(stream, stream->i+1);
+    streamRelease(stream);
+  }
+  data->simulationInfo->external_input.i = stream->i;
+
+  if (t == t1) {
+    for (j = 0; j < nu; ++j) {
+      data->simulationInfo->inputVars[j] = ROW_VALUE(stream, stream->i, j);
+    }
+    return 1;
+  } else if (t == t2) {
+    for (j = 0; j < nu; ++j) {
+      data->simulationInfo->inputVars[j] = ROW_VALUE(stream, stream->i+1, j);
+    }
+    return 1;
+  }
+
+  dt = t2 - t1;
+  for (j = 0; j < nu; ++j) {
+    u1 = ROW_VALUE(stream, stream->i, j);
+    u2 = ROW_VALUE(stream, stream->i+1, j);
+    if (u1 != u2) {
+      data->simulationInfo->inputVars[j] = (u1*(dt+t1-t)+(t-t1)*u2)/dt;
+    } else {
+      data->simulationInfo->inputVars[j] = u1;
+    }
+  }
+  return 0;
+}
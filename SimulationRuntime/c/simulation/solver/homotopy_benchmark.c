@@ -0,0 +1,246 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Benchmark of the nonlinear solvers on the homotopy-based initialization of
+ * a pipe network with n pressures (default n = 5000): a chain of pipes from
+ * a source with p = 10 to a sink with p = 1, every node has a leakage
+ * 0.01*(p[i] - 1) to the ambient. The mass balances
+ *
+ *   m(p[i-1] - p[i]) - m(p[i] - p[i+1]) - 0.01*(p[i] - 1) = 0
+ *
+ * use m(dp) = homotopy(dp/(dp^2 + 1e-4)^0.25, dp) for the turbulent flow
+ * with the laminar flow as simplified model, like the pipes of
+ * Modelica.Fluid. The system is solved for lambda = 0, 0.1, .., 1 like the
+ * initialization with -ils=11, each solution is the start value of the next
+ * step and the first step starts from p = 0. The Jacobian is tridiagonal and
+ * colored with three colors. The table compares
+ *
+ *   - homotopy: -nls=homotopy, the sparse variant with KLU
+ *   - mixed:    -nls=mixed, the sparse homotopy with the dense hybrd as
+ *               fallback, which is only allocated if the homotopy fails
+ *   - newton:   -nls=newton, the sparse damped Newton solver
+ *   - dense:    -nls=homotopy -nlssMinSize=n+1, the dense homotopy solver,
+ *               only run up to 1000 equations
+ *
+ * and shows whether all steps were solved, the residual and Jacobian column
+ * evaluations, the time and the largest residual of the final solution.
+ *
+ * Build with "make homotopy-benchmark" in SimulationRuntime/c, after the
+ * runtime libraries are built with UMFPACK; run it as
+ * "./homotopy-benchmark [n]".
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "simulation/options.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/test/test_model.h"
+#include "meta/meta_modelica.h"
+
+#define LAMBDA_STEPS 11
+#define MAX_DENSE 1000
+
+static int n;
+static long nResiduals, nJacobians;
+
+/* pressure at node i = -1..n, the source and the sink are fixed */
+static double pressure(const double *p, int i)
+{
+  return i < 0 ? 10.0 : (i >= n ? 1.0 : p[i]);
+}
+
+/* flow through the pipe from node i-1 to node i and its derivative by dp */
+static double flow(double lambda, double dp)
+{
+  return lambda*dp/pow(dp*dp + 1e-4, 0.25) + (1.0 - lambda)*dp;
+}
+
+static double flowDer(double lambda, double dp)
+{
+  return lambda*(0.5*dp*dp + 1e-4)/pow(dp*dp + 1e-4, 1.25) + (1.0 - lambda);
+}
+
+/* the iteration variables are stored in the states of the test model, the
+ * jacobian column is evaluated at the last residual call like in the
+ * generated code */
+static void residual(void **dataIn, const double *pIn, double *res, const int *iflag)
+{
+  DATA *data = (DATA*) dataIn[0];
+  double *p = data->localData[0]->realVars, lambda = data->simulationInfo->lambda;
+  int i;
+
+  memcpy(p, pIn, n*sizeof(double));
+  for (i = 0; i < n; i++) {
+    res[i] = flow(lambda, pressure(p, i-1) - p[i]) - flow(lambda, p[i] - pressure(p, i+1)) - 0.01*(p[i] - 1.0);
+  }
+  nResiduals++;
+}
+
+static int jacobianColumn(void *inData, threadData_t *threadData)
+{
+  DATA *data = (DATA*) inData;
+  ANALYTIC_JACOBIAN *jacobian = &data->simulationInfo->analyticJacobians[0];
+  const double *p = data->localData[0]->realVars, *seed = jacobian->seedVars;
+  double lambda = data->simulationInfo->lambda, dIn, dOut;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    dIn = flowDer(lambda, pressure(p, i-1) - p[i]);
+    dOut = flowDer(lambda, p[i] - pressure(p, i+1));
+    jacobian->resultVars[i] = -(dIn + dOut + 0.01)*seed[i] + (i > 0 ? dIn*seed[i-1] : 0.0) + (i < n-1 ? dOut*seed[i+1] : 0.0);
+  }
+  nJacobians++;
+  return 0;
+}
+
+static int initialJacobian(void *inData, threadData_t *threadData)
+{
+  DATA *data = (DATA*) inData;
+  ANALYTIC_JACOBIAN *jacobian = &data->simulationInfo->analyticJacobians[0];
+
+  jacobian->seedVars = (modelica_real*) calloc(n, sizeof(modelica_real));
+  jacobian->resultVars = (modelica_real*) calloc(n, sizeof(modelica_real));
+  return 0;
+}
+
+static void initializeStaticData(void *inData, threadData_t *threadData, void *sysData)
+{
+  NONLINEAR_SYSTEM_DATA *nls = (NONLINEAR_SYSTEM_DATA*) sysData;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    nls->nominal[i] = 1.0;
+    nls->min[i] = -DBL_MAX;
+    nls->max[i] = DBL_MAX;
+    nls->nlsxOld[i] = 0.0;
+    nls->nlsxExtrapolation[i] = 0.0;
+  }
+}
+
+static void getIterationVars(DATA *data, double *x)
+{
+  memcpy(x, data->localData[0]->realVars, n*sizeof(double));
+}
+
+static int noFunction(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static void run(const char *name, int nlsMethod, int sparse)
+{
+  static EQUATION_INFO equationInfo;
+  TEST_MODEL model;
+  NONLINEAR_SYSTEM_DATA nls;
+  double t, maxResidual = 0.0, *res;
+  void *dataAndThreadData[2];
+  int i, k, success;
+
+  initTestModel(&model, n, noFunction, 0.0, 1.0, 1e-6);
+  setTestModelBandPattern(&model, 1, 1);
+  memset(&nls, 0, sizeof(NONLINEAR_SYSTEM_DATA));
+  nls.size = n;
+  nls.jacobianIndex = 0;
+  nls.residualFunc = residual;
+  nls.analyticalJacobianColumn = jacobianColumn;
+  nls.initialAnalyticalJacobian = initialJacobian;
+  nls.initializeStaticNLSData = initializeStaticData;
+  nls.getIterationVars = getIterationVars;
+  model.modelData.nNonLinearSystems = 1;
+  /* the failure message of the solver lists the variables of the equation */
+  model.modelData.modelDataXml.equationInfo = &equationInfo;
+  model.simulationInfo.nonlinearSystemData = &nls;
+  model.simulationInfo.nlsMethod = nlsMethod;
+  model.simulationInfo.initial = 1;
+  nonlinearSparseSolverMaxDensity = 1.0;
+  nonlinearSparseSolverMinSize = sparse ? 1 : n+1;
+  nResiduals = 0;
+  nJacobians = 0;
+
+  t = now();
+  initializeNonlinearSystems(&model.data, &model.threadData);
+  for (k = 0, success = 1; k < LAMBDA_STEPS && success; k++) {
+    model.simulationInfo.lambda = k/(LAMBDA_STEPS - 1.0);
+    success = 0 == solve_nonlinear_system(&model.data, &model.threadData, 0);
+  }
+  t = now() - t;
+
+  res = (double*) malloc(n*sizeof(double));
+  dataAndThreadData[0] = &model.data;
+  dataAndThreadData[1] = &model.threadData;
+  residual(dataAndThreadData, nls.nlsx, res, NULL);
+  for (i = 0; i < n; i++) {
+    maxResidual = fmax(maxResidual, fabs(res[i]));
+  }
+  printf("%-10s %8s %10ld %10ld %10.3f %12.3e\n", name, success ? "yes" : "no", nResiduals-1, nJacobians, t, maxResidual);
+
+  free(res);
+  freeNonlinearSystems(&model.data, &model.threadData);
+  free(model.jacobian.seedVars);
+  free(model.jacobian.resultVars);
+  freeTestModel(&model);
+}
+
+int main(int argc, char **argv)
+{
+  n = argc > 1 ? atoi(argv[1]) : 5000;
+  if (n < 2) {
+    fprintf(stderr, "usage: %s [number of equations >= 2]\n", argv[0]);
+    return 1;
+  }
+
+  mmc_init_nogc();
+
+  printf("pipe network with %d pressures, %d homotopy steps\n", n, LAMBDA_STEPS);
+  printf("%-10s %8s %10s %10s %10s %12s\n", "solver", "solved", "residuals", "jac colors", "time [s]", "max residual");
+  run("homotopy", NLS_HOMOTOPY, 1);
+  run("mixed", NLS_MIXED, 1);
+  run("newton", NLS_NEWTON, 1);
+  if (n <= MAX_DENSE) {
+    run("dense", NLS_HOMOTOPY, 0);
+  } else {
+    printf("%-10s skipped, more than %d equations\n", "dense", MAX_DENSE);
+  }
+  return 0;
+}
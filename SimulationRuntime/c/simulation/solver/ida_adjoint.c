@@ -0,0 +1,723 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2016, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_adjoint.c
+ *
+ *  Adjoint sensitivity analysis with IDAS.
+ *
+ *  The forward integration of ida_solver.c is checkpointed with IDASolveF.
+ *  For every objective G a backward problem is solved from the stop time T
+ *  to the start time t0:
+ *
+ *    nu' = -J^T nu - gy^T,                  nu(T) = Gy^T
+ *    dG/dp = Gp + int_t0^T (gp + nu^T fp) dt
+ *    dG/dx(t0) = nu(t0)
+ *
+ *  with J = df/dx. For final(z) the objective is G = z(T) and g = 0, for
+ *  integral(z) it is G = int z dt with g = z and nu(T) = 0. J is taken from
+ *  the generated jacobian A if a symbolic jacobian is selected, otherwise
+ *  it is approximated by (colored) finite differences. df/dp is approximated
+ *  by finite differences, since there is no generated parameter jacobian.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "omc_config.h"
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+
+#include "util/omc_error.h"
+#include "simulation/options.h"
+#include "simulation/solver/ida_solver.h"
+#include "simulation/solver/ida_adjoint.h"
+
+#ifdef WITH_SUNDIALS
+
+#include <sundials/sundials_nvector.h>
+#include <nvector/nvector_serial.h>
+#include <idas/idas.h>
+#include <idas/idas_dense.h>
+
+/* number of steps between two checkpoints of the forward integration */
+#define IDA_ADJOINT_CHECKPOINT_STEPS 100
+
+/*! \fn splitList
+ *
+ *  Splits a comma-separated list in place; commas inside brackets or
+ *  parentheses belong to the element (e.g. final(x[1,2])).
+ *  Returns the number of elements.
+ */
+static int splitList(char *list, char ***elements)
+{
+  int n = 1, depth = 0, k = 0;
+  char *c;
+
+  for(c = list; *c; ++c) {
+    if(*c == '(' || *c == '[') depth++;
+    else if(*c == ')' || *c == ']') depth--;
+    else if(*c == ',' && depth == 0) n++;
+  }
+
+  *elements = (char**) malloc(n*sizeof(char*));
+  (*elements)[k++] = list;
+  depth = 0;
+  for(c = list; *c; ++c) {
+    if(*c == '(' || *c == '[') depth++;
+    else if(*c == ')' || *c == ']') depth--;
+    else if(*c == ',' && depth == 0) {
+      *c = '\0';
+      (*elements)[k++] = c+1;
+    }
+  }
+  return n;
+}
+
+static long findRealVariable(DATA *data, const char *name)
+{
+  long i;
+  for(i=0; i<data->modelData->nVariablesReal; ++i) {
+    if(0 == strcmp(data->modelData->realVarsData[i].info.name, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static long findRealParameter(DATA *data, const char *name)
+{
+  long i;
+  for(i=0; i<data->modelData->nParametersReal; ++i) {
+    if(0 == strcmp(data->modelData->realParameterData[i].info.name, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void parseObjective(IDA_ADJOINT *adjoint, threadData_t *threadData, IDA_ADJOINT_OBJECTIVE *objective, const char *spec)
+{
+  const char *open = strchr(spec, '(');
+  size_t len = strlen(spec);
+  char *name;
+
+  if(!open || spec[len-1] != ')') {
+    throwStreamPrint(threadData, "##IDA## invalid objective %s for -idaAdjoint, expected final(name) or integral(name)", spec);
+  }
+
+  if(0 == strncmp(spec, "final(", 6)) {
+    objective->kind = IDA_ADJOINT_FINAL;
+  } else if(0 == strncmp(spec, "integral(", 9)) {
+    objective->kind = IDA_ADJOINT_INTEGRAL;
+  } else {
+    throwStreamPrint(threadData, "##IDA## invalid objective %s for -idaAdjoint, expected final(name) or integral(name)", spec);
+  }
+
+  name = strdup(open+1);
+  name[strlen(name)-1] = '\0';
+  objective->index = findRealVariable(adjoint->data, name);
+  if(objective->index < 0) {
+    throwStreamPrint(threadData, "##IDA## unknown real variable %s in objective %s", name, spec);
+  }
+  free(name);
+
+  objective->name = strdup(spec);
+  objective->gy = (double*) calloc(adjoint->N, sizeof(double));
+  objective->gyValid = 0;
+
+  if(objective->index >= 2*adjoint->N) {
+    adjoint->needAlgebraics = 1;
+  }
+}
+
+/*! \fn ida_adjoint_allocate
+ *
+ *  Parses -idaAdjoint and -idaAdjointParams and enables the checkpointing of
+ *  the forward integration. pattern is the sparse pattern of jacobian A if it
+ *  is initialized, otherwise NULL.
+ */
+IDA_ADJOINT* ida_adjoint_allocate(DATA *data, threadData_t *threadData, void *ida_mem, SPARSE_PATTERN *pattern, int useSymbolicJacobian)
+{
+  IDA_ADJOINT *adjoint = (IDA_ADJOINT*) calloc(1, sizeof(IDA_ADJOINT));
+  char *list, **elements;
+  long i;
+  int flag;
+
+  adjoint->data = data;
+  adjoint->threadData = threadData;
+  adjoint->N = data->modelData->nStates;
+  adjoint->valid = 1;
+  adjoint->pattern = pattern;
+  adjoint->useSymbolicJacobian = useSymbolicJacobian && pattern;
+
+  /* objectives */
+  list = strdup(omc_flagValue[FLAG_IDA_ADJOINT]);
+  adjoint->nObjectives = splitList(list, &elements);
+  adjoint->objectives = (IDA_ADJOINT_OBJECTIVE*) calloc(adjoint->nObjectives, sizeof(IDA_ADJOINT_OBJECTIVE));
+  adjoint->problems = (IDA_ADJOINT_PROBLEM*) calloc(adjoint->nObjectives, sizeof(IDA_ADJOINT_PROBLEM));
+  for(i=0; i<adjoint->nObjectives; ++i) {
+    parseObjective(adjoint, threadData, &adjoint->objectives[i], elements[i]);
+    adjoint->problems[i].adjoint = adjoint;
+    adjoint->problems[i].objective = &adjoint->objectives[i];
+  }
+  free(elements);
+  free(list);
+
+  /* parameters */
+  if(omc_flag[FLAG_IDA_ADJOINT_PARAMS]) {
+    list = strdup(omc_flagValue[FLAG_IDA_ADJOINT_PARAMS]);
+    adjoint->Np = splitList(list, &elements);
+    adjoint->paramIndex = (long*) malloc(adjoint->Np*sizeof(long));
+    for(i=0; i<adjoint->Np; ++i) {
+      adjoint->paramIndex[i] = findRealParameter(data, elements[i]);
+      if(adjoint->paramIndex[i] < 0) {
+        throwStreamPrint(threadData, "##IDA## unknown real parameter %s in -idaAdjointParams", elements[i]);
+      }
+    }
+    free(elements);
+    free(list);
+  } else {
+    adjoint->Np = data->modelData->nParametersReal;
+    adjoint->paramIndex = (long*) malloc(adjoint->Np*sizeof(long));
+    for(i=0; i<adjoint->Np; ++i) {
+      adjoint->paramIndex[i] = i;
+    }
+  }
+
+  adjoint->states = (double*) malloc(adjoint->N*sizeof(double));
+  adjoint->realVars = (double*) malloc(data->modelData->nVariablesReal*sizeof(double));
+  adjoint->jac = (double*) calloc(adjoint->N*adjoint->N, sizeof(double));
+  adjoint->fp = (double*) calloc(adjoint->N*adjoint->Np, sizeof(double));
+  adjoint->gp = (double*) calloc(adjoint->nObjectives*adjoint->Np, sizeof(double));
+  adjoint->delta = (double*) malloc(adjoint->N*sizeof(double));
+
+  flag = IDAAdjInit(ida_mem, IDA_ADJOINT_CHECKPOINT_STEPS, IDA_HERMITE);
+  if (checkIDAflag(flag)){
+    throwStreamPrint(threadData, "##IDA## IDAAdjInit failed!");
+  }
+
+  infoStreamPrint(LOG_SOLVER, 0, "ida adjoint sensitivities: %d objective(s), %d parameter(s), jacobian %s", adjoint->nObjectives, adjoint->Np,
+      adjoint->useSymbolicJacobian ? "symbolic" : (pattern ? "colored numerical" : "numerical"));
+
+  return adjoint;
+}
+
+void ida_adjoint_free(IDA_ADJOINT *adjoint)
+{
+  int i;
+
+  for(i=0; i<adjoint->nObjectives; ++i) {
+    free(adjoint->objectives[i].name);
+    free(adjoint->objectives[i].gy);
+  }
+  free(adjoint->objectives);
+  free(adjoint->problems);
+  free(adjoint->paramIndex);
+  free(adjoint->states);
+  free(adjoint->realVars);
+  free(adjoint->jac);
+  free(adjoint->fp);
+  free(adjoint->gp);
+  free(adjoint->delta);
+  free(adjoint);
+}
+
+/* evaluates the model at the states of the current point */
+static void evaluateModel(IDA_ADJOINT *adjoint)
+{
+  DATA *data = adjoint->data;
+
+  data->callback->functionODE(data, adjoint->threadData);
+  if(adjoint->needAlgebraics) {
+    data->callback->functionAlgebraics(data, adjoint->threadData);
+  }
+}
+
+/* restores all real variables of the current point */
+static void restorePoint(IDA_ADJOINT *adjoint)
+{
+  memcpy(adjoint->data->localData[0]->realVars, adjoint->realVars, adjoint->data->modelData->nVariablesReal*sizeof(double));
+}
+
+static double perturbation(double x)
+{
+  return sqrt(DBL_EPSILON) * fmax(fabs(x), 1.0);
+}
+
+/*! \fn evaluateJacobian
+ *
+ *  Dense column-major df/dx at the current point, from the generated
+ *  jacobian A or by finite differences.
+ */
+static void evaluateJacobian(IDA_ADJOINT *adjoint)
+{
+  DATA *data = adjoint->data;
+  SPARSE_PATTERN *pattern = adjoint->pattern;
+  double *x = data->localData[0]->realVars;
+  double *xdot = x + adjoint->N;
+  const double *f0 = adjoint->realVars + adjoint->N;
+  long i, ii, j, l;
+
+  memset(adjoint->jac, 0, adjoint->N*adjoint->N*sizeof(double));
+
+  if(!pattern) {
+    for(i=0; i<adjoint->N; ++i) {
+      double delta = perturbation(x[i]);
+      x[i] += delta;
+      data->callback->functionODE(data, adjoint->threadData);
+      for(l=0; l<adjoint->N; ++l) {
+        adjoint->jac[i*adjoint->N + l] = (xdot[l] - f0[l]) / delta;
+      }
+      x[i] = adjoint->states[i];
+    }
+    restorePoint(adjoint);
+    return;
+  }
+
+  for(i=0; i<pattern->maxColors; ++i) {
+    if(adjoint->useSymbolicJacobian) {
+      ANALYTIC_JACOBIAN *jacA = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A];
+      for(ii=0; ii<adjoint->N; ++ii) {
+        if(pattern->colorCols[ii]-1 == i) jacA->seedVars[ii] = 1.0;
+      }
+      data->callback->functionJacA_column(data, adjoint->threadData);
+      for(ii=0; ii<adjoint->N; ++ii) {
+        if(pattern->colorCols[ii]-1 == i) {
+          for(j = (ii == 0 ? 0 : pattern->leadindex[ii-1]); j < pattern->leadindex[ii]; ++j) {
+            l = pattern->index[j];
+            adjoint->jac[ii*adjoint->N + l] = jacA->resultVars[l];
+          }
+          jacA->seedVars[ii] = 0.0;
+        }
+      }
+    } else {
+      for(ii=0; ii<adjoint->N; ++ii) {
+        if(pattern->colorCols[ii]-1 == i) {
+          adjoint->delta[ii] = perturbation(x[ii]);
+          x[ii] += adjoint->delta[ii];
+        }
+      }
+      data->callback->functionODE(data, adjoint->threadData);
+      for(ii=0; ii<adjoint->N; ++ii) {
+        if(pattern->colorCols[ii]-1 == i) {
+          for(j = (ii == 0 ? 0 : pattern->leadindex[ii-1]); j < pattern->leadindex[ii]; ++j) {
+            l = pattern->index[j];
+            adjoint->jac[ii*adjoint->N + l] = (xdot[l] - f0[l]) / adjoint->delta[ii];
+          }
+          x[ii] = adjoint->states[ii];
+        }
+      }
+    }
+  }
+  restorePoint(adjoint);
+}
+
+/*! \fn evaluatePoint
+ *
+ *  Sets the model to (t, x) and computes df/dx there. Consecutive calls at
+ *  the same point, e.g. from the residual, the jacobian and the quadrature
+ *  of the backward problems, reuse the results.
+ */
+static void evaluatePoint(IDA_ADJOINT *adjoint, double t, const double *x)
+{
+  DATA *data = adjoint->data;
+  int i;
+
+  if(adjoint->pointValid && t == adjoint->time && 0 == memcmp(x, adjoint->states, adjoint->N*sizeof(double))) {
+    return;
+  }
+
+  adjoint->time = t;
+  memcpy(adjoint->states, x, adjoint->N*sizeof(double));
+  data->localData[0]->timeValue = t;
+  memcpy(data->localData[0]->realVars, x, adjoint->N*sizeof(double));
+  evaluateModel(adjoint);
+  memcpy(adjoint->realVars, data->localData[0]->realVars, data->modelData->nVariablesReal*sizeof(double));
+
+  evaluateJacobian(adjoint);
+
+  adjoint->pointValid = 1;
+  adjoint->fpValid = 0;
+  for(i=0; i<adjoint->nObjectives; ++i) {
+    adjoint->objectives[i].gyValid = 0;
+  }
+}
+
+/*! \fn objectiveGradient
+ *
+ *  Derivative of the objective variable w.r.t. the states at the current
+ *  point: a unit vector for states, a row of df/dx for state derivatives
+ *  and finite differences otherwise.
+ */
+static const double* objectiveGradient(IDA_ADJOINT *adjoint, IDA_ADJOINT_OBJECTIVE *objective)
+{
+  DATA *data = adjoint->data;
+  double *x = data->localData[0]->realVars;
+  long i, k = objective->index;
+
+  if(objective->gyValid) {
+    return objective->gy;
+  }
+
+  if(k < adjoint->N) {
+    memset(objective->gy, 0, adjoint->N*sizeof(double));
+    objective->gy[k] = 1.0;
+  } else if(k < 2*adjoint->N) {
+    for(i=0; i<adjoint->N; ++i) {
+      objective->gy[i] = adjoint->jac[i*adjoint->N + (k-adjoint->N)];
+    }
+  } else {
+    for(i=0; i<adjoint->N; ++i) {
+      double delta = perturbation(x[i]);
+      x[i] += delta;
+      evaluateModel(adjoint);
+      objective->gy[i] = (x[k] - adjoint->realVars[k]) / delta;
+      restorePoint(adjoint);
+    }
+  }
+
+  objective->gyValid = 1;
+  return objective->gy;
+}
+
+/*! \fn evaluateParameterJacobian
+ *
+ *  df/dp and the derivatives of all objective variables w.r.t. the
+ *  parameters at the current point by forward differences. Bound
+ *  parameters are updated for every perturbation.
+ */
+static void evaluateParameterJacobian(IDA_ADJOINT *adjoint)
+{
+  DATA *data = adjoint->data;
+  threadData_t *threadData = adjoint->threadData;
+  double *vars = data->localData[0]->realVars;
+  long i, j, l;
+
+  if(adjoint->fpValid) {
+    return;
+  }
+
+  for(j=0; j<adjoint->Np; ++j) {
+    double *p = &data->simulationInfo->realParameter[adjoint->paramIndex[j]];
+    double pSave = *p;
+    double delta = perturbation(pSave);
+
+    *p += delta;
+    data->callback->updateBoundParameters(data, threadData);
+    evaluateModel(adjoint);
+
+    for(l=0; l<adjoint->N; ++l) {
+      adjoint->fp[j*adjoint->N + l] = (vars[adjoint->N + l] - adjoint->realVars[adjoint->N + l]) / delta;
+    }
+    for(i=0; i<adjoint->nObjectives; ++i) {
+      long k = adjoint->objectives[i].index;
+      adjoint->gp[i*adjoint->Np + j] = k < adjoint->N ? 0.0 : (vars[k] - adjoint->realVars[k]) / delta;
+    }
+
+    *p = pSave;
+    restorePoint(adjoint);
+  }
+  data->callback->updateBoundParameters(data, threadData);
+
+  adjoint->fpValid = 1;
+}
+
+/* backward residual: nu' + J^T nu + gy^T = 0 */
+static int residualFunctionB(double tt, N_Vector yy, N_Vector yp, N_Vector yyB, N_Vector ypB, N_Vector rrB, void *userDataB)
+{
+  IDA_ADJOINT_PROBLEM *problem = (IDA_ADJOINT_PROBLEM*) userDataB;
+  IDA_ADJOINT *adjoint = problem->adjoint;
+  double *nu = N_VGetArrayPointer(yyB);
+  double *nuDot = N_VGetArrayPointer(ypB);
+  double *res = N_VGetArrayPointer(rrB);
+  const double *gy = NULL;
+  long i, l;
+
+  evaluatePoint(adjoint, tt, N_VGetArrayPointer(yy));
+  if(problem->objective->kind == IDA_ADJOINT_INTEGRAL) {
+    gy = objectiveGradient(adjoint, problem->objective);
+  }
+
+  for(i=0; i<adjoint->N; ++i) {
+    double sum = nuDot[i];
+    for(l=0; l<adjoint->N; ++l) {
+      sum += adjoint->jac[i*adjoint->N + l] * nu[l];
+    }
+    res[i] = gy ? sum + gy[i] : sum;
+  }
+  return 0;
+}
+
+/* backward jacobian: J^T + cjB*I */
+static int jacobianFunctionB(long int NeqB, double tt, double cjB, N_Vector yy, N_Vector yp,
+    N_Vector yyB, N_Vector ypB, N_Vector rrB, DlsMat JacB, void *userDataB,
+    N_Vector tmp1B, N_Vector tmp2B, N_Vector tmp3B)
+{
+  IDA_ADJOINT_PROBLEM *problem = (IDA_ADJOINT_PROBLEM*) userDataB;
+  IDA_ADJOINT *adjoint = problem->adjoint;
+  long i, l;
+
+  evaluatePoint(adjoint, tt, N_VGetArrayPointer(yy));
+  for(i=0; i<adjoint->N; ++i) {
+    for(l=0; l<adjoint->N; ++l) {
+      DENSE_ELEM(JacB, i, l) = adjoint->jac[i*adjoint->N + l];
+    }
+    DENSE_ELEM(JacB, i, i) += cjB;
+  }
+  return 0;
+}
+
+/* backward quadrature: -(gp + nu^T fp) and -g for the value of integral objectives */
+static int quadratureFunctionB(double tt, N_Vector yy, N_Vector yp, N_Vector yyB, N_Vector ypB, N_Vector rhsQB, void *userDataB)
+{
+  IDA_ADJOINT_PROBLEM *problem = (IDA_ADJOINT_PROBLEM*) userDataB;
+  IDA_ADJOINT *adjoint = problem->adjoint;
+  int integral = problem->objective->kind == IDA_ADJOINT_INTEGRAL;
+  const double *gp = adjoint->gp + (problem->objective - adjoint->objectives)*adjoint->Np;
+  double *nu = N_VGetArrayPointer(yyB);
+  double *q = N_VGetArrayPointer(rhsQB);
+  long j, l;
+
+  evaluatePoint(adjoint, tt, N_VGetArrayPointer(yy));
+  evaluateParameterJacobian(adjoint);
+
+  for(j=0; j<adjoint->Np; ++j) {
+    double sum = integral ? gp[j] : 0.0;
+    for(l=0; l<adjoint->N; ++l) {
+      sum += nu[l] * adjoint->fp[j*adjoint->N + l];
+    }
+    q[j] = -sum;
+  }
+  q[adjoint->Np] = integral ? -adjoint->realVars[problem->objective->index] : 0.0;
+  return 0;
+}
+
+static void writeGradients(IDA_ADJOINT *adjoint, const double *values, double **gradients)
+{
+  DATA *data = adjoint->data;
+  char *fileName = (char*) malloc(strlen(data->modelData->modelFilePrefix) + 13);
+  FILE *file;
+  long i, j;
+
+  sprintf(fileName, "%s_adjoint.csv", data->modelData->modelFilePrefix);
+  file = fopen(fileName, "w");
+  if(!file) {
+    warningStreamPrint(LOG_STDOUT, 0, "##IDA## Cannot open %s for writing the adjoint sensitivities.", fileName);
+    free(fileName);
+    return;
+  }
+
+  fprintf(file, "\"objective\",\"value\"");
+  for(j=0; j<adjoint->Np; ++j) {
+    fprintf(file, ",\"%s\"", data->modelData->realParameterData[adjoint->paramIndex[j]].info.name);
+  }
+  for(j=0; j<adjoint->N; ++j) {
+    fprintf(file, ",\"start(%s)\"", data->modelData->realVarsData[j].info.name);
+  }
+  fprintf(file, "\n");
+
+  for(i=0; i<adjoint->nObjectives; ++i) {
+    fprintf(file, "\"%s\",%.16g", adjoint->objectives[i].name, values[i]);
+    for(j=0; j<adjoint->Np+adjoint->N; ++j) {
+      fprintf(file, ",%.16g", gradients[i][j]);
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  infoStreamPrint(LOG_STDOUT, 0, "Wrote adjoint sensitivities of %d objective(s) to %s.", adjoint->nObjectives, fileName);
+  free(fileName);
+}
+
+/*! \fn ida_adjoint_solve
+ *
+ *  Solves the backward problems of all objectives from tFinal to tStart and
+ *  writes the gradients to <model>_adjoint.csv. The gradients with respect
+ *  to the parameters assume start values which do not depend on them; the
+ *  gradients with respect to the start values of the states are written
+ *  separately, so they can be chained with dx(t0)/dp.
+ */
+int ida_adjoint_solve(IDA_ADJOINT *adjoint, void *ida_mem, double tStart, double tFinal)
+{
+  DATA *data = adjoint->data;
+  threadData_t *threadData = adjoint->threadData;
+  double rtol = data->simulationInfo->tolerance;
+  double tret;
+  double *xFinal, *values, **gradients;
+  N_Vector tmpState, tmpQuad;
+  N_Vector *yB, *ypB, *qB;
+  long i, j, l;
+  int k, flag, retVal = 0;
+
+  if(!adjoint->valid) {
+    warningStreamPrint(LOG_STDOUT, 0, "##IDA## Adjoint sensitivities are not computed, since the simulation contains events after the start time.");
+    return 1;
+  }
+  if(!adjoint->forwardStarted || tFinal <= tStart) {
+    warningStreamPrint(LOG_STDOUT, 0, "##IDA## Adjoint sensitivities are not computed for an empty simulation interval.");
+    return 1;
+  }
+
+  infoStreamPrint(LOG_SOLVER, 1, "##IDA## backward integration from %g to %g", tFinal, tStart);
+
+  xFinal = (double*) malloc(adjoint->N*sizeof(double));
+  memcpy(xFinal, data->localData[0]->realVars, adjoint->N*sizeof(double));
+  values = (double*) calloc(adjoint->nObjectives, sizeof(double));
+  gradients = (double**) malloc(adjoint->nObjectives*sizeof(double*));
+  tmpState = N_VNew_Serial(adjoint->N);
+  tmpQuad = N_VNew_Serial(adjoint->Np+1);
+  yB = N_VCloneVectorArray_Serial(adjoint->nObjectives, tmpState);
+  ypB = N_VCloneVectorArray_Serial(adjoint->nObjectives, tmpState);
+  qB = N_VCloneVectorArray_Serial(adjoint->nObjectives, tmpQuad);
+
+  /* final conditions */
+  adjoint->pointValid = 0;
+  evaluatePoint(adjoint, tFinal, xFinal);
+  evaluateParameterJacobian(adjoint);
+
+  for(k=0; k<adjoint->nObjectives; ++k) {
+    IDA_ADJOINT_OBJECTIVE *objective = &adjoint->objectives[k];
+    double *nu = N_VGetArrayPointer(yB[k]);
+    double *nuDot = N_VGetArrayPointer(ypB[k]);
+    const double *gy = objectiveGradient(adjoint, objective);
+
+    gradients[k] = (double*) calloc(adjoint->Np+adjoint->N, sizeof(double));
+    N_VConst(0.0, qB[k]);
+
+    if(objective->kind == IDA_ADJOINT_FINAL) {
+      values[k] = adjoint->realVars[objective->index];
+      memcpy(nu, gy, adjoint->N*sizeof(double));
+      memcpy(gradients[k], adjoint->gp + k*adjoint->Np, adjoint->Np*sizeof(double));
+    } else {
+      N_VConst(0.0, yB[k]);
+    }
+
+    /* consistent derivative: nu' = -J^T nu - gy^T */
+    for(i=0; i<adjoint->N; ++i) {
+      double sum = objective->kind == IDA_ADJOINT_INTEGRAL ? gy[i] : 0.0;
+      for(l=0; l<adjoint->N; ++l) {
+        sum += adjoint->jac[i*adjoint->N + l] * nu[l];
+      }
+      nuDot[i] = -sum;
+    }
+
+    flag = IDACreateB(ida_mem, &objective->which);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDACreateB failed!");
+    }
+    flag = IDAInitB(ida_mem, objective->which, residualFunctionB, tFinal, yB[k], ypB[k]);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDAInitB failed!");
+    }
+    flag = IDASStolerancesB(ida_mem, objective->which, rtol, rtol);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDASStolerancesB failed!");
+    }
+    flag = IDASetUserDataB(ida_mem, objective->which, &adjoint->problems[k]);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDASetUserDataB failed!");
+    }
+    flag = IDADenseB(ida_mem, objective->which, adjoint->N);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDADenseB failed!");
+    }
+    flag = IDADlsSetDenseJacFnB(ida_mem, objective->which, jacobianFunctionB);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDADlsSetDenseJacFnB failed!");
+    }
+    flag = IDAQuadInitB(ida_mem, objective->which, quadratureFunctionB, qB[k]);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDAQuadInitB failed!");
+    }
+    flag = IDAQuadSStolerancesB(ida_mem, objective->which, rtol, rtol);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDAQuadSStolerancesB failed!");
+    }
+    flag = IDASetQuadErrConB(ida_mem, objective->which, TRUE);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## IDASetQuadErrConB failed!");
+    }
+  }
+
+  /* all backward problems share the interpolated forward solution */
+  flag = IDASolveB(ida_mem, tStart, IDA_NORMAL);
+  if (checkIDAflag(flag)){
+    warningStreamPrint(LOG_STDOUT, 0, "##IDA## Backward integration failed with flag %d, no adjoint sensitivities are written.", flag);
+    retVal = 1;
+  }
+
+  for(k=0; k<adjoint->nObjectives && !retVal; ++k) {
+    IDA_ADJOINT_OBJECTIVE *objective = &adjoint->objectives[k];
+    double *nu = N_VGetArrayPointer(yB[k]);
+    double *q = N_VGetArrayPointer(qB[k]);
+
+    if (checkIDAflag(IDAGetB(ida_mem, objective->which, &tret, yB[k], ypB[k])) ||
+        checkIDAflag(IDAGetQuadB(ida_mem, objective->which, &tret, qB[k]))){
+      throwStreamPrint(threadData, "##IDA## Something goes wrong while obtain results of the backward problem!");
+    }
+
+    for(j=0; j<adjoint->Np; ++j) {
+      gradients[k][j] += q[j];
+    }
+    memcpy(gradients[k] + adjoint->Np, nu, adjoint->N*sizeof(double));
+    if(objective->kind == IDA_ADJOINT_INTEGRAL) {
+      values[k] = q[adjoint->Np];
+    }
+  }
+  messageClose(LOG_SOLVER);
+
+  if(!retVal) {
+    writeGradients(adjoint, values, gradients);
+  }
+
+  /* leave the model at the stop time */
+  data->localData[0]->timeValue = tFinal;
+  memcpy(data->localData[0]->realVars, xFinal, adjoint->N*sizeof(double));
+  adjoint->pointValid = 0;
+  evaluateModel(adjoint);
+
+  for(k=0; k<adjoint->nObjectives; ++k) {
+    free(gradients[k]);
+  }
+  free(gradients);
+  free(values);
+  free(xFinal);
+  N_VDestroy_Serial(tmpState);
+  N_VDestroy_Serial(tmpQuad);
+  N_VDestroyVectorArray_Serial(yB, adjoint->nObjectives);
+  N_VDestroyVectorArray_Serial(ypB, adjoint->nObjectives);
+  N_VDestroyVectorArray_Serial(qB, adjoint->nObjectives);
+
+  return retVal;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2016, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_adjoint.h
+ *
+ *  Adjoint sensitivities of scalar objectives with IDAS (-idaAdjoint).
+ */
+
+#ifndef OMC_IDA_ADJOINT_H
+#define OMC_IDA_ADJOINT_H
+
+#include "openmodelica.h"
+#include "simulation_data.h"
+
+#ifdef WITH_SUNDIALS
+
+typedef enum IDA_ADJOINT_KIND
+{
+  IDA_ADJOINT_FINAL = 0,        /* value of a variable at the stop time */
+  IDA_ADJOINT_INTEGRAL          /* integral of a variable over the simulation interval */
+} IDA_ADJOINT_KIND;
+
+typedef struct IDA_ADJOINT_OBJECTIVE
+{
+  IDA_ADJOINT_KIND kind;
+  long index;                   /* index of the variable in realVars */
+  char *name;                   /* objective as given on the command line */
+  int which;                    /* index of the backward problem in IDAS */
+  int gyValid;                  /* gy belongs to the current point */
+  double *gy;                   /* derivative of the variable w.r.t. the states */
+} IDA_ADJOINT_OBJECTIVE;
+
+typedef struct IDA_ADJOINT_PROBLEM
+{
+  struct IDA_ADJOINT *adjoint;
+  IDA_ADJOINT_OBJECTIVE *objective;
+} IDA_ADJOINT_PROBLEM;
+
+typedef struct IDA_ADJOINT
+{
+  DATA *data;
+  threadData_t *threadData;
+  long N;                       /* number of states */
+  int valid;                    /* FALSE if the forward trajectory cannot be used */
+  int forwardStarted;           /* first checkpointed step done */
+
+  int nObjectives;
+  IDA_ADJOINT_OBJECTIVE *objectives;
+  IDA_ADJOINT_PROBLEM *problems;
+  int needAlgebraics;           /* some objective is neither a state nor a derivative */
+
+  int Np;
+  long *paramIndex;             /* indices of the parameters in realParameter */
+
+  /* jacobian df/dx */
+  SPARSE_PATTERN *pattern;      /* NULL for dense finite differences */
+  int useSymbolicJacobian;
+
+  /* cached evaluation at the last point (t, x) */
+  int pointValid;
+  int fpValid;
+  double time;
+  double *states;
+  double *realVars;             /* all real variables at the point */
+  double *jac;                  /* dense column-major df/dx */
+  double *fp;                   /* dense column-major df/dp */
+  double *gp;                   /* d(objective variable)/dp, nObjectives*Np */
+  double *delta;
+} IDA_ADJOINT;
+
+IDA_ADJOINT* ida_adjoint_allocate(DATA *data, threadData_t *threadData, void *ida_mem, SPARSE_PATTERN *pattern, int useSymbolicJacobian);
+void ida_adjoint_free(IDA_ADJOINT *adjoint);
+int ida_adjoint_solve(IDA_ADJOINT *adjoint, void *ida_mem, double tStart, double tFinal);
+
+#endif
+
+#endif
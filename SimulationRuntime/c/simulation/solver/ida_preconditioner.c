@@ -0,0 +1,642 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_preconditioner.c
+ *
+ *  Block jacobi, ILU(0) and ILUT preconditioners for the iterative linear
+ *  solvers of IDA. The blocks of the block jacobi preconditioner are the
+ *  strong components of the jacobian sparsity pattern, i.e. the diagonal
+ *  blocks of its BLT form. Strong components larger than
+ *  IDA_PREC_MAX_BLOCK_SIZE are split into chunks of consecutive variables.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "util/omc_error.h"
+#include "simulation/solver/ida_preconditioner.h"
+
+#define IDA_PREC_MAX_BLOCK_SIZE 32
+#define IDA_PREC_ILUT_TOL 1e-3      /* drop tolerance relative to the norm of the row */
+#define IDA_PREC_ILUT_FILL 10       /* additional elements per row in each factor */
+
+extern void dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern void dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+
+typedef struct ILUT_ENTRY
+{
+  int col;
+  double val;
+} ILUT_ENTRY;
+
+static int compareMagnitude(const void *a, const void *b)
+{
+  double x = fabs(((const ILUT_ENTRY*)a)->val);
+  double y = fabs(((const ILUT_ENTRY*)b)->val);
+  return (x < y) - (x > y);
+}
+
+static int compareColumn(const void *a, const void *b)
+{
+  return ((const ILUT_ENTRY*)a)->col - ((const ILUT_ENTRY*)b)->col;
+}
+
+/*! \fn strongComponents
+ *
+ *  Tarjan's algorithm without recursion on the graph of the pattern.
+ *  Returns the number of components, comp holds the component of each variable.
+ */
+static int strongComponents(IDA_PRECONDITIONER *prec, int *comp)
+{
+  const int n = (int)prec->n;
+  int *index = (int*) malloc(n*sizeof(int));
+  int *low = (int*) malloc(n*sizeof(int));
+  int *next = (int*) malloc(n*sizeof(int));
+  int *stack = (int*) malloc(n*sizeof(int));
+  int *callStack = (int*) malloc(n*sizeof(int));
+  int counter = 0, nComp = 0, sp = 0, csp, s;
+
+  for(s=0; s<n; ++s) {
+    index[s] = -1;
+    comp[s] = -1;
+  }
+
+  for(s=0; s<n; ++s) {
+    if(index[s] >= 0) {
+      continue;
+    }
+    index[s] = low[s] = counter++;
+    next[s] = prec->rowPtr[s];
+    stack[sp++] = s;
+    csp = 0;
+    callStack[csp++] = s;
+
+    while(csp > 0) {
+      int v = callStack[csp-1];
+      if(next[v] < prec->rowPtr[v+1]) {
+        int w = prec->colIdx[next[v]++];
+        if(index[w] < 0) {
+          index[w] = low[w] = counter++;
+          next[w] = prec->rowPtr[w];
+          stack[sp++] = w;
+          callStack[csp++] = w;
+        } else if(comp[w] < 0 && index[w] < low[v]) {
+          low[v] = index[w];
+        }
+      } else {
+        --csp;
+        if(csp > 0 && low[v] < low[callStack[csp-1]]) {
+          low[callStack[csp-1]] = low[v];
+        }
+        if(low[v] == index[v]) {
+          int w;
+          do {
+            w = stack[--sp];
+            comp[w] = nComp;
+          } while(w != v);
+          nComp++;
+        }
+      }
+    }
+  }
+
+  free(index);
+  free(low);
+  free(next);
+  free(stack);
+  free(callStack);
+  return nComp;
+}
+
+static void allocateBlockJacobi(IDA_PRECONDITIONER *prec)
+{
+  const int n = (int)prec->n;
+  int *comp = (int*) malloc(n*sizeof(int));
+  int *compPtr;
+  int nComp, c, i, b, size, maxSize = 0;
+
+  nComp = strongComponents(prec, comp);
+
+  /* sort the variables by components, keeping their order inside of a component */
+  compPtr = (int*) calloc(nComp+1, sizeof(int));
+  for(i=0; i<n; ++i) {
+    compPtr[comp[i]+1]++;
+  }
+  for(c=0; c<nComp; ++c) {
+    compPtr[c+1] += compPtr[c];
+  }
+  prec->blockVars = (int*) malloc(n*sizeof(int));
+  for(i=0; i<n; ++i) {
+    prec->blockVars[compPtr[comp[i]]++] = i;
+  }
+  for(c=nComp; c>0; --c) {
+    compPtr[c] = compPtr[c-1];
+  }
+  compPtr[0] = 0;
+
+  /* split large components */
+  prec->nBlocks = 0;
+  for(c=0; c<nComp; ++c) {
+    size = compPtr[c+1] - compPtr[c];
+    prec->nBlocks += (size + IDA_PREC_MAX_BLOCK_SIZE - 1) / IDA_PREC_MAX_BLOCK_SIZE;
+  }
+  prec->blockPtr = (int*) malloc((prec->nBlocks+1)*sizeof(int));
+  prec->luPtr = (int*) malloc((prec->nBlocks+1)*sizeof(int));
+  b = 0;
+  for(c=0; c<nComp; ++c) {
+    for(i=compPtr[c]; i<compPtr[c+1]; i+=IDA_PREC_MAX_BLOCK_SIZE) {
+      prec->blockPtr[b++] = i;
+    }
+  }
+  prec->blockPtr[prec->nBlocks] = n;
+
+  prec->blockOf = (int*) malloc(n*sizeof(int));
+  prec->blockPos = (int*) malloc(n*sizeof(int));
+  prec->luPtr[0] = 0;
+  for(b=0; b<prec->nBlocks; ++b) {
+    size = prec->blockPtr[b+1] - prec->blockPtr[b];
+    maxSize = size > maxSize ? size : maxSize;
+    prec->luPtr[b+1] = prec->luPtr[b] + size*size;
+    for(i=prec->blockPtr[b]; i<prec->blockPtr[b+1]; ++i) {
+      prec->blockOf[prec->blockVars[i]] = b;
+      prec->blockPos[prec->blockVars[i]] = i - prec->blockPtr[b];
+    }
+  }
+  prec->blockLU = (double*) malloc(prec->luPtr[prec->nBlocks]*sizeof(double));
+  prec->pivots = (int*) malloc(n*sizeof(int));
+  prec->work = (double*) malloc(maxSize*sizeof(double));
+
+  infoStreamPrint(LOG_SOLVER, 0, "ida preconditioner: %d strong components, %d blocks, largest block %d", nComp, prec->nBlocks, maxSize);
+
+  free(comp);
+  free(compPtr);
+}
+
+/*! \fn ida_prec_allocate
+ *
+ *  colPtr and rowIdx describe the sparsity pattern of the jacobian in
+ *  compressed column format. The values passed to ida_prec_setJacobian
+ *  are expected in the same order.
+ */
+IDA_PRECONDITIONER* ida_prec_allocate(int method, int refresh, long n, const unsigned int *colPtr, const unsigned int *rowIdx)
+{
+  IDA_PRECONDITIONER *prec = (IDA_PRECONDITIONER*) calloc(1, sizeof(IDA_PRECONDITIONER));
+  int i, j, p, nnz;
+  int *hasDiag = (int*) calloc(n, sizeof(int));
+  int *fill;
+
+  assertStreamPrint(NULL, 0 != prec, "out of memory");
+
+  prec->method = method;
+  prec->refresh = refresh;
+  prec->n = n;
+  prec->nnzIn = colPtr[n];
+
+  /* count elements per row, add missing diagonal elements */
+  prec->rowPtr = (int*) calloc(n+1, sizeof(int));
+  for(j=0; j<n; ++j) {
+    for(p=colPtr[j]; p<(int)colPtr[j+1]; ++p) {
+      prec->rowPtr[rowIdx[p]+1]++;
+      if((int)rowIdx[p] == j) {
+        hasDiag[j] = 1;
+      }
+    }
+    if(!hasDiag[j]) {
+      prec->rowPtr[j+1]++;
+    }
+  }
+  for(i=0; i<n; ++i) {
+    prec->rowPtr[i+1] += prec->rowPtr[i];
+  }
+  nnz = prec->nnz = prec->rowPtr[n];
+
+  /* transpose column by column, the columns of each row are sorted afterwards */
+  prec->colIdx = (int*) malloc(nnz*sizeof(int));
+  prec->diagIdx = (int*) malloc(n*sizeof(int));
+  prec->cscToCsr = (int*) malloc(prec->nnzIn*sizeof(int));
+  prec->jac = (double*) calloc(nnz, sizeof(double));
+  fill = (int*) malloc(n*sizeof(int));
+  memcpy(fill, prec->rowPtr, n*sizeof(int));
+  for(j=0; j<n; ++j) {
+    for(p=colPtr[j]; p<(int)colPtr[j+1]; ++p) {
+      i = rowIdx[p];
+      if(i == j) {
+        prec->diagIdx[i] = fill[i];
+      }
+      prec->cscToCsr[p] = fill[i];
+      prec->colIdx[fill[i]++] = j;
+    }
+    if(!hasDiag[j]) {
+      prec->diagIdx[j] = fill[j];
+      prec->colIdx[fill[j]++] = j;
+    }
+  }
+  free(fill);
+  free(hasDiag);
+
+  switch(method)
+  {
+  case IDA_PREC_BJAC:
+    allocateBlockJacobi(prec);
+    break;
+  case IDA_PREC_ILU0:
+    /* same pattern as the jacobian */
+    prec->luRowPtr = prec->rowPtr;
+    prec->luColIdx = prec->colIdx;
+    prec->luDiag = prec->diagIdx;
+    prec->lu = (double*) malloc(nnz*sizeof(double));
+    prec->wPos = (int*) malloc(n*sizeof(int));
+    for(i=0; i<n; ++i) {
+      prec->wPos[i] = -1;
+    }
+    break;
+  case IDA_PREC_ILUT:
+    prec->luRowPtr = (int*) malloc((n+1)*sizeof(int));
+    prec->luColIdx = (int*) malloc((nnz + 2*IDA_PREC_ILUT_FILL*n)*sizeof(int));
+    prec->luDiag = (int*) malloc(n*sizeof(int));
+    prec->lu = (double*) malloc((nnz + 2*IDA_PREC_ILUT_FILL*n)*sizeof(double));
+    prec->w = (double*) malloc(n*sizeof(double));
+    prec->wIdx = (int*) malloc(2*n*sizeof(int));
+    prec->wPos = (int*) malloc(n*sizeof(int));
+    for(i=0; i<n; ++i) {
+      prec->wPos[i] = -1;
+    }
+    break;
+  default:
+    throwStreamPrint(NULL, "unrecognized ida preconditioner %d", method);
+  }
+
+  return prec;
+}
+
+void ida_prec_free(IDA_PRECONDITIONER *prec)
+{
+  if(!prec) {
+    return;
+  }
+  if(prec->method == IDA_PREC_ILUT) {
+    free(prec->luRowPtr);
+    free(prec->luColIdx);
+    free(prec->luDiag);
+  }
+  free(prec->lu);
+  free(prec->w);
+  free(prec->wIdx);
+  free(prec->wPos);
+
+  free(prec->blockPtr);
+  free(prec->blockVars);
+  free(prec->blockOf);
+  free(prec->blockPos);
+  free(prec->luPtr);
+  free(prec->blockLU);
+  free(prec->pivots);
+  free(prec->work);
+
+  free(prec->rowPtr);
+  free(prec->colIdx);
+  free(prec->diagIdx);
+  free(prec->cscToCsr);
+  free(prec->jac);
+  free(prec);
+}
+
+/*! \fn ida_prec_needJacobian
+ *
+ *  Refresh policy: the jacobian is evaluated again after prec->refresh
+ *  setups or if the nonlinear solver failed since the last evaluation.
+ */
+int ida_prec_needJacobian(IDA_PRECONDITIONER *prec, long convFails)
+{
+  if(convFails != prec->convFails) {
+    prec->convFails = convFails;
+    prec->jacobianValid = 0;
+  }
+  return !prec->jacobianValid || (prec->refresh > 0 && prec->setupsSinceJacobian >= prec->refresh);
+}
+
+void ida_prec_setJacobian(IDA_PRECONDITIONER *prec, const double *values)
+{
+  int p;
+
+  memset(prec->jac, 0, prec->nnz*sizeof(double));
+  for(p=0; p<prec->nnzIn; ++p) {
+    prec->jac[prec->cscToCsr[p]] = values[p];
+  }
+  prec->jacobianValid = 1;
+  prec->setupsSinceJacobian = 0;
+  prec->numJacobians++;
+}
+
+static double rowNorm(IDA_PRECONDITIONER *prec, int i, double shift)
+{
+  double norm = fabs(shift);
+  int p;
+  for(p=prec->rowPtr[i]; p<prec->rowPtr[i+1]; ++p) {
+    norm = fmax(norm, fabs(prec->jac[p]));
+  }
+  return norm;
+}
+
+/* replaces a vanishing pivot of an incomplete decomposition */
+static double fixPivot(double pivot, double norm)
+{
+  double tiny = sqrt(DBL_EPSILON) * (norm > 0.0 ? norm : 1.0);
+  if(fabs(pivot) >= tiny) {
+    return pivot;
+  }
+  return pivot < 0.0 ? -tiny : tiny;
+}
+
+static int factorizeBlockJacobi(IDA_PRECONDITIONER *prec, double shift)
+{
+  int b, k, p, info;
+
+  for(b=0; b<prec->nBlocks; ++b) {
+    int size = prec->blockPtr[b+1] - prec->blockPtr[b];
+    double *A = prec->blockLU + prec->luPtr[b];
+
+    memset(A, 0, size*size*sizeof(double));
+    for(k=prec->blockPtr[b]; k<prec->blockPtr[b+1]; ++k) {
+      int i = prec->blockVars[k];
+      int row = k - prec->blockPtr[b];
+      for(p=prec->rowPtr[i]; p<prec->rowPtr[i+1]; ++p) {
+        int j = prec->colIdx[p];
+        if(prec->blockOf[j] == b) {
+          A[prec->blockPos[j]*size + row] += prec->jac[p];
+        }
+      }
+      A[row*size + row] += shift;
+    }
+
+    dgetrf_(&size, &size, A, &size, prec->pivots + prec->blockPtr[b], &info);
+    if(info != 0) {
+      infoStreamPrint(LOG_SOLVER, 0, "ida preconditioner: block %d of size %d is singular", b, size);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int factorizeILU0(IDA_PRECONDITIONER *prec, double shift)
+{
+  const int n = (int)prec->n;
+  int i, p, q;
+
+  memcpy(prec->lu, prec->jac, prec->nnz*sizeof(double));
+  for(i=0; i<n; ++i) {
+    prec->lu[prec->diagIdx[i]] += shift;
+  }
+
+  for(i=0; i<n; ++i) {
+    for(p=prec->rowPtr[i]; p<prec->rowPtr[i+1]; ++p) {
+      prec->wPos[prec->colIdx[p]] = p;
+    }
+
+    for(p=prec->rowPtr[i]; p<prec->diagIdx[i]; ++p) {
+      int k = prec->colIdx[p];
+      double l = prec->lu[p] / prec->lu[prec->diagIdx[k]];
+      prec->lu[p] = l;
+      for(q=prec->diagIdx[k]+1; q<prec->rowPtr[k+1]; ++q) {
+        if(prec->wPos[prec->colIdx[q]] >= 0) {
+          prec->lu[prec->wPos[prec->colIdx[q]]] -= l * prec->lu[q];
+        }
+      }
+    }
+    prec->lu[prec->diagIdx[i]] = fixPivot(prec->lu[prec->diagIdx[i]], rowNorm(prec, i, shift));
+
+    for(p=prec->rowPtr[i]; p<prec->rowPtr[i+1]; ++p) {
+      prec->wPos[prec->colIdx[p]] = -1;
+    }
+  }
+  return 0;
+}
+
+/* stores the largest entries of a factor row, returns the new number of stored elements */
+static int storeILUTPart(IDA_PRECONDITIONER *prec, ILUT_ENTRY *entries, int len, int maxLen, int pos)
+{
+  int k;
+  if(len > maxLen) {
+    qsort(entries, len, sizeof(ILUT_ENTRY), compareMagnitude);
+    len = maxLen;
+  }
+  qsort(entries, len, sizeof(ILUT_ENTRY), compareColumn);
+  for(k=0; k<len; ++k) {
+    prec->luColIdx[pos+k] = entries[k].col;
+    prec->lu[pos+k] = entries[k].val;
+  }
+  return pos + len;
+}
+
+static int factorizeILUT(IDA_PRECONDITIONER *prec, double shift)
+{
+  const int n = (int)prec->n;
+  double *w = prec->w;
+  int *wIdx = prec->wIdx;
+  int *wPos = prec->wPos;
+  ILUT_ENTRY *entries = (ILUT_ENTRY*) malloc(n*sizeof(ILUT_ENTRY));
+  int i, p, q, pos = 0;
+
+  for(i=0; i<n; ++i) {
+    int lenL = 0, lenU = 0, jj, nL = 0, nU = 0;
+    int nOrigL = prec->diagIdx[i] - prec->rowPtr[i];
+    int nOrigU = prec->rowPtr[i+1] - prec->diagIdx[i] - 1;
+    double norm = 0.0, tol, diag;
+
+    prec->luRowPtr[i] = pos;
+
+    /* scatter row i: lower part in wIdx[0..lenL), upper part including the diagonal in wIdx[n..n+lenU) */
+    for(p=prec->rowPtr[i]; p<prec->rowPtr[i+1]; ++p) {
+      int j = prec->colIdx[p];
+      w[j] = prec->jac[p] + (j == i ? shift : 0.0);
+      norm += w[j]*w[j];
+      if(j < i) {
+        wPos[j] = lenL;
+        wIdx[lenL++] = j;
+      } else {
+        wPos[j] = n + lenU;
+        wIdx[n + lenU++] = j;
+      }
+    }
+    norm = sqrt(norm / (prec->rowPtr[i+1] - prec->rowPtr[i]));
+    tol = IDA_PREC_ILUT_TOL * norm;
+
+    /* eliminate the lower part in increasing column order */
+    for(jj=0; jj<lenL; ++jj) {
+      int k, kk, min = jj;
+      double l;
+      for(kk=jj+1; kk<lenL; ++kk) {
+        if(wIdx[kk] < wIdx[min]) {
+          min = kk;
+        }
+      }
+      if(min != jj) {
+        int tmp = wIdx[jj];
+        wIdx[jj] = wIdx[min];
+        wIdx[min] = tmp;
+        wPos[wIdx[jj]] = jj;
+        wPos[wIdx[min]] = min;
+      }
+      k = wIdx[jj];
+
+      /* the drop tolerance is in the units of the row, so it is applied before the scaling */
+      if(fabs(w[k]) < tol) {
+        w[k] = 0.0;
+        continue;
+      }
+      l = w[k] / prec->lu[prec->luDiag[k]];
+      w[k] = l;
+      for(q=prec->luDiag[k]+1; q<prec->luRowPtr[k+1]; ++q) {
+        int j = prec->luColIdx[q];
+        if(wPos[j] < 0) {
+          w[j] = 0.0;
+          if(j < i) {
+            wPos[j] = lenL;
+            wIdx[lenL++] = j;
+          } else {
+            wPos[j] = n + lenU;
+            wIdx[n + lenU++] = j;
+          }
+        }
+        w[j] -= l * prec->lu[q];
+      }
+    }
+
+    /* dropping, the lower part holds the multipliers that were not dropped */
+    for(jj=0; jj<lenL; ++jj) {
+      if(w[wIdx[jj]] != 0.0) {
+        entries[nL].col = wIdx[jj];
+        entries[nL++].val = w[wIdx[jj]];
+      }
+    }
+    pos = storeILUTPart(prec, entries, nL, nOrigL + IDA_PREC_ILUT_FILL, pos);
+
+    diag = w[i];
+    for(jj=n; jj<n+lenU; ++jj) {
+      int j = wIdx[jj];
+      if(j != i && fabs(w[j]) >= tol) {
+        entries[nU].col = j;
+        entries[nU++].val = w[j];
+      }
+    }
+    prec->luDiag[i] = pos;
+    prec->luColIdx[pos] = i;
+    prec->lu[pos] = fixPivot(diag, rowNorm(prec, i, shift));
+    pos = storeILUTPart(prec, entries, nU, nOrigU + IDA_PREC_ILUT_FILL, pos+1);
+
+    /* reset work row */
+    for(jj=0; jj<lenL; ++jj) {
+      wPos[wIdx[jj]] = -1;
+    }
+    for(jj=n; jj<n+lenU; ++jj) {
+      wPos[wIdx[jj]] = -1;
+    }
+  }
+  prec->luRowPtr[n] = pos;
+
+  free(entries);
+  return 0;
+}
+
+/*! \fn ida_prec_factorize
+ *
+ *  Decomposes J + shift*I. Returns 0 on success and 1 if the
+ *  decomposition failed, which IDA treats as a recoverable error.
+ */
+int ida_prec_factorize(IDA_PRECONDITIONER *prec, double shift)
+{
+  int retVal;
+
+  switch(prec->method)
+  {
+  case IDA_PREC_BJAC:
+    retVal = factorizeBlockJacobi(prec, shift);
+    break;
+  case IDA_PREC_ILU0:
+    retVal = factorizeILU0(prec, shift);
+    break;
+  case IDA_PREC_ILUT:
+    retVal = factorizeILUT(prec, shift);
+    break;
+  default:
+    retVal = 1;
+  }
+  prec->setupsSinceJacobian++;
+  prec->numSetups++;
+  return retVal;
+}
+
+/*! \fn ida_prec_solve
+ *
+ *  Solves M z = r with the current decomposition, r and z may be the same vector.
+ */
+void ida_prec_solve(IDA_PRECONDITIONER *prec, const double *r, double *z)
+{
+  const int n = (int)prec->n;
+  int i, k, p;
+
+  prec->numSolves++;
+
+  if(prec->method == IDA_PREC_BJAC) {
+    char trans = 'N';
+    int nrhs = 1, info;
+    for(k=0; k<prec->nBlocks; ++k) {
+      int size = prec->blockPtr[k+1] - prec->blockPtr[k];
+      const int *vars = prec->blockVars + prec->blockPtr[k];
+      for(i=0; i<size; ++i) {
+        prec->work[i] = r[vars[i]];
+      }
+      dgetrs_(&trans, &size, &nrhs, prec->blockLU + prec->luPtr[k], &size, prec->pivots + prec->blockPtr[k], prec->work, &size, &info);
+      for(i=0; i<size; ++i) {
+        z[vars[i]] = prec->work[i];
+      }
+    }
+    return;
+  }
+
+  /* forward substitution with the unit lower factor */
+  for(i=0; i<n; ++i) {
+    double sum = r[i];
+    for(p=prec->luRowPtr[i]; p<prec->luDiag[i]; ++p) {
+      sum -= prec->lu[p] * z[prec->luColIdx[p]];
+    }
+    z[i] = sum;
+  }
+  /* backward substitution with the upper factor */
+  for(i=n-1; i>=0; --i) {
+    double sum = z[i];
+    for(p=prec->luDiag[i]+1; p<prec->luRowPtr[i+1]; ++p) {
+      sum -= prec->lu[p] * z[prec->luColIdx[p]];
+    }
+    z[i] = sum / prec->lu[prec->luDiag[i]];
+  }
+}
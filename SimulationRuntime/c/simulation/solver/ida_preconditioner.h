@@ -0,0 +1,97 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_preconditioner.h
+ *
+ *  Preconditioners for the iterative linear solvers of IDA (-idaPrec).
+ *  The preconditioner approximates M = J + shift*I, where J is given on the
+ *  colored sparsity pattern of the jacobian.
+ */
+
+#ifndef OMC_IDA_PRECONDITIONER_H
+#define OMC_IDA_PRECONDITIONER_H
+
+#include "util/simulation_options.h"
+
+typedef struct IDA_PRECONDITIONER
+{
+  int method;                   /* enum IDA_PREC */
+  int refresh;                  /* maximum number of setups between two jacobian evaluations, 0 = only after convergence failures */
+  long n;
+
+  /* jacobian in compressed row format, diagonal always included */
+  int nnz;
+  int *rowPtr;
+  int *colIdx;
+  int *diagIdx;                 /* position of the diagonal element in each row */
+  int *cscToCsr;                /* position of each element of the compressed column input */
+  int nnzIn;
+  double *jac;
+
+  /* block jacobi: dense LU decompositions of the diagonal blocks */
+  int nBlocks;
+  int *blockPtr;                /* first variable of each block in blockVars, nBlocks+1 */
+  int *blockVars;               /* variables ordered by blocks */
+  int *blockOf;                 /* block of each variable */
+  int *blockPos;                /* position of each variable inside of its block */
+  int *luPtr;                   /* first element of each block decomposition in blockLU */
+  double *blockLU;
+  int *pivots;
+  double *work;
+
+  /* incomplete LU: unit lower and upper factor in compressed row format */
+  int *luRowPtr;
+  int *luColIdx;
+  int *luDiag;
+  double *lu;
+  double *w;                    /* dense work row */
+  int *wPos;                    /* position of a column in the work row, -1 if not present */
+  int *wIdx;
+
+  /* refresh policy */
+  int jacobianValid;
+  int setupsSinceJacobian;
+  long convFails;               /* convergence failures of the nonlinear solver seen so far */
+
+  /* statistics */
+  unsigned long numSetups;
+  unsigned long numJacobians;
+  unsigned long numSolves;
+} IDA_PRECONDITIONER;
+
+IDA_PRECONDITIONER* ida_prec_allocate(int method, int refresh, long n, const unsigned int *colPtr, const unsigned int *rowIdx);
+void ida_prec_free(IDA_PRECONDITIONER *prec);
+
+int ida_prec_needJacobian(IDA_PRECONDITIONER *prec, long convFails);
+void ida_prec_setJacobian(IDA_PRECONDITIONER *prec, const double *values);
+int ida_prec_factorize(IDA_PRECONDITIONER *prec, double shift);
+void ida_prec_solve(IDA_PRECONDITIONER *prec, const double *r, double *z);
+
+#endif
@@ -63,6 +63,7 @@
 #include <idas/idas_spgmr.h>
 #include <idas/idas_spbcgs.h>
 #include <idas/idas_sptfqmr.h>
+#include <idas/idas_spils.h>
 
 
 static int jacobianOwnNumColoredIDA(long int Neq, realtype tt, realtype cj,
@@ -81,7 +82,20 @@ static int jacobiancoloredKLUNum(realtype tt, realtype cj,
     N_Vector yy, N_Vector yp, N_Vector rr, SlsMat Jac, void *user_data,
     N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
 
+static int jacobianSparseNumIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, SlsMat Jac, double cj, void *userData);
+
+static int precSetupIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    realtype cj, void *user_data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+
+static int precSolveIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    N_Vector rvec, N_Vector zvec, realtype cj, realtype delta, void *user_data, N_Vector tmp);
+
+static int jacTimesVecIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    N_Vector v, N_Vector Jv, realtype cj, void *user_data, N_Vector tmp1, N_Vector tmp2);
+
 static int residualFunctionIDA(double time, N_Vector yy, N_Vector yp, N_Vector res, void* userData);
+static void setJacElementKluSparse(int row, int col, double value, int nth, SlsMat spJac);
+static void freeJacobianWorkersIDA(IDA_SOLVER *idaData);
 int rootsFunctionIDA(double time, N_Vector yy, N_Vector yp, double *gout, void* userData);
 
 int checkIDAflag(int flag)
@@ -193,6 +207,11 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
   idaData->delta_hh = (double*) malloc(idaData->N*sizeof(double));
   idaData->errwgt = N_VNew_Serial(idaData->N);
   idaData->newdelta = N_VNew_Serial(idaData->N);
+  idaData->jacobianThreads = 1;
+  idaData->jacobianPool = NULL;
+  idaData->jacobianWorkers = NULL;
+  idaData->preconditioner = NULL;
+  idaData->lastResidualStates = NULL;
 
   /* allocate memory for initialization process */
   tmp = (double*) malloc(idaData->N*sizeof(double));
@@ -272,6 +291,7 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
 
   /* check if Flags FLAG_NOEQUIDISTANT_OUT_FREQ or FLAG_NOEQUIDISTANT_OUT_TIME are set */
   if (idaData->internalSteps){
+    idaData->stepsOutputCounter = 1;
     if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ])
     {
       idaData->stepsFreq = atoi(omc_flagValue[FLAG_NOEQUIDISTANT_OUT_FREQ]);
@@ -405,6 +425,11 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
     }
   }
 
+  if (idaData->jacobianMethod == COLOREDNUMJAC || idaData->jacobianMethod == KLUSPARSE)
+  {
+    idaData->jacobianThreads = getJacobianThreads(data);
+  }
+
   /* set up the appropriate function pointer */
   if (idaData->linearSolverMethod == IDA_LS_KLU)
   {
@@ -433,7 +458,7 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
       break;
     }
   }
-  else
+  else if (idaData->linearSolverMethod == IDA_LS_DENSE)
   {
     switch (idaData->jacobianMethod){
     case SYMJAC:
@@ -455,12 +480,126 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
       break;
     }
   }
+  else
+  {
+    /* the iterative solvers only need products of the jacobian with a vector */
+    switch (idaData->jacobianMethod){
+    case SYMJAC:
+    case COLOREDSYMJAC:
+      if (idaData->daeMode)
+      {
+        infoStreamPrint(LOG_STDOUT, 0, "The directional derivative is not generated for the DAE mode. Switch back to colored numerical jacobian.");
+        idaData->jacobianMethod = COLOREDNUMJAC;
+      }
+      else
+      {
+        flag = IDASpilsSetJacTimesVecFn(idaData->ida_mem, jacTimesVecIDA);
+      }
+      break;
+    case COLOREDNUMJAC:
+    case NUMJAC:
+    case INTERNALNUMJAC:
+      /* ida internal difference quotients, the colored jacobian is only used by the preconditioner */
+      break;
+    default:
+      throwStreamPrint(threadData,"unrecognized jacobian calculation method %s", (const char*)omc_flagValue[FLAG_JACOBIAN]);
+      break;
+    }
+  }
   if (checkIDAflag(flag)){
     throwStreamPrint(threadData, "##IDA## Setting jacobian function fails while initialize IDA solver!");
   } else {
     infoStreamPrint(LOG_SOLVER, 0, "jacobian is calculated by %s", JACOBIAN_METHOD_DESC[idaData->jacobianMethod]);
   }
 
+  /* if FLAG_IDA_PREC is set, choose the preconditioner of the iterative linear solvers */
+  if (omc_flag[FLAG_IDA_PREC])
+  {
+    int precMethod = IDA_PREC_UNKNOWN;
+    int refresh = 10;
+
+    for(i=1; i< IDA_PREC_MAX;i++)
+    {
+      if(!strcmp((const char*)omc_flagValue[FLAG_IDA_PREC], IDA_PREC_METHOD[i])){
+        precMethod = (int)i;
+        break;
+      }
+    }
+    if(precMethod == IDA_PREC_UNKNOWN)
+    {
+      if (ACTIVE_WARNING_STREAM(LOG_SOLVER))
+      {
+        warningStreamPrint(LOG_SOLVER, 1, "unrecognized ida preconditioner %s, current options are:", (const char*)omc_flagValue[FLAG_IDA_PREC]);
+        for(i=1; i < IDA_PREC_MAX; ++i)
+        {
+          warningStreamPrint(LOG_SOLVER, 0, "%-15s [%s]", IDA_PREC_METHOD[i], IDA_PREC_METHOD_DESC[i]);
+        }
+        messageClose(LOG_SOLVER);
+      }
+      throwStreamPrint(threadData,"unrecognized ida preconditioner %s", (const char*)omc_flagValue[FLAG_IDA_PREC]);
+    }
+
+    if (omc_flag[FLAG_IDA_PREC_REFRESH])
+    {
+      refresh = atoi(omc_flagValue[FLAG_IDA_PREC_REFRESH]);
+      assertStreamPrint(threadData, refresh >= 0, "Selected preconditioner refresh %d is negative.", refresh);
+    }
+
+    if (precMethod == IDA_PREC_NONE)
+    {
+      /* nothing to do */
+    }
+    else if (idaData->linearSolverMethod != IDA_LS_SPGMR &&
+             idaData->linearSolverMethod != IDA_LS_SPBCG &&
+             idaData->linearSolverMethod != IDA_LS_SPTFQMR)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "-idaPrec is only used by the iterative linear solvers of ida and is ignored.");
+    }
+    else
+    {
+      SPARSE_PATTERN *pattern = NULL;
+      unsigned int *colPtr;
+
+      if (idaData->daeMode)
+      {
+        pattern = data->simulationInfo->daeModeData->sparsePattern;
+      }
+      else if (idaData->jacobianMethod == COLOREDNUMJAC || idaData->jacobianMethod == COLOREDSYMJAC ||
+               idaData->jacobianMethod == SYMJAC)
+      {
+        pattern = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+      }
+      if (!pattern)
+      {
+        throwStreamPrint(threadData, "The ida preconditioner needs the sparsity pattern of the jacobian, the jacobian calculation method has to be %s or %s",
+                         JACOBIAN_METHOD[COLOREDNUMJAC], JACOBIAN_METHOD[COLOREDSYMJAC]);
+      }
+
+      /* in daeMode the leadindex holds the begin of each column, else the end */
+      colPtr = (unsigned int*) malloc((idaData->N+1)*sizeof(unsigned int));
+      if (idaData->daeMode)
+      {
+        memcpy(colPtr, pattern->leadindex, (idaData->N+1)*sizeof(unsigned int));
+      }
+      else
+      {
+        colPtr[0] = 0;
+        memcpy(colPtr + 1, pattern->leadindex, idaData->N*sizeof(unsigned int));
+      }
+
+      idaData->NNZ = pattern->numberOfNoneZeros;
+      idaData->precJac = NewSparseMat(idaData->N, idaData->N, idaData->NNZ);
+      idaData->preconditioner = ida_prec_allocate(precMethod, refresh, idaData->N, colPtr, pattern->index);
+      free(colPtr);
+
+      flag = IDASpilsSetPreconditioner(idaData->ida_mem, precSetupIDA, precSolveIDA);
+      if (checkIDAflag(flag)){
+        throwStreamPrint(threadData, "##IDA## Setting the preconditioner fails while initialize IDA solver!");
+      }
+    }
+    infoStreamPrint(LOG_SOLVER, 0, "IDA preconditioner selected %s", IDA_PREC_METHOD_DESC[precMethod]);
+  }
+
   /* set max error test fails */
   if (omc_flag[FLAG_IDA_MAXERRORTESTFAIL])
   {
@@ -595,6 +734,27 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
     }
   }
 
+  /* configure the adjoint sensitivities */
+  idaData->adjoint = NULL;
+  if (omc_flag[FLAG_IDA_ADJOINT])
+  {
+    if (idaData->daeMode || idaData->idaSmode)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "-idaAdjoint is not supported together with -daeMode or -idaSensitivity and is ignored.");
+    }
+    else
+    {
+      SPARSE_PATTERN *pattern = NULL;
+      if (idaData->jacobianMethod == COLOREDNUMJAC || idaData->jacobianMethod == COLOREDSYMJAC ||
+          idaData->jacobianMethod == KLUSPARSE || idaData->jacobianMethod == SYMJAC)
+      {
+        pattern = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+      }
+      idaData->adjoint = ida_adjoint_allocate(data, threadData, idaData->ida_mem, pattern,
+          idaData->jacobianMethod == COLOREDSYMJAC || idaData->jacobianMethod == SYMJAC);
+    }
+  }
+
   free(tmp);
   TRACE_POP
   return 0;
@@ -627,6 +787,21 @@ ida_solver_deinitial(IDA_SOLVER *idaData){
     N_VDestroyVectorArray_Serial(idaData->ySResult, idaData->Np);
   }
 
+  if (idaData->adjoint)
+  {
+    ida_adjoint_free(idaData->adjoint);
+  }
+
+  freeJacobianWorkersIDA(idaData);
+
+  if (idaData->preconditioner)
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "##IDA## preconditioner: %lu setups, %lu jacobian evaluations, %lu solves",
+                    idaData->preconditioner->numSetups, idaData->preconditioner->numJacobians, idaData->preconditioner->numSolves);
+    ida_prec_free(idaData->preconditioner);
+    DestroySparseMat(idaData->precJac);
+  }
+
   N_VDestroy_Serial(idaData->errwgt);
   N_VDestroy_Serial(idaData->newdelta);
 
@@ -646,7 +821,6 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   int retVal = 0, finished = FALSE;
   int saveJumpState;
   long int tmp;
-  static unsigned int stepsOutputCounter = 1;
   int stepsMode;
 
   IDA_SOLVER *idaData = (IDA_SOLVER*) solverInfo->solverData;
@@ -708,6 +882,13 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
       }
     }
 
+    /* the checkpoints do not cover a restart of the integration */
+    if (idaData->adjoint && idaData->adjoint->forwardStarted && idaData->adjoint->valid)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "##IDA## Adjoint sensitivities are disabled due to an event at time %g.", solverInfo->currentTime);
+      idaData->adjoint->valid = 0;
+    }
+
     idaData->setInitialSolution = 1;
   }
 
@@ -775,7 +956,16 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
     externalInputUpdate(data);
     data->callback->input_function(data, threadData);
 
-    flag = IDASolve(idaData->ida_mem, tout, &solverInfo->currentTime, idaData->y, idaData->yp, stepsMode);
+    if (idaData->adjoint && idaData->adjoint->valid)
+    {
+      int ncheck;
+      flag = IDASolveF(idaData->ida_mem, tout, &solverInfo->currentTime, idaData->y, idaData->yp, stepsMode, &ncheck);
+      idaData->adjoint->forwardStarted = 1;
+    }
+    else
+    {
+      flag = IDASolve(idaData->ida_mem, tout, &solverInfo->currentTime, idaData->y, idaData->yp, stepsMode);
+    }
 
     /* set time to current time */
     sData->timeValue = solverInfo->currentTime;
@@ -815,20 +1005,20 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
     /* emit step, if step mode is selected */
     if (idaData->internalSteps)
     {
-      infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant stepsOutputCounter %d by freq %d at time = %.15g", stepsOutputCounter, idaData->stepsFreq, solverInfo->currentTime);
+      infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant stepsOutputCounter %d by freq %d at time = %.15g", idaData->stepsOutputCounter, idaData->stepsFreq, solverInfo->currentTime);
       if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ]){
         /* output every n-th time step */
-        if (stepsOutputCounter >= idaData->stepsFreq){
-          stepsOutputCounter = 1; /* next line set it to one */
-          infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant output %d by freq at time = %.15g", stepsOutputCounter, solverInfo->currentTime);
+        if (idaData->stepsOutputCounter >= idaData->stepsFreq){
+          idaData->stepsOutputCounter = 1; /* next line set it to one */
+          infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant output %d by freq at time = %.15g", idaData->stepsOutputCounter, solverInfo->currentTime);
           break;
         }
-        stepsOutputCounter++;
+        idaData->stepsOutputCounter++;
       } else if (omc_flag[FLAG_NOEQUIDISTANT_OUT_TIME]){
         /* output when time>=k*timeValue */
-        if (solverInfo->currentTime > stepsOutputCounter * idaData->stepsTime){
-          stepsOutputCounter++;
-          infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant output %d by time freq at time = %.15g", stepsOutputCounter, solverInfo->currentTime);
+        if (solverInfo->currentTime > idaData->stepsOutputCounter * idaData->stepsTime){
+          idaData->stepsOutputCounter++;
+          infoStreamPrint(LOG_SOLVER, 0, "##IDA## noEquadistant output %d by time freq at time = %.15g", idaData->stepsOutputCounter, solverInfo->currentTime);
           break;
         }
       } else {
@@ -890,10 +1080,16 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   {
     flag = IDASlsGetNumJacEvals(idaData->ida_mem, &tmp);
   }
-  else
+  else if (idaData->linearSolverMethod == IDA_LS_DENSE)
   {
     flag = IDADlsGetNumJacEvals(idaData->ida_mem, &tmp);
   }
+  else if (idaData->preconditioner)
+  {
+    /* jacobians of the preconditioner of the iterative solvers */
+    tmp = idaData->preconditioner->numJacobians;
+    flag = IDA_SUCCESS;
+  }
 
   if (flag == IDA_SUCCESS)
   {
@@ -922,6 +1118,23 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   return retVal;
 }
 
+/* backward integration of the adjoint sensitivities after the simulation */
+int
+ida_solver_adjoint(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  TRACE_PUSH
+  IDA_SOLVER *idaData = (IDA_SOLVER*) solverInfo->solverData;
+  int retVal = 0;
+
+  if (idaData->adjoint)
+  {
+    retVal = ida_adjoint_solve(idaData->adjoint, idaData->ida_mem, data->simulationInfo->startTime, solverInfo->currentTime);
+  }
+
+  TRACE_POP
+  return retVal;
+}
+
 int residualFunctionIDA(double time, N_Vector yy, N_Vector yp, N_Vector res, void* userData)
 {
   TRACE_PUSH
@@ -967,6 +1180,11 @@ int residualFunctionIDA(double time, N_Vector yy, N_Vector yp, N_Vector res, voi
     memcpy(data->localData[0]->realVars + data->modelData->nStates, statesDer, sizeof(double)*data->modelData->nStates);
     data->simulationInfo->daeModeData->setAlgebraicDAEVars(data, threadData, states + data->modelData->nStates);
   }
+  else if (states != data->localData[0]->realVars)
+  {
+    /* the residual is evaluated at vectors of ida, e.g. by the jacobian-vector products of the iterative solvers */
+    memcpy(data->localData[0]->realVars, states, sizeof(double)*data->modelData->nStates);
+  }
 
   /* debug */
   if (ACTIVE_STREAM(LOG_DASSL_STATES)){
@@ -1003,6 +1221,10 @@ int residualFunctionIDA(double time, N_Vector yy, N_Vector yp, N_Vector res, voi
   }
 
   printVector(LOG_DASSL_STATES, "delta", delta, idaData->N, time);
+
+  /* remember the point for the generated jacobian, perturbed points of jacobian evaluations are not */
+  idaData->lastResidualStates = (data->simulationInfo->currentContext == CONTEXT_JACOBIAN) ? NULL : states;
+  idaData->lastResidualTime = time;
   success = 1;
 #if !defined(OMC_EMCC)
   MMC_CATCH_INTERNAL(simulationJumpBuffer)
@@ -1063,6 +1285,7 @@ int rootsFunctionIDA(double time, N_Vector yy, N_Vector yp, double *gout, void*
   }
 
   data->callback->function_ZeroCrossings(data, threadData, gout);
+  idaData->lastResidualStates = NULL;
 
   threadData->currentErrorStage = saveJumpState;
   data->localData[0]->timeValue = timeBackup;
@@ -1077,6 +1300,200 @@ int rootsFunctionIDA(double time, N_Vector yy, N_Vector yp, double *gout, void*
 }
 
 
+/* per worker data of -jacobianThreads */
+typedef struct IDA_JACOBIAN_WORKER
+{
+  IDA_SOLVER idaData;            /* copy of the integrator data with simData of the worker */
+  IDA_USERDATA simData;
+  N_Vector y;
+  N_Vector yp;
+  N_Vector newdelta;
+  double *states;                /* y and yp if they are not part of the model variables */
+  double *statesDer;
+  double *delta_hh;
+} IDA_JACOBIAN_WORKER;
+
+/* arguments of the colored jacobians for the workers of -jacobianThreads */
+typedef struct IDA_JACOBIAN_JOB
+{
+  IDA_SOLVER *idaData;
+  SPARSE_PATTERN *sparsePattern;
+  double tt;
+  double cj;
+  double currentStep;
+  double *states;
+  double *yprime;
+  int statesInModel;             /* ODE mode: states or yprime are the model variables of localData[0], */
+  int yprimeInModel;             /* the workers use their own model variables then */
+  double *delta;
+  double *errwgt;
+  DlsMat denseJac;               /* either the dense or the sparse jacobian is set */
+  SlsMat sparseJac;
+} IDA_JACOBIAN_JOB;
+
+/*
+ * creates the worker pool at the first evaluation, the model is initialized
+ * by then
+ */
+static void allocateJacobianWorkersIDA(IDA_SOLVER *idaData, DATA* data, threadData_t *threadData)
+{
+  int i;
+
+  idaData->jacobianPool = allocateParallelJacobian(data, threadData, idaData->jacobianThreads);
+  idaData->jacobianWorkers = (IDA_JACOBIAN_WORKER*) calloc(idaData->jacobianPool->nThreads, sizeof(IDA_JACOBIAN_WORKER));
+  assertStreamPrint(threadData, 0 != idaData->jacobianWorkers, "out of memory");
+
+  for(i = 0; i < idaData->jacobianPool->nThreads; i++)
+  {
+    IDA_JACOBIAN_WORKER *worker = &idaData->jacobianWorkers[i];
+    DATA *workerData = &idaData->jacobianPool->workers[i].data;
+
+    worker->simData.data = workerData;
+    worker->simData.threadData = &idaData->jacobianPool->workers[i].threadData;
+    worker->idaData = *idaData;
+    worker->idaData.simData = &worker->simData;
+    worker->states = (double*) malloc(idaData->N*sizeof(double));
+    worker->statesDer = (double*) malloc(idaData->N*sizeof(double));
+    worker->y = N_VMake_Serial(idaData->N, worker->states);
+    worker->yp = N_VMake_Serial(idaData->N, worker->statesDer);
+    worker->newdelta = N_VNew_Serial(idaData->N);
+    worker->delta_hh = (double*) malloc(idaData->N*sizeof(double));
+  }
+}
+
+static void freeJacobianWorkersIDA(IDA_SOLVER *idaData)
+{
+  int i;
+
+  if (!idaData->jacobianPool)
+  {
+    return;
+  }
+
+  for(i = 0; i < idaData->jacobianPool->nThreads; i++)
+  {
+    IDA_JACOBIAN_WORKER *worker = &idaData->jacobianWorkers[i];
+    N_VDestroy_Serial(worker->y);
+    N_VDestroy_Serial(worker->yp);
+    N_VDestroy_Serial(worker->newdelta);
+    free(worker->states);
+    free(worker->statesDer);
+    free(worker->delta_hh);
+  }
+  free(idaData->jacobianWorkers);
+  freeParallelJacobian(idaData->jacobianPool);
+  idaData->jacobianWorkers = NULL;
+  idaData->jacobianPool = NULL;
+}
+
+/*
+ *  evaluates the columns of one color on a worker of -jacobianThreads,
+ *  the columns are stored directly into the shared jacobian
+ */
+static void jacobianColorWorkerIDA(DATA* data, threadData_t *threadData, int workerIndex, unsigned int color, void *userData)
+{
+  IDA_JACOBIAN_JOB *job = (IDA_JACOBIAN_JOB*) userData;
+  IDA_SOLVER *idaData = job->idaData;
+  IDA_JACOBIAN_WORKER *worker = &idaData->jacobianWorkers[workerIndex];
+  SPARSE_PATTERN *sparsePattern = job->sparsePattern;
+
+  double *states, *yprime;
+  double *newdelta = N_VGetArrayPointer(worker->newdelta);
+  double *delta_hh = worker->delta_hh;
+
+  double delta_h = idaData->sqrteps;
+  double delta_hhh;
+  long int j,l,ii,start,end;
+
+  /* alias the model variables of the worker where the serial evaluation aliases the ones of data */
+  N_VSetArrayPointer(job->statesInModel ? data->localData[0]->realVars : worker->states, worker->y);
+  N_VSetArrayPointer(job->yprimeInModel ? data->localData[0]->realVars + data->modelData->nStates : worker->statesDer, worker->yp);
+  states = N_VGetArrayPointer(worker->y);
+  yprime = N_VGetArrayPointer(worker->yp);
+
+  memcpy(states, job->states, idaData->N*sizeof(double));
+  memcpy(yprime, job->yprime, idaData->N*sizeof(double));
+
+  for(ii=0; ii < idaData->N; ii++)
+  {
+    if(sparsePattern->colorCols[ii]-1 == color)
+    {
+      delta_hhh = job->currentStep * yprime[ii];
+      delta_hh[ii] = delta_h * fmax(fmax(fabs(states[ii]),fabs(delta_hhh)),fabs(1./job->errwgt[ii]));
+      delta_hh[ii] = (delta_hhh >= 0 ? delta_hh[ii] : -delta_hh[ii]);
+      delta_hh[ii] = (states[ii] + delta_hh[ii]) - states[ii];
+      states[ii] += delta_hh[ii];
+
+      if (idaData->daeMode){
+        yprime[ii] += job->cj * delta_hh[ii];
+      }
+
+      delta_hh[ii] = 1. / delta_hh[ii];
+    }
+  }
+
+  (*idaData->residualFunction)(job->tt, worker->y, worker->yp, worker->newdelta, &worker->idaData);
+
+  for(ii = 0; ii < idaData->N; ii++)
+  {
+    if(sparsePattern->colorCols[ii]-1 == color)
+    {
+      if (idaData->daeMode)
+      {
+        start = sparsePattern->leadindex[ii];
+        end = sparsePattern->leadindex[ii+1];
+      }
+      else
+      {
+        start = (ii == 0) ? 0 : sparsePattern->leadindex[ii-1];
+        end = sparsePattern->leadindex[ii];
+      }
+      for(j = start; j < end; j++)
+      {
+        l = sparsePattern->index[j];
+        if (job->denseJac)
+        {
+          DENSE_ELEM(job->denseJac, l, ii) = (newdelta[l] - job->delta[l]) * delta_hh[ii];
+        }
+        else
+        {
+          setJacElementKluSparse(l, ii, (newdelta[l] - job->delta[l]) * delta_hh[ii], j, job->sparseJac);
+        }
+      }
+    }
+  }
+}
+
+/*
+ * evaluates a colored jacobian on the workers of -jacobianThreads
+ */
+static void jacobianColoredParallelIDA(IDA_SOLVER *idaData, DATA* data, SPARSE_PATTERN *sparsePattern, double tt, double cj, double currentStep,
+    N_Vector yy, N_Vector yp, N_Vector rr, DlsMat denseJac, SlsMat sparseJac)
+{
+  threadData_t* threadData = (threadData_t*)(((IDA_USERDATA*)idaData->simData)->threadData);
+  IDA_JACOBIAN_JOB job;
+
+  job.idaData = idaData;
+  job.sparsePattern = sparsePattern;
+  job.tt = tt;
+  job.cj = cj;
+  job.currentStep = currentStep;
+  job.states = N_VGetArrayPointer(yy);
+  job.yprime = N_VGetArrayPointer(yp);
+  job.statesInModel = !idaData->daeMode && job.states == data->localData[0]->realVars;
+  job.yprimeInModel = !idaData->daeMode && job.yprime == data->localData[0]->realVars + data->modelData->nStates;
+  job.delta = N_VGetArrayPointer(rr);
+  job.errwgt = N_VGetArrayPointer(idaData->errwgt);
+  job.denseJac = denseJac;
+  job.sparseJac = sparseJac;
+
+  if (!idaData->jacobianPool)
+  {
+    allocateJacobianWorkersIDA(idaData, data, threadData);
+  }
+  evalParallelJacobianColors(idaData->jacobianPool, data, threadData, sparsePattern->maxColors, jacobianColorWorkerIDA, &job);
+}
+
 /*
  *  function calculates a jacobian matrix by
  *  numerical method finite differences with coloring
@@ -1126,13 +1543,25 @@ int jacOwnNumColoredIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, DlsMat
 
   setContext(data, &tt, CONTEXT_JACOBIAN);
 
+  if (idaData->jacobianThreads > 1)
+  {
+    jacobianColoredParallelIDA(idaData, data, sparsePattern, tt, cj, currentStep, yy, yp, rr, Jac, NULL);
+    unsetContext(data);
+    TRACE_POP
+    return 0;
+  }
+
+  /* in ODE mode yprime may be overwritten by the residual function, the
+   * increments are taken from the values IDA passed in */
+  memcpy(ypsave, yprime, idaData->N*sizeof(double));
+
   for(i = 0; i < sparsePattern->maxColors; i++)
   {
     for(ii=0; ii < idaData->N; ii++)
     {
       if(sparsePattern->colorCols[ii]-1 == i)
       {
-        delta_hhh = currentStep * yprime[ii];
+        delta_hhh = currentStep * ypsave[ii];
         delta_hh[ii] = delta_h * fmax(fmax(fabs(states[ii]),fabs(delta_hhh)),fabs(1./errwgt[ii]));
         delta_hh[ii] = (delta_hhh >= 0 ? delta_hh[ii] : -delta_hh[ii]);
         delta_hh[ii] = (states[ii] + delta_hh[ii]) - states[ii];
@@ -1140,7 +1569,6 @@ int jacOwnNumColoredIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, DlsMat
         states[ii] += delta_hh[ii];
 
         if (idaData->daeMode){
-          ypsave[ii] = yprime[ii];
           yprime[ii] += cj * delta_hh[ii];
         }
 
@@ -1187,6 +1615,7 @@ int jacOwnNumColoredIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, DlsMat
       }
     }
   }
+  memcpy(yprime, ypsave, idaData->N*sizeof(double));
   unsetContext(data);
 
   TRACE_POP
@@ -1413,13 +1842,27 @@ int jacobianSparseNumIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, SlsMa
 
   setContext(data, &tt, CONTEXT_JACOBIAN);
 
+  if (idaData->jacobianThreads > 1)
+  {
+    jacobianColoredParallelIDA(idaData, data, sparsePattern, tt, cj, currentStep, yy, yp, rr, NULL, Jac);
+    /* finish matrix colptrs */
+    Jac->colptrs[idaData->N] = idaData->NNZ;
+    unsetContext(data);
+    TRACE_POP
+    return 0;
+  }
+
+  /* in ODE mode yprime may be overwritten by the residual function, the
+   * increments are taken from the values IDA passed in */
+  memcpy(ypsave, yprime, idaData->N*sizeof(double));
+
   for(i = 0; i < sparsePattern->maxColors; i++)
   {
     for(ii=0; ii < idaData->N; ii++)
     {
       if(sparsePattern->colorCols[ii]-1 == i)
       {
-        delta_hhh = currentStep * yprime[ii];
+        delta_hhh = currentStep * ypsave[ii];
         delta_hh[ii] = delta_h * fmax(fmax(fabs(states[ii]),fabs(delta_hhh)),fabs(1./errwgt[ii]));
         delta_hh[ii] = (delta_hhh >= 0 ? delta_hh[ii] : -delta_hh[ii]);
         delta_hh[ii] = (states[ii] + delta_hh[ii]) - states[ii];
@@ -1427,7 +1870,6 @@ int jacobianSparseNumIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, SlsMa
         states[ii] += delta_hh[ii];
 
         if (idaData->daeMode){
-          ypsave[ii] = yprime[ii];
           yprime[ii] += cj * delta_hh[ii];
         }
 
@@ -1471,6 +1913,7 @@ int jacobianSparseNumIDA(double tt, N_Vector yy, N_Vector yp, N_Vector rr, SlsMa
       }
     }
   }
+  memcpy(yprime, ypsave, idaData->N*sizeof(double));
   /* finish matrix colptrs */
   Jac->colptrs[idaData->N] = idaData->NNZ;
 
@@ -1524,4 +1967,185 @@ static int jacobianSparseNum(double tt, double cj,
   return 0;
 }
 
+/*
+ * evaluates the model at (tt, yy) for the generated jacobian, unless
+ * the last residual evaluation was already done at this point
+ */
+static int setJacobianPointIDA(IDA_SOLVER* idaData, double tt, N_Vector yy, N_Vector yp, N_Vector tmp)
+{
+  if (idaData->lastResidualStates == N_VGetArrayPointer(yy) && idaData->lastResidualTime == tt)
+  {
+    return 0;
+  }
+  return (*idaData->residualFunction)(tt, yy, yp, tmp, idaData);
+}
+
+/*
+ *  function calculates the colored generated jacobian A
+ *  into a sparse SlsMat matrix
+ */
+static
+int jacobianSparseSymIDA(double tt, N_Vector yy, N_Vector yp, SlsMat Jac, void *userData, N_Vector tmp)
+{
+  TRACE_PUSH
+  IDA_SOLVER* idaData = (IDA_SOLVER*)userData;
+  DATA* data = (DATA*)(((IDA_USERDATA*)idaData->simData)->data);
+  threadData_t* threadData = (threadData_t*)(((IDA_USERDATA*)idaData->simData)->threadData);
+  const int index = data->callback->INDEX_JAC_A;
+  ANALYTIC_JACOBIAN* jacA = &(data->simulationInfo->analyticJacobians[index]);
+  SPARSE_PATTERN* sparsePattern = &(jacA->sparsePattern);
+  double timeBackup;
+  long int i,j,ii;
+  int nth;
+
+  if (setJacobianPointIDA(idaData, tt, yy, yp, tmp))
+  {
+    TRACE_POP
+    return 1;
+  }
+
+  /* it's needed to clear the matrix */
+  SlsSetToZero(Jac);
+
+  setContext(data, &tt, CONTEXT_JACOBIAN);
+  timeBackup = data->localData[0]->timeValue;
+  data->localData[0]->timeValue = tt;
+
+  for(i = 0; i < sparsePattern->maxColors; i++)
+  {
+    for(ii=0; ii < idaData->N; ii++)
+    {
+      if(sparsePattern->colorCols[ii]-1 == i)
+      {
+        jacA->seedVars[ii] = 1.0;
+      }
+    }
+
+    data->callback->functionJacA_column(data, threadData);
+    increaseJacContext(data);
+
+    for(ii = 0; ii < idaData->N; ii++)
+    {
+      if(sparsePattern->colorCols[ii]-1 == i)
+      {
+        nth = (ii == 0) ?  0 : sparsePattern->leadindex[ii-1];
+        while(nth < sparsePattern->leadindex[ii])
+        {
+          j  =  sparsePattern->index[nth];
+          setJacElementKluSparse(j, ii, jacA->resultVars[j], nth, Jac);
+          nth++;
+        };
+        jacA->seedVars[ii] = 0.0;
+      }
+    }
+  }
+  /* finish matrix colptrs */
+  Jac->colptrs[idaData->N] = idaData->NNZ;
+
+  data->localData[0]->timeValue = timeBackup;
+  unsetContext(data);
+
+  TRACE_POP
+  return 0;
+}
+
+/*
+ * preconditioner setup of the iterative linear solvers, see -idaPrec and -idaPrecRefresh
+ * In daeMode the jacobian already contains cj and is evaluated at every setup.
+ */
+static int precSetupIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    realtype cj, void *user_data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+  TRACE_PUSH
+  IDA_SOLVER* idaData = (IDA_SOLVER*)user_data;
+  long int convFails = 0;
+  int retVal;
+
+  IDAGetNumNonlinSolvConvFails(idaData->ida_mem, &convFails);
+
+  if (idaData->daeMode || ida_prec_needJacobian(idaData->preconditioner, convFails))
+  {
+    if (idaData->jacobianMethod == COLOREDSYMJAC || idaData->jacobianMethod == SYMJAC)
+    {
+      retVal = jacobianSparseSymIDA(tt, yy, yp, idaData->precJac, user_data, tmp1);
+    }
+    else
+    {
+      retVal = jacobianSparseNumIDA(tt, yy, yp, rr, idaData->precJac, cj, user_data);
+    }
+    if (retVal)
+    {
+      TRACE_POP
+      return 1;
+    }
+
+    /* debug */
+    if (ACTIVE_STREAM(LOG_JAC)){
+      infoStreamPrint(LOG_JAC, 0, "##IDA## Sparse Matrix of the preconditioner.");
+      PrintSparseMat(idaData->precJac);
+    }
+    ida_prec_setJacobian(idaData->preconditioner, idaData->precJac->data);
+  }
+
+  retVal = ida_prec_factorize(idaData->preconditioner, idaData->daeMode ? 0.0 : -cj);
+
+  TRACE_POP
+  return retVal;
+}
+
+/*
+ * preconditioner solve of the iterative linear solvers
+ */
+static int precSolveIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    N_Vector rvec, N_Vector zvec, realtype cj, realtype delta, void *user_data, N_Vector tmp)
+{
+  IDA_SOLVER* idaData = (IDA_SOLVER*)user_data;
+
+  ida_prec_solve(idaData->preconditioner, N_VGetArrayPointer(rvec), N_VGetArrayPointer(zvec));
+
+  return 0;
+}
+
+/*
+ * jacobian times vector of the iterative linear solvers with the
+ * generated directional derivative: Jv = A*v - cj*v
+ */
+static int jacTimesVecIDA(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+    N_Vector v, N_Vector Jv, realtype cj, void *user_data, N_Vector tmp1, N_Vector tmp2)
+{
+  TRACE_PUSH
+  IDA_SOLVER* idaData = (IDA_SOLVER*)user_data;
+  DATA* data = (DATA*)(((IDA_USERDATA*)idaData->simData)->data);
+  threadData_t* threadData = (threadData_t*)(((IDA_USERDATA*)idaData->simData)->threadData);
+  ANALYTIC_JACOBIAN* jacA = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
+  double *vv = N_VGetArrayPointer(v);
+  double *jv = N_VGetArrayPointer(Jv);
+  double timeBackup;
+  long int i;
+
+  if (setJacobianPointIDA(idaData, tt, yy, yp, tmp1))
+  {
+    TRACE_POP
+    return 1;
+  }
+
+  setContext(data, &tt, CONTEXT_JACOBIAN);
+  timeBackup = data->localData[0]->timeValue;
+  data->localData[0]->timeValue = tt;
+
+  memcpy(jacA->seedVars, vv, idaData->N*sizeof(double));
+  data->callback->functionJacA_column(data, threadData);
+  for(i = 0; i < idaData->N; i++)
+  {
+    jv[i] = jacA->resultVars[i] - cj * vv[i];
+  }
+  memset(jacA->seedVars, 0, idaData->N*sizeof(double));
+
+  data->localData[0]->timeValue = timeBackup;
+  unsetContext(data);
+
+  TRACE_POP
+  return 0;
+}
+
 #endif
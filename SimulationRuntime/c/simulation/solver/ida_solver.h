@@ -38,6 +38,9 @@
 #include "simulation_data.h"
 #include "util/simulation_options.h"
 #include "simulation/solver/solver_main.h"
+#include "simulation/solver/parallel_jacobian.h"
+#include "simulation/solver/ida_adjoint.h"
+#include "simulation/solver/ida_preconditioner.h"
 
 #ifdef WITH_SUNDIALS
 
@@ -62,6 +65,7 @@ typedef struct IDA_SOLVER
   int internalSteps;             /* if = 1 internal step of the integrator are used  */
   unsigned int stepsFreq;        /* value specifies the output frequency regarding to time steps. Used in internal steps mode. */
   double stepsTime;              /* value specifies the time increment when output happens. Used in internal steps mode. */
+  unsigned int stepsOutputCounter; /* number of the next output in internal steps mode */
 
 
   /* ### work arrays ### */
@@ -82,6 +86,17 @@ typedef struct IDA_SOLVER
   SlsMat tmpJac;
   DlsMat denseJac;
 
+  /* ### parallel evaluation of colored numerical jacobians (-jacobianThreads) */
+  int jacobianThreads;
+  PARALLEL_JACOBIAN *jacobianPool;                /* created at the first evaluation */
+  struct IDA_JACOBIAN_WORKER *jacobianWorkers;
+
+  /* ### preconditioner and jacobian times vector of the iterative linear solvers */
+  IDA_PRECONDITIONER *preconditioner;   /* NULL if -idaPrec is not used */
+  SlsMat precJac;                       /* jacobian of the preconditioner in the order of the sparsity pattern */
+  double *lastResidualStates;           /* point of the last residual evaluation outside of a jacobian evaluation */
+  double lastResidualTime;
+
   /* ### daeMode ### */
   int daeMode;                  /* if TRUE then solve dae more with a reals residual function */
   long int N;
@@ -97,6 +112,9 @@ typedef struct IDA_SOLVER
   N_Vector* ySp;
   N_Vector* ySResult;
 
+  /* ### ida adjoint sensitivities ### */
+  IDA_ADJOINT* adjoint;         /* NULL if -idaAdjoint is not used */
+
 }IDA_SOLVER;
 
 /* initial main ida Data */
@@ -111,6 +129,12 @@ ida_solver_deinitial(IDA_SOLVER *idaData);
 int
 ida_solver_step(DATA* simData, threadData_t *threadData, SOLVER_INFO* solverInfo);
 
+/* backward integration of the adjoint sensitivities after the simulation */
+int
+ida_solver_adjoint(DATA* simData, threadData_t *threadData, SOLVER_INFO* solverInfo);
+
+int checkIDAflag(int flag);
+
 #endif
 
 #endif
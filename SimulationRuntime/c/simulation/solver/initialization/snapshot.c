@@ -0,0 +1,480 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file snapshot.c
+ *
+ *  A snapshot contains everything the solver needs to continue a simulation
+ *  without running the initialization: the ring buffer, pre-values,
+ *  relations, zero crossings, the sample and delay state and the last
+ *  solutions of the linear and non-linear systems. The header stores the
+ *  model GUID and a hash of the variable layout; snapshots of other models
+ *  or other translations are rejected. Changed parameters are only reported,
+ *  since the parameters of the current run are used anyway.
+ *
+ *  The data is written in native byte order.
+ */
+
+#include "snapshot.h"
+#include "initialization.h"
+
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "util/ringbuffer.h"
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/synchronous.h"
+#include "meta/meta_modelica.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if !defined(OMC_MINIMAL_RUNTIME)
+
+#define SNAPSHOT_MAGIC "OMSNAP01"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+typedef struct SNAPSHOT_FILE
+{
+  FILE *file;
+  int failed;                   /* set on the first i/o error or size mismatch */
+} SNAPSHOT_FILE;
+
+static uint64_t fnv1a(uint64_t hash, const void *buffer, size_t size)
+{
+  const unsigned char *p = (const unsigned char*) buffer;
+  size_t i;
+
+  for(i=0; i<size; ++i) {
+    hash ^= p[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+static uint64_t fnv1aString(uint64_t hash, const char *s)
+{
+  return fnv1a(hash, s, strlen(s)+1);
+}
+
+/*! \fn layoutHash
+ *
+ *  Hash of all sizes and variable names, i.e. of everything that has to
+ *  match for the stored arrays to be meaningful.
+ */
+static uint64_t layoutHash(DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  uint64_t hash = FNV_OFFSET_BASIS;
+  long i;
+  long sizes[] = {
+    mData->nStates, mData->nVariablesReal, mData->nVariablesInteger, mData->nVariablesBoolean,
+    mData->nVariablesString, mData->nParametersReal, mData->nParametersInteger,
+    mData->nParametersBoolean, mData->nParametersString, mData->nZeroCrossings,
+    mData->nRelations, mData->nMathEvents, mData->nDelayExpressions, mData->nSamples,
+    mData->nLinearSystems, mData->nNonLinearSystems
+  };
+
+  hash = fnv1a(hash, sizes, sizeof(sizes));
+  for(i=0; i<mData->nVariablesReal; ++i) {
+    hash = fnv1aString(hash, mData->realVarsData[i].info.name);
+  }
+  for(i=0; i<mData->nVariablesInteger; ++i) {
+    hash = fnv1aString(hash, mData->integerVarsData[i].info.name);
+  }
+  for(i=0; i<mData->nVariablesBoolean; ++i) {
+    hash = fnv1aString(hash, mData->booleanVarsData[i].info.name);
+  }
+  for(i=0; i<mData->nVariablesString; ++i) {
+    hash = fnv1aString(hash, mData->stringVarsData[i].info.name);
+  }
+  for(i=0; i<mData->nNonLinearSystems; ++i) {
+    hash = fnv1a(hash, &data->simulationInfo->nonlinearSystemData[i].size, sizeof(modelica_integer));
+  }
+  for(i=0; i<mData->nLinearSystems; ++i) {
+    hash = fnv1a(hash, &data->simulationInfo->linearSystemData[i].size, sizeof(modelica_integer));
+  }
+  return hash;
+}
+
+/*! \fn parameterHash
+ *
+ *  Hash of all parameter values after updateBoundParameters.
+ */
+static uint64_t parameterHash(DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  uint64_t hash = FNV_OFFSET_BASIS;
+  long i;
+
+  hash = fnv1a(hash, sInfo->realParameter, mData->nParametersReal*sizeof(modelica_real));
+  hash = fnv1a(hash, sInfo->integerParameter, mData->nParametersInteger*sizeof(modelica_integer));
+  hash = fnv1a(hash, sInfo->booleanParameter, mData->nParametersBoolean*sizeof(modelica_boolean));
+  for(i=0; i<mData->nParametersString; ++i) {
+    hash = fnv1aString(hash, MMC_STRINGDATA(sInfo->stringParameter[i]));
+  }
+  return hash;
+}
+
+static void writeBytes(SNAPSHOT_FILE *f, const void *buffer, size_t size)
+{
+  if(!f->failed && size > 0 && 1 != fwrite(buffer, size, 1, f->file)) {
+    f->failed = 1;
+  }
+}
+
+static void readBytes(SNAPSHOT_FILE *f, void *buffer, size_t size)
+{
+  if(!f->failed && size > 0 && 1 != fread(buffer, size, 1, f->file)) {
+    f->failed = 1;
+  }
+}
+
+/* arrays are prefixed with their length, which is checked when reading */
+static void writeArray(SNAPSHOT_FILE *f, const void *buffer, size_t elemSize, long n)
+{
+  int64_t len = n;
+  writeBytes(f, &len, sizeof(int64_t));
+  writeBytes(f, buffer, elemSize*n);
+}
+
+static void readArray(SNAPSHOT_FILE *f, void *buffer, size_t elemSize, long n)
+{
+  int64_t len = -1;
+  readBytes(f, &len, sizeof(int64_t));
+  if(len != n) {
+    f->failed = 1;
+  }
+  readBytes(f, buffer, elemSize*n);
+}
+
+static void writeStrings(SNAPSHOT_FILE *f, modelica_string *strings, long n)
+{
+  long i;
+  writeArray(f, NULL, 0, n);
+  for(i=0; i<n; ++i) {
+    writeArray(f, MMC_STRINGDATA(strings[i]), 1, MMC_STRLEN(strings[i]));
+  }
+}
+
+static void readStrings(SNAPSHOT_FILE *f, modelica_string *strings, long n)
+{
+  long i;
+  int64_t len = -1;
+
+  readArray(f, NULL, 0, n);
+  for(i=0; i<n && !f->failed; ++i) {
+    char *buffer;
+    readBytes(f, &len, sizeof(int64_t));
+    if(f->failed || len < 0) {
+      f->failed = 1;
+      return;
+    }
+    buffer = (char*) malloc(len+1);
+    readBytes(f, buffer, len);
+    buffer[len] = '\0';
+    if(!f->failed) {
+      strings[i] = mmc_mk_scon_persist(buffer);
+    }
+    free(buffer);
+  }
+}
+
+static void writeSimulationData(SNAPSHOT_FILE *f, DATA *data, SIMULATION_DATA *sData)
+{
+  MODEL_DATA *mData = data->modelData;
+
+  writeBytes(f, &sData->timeValue, sizeof(modelica_real));
+  writeArray(f, sData->realVars, sizeof(modelica_real), mData->nVariablesReal);
+  writeArray(f, sData->integerVars, sizeof(modelica_integer), mData->nVariablesInteger);
+  writeArray(f, sData->booleanVars, sizeof(modelica_boolean), mData->nVariablesBoolean);
+  writeStrings(f, sData->stringVars, mData->nVariablesString);
+}
+
+static void readSimulationData(SNAPSHOT_FILE *f, DATA *data, SIMULATION_DATA *sData)
+{
+  MODEL_DATA *mData = data->modelData;
+
+  readBytes(f, &sData->timeValue, sizeof(modelica_real));
+  readArray(f, sData->realVars, sizeof(modelica_real), mData->nVariablesReal);
+  readArray(f, sData->integerVars, sizeof(modelica_integer), mData->nVariablesInteger);
+  readArray(f, sData->booleanVars, sizeof(modelica_boolean), mData->nVariablesBoolean);
+  readStrings(f, sData->stringVars, mData->nVariablesString);
+}
+
+/*! \fn writeSnapshot
+ *
+ *  \param [ref] [data]
+ *  \param [in]  [fileName]
+ *
+ *  Writes the current simulation state to fileName.
+ *  Returns 0 on success.
+ */
+int writeSnapshot(DATA *data, threadData_t *threadData, const char *fileName)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  SNAPSHOT_FILE f;
+  int32_t version = SNAPSHOT_VERSION, byteOrder = SNAPSHOT_BYTE_ORDER;
+  uint64_t hash;
+  long i, j;
+
+  f.failed = 0;
+  f.file = fopen(fileName, "wb");
+  if(!f.file) {
+    warningStreamPrint(LOG_STDOUT, 0, "Cannot open snapshot file %s for writing.", fileName);
+    return 1;
+  }
+
+  /* header */
+  writeBytes(&f, SNAPSHOT_MAGIC, 8);
+  writeBytes(&f, &version, sizeof(int32_t));
+  writeBytes(&f, &byteOrder, sizeof(int32_t));
+  writeArray(&f, mData->modelGUID, 1, strlen(mData->modelGUID));
+  hash = layoutHash(data);
+  writeBytes(&f, &hash, sizeof(uint64_t));
+  hash = parameterHash(data);
+  writeBytes(&f, &hash, sizeof(uint64_t));
+
+  /* ring buffer, current values first */
+  for(i=0; i<SIZERINGBUFFER; ++i) {
+    writeSimulationData(&f, data, data->localData[i]);
+  }
+
+  /* pre-values and event handling */
+  writeArray(&f, sInfo->realVarsPre, sizeof(modelica_real), mData->nVariablesReal);
+  writeArray(&f, sInfo->integerVarsPre, sizeof(modelica_integer), mData->nVariablesInteger);
+  writeArray(&f, sInfo->booleanVarsPre, sizeof(modelica_boolean), mData->nVariablesBoolean);
+  writeStrings(&f, sInfo->stringVarsPre, mData->nVariablesString);
+  writeArray(&f, sInfo->relations, sizeof(modelica_boolean), mData->nRelations);
+  writeArray(&f, sInfo->relationsPre, sizeof(modelica_boolean), mData->nRelations);
+  writeArray(&f, sInfo->zeroCrossings, sizeof(modelica_real), mData->nZeroCrossings);
+  writeArray(&f, sInfo->zeroCrossingsPre, sizeof(modelica_real), mData->nZeroCrossings);
+  writeArray(&f, sInfo->mathEventsValuePre, sizeof(modelica_real), mData->nMathEvents);
+  writeArray(&f, sInfo->samples, sizeof(modelica_boolean), mData->nSamples);
+  writeArray(&f, sInfo->nextSampleTimes, sizeof(double), mData->nSamples);
+  writeBytes(&f, &sInfo->nextSampleEvent, sizeof(double));
+
+  /* delay buffers */
+  for(i=0; i<mData->nDelayExpressions; ++i) {
+    RINGBUFFER *delayStructure = sInfo->delayStructure[i];
+    long length = ringBufferLength(delayStructure);
+    writeArray(&f, NULL, 0, length);
+    for(j=0; j<length; ++j) {
+      writeBytes(&f, getRingData(delayStructure, j), sizeof(TIME_AND_VALUE));
+    }
+  }
+
+  /* initial guesses of the algebraic loops */
+  for(i=0; i<mData->nNonLinearSystems; ++i) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    writeArray(&f, nonlinsys->nlsx, sizeof(modelica_real), nonlinsys->size);
+    writeArray(&f, nonlinsys->nlsxOld, sizeof(modelica_real), nonlinsys->size);
+    writeArray(&f, nonlinsys->nlsxExtrapolation, sizeof(modelica_real), nonlinsys->size);
+    writeBytes(&f, &nonlinsys->lastTimeSolved, sizeof(modelica_real));
+  }
+  for(i=0; i<mData->nLinearSystems; ++i) {
+    LINEAR_SYSTEM_DATA *linsys = &sInfo->linearSystemData[i];
+    writeArray(&f, linsys->x, sizeof(modelica_real), linsys->size);
+  }
+
+  if(fclose(f.file)) {
+    f.failed = 1;
+  }
+  if(f.failed) {
+    warningStreamPrint(LOG_STDOUT, 0, "Failed to write snapshot file %s.", fileName);
+    return 1;
+  }
+
+  infoStreamPrint(LOG_STDOUT, 0, "Wrote snapshot at time %g to %s.", data->localData[0]->timeValue, fileName);
+  return 0;
+}
+
+/*! \fn loadSnapshot
+ *
+ *  \param [ref] [data]
+ *  \param [in]  [fileName]
+ *
+ *  Replaces the initialization: sets up parameters and the static data of the
+ *  solvers as initialization() does and then restores the stored state
+ *  instead of solving the initial system.
+ *  Returns 0 on success.
+ */
+int loadSnapshot(DATA *data, threadData_t *threadData, const char *fileName)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  SNAPSHOT_FILE f;
+  char magic[8];
+  char *guid;
+  int32_t version = 0, byteOrder = 0;
+  int64_t guidLength = -1;
+  uint64_t hash;
+  long i, j;
+
+  infoStreamPrint(LOG_INIT, 0, "### START INITIALIZATION (snapshot %s) ###", fileName);
+
+  setAllParamsToStart(data);
+  data->callback->updateBoundParameters(data, threadData);
+  data->callback->updateBoundVariableAttributes(data, threadData);
+  setAllVarsToStart(data);
+
+  /* update static data of linear/non-linear system solvers */
+  updateStaticDataOfLinearSystems(data, threadData);
+  updateStaticDataOfNonlinearSystems(data, threadData);
+
+  f.failed = 0;
+  f.file = fopen(fileName, "rb");
+  if(!f.file) {
+    errorStreamPrint(LOG_STDOUT, 0, "Cannot open snapshot file %s.", fileName);
+    return 1;
+  }
+
+  /* header */
+  readBytes(&f, magic, 8);
+  readBytes(&f, &version, sizeof(int32_t));
+  readBytes(&f, &byteOrder, sizeof(int32_t));
+  if(f.failed || memcmp(magic, SNAPSHOT_MAGIC, 8) || version != SNAPSHOT_VERSION || byteOrder != SNAPSHOT_BYTE_ORDER) {
+    errorStreamPrint(LOG_STDOUT, 0, "%s is not a snapshot file of this version or platform.", fileName);
+    fclose(f.file);
+    return 1;
+  }
+
+  readBytes(&f, &guidLength, sizeof(int64_t));
+  if(f.failed || guidLength != (int64_t) strlen(mData->modelGUID)) {
+    errorStreamPrint(LOG_STDOUT, 0, "Snapshot %s was not written by this model.", fileName);
+    fclose(f.file);
+    return 1;
+  }
+  guid = (char*) malloc(guidLength+1);
+  readBytes(&f, guid, guidLength);
+  guid[guidLength] = '\0';
+  if(f.failed || strcmp(guid, mData->modelGUID)) {
+    errorStreamPrint(LOG_STDOUT, 0, "Snapshot %s was written by model %s, expected %s.", fileName, guid, mData->modelGUID);
+    free(guid);
+    fclose(f.file);
+    return 1;
+  }
+  free(guid);
+
+  readBytes(&f, &hash, sizeof(uint64_t));
+  if(f.failed || hash != layoutHash(data)) {
+    errorStreamPrint(LOG_STDOUT, 0, "The variable layout of snapshot %s does not match the model.", fileName);
+    fclose(f.file);
+    return 1;
+  }
+  readBytes(&f, &hash, sizeof(uint64_t));
+  if(!f.failed && hash != parameterHash(data)) {
+    warningStreamPrint(LOG_STDOUT, 0, "Parameters differ from the ones of snapshot %s; the stored state may not be consistent.", fileName);
+  }
+
+  /* ring buffer */
+  for(i=0; i<SIZERINGBUFFER; ++i) {
+    readSimulationData(&f, data, data->localData[i]);
+  }
+
+  /* pre-values and event handling */
+  readArray(&f, sInfo->realVarsPre, sizeof(modelica_real), mData->nVariablesReal);
+  readArray(&f, sInfo->integerVarsPre, sizeof(modelica_integer), mData->nVariablesInteger);
+  readArray(&f, sInfo->booleanVarsPre, sizeof(modelica_boolean), mData->nVariablesBoolean);
+  readStrings(&f, sInfo->stringVarsPre, mData->nVariablesString);
+  readArray(&f, sInfo->relations, sizeof(modelica_boolean), mData->nRelations);
+  readArray(&f, sInfo->relationsPre, sizeof(modelica_boolean), mData->nRelations);
+  readArray(&f, sInfo->zeroCrossings, sizeof(modelica_real), mData->nZeroCrossings);
+  readArray(&f, sInfo->zeroCrossingsPre, sizeof(modelica_real), mData->nZeroCrossings);
+  readArray(&f, sInfo->mathEventsValuePre, sizeof(modelica_real), mData->nMathEvents);
+
+  /* set up samplesInfo before the sample state is overwritten */
+  data->callback->function_initSample(data, threadData);
+  readArray(&f, sInfo->samples, sizeof(modelica_boolean), mData->nSamples);
+  readArray(&f, sInfo->nextSampleTimes, sizeof(double), mData->nSamples);
+  readBytes(&f, &sInfo->nextSampleEvent, sizeof(double));
+
+  /* delay buffers */
+  for(i=0; i<mData->nDelayExpressions && !f.failed; ++i) {
+    RINGBUFFER *delayStructure = sInfo->delayStructure[i];
+    long oldLength = ringBufferLength(delayStructure);
+    int64_t length = -1;
+    TIME_AND_VALUE tpl;
+
+    readBytes(&f, &length, sizeof(int64_t));
+    if(length < 0) {
+      f.failed = 1;
+    }
+    for(j=0; j<length && !f.failed; ++j) {
+      readBytes(&f, &tpl, sizeof(TIME_AND_VALUE));
+      appendRingData(delayStructure, &tpl);
+    }
+    /* drop previous entries, the buffers are empty unless a model is reused */
+    if(oldLength > 0 && ringBufferLength(delayStructure) > oldLength) {
+      dequeueNFirstRingDatas(delayStructure, oldLength);
+    }
+  }
+
+  /* initial guesses of the algebraic loops */
+  for(i=0; i<mData->nNonLinearSystems; ++i) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    readArray(&f, nonlinsys->nlsx, sizeof(modelica_real), nonlinsys->size);
+    readArray(&f, nonlinsys->nlsxOld, sizeof(modelica_real), nonlinsys->size);
+    readArray(&f, nonlinsys->nlsxExtrapolation, sizeof(modelica_real), nonlinsys->size);
+    readBytes(&f, &nonlinsys->lastTimeSolved, sizeof(modelica_real));
+  }
+  for(i=0; i<mData->nLinearSystems; ++i) {
+    LINEAR_SYSTEM_DATA *linsys = &sInfo->linearSystemData[i];
+    readArray(&f, linsys->x, sizeof(modelica_real), linsys->size);
+  }
+
+  fclose(f.file);
+  if(f.failed) {
+    errorStreamPrint(LOG_STDOUT, 0, "Snapshot file %s is truncated or corrupt.", fileName);
+    return 1;
+  }
+
+  /* clocked partitions are restarted at the snapshot time */
+  initSynchronous(data, threadData, data->localData[0]->timeValue);
+
+  printRelations(data, LOG_EVENTS);
+  printZeroCrossings(data, LOG_EVENTS);
+  infoStreamPrint(LOG_INIT, 0, "### END INITIALIZATION (restored time %g) ###", data->localData[0]->timeValue);
+
+  return 0;
+}
+
+#endif /* !OMC_MINIMAL_RUNTIME */
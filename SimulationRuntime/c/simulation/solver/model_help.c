@@ -53,13 +53,13 @@
 int maxEventIterations = 20;
 double linearSparseSolverMaxDensity = 0.2;
 int linearSparseSolverMinSize = 4001;
+double nonlinearSparseSolverMaxDensity = 0.1;
+int nonlinearSparseSolverMinSize = 1001;
 double newtonXTol = 1e-12;
 double newtonFTol = 1e-12;
 const size_t SIZERINGBUFFER = 3;
 int compiledInDAEMode = 0;
 
-static double tolZC;
-
 /*! \fn updateDiscreteSystem
  *
  *  Function to update the whole system with event iteration.
@@ -885,6 +885,7 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   rotateRingBuffer(data->simulationData, 0, (void**) data->localData);
 
   /* create modelData var arrays */
+  data->modelData->sharedVarInfo = 0;
   data->modelData->realVarsData = (STATIC_REAL_DATA*) omc_alloc_interface.malloc_uncollectable(data->modelData->nVariablesReal * sizeof(STATIC_REAL_DATA));
   data->modelData->integerVarsData = (STATIC_INTEGER_DATA*) omc_alloc_interface.malloc_uncollectable(data->modelData->nVariablesInteger * sizeof(STATIC_INTEGER_DATA));
   data->modelData->booleanVarsData = (STATIC_BOOLEAN_DATA*) omc_alloc_interface.malloc_uncollectable(data->modelData->nVariablesBoolean * sizeof(STATIC_BOOLEAN_DATA));
@@ -934,6 +935,11 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   /* initialize zeroCrossingsIndex with corresponding index is used by events lists */
   for(i=0; i<data->modelData->nZeroCrossings; i++)
     data->simulationInfo->zeroCrossingIndex[i] = (long)i;
+  /* work arrays of the root finding, allocated once to keep event steps free of allocations */
+  data->simulationInfo->rootStatesLeft = (modelica_real*) malloc(data->modelData->nStates*sizeof(modelica_real));
+  data->simulationInfo->rootStatesRight = (modelica_real*) malloc(data->modelData->nStates*sizeof(modelica_real));
+  data->simulationInfo->rootEventList = allocList(sizeof(long));
+  listReserve(data->simulationInfo->rootEventList, data->modelData->nZeroCrossings);
 
   /* buffer for old values */
   data->simulationInfo->realVarsOld = (modelica_real*) calloc(data->modelData->nVariablesReal, sizeof(modelica_real));
@@ -1051,7 +1057,7 @@ void deInitializeDataStruc(DATA *data)
 {
   TRACE_PUSH
   size_t i = 0;
-  int needToFree = !data->callback->read_input_fmu;
+  int needToFree = !data->callback->read_input_fmu && !data->modelData->sharedVarInfo;
 
   /* prepare RingBuffer */
   for(i=0; i<SIZERINGBUFFER; i++)
@@ -1102,6 +1108,9 @@ void deInitializeDataStruc(DATA *data)
   free(data->simulationInfo->relationsPre);
   free(data->simulationInfo->storedRelations);
   free(data->simulationInfo->zeroCrossingIndex);
+  free(data->simulationInfo->rootStatesLeft);
+  free(data->simulationInfo->rootStatesRight);
+  freeList(data->simulationInfo->rootEventList);
 
   /* free buffer for old state variables */
   free(data->simulationInfo->realVarsOld);
@@ -1175,39 +1184,41 @@ void deInitializeDataStruc(DATA *data)
  * Greater is for case LESSEQ and GREATER
  */
 
-void setZCtol(double relativeTol)
+void setZCtol(DATA *data, double relativeTol)
 {
   TRACE_PUSH
 
   /* lochel: force tolZC > 0 */
-  tolZC = TOL_HYSTERESIS_ZEROCROSSINGS * fmax(relativeTol, MINIMAL_STEP_SIZE);
-  infoStreamPrint(LOG_EVENTS_V, 0, "Set tolerance for zero-crossing hysteresis to: %e", tolZC);
+  data->simulationInfo->tolZC = TOL_HYSTERESIS_ZEROCROSSINGS * fmax(relativeTol, MINIMAL_STEP_SIZE);
+  infoStreamPrint(LOG_EVENTS_V, 0, "Set tolerance for zero-crossing hysteresis to: %e", data->simulationInfo->tolZC);
 
   TRACE_POP
 }
 
 /* TODO: fix this */
-modelica_boolean LessZC(double a, double b, modelica_boolean direction)
+modelica_boolean LessZCData(double a, double b, modelica_boolean direction, DATA *data)
 {
+  double tolZC = data->simulationInfo->tolZC;
   double eps = tolZC * fmax(fabs(a), fabs(b)) + tolZC;
   return direction ? (a - b <= eps) : (a - b <= -eps);
 }
 
-modelica_boolean LessEqZC(double a, double b, modelica_boolean direction)
+modelica_boolean LessEqZCData(double a, double b, modelica_boolean direction, DATA *data)
 {
-  return !GreaterZC(a, b, !direction);
+  return !GreaterZCData(a, b, !direction, data);
 }
 
 /* TODO: fix this */
-modelica_boolean GreaterZC(double a, double b, modelica_boolean direction)
+modelica_boolean GreaterZCData(double a, double b, modelica_boolean direction, DATA *data)
 {
+  double tolZC = data->simulationInfo->tolZC;
   double eps = tolZC * fmax(fabs(a), fabs(b)) + tolZC;
   return direction ? (a - b >= -eps ) : (a - b >= eps);
 }
 
-modelica_boolean GreaterEqZC(double a, double b, modelica_boolean direction)
+modelica_boolean GreaterEqZCData(double a, double b, modelica_boolean direction, DATA *data)
 {
-  return !LessZC(a, b, !direction);
+  return !LessZCData(a, b, !direction, data);
 }
 
 modelica_boolean Less(double a, double b)
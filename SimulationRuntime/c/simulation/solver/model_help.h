@@ -69,7 +69,7 @@ extern "C" {
   } \
   else \
   { \
-    res = ((op_w##ZC)((exp1),(exp2),data->simulationInfo->storedRelations[index])); \
+    res = (op_w##ZC((exp1),(exp2),data->simulationInfo->storedRelations[index])); \
     data->simulationInfo->relations[index] = res; \
   } \
 }
@@ -77,6 +77,8 @@ extern "C" {
 extern int maxEventIterations;
 extern double linearSparseSolverMaxDensity;
 extern int linearSparseSolverMinSize;
+extern double nonlinearSparseSolverMaxDensity;
+extern int nonlinearSparseSolverMinSize;
 extern double newtonXTol;
 extern double newtonFTol;
 extern const size_t SIZERINGBUFFER;
@@ -127,7 +129,7 @@ modelica_boolean checkRelations(DATA *data);
 void printHysteresisRelations(DATA *data);
 void activateHysteresis(DATA* data);
 void storeRelations(DATA* data);
-void setZCtol(double relativeTol);
+void setZCtol(DATA *data, double relativeTol);
 
 double getNextSampleTimeFMU(DATA *data);
 
@@ -152,10 +154,17 @@ modelica_boolean GreaterEq(double a, double b);
 /* functions used to evaluate relation in
  * zero-crossing with hysteresis effect
  */
-modelica_boolean LessZC(double a, double b, modelica_boolean);
-modelica_boolean LessEqZC(double a, double b, modelica_boolean);
-modelica_boolean GreaterZC(double a, double b, modelica_boolean);
-modelica_boolean GreaterEqZC(double a, double b, modelica_boolean);
+modelica_boolean LessZCData(double a, double b, modelica_boolean, DATA *data);
+modelica_boolean LessEqZCData(double a, double b, modelica_boolean, DATA *data);
+modelica_boolean GreaterZCData(double a, double b, modelica_boolean, DATA *data);
+modelica_boolean GreaterEqZCData(double a, double b, modelica_boolean, DATA *data);
+
+/* the generated code calls these with the DATA of the calling function in
+ * scope, like RELATIONHYSTERESIS; the tolerance is per DATA, see setZCtol */
+#define LessZC(a,b,direction) LessZCData((a),(b),(direction),data)
+#define LessEqZC(a,b,direction) LessEqZCData((a),(b),(direction),data)
+#define GreaterZC(a,b,direction) GreaterZCData((a),(b),(direction),data)
+#define GreaterEqZC(a,b,direction) GreaterEqZCData((a),(b),(direction),data)
 
 extern int measure_time_flag;
 
@@ -0,0 +1,970 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file multirate.c
+ *
+ *  Multirate integration based on the embedded Runge-Kutta method of
+ *  Bogacki and Shampine of order 3(2).
+ *
+ *  Every macro step is first taken for all states. States whose local error
+ *  estimate exceeds the tolerance are moved to the fast partition, together
+ *  with the states whose derivatives depend on them according to the sparse
+ *  pattern of jacobian A. The slow states accept the macro step, while the
+ *  fast states are integrated again over the macro step with small sub-steps
+ *  and an own step size control. During the sub-steps the slow states are
+ *  taken from the cubic Hermite interpolant of the macro step. The macro step
+ *  size is controlled by the slow states only. If the fast partition would
+ *  grow beyond the share given by -mrMaxFast, the macro step is rejected and
+ *  repeated with a smaller step size for all states instead.
+ *
+ *  Between re-partitionings, which take place every -mrPartitionInterval
+ *  macro steps and after events, states only move from the slow to the fast
+ *  partition. The integrator stops at the output points and leaves the event
+ *  handling to the solver main loop, which locates state events on the
+ *  solution of the last step (see events.c).
+ *
+ *  With -mrImplicit the fast partition is integrated with the linearly
+ *  implicit Rosenbrock method of Shampine and Reichelt of order 2(3), the
+ *  method of MATLAB's ode23s. Like there, the jacobian of the fast
+ *  derivatives w.r.t. the fast states and the time derivative of f are
+ *  computed at the begin of every sub-step, here by finite differences.
+ *  Keeping them over the macro step would be allowed for the method of
+ *  order 2, but the error estimate then rejects most sub-steps. Stiff fast
+ *  states take sub-steps limited by the accuracy instead of the stability
+ *  of the explicit method.
+ *
+ *  If the runtime is compiled with FMU_EXPERIMENTAL and the model provides
+ *  functionODEPartial, the sub-steps only evaluate the equations needed for
+ *  the derivatives of the fast states, else the whole ODE is evaluated.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <float.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+
+#include "util/omc_error.h"
+#include "gc/omc_gc.h"
+
+#include "simulation/options.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/solver/solver_main.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/external_input.h"
+#include "simulation/solver/epsilon.h"
+
+#include "simulation/solver/multirate.h"
+#include "meta/meta_modelica.h"
+
+extern void dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern void dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+
+/* Bogacki-Shampine 3(2) */
+static const double BS3_A21 = 1.0/2.0;
+static const double BS3_A32 = 3.0/4.0;
+static const double BS3_B1 = 2.0/9.0;
+static const double BS3_B2 = 1.0/3.0;
+static const double BS3_B3 = 4.0/9.0;
+static const double BS3_E1 = -5.0/72.0;   /* difference of the embedded solution of order 2 */
+static const double BS3_E2 = 1.0/12.0;
+static const double BS3_E3 = 1.0/9.0;
+static const double BS3_E4 = -1.0/8.0;
+
+/* Rosenbrock method of Shampine and Reichelt, d = 1/(2+sqrt(2)), e32 = 6+sqrt(2) */
+static const double ROS_D = 0.29289321881345248;
+static const double ROS_E32 = 7.4142135623730950;
+
+/* step size control */
+static const double MULTIRATE_SAFE = 0.9;
+static const double MULTIRATE_FACMIN = 0.2;
+static const double MULTIRATE_FACMAX = 5.0;
+
+/*! \fn multirate_f
+ *
+ *  evaluates all state derivatives f(t, y)
+ */
+static void multirate_f(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double t, const double* y, double* f)
+{
+  SIMULATION_DATA *sData = data->localData[0];
+  int ctx = data->simulationInfo->currentContext == CONTEXT_ALGEBRAIC;
+
+  if (ctx)
+  {
+    setContext(data, &t, CONTEXT_ODE);
+  }
+
+  memcpy(sData->realVars, y, mr->n*sizeof(double));
+  sData->timeValue = t;
+
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+
+  memcpy(f, sData->realVars + mr->n, mr->n*sizeof(double));
+  mr->evalFunctionODE++;
+
+  if (ctx)
+  {
+    unsetContext(data);
+  }
+}
+
+/*! \fn multirate_fFast
+ *
+ *  evaluates the derivatives of the fast states at (t, y), the other
+ *  elements of f are not touched
+ */
+static void multirate_fFast(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double t, const double* y, double* f)
+{
+  SIMULATION_DATA *sData = data->localData[0];
+  int ctx = data->simulationInfo->currentContext == CONTEXT_ALGEBRAIC;
+  int i;
+
+  if (ctx)
+  {
+    setContext(data, &t, CONTEXT_ODE);
+  }
+
+  memcpy(sData->realVars, y, mr->n*sizeof(double));
+  sData->timeValue = t;
+
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+#ifdef FMU_EXPERIMENTAL
+  if (data->callback->functionODEPartial)
+  {
+    for (i=0; i<mr->nFast; i++)
+    {
+      data->callback->functionODEPartial(data, threadData, mr->fastIdx[i]);
+    }
+  }
+  else
+#endif
+  {
+    data->callback->functionODE(data, threadData);
+  }
+
+  for (i=0; i<mr->nFast; i++)
+  {
+    f[mr->fastIdx[i]] = sData->realVars[mr->n + mr->fastIdx[i]];
+  }
+  mr->evalFunctionODE++;
+
+  if (ctx)
+  {
+    unsetContext(data);
+  }
+}
+
+/*! \fn multirate_initPattern
+ *
+ *  copies the sparse pattern of jacobian A in compressed column format,
+ *  column j holds the states whose derivatives depend on state j
+ */
+static void multirate_initPattern(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr)
+{
+  SPARSE_PATTERN *pattern;
+  int j;
+
+  if (0 != data->callback->initialAnalyticJacobianA(data, threadData))
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "multirate: sparse pattern not available, the fast partition is not extended by coupled states");
+    return;
+  }
+  pattern = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+
+  mr->colPtr = (int*) malloc((mr->n+1)*sizeof(int));
+  mr->rowIdx = (int*) malloc(pattern->numberOfNoneZeros*sizeof(int));
+  mr->colPtr[0] = 0;
+  for (j=0; j<mr->n; j++)
+  {
+    mr->colPtr[j+1] = pattern->leadindex[j];
+  }
+  for (j=0; j<(int)pattern->numberOfNoneZeros; j++)
+  {
+    mr->rowIdx[j] = pattern->index[j];
+  }
+}
+
+/*! \fn allocateMultirate
+ *
+ *  allocates the memory of the integrator
+ */
+int allocateMultirate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) calloc(1, sizeof(DATA_MULTIRATE));
+  const int n = data->modelData->nStates;
+  int i;
+
+  solverInfo->solverData = (void*) mr;
+  data->simulationInfo->currentContext = CONTEXT_ALGEBRAIC;
+
+  mr->n = n;
+  mr->y = (double*) calloc(n, sizeof(double));
+  mr->yNew = (double*) calloc(n, sizeof(double));
+  mr->k1 = (double*) calloc(n, sizeof(double));
+  mr->k2 = (double*) calloc(n, sizeof(double));
+  mr->k3 = (double*) calloc(n, sizeof(double));
+  mr->k4 = (double*) calloc(n, sizeof(double));
+  mr->err = (double*) calloc(n, sizeof(double));
+  mr->work = (double*) calloc(n, sizeof(double));
+  mr->fwork = (double*) calloc(n, sizeof(double));
+  mr->atol = (double*) calloc(n, sizeof(double));
+  mr->isFast = (int*) calloc(n, sizeof(int));
+  mr->fastIdx = (int*) calloc(n, sizeof(int));
+  mr->yf = (double*) calloc(n, sizeof(double));
+  mr->yfNew = (double*) calloc(n, sizeof(double));
+  mr->kf1 = (double*) calloc(n, sizeof(double));
+  mr->kf2 = (double*) calloc(n, sizeof(double));
+  mr->kf3 = (double*) calloc(n, sizeof(double));
+  mr->kf4 = (double*) calloc(n, sizeof(double));
+
+  mr->rtol = data->simulationInfo->tolerance;
+  for (i=0; i<n; i++)
+  {
+    mr->atol[i] = mr->rtol * fmax(fabs(data->modelData->realVarsData[i].attribute.nominal), 1e-32);
+  }
+
+  mr->hmax = data->simulationInfo->stopTime - data->simulationInfo->startTime;
+  if (mr->hmax <= 0)
+  {
+    mr->hmax = DBL_MAX;
+  }
+  if (omc_flag[FLAG_MAX_STEP_SIZE])
+  {
+    mr->hmax = atof(omc_flagValue[FLAG_MAX_STEP_SIZE]);
+    assertStreamPrint(threadData, mr->hmax >= MINIMAL_STEP_SIZE, "Selected maximum step size %e is too small.", mr->hmax);
+    infoStreamPrint(LOG_SOLVER, 0, "maximum step size %g", mr->hmax);
+  }
+  if (omc_flag[FLAG_INITIAL_STEP_SIZE])
+  {
+    mr->hinit = atof(omc_flagValue[FLAG_INITIAL_STEP_SIZE]);
+    assertStreamPrint(threadData, mr->hinit >= MINIMAL_STEP_SIZE, "Selected initial step size %e is too small.", mr->hinit);
+    infoStreamPrint(LOG_SOLVER, 0, "initial step size %g", mr->hinit);
+  }
+
+  mr->maxFast = 0.3;
+  if (omc_flag[FLAG_MR_MAX_FAST])
+  {
+    mr->maxFast = atof(omc_flagValue[FLAG_MR_MAX_FAST]);
+    assertStreamPrint(threadData, mr->maxFast >= 0.0 && mr->maxFast <= 1.0, "Selected maximum share of fast states %g is not in [0, 1].", mr->maxFast);
+  }
+  mr->partitionInterval = 10;
+  if (omc_flag[FLAG_MR_PARTITION_INTERVAL])
+  {
+    mr->partitionInterval = atoi(omc_flagValue[FLAG_MR_PARTITION_INTERVAL]);
+    assertStreamPrint(threadData, mr->partitionInterval > 0, "Selected partition interval %d has to be positive.", mr->partitionInterval);
+  }
+  mr->implicitFast = omc_flag[FLAG_MR_IMPLICIT];
+  infoStreamPrint(LOG_SOLVER, 0, "multirate: maximum share of fast states %g, re-partitioning every %d macro steps, %s sub-steps", mr->maxFast, mr->partitionInterval, mr->implicitFast ? "linearly implicit" : "explicit");
+
+  multirate_initPattern(data, threadData, mr);
+
+  return 0;
+}
+
+/*! \fn freeMultirate
+ *
+ *  frees the memory of the integrator
+ */
+int freeMultirate(SOLVER_INFO* solverInfo)
+{
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) solverInfo->solverData;
+
+  free(mr->y);
+  free(mr->yNew);
+  free(mr->k1);
+  free(mr->k2);
+  free(mr->k3);
+  free(mr->k4);
+  free(mr->err);
+  free(mr->work);
+  free(mr->fwork);
+  free(mr->atol);
+  free(mr->isFast);
+  free(mr->fastIdx);
+  free(mr->yf);
+  free(mr->yfNew);
+  free(mr->kf1);
+  free(mr->kf2);
+  free(mr->kf3);
+  free(mr->kf4);
+  free(mr->colPtr);
+  free(mr->rowIdx);
+  free(mr->jacFast);
+  free(mr->wFast);
+  free(mr->ipivFast);
+  free(mr->rk1);
+  free(mr->rk2);
+  free(mr->rk3);
+  free(mr->dfdt);
+
+  free(mr);
+
+  return 0;
+}
+
+/*! \fn multirate_factor
+ *
+ *  step size factor for the scaled error err of a method of order 3(2)
+ */
+static double multirate_factor(double err)
+{
+  if (err <= 0.0)
+  {
+    return MULTIRATE_FACMAX;
+  }
+  return fmin(MULTIRATE_FACMAX, fmax(MULTIRATE_FACMIN, MULTIRATE_SAFE*pow(err, -1.0/3.0)));
+}
+
+/*! \fn multirate_interpolate
+ *
+ *  evaluates the cubic Hermite interpolant of the macro step (t, t+H)
+ *  for the slow states at time tau
+ */
+static void multirate_interpolate(DATA_MULTIRATE* mr, double H, double tau, double* y)
+{
+  const double s = (tau - mr->t) / H;
+  const double h00 = (1.0 + 2.0*s)*(1.0 - s)*(1.0 - s);
+  const double h10 = s*(1.0 - s)*(1.0 - s);
+  const double h01 = s*s*(3.0 - 2.0*s);
+  const double h11 = s*s*(s - 1.0);
+  int i;
+
+  for (i=0; i<mr->n; i++)
+  {
+    if (!mr->isFast[i])
+    {
+      y[i] = h00*mr->y[i] + h10*H*mr->k1[i] + h01*mr->yNew[i] + h11*H*mr->k4[i];
+    }
+  }
+}
+
+/*! \fn multirate_markFast
+ *
+ *  tentatively marks state i and the states coupled to it as fast
+ *
+ *  \return number of newly marked states
+ */
+static int multirate_markFast(DATA_MULTIRATE* mr, int i)
+{
+  int k, count = 0;
+
+  if (!mr->isFast[i])
+  {
+    mr->isFast[i] = 2;
+    count++;
+  }
+  if (mr->colPtr)
+  {
+    for (k = mr->colPtr[i]; k < mr->colPtr[i+1]; k++)
+    {
+      if (!mr->isFast[mr->rowIdx[k]])
+      {
+        mr->isFast[mr->rowIdx[k]] = 2;
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+/*! \fn multirate_commitFast
+ *
+ *  accepts (accept = TRUE) or discards the tentatively marked fast states
+ *  and updates the index list of the fast partition
+ */
+static void multirate_commitFast(DATA_MULTIRATE* mr, int accept)
+{
+  int i;
+
+  mr->nFast = 0;
+  for (i=0; i<mr->n; i++)
+  {
+    if (2 == mr->isFast[i])
+    {
+      mr->isFast[i] = accept;
+    }
+    if (mr->isFast[i])
+    {
+      mr->fastIdx[mr->nFast++] = i;
+    }
+  }
+}
+
+/*! \fn multirate_partition
+ *
+ *  re-evaluates the partition from the error estimates of the last
+ *  macro step
+ */
+static void multirate_partition(DATA_MULTIRATE* mr)
+{
+  int i, count = 0, nFastOld = mr->nFast;
+
+  memset(mr->isFast, 0, mr->n*sizeof(int));
+  for (i=0; i<mr->n; i++)
+  {
+    if (mr->err[i] > 1.0)
+    {
+      count += multirate_markFast(mr, i);
+    }
+  }
+  multirate_commitFast(mr, count <= mr->maxFast*mr->n);
+  mr->stepsSincePartition = 0;
+
+  if (mr->nFast != nFastOld)
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "multirate: %d of %d states in the fast partition at time %g", mr->nFast, mr->n, mr->t);
+  }
+}
+
+/*! \fn multirate_macroStep
+ *
+ *  takes the macro step (t, t+H) for all states and computes the scaled
+ *  error estimate of each state
+ */
+static void multirate_macroStep(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double H)
+{
+  const int n = mr->n;
+  double e;
+  int i;
+
+  for (i=0; i<n; i++)
+  {
+    mr->work[i] = mr->y[i] + H*BS3_A21*mr->k1[i];
+  }
+  multirate_f(data, threadData, mr, mr->t + BS3_A21*H, mr->work, mr->k2);
+
+  for (i=0; i<n; i++)
+  {
+    mr->work[i] = mr->y[i] + H*BS3_A32*mr->k2[i];
+  }
+  multirate_f(data, threadData, mr, mr->t + BS3_A32*H, mr->work, mr->k3);
+
+  for (i=0; i<n; i++)
+  {
+    mr->yNew[i] = mr->y[i] + H*(BS3_B1*mr->k1[i] + BS3_B2*mr->k2[i] + BS3_B3*mr->k3[i]);
+  }
+  multirate_f(data, threadData, mr, mr->t + H, mr->yNew, mr->k4);
+
+  for (i=0; i<n; i++)
+  {
+    e = H*(BS3_E1*mr->k1[i] + BS3_E2*mr->k2[i] + BS3_E3*mr->k3[i] + BS3_E4*mr->k4[i]);
+    mr->err[i] = fabs(e) / (mr->atol[i] + mr->rtol*fmax(fabs(mr->y[i]), fabs(mr->yNew[i])));
+    /* the explicit stages of stiff states may overflow, they still have to become fast */
+    if (isnan(mr->err[i]))
+    {
+      mr->err[i] = DBL_MAX;
+    }
+  }
+}
+
+/*! \fn multirate_subStepExplicit
+ *
+ *  takes the sub-step (ts, ts+hs) of the fast states with the explicit
+ *  method, yfNew and kf4 are the states and derivatives at ts+hs
+ *
+ *  \return scaled error estimate of the fast states
+ */
+static double multirate_subStepExplicit(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double H, double ts, double hs)
+{
+  double err = 0.0, e;
+  int i, k;
+
+  multirate_interpolate(mr, H, ts + BS3_A21*hs, mr->work);
+  for (k=0; k<mr->nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->work[i] = mr->yf[i] + hs*BS3_A21*mr->kf1[i];
+  }
+  multirate_fFast(data, threadData, mr, ts + BS3_A21*hs, mr->work, mr->kf2);
+
+  multirate_interpolate(mr, H, ts + BS3_A32*hs, mr->work);
+  for (k=0; k<mr->nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->work[i] = mr->yf[i] + hs*BS3_A32*mr->kf2[i];
+  }
+  multirate_fFast(data, threadData, mr, ts + BS3_A32*hs, mr->work, mr->kf3);
+
+  multirate_interpolate(mr, H, ts + hs, mr->yfNew);
+  for (k=0; k<mr->nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->yfNew[i] = mr->yf[i] + hs*(BS3_B1*mr->kf1[i] + BS3_B2*mr->kf2[i] + BS3_B3*mr->kf3[i]);
+  }
+  multirate_fFast(data, threadData, mr, ts + hs, mr->yfNew, mr->kf4);
+
+  for (k=0; k<mr->nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    e = hs*(BS3_E1*mr->kf1[i] + BS3_E2*mr->kf2[i] + BS3_E3*mr->kf3[i] + BS3_E4*mr->kf4[i]);
+    err = fmax(err, fabs(e) / (mr->atol[i] + mr->rtol*fmax(fabs(mr->yf[i]), fabs(mr->yfNew[i]))));
+  }
+
+  return err;
+}
+
+/*! \fn multirate_jacobianFast
+ *
+ *  computes the jacobian of the fast derivatives w.r.t. the fast states and
+ *  their time derivative at the begin ts of the sub-step of the macro step
+ *  (t, t+H) by forward differences, one evaluation per fast state and one
+ *  for the time
+ */
+static void multirate_jacobianFast(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double H, double ts)
+{
+  const int nFast = mr->nFast;
+  double delta;
+  int i, j, k, l;
+
+  if (nFast > mr->sizeFast)
+  {
+    mr->sizeFast = nFast;
+    mr->jacFast = (double*) realloc(mr->jacFast, nFast*nFast*sizeof(double));
+    mr->wFast = (double*) realloc(mr->wFast, nFast*nFast*sizeof(double));
+    mr->ipivFast = (int*) realloc(mr->ipivFast, nFast*sizeof(int));
+    mr->rk1 = (double*) realloc(mr->rk1, nFast*sizeof(double));
+    mr->rk2 = (double*) realloc(mr->rk2, nFast*sizeof(double));
+    mr->rk3 = (double*) realloc(mr->rk3, nFast*sizeof(double));
+    mr->dfdt = (double*) realloc(mr->dfdt, nFast*sizeof(double));
+  }
+
+  multirate_interpolate(mr, H, ts, mr->work);
+  for (k=0; k<nFast; k++)
+  {
+    j = mr->fastIdx[k];
+    mr->work[j] = mr->yf[j];
+  }
+
+  for (k=0; k<nFast; k++)
+  {
+    j = mr->fastIdx[k];
+    delta = sqrt(DBL_EPSILON) * fmax(fabs(mr->yf[j]), mr->atol[j]/mr->rtol);
+    mr->work[j] = mr->yf[j] + delta;
+    multirate_fFast(data, threadData, mr, ts, mr->work, mr->fwork);
+    mr->work[j] = mr->yf[j];
+    for (l=0; l<nFast; l++)
+    {
+      i = mr->fastIdx[l];
+      mr->jacFast[l + k*nFast] = (mr->fwork[i] - mr->kf1[i]) / delta;
+    }
+  }
+
+  delta = sqrt(DBL_EPSILON) * fmax(fabs(ts), 1.0);
+  multirate_fFast(data, threadData, mr, ts + delta, mr->work, mr->fwork);
+  for (l=0; l<nFast; l++)
+  {
+    i = mr->fastIdx[l];
+    mr->dfdt[l] = (mr->fwork[i] - mr->kf1[i]) / delta;
+  }
+
+  mr->hW = 0.0;
+  mr->jacEvals++;
+}
+
+/*! \fn multirate_solveFast
+ *
+ *  solves (I - hW*d*jacFast)*x = b for the fast part, b is overwritten
+ *  with the solution
+ */
+static void multirate_solveFast(DATA_MULTIRATE* mr, double* b)
+{
+  int n = mr->nFast, nrhs = 1, info = 0;
+  char trans = 'N';
+
+  dgetrs_(&trans, &n, &nrhs, mr->wFast, &n, mr->ipivFast, b, &n, &info);
+}
+
+/*! \fn multirate_subStepImplicit
+ *
+ *  takes the sub-step (ts, ts+hs) of the fast states with the Rosenbrock
+ *  method, yfNew and kf4 are the states and derivatives at ts+hs
+ *
+ *  \return scaled error estimate of the fast states, DBL_MAX if the
+ *          iteration matrix is singular
+ */
+static double multirate_subStepImplicit(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double H, double ts, double hs)
+{
+  const int nFast = mr->nFast;
+  double err = 0.0, e;
+  int i, k, info = 0;
+
+  if (hs != mr->hW)
+  {
+    for (k=0; k<nFast*nFast; k++)
+    {
+      mr->wFast[k] = -hs*ROS_D*mr->jacFast[k];
+    }
+    for (k=0; k<nFast; k++)
+    {
+      mr->wFast[k + k*nFast] += 1.0;
+    }
+    dgetrf_(&mr->nFast, &mr->nFast, mr->wFast, &mr->nFast, mr->ipivFast, &info);
+    if (info != 0)
+    {
+      mr->hW = 0.0;
+      return DBL_MAX;
+    }
+    mr->hW = hs;
+  }
+
+  for (k=0; k<nFast; k++)
+  {
+    mr->rk1[k] = mr->kf1[mr->fastIdx[k]] + hs*ROS_D*mr->dfdt[k];
+  }
+  multirate_solveFast(mr, mr->rk1);
+
+  multirate_interpolate(mr, H, ts + 0.5*hs, mr->work);
+  for (k=0; k<nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->work[i] = mr->yf[i] + 0.5*hs*mr->rk1[k];
+  }
+  multirate_fFast(data, threadData, mr, ts + 0.5*hs, mr->work, mr->kf2);
+
+  for (k=0; k<nFast; k++)
+  {
+    mr->rk2[k] = mr->kf2[mr->fastIdx[k]] - mr->rk1[k];
+  }
+  multirate_solveFast(mr, mr->rk2);
+  for (k=0; k<nFast; k++)
+  {
+    mr->rk2[k] += mr->rk1[k];
+  }
+
+  multirate_interpolate(mr, H, ts + hs, mr->yfNew);
+  for (k=0; k<nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->yfNew[i] = mr->yf[i] + hs*mr->rk2[k];
+  }
+  multirate_fFast(data, threadData, mr, ts + hs, mr->yfNew, mr->kf4);
+
+  for (k=0; k<nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    mr->rk3[k] = mr->kf4[i] - ROS_E32*(mr->rk2[k] - mr->kf2[i]) - 2.0*(mr->rk1[k] - mr->kf1[i]) + hs*ROS_D*mr->dfdt[k];
+  }
+  multirate_solveFast(mr, mr->rk3);
+
+  for (k=0; k<nFast; k++)
+  {
+    i = mr->fastIdx[k];
+    e = hs/6.0*(mr->rk1[k] - 2.0*mr->rk2[k] + mr->rk3[k]);
+    err = fmax(err, fabs(e) / (mr->atol[i] + mr->rtol*fmax(fabs(mr->yf[i]), fabs(mr->yfNew[i]))));
+  }
+  if (isnan(err))
+  {
+    err = DBL_MAX;
+  }
+
+  return err;
+}
+
+/*! \fn multirate_refineFast
+ *
+ *  integrates the fast states over the macro step (t, t+H) with sub-steps,
+ *  the slow states are interpolated
+ *
+ *  \return 0 on success, else the sub-step size became too small
+ */
+static int multirate_refineFast(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double H)
+{
+  const double tEnd = mr->t + H;
+  double ts = mr->t, hs, err, fac;
+  int i, k, last, jacCurrent = 0;
+
+  memcpy(mr->yf, mr->y, mr->n*sizeof(double));
+  memcpy(mr->kf1, mr->k1, mr->n*sizeof(double));
+  hs = mr->hFast > 0 ? fmin(mr->hFast, H) : 0.1*H;
+
+  while (ts < tEnd)
+  {
+    last = hs >= tEnd - ts;
+    if (last)
+    {
+      hs = tEnd - ts;
+    }
+
+    if (mr->implicitFast)
+    {
+      /* a repeated sub-step keeps the jacobian */
+      if (!jacCurrent)
+      {
+        multirate_jacobianFast(data, threadData, mr, H, ts);
+        jacCurrent = 1;
+      }
+      err = multirate_subStepImplicit(data, threadData, mr, H, ts, hs);
+    }
+    else
+    {
+      err = multirate_subStepExplicit(data, threadData, mr, H, ts, hs);
+    }
+    fac = multirate_factor(err);
+
+    if (err <= 1.0)
+    {
+      ts = last ? tEnd : ts + hs;
+      for (k=0; k<mr->nFast; k++)
+      {
+        i = mr->fastIdx[k];
+        mr->yf[i] = mr->yfNew[i];
+        mr->kf1[i] = mr->kf4[i];
+      }
+      mr->subStepsDone++;
+      jacCurrent = 0;
+      /* a step shortened to the end of the macro step does not increase the proposal */
+      if (!last || fac < 1.0)
+      {
+        mr->hFast = hs*fac;
+      }
+    }
+    else
+    {
+      mr->errorTestFailures++;
+      mr->hFast = hs*fac;
+    }
+    hs = mr->hFast;
+
+    if (hs < MINIMAL_STEP_SIZE)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "multirate: sub-step size %g of the fast partition too small at time %g", hs, ts);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/*! \fn multirate_restart
+ *
+ *  (re)starts the integration at the current time, e.g. after an event
+ */
+static void multirate_restart(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DATA_MULTIRATE* mr)
+{
+  const int n = mr->n;
+  double d0 = 0.0, d1 = 0.0, sc;
+  int i;
+
+  for (i=0; i<n; i++)
+  {
+    sc = mr->atol[i] + mr->rtol*fabs(mr->y[i]);
+    d0 += (mr->y[i]/sc)*(mr->y[i]/sc);
+    d1 += (mr->k1[i]/sc)*(mr->k1[i]/sc);
+  }
+  d0 = n > 0 ? sqrt(d0/n) : 0.0;
+  d1 = n > 0 ? sqrt(d1/n) : 0.0;
+
+  if (mr->hinit > 0)
+  {
+    mr->h = mr->hinit;
+  }
+  else
+  {
+    mr->h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+  }
+  mr->h = fmin(mr->h, mr->hmax);
+  mr->hFast = 0.0;
+
+  memset(mr->isFast, 0, n*sizeof(int));
+  mr->nFast = 0;
+  mr->stepsSincePartition = 0;
+
+  mr->stepsDone = 0;
+  mr->subStepsDone = 0;
+  mr->evalFunctionODE = 0;
+  mr->errorTestFailures = 0;
+  mr->jacEvals = 0;
+
+  infoStreamPrint(LOG_SOLVER, 0, "multirate: restart at time %g with step size %g", mr->t, mr->h);
+}
+
+/*! \fn multirate_step
+ *
+ *  integrates from solverInfo->currentTime to currentTime + currentStepSize
+ */
+int multirate_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  TRACE_PUSH
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) solverInfo->solverData;
+  SIMULATION_DATA *sData = data->localData[0];
+  SIMULATION_DATA *sDataOld = data->localData[1];
+  const int n = mr->n;
+  double target, H = 0.0, errSlow, fac;
+  int i, last, retVal = 0;
+  int saveJumpState;
+
+  saveJumpState = threadData->currentErrorStage;
+  threadData->currentErrorStage = ERROR_INTEGRATOR;
+
+  /* try */
+#if !defined(OMC_EMCC)
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+
+  /* the last point and its derivatives are always the accepted ones, since
+   * the solver main loop evaluates the ODE there after each step */
+  mr->t = sDataOld->timeValue;
+  memcpy(mr->y, sDataOld->realVars, n*sizeof(double));
+  memcpy(mr->k1, sDataOld->realVars + n, n*sizeof(double));
+  target = solverInfo->currentTime + solverInfo->currentStepSize;
+
+  if (mr->h <= 0.0 || solverInfo->didEventStep)
+  {
+    multirate_restart(data, threadData, solverInfo, mr);
+  }
+
+  while (mr->t < target)
+  {
+    last = mr->h >= target - mr->t;
+    H = last ? target - mr->t : mr->h;
+    multirate_macroStep(data, threadData, mr, H);
+
+    errSlow = 0.0;
+    for (i=0; i<n; i++)
+    {
+      if (!mr->isFast[i])
+      {
+        errSlow = fmax(errSlow, mr->err[i]);
+      }
+    }
+
+    if (errSlow > 1.0)
+    {
+      /* move the failing slow states to the fast partition, if it does not grow too large */
+      int count = 0;
+      for (i=0; i<n; i++)
+      {
+        if (!mr->isFast[i] && mr->err[i] > 1.0)
+        {
+          count += multirate_markFast(mr, i);
+        }
+      }
+
+      if (mr->nFast + count <= mr->maxFast*n)
+      {
+        multirate_commitFast(mr, 1);
+        infoStreamPrint(LOG_SOLVER, 0, "multirate: %d of %d states in the fast partition at time %g", mr->nFast, n, mr->t);
+        errSlow = 0.0;
+        for (i=0; i<n; i++)
+        {
+          if (!mr->isFast[i])
+          {
+            errSlow = fmax(errSlow, mr->err[i]);
+          }
+        }
+      }
+      else
+      {
+        multirate_commitFast(mr, 0);
+        mr->errorTestFailures++;
+        mr->h = H*multirate_factor(errSlow);
+        if (mr->h < MINIMAL_STEP_SIZE)
+        {
+          warningStreamPrint(LOG_STDOUT, 0, "multirate: step size %g too small at time %g", mr->h, mr->t);
+          retVal = -1;
+          break;
+        }
+        continue;
+      }
+    }
+
+    if (mr->nFast > 0)
+    {
+      if (multirate_refineFast(data, threadData, mr, H))
+      {
+        retVal = -1;
+        break;
+      }
+      for (i=0; i<mr->nFast; i++)
+      {
+        mr->yNew[mr->fastIdx[i]] = mr->yf[mr->fastIdx[i]];
+      }
+    }
+
+    /* accept the macro step */
+    mr->t = last ? target : mr->t + H;
+    memcpy(mr->y, mr->yNew, n*sizeof(double));
+    if (mr->nFast > 0)
+    {
+      multirate_f(data, threadData, mr, mr->t, mr->y, mr->k1);
+    }
+    else
+    {
+      memcpy(mr->k1, mr->k4, n*sizeof(double));
+    }
+    mr->stepsDone++;
+
+    /* a step shortened to the output point does not increase the proposal */
+    fac = multirate_factor(errSlow);
+    if (!last || fac < 1.0)
+    {
+      mr->h = fmin(H*fac, mr->hmax);
+    }
+
+    if (++mr->stepsSincePartition >= mr->partitionInterval)
+    {
+      multirate_partition(mr);
+    }
+
+    if (solverInfo->integratorSteps)
+    {
+      break;
+    }
+  }
+
+  if (0 == retVal)
+  {
+    memcpy(sData->realVars, mr->y, n*sizeof(double));
+    sData->timeValue = mr->t;
+    solverInfo->currentTime = mr->t;
+    solverInfo->solverStepSize = H;
+  }
+
+#if !defined(OMC_EMCC)
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  threadData->currentErrorStage = saveJumpState;
+
+  solverInfo->solverStatsTmp[0] = mr->stepsDone;
+  solverInfo->solverStatsTmp[1] = mr->evalFunctionODE;
+  solverInfo->solverStatsTmp[2] = mr->jacEvals;
+  solverInfo->solverStatsTmp[3] = mr->errorTestFailures;
+
+  infoStreamPrint(LOG_SOLVER, 0, "multirate: %u macro steps, %u sub-steps of the fast partition", mr->stepsDone, mr->subStepsDone);
+
+  TRACE_POP
+  return retVal;
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file multirate.h
+ *
+ *  Multirate integration with automatic partitioning of the states into a
+ *  slow partition, which takes large explicit macro steps, and a fast
+ *  partition, which is refined with small explicit or, with -mrImplicit,
+ *  linearly implicit sub-steps.
+ */
+
+#ifndef _MULTIRATE_H_
+#define _MULTIRATE_H_
+
+#include "simulation_data.h"
+#include "solver_main.h"
+
+typedef struct DATA_MULTIRATE
+{
+  int n;                        /* number of states */
+
+  /* macro step */
+  double *y;                    /* states at the begin of the macro step */
+  double *yNew;                 /* states at the end of the macro step */
+  double *k1, *k2, *k3, *k4;    /* stages of the macro step, k1 = f(t, y) */
+  double *err;                  /* scaled error estimate of each state */
+  double *work;                 /* stage states */
+  double *fwork;                /* derivatives */
+  double rtol;
+  double *atol;
+
+  /* partition */
+  int *isFast;                  /* TRUE if the state belongs to the fast partition */
+  int *fastIdx;                 /* indices of the fast states */
+  int nFast;
+  int *colPtr;                  /* pattern of jacobian A in compressed column format, NULL if not available */
+  int *rowIdx;
+  double maxFast;               /* maximum share of fast states */
+  int partitionInterval;        /* number of macro steps between re-partitioning */
+  int stepsSincePartition;
+
+  /* fast sub-steps */
+  double *yf, *yfNew;           /* states during the sub-steps, only the fast part is integrated */
+  double *kf1, *kf2, *kf3, *kf4;
+  double hFast;
+
+  /* linearly implicit sub-steps (-mrImplicit), the arrays hold the fast part only */
+  int implicitFast;
+  int sizeFast;                 /* allocated size of the arrays below */
+  double *jacFast;              /* jacobian of the fast derivatives w.r.t. the fast states */
+  double *dfdt;                 /* time derivative of the fast derivatives */
+  double *wFast;                /* LU factors of I - hW*d*jacFast */
+  int *ipivFast;
+  double hW;                    /* sub-step size of wFast, 0 if not factorized */
+  double *rk1, *rk2, *rk3;      /* stages of the Rosenbrock method */
+
+  /* integrator state */
+  double t;
+  double h;                     /* proposed macro step size */
+  double hmax;
+  double hinit;
+
+  /* statistics since last restart */
+  unsigned int stepsDone;
+  unsigned int subStepsDone;
+  unsigned int evalFunctionODE;
+  unsigned int errorTestFailures;
+  unsigned int jacEvals;
+} DATA_MULTIRATE;
+
+int allocateMultirate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+int freeMultirate(SOLVER_INFO* solverInfo);
+int multirate_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+
+#endif /* _MULTIRATE_H_ */
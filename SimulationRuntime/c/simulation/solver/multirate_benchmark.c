@@ -0,0 +1,176 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*
+ * Benchmark of the multirate solver on a model with a stiff/non-stiff split:
+ * two stiff fast states, standing for the electrical part, drive a chain of
+ * n-2 slow states (default n = 1000), standing for the thermal part
+ *
+ *   der(x[1]) = -1e4*(x[1] - cos(t))
+ *   der(x[2]) = -1e3*(x[2] - x[1]^2)
+ *   der(x[i]) = 0.1*(x[i-1] - x[i]), i = 3..n
+ *
+ * with x(0) = 0 until t = 10. The table compares
+ *
+ *   - single-rate: -s=multirate -mrMaxFast=0, every step is taken for all
+ *     states and the step size is limited by the stability of the stiff ones
+ *   - explicit:    -s=multirate, the fast states take explicit sub-steps
+ *   - implicit:    -s=multirate -mrImplicit, the fast states take linearly
+ *     implicit sub-steps
+ *
+ * with tolerance 1e-6. It shows the macro steps, the sub-steps, the calls of
+ * functionODE, the time and the largest error over all states at the 500
+ * output points against a single-rate solution with tolerance 1e-10. Every
+ * call of functionODE evaluates all n derivatives, the generated code has no
+ * cheaper evaluation of the fast ones without FMU_EXPERIMENTAL.
+ *
+ * Build with "make multirate-benchmark" in SimulationRuntime/c, after the
+ * runtime libraries are built; run it as "./multirate-benchmark [n]".
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "simulation/options.h"
+#include "simulation/solver/multirate.h"
+#include "simulation/test/test_model.h"
+#include "meta/meta_modelica.h"
+
+#define N_OUTPUTS 500
+
+static int n;
+static long nCalls;
+
+static int splitODE(DATA *data, threadData_t *threadData)
+{
+  const double *x = data->localData[0]->realVars;
+  double *der = data->localData[0]->realVars + n;
+  int i;
+
+  der[0] = -1e4*(x[0] - cos(data->localData[0]->timeValue));
+  der[1] = -1e3*(x[1] - x[0]*x[0]);
+  for (i = 2; i < n; i++) {
+    der[i] = 0.1*(x[i-1] - x[i]);
+  }
+  nCalls++;
+  return 0;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+/* integrates until t = 10 and stores the states at the output points in
+ * result[k*n..(k+1)*n-1], if result is not NULL the largest difference to
+ * it is returned instead */
+static int run(const char *name, const char *maxFast, int implicitFast, double tolerance, double *result, double *reference)
+{
+  TEST_MODEL model;
+  DATA_MULTIRATE *mr;
+  double t, maxError = 0.0;
+  int i, k, rc = 0;
+
+  initTestModel(&model, n, splitODE, 0.0, 10.0, tolerance);
+  setTestModelBandPattern(&model, 1, 0);
+  omc_flag[FLAG_MR_MAX_FAST] = NULL != maxFast;
+  omc_flagValue[FLAG_MR_MAX_FAST] = maxFast;
+  omc_flag[FLAG_MR_IMPLICIT] = implicitFast;
+  nCalls = 0;
+
+  t = now();
+  allocateMultirate(&model.data, &model.threadData, &model.solverInfo);
+  mr = (DATA_MULTIRATE*) model.solverInfo.solverData;
+  splitODE(&model.data, &model.threadData);
+  for (k = 1; k <= N_OUTPUTS && 0 == rc; k++) {
+    beginTestModelStep(&model, 10.0*k/N_OUTPUTS);
+    rc = multirate_step(&model.data, &model.threadData, &model.solverInfo);
+    /* like the solver main loop, which evaluates the ODE after each step */
+    splitODE(&model.data, &model.threadData);
+    if (result) {
+      memcpy(result + (k-1)*n, model.localData[0]->realVars, n*sizeof(double));
+    } else {
+      for (i = 0; i < n; i++) {
+        maxError = fmax(maxError, fabs(model.localData[0]->realVars[i] - reference[(k-1)*n + i]));
+      }
+    }
+  }
+  t = now() - t;
+
+  if (name) {
+    printf("%-12s %10u %10u %12ld %10.3f %12.3e\n", name, mr->stepsDone, mr->subStepsDone, nCalls, t, maxError);
+  }
+
+  freeMultirate(&model.solverInfo);
+  omc_flag[FLAG_MR_MAX_FAST] = 0;
+  omc_flag[FLAG_MR_IMPLICIT] = 0;
+  freeTestModel(&model);
+  return rc;
+}
+
+int main(int argc, char **argv)
+{
+  double *reference;
+
+  n = argc > 1 ? atoi(argv[1]) : 1000;
+  if (n < 3) {
+    fprintf(stderr, "usage: %s [number of states >= 3]\n", argv[0]);
+    return 1;
+  }
+
+  mmc_init_nogc();
+
+  reference = (double*) malloc(N_OUTPUTS*n*sizeof(double));
+  if (run(NULL, "0", 0, 1e-10, reference, NULL)) {
+    printf("reference solution failed\n");
+    return 1;
+  }
+
+  printf("stiff/non-stiff split with %d states until t = 10\n", n);
+  printf("%-12s %10s %10s %12s %10s %12s\n", "method", "steps", "sub-steps", "functionODE", "time [s]", "max error");
+  if (run("single-rate", "0", 0, 1e-6, NULL, reference)) {
+    printf("single-rate failed\n");
+  }
+  if (run("explicit", NULL, 0, 1e-6, NULL, reference)) {
+    printf("explicit failed\n");
+  }
+  if (run("implicit", NULL, 1, 1e-6, NULL, reference)) {
+    printf("implicit failed\n");
+  }
+
+  free(reference);
+  return 0;
+}
@@ -52,6 +52,7 @@ extern "C" {
 
 extern double enorm_(int *n, double *x);
 int solveLinearSystem(int* n, int* iwork, double* fvec, double *fjac, DATA_NEWTON* solverData);
+static int solveLinearSystemSparse(int* n, double* fvec, DATA_NEWTON* solverData);
 void calculatingErrors(DATA_NEWTON* solverData, double* delta_x, double* delta_x_scaled, double* delta_f, double* error_f,
     double* scaledError_f, int* n, double* x, double* fvec);
 void scaling_residual_vector(DATA_NEWTON* solverData);
@@ -79,10 +80,11 @@ extern void dgetrs_(char *trans, int *n, int *nrhs, doublereal *a, int *lda, int
 #endif
 
 
-/*! \fn allocateNewtonData
- * allocate memory for nonlinear system solver
+/*! \fn allocateNewtonDataCommon
+ * allocate memory for nonlinear system solver, the dense jacobian is only
+ * allocated if denseJacobian is set
  */
-int allocateNewtonData(int size, void** voiddata)
+static int allocateNewtonDataCommon(int size, int denseJacobian, void** voiddata)
 {
   DATA_NEWTON* data = (DATA_NEWTON*) malloc(sizeof(DATA_NEWTON));
 
@@ -99,7 +101,7 @@ int allocateNewtonData(int size, void** voiddata)
   data->ftol = 1e-6;
   data->maxfev = size*100;
   data->epsfcn = DBL_EPSILON;
-  data->fjac = (double*) malloc((size*size)*sizeof(double));
+  data->fjac = denseJacobian ? (double*) malloc((size*size)*sizeof(double)) : NULL;
 
   data->rwork = (double*) malloc((size)*sizeof(double));
   data->iwork = (int*) malloc(size*sizeof(int));
@@ -117,9 +119,67 @@ int allocateNewtonData(int size, void** voiddata)
   data->numberOfIterations = 0;
   data->numberOfFunctionEvaluations = 0;
 
+  data->useSparse = 0;
+  data->nnz = 0;
+  data->Ap = NULL;
+  data->Ai = NULL;
+  data->Ax = NULL;
+#ifdef WITH_UMFPACK
+  data->symbolic = NULL;
+  data->numeric = NULL;
+#endif
+
   return 0;
 }
 
+/*! \fn allocateNewtonData
+ * allocate memory for nonlinear system solver
+ */
+int allocateNewtonData(int size, void** voiddata)
+{
+  return allocateNewtonDataCommon(size, 1, voiddata);
+}
+
+/*! \fn allocateNewtonDataSparse
+ * allocate memory for nonlinear system solver using a sparse jacobian
+ *
+ * The jacobian is stored in compressed column format with the structure
+ * of the sparse pattern and factorized with KLU. The symbolic analysis
+ * is done once here and reused for all subsequent factorizations.
+ */
+int allocateNewtonDataSparse(int size, SPARSE_PATTERN* pattern, void** voiddata)
+{
+#ifdef WITH_UMFPACK
+  DATA_NEWTON* data;
+  int i;
+
+  allocateNewtonDataCommon(size, 0, voiddata);
+  data = (DATA_NEWTON*) *voiddata;
+
+  data->useSparse = 1;
+  data->nnz = pattern->numberOfNoneZeros;
+  data->Ap = (int*) malloc((size+1)*sizeof(int));
+  data->Ai = (int*) malloc(data->nnz*sizeof(int));
+  data->Ax = (double*) calloc(data->nnz, sizeof(double));
+
+  data->Ap[0] = 0;
+  for(i=0; i<size; i++)
+    data->Ap[i+1] = pattern->leadindex[i];
+  for(i=0; i<data->nnz; i++)
+    data->Ai[i] = pattern->index[i];
+
+  klu_defaults(&data->common);
+  data->symbolic = klu_analyze(size, data->Ap, data->Ai, &data->common);
+  assertStreamPrint(NULL, NULL != data->symbolic, "allocateNewtonDataSparse() failed: KLU symbolic analysis failed!");
+
+  return 0;
+#else
+  throwStreamPrint(NULL, "allocateNewtonDataSparse() failed: OMC is compiled without UMFPACK, if you want use klu please compile OMC with UMFPACK.");
+  return -1;
+#endif
+}
+
+
 /*! \fn freeNewtonData
  *
  * free memory for nonlinear solver newton
@@ -145,6 +205,17 @@ int freeNewtonData(void **voiddata)
   free(data->delta_f);
   free(data->delta_x_vec);
 
+  /* sparse newton */
+#ifdef WITH_UMFPACK
+  if(data->numeric)
+    klu_free_numeric(&data->numeric, &data->common);
+  if(data->symbolic)
+    klu_free_symbolic(&data->symbolic, &data->common);
+#endif
+  free(data->Ap);
+  free(data->Ai);
+  free(data->Ax);
+
   return 0;
 }
 
@@ -238,7 +309,15 @@ int _omc_newton(int(*f)(int*, double*, double*, void*, int), DATA_NEWTON* solver
 
 
     /* debug output */
-    if(ACTIVE_STREAM(LOG_NLS_JAC))
+    if(ACTIVE_STREAM(LOG_NLS_JAC) && solverData->useSparse)
+    {
+      infoStreamPrint(LOG_NLS_JAC, 1, "sparse jacobian matrix [%dx%d] with %d nonzeros", (int)*n, (int)*n, solverData->nnz);
+      for(j=0; j<solverData->n; j++)
+        for(i=solverData->Ap[j]; i<solverData->Ap[j+1]; i++)
+          infoStreamPrint(LOG_NLS_JAC, 0, "(%d,%d) = %10g", solverData->Ai[i], j, solverData->Ax[i]);
+      messageClose(LOG_NLS_JAC);
+    }
+    else if(ACTIVE_STREAM(LOG_NLS_JAC))
     {
       char *buffer = (char*)malloc(sizeof(char)*solverData->n*15);
 
@@ -352,6 +431,57 @@ void printErrors(double delta_x, double delta_x_scaled, double delta_f, double e
   messageClose(LOG_NLS_V);
 }
 
+/*! \fn solveLinearSystemSparse
+ *
+ *  function solves linear system J*(x_{n+1} - x_n) = f using klu
+ *
+ *  The symbolic analysis from the allocation is reused. If a numeric
+ *  factorization exists it is refactored with the new values and only
+ *  factorized from scratch if the pivoting became unstable.
+ */
+static int solveLinearSystemSparse(int* n, double* fvec, DATA_NEWTON* solverData)
+{
+#ifdef WITH_UMFPACK
+  int nrsh = 1;
+
+  /* if no factorization is given, calculate it */
+  if (solverData->factorization == 0)
+  {
+    if (solverData->numeric)
+    {
+      klu_refactor(solverData->Ap, solverData->Ai, solverData->Ax, solverData->symbolic, solverData->numeric, &solverData->common);
+      klu_rgrowth(solverData->Ap, solverData->Ai, solverData->Ax, solverData->symbolic, solverData->numeric, &solverData->common);
+      if (solverData->common.status != KLU_OK || solverData->common.rgrowth < 1e-3)
+      {
+        klu_free_numeric(&solverData->numeric, &solverData->common);
+        solverData->numeric = NULL;
+      }
+    }
+    if (!solverData->numeric)
+      solverData->numeric = klu_factor(solverData->Ap, solverData->Ai, solverData->Ax, solverData->symbolic, &solverData->common);
+    if (!solverData->numeric || solverData->common.status == KLU_SINGULAR)
+    {
+      warningStreamPrint(LOG_NLS, 0, "Jacobian Matrix singular!");
+      return -1;
+    }
+    solverData->factorization = 1;
+  }
+
+  if (!klu_solve(solverData->symbolic, solverData->numeric, *n, nrsh, fvec, &solverData->common))
+  {
+    warningStreamPrint(LOG_NLS, 0, "klu_solve failed with status %d", (int)solverData->common.status);
+    return -1;
+  }
+
+  /* save solution of J*(x_{n+1} - x_n)=f */
+  memcpy(solverData->x_increment, fvec, *n*sizeof(double));
+
+  return 0;
+#else
+  return -1;
+#endif
+}
+
 /*! \fn solveLinearSystem
  *
  *  function solves linear system J*(x_{n+1} - x_n) = f using lapack
@@ -361,6 +491,9 @@ int solveLinearSystem(int* n, int* iwork, double* fvec, double *fjac, DATA_NEWTO
   int i, nrsh=1, lapackinfo;
   char trans = 'N';
 
+  if (solverData->useSparse)
+    return solveLinearSystemSparse(n, fvec, solverData);
+
   /* if no factorization is given, calculate it */
   if (solverData->factorization == 0)
   {
@@ -438,6 +571,21 @@ void calculatingErrors(DATA_NEWTON* solverData, double* delta_x, double* delta_x
 void scaling_residual_vector(DATA_NEWTON* solverData)
 {
   int i,j,k;
+  if(solverData->useSparse)
+  {
+    for(i=0; i<solverData->n; i++)
+    {
+      solverData->resScaling[i] = 0.0;
+      for(k=solverData->Ap[i]; k<solverData->Ap[i+1]; k++)
+        solverData->resScaling[i] = fmax(fabs(solverData->Ax[k]), solverData->resScaling[i]);
+      if(solverData->resScaling[i] <= 0.0){
+        warningStreamPrint(LOG_NLS_V, 0, "Jacobian matrix is singular.");
+        solverData->resScaling[i] = 1e-16;
+      }
+      solverData->fvecScaled[i] = solverData->fvec[i] / solverData->resScaling[i];
+    }
+    return;
+  }
   for(i=0, k=0; i<solverData->n; i++)
   {
     solverData->resScaling[i] = 0.0;
@@ -36,6 +36,11 @@
 
 #include "simulation_data.h"
 #include "nonlinearSolverNewton.h"
+#include "omc_config.h"
+
+#ifdef WITH_UMFPACK
+#include "suitesparse/Include/klu.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -73,12 +78,25 @@ typedef struct DATA_NEWTON
   double* delta_f;
   double* delta_x_vec;
 
+  /* sparse newton, jacobian in compressed column format */
+  int useSparse;
+  int nnz;
+  int* Ap;
+  int* Ai;
+  double* Ax;
+#ifdef WITH_UMFPACK
+  klu_symbolic* symbolic;
+  klu_numeric* numeric;
+  klu_common common;
+#endif
+
    rtclock_t timeClock;
 
 } DATA_NEWTON;
 
 
 int allocateNewtonData(int size, void** data);
+int allocateNewtonDataSparse(int size, SPARSE_PATTERN* pattern, void** data);
 int freeNewtonData(void** data);
 int _omc_newton(int(*f)(int*, double*, double*, void*, int), DATA_NEWTON* solverData, void* userdata);
 
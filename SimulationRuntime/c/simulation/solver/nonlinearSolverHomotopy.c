@@ -48,6 +48,11 @@
 #include "nonlinearSystem.h"
 #include "nonlinearSolverHomotopy.h"
 #include "nonlinearSolverHybrd.h"
+#include "omc_config.h"
+
+#ifdef WITH_UMFPACK
+#include "suitesparse/Include/klu.h"
+#endif
 
 /*! \typedef DATA_HOMOTOPY
  * define memory structure for nonlinear system solver
@@ -120,6 +125,29 @@ typedef struct DATA_HOMOTOPY
   int* indRow;
   int* indCol;
 
+  /* sparse variant: augmented matrix [H_y H_lambda; e_pos^T] of size m in
+   * compressed column format, the diagonal is always included */
+  int useSparse;
+  int nnz;
+  int* Ap;
+  int* Ai;
+  int* structural;  /* FALSE for diagonal and border elements added to the pattern */
+  int* diagIdx;     /* position of the diagonal element in each column */
+  int* borderIdx;   /* position of the border element in each column */
+  double* Ax;       /* jacobian scaled by xScaling, last column is H_lambda resp. f */
+  double* Ax0;      /* Ax at x0 */
+  double* Axs;      /* row scaled values of the current factorization */
+  double* rowScale; /* row scaling of the current factorization */
+  double* rhs;
+  int pos;          /* fixed component of the path parametrization */
+  int factorPos;    /* border position of the current factorization, -1 if none */
+  int numberOfFactorizations;
+#ifdef WITH_UMFPACK
+  klu_symbolic* symbolic;
+  klu_numeric* numeric;
+  klu_common common;
+#endif
+
   int (*f)         (struct DATA_HOMOTOPY*, double*, double*);
   int (*fJac_f)    (struct DATA_HOMOTOPY*, double*, double*);
   int (*h_function)(struct DATA_HOMOTOPY*, double*, double*);
@@ -136,11 +164,12 @@ typedef struct DATA_HOMOTOPY
 
 } DATA_HOMOTOPY;
 
-/*! \fn allocateHomotopyData
- *  allocate memory for nonlinear system solver
+/*! \fn allocateHomotopyDataCommon
+ *  allocate memory for nonlinear system solver, the dense matrices and the
+ *  hybrid fallback solver are only allocated if dense is set
  *  \author bbachmann
  */
-int allocateHomotopyData(int size, void** voiddata)
+static int allocateHomotopyDataCommon(int size, int dense, void** voiddata)
 {
   DATA_HOMOTOPY* data = (DATA_HOMOTOPY*) malloc(sizeof(DATA_HOMOTOPY));
 
@@ -177,12 +206,12 @@ int allocateHomotopyData(int size, void** voiddata)
   data->x1 = (double*) calloc(size,sizeof(double));
   data->finit = (double*) calloc(size,sizeof(double));
   data->fx0 = (double*) calloc(size,sizeof(double));
-  data->fJac = (double*) calloc((size*(size+1)),sizeof(double));
-  data->fJacx0 = (double*) calloc((size*(size+1)),sizeof(double));
+  data->fJac = dense ? (double*) calloc((size*(size+1)),sizeof(double)) : NULL;
+  data->fJacx0 = dense ? (double*) calloc((size*(size+1)),sizeof(double)) : NULL;
 
   /* debug arrays */
   data->debug_dx = (double*) calloc(size,sizeof(double));
-  data->debug_fJac = (double*) calloc((size*(size+1)),sizeof(double));
+  data->debug_fJac = dense ? (double*) calloc((size*(size+1)),sizeof(double)) : NULL;
 
    /* homotopy */
   data->y0 = (double*) calloc((size+1),sizeof(double));
@@ -193,20 +222,142 @@ int allocateHomotopyData(int size, void** voiddata)
   data->dy1 = (double*) calloc((size+1),sizeof(double));
   data->dy2 = (double*) calloc((size+1),sizeof(double));
   data->hvec = (double*) calloc(size,sizeof(double));
-  data->hJac  = (double*) calloc(size*(size+1),sizeof(double));
-  data->hJacInit  = (double*) calloc(size*(size+1),sizeof(double));
+  data->hJac  = dense ? (double*) calloc(size*(size+1),sizeof(double)) : NULL;
+  data->hJacInit  = dense ? (double*) calloc(size*(size+1),sizeof(double)) : NULL;
   data->ones  = (double*) calloc(size+1,sizeof(double));
 
   /* linear system */
   data->indRow =(int*) calloc(size,sizeof(int));
   data->indCol =(int*) calloc(size+1,sizeof(int));
 
-  allocateHybrdData(size, &data->dataHybrid);
+  if (dense)
+    allocateHybrdData(size, &data->dataHybrid);
+  else
+    data->dataHybrid = NULL;
+
+  data->useSparse = 0;
+  data->nnz = 0;
+  data->Ap = NULL;
+  data->Ai = NULL;
+  data->structural = NULL;
+  data->diagIdx = NULL;
+  data->borderIdx = NULL;
+  data->Ax = NULL;
+  data->Ax0 = NULL;
+  data->Axs = NULL;
+  data->rowScale = NULL;
+  data->rhs = NULL;
+  data->pos = size;
+  data->factorPos = -1;
+  data->numberOfFactorizations = 0;
+#ifdef WITH_UMFPACK
+  data->symbolic = NULL;
+  data->numeric = NULL;
+#endif
 
   assertStreamPrint(NULL, 0 != *voiddata, "allocationHomotopyData() voiddata failed!");
   return 0;
 }
 
+/*! \fn allocateHomotopyData
+ *  allocate memory for nonlinear system solver
+ *  \author bbachmann
+ */
+int allocateHomotopyData(int size, void** voiddata)
+{
+  return allocateHomotopyDataCommon(size, 1, voiddata);
+}
+
+/*! \fn allocateHomotopyDataSparse
+ *  allocate memory for nonlinear system solver using a sparse jacobian
+ *
+ *  Newton steps, path tangents and corrector steps all solve a system with
+ *  the augmented matrix [H_y H_lambda; e_pos^T], where the border row fixes
+ *  the component pos of the solution. Its structure is the sparse pattern of
+ *  the system plus the diagonal, a dense lambda column and a dense border
+ *  row, so it never changes and the KLU symbolic analysis is done once here.
+ */
+int allocateHomotopyDataSparse(int size, SPARSE_PATTERN* pattern, void** voiddata)
+{
+#ifdef WITH_UMFPACK
+  DATA_HOMOTOPY* data;
+  int i, j, k, l, nnz, hasDiag;
+
+  allocateHomotopyDataCommon(size, 0, voiddata);
+  data = (DATA_HOMOTOPY*) *voiddata;
+
+  data->useSparse = 1;
+  data->Ap = (int*) malloc((size+2)*sizeof(int));
+  data->Ai = (int*) malloc((pattern->numberOfNoneZeros + 3*size + 1)*sizeof(int));
+  data->structural = (int*) malloc((pattern->numberOfNoneZeros + 3*size + 1)*sizeof(int));
+  data->diagIdx = (int*) malloc(size*sizeof(int));
+  data->borderIdx = (int*) malloc((size+1)*sizeof(int));
+
+  for (j=0, nnz=0; j<size; j++)
+  {
+    data->Ap[j] = nnz;
+    hasDiag = 0;
+    for (k = j ? pattern->leadindex[j-1] : 0; k < pattern->leadindex[j]; k++)
+    {
+      data->Ai[nnz] = pattern->index[k];
+      data->structural[nnz] = 1;
+      hasDiag |= (int)pattern->index[k] == j;
+      nnz++;
+    }
+    if (!hasDiag)
+    {
+      data->Ai[nnz] = j;
+      data->structural[nnz] = 0;
+      nnz++;
+    }
+    /* sort the column by row indices */
+    for (k = data->Ap[j]+1; k < nnz; k++)
+    {
+      for (l = k; l > data->Ap[j] && data->Ai[l-1] > data->Ai[l]; l--)
+      {
+        i = data->Ai[l]; data->Ai[l] = data->Ai[l-1]; data->Ai[l-1] = i;
+        i = data->structural[l]; data->structural[l] = data->structural[l-1]; data->structural[l-1] = i;
+      }
+    }
+    for (k = data->Ap[j]; k < nnz; k++)
+    {
+      if (data->Ai[k] == j)
+        data->diagIdx[j] = k;
+    }
+    /* border row */
+    data->borderIdx[j] = nnz;
+    data->Ai[nnz] = size;
+    data->structural[nnz] = 0;
+    nnz++;
+  }
+  /* lambda column */
+  data->Ap[size] = nnz;
+  for (i=0; i<=size; i++, nnz++)
+  {
+    data->Ai[nnz] = i;
+    data->structural[nnz] = 0;
+  }
+  data->borderIdx[size] = nnz-1;
+  data->Ap[size+1] = nnz;
+  data->nnz = nnz;
+
+  data->Ax = (double*) calloc(nnz, sizeof(double));
+  data->Ax0 = (double*) calloc(nnz, sizeof(double));
+  data->Axs = (double*) calloc(nnz, sizeof(double));
+  data->rowScale = (double*) calloc(size+1, sizeof(double));
+  data->rhs = (double*) calloc(size+1, sizeof(double));
+
+  klu_defaults(&data->common);
+  data->symbolic = klu_analyze(size+1, data->Ap, data->Ai, &data->common);
+  assertStreamPrint(NULL, NULL != data->symbolic, "allocateHomotopyDataSparse() failed: KLU symbolic analysis failed!");
+
+  return 0;
+#else
+  throwStreamPrint(NULL, "allocateHomotopyDataSparse() failed: OMC is compiled without UMFPACK, if you want use klu please compile OMC with UMFPACK.");
+  return -1;
+#endif
+}
+
 /*! \fn freeHomotopyData
  *
  *  free memory for nonlinear system solver
@@ -254,7 +405,26 @@ int freeHomotopyData(void **voiddata)
   free(data->indRow);
   free(data->indCol);
 
-  freeHybrdData(&data->dataHybrid);
+  if (data->dataHybrid)
+    freeHybrdData(&data->dataHybrid);
+
+  /* sparse variant */
+#ifdef WITH_UMFPACK
+  if (data->numeric)
+    klu_free_numeric(&data->numeric, &data->common);
+  if (data->symbolic)
+    klu_free_symbolic(&data->symbolic, &data->common);
+#endif
+  free(data->Ap);
+  free(data->Ai);
+  free(data->structural);
+  free(data->diagIdx);
+  free(data->borderIdx);
+  free(data->Ax);
+  free(data->Ax0);
+  free(data->Axs);
+  free(data->rowScale);
+  free(data->rhs);
 
   return 0;
 }
@@ -784,6 +954,49 @@ int getAnalyticalJacobianHomotopy(DATA_HOMOTOPY* solverData, double* jac)
   return 0;
 }
 
+/*! \fn getAnalyticalJacobianHomotopySparse
+ *
+ *  function calculates analytical jacobian in the compressed column format
+ *  of the augmented matrix, the lambda column and the border row are not set
+ *
+ *  \param [ref] [data]
+ *  \param [out] [jac]
+ */
+static int getAnalyticalJacobianHomotopySparse(DATA_HOMOTOPY* solverData, double* jac)
+{
+  DATA* data = solverData->data;
+  threadData_t *threadData = solverData->threadData;
+  int i,j,k,ii;
+  NONLINEAR_SYSTEM_DATA* systemData = &(data->simulationInfo->nonlinearSystemData[solverData->sysNumber]);
+  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[systemData->jacobianIndex]);
+
+  for(i=0; i < jacobian->sparsePattern.maxColors; i++)
+  {
+    /* activate seed variable for the corresponding color */
+    for(ii=0; ii < jacobian->sizeCols; ii++)
+      if(jacobian->sparsePattern.colorCols[ii]-1 == i)
+        jacobian->seedVars[ii] = 1;
+
+    ((systemData->analyticalJacobianColumn))(data, threadData);
+
+    for(j = 0; j < jacobian->sizeCols; j++)
+    {
+      if(jacobian->seedVars[j] == 1)
+      {
+        for(k = solverData->Ap[j]; k < solverData->borderIdx[j]; k++)
+        {
+          /* scaled like the dense jacobian, diagonal elements added to the pattern are zero */
+          jac[k] = solverData->structural[k] ? jacobian->resultVars[solverData->Ai[k]] * solverData->xScaling[j] : 0.0;
+        }
+        /* de-activate seed variable for the corresponding color */
+        jacobian->seedVars[j] = 0;
+      }
+    }
+  }
+
+  return 0;
+}
+
 /*! \fn getNumericalJacobianHomotopy
  *
  *  function calculates a jacobian matrix by
@@ -953,6 +1166,50 @@ static int wrapper_fvec_homotopy_fixpoint_der(DATA_HOMOTOPY* solverData, double*
   return 0;
 }
 
+/*! \fn wrapper_fvec_der_sparse for the sparse jacobian of the residual Function
+ *
+ */
+static int wrapper_fvec_der_sparse(DATA_HOMOTOPY* solverData, double* x, double* Ax)
+{
+  getAnalyticalJacobianHomotopySparse(solverData, Ax);
+  return 0;
+}
+
+/*! \fn wrapper_fvec_homotopy_newton_der_sparse for the sparse jacobian of the Newton homotopy
+ *
+ */
+static int wrapper_fvec_homotopy_newton_der_sparse(DATA_HOMOTOPY* solverData, double* x, double* Ax)
+{
+  int n = solverData->n;
+
+  getAnalyticalJacobianHomotopySparse(solverData, Ax);
+
+  /* add f(x0) as the lambda column of the Jacobian */
+  vecCopy(n, solverData->fx0, Ax + solverData->Ap[n]);
+
+  return 0;
+}
+
+/*! \fn wrapper_fvec_homotopy_fixpoint_der_sparse for the sparse jacobian of the fixpoint homotopy
+ *
+ *  solverData->f1 must be the residual at x
+ */
+static int wrapper_fvec_homotopy_fixpoint_der_sparse(DATA_HOMOTOPY* solverData, double* x, double* Ax)
+{
+  int i, k;
+  int n = solverData->n;
+
+  getAnalyticalJacobianHomotopySparse(solverData, Ax);
+  for (i=0; i<n; i++) {
+    for (k=solverData->Ap[i]; k<solverData->borderIdx[i]; k++)
+      Ax[k] *= x[n];
+    /* the columns are scaled, so is the identity */
+    Ax[solverData->diagIdx[i]] += (1-x[n]) * solverData->xScaling[i];
+    Ax[solverData->Ap[n] + i] = solverData->f1[i]-(x[i] - solverData->x0[i]);
+  }
+  return 0;
+}
+
 /*! \fn getIndicesOfPivotElement for calculating pivot element
  *
  *  \author bbachmann
@@ -1091,6 +1348,161 @@ int solveSystemWithTotalPivotSearch(int n, double* x, double* A, int* indRow, in
 
   return 0;
 }
+/*! \fn calcResidualScalingSparse
+ *
+ *  residual scaling as sum of the absolute row values of the first
+ *  nCols columns of the sparse jacobian
+ */
+static void calcResidualScalingSparse(DATA_HOMOTOPY* solverData, int nCols)
+{
+  int j, k;
+
+  vecConst(solverData->n, 0.0, solverData->resScaling);
+  for (j=0; j<nCols; j++)
+    for (k=solverData->Ap[j]; k<solverData->borderIdx[j]; k++)
+      solverData->resScaling[solverData->Ai[k]] += fabs(solverData->Ax[k]);
+}
+
+/*! \fn factorizeSparseHomotopy
+ *
+ *  factorizes the augmented matrix [H_y H_lambda; e_pos^T] with scaled rows,
+ *  like scaleMatrixRows does for the dense matrix. The symbolic analysis is
+ *  reused and the previous numeric factorization is refactored, unless the
+ *  pivoting became unstable.
+ */
+static int factorizeSparseHomotopy(DATA_HOMOTOPY* solverData, int pos)
+{
+#ifdef WITH_UMFPACK
+  int j, k, n = solverData->n;
+
+  for (j=0; j<solverData->m; j++)
+    solverData->Ax[solverData->borderIdx[j]] = (j == pos) ? 1.0 : 0.0;
+
+  vecConst(n, sqrt(DBL_EPSILON), solverData->rowScale);
+  solverData->rowScale[n] = 1.0;
+  for (k=0; k<solverData->nnz; k++)
+    if (solverData->Ai[k] < n && fabs(solverData->Ax[k]) > solverData->rowScale[solverData->Ai[k]])
+      solverData->rowScale[solverData->Ai[k]] = fabs(solverData->Ax[k]);
+  for (k=0; k<solverData->nnz; k++)
+    solverData->Axs[k] = solverData->Ax[k] / solverData->rowScale[solverData->Ai[k]];
+
+  solverData->factorPos = -1;
+  if (solverData->numeric)
+  {
+    klu_refactor(solverData->Ap, solverData->Ai, solverData->Axs, solverData->symbolic, solverData->numeric, &solverData->common);
+    klu_rgrowth(solverData->Ap, solverData->Ai, solverData->Axs, solverData->symbolic, solverData->numeric, &solverData->common);
+    if (solverData->common.status != KLU_OK || solverData->common.rgrowth < 1e-3)
+    {
+      klu_free_numeric(&solverData->numeric, &solverData->common);
+      solverData->numeric = NULL;
+    }
+  }
+  if (!solverData->numeric)
+    solverData->numeric = klu_factor(solverData->Ap, solverData->Ai, solverData->Axs, solverData->symbolic, &solverData->common);
+  solverData->numberOfFactorizations++;
+  if (!solverData->numeric || solverData->common.status == KLU_SINGULAR)
+  {
+    warningStreamPrint(LOG_NLS, 0, "Matrix singular!");
+    return -1;
+  }
+  klu_rcond(solverData->symbolic, solverData->numeric, &solverData->common);
+  if (solverData->common.rcond < DBL_EPSILON)
+  {
+    warningStreamPrint(LOG_NLS, 0, "Matrix singular!");
+    debugDouble(LOG_NLS, "rcond = ", solverData->common.rcond);
+    return -1;
+  }
+  solverData->factorPos = pos;
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+/*! \fn solveSparseHomotopy
+ *
+ *  solves the system with the current factorization, rhs has size m and is
+ *  overwritten by the solution in scaled variables
+ */
+static int solveSparseHomotopy(DATA_HOMOTOPY* solverData, double* rhs)
+{
+#ifdef WITH_UMFPACK
+  int i;
+
+  for (i=0; i<solverData->n; i++)
+    rhs[i] /= solverData->rowScale[i];
+  if (!klu_solve(solverData->symbolic, solverData->numeric, solverData->m, 1, rhs, &solverData->common))
+  {
+    warningStreamPrint(LOG_NLS, 0, "klu_solve failed with status %d", (int)solverData->common.status);
+    return -1;
+  }
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+/*! \fn calcNewtonJacobian
+ *
+ *  calculates the jacobian at x and stores f = solverData->f1 as last column
+ */
+static void calcNewtonJacobian(DATA_HOMOTOPY* solverData, double* x)
+{
+  int n = solverData->n;
+
+  if (solverData->useSparse)
+  {
+    solverData->fJac_f(solverData, x, solverData->Ax);
+    vecCopy(n, solverData->f1, solverData->Ax + solverData->Ap[n]);
+  }
+  else
+  {
+    solverData->fJac_f(solverData, x, solverData->fJac);
+    vecCopy(n, solverData->f1, solverData->fJac + n*n);
+  }
+}
+
+/*! \fn scaleNewtonJacobian
+ *
+ *  calculates the scaling factors of the residuals, the rows of the dense
+ *  jacobian are scaled here, the rows of the sparse one at factorization
+ */
+static void scaleNewtonJacobian(DATA_HOMOTOPY* solverData)
+{
+  if (solverData->useSparse)
+  {
+    calcResidualScalingSparse(solverData, solverData->n);
+  }
+  else
+  {
+    matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
+  }
+  debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", solverData->resScaling, solverData->n);
+  if (!solverData->useSparse)
+  {
+    scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+  }
+}
+
+/*! \fn solveNewtonStep
+ *
+ *  solves J*dy = -f for the jacobian [J f] of calcNewtonJacobian, dy[n] = 1
+ */
+static int solveNewtonStep(DATA_HOMOTOPY* solverData, double* dy)
+{
+  int pos = solverData->n, rank;
+
+  if (solverData->useSparse)
+  {
+    if (factorizeSparseHomotopy(solverData, pos) != 0)
+      return -1;
+    vecConst(solverData->n, 0.0, dy);
+    dy[solverData->n] = 1.0;
+    return solveSparseHomotopy(solverData, dy);
+  }
+  return solveSystemWithTotalPivotSearch(solverData->n, dy, solverData->fJac, solverData->indRow, solverData->indCol, &pos, &rank);
+}
+
 /*! \fn solve system with damped Newton-Raphson
  *
  *  \author bbachmann
@@ -1099,7 +1511,6 @@ int solveSystemWithTotalPivotSearch(int n, double* x, double* A, int* indRow, in
 static int newtonAlgorithm(DATA_HOMOTOPY* solverData, double* x)
 {
   int numberOfIterations = 0 ,i, j, n=solverData->n, m=solverData->m;
-  int  pos = solverData->n, rank;
   double error_f_sqrd, error_f1_sqrd, error_f2_sqrd, error_f_sqrd_scaled, delta_x_sqrd, delta_x_sqrd_scaled, grad_f;
   int numberOfSmallSteps = 0;
   double error_f_old = 1e100;
@@ -1135,7 +1546,7 @@ static int newtonAlgorithm(DATA_HOMOTOPY* solverData, double* x)
     debugInt(LOG_NLS_V, "Iteration:", numberOfIterations);
 
     /* solve jacobian and function value (both stored in hJac, last column is fvec), side effects: jacobian matrix is changed */
-    if ((numberOfIterations>1) && (solveSystemWithTotalPivotSearch(solverData->n, solverData->dy0, solverData->fJac, solverData->indRow, solverData->indCol, &pos, &rank) != 0))
+    if ((numberOfIterations>1) && (solveNewtonStep(solverData, solverData->dy0) != 0))
     {
       /* report solver abortion */
       solverData->info=-1;
@@ -1375,7 +1786,7 @@ static int newtonAlgorithm(DATA_HOMOTOPY* solverData, double* x)
     MMC_TRY_INTERNAL(simulationJumpBuffer)
 #endif
     /* calculate jacobian and function values (both stored in fJac, last column is fvec) */
-    solverData->fJac_f(solverData, x, solverData->fJac);
+    calcNewtonJacobian(solverData, x);
     assert = 0;
 #ifndef OMC_EMCC
     MMC_CATCH_INTERNAL(simulationJumpBuffer)
@@ -1387,11 +1798,8 @@ static int newtonAlgorithm(DATA_HOMOTOPY* solverData, double* x)
       debugString(LOG_NLS_V,"UPS! assert when calculating Jacobian!!!");
       break;
     }
-    vecCopy(n, solverData->f1, solverData->fJac + n*n);
     /* calculate scaling factor of residuals */
-    matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
-    debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", solverData->resScaling, solverData->n);
-    scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+    scaleNewtonJacobian(solverData);
   }
   return 0;
 }
@@ -1678,6 +2086,353 @@ static int homotopyAlgorithm(DATA_HOMOTOPY* solverData, double *x)
   return 0;
 }
 
+/*! \fn tangentSparseHomotopy
+ *
+ *  calculates the tangent dy of the path at the point of the current jacobian
+ *  from [H_y H_lambda; e_pos^T]*dy = [0; 1]. Afterwards pos is moved to the
+ *  largest component of the tangent and dy is normalized to dy[pos] = 1, as
+ *  the total pivot search does for the dense matrix. If the matrix is
+ *  singular for the given pos, the second largest component of the previous
+ *  tangent prevTangent is tried.
+ */
+static int tangentSparseHomotopy(DATA_HOMOTOPY* solverData, double* prevTangent, double* dy, int* pos)
+{
+  int i, alt = -1, newPos;
+  int m = solverData->m;
+
+  if (factorizeSparseHomotopy(solverData, *pos) != 0)
+  {
+    for (i=0; i<m; i++)
+      if (i != *pos && (alt < 0 || fabs(prevTangent[i]/solverData->xScaling[i]) > fabs(prevTangent[alt]/solverData->xScaling[alt])))
+        alt = i;
+    debugInt(LOG_NLS_HOMOTOPY, "singular parametrization, try position ", alt);
+    if (alt < 0 || factorizeSparseHomotopy(solverData, alt) != 0)
+      return -1;
+    *pos = alt;
+  }
+
+  vecConst(m, 0.0, dy);
+  dy[solverData->n] = 1.0;
+  if (solveSparseHomotopy(solverData, dy) != 0)
+    return -1;
+
+  for (i=0, newPos=*pos; i<m; i++)
+    if (fabs(dy[i]) > fabs(dy[newPos]))
+      newPos = i;
+  vecScalarMult(m, dy, 1.0/dy[newPos], dy);
+  *pos = newPos;
+
+  return 0;
+}
+
+/*! \fn homotopyAlgorithmSparse
+ *
+ *  path following of homotopyAlgorithm with the sparse augmented matrix.
+ *
+ *  The corrector is a simplified Newton iteration, it reuses the
+ *  factorization of the tangent and only evaluates and factorizes the
+ *  jacobian again, if the contraction rate theta of the iteration exceeds
+ *  thetaMax. The step size tau is controlled by the contraction rate of the
+ *  first corrector steps, which grows with the square of tau, and the bend
+ *  of the path, which grows linearly with tau.
+ */
+static int homotopyAlgorithmSparse(DATA_HOMOTOPY* solverData, double *x)
+{
+  int j;
+  double error_h, error_h_scaled, delta_x, delta_x_old;
+  double vecScalarProduct;
+
+  int pos = solverData->n;
+  int iter = 0;
+  int maxiter = 20;
+  int numSteps = 0;
+  int stepAccept = 0;
+  int lastRefresh;
+  int factorizationsOld = solverData->numberOfFactorizations;
+  double bend = 0, theta, thetaFirst, fac;
+  double tau = 0.2, tauMax = 10.0, tauMin = 1e-4, hEps = 1e-3, adaptBend = 0.05;
+  double thetaTarget = 0.25, thetaMax = 0.5;
+  int m = solverData->m;
+  int n = solverData->n;
+  int initialStep = 1;
+
+  int assert = 1;
+  threadData_t *threadData = solverData->threadData;
+
+  /* Initialize vector dy2 using chosen startDirection */
+  /* set start vector, lambda = 0.0 */
+  vecCopy(n, x, solverData->y0);
+  solverData->y0[n] = 0.0;
+
+  vecConst(n, 0.0, solverData->dy2);
+  solverData->dy2[n]= solverData->startDirection;
+  printHomotopyUnknowns(LOG_NLS, solverData);
+  assert = 1;
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+    solverData->h_function(solverData, solverData->y0, solverData->hvec);
+    assert = 0;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  /* start iteration; stop, if lambda = solverData->y0[n] == 1 */
+  while (solverData->y0[n]<1)
+  {
+    /* Break loop, iff algorithm gets stuck or lambda accelerates to the wrong direction */
+    if (iter>10)
+    {
+      debugInt(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge: iter = ", iter);
+      debugString(LOG_NLS_HOMOTOPY, "======================================================");
+      return -1;
+    }
+    if (solverData->y0[n]<(-1))
+    {
+      debugDouble(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge: lambda = ", solverData->y0[n]);
+      debugString(LOG_NLS_HOMOTOPY, "======================================================");
+      return -1;
+    }
+    if (numSteps >= solverData->maxNumberOfIterations)
+    {
+      debugInt(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge: numSteps = ", numSteps);
+      debugString(LOG_NLS_HOMOTOPY, "======================================================");
+      return -1;
+    }
+
+    stepAccept = 0;
+
+    /* If a step succeeded, calculate the jacobian and the tangent of the path */
+    if (iter==0)
+    {
+      assert = 1;
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+      solverData->hJac_dh(solverData, solverData->y0, solverData->Ax);
+      assert = 0;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+
+      if (assert || (tangentSparseHomotopy(solverData, solverData->dy2, solverData->dy0, &pos) != 0))
+      {
+        /* report solver abortion */
+        solverData->info=-1;
+        /* debug information */
+        if (assert)
+          debugString(LOG_NLS_HOMOTOPY, "Assert, when calculating Jacobian!");
+        else
+          debugString(LOG_NLS_HOMOTOPY, "System singular and not solvable!");
+        debugString(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge");
+        debugString(LOG_NLS_HOMOTOPY, "======================================================");
+        return -1;
+      }
+      calcResidualScalingSparse(solverData, m);
+      vecMultScaling(m, solverData->dy0, solverData->xScaling, solverData->dy0);
+
+      /* Correct search direction, depending on the last direction (angle < 90 degree) */
+      vecScalarProduct = vecScalarProd(m,solverData->dy0,solverData->dy2);
+      debugDouble(LOG_NLS_HOMOTOPY,"scalar product ", vecScalarProduct);
+      if (vecScalarProduct<0 || ((fabs(vecScalarProduct)<DBL_EPSILON) && (solverData->startDirection == -1) && initialStep))
+      {
+        debugVectorDouble(LOG_NLS_HOMOTOPY,"step:",solverData->dy0, m);
+        vecAddInv(m, solverData->dy0, solverData->dy0);
+        debugVectorDouble(LOG_NLS_HOMOTOPY,"corrected step:",solverData->dy0, m);
+      }
+      /* adapt tau, if lambda + tau*delta_lambda > 1 */
+      if (fabs(solverData->dy0[n])>1e-8)
+      {
+        tau = fmin(tau,(1-solverData->y0[n])/fabs(solverData->dy0[n]));
+      }
+    }
+
+    assert = 1;
+    while (assert && (tau > tauMin))
+    {
+      /* do update and store approximated vector in yt */
+      vecAddScal(m, solverData->y0, solverData->dy0, tau,  solverData->y1);
+
+      /* update function value */
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+      solverData->h_function(solverData, solverData->y1, solverData->hvec);
+      assert = 0;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+     if (assert)
+       tau = tau/2;
+    }
+    if (assert)
+    {
+        /* report solver abortion */
+        solverData->info=-1;
+        /* debug information */
+        debugString(LOG_NLS_HOMOTOPY, "Assert, when calculating function value!");
+        debugString(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge");
+        debugString(LOG_NLS_HOMOTOPY, "======================================================");
+        return -1;
+    }
+    vecCopy(m, solverData->y1, solverData->y2);
+    vecCopy(m, solverData->y1, solverData->yt);
+    vecCopy(n, solverData->hvec, solverData->hvecScaled);
+
+    solverData->tau = tau;
+    printHomotopyPredictorStep(LOG_NLS_HOMOTOPY, solverData);
+
+    /* the corrector fixes the component pos, the factorization of the tangent is
+     * reused, only the border row changes, if the tangent moved pos */
+    if (solverData->factorPos != pos && factorizeSparseHomotopy(solverData, pos) != 0)
+    {
+      solverData->info=-1;
+      debugString(LOG_NLS_HOMOTOPY, "System singular and not solvable!");
+      debugString(LOG_NLS_HOMOTOPY, "Homotopy Algorithm did not converge");
+      debugString(LOG_NLS_HOMOTOPY, "======================================================");
+      return -1;
+    }
+
+    /* Corrector step: simplified Newton iteration! */
+    delta_x_old = -1;
+    thetaFirst = -1;
+    lastRefresh = -2;
+    for(j=0;j<maxiter;j++)
+    {
+      if (vec2Norm(n, solverData->hvec)<hEps || vec2Norm(n, solverData->hvecScaled)<hEps)
+      {
+        stepAccept = 1;
+        break;
+      }
+      vecAddInv(n, solverData->hvec, solverData->dy1);
+      solverData->dy1[n] = 0.0;
+      if (solveSparseHomotopy(solverData, solverData->dy1) != 0)
+      {
+        stepAccept = 0;
+        break;
+      }
+      delta_x = vec2Norm(m, solverData->dy1);
+      theta = delta_x_old > 0 ? delta_x/delta_x_old : 0;
+      if (thetaFirst < 0 && delta_x_old > 0)
+        thetaFirst = theta;
+      if (theta > thetaMax)
+      {
+        if (lastRefresh == j-1)
+        {
+          debugDouble(LOG_NLS_HOMOTOPY, "corrector does not contract, theta = ", theta);
+          stepAccept = 0;
+          break;
+        }
+        /* calculate the jacobian at the current point and solve again */
+        assert = 1;
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+        solverData->hJac_dh(solverData, solverData->y1, solverData->Ax);
+        assert = 0;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+        if (assert || factorizeSparseHomotopy(solverData, pos) != 0)
+        {
+          stepAccept = 0;
+          break;
+        }
+        calcResidualScalingSparse(solverData, m);
+        lastRefresh = j;
+        vecAddInv(n, solverData->hvec, solverData->dy1);
+        solverData->dy1[n] = 0.0;
+        if (solveSparseHomotopy(solverData, solverData->dy1) != 0)
+        {
+          stepAccept = 0;
+          break;
+        }
+        delta_x = vec2Norm(m, solverData->dy1);
+      }
+      delta_x_old = delta_x;
+
+      /* Scaling back to original variables */
+      vecMultScaling(m, solverData->dy1, solverData->xScaling, solverData->dy1);
+
+      solverData->dy1[pos] = 0.0;
+      vecAdd(m, solverData->y1, solverData->dy1, solverData->y2);
+      vecCopy(m, solverData->y2, solverData->y1);
+      assert = 1;
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+      solverData->h_function(solverData, solverData->y1, solverData->hvec);
+      assert = 0;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+      if (assert)
+      {
+          stepAccept = 0;
+          break;
+      }
+      /* Calculate different error measurements */
+      vecDivScaling(n, solverData->hvec, solverData->resScaling, solverData->hvecScaled);
+
+      error_h        = vec2Norm(n, solverData->hvec);
+      error_h_scaled = vec2Norm(n, solverData->hvecScaled);
+      debugDouble(LOG_NLS_HOMOTOPY, "theta          =", theta);
+      debugDouble(LOG_NLS_HOMOTOPY, "error_h        =", error_h);
+      debugDouble(LOG_NLS_HOMOTOPY, "error_h_scaled =", error_h_scaled);
+    }
+    if (!assert)
+    {
+      vecDiff(m, solverData->y1, solverData->yt, solverData->dy1);
+      vecDiff(m, solverData->yt, solverData->y0, solverData->dy2);
+      printHomotopyCorrectorStep(LOG_NLS_HOMOTOPY, solverData);
+      bend = vec2Norm(m,solverData->dy1)/vec2Norm(m,solverData->dy2);
+    }
+
+    /* step size factor from the bend and the contraction of the corrector */
+    fac = 2.0;
+    if (bend > DBL_EPSILON)
+      fac = fmin(fac, sqrt(adaptBend/bend));
+    if (thetaFirst > DBL_EPSILON)
+      fac = fmin(fac, sqrt(thetaTarget/thetaFirst));
+
+    if ((bend > adaptBend) || !stepAccept)
+    {
+      if (bend<DBL_EPSILON)
+      {
+        /* debug information */
+        debugString(LOG_NLS_HOMOTOPY, "\nINCREMENT ZERO: Homotopy Algorithm did not converge\n");
+        debugString(LOG_NLS_HOMOTOPY, "======================================================");
+        return -1;
+      }
+      tau = fmax(tauMin, tau*(stepAccept ? fmax(0.1, fmin(0.5, fac)) : 0.25));
+      debugDouble(LOG_NLS_HOMOTOPY, "bend/adaptBend  =", bend/adaptBend);
+      debugDouble(LOG_NLS_HOMOTOPY, "--- decreasing step size tau =", tau);
+      iter++;
+    } else
+    {
+      initialStep = 0;
+      iter = 0;
+      numSteps++;
+      tau = fmin(tauMax, tau*fmax(0.5, fac));
+      debugDouble(LOG_NLS_HOMOTOPY, "step size factor =", fmax(0.5, fac));
+      debugDouble(LOG_NLS_HOMOTOPY, "new step size tau =", tau);
+      vecCopy(m, solverData->y1, solverData->y0);
+      vecCopy(m, solverData->dy0, solverData->dy2);
+      debugString(LOG_NLS_HOMOTOPY, "======================================================");
+      printHomotopyUnknowns(LOG_NLS_HOMOTOPY, solverData);
+    }
+  }
+  /* copy solution back to vector x */
+  vecCopy(n, solverData->y1, x);
+
+  debugString(LOG_NLS_HOMOTOPY, "HOMOTOPY ALGORITHM SUCCEEDED");
+  debugInt(LOG_NLS_HOMOTOPY, "number of steps: ", numSteps);
+  debugInt(LOG_NLS_HOMOTOPY, "number of factorizations: ", solverData->numberOfFactorizations-factorizationsOld);
+  debugString(LOG_NLS_HOMOTOPY, "======================================================");
+  solverData->info = 1;
+
+  return 0;
+}
+
 /*! \fn solve non-linear system with a damped Newton method combined with a homotopy approach
 
  *
@@ -1711,8 +2466,6 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
   int giveUp = 0;
   int alreadyTested = 0;
   int iflag = 1;
-  int pos;
-  int rank;
   int iter;
   int maxiter = 10;
   int tries = 0;
@@ -1726,7 +2479,7 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
   relationsPreBackup = (modelica_boolean*) malloc(data->modelData->nRelations*sizeof(modelica_boolean));
 
   solverData->f = wrapper_fvec;
-  solverData->fJac_f = wrapper_fvec_der;
+  solverData->fJac_f = solverData->useSparse ? wrapper_fvec_der_sparse : wrapper_fvec_der;
 
   solverData->data = data;
   solverData->threadData = threadData;
@@ -1813,18 +2566,17 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
         return success;
       }
     }
-    solverData->fJac_f(solverData, solverData->x0, solverData->fJac);
-    vecCopy(solverData->n, solverData->f1, solverData->fJac + solverData->n*solverData->n);
-    vecCopy(solverData->n*solverData->m, solverData->fJac, solverData->fJacx0);
+    calcNewtonJacobian(solverData, solverData->x0);
+    if (solverData->useSparse)
+      vecCopy(solverData->nnz, solverData->Ax, solverData->Ax0);
+    else
+      vecCopy(solverData->n*solverData->m, solverData->fJac, solverData->fJacx0);
     if (mixedSystem)
       memcpy(relationsPreBackup, data->simulationInfo->relations, sizeof(modelica_boolean)*data->modelData->nRelations);
     /* calculate scaling factor of residuals */
-    matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
-    debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", solverData->resScaling, solverData->n);
-    scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+    scaleNewtonJacobian(solverData);
 
-    pos = solverData->n;
-    assert = (solveSystemWithTotalPivotSearch(solverData->n, solverData->dy0, solverData->fJac, solverData->indRow, solverData->indCol, &pos, &rank) != 0);
+    assert = (solveNewtonStep(solverData, solverData->dy0) != 0);
     if (!assert)
       debugString(LOG_NLS_V, "regular initial point!!!");
     giveUp = 0;
@@ -1885,7 +2637,7 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
         break;
       }
 
-      if (solverData->info == -1){
+      if (solverData->info == -1 && solverData->dataHybrid){
         solverDataHybrid = (DATA_HYBRD*)(solverData->dataHybrid);
         systemData->solverData = solverDataHybrid;
 
@@ -1917,14 +2669,15 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
           alreadyTested = 1;
           vecCopy(solverData->n, solverData->x0, solverData->x);
           vecCopy(solverData->n, solverData->fx0, solverData->f1);
-          vecCopy(solverData->n*solverData->m, solverData->fJacx0, solverData->fJac);
+          if (solverData->useSparse)
+            vecCopy(solverData->nnz, solverData->Ax0, solverData->Ax);
+          else
+            vecCopy(solverData->n*solverData->m, solverData->fJacx0, solverData->fJac);
 
           /* calculate scaling factor of residuals */
-          matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
-          scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+          scaleNewtonJacobian(solverData);
 
-          pos = solverData->n;
-          solveSystemWithTotalPivotSearch(solverData->n, solverData->dy0, solverData->fJac,   solverData->indRow, solverData->indCol, &pos, &rank);
+          solveNewtonStep(solverData, solverData->dy0);
           debugDouble(LOG_NLS,"solve mixed system at time : ", solverData->timeValue);
           continue;
         }
@@ -1956,7 +2709,7 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
       /* store x0 and calculate f(x0) -> newton homotopy, fJac(x0) -> taylor, affin homotopy */
       solverData->homotopyMethod = 1;
       solverData->h_function = wrapper_fvec_homotopy_newton;
-      solverData->hJac_dh = wrapper_fvec_homotopy_newton_der;
+      solverData->hJac_dh = solverData->useSparse ? wrapper_fvec_homotopy_newton_der_sparse : wrapper_fvec_homotopy_newton_der;
       solverData->startDirection = 1.0;
       debugDouble(LOG_NLS_HOMOTOPY,"STARTING NEWTON HOMOTOPY METHOD; startDirection = ", solverData->startDirection);
     }
@@ -1965,7 +2718,7 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
       /* store x0 and calculate f(x0) -> newton homotopy, fJac(x0) -> taylor, affin homotopy */
       solverData->homotopyMethod = 1;
       solverData->h_function = wrapper_fvec_homotopy_newton;
-      solverData->hJac_dh = wrapper_fvec_homotopy_newton_der;
+      solverData->hJac_dh = solverData->useSparse ? wrapper_fvec_homotopy_newton_der_sparse : wrapper_fvec_homotopy_newton_der;
       solverData->startDirection = -1.0;
       debugDouble(LOG_NLS_HOMOTOPY,"STARTING NEWTON HOMOTOPY METHOD; startDirection = ", solverData->startDirection);
     }
@@ -1973,11 +2726,14 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
     {
       solverData->homotopyMethod = 2;
       solverData->h_function = wrapper_fvec_homotopy_fixpoint;
-      solverData->hJac_dh = wrapper_fvec_homotopy_fixpoint_der;
+      solverData->hJac_dh = solverData->useSparse ? wrapper_fvec_homotopy_fixpoint_der_sparse : wrapper_fvec_homotopy_fixpoint_der;
       solverData->startDirection = 1.0;
       debugDouble(LOG_NLS_HOMOTOPY,"STARTING FIXPOINT HOMOTOPY METHOD = ", solverData->startDirection);
     }
-    homotopyAlgorithm(solverData, solverData->x);
+    if (solverData->useSparse)
+      homotopyAlgorithmSparse(solverData, solverData->x);
+    else
+      homotopyAlgorithm(solverData, solverData->x);
     if (solverData->info<1)
     {
       skipNewton = 1;
@@ -1989,15 +2745,11 @@ int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber)
       MMC_TRY_INTERNAL(simulationJumpBuffer)
  #endif
       solverData->f(solverData, solverData->x, solverData->f1);
-      solverData->fJac_f(solverData, solverData->x, solverData->fJac);
-      vecCopy(solverData->n, solverData->f1, solverData->fJac + solverData->n*solverData->n);
+      calcNewtonJacobian(solverData, solverData->x);
       /* calculate scaling factor of residuals */
-      matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
-      debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", solverData->resScaling, solverData->n);
-      scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+      scaleNewtonJacobian(solverData);
 
-      pos = solverData->n;
-      assert = (solveSystemWithTotalPivotSearch(solverData->n, solverData->dy0, solverData->fJac,   solverData->indRow, solverData->indCol, &pos, &rank) != 0);
+      assert = (solveNewtonStep(solverData, solverData->dy0) != 0);
       if (!assert)
         debugString(LOG_NLS_V, "regular initial point!!!");
 #ifndef OMC_EMCC
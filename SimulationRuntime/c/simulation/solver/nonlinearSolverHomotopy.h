@@ -37,6 +37,7 @@
 #include "simulation_data.h"
 
 int allocateHomotopyData(int size, void** data);
+int allocateHomotopyDataSparse(int size, SPARSE_PATTERN* pattern, void** data);
 int freeHomotopyData(void** data);
 
 int solveHomotopy(DATA *data, threadData_t *threadData, int sysNumber);
@@ -203,6 +203,11 @@ static void printStatus(DATA *data, DATA_HYBRD *solverData, int eqSystemNumber,
  *  function calculates a jacobian matrix by
  *  numerical method finite differences
  *
+ *  The columns are not distributed with -jacobianThreads: the torn systems
+ *  are small and dense, one column costs a single residual evaluation which
+ *  is cheaper than a hand-over to another thread, and the solver already runs
+ *  inside a model evaluation that may be a worker of -jacobianThreads itself.
+ *
  *  \param [ref] [data]
  *  \param [out] [jac]
  *
@@ -121,6 +121,46 @@ int getAnalyticalJacobianNewton(DATA* data, threadData_t *threadData, double* ja
 }
 
 
+/*! \fn getAnalyticalJacobianNewtonSparse
+ *
+ *  function calculates analytical jacobian and stores it in the compressed
+ *  column format of the sparse newton solver
+ *
+ *  \param [ref] [data]
+ *  \param [out] [jac]
+ *
+ */
+static int getAnalyticalJacobianNewtonSparse(DATA* data, threadData_t *threadData, double* jac, int sysNumber)
+{
+  int i,j,ii;
+  NONLINEAR_SYSTEM_DATA* systemData = &(((DATA*)data)->simulationInfo->nonlinearSystemData[sysNumber]);
+  const int index = systemData->jacobianIndex;
+  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
+
+  for(i=0; i < jacobian->sparsePattern.maxColors; i++)
+  {
+    /* activate seed variable for the corresponding color */
+    for(ii=0; ii < jacobian->sizeCols; ii++)
+      if(jacobian->sparsePattern.colorCols[ii]-1 == i)
+        jacobian->seedVars[ii] = 1;
+
+    systemData->analyticalJacobianColumn(data, threadData);
+
+    for(j = 0; j < jacobian->sizeCols; j++)
+    {
+      if(jacobian->seedVars[j] == 1)
+      {
+        for(ii = (j==0) ? 0 : jacobian->sparsePattern.leadindex[j-1]; ii < jacobian->sparsePattern.leadindex[j]; ii++)
+          jac[ii] = jacobian->resultVars[jacobian->sparsePattern.index[ii]];
+        /* de-activate seed variable for the corresponding color */
+        jacobian->seedVars[j] = 0;
+      }
+    }
+  }
+
+  return 0;
+}
+
 /*! \fn wrapper_fvec_newton for the residual Function
  *   tensolve calls for the subroutine fcn(n, x, fvec, iflag, data)
  *
@@ -142,7 +182,9 @@ int wrapper_fvec_newton(int* n, double* x, double* fvec, void* userdata, int fj)
   if (fj) {
     (data->simulationInfo->nonlinearSystemData[currentSys].residualFunc)(dataAndThreadData, x, fvec, iflag);
   } else {
-    if(systemData->jacobianIndex != -1) {
+    if(solverData->useSparse) {
+      getAnalyticalJacobianNewtonSparse(data, uData->threadData, solverData->Ax, currentSys);
+    } else if(systemData->jacobianIndex != -1) {
       getAnalyticalJacobianNewton(data, uData->threadData, solverData->fjac, currentSys);
     } else {
       double delta_h = sqrt(solverData->epsfcn);
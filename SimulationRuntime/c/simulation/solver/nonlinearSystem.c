@@ -42,10 +42,12 @@
 #include "nonlinearSolverHybrd.h"
 #include "nonlinearSolverNewton.h"
 #include "newtonIteration.h"
+#include "model_help.h"
 #endif
 #include "nonlinearSolverHomotopy.h"
 #include "simulation/simulation_info_json.h"
 #include "simulation/simulation_runtime.h"
+#include "simulation/options.h"
 
 /* for try and catch simulationJumpBuffer */
 #include "meta/meta_modelica.h"
@@ -339,6 +341,9 @@ int initializeNonlinearSystems(DATA *data, threadData_t *threadData)
   TRACE_PUSH
   int i;
   int size;
+#if !defined(OMC_MINIMAL_RUNTIME) && defined(WITH_UMFPACK)
+  int nnz;
+#endif
   NONLINEAR_SYSTEM_DATA *nonlinsys = data->simulationInfo->nonlinearSystemData;
   struct dataNewtonAndHybrid *mixedSolverData;
 
@@ -363,6 +368,20 @@ int initializeNonlinearSystems(DATA *data, threadData_t *threadData)
       }
     }
 
+    /* check if the sparse newton solver should be used */
+    nonlinsys[i].useSparseSolver = 0;
+#if !defined(OMC_MINIMAL_RUNTIME) && defined(WITH_UMFPACK)
+    if(nonlinsys[i].jacobianIndex != -1)
+    {
+      nnz = data->simulationInfo->analyticJacobians[nonlinsys[i].jacobianIndex].sparsePattern.numberOfNoneZeros;
+      if(nnz/(double)(size*size)<=nonlinearSparseSolverMaxDensity && size>=nonlinearSparseSolverMinSize)
+      {
+        nonlinsys[i].useSparseSolver = 1;
+        infoStreamPrint(LOG_STDOUT, 0, "Using sparse solver for nonlinear system %d,\nbecause density of %.2f remains under threshold of %.2f and size of %d exceeds threshold of %d.\nThe maximum density and the minimal system size for using sparse solvers can be specified\nusing the runtime flags '<-nlssMaxDensity=value>' and '<-nlssMinSize=value>'.", i, nnz/(double)(size*size), nonlinearSparseSolverMaxDensity, size, nonlinearSparseSolverMinSize);
+      }
+    }
+#endif
+
     /* allocate system data */
     nonlinsys[i].nlsx = (double*) malloc(size*sizeof(double));
     nonlinsys[i].nlsxExtrapolation = (double*) malloc(size*sizeof(double));
@@ -371,6 +390,9 @@ int initializeNonlinearSystems(DATA *data, threadData_t *threadData)
 
     /* allocate value list*/
     nonlinsys[i].oldValueList = (void*) allocValueList(1);
+    if(omc_flag[FLAG_RT_PREALLOC]) {
+      reserveValueList((VALUES_LIST*)nonlinsys[i].oldValueList, size, NLS_HISTORY_LENGTH);
+    }
 
     nonlinsys[i].lastTimeSolved = 0.0;
 
@@ -396,6 +418,17 @@ int initializeNonlinearSystems(DATA *data, threadData_t *threadData)
     }
 #endif
     /* allocate solver data */
+#if !defined(OMC_MINIMAL_RUNTIME)
+    if(nonlinsys[i].useSparseSolver && data->simulationInfo->nlsMethod == NLS_HOMOTOPY)
+    {
+      allocateHomotopyDataSparse(size, &data->simulationInfo->analyticJacobians[nonlinsys[i].jacobianIndex].sparsePattern, &nonlinsys[i].solverData);
+    }
+    else if(nonlinsys[i].useSparseSolver && data->simulationInfo->nlsMethod != NLS_MIXED)
+    {
+      allocateNewtonDataSparse(size, &data->simulationInfo->analyticJacobians[nonlinsys[i].jacobianIndex].sparsePattern, &nonlinsys[i].solverData);
+    }
+    else
+#endif
     switch(data->simulationInfo->nlsMethod)
     {
 #if !defined(OMC_MINIMAL_RUNTIME)
@@ -415,9 +448,18 @@ int initializeNonlinearSystems(DATA *data, threadData_t *threadData)
 #if !defined(OMC_MINIMAL_RUNTIME)
     case NLS_MIXED:
       mixedSolverData = (struct dataNewtonAndHybrid*) malloc(sizeof(struct dataNewtonAndHybrid));
-      allocateHomotopyData(size, &(mixedSolverData->newtonData));
+      if(nonlinsys[i].useSparseSolver)
+      {
+        allocateHomotopyDataSparse(size, &data->simulationInfo->analyticJacobians[nonlinsys[i].jacobianIndex].sparsePattern, &(mixedSolverData->newtonData));
+        /* the dense fallback needs O(size^2) memory, it is allocated when it is needed first */
+        mixedSolverData->hybridData = NULL;
+      }
+      else
+      {
+        allocateHomotopyData(size, &(mixedSolverData->newtonData));
 
-      allocateHybrdData(size, &(mixedSolverData->hybridData));
+        allocateHybrdData(size, &(mixedSolverData->hybridData));
+      }
 
       nonlinsys[i].solverData = (void*) mixedSolverData;
 
@@ -496,6 +538,17 @@ int freeNonlinearSystems(DATA *data, threadData_t *threadData)
     }
 #endif
     /* free solver data */
+#if !defined(OMC_MINIMAL_RUNTIME)
+    if(nonlinsys[i].useSparseSolver && data->simulationInfo->nlsMethod == NLS_HOMOTOPY)
+    {
+      freeHomotopyData(&nonlinsys[i].solverData);
+    }
+    else if(nonlinsys[i].useSparseSolver && data->simulationInfo->nlsMethod != NLS_MIXED)
+    {
+      freeNewtonData(&nonlinsys[i].solverData);
+    }
+    else
+#endif
     switch(data->simulationInfo->nlsMethod)
     {
 #if !defined(OMC_MINIMAL_RUNTIME)
@@ -515,7 +568,8 @@ int freeNonlinearSystems(DATA *data, threadData_t *threadData)
 #if !defined(OMC_MINIMAL_RUNTIME)
     case NLS_MIXED:
       freeHomotopyData(&((struct dataNewtonAndHybrid*) nonlinsys[i].solverData)->newtonData);
-      freeHybrdData(&((struct dataNewtonAndHybrid*) nonlinsys[i].solverData)->hybridData);
+      if(((struct dataNewtonAndHybrid*) nonlinsys[i].solverData)->hybridData)
+        freeHybrdData(&((struct dataNewtonAndHybrid*) nonlinsys[i].solverData)->hybridData);
       break;
 #endif
     default:
@@ -594,8 +648,7 @@ int updateInitialGuessDB(NONLINEAR_SYSTEM_DATA *nonlinsys, double time, int cont
     /* do not use solution of jacobian for next extrapolation */
     if (context < 4)
     {
-      addListElement((VALUES_LIST*)nonlinsys->oldValueList,
-              createValueElement(nonlinsys->size, time, nonlinsys->nlsx));
+      addListValues((VALUES_LIST*)nonlinsys->oldValueList, nonlinsys->size, time, nonlinsys->nlsx);
     }
   }
   else if (nonlinsys->solved == 2)
@@ -607,8 +660,7 @@ int updateInitialGuessDB(NONLINEAR_SYSTEM_DATA *nonlinsys, double time, int cont
     /* do not use solution of jacobian for next extrapolation */
     if (context < 4)
     {
-      addListElement((VALUES_LIST*)nonlinsys->oldValueList,
-              createValueElement(nonlinsys->size, time, nonlinsys->nlsx));
+      addListValues((VALUES_LIST*)nonlinsys->oldValueList, nonlinsys->size, time, nonlinsys->nlsx);
     }
   }
   messageClose(LOG_NLS_EXTRAPOLATE);
@@ -719,6 +771,23 @@ int solve_nonlinear_system(DATA *data, threadData_t *threadData, int sysNumber)
   threadData->currentErrorStage = ERROR_NONLINEARSOLVER;
 
   /* use the selected solver for solving nonlinear system */
+#if !defined(OMC_MINIMAL_RUNTIME)
+  if(nonlinsys->useSparseSolver && data->simulationInfo->nlsMethod != NLS_MIXED)
+  {
+    /* the homotopy solver has a sparse variant, the mixed strategy is handled below */
+    if(data->simulationInfo->nlsMethod == NLS_HOMOTOPY)
+      success = solveHomotopy(data, threadData, sysNumber);
+    else
+      success = solveNewton(data, threadData, sysNumber);
+    /* check if solution process was successful, if not use alternative tearing set if available (dynamic tearing)*/
+    if (!success && nonlinsys->strictTearingFunctionCall != NULL){
+      debugString(LOG_DT, "Solving the casual tearing set failed! Now the strict tearing set is used.");
+      success = nonlinsys->strictTearingFunctionCall(data, threadData);
+      if (success) success=2;
+    }
+  }
+  else
+#endif
   switch(data->simulationInfo->nlsMethod)
   {
 #if !defined(OMC_MINIMAL_RUNTIME)
@@ -760,6 +829,8 @@ int solve_nonlinear_system(DATA *data, threadData_t *threadData, int sysNumber)
     }
 
     if (!success) {
+      if (NULL == mixedSolverData->hybridData)
+        allocateHybrdData(nonlinsys->size, &(mixedSolverData->hybridData));
       nonlinsys->solverData = mixedSolverData->hybridData;
       success = solveHybrd(data, threadData, sysNumber);
     }
@@ -48,6 +48,7 @@
 
 /* Forward extrapolate function definition */
 double extrapolateValues(const double, const double, const double, const double, const double);
+static void insertListElement(VALUES_LIST* valuesList, VALUE* newElem);
 
 VALUES_LIST* allocValueList(unsigned int numberOfList)
 {
@@ -56,25 +57,66 @@ VALUES_LIST* allocValueList(unsigned int numberOfList)
 
   for(i=0; i<numberOfList; ++i){
     (valueList+i)->valueList = allocList(sizeof(VALUE));
+    (valueList+i)->freeValues = NULL;
+    (valueList+i)->nFreeValues = 0;
+    (valueList+i)->maxLength = 0;
   }
 
   return valueList;
 }
 
+/*! \fn reserveValueList
+ *
+ *  Preallocates the nodes and value arrays for maxLength elements. Afterwards
+ *  the list never grows beyond maxLength elements, the oldest element is
+ *  reused instead, and adding elements does not allocate memory.
+ *
+ *  \param [ref] [valueList]
+ *  \param [in]  [size] size of the value arrays
+ *  \param [in]  [maxLength]
+ */
+void reserveValueList(VALUES_LIST *valueList, unsigned int size, unsigned int maxLength)
+{
+  valueList->maxLength = maxLength;
+  listReserve(valueList->valueList, maxLength + 1);
+
+  valueList->freeValues = (double**) malloc(maxLength*sizeof(double*));
+  for(valueList->nFreeValues = 0; valueList->nFreeValues < maxLength; ++valueList->nFreeValues) {
+    valueList->freeValues[valueList->nFreeValues] = (double*) malloc(size*sizeof(double));
+  }
+}
+
+/* returns the value array of an element which is removed from the list */
+static void releaseValues(VALUES_LIST *valueList, VALUE *elem)
+{
+  if (valueList->nFreeValues < valueList->maxLength) {
+    valueList->freeValues[valueList->nFreeValues++] = elem->values;
+  } else {
+    free(elem->values);
+  }
+  elem->values = NULL;
+}
+
+static void releaseValuesFrom(VALUES_LIST *valueList, LIST_NODE *node)
+{
+  for(; node; node = listNextNode(node)) {
+    releaseValues(valueList, (VALUE*)listNodeData(node));
+  }
+}
+
 void freeValueList(VALUES_LIST *valueList, unsigned int numberOfList)
 {
-  VALUE* elem;
   VALUES_LIST *tmpList;
 
   int i,j;
   for(j = 0; j < numberOfList; ++j)
   {
     tmpList = valueList+j;
-    for(i = 0; i < listLen(tmpList->valueList); ++i)
-    {
-      elem = (VALUE*) listFirstData(tmpList->valueList);
-      listPopFront(tmpList->valueList);
+    cleanValueList(tmpList, NULL);
+    for(i = 0; i < tmpList->nFreeValues; ++i) {
+      free(tmpList->freeValues[i]);
     }
+    free(tmpList->freeValues);
     freeList(tmpList->valueList);
   }
   free(valueList);
@@ -82,12 +124,13 @@ void freeValueList(VALUES_LIST *valueList, unsigned int numberOfList)
 
 void cleanValueList(VALUES_LIST *valueList, LIST_NODE *startNode)
 {
-  LIST_NODE *next, *node;
-  VALUE* elem;
+  LIST_NODE *next;
 
-  int i, j;
   if (startNode == NULL)
   {
+    if (listLen(valueList->valueList) > 0) {
+      releaseValuesFrom(valueList, listFirstNode(valueList->valueList));
+    }
     listClear(valueList->valueList);
   }
   else
@@ -95,6 +138,7 @@ void cleanValueList(VALUES_LIST *valueList, LIST_NODE *startNode)
     next = listNextNode(startNode);
     /* clean list from next node */
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "cleanValueList length: %d", listLen(valueList->valueList));
+    releaseValuesFrom(valueList, next);
     updateNodeNext(valueList->valueList, startNode, NULL);
     removeNodes(valueList->valueList, next);
   }
@@ -129,7 +173,8 @@ void cleanValueListbyTime(VALUES_LIST *valueList, double time)
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "cleanValueListbyTime %g check element: ", time);
     printValueElement(elem);
 
-    freeNode(node);
+    releaseValues(valueList, elem);
+    listReleaseNode(valueList->valueList, node);
     updatelistFirst(valueList->valueList, next);
     updatelistLength(valueList->valueList, listLen(valueList->valueList)-1);
     node = next;
@@ -162,7 +207,46 @@ void freeValue(VALUE* elem)
   free(elem);
 }
 
+/*! \fn addListValues
+ *
+ *  Adds a copy of the values at the given time. If the list is reserved, the
+ *  copy is stored in a preallocated value array.
+ */
+void addListValues(VALUES_LIST* valuesList, unsigned int size, double time, double* values)
+{
+  VALUE elem;
+
+  if (valuesList->maxLength == 0)
+  {
+    addListElement(valuesList, createValueElement(size, time, values));
+    return;
+  }
+
+  /* reuse the oldest element if the list is full */
+  if (listLen(valuesList->valueList) >= valuesList->maxLength)
+  {
+    LIST_NODE *node = listFirstNode(valuesList->valueList);
+    while (listNextNode(listNextNode(node))) {
+      node = listNextNode(node);
+    }
+    cleanValueList(valuesList, node);
+  }
+
+  elem.time = time;
+  elem.size = size;
+  elem.values = valuesList->freeValues[--valuesList->nFreeValues];
+  memcpy(elem.values, values, size*sizeof(double));
+  insertListElement(valuesList, &elem);
+}
+
 void addListElement(VALUES_LIST* valuesList, VALUE* newElem)
+{
+  /* the list takes over the value array */
+  insertListElement(valuesList, newElem);
+  free(newElem);
+}
+
+static void insertListElement(VALUES_LIST* valuesList, VALUE* newElem)
 {
   LIST_NODE *node, *next;
   VALUE* elem;
@@ -237,6 +321,7 @@ void addListElement(VALUES_LIST* valuesList, VALUE* newElem)
   else
   {
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "replace element.");
+    releaseValues(valuesList, (VALUE*)listNodeData(next));
     updateNodeData(valuesList->valueList, next, (void*) newElem);
   }
   /*  clean list if too full */
@@ -39,9 +39,17 @@
 
 #include "util/list.h"
 
+/* number of solutions kept by a reserved list for the extrapolation */
+#define NLS_HISTORY_LENGTH 12
+
 typedef struct VALUES_LIST
 {
   LIST* valueList;
+
+  /* preallocated value arrays, see reserveValueList */
+  double **freeValues;
+  unsigned int nFreeValues;
+  unsigned int maxLength;   /* maximum number of elements, 0 if not reserved */
 } VALUES_LIST;
 
 typedef struct VALUE
@@ -54,14 +62,15 @@ typedef struct VALUE
 
 VALUES_LIST *allocValueList(const unsigned int numberOfLists);
 void freeValueList(VALUES_LIST *valueList, unsigned int numberOfLists);
+void reserveValueList(VALUES_LIST *valueList, unsigned int size, unsigned int maxLength);
 
 VALUE* createValueElement(unsigned int size, double time, double* values);
 void freeValue(VALUE* elem);
 void cleanValueList(VALUES_LIST *valueListm, LIST_NODE* next);
 void cleanValueListbyTime(VALUES_LIST *valueList, double time);
-void removeNodes(LIST* list, LIST_NODE *node);
 
 void addListElement(VALUES_LIST* valueList, VALUE* elem);
+void addListValues(VALUES_LIST* valueList, unsigned int size, double time, double* values);
 void getValues(VALUES_LIST* valueList, double time, double* values, double* oldOutput);
 
 void printValueElement(VALUE* elem);
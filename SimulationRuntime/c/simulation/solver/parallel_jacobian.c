@@ -0,0 +1,511 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file parallel_jacobian.c
+ *
+ *  The workers are created once per integrator and sleep on a condition
+ *  variable between the Jacobian evaluations. For every color a worker first
+ *  copies the current state of the integrator thread into its own model data,
+ *  so the result of a column does not depend on which worker evaluated it or
+ *  in which order the colors were handed out.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <math.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "gc/omc_gc.h"
+
+#include "simulation/options.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/nonlinearValuesList.h"
+#include "simulation/solver/parallel_jacobian.h"
+#include "meta/meta_modelica.h"
+
+/*! \fn getJacobianThreads
+ *
+ *  Returns the number of threads selected with -jacobianThreads. Profiling
+ *  uses global timers that cannot be shared, then always 1 is returned.
+ *  External objects are opaque handles of the model (files, tables, foreign
+ *  libraries) that can neither be copied nor used from several threads,
+ *  models with external objects are evaluated serially as well.
+ */
+int getJacobianThreads(DATA* data)
+{
+  int nThreads = 1;
+
+  if (omc_flag[FLAG_JACOBIAN_THREADS])
+  {
+    nThreads = atoi(omc_flagValue[FLAG_JACOBIAN_THREADS]);
+    if (nThreads < 1)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "invalid value %s for -jacobianThreads, using 1", omc_flagValue[FLAG_JACOBIAN_THREADS]);
+      nThreads = 1;
+    }
+  }
+  if (nThreads > 1 && measure_time_flag)
+  {
+    warningStreamPrint(LOG_STDOUT, 0, "-jacobianThreads is ignored if profiling is enabled");
+    nThreads = 1;
+  }
+  if (nThreads > 1 && data->modelData->nExtObjs > 0)
+  {
+    warningStreamPrint(LOG_STDOUT, 0, "-jacobianThreads is ignored for models with external objects");
+    nThreads = 1;
+  }
+  return nThreads;
+}
+
+/*! \fn initializeJacobianWorker
+ *
+ *  Creates the model data of one worker the same way -ensemble does it:
+ *  static variable information is shared, everything that is written during
+ *  an evaluation is allocated per worker.
+ */
+static void initializeJacobianWorker(JACOBIAN_WORKER *worker, DATA* data, threadData_t *threadData)
+{
+  MODEL_DATA *baseModelData = data->modelData;
+
+  worker->data = *data;
+  worker->modelData = *baseModelData;
+  worker->simulationInfo = *data->simulationInfo;
+  worker->data.modelData = &worker->modelData;
+  worker->data.simulationInfo = &worker->simulationInfo;
+  initializeDataStruc(&worker->data, threadData);
+
+#define JACOBIAN_COPY_VARS(n,vars) memcpy(worker->modelData.vars, baseModelData->vars, worker->modelData.n*sizeof(*worker->modelData.vars));
+  JACOBIAN_COPY_VARS(nVariablesReal,realVarsData)
+  JACOBIAN_COPY_VARS(nVariablesInteger,integerVarsData)
+  JACOBIAN_COPY_VARS(nVariablesBoolean,booleanVarsData)
+  JACOBIAN_COPY_VARS(nVariablesString,stringVarsData)
+  JACOBIAN_COPY_VARS(nParametersReal,realParameterData)
+  JACOBIAN_COPY_VARS(nParametersInteger,integerParameterData)
+  JACOBIAN_COPY_VARS(nParametersBoolean,booleanParameterData)
+  JACOBIAN_COPY_VARS(nParametersString,stringParameterData)
+  JACOBIAN_COPY_VARS(nAliasReal,realAlias)
+  JACOBIAN_COPY_VARS(nAliasInteger,integerAlias)
+  JACOBIAN_COPY_VARS(nAliasBoolean,booleanAlias)
+  JACOBIAN_COPY_VARS(nAliasString,stringAlias)
+  JACOBIAN_COPY_VARS(nSamples,samplesInfo)
+  JACOBIAN_COPY_VARS(nClocks,clocksInfo)
+  JACOBIAN_COPY_VARS(nSubClocks,subClocksInfo)
+#undef JACOBIAN_COPY_VARS
+  worker->modelData.modelDataXml = baseModelData->modelDataXml;
+  worker->modelData.sharedVarInfo = 1;
+
+  worker->simulationInfo.nlsMethod = data->simulationInfo->nlsMethod;
+  worker->simulationInfo.lsMethod = data->simulationInfo->lsMethod;
+  worker->simulationInfo.lssMethod = data->simulationInfo->lssMethod;
+  worker->simulationInfo.mixedMethod = data->simulationInfo->mixedMethod;
+  worker->simulationInfo.newtonStrategy = data->simulationInfo->newtonStrategy;
+  worker->simulationInfo.nlsCsvInfomation = 0;
+  worker->simulationInfo.external_input.active = 0;
+
+  initializeMixedSystems(&worker->data, threadData);
+  initializeLinearSystems(&worker->data, threadData);
+  initializeNonlinearSystems(&worker->data, threadData);
+  initializeTermination(&worker->simulationInfo, &worker->threadData);
+}
+
+static void freeJacobianWorker(JACOBIAN_WORKER *worker)
+{
+  threadData_t *threadData = &worker->threadData;
+
+  freeMixedSystems(&worker->data, threadData);
+  freeLinearSystems(&worker->data, threadData);
+  freeNonlinearSystems(&worker->data, threadData);
+  freeTermination(&worker->simulationInfo, threadData);
+  deInitializeDataStruc(&worker->data);
+}
+
+/*! \fn copyDelayBuffer
+ *
+ *  A ring buffer can not be emptied, the length of dst is matched first and
+ *  then the entries are overwritten. The delay buffers of the integrator are
+ *  only empty before the first value is stored, dst is empty then as well.
+ */
+static void copyDelayBuffer(RINGBUFFER *dst, RINGBUFFER *src)
+{
+  int length = ringBufferLength(src), k;
+
+  if (length == 0)
+  {
+    return;
+  }
+  if (ringBufferLength(dst) > length)
+  {
+    dequeueNFirstRingDatas(dst, ringBufferLength(dst) - length);
+  }
+  while (ringBufferLength(dst) < length)
+  {
+    appendRingData(dst, getRingData(src, ringBufferLength(dst)));
+  }
+  for (k = 0; k < length; ++k)
+  {
+    memcpy(getRingData(dst, k), getRingData(src, k), sizeof(TIME_AND_VALUE));
+  }
+}
+
+/*! \fn syncParameters
+ *
+ *  Parameters only change at initialization and the delay buffers only
+ *  between steps, copying them once per job is enough.
+ */
+static void syncParameters(DATA* data, DATA* base)
+{
+  MODEL_DATA *mData = base->modelData;
+  SIMULATION_INFO *src = base->simulationInfo, *dst = data->simulationInfo;
+  long i;
+
+  memcpy(dst->realParameter, src->realParameter, mData->nParametersReal*sizeof(modelica_real));
+  memcpy(dst->integerParameter, src->integerParameter, mData->nParametersInteger*sizeof(modelica_integer));
+  memcpy(dst->booleanParameter, src->booleanParameter, mData->nParametersBoolean*sizeof(modelica_boolean));
+  memcpy(dst->stringParameter, src->stringParameter, mData->nParametersString*sizeof(modelica_string));
+
+  for (i = 0; i < mData->nDelayExpressions; ++i)
+  {
+    copyDelayBuffer(dst->delayStructure[i], src->delayStructure[i]);
+  }
+}
+
+/*! \fn syncVariables
+ *
+ *  Copies everything an evaluation of the model reads from the integrator
+ *  thread into the worker data.
+ */
+static void syncVariables(DATA* data, DATA* base, unsigned int color)
+{
+  MODEL_DATA *mData = base->modelData;
+  SIMULATION_INFO *src = base->simulationInfo, *dst = data->simulationInfo;
+  SIMULATION_DATA *sData = base->localData[0], *wData = data->localData[0];
+  long i;
+
+  wData->timeValue = sData->timeValue;
+  memcpy(wData->realVars, sData->realVars, mData->nVariablesReal*sizeof(modelica_real));
+  memcpy(wData->integerVars, sData->integerVars, mData->nVariablesInteger*sizeof(modelica_integer));
+  memcpy(wData->booleanVars, sData->booleanVars, mData->nVariablesBoolean*sizeof(modelica_boolean));
+  memcpy(wData->stringVars, sData->stringVars, mData->nVariablesString*sizeof(modelica_string));
+
+  memcpy(dst->realVarsPre, src->realVarsPre, mData->nVariablesReal*sizeof(modelica_real));
+  memcpy(dst->integerVarsPre, src->integerVarsPre, mData->nVariablesInteger*sizeof(modelica_integer));
+  memcpy(dst->booleanVarsPre, src->booleanVarsPre, mData->nVariablesBoolean*sizeof(modelica_boolean));
+  memcpy(dst->stringVarsPre, src->stringVarsPre, mData->nVariablesString*sizeof(modelica_string));
+
+  memcpy(dst->relations, src->relations, mData->nRelations*sizeof(modelica_boolean));
+  memcpy(dst->relationsPre, src->relationsPre, mData->nRelations*sizeof(modelica_boolean));
+  memcpy(dst->storedRelations, src->storedRelations, mData->nRelations*sizeof(modelica_boolean));
+  memcpy(dst->mathEventsValuePre, src->mathEventsValuePre, mData->nMathEvents*sizeof(modelica_real));
+  memcpy(dst->samples, src->samples, mData->nSamples*sizeof(modelica_boolean));
+  memcpy(dst->inputVars, src->inputVars, mData->nInputVars*sizeof(modelica_real));
+
+  /* start values of the algebraic loops, see prepareStartValues */
+  for (i = 0; i < mData->nNonLinearSystems; ++i)
+  {
+    NONLINEAR_SYSTEM_DATA *nls = &src->nonlinearSystemData[i];
+    NONLINEAR_SYSTEM_DATA *wNls = &dst->nonlinearSystemData[i];
+    memcpy(wNls->nlsxOld, nls->nlsxOld, nls->size*sizeof(modelica_real));
+    memcpy(wNls->nlsxExtrapolation, nls->nlsxExtrapolation, nls->size*sizeof(modelica_real));
+    wNls->lastTimeSolved = nls->lastTimeSolved;
+    if (listLen(((VALUES_LIST*)wNls->oldValueList)->valueList) > 0)
+    {
+      cleanValueList((VALUES_LIST*)wNls->oldValueList, NULL);
+    }
+  }
+
+  dst->discreteCall = src->discreteCall;
+  dst->solveContinuous = src->solveContinuous;
+  dst->noThrowDivZero = src->noThrowDivZero;
+  dst->initial = src->initial;
+  dst->lambda = src->lambda;
+  dst->stepSize = src->stepSize;
+  dst->currentContext = src->currentContext;
+  dst->currentContextOld = src->currentContextOld;
+  dst->currentJacobianEval = color;
+  dst->tolZC = src->tolZC;
+}
+
+static int evalJacobianColor(PARALLEL_JACOBIAN *pool, JACOBIAN_WORKER *worker, unsigned int color)
+{
+  threadData_t *threadData = &worker->threadData;
+  int success = 0;
+
+  syncVariables(&worker->data, pool->data, color);
+  threadData->currentErrorStage = pool->errorStage;
+
+  MMC_TRY_INTERNAL(globalJumpBuffer)
+#if !defined(OMC_EMCC)
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+    pool->func(&worker->data, threadData, worker->id, color, pool->userData);
+    success = 1;
+#if !defined(OMC_EMCC)
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  MMC_CATCH_INTERNAL(globalJumpBuffer)
+
+  return success;
+}
+
+static void* jacobianWorkerThread(void *arg)
+{
+  JACOBIAN_WORKER *worker = (JACOBIAN_WORKER*) arg;
+  PARALLEL_JACOBIAN *pool = worker->pool;
+  unsigned long generation = 0;
+  unsigned int color;
+
+  pthread_setspecific(mmc_thread_data_key, &worker->threadData);
+  omc_alloc_interface.init();
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;)
+  {
+    while (!pool->shutdown && pool->generation == generation)
+    {
+      pthread_cond_wait(&pool->work, &pool->mutex);
+    }
+    if (pool->shutdown)
+    {
+      break;
+    }
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+    syncParameters(&worker->data, pool->data);
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->nextColor < pool->nColors && !pool->failed)
+    {
+      color = pool->nextColor++;
+      if (color == pool->nColors - 1)
+      {
+        pool->lastColorWorker = worker->id;
+      }
+      pthread_mutex_unlock(&pool->mutex);
+      if (!evalJacobianColor(pool, worker, color))
+      {
+        pthread_mutex_lock(&pool->mutex);
+        if (!pool->failed || color < pool->failedColor)
+        {
+          pool->failedColor = color;
+        }
+        pool->failed = 1;
+      }
+      else
+      {
+        pthread_mutex_lock(&pool->mutex);
+      }
+    }
+
+    if (--pool->busy == 0)
+    {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+/*! \fn allocateParallelJacobian
+ *
+ *  Has to be called after the initialization of the model, the workers copy
+ *  the static variable information of data.
+ */
+PARALLEL_JACOBIAN* allocateParallelJacobian(DATA* data, threadData_t *threadData, int nThreads)
+{
+  PARALLEL_JACOBIAN *pool = (PARALLEL_JACOBIAN*) calloc(1, sizeof(PARALLEL_JACOBIAN));
+  int i;
+
+  assertStreamPrint(threadData, 0 != pool, "out of memory");
+  pool->workers = (JACOBIAN_WORKER*) calloc(nThreads, sizeof(JACOBIAN_WORKER));
+  assertStreamPrint(threadData, 0 != pool->workers, "out of memory");
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (i = 0; i < nThreads; ++i)
+  {
+    JACOBIAN_WORKER *worker = &pool->workers[i];
+    worker->id = i;
+    worker->pool = pool;
+    initializeJacobianWorker(worker, data, threadData);
+    if (GC_pthread_create(&worker->thread, NULL, jacobianWorkerThread, worker))
+    {
+      freeJacobianWorker(worker);
+      break;
+    }
+    pool->nThreads++;
+  }
+
+  if (pool->nThreads == 0)
+  {
+    freeParallelJacobian(pool);
+    throwStreamPrint(threadData, "Failed to create threads for the Jacobian evaluation");
+  }
+  infoStreamPrint(LOG_SOLVER, 0, "evaluating colored Jacobians on %d threads", pool->nThreads);
+
+  return pool;
+}
+
+void freeParallelJacobian(PARALLEL_JACOBIAN *pool)
+{
+  int i;
+
+  if (!pool)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (i = 0; i < pool->nThreads; ++i)
+  {
+    GC_pthread_join(pool->workers[i].thread, NULL);
+    freeJacobianWorker(&pool->workers[i]);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool->workers);
+  free(pool);
+}
+
+/*! \fn prepareStartValues
+ *
+ *  Done on the integrator thread before a job. The serial evaluation takes
+ *  the start values of every algebraic loop from the extrapolation of the
+ *  solutions of the last steps (getInitialGuess). Solutions found for the
+ *  Jacobian are not added to that list, so all colors start from the same
+ *  values. They are computed here once and copied into nlsxOld and
+ *  nlsxExtrapolation like getInitialGuess does, the workers start from them
+ *  with an empty list.
+ */
+static void prepareStartValues(DATA* data)
+{
+  double time = data->localData[0]->timeValue;
+  long i;
+
+  for (i = 0; i < data->modelData->nNonLinearSystems; ++i)
+  {
+    NONLINEAR_SYSTEM_DATA *nls = &data->simulationInfo->nonlinearSystemData[i];
+    VALUES_LIST *valueList = (VALUES_LIST*) nls->oldValueList;
+    if (fabs(time - nls->lastTimeSolved) < 5*data->simulationInfo->stepSize && listLen(valueList->valueList) > 0)
+    {
+      getValues(valueList, time, nls->nlsxExtrapolation, nls->nlsxOld);
+    }
+  }
+}
+
+/*! \fn evalParallelJacobianColors
+ *
+ *  Evaluates the colors 0..nColors-1 with func on the workers and blocks
+ *  until all of them are done. data is not modified by the workers.
+ */
+void evalParallelJacobianColors(PARALLEL_JACOBIAN *pool, DATA* data, threadData_t *threadData, unsigned int nColors, jacobianColorFunction func, void *userData)
+{
+  long i, j;
+
+  prepareStartValues(data);
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->data = data;
+  pool->func = func;
+  pool->userData = userData;
+  pool->nColors = nColors;
+  pool->nextColor = 0;
+  pool->errorStage = threadData->currentErrorStage;
+  pool->failed = 0;
+  pool->lastColorWorker = -1;
+  pool->busy = pool->nThreads;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->work);
+  while (pool->busy > 0)
+  {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (i = 0; i < pool->nThreads; ++i)
+  {
+    SIMULATION_INFO *simInfo = &pool->workers[i].simulationInfo;
+    CALL_STATISTICS *stats = &simInfo->callStatistics;
+    data->simulationInfo->callStatistics.functionODE += stats->functionODE;
+    data->simulationInfo->callStatistics.functionEvalDAE += stats->functionEvalDAE;
+    stats->functionODE = 0;
+    stats->functionEvalDAE = 0;
+
+    /* terminate() during the evaluation stops the run like in the serial case */
+    if (simInfo->terminationTerminate && !data->simulationInfo->terminationTerminate)
+    {
+      char *msg = data->simulationInfo->terminationMessage;
+      size_t size = data->simulationInfo->terminationMessageSize;
+      data->simulationInfo->terminationTerminate = 1;
+      data->simulationInfo->terminationInfo = simInfo->terminationInfo;
+      data->simulationInfo->terminationMessage = simInfo->terminationMessage;
+      data->simulationInfo->terminationMessageSize = simInfo->terminationMessageSize;
+      simInfo->terminationMessage = msg;
+      simInfo->terminationMessageSize = size;
+    }
+    simInfo->terminationTerminate = 0;
+  }
+  /* the serial evaluation leaves the last color's success behind */
+  if (pool->lastColorWorker >= 0)
+  {
+    SIMULATION_INFO *simInfo = &pool->workers[pool->lastColorWorker].simulationInfo;
+    for (j = 0; j < data->modelData->nNonLinearSystems; ++j)
+    {
+      data->simulationInfo->nonlinearSystemData[j].lastTimeSolved = simInfo->nonlinearSystemData[j].lastTimeSolved;
+    }
+  }
+  if (data->simulationInfo->currentContext == CONTEXT_JACOBIAN)
+  {
+    data->simulationInfo->currentJacobianEval += nColors;
+  }
+
+  if (pool->failed)
+  {
+    throwStreamPrint(threadData, "Error, can not evaluate color %u of the Jacobian", pool->failedColor + 1);
+  }
+}
@@ -0,0 +1,106 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file parallel_jacobian.h
+ *
+ *  Persistent pool of worker threads evaluating the color groups of a
+ *  colored numerical Jacobian. Every worker owns a copy of the mutable model
+ *  data (ring buffer, pre values, relations, delay buffers, algebraic loops)
+ *  and its own threadData_t; the read-only model information is shared with
+ *  the integrator thread. The result is bitwise identical to the serial
+ *  evaluation.
+ */
+
+#ifndef _PARALLEL_JACOBIAN_H_
+#define _PARALLEL_JACOBIAN_H_
+
+#include <pthread.h>
+
+#include "simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \fn jacobianColorFunction
+ *
+ *  Evaluates all columns of one color using the worker copy data. Columns of
+ *  one color are disjoint, so the function may store them directly into the
+ *  shared Jacobian. Buffers that are written have to be taken per worker.
+ */
+typedef void (*jacobianColorFunction)(DATA* data, threadData_t *threadData, int worker, unsigned int color, void *userData);
+
+struct PARALLEL_JACOBIAN;
+
+typedef struct JACOBIAN_WORKER
+{
+  int id;
+  struct PARALLEL_JACOBIAN *pool;
+  pthread_t thread;
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  threadData_t threadData;
+} JACOBIAN_WORKER;
+
+typedef struct PARALLEL_JACOBIAN
+{
+  int nThreads;
+  JACOBIAN_WORKER *workers;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t work;            /* signals a new job or shutdown to the workers */
+  pthread_cond_t done;            /* signals the end of a job to the integrator thread */
+  unsigned long generation;       /* number of the current job */
+  int busy;                       /* workers still working on the current job */
+  int shutdown;
+
+  /* current job */
+  DATA *data;
+  jacobianColorFunction func;
+  void *userData;
+  unsigned int nColors;
+  unsigned int nextColor;
+  int errorStage;
+  int failed;
+  unsigned int failedColor;
+  int lastColorWorker;            /* worker that evaluated the last color */
+} PARALLEL_JACOBIAN;
+
+int getJacobianThreads(DATA* data);
+PARALLEL_JACOBIAN* allocateParallelJacobian(DATA* data, threadData_t *threadData, int nThreads);
+void freeParallelJacobian(PARALLEL_JACOBIAN *pool);
+void evalParallelJacobianColors(PARALLEL_JACOBIAN *pool, DATA* data, threadData_t *threadData, unsigned int nColors, jacobianColorFunction func, void *userData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PARALLEL_JACOBIAN_H_ */
@@ -29,6 +29,7 @@
  */
 
 #include <stdio.h>
+#include <float.h>
 #include "solver_main.h"
 
 #include "simulation/simulation_runtime.h"
@@ -37,6 +38,7 @@
 
 #include "util/omc_error.h"
 #include "simulation/options.h"
+#include "simulation/solver/external_input.h"
 
 
 /*! enum error_msg
@@ -50,16 +52,63 @@ enum error_msg
   OK = 0L           /*!< Everything is fine. */
 };
 
-const modelica_real EPS = 1e-15;
-
-/* Needed if we want to write all the variables into a file*/
-/* #define D */
-
-static modelica_integer deltaQ( DATA* data,const modelica_real dQ, const modelica_integer index, modelica_real* dTnextQ, modelica_real* nextQ, modelica_real* diffQ);
-static modelica_integer getDerWithStateK(const unsigned int *index, const unsigned int* leadindex, modelica_integer* der, uinteger* numDer, const uinteger k);
-static modelica_integer getStatesInDer(const unsigned int* index, const unsigned int* leadindex, const uinteger ROWS, const uinteger STATES, uinteger** StatesInDer);
-static modelica_integer qss_step(DATA* data, SOLVER_INFO* solverInfo);
-static uinteger minStep( const modelica_real* tqp, const uinteger size );
+/*! struct QSS_DATA
+ * \brief  State of the QSS integration.
+ *
+ *  Every state i has a polynomial trajectory x_i of degree order, anchored
+ *  at tx[i], and a quantized trajectory q_i of degree order-1, anchored at
+ *  tq[i]. The derivatives are evaluated as f(t,q). State i is requantized at
+ *  tnext[i], when x_i deviates from q_i by the quantum dQ[i]. The states are
+ *  kept in a binary min-heap ordered by tnext, so the next state is found in
+ *  O(1) and after a step only the heap entries of the states whose
+ *  derivatives depend on the requantized state are updated.
+ */
+typedef struct QSS_DATA
+{
+  int method;                /*!< QSS_QSS1, QSS_QSS2, QSS_QSS3 or QSS_LIQSS2 */
+  int order;                 /*!< degree of the state trajectories */
+  uinteger n;                /*!< number of states */
+  modelica_real deltaT;      /*!< time step for the numerical time derivatives of f */
+
+  modelica_real *x;          /*!< coefficients of the state trajectories, 4 per state */
+  modelica_real *q;          /*!< coefficients of the quantized trajectories, 3 per state */
+  modelica_real *tx;         /*!< anchor times of x */
+  modelica_real *tq;         /*!< anchor times of q */
+  modelica_real *tnext;      /*!< times of the next requantization */
+  modelica_real *dQ;         /*!< quanta, (nominal value) * 10^-4 */
+  modelica_real *offset;     /*!< x-q right after the requantization; nonzero only for LIQSS2 */
+  modelica_real *a;          /*!< estimated diagonal of the Jacobian, only for LIQSS2 */
+  modelica_real *f[3];       /*!< derivatives at time t, t+deltaT and t+2*deltaT */
+
+  uinteger *heap;            /*!< states ordered by tnext */
+  uinteger *pos;             /*!< position of every state in heap */
+
+  uinteger *derLead;         /*!< derivatives depending on state k: derIndex[derLead[k]..derLead[k+1]-1] */
+  uinteger *derIndex;
+  uinteger *inLead;          /*!< states in derivative j: inIndex[inLead[j]..inLead[j+1]-1] */
+  uinteger *inIndex;
+
+  uinteger *affected;        /*!< derivatives to update in the current step */
+  uinteger numAffected;
+  uinteger *inputs;          /*!< states these derivatives depend on */
+  uinteger numInputs;
+  uinteger *mark;            /*!< marks for collecting affected and inputs without duplicates */
+  uinteger stamp;
+} QSS_DATA;
+
+static modelica_integer allocateQSSData(QSS_DATA* qss, DATA* data, int method);
+static void freeQSSData(QSS_DATA* qss);
+static void heapInit(QSS_DATA* qss);
+static void heapUpdate(QSS_DATA* qss, uinteger i);
+static void collectAffected(QSS_DATA* qss, uinteger ind);
+static void evaluateDerivatives(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, modelica_real* f);
+static modelica_integer updateStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, int requantized);
+static void requantize(QSS_DATA* qss, uinteger i, modelica_real time);
+static modelica_real nextTime(const QSS_DATA* qss, uinteger i, modelica_real time);
+static void emitStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time);
+static modelica_real evalPoly(const modelica_real* c, int order, modelica_real h);
+static void shiftPoly(modelica_real* c, int order, modelica_real h);
+static modelica_real minPositiveRoot(const modelica_real* c, int order);
 
 /*! performQSSSimulation(DATA* data, SOLVER_INFO* solverInfo)
  *
@@ -73,28 +122,48 @@ int prefixedName_performQSSSimulation(DATA* data, threadData_t *threadData, SOLV
   TRACE_PUSH
 
   SIMULATION_INFO *simInfo = data->simulationInfo;
-  MODEL_DATA *mData = data->modelData;
   uinteger currStepNo = 0;
   modelica_integer retValIntegrator = 0;
   modelica_integer retValue = 0;
   uinteger ind = 0;
   uinteger i = 0;
-  SIMULATION_DATA *sData = NULL;
-  modelica_real* state = NULL;
-  modelica_real* stateDer = NULL;
-  SPARSE_PATTERN* pattern = NULL;
-  uinteger ROWS = 0;
-  uinteger STATES = 0;
-  uinteger numDer = 0;
-  modelica_boolean fail = 0;
-  modelica_real *qik, *xik, *derXik, *tq, *tx, *tqp, *nQh, *dQ;
-  modelica_real diffQ = 0.0, dTnextQ = 0.0, nextQ = 0.0;
-  modelica_integer* der = NULL;
+  uinteger outStep = 1;
+  modelica_real tOut = 0.0;
+  int method = QSS_QSS1;
+  int equidistantOutput = omc_flag[FLAG_QSS_GRID_OUTPUT];
+  QSS_DATA qss;
 
   solverInfo->currentTime = simInfo->startTime;
 
   warningStreamPrint(LOG_STDOUT, 0, "This QSS method is under development and should not be used yet.");
 
+  if (omc_flag[FLAG_QSS_METHOD])
+  {
+    method = QSS_UNKNOWN;
+    for (i = 1; i < QSS_MAX; i++)
+    {
+      if (!strcmp((const char*)omc_flagValue[FLAG_QSS_METHOD], QSS_METHOD_NAME[i]))
+      {
+        method = (int)i;
+        break;
+      }
+    }
+    if (method == QSS_UNKNOWN)
+    {
+      if (ACTIVE_WARNING_STREAM(LOG_SOLVER))
+      {
+        warningStreamPrint(LOG_SOLVER, 1, "unrecognized QSS method %s, current options are:", (const char*)omc_flagValue[FLAG_QSS_METHOD]);
+        for (i = 1; i < QSS_MAX; ++i)
+        {
+          warningStreamPrint(LOG_SOLVER, 0, "%-15s [%s]", QSS_METHOD_NAME[i], QSS_METHOD_DESC[i]);
+        }
+        messageClose(LOG_SOLVER);
+      }
+      throwStreamPrint(threadData, "unrecognized QSS method %s", (const char*)omc_flagValue[FLAG_QSS_METHOD]);
+    }
+  }
+  infoStreamPrint(LOG_SOLVER, 0, "QSS method: %s", QSS_METHOD_DESC[method]);
+
   if (data->callback->initialAnalyticJacobianA(data, threadData))
   {
     infoStreamPrint(LOG_STDOUT, 0, "Jacobian or sparse pattern is not generated or failed to initialize.");
@@ -104,106 +173,29 @@ int prefixedName_performQSSSimulation(DATA* data, threadData_t *threadData, SOLV
 
 /* *********************************************************************************** */
   /* Initialization */
-  i = 0; /* loop var */
-  sData = (SIMULATION_DATA*)data->localData[0];
-  state = sData->realVars;
-  stateDer = sData->realVars + data->modelData->nStates;
-  pattern = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern);
-  ROWS = data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sizeRows;
-  STATES = data->modelData->nStates;
-  numDer = 0;  /* number of derivatives influenced by state k */
-
-  fail = 0;
-  qik = NULL;  /* Approximation of states */
-  xik = NULL;  /* states */
-  derXik = NULL;  /* Derivative of states */
-  tq = NULL;    /* Time of approximation, because not all approximations are calculated at a specific time, each approx. has its own timestamp */
-  tx = NULL;    /* Time of the states, because not all states are calculated at a specific time, each state has its own timestamp */
-  tqp = NULL;    /* Time of the next change in state */
-  nQh = NULL;    /* next value of the state */
-  dQ = NULL;    /* change in quantity of every state, default = nominal*10^-4 */
-
-  /* allocate memory*/
-  qik = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (qik == NULL) ? 1 : ( 0 | fail);
-  xik = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (xik == NULL) ? 1 : ( 0 | fail);
-  derXik = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (derXik == NULL) ? 1 : ( 0 | fail);
-  tq = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (tq == NULL) ? 1 : ( 0 | fail);
-  tx = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (tx == NULL) ? 1 : ( 0 | fail);
-  tqp = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (tqp == NULL) ? 1 : ( 0 | fail);
-  nQh = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (nQh == NULL) ? 1 : ( 0 | fail);
-  dQ = (modelica_real*)calloc(STATES, sizeof(modelica_real));
-  fail = (dQ == NULL) ? 1 : ( 0 | fail);
-
-
-  if (fail)
-    return OO_MEMORY;
-  /* end - allocate memory */
-
-  /* further initialization of local variables */
-
-  diffQ = 0.0; dTnextQ = 0.0; nextQ = 0.0;
-  for (i = 0; i < STATES; i++)
-  {
-    dQ[i] = 0.0001 * data->modelData->realVarsData[i].attribute.nominal;
-    tx[i] = tq[i] = simInfo->startTime;
-    qik[i] = state[i];
-    xik[i] = state[i];
-    derXik[i] = stateDer[i];
-    retValue = deltaQ(data, dQ[i], i, &dTnextQ, &nextQ, &diffQ);
-    if (OK != retValue)
-      return retValue;
-    tqp[i] = tq[i] + dTnextQ;
-    nQh[i] = nextQ;
-  }
-
-/* Transform the sparsity pattern into a data structure for an index based access. */
-  der = (modelica_integer*)calloc(ROWS, sizeof(modelica_integer));
-  if (NULL==der)
-    return OO_MEMORY;
-  for (i = 0; i < ROWS; i++)
-    der[i] = -1;
-
-  /* how many states are involved in each derivative */
-  /* **** This is needed if we have QSS2 or higher **** */
- /* uinteger* numStatesInDer = calloc(ROWS,sizeof(uinteger));
-  if (NULL==numStatesInDer) return OO_MEMORY; */
-  /*
-   *   dx1/dt = x2
-   *   dx2/dt = x1 + x2
-   *   lead to
-   *  StatesInDer[0]-{ 2 }
-   *  StatesInDer[1]-{ 1, 2 }
-  */
-/*  uinteger** StatesInDer = calloc(ROWS,sizeof(uinteger*));
-  if (NULL==StatesInDer) return OO_MEMORY; */
-
-  /* count number of states in each derivative*/
-/*  for (i = 0; i < pattern->leadindex[ROWS-1]; i++) numStatesInDer[ pattern->index[i] ]++; */
-  /* collect memory for all stateindices */
-/*  for (i = 0; i < ROWS; i++)
+  retValue = allocateQSSData(&qss, data, method);
+  if (OK != retValue)
+    return retValue;
+
+  /* all derivatives are computed at the start time */
+  qss.numAffected = 0;
+  for (i = 0; i < qss.n; i++)
+    qss.affected[qss.numAffected++] = i;
+  qss.numInputs = 0;
+  for (i = 0; i < qss.n; i++)
+    qss.inputs[qss.numInputs++] = i;
+  retValue = updateStates(data, threadData, &qss, simInfo->startTime, 0);
+  if (OK != retValue)
   {
-    *(StatesInDer + i) = calloc(numStatesInDer[i], sizeof(uinteger));
-    if (NULL==*(StatesInDer + i)) return OO_MEMORY;
+    freeQSSData(&qss);
+    return retValue;
   }
+  heapInit(&qss);
 
-  retValue = getStatesInDer(pattern->index, pattern->leadindex, ROWS, STATES, StatesInDer);
-  if (OK != retValue) return retValue; */
-
-/*  retValue = getDerWithStateK(pattern->index, pattern->leadindex, der, &numDer, 0);
-  if (OK != retValue) return retValue; */
-/* End of transformation */
-
-#ifdef D
-  FILE* fid=NULL;
-  fid = fopen("log_qss.txt","w");
-#endif
+  if (simInfo->numSteps > 0)
+    tOut = simInfo->startTime + (simInfo->stopTime - simInfo->startTime) / simInfo->numSteps;
+  else
+    tOut = simInfo->stopTime;
 
 /* *********************************************************************************** */
 
@@ -211,7 +203,7 @@ int prefixedName_performQSSSimulation(DATA* data, threadData_t *threadData, SOLV
   while(solverInfo->currentTime < simInfo->stopTime)
   {
     modelica_integer success = 0;
-	uinteger k = 0, j = 0;
+    modelica_real time;
 
     threadData->currentErrorStage = ERROR_SIMULATION;
     omc_alloc_interface.collect_a_little();
@@ -227,180 +219,93 @@ int prefixedName_performQSSSimulation(DATA* data, threadData_t *threadData, SOLV
       printf("TRACE: push loop step=%u, time=%.12g\n", currStepNo, solverInfo->currentTime);
 #endif
 
-#ifdef D
-    fprintf(fid,"t = %.8f\n",solverInfo->currentTime);
-    fprintf(fid,"%16s\t%16s\t%16s\t%16s\t%16s\t%16s\n","tx","x","dx","tq","q","tqp");
-    for (i = 0; i < STATES; i++)
-    {
-      fprintf(fid,"%16.8f\t%16.8f\t%16.8f\t%16.8f\t%16.8f\t%16.8f\n",tx[i],xik[i],derXik[i],tq[i],qik[i],tqp[i]);
-    }
-#endif
-
-    currStepNo++;
-
-    ind = minStep(tqp, STATES);
+    ind = qss.heap[0];
+    time = qss.tnext[ind];
 
-    if (isnan(tqp[ind]))
+    /* emit the output points before the next requantization */
+    while (equidistantOutput && tOut <= time && tOut <= simInfo->stopTime)
     {
-#ifdef D
-      fprintf(fid,"Exit caused by #QNAN!\tind=%d",ind);
-#endif
-      return ISNAN;
+      emitStates(data, threadData, &qss, tOut);
+      outStep++;
+      tOut = simInfo->startTime + outStep * (simInfo->stopTime - simInfo->startTime) / simInfo->numSteps;
+      if (outStep > simInfo->numSteps)
+        tOut = simInfo->stopTime + 1.0;
     }
-    if (isinf(tqp[ind]))
+
+    if (time >= simInfo->stopTime)
     {
       /* If all derivatives are zero, the states stay constant and only the
        * time propagates till stop->time.
        */
-      warningStreamPrint(LOG_STDOUT, 0, "All derivatives are zero at time %f!.\n", sData->timeValue);
+      if (!equidistantOutput)
+        emitStates(data, threadData, &qss, simInfo->stopTime);
       solverInfo->currentTime = simInfo->stopTime;
-      sData->timeValue = solverInfo->currentTime;
-
-      continue;
+      solverInfo->laststep = solverInfo->currentTime;
+      success = 1;
     }
-
-    qik[ind] = nQh[ind];
-
-    xik[ind] = qik[ind];
-    state[ind] = qik[ind];
-
-    tx[ind] = tqp[ind];
-    tq[ind] = tqp[ind];
-
-    solverInfo->currentTime = tqp[ind];
-
-#ifdef D
-    fprintf(fid,"Index: %d\n\n",ind);
-#endif
-
-    /* the state[ind] will change again in dTnextQ*/
-    retValue = deltaQ(data, dQ[ind], ind, &dTnextQ, &nextQ, &diffQ);
-    if (OK != retValue)
-      return retValue;
-    tqp[ind] = tq[ind] + dTnextQ;
-    nQh[ind] = nextQ;
-
-    if (0 != strcmp("ia", data->simulationInfo->outputFormat))
+    else
     {
-      communicateStatus("Running", (solverInfo->currentTime-simInfo->startTime)/(simInfo->stopTime-simInfo->startTime));
-    }
-
-    /* get the derivatives depending on state[ind] */
-    for (i = 0; i < ROWS; i++)
-      der[i] = -1;
-    retValue = getDerWithStateK(pattern->index, pattern->leadindex, der, &numDer, ind);
-
-    k = 0, j = 0;
-    for (k = 0; k < numDer; k++)
-    {
-      j = der[k];
-      if (j != ind)
+      currStepNo++;
+      solverInfo->currentTime = time;
+
+      /* requantize state[ind] and update all derivatives depending on it */
+      requantize(&qss, ind, time);
+      collectAffected(&qss, ind);
+      retValIntegrator = updateStates(data, threadData, &qss, time, 1);
+      if (ISNAN == retValIntegrator)
       {
-        xik[j] = xik[j] + derXik[j] * (solverInfo->currentTime - tx[j]);
-        state[j] = xik[j];
-        tx[j] = solverInfo->currentTime;
+        warningStreamPrint(LOG_STDOUT, 0, "Time of next change is NaN at time %g.", time);
       }
-    }
+      for (i = 0; i < qss.numAffected; i++)
+        heapUpdate(&qss, qss.affected[i]);
 
-    /*
-     * Recalculate all equations which are affected by state[ind].
-     * Unfortunately all equations will be calculated up to now. And we need to evaluate
-     * the equations as f(t,q) and not f(t,x). So all states were saved onto a local stack
-     * and overwritten by q. After evaluating the equations the states are written back.
-     */
-    for (i = 0; i < STATES; i++)
-    {
-      xik[i] = state[i];   /* save current state */
-      state[i] = qik[i];  /* overwrite current state for dx/dt = f(t,q) */
-    }
-
-    /* update continous system */
-    sData->timeValue = solverInfo->currentTime;
-    externalInputUpdate(data);
-    data->callback->input_function(data, threadData);
-    data->callback->functionODE(data, threadData);
-    data->callback->functionAlgebraics(data, threadData);
-    data->callback->output_function(data, threadData);
-    data->callback->function_storeDelayed(data, threadData);
-
-    for (i = 0; i < STATES; i++)
-    {
-      state[i] = xik[i];  /* restore current state */
-    }
+      if (!equidistantOutput)
+        emitStates(data, threadData, &qss, time);
 
+      solverInfo->laststep = solverInfo->currentTime;
 
-    /*
-     * Get derivatives affected by state[ind] and write back ALL derivatives. After that we have
-     * states and derivatives for different times tx.
-    */
-
-    for (k = 0; k < numDer; k++)
-    {
-      j = der[k];
-      derXik[j] = stateDer[j];
-    }
-    derXik[ind] = stateDer[ind];  /* not in every case part of the above derivatives */
-
-    for (i = 0; i < STATES; i++)
-    {
-      stateDer[i] = derXik[i];  /* write back all derivatives */
-    }
-
-    /* recalculate the time of next change only for the affected states */
-    for (k = 0; k < numDer; k++)
-    {
-      j = der[k];
-      retValue = deltaQ(data, dQ[j], j, &dTnextQ, &nextQ, &diffQ);
-      if (OK != retValue)
-        return retValue;
-      tqp[j] = solverInfo->currentTime + dTnextQ;
-      nQh[j] = nextQ;
-    }
-
-    /*sData->timeValue = solverInfo->currentTime;*/
-    solverInfo->laststep = solverInfo->currentTime;
-
-    sim_result.emit(&sim_result, data, threadData);
-
-    /* check if terminate()=true */
-    if (terminationTerminate)
-    {
-      printInfo(stdout, TermInfo);
-      fputc('\n', stdout);
-      infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at time %f\nMessage : %s", data->localData[0]->timeValue, TermMsg);
-      simInfo->stopTime = solverInfo->currentTime;
-    }
+      /* check if terminate()=true */
+      if (simInfo->terminationTerminate)
+      {
+        printInfo(stdout, simInfo->terminationInfo);
+        fputc('\n', stdout);
+        infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at time %f\nMessage : %s", data->localData[0]->timeValue, simInfo->terminationMessage);
+        simInfo->stopTime = solverInfo->currentTime;
+        if (equidistantOutput)
+          emitStates(data, threadData, &qss, solverInfo->currentTime);
+      }
 
-    /* terminate for some cases:
-     * - integrator fails
-     * - non-linear system failed to solve
-     * - assert was called
-     */
-    if (retValIntegrator)
-    {
-      retValue = -1 + retValIntegrator;
-      infoStreamPrint(LOG_STDOUT, 0, "model terminate | Integrator failed. | Simulation terminated at time %g", solverInfo->currentTime);
-      break;
-    }
-    else if (check_nonlinear_solutions(data, 0))
-    {
-      retValue = -2;
-      infoStreamPrint(LOG_STDOUT, 0, "model terminate | non-linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
-      break;
-    }
-    else if (check_linear_solutions(data, 0))
-    {
-      retValue = -3;
-      infoStreamPrint(LOG_STDOUT, 0, "model terminate | linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
-      break;
-    }
-    else if (check_mixed_solutions(data, 0))
-    {
-      retValue = -4;
-      infoStreamPrint(LOG_STDOUT, 0, "model terminate | mixed system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
-      break;
+      /* terminate for some cases:
+       * - integrator fails
+       * - non-linear system failed to solve
+       * - assert was called
+       */
+      if (retValIntegrator)
+      {
+        retValue = -1 + retValIntegrator;
+        infoStreamPrint(LOG_STDOUT, 0, "model terminate | Integrator failed. | Simulation terminated at time %g", solverInfo->currentTime);
+        break;
+      }
+      else if (check_nonlinear_solutions(data, 0))
+      {
+        retValue = -2;
+        infoStreamPrint(LOG_STDOUT, 0, "model terminate | non-linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+        break;
+      }
+      else if (check_linear_solutions(data, 0))
+      {
+        retValue = -3;
+        infoStreamPrint(LOG_STDOUT, 0, "model terminate | linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+        break;
+      }
+      else if (check_mixed_solutions(data, 0))
+      {
+        retValue = -4;
+        infoStreamPrint(LOG_STDOUT, 0, "model terminate | mixed system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+        break;
+      }
+      success = 1;
     }
-    success = 1;
 #if !defined(OMC_EMCC)
     }
     /* catch */
@@ -417,168 +322,541 @@ int prefixedName_performQSSSimulation(DATA* data, threadData_t *threadData, SOLV
   }
   /* End of main loop */
 
-#ifdef D
-  fprintf(fid,"t = %.8f\n",solverInfo->currentTime);
-  fprintf(fid,"%16s\t%16s\t%16s\t%16s\t%16s\t%16s\n","tx","x","dx","tq","q","tqp");
-  for (i = 0; i < STATES; i++)
-  {
-    fprintf(fid,"%16.8f\t%16.8f\t%16.8f\t%16.8f\t%16.8f\t%16.8f\n",tx[i],xik[i],derXik[i],tq[i],qik[i],tqp[i]);
-  }
-  fclose(fid);
-#endif
+  infoStreamPrint(LOG_SOLVER, 0, "%s: %lu steps", QSS_METHOD_NAME[method], (unsigned long)currStepNo);
 
-  /* free memory*/
-   free(der);
- /*  for (i = 0; i < ROWS; i++) free(*(StatesInDer + i));
-   free(StatesInDer);
-   free(numStatesInDer); */
-   free(qik);
-   free(xik);
-   free(derXik);
-   free(tq);
-   free(tx);
-   free(tqp);
-   free(nQh);
-   free(dQ);
-   /* end - free memory */
+  freeQSSData(&qss);
 
   TRACE_POP
   return retValue;
 }
 
+/*! static modelica_integer allocateQSSData(QSS_DATA* qss, DATA* data, int method)
+ *  \brief  Allocates the QSS data and sets up the trajectories at the start time.
+ *
+ *  The sparsity pattern of the Jacobian A is stored column-wise: column k
+ *  holds the derivatives depending on state k. It is transposed here to get
+ *  the states each derivative depends on.
+ *  \return  [OK] or [OO_MEMORY].
+ */
+static modelica_integer allocateQSSData(QSS_DATA* qss, DATA* data, int method)
+{
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  modelica_real* state = data->localData[0]->realVars;
+  SPARSE_PATTERN* pattern = &(simInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern);
+  uinteger n = data->modelData->nStates;
+  uinteger nnz, i, k;
+
+  memset(qss, 0, sizeof(QSS_DATA));
+  qss->method = method;
+  qss->order = method == QSS_QSS1 ? 1 : (method == QSS_QSS3 ? 3 : 2);
+  qss->n = n;
+  /* forward differences: the error of f' is O(deltaT), of f'' O(deltaT) with
+   * rounding errors O(eps/deltaT^2) */
+  qss->deltaT = (qss->order == 3 ? 1e-5 : 1e-8) * (simInfo->stopTime - simInfo->startTime);
+  if (qss->deltaT <= 0.0)
+    qss->deltaT = 1e-8;
+  nnz = n > 0 ? pattern->leadindex[n-1] : 0;
+
+  qss->x = (modelica_real*)calloc(4*n+1, sizeof(modelica_real));
+  qss->q = (modelica_real*)calloc(3*n+1, sizeof(modelica_real));
+  qss->tx = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->tq = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->tnext = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->dQ = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->offset = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->a = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  for (k = 0; k < 3; k++)
+    qss->f[k] = (modelica_real*)calloc(n+1, sizeof(modelica_real));
+  qss->heap = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->pos = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->derLead = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->derIndex = (uinteger*)calloc(nnz+1, sizeof(uinteger));
+  qss->inLead = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->inIndex = (uinteger*)calloc(nnz+1, sizeof(uinteger));
+  qss->affected = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->inputs = (uinteger*)calloc(n+1, sizeof(uinteger));
+  qss->mark = (uinteger*)calloc(n+1, sizeof(uinteger));
+
+  if (!qss->x || !qss->q || !qss->tx || !qss->tq || !qss->tnext || !qss->dQ || !qss->offset || !qss->a ||
+      !qss->f[0] || !qss->f[1] || !qss->f[2] || !qss->heap || !qss->pos || !qss->derLead || !qss->derIndex ||
+      !qss->inLead || !qss->inIndex || !qss->affected || !qss->inputs || !qss->mark)
+  {
+    freeQSSData(qss);
+    return OO_MEMORY;
+  }
+
+  /* derivatives depending on state k */
+  for (k = 0; k < n; k++)
+    qss->derLead[k+1] = pattern->leadindex[k];
+  for (i = 0; i < nnz; i++)
+    qss->derIndex[i] = pattern->index[i];
+
+  /* states in derivative j */
+  for (i = 0; i < nnz; i++)
+    qss->inLead[pattern->index[i]+1]++;
+  for (k = 0; k < n; k++)
+    qss->inLead[k+1] += qss->inLead[k];
+  for (k = 0; k < n; k++)
+  {
+    for (i = qss->derLead[k]; i < qss->derLead[k+1]; i++)
+    {
+      uinteger j = qss->derIndex[i];
+      qss->inIndex[qss->inLead[j] + qss->mark[j]++] = k;
+    }
+  }
+  memset(qss->mark, 0, n*sizeof(uinteger));
+
+  for (i = 0; i < n; i++)
+  {
+    qss->dQ[i] = 0.0001 * data->modelData->realVarsData[i].attribute.nominal;
+    qss->tx[i] = qss->tq[i] = simInfo->startTime;
+    qss->x[4*i] = state[i];
+    qss->q[3*i] = state[i];
+  }
+  return OK;
+}
+
+/*! static void freeQSSData(QSS_DATA* qss)
+ *  \brief  Frees the QSS data.
+ */
+static void freeQSSData(QSS_DATA* qss)
+{
+  int k;
+  free(qss->x);
+  free(qss->q);
+  free(qss->tx);
+  free(qss->tq);
+  free(qss->tnext);
+  free(qss->dQ);
+  free(qss->offset);
+  free(qss->a);
+  for (k = 0; k < 3; k++)
+    free(qss->f[k]);
+  free(qss->heap);
+  free(qss->pos);
+  free(qss->derLead);
+  free(qss->derIndex);
+  free(qss->inLead);
+  free(qss->inIndex);
+  free(qss->affected);
+  free(qss->inputs);
+  free(qss->mark);
+}
 
-/*! static int deltaQ( DATA* data, const modelica_integer index, modelica_real* dTnextQ, modelica_real* nextQ, modelica_real* diffQ)
- *  \brief  Computes the next step in time and quantity for state[index].
- *  \param [ref] [data]  Global data object.
- *  \param [in]  [dQ] Change of quantity for state[index], (nominal value) * 10^-4.
- *  \param [in] [index]  A new step will be computed for state[index].
- *  \param [out] [dTnextQ]  The state will change after dTnextQ second.
- *  \param [out] [nextQ]  Next quantity reached by the state.
- *  \param [out] [diffQ]  Difference between the states current and future value.
- *  \return  [0]  Everything is fine.
+/*! static int heapLess(const QSS_DATA* qss, uinteger i, uinteger j)
+ *  \brief  Order of the heap; NaN is never less, so it sinks to the bottom.
  */
-static modelica_integer deltaQ( DATA* data, const modelica_real dQ, const modelica_integer index, modelica_real* dTnextQ, modelica_real* nextQ, modelica_real* diffQ)
+static int heapLess(const QSS_DATA* qss, uinteger i, uinteger j)
 {
+  return qss->tnext[qss->heap[i]] < qss->tnext[qss->heap[j]];
+}
 
-  /* localData[0] because old values in the ringbuffer are not stored in QSS1 and so the ringbuffer will not be rotated. */
-  SIMULATION_DATA *sDataOld = (SIMULATION_DATA*)data->localData[0];
-  modelica_real* stateDer = sDataOld->realVars + data->modelData->nStates;
+static void heapSwap(QSS_DATA* qss, uinteger i, uinteger j)
+{
+  uinteger tmp = qss->heap[i];
+  qss->heap[i] = qss->heap[j];
+  qss->heap[j] = tmp;
+  qss->pos[qss->heap[i]] = i;
+  qss->pos[qss->heap[j]] = j;
+}
 
+static void heapSiftDown(QSS_DATA* qss, uinteger i)
+{
+  for (;;)
+  {
+    uinteger l = 2*i+1, r = 2*i+2, m = i;
+    if (l < qss->n && heapLess(qss, l, m))
+      m = l;
+    if (r < qss->n && heapLess(qss, r, m))
+      m = r;
+    if (m == i)
+      return;
+    heapSwap(qss, i, m);
+    i = m;
+  }
+}
 
-  if (stateDer[index] >= 0 )    /* quantity of the state will increase */
+/*! static void heapInit(QSS_DATA* qss)
+ *  \brief  Builds the heap of all states ordered by tnext in O(n).
+ */
+static void heapInit(QSS_DATA* qss)
+{
+  uinteger i;
+  for (i = 0; i < qss->n; i++)
   {
-    *nextQ = (floor( sDataOld->realVars[index] / dQ ) + 1 ) * dQ;
-    if (*nextQ <= (sDataOld->realVars[index] + EPS))
-      *nextQ = *nextQ + dQ;
+    qss->heap[i] = i;
+    qss->pos[i] = i;
   }
-  else
+  for (i = qss->n/2; i > 0; i--)
+    heapSiftDown(qss, i-1);
+}
+
+/*! static void heapUpdate(QSS_DATA* qss, uinteger k)
+ *  \brief  Restores the heap order after tnext[k] has changed, in O(log n).
+ */
+static void heapUpdate(QSS_DATA* qss, uinteger k)
+{
+  uinteger i = qss->pos[k];
+  while (i > 0 && heapLess(qss, i, (i-1)/2))
   {
-    *nextQ = floor( sDataOld->realVars[index] / dQ ) * dQ;
-    if (*nextQ >= (sDataOld->realVars[index] - EPS ))
-      *nextQ = *nextQ - dQ;
+    heapSwap(qss, i, (i-1)/2);
+    i = (i-1)/2;
   }
+  heapSiftDown(qss, i);
+}
 
-  *diffQ = fabs(*nextQ - sDataOld->realVars[index]);
-  *dTnextQ = fabs(*diffQ / stateDer[index]);
+/*! static void collectAffected(QSS_DATA* qss, uinteger ind)
+ *  \brief  Collects the derivatives depending on state ind, plus ind itself,
+ *          and all states these derivatives depend on.
+ */
+static void collectAffected(QSS_DATA* qss, uinteger ind)
+{
+  uinteger i, k;
 
-  return OK;
+  qss->stamp++;
+  qss->numAffected = 0;
+  qss->affected[qss->numAffected++] = ind;
+  qss->mark[ind] = qss->stamp;
+  for (i = qss->derLead[ind]; i < qss->derLead[ind+1]; i++)
+  {
+    uinteger j = qss->derIndex[i];
+    if (qss->mark[j] != qss->stamp)
+    {
+      qss->mark[j] = qss->stamp;
+      qss->affected[qss->numAffected++] = j;
+    }
+  }
+
+  qss->stamp++;
+  qss->numInputs = 0;
+  for (k = 0; k < qss->numAffected; k++)
+  {
+    uinteger j = qss->affected[k];
+    for (i = qss->inLead[j]; i < qss->inLead[j+1]; i++)
+    {
+      uinteger s = qss->inIndex[i];
+      if (qss->mark[s] != qss->stamp)
+      {
+        qss->mark[s] = qss->stamp;
+        qss->inputs[qss->numInputs++] = s;
+      }
+    }
+  }
 }
 
-/*! static int getDerWithStateK(const unsigned int *index, const unsigned int* leadindex, int* der, unsigned int* numDer, const unsigned int k)
- *  \brief  Returns the indices of all derivatives with state k inside.
- *  \param [ref] [index]
- *  \param [ref] [leadindex]
- *  \param [out] [der]  Derivatives which are influenced by state k.
- *  \param [out] [numDer] Number of influenced derivatives.
- *  \param [in] [k]  State to look for.
- *  \return [0]  Everything is fine.
+/*! static void evaluateDerivatives(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, modelica_real* f)
+ *  \brief  Evaluates the affected derivatives as f(time, q(time)).
+ *
+ *  Only the states the affected derivatives depend on are set to their
+ *  quantized values; the derivatives of all other states are not used.
+ *  \param [out] [f]  f[j] for all affected derivatives j.
  */
-static modelica_integer getDerWithStateK(const unsigned int *index, const unsigned int* leadindex, modelica_integer* der, uinteger* numDer, const uinteger k)
+static void evaluateDerivatives(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, modelica_real* f)
 {
-  uinteger start = 0, j, i;
-  if (0 < k)
-    start = leadindex[k - 1];
-  j = 0;
-  i = 0;
-  for (i = start; i < leadindex[k]; i++)
+  SIMULATION_DATA *sData = (SIMULATION_DATA*)data->localData[0];
+  modelica_real* state = sData->realVars;
+  modelica_real* stateDer = sData->realVars + data->modelData->nStates;
+  uinteger i;
+
+  for (i = 0; i < qss->numInputs; i++)
   {
-    der[j] = index[i];
-    j++;
+    uinteger s = qss->inputs[i];
+    state[s] = evalPoly(qss->q + 3*s, qss->order-1, time - qss->tq[s]);
   }
-  *numDer = j;
-  return OK;
+
+  sData->timeValue = time;
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+
+  for (i = 0; i < qss->numAffected; i++)
+    f[qss->affected[i]] = stateDer[qss->affected[i]];
 }
 
-/*! static int getStatesInDer(const unsigned int* index, const unsigned int* leadindex, const unsigned int ROWS, const unsigned int STATES, unsigned int** StatesInDer)
- *  \brief  Return the indices of all states in each derivative for an indexed access.
- *  \param [ref] [index]
- *  \param [ref] [leadindex]
- *  \param [in]  [ROWS] number of derivatives
- *  \param [in]  [STATES] number of states
- *  \param [out] [StatesInDer]  index of states in each derivative
+/*! static modelica_integer updateStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, int requantized)
+ *  \brief  Recomputes the trajectories of the affected states at time.
  *
+ *  The coefficients of order two and three are the time derivatives of f
+ *  along the quantized trajectories, computed with forward differences.
+ *  \param [in] [requantized]  If set, affected[0] has just been requantized;
+ *                             for LIQSS2 its Jacobian diagonal is estimated.
+ *  \return  [OK] or [ISNAN] if a time of next change is NaN.
  */
-static modelica_integer getStatesInDer(const unsigned int* index, const unsigned int* leadindex, const uinteger ROWS, const uinteger STATES, uinteger** StatesInDer)
+static modelica_integer updateStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time, int requantized)
 {
-  uinteger i = 0, k = 0; /* loop var */
-  uinteger numDer = 0;
-  modelica_integer* der = (modelica_integer*)calloc(ROWS, sizeof(modelica_integer));
-  uinteger* stackPointer = (uinteger*)calloc(ROWS, sizeof(uinteger));
+  modelica_real* stateDer = data->localData[0]->realVars + data->modelData->nStates;
+  modelica_real h = qss->deltaT;
+  modelica_real *f0 = qss->f[0], *f1 = qss->f[1], *f2 = qss->f[2];
+  modelica_integer retValue = OK;
+  uinteger i;
 
-  if (NULL == der)
-    return OO_MEMORY;
+  evaluateDerivatives(data, threadData, qss, time, f0);
 
-  for (i = 0; i < ROWS; i++)
-    der[i] = -1;
+  if (QSS_LIQSS2 == qss->method && requantized)
+  {
+    /* a_ii = df_i/dq_i for the next requantization of state i */
+    uinteger k = qss->affected[0];
+    modelica_real* state = data->localData[0]->realVars;
+    modelica_real qk = state[k];
+    state[k] = qk + qss->dQ[k];
+    data->callback->functionODE(data, threadData);
+    qss->a[k] = (stateDer[k] - f0[k]) / qss->dQ[k];
+    state[k] = qk;
+  }
+  if (qss->order > 1)
+    evaluateDerivatives(data, threadData, qss, time + h, f1);
+  if (qss->order > 2)
+    evaluateDerivatives(data, threadData, qss, time + 2*h, f2);
 
-  for (i = 0; i < ROWS; i++)
-    stackPointer[i] = 0;
+  for (i = 0; i < qss->numAffected; i++)
+  {
+    uinteger j = qss->affected[i];
+    modelica_real* x = qss->x + 4*j;
+
+    /* x_j is continuous: advance it to time and replace its derivatives */
+    x[0] = evalPoly(x, qss->order, time - qss->tx[j]);
+    qss->tx[j] = time;
+    x[1] = f0[j];
+    switch (qss->order)
+    {
+    case 2:
+      x[2] = 0.5 * (f1[j] - f0[j]) / h;
+      break;
+    case 3:
+      x[2] = 0.5 * (-3.0*f0[j] + 4.0*f1[j] - f2[j]) / (2.0*h);
+      x[3] = (f0[j] - 2.0*f1[j] + f2[j]) / (6.0*h*h);
+      break;
+    }
 
-  /*    Ask for all states in which derivative they occur. */
-  for (k = 0; k < STATES; k++)
+    qss->tnext[j] = nextTime(qss, j, time);
+    if (isnan(qss->tnext[j]))
+      retValue = ISNAN;
+  }
+  return retValue;
+}
+
+/*! static void requantize(QSS_DATA* qss, uinteger i, modelica_real time)
+ *  \brief  Sets the quantized trajectory of state i at time.
+ *
+ *  For QSS q_i is the Taylor polynomial of x_i of degree order-1. For
+ *  LIQSS2 q_i is placed one quantum above or below x_i, on the side x_i
+ *  moves to when the derivative is evaluated at q_i, using the local model
+ *  dx_i/dt = a_ii*q_i + u(t). If neither side is consistent, q_i is the
+ *  point where x_i is in equilibrium.
+ */
+static void requantize(QSS_DATA* qss, uinteger i, modelica_real time)
+{
+  modelica_real* x = qss->x + 4*i;
+  modelica_real* q = qss->q + 3*i;
+  modelica_real dQ = qss->dQ[i];
+  modelica_real a = qss->a[i];
+
+  shiftPoly(x, qss->order, time - qss->tx[i]);
+  qss->tx[i] = time;
+
+  if (QSS_LIQSS2 == qss->method && fabs(a) * dQ > DBL_EPSILON * fabs(x[1]))
   {
-    getDerWithStateK(index, leadindex, der, &numDer, k);
-    for (i = 0; i < ROWS; i++)
+    modelica_real q0, q1, u0, u1;
+
+    /* u(t) of the local model from the current slope with the old q */
+    shiftPoly(q, 1, time - qss->tq[i]);
+    u0 = x[1] - a * q[0];
+    u1 = 2.0 * x[2] - a * q[1];
+
+    q0 = x[0] + dQ;
+    q1 = a * q0 + u0;
+    if (a * q1 + u1 < 0.0)
     {
-      if (der[i] < 0)
-        continue;
-      /* stackPointer refers to the next free position for der[i] in StatesInDer */
-      StatesInDer[ der[i] ][ stackPointer[ der[i] ] ] = k;
-      stackPointer[ der[i] ]++;
-      der[i] = -1;  /* clear all */
+      q0 = x[0] - dQ;
+      q1 = a * q0 + u0;
+      if (a * q1 + u1 > 0.0)
+      {
+        q1 = -u1 / a;
+        q0 = (q1 - u0) / a;
+        if (q0 > x[0] + dQ)
+          q0 = x[0] + dQ;
+        else if (q0 < x[0] - dQ)
+          q0 = x[0] - dQ;
+      }
     }
+    q[0] = q0;
+    q[1] = q1;
+    qss->offset[i] = x[0] - q0;
   }
+  else
+  {
+    q[0] = x[0];
+    q[1] = x[1];
+    q[2] = x[2];
+    qss->offset[i] = 0.0;
+  }
+  qss->tq[i] = time;
+}
 
-  free(der);
-  free(stackPointer);
-  return OK;
+/*! static modelica_real nextTime(const QSS_DATA* qss, uinteger i, modelica_real time)
+ *  \brief  Returns the first time after time where x_i - q_i leaves the band
+ *          of width dQ around the offset after the last requantization.
+ *          x_i must be anchored at time.
+ */
+static modelica_real nextTime(const QSS_DATA* qss, uinteger i, modelica_real time)
+{
+  const modelica_real* x = qss->x + 4*i;
+  modelica_real q[3], d[4], dt;
+  modelica_real dQ = qss->dQ[i];
+  int k;
+
+  q[0] = qss->q[3*i];
+  q[1] = qss->q[3*i+1];
+  q[2] = qss->q[3*i+2];
+  shiftPoly(q, qss->order-1, time - qss->tq[i]);
+  for (k = 0; k < qss->order; k++)
+    d[k] = x[k] - q[k];
+  d[qss->order] = x[qss->order];
+  d[0] -= qss->offset[i];
+
+  if (isnan(d[0]))
+    return d[0];
+  if (fabs(d[0]) >= dQ)
+    return time;
+
+  d[0] -= dQ;
+  dt = minPositiveRoot(d, qss->order);
+  d[0] += 2.0 * dQ;
+  dt = fmin(dt, minPositiveRoot(d, qss->order));
+  return time + dt;
 }
 
+/*! static void emitStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time)
+ *  \brief  Evaluates the model with all states x(time) and emits the result.
+ */
+static void emitStates(DATA* data, threadData_t *threadData, QSS_DATA* qss, modelica_real time)
+{
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  SIMULATION_DATA *sData = (SIMULATION_DATA*)data->localData[0];
+  modelica_real* state = sData->realVars;
+  uinteger i;
+
+  for (i = 0; i < qss->n; i++)
+    state[i] = evalPoly(qss->x + 4*i, qss->order, time - qss->tx[i]);
 
-/*! static unsigned int minStep(const modelica_real* tqp, const unsigned int size )
- *  \brief  Finds the index of the state which will change first.
- *  \param [in] [tqp]  State[i] will change in time tqp[i].
- *  \param [in] [size]  Number of states.
- *  \return  Index of the state which will change first.
+  sData->timeValue = time;
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+  data->callback->functionAlgebraics(data, threadData);
+  data->callback->output_function(data, threadData);
+  data->callback->function_storeDelayed(data, threadData);
+
+  sim_result.emit(&sim_result, data, threadData);
+
+  if (0 != strcmp("ia", simInfo->outputFormat))
+  {
+    communicateStatus("Running", (time-simInfo->startTime)/(simInfo->stopTime-simInfo->startTime));
+  }
+}
+
+/*! static modelica_real evalPoly(const modelica_real* c, int order, modelica_real h)
+ *  \brief  Returns c[0] + c[1]*h + ... + c[order]*h^order.
  */
-static uinteger minStep(const modelica_real* tqp, const uinteger size )
+static modelica_real evalPoly(const modelica_real* c, int order, modelica_real h)
 {
-  uinteger i = 0;
-  uinteger ind = i;
-  modelica_real tmin =
-#if defined(_MSC_VER)
-      NAN;
-#else
-      1.0/0.0; /* We can have a QNAN at any index and tqp[i] < QNAN will fail in every case. */
-#endif
+  modelica_real res = c[order];
+  int k;
+  for (k = order-1; k >= 0; k--)
+    res = res * h + c[k];
+  return res;
+}
 
-  for (i = 0; i < size; i++)
+/*! static void shiftPoly(modelica_real* c, int order, modelica_real h)
+ *  \brief  Re-expands the polynomial c around h, i.e. c(t) becomes c(t+h).
+ */
+static void shiftPoly(modelica_real* c, int order, modelica_real h)
+{
+  int j, k;
+  if (h == 0.0)
+    return;
+  for (j = 0; j < order; j++)
+    for (k = order-1; k >= j; k--)
+      c[k] += h * c[k+1];
+}
+
+/*! static modelica_real minPositiveRoot(const modelica_real* c, int order)
+ *  \brief  Returns the smallest positive root of c[0] + ... + c[order]*h^order
+ *          for order <= 3, or DBL_MAX if there is none.
+ */
+static modelica_real minPositiveRoot(const modelica_real* c, int order)
+{
+  modelica_real r[3], res = DBL_MAX;
+  int n = 0, k, it;
+
+  while (order > 0 && c[order] == 0.0)
+    order--;
+
+  switch (order)
+  {
+  case 1:
+    r[n++] = -c[0] / c[1];
+    break;
+  case 2:
   {
-    if (tqp[i] < tmin && !isnan(tqp[i]))
+    modelica_real disc = c[1]*c[1] - 4.0*c[2]*c[0];
+    if (disc >= 0.0)
     {
-      ind = i;
-      tmin = tqp[i];
+      /* avoids the cancellation of -b + sqrt(disc) */
+      modelica_real t = -0.5 * (c[1] + (c[1] >= 0.0 ? sqrt(disc) : -sqrt(disc)));
+      if (t != 0.0)
+      {
+        r[n++] = t / c[2];
+        r[n++] = c[0] / t;
+      }
+      else
+        r[n++] = 0.0;
     }
+    break;
+  }
+  case 3:
+  {
+    /* x^3 + a x^2 + b x + cc, reduced to y^3 + p y + s with x = y - a/3 */
+    modelica_real a = c[2]/c[3], b = c[1]/c[3], cc = c[0]/c[3];
+    modelica_real p = b - a*a/3.0;
+    modelica_real s = 2.0*a*a*a/27.0 - a*b/3.0 + cc;
+    modelica_real disc = s*s/4.0 + p*p*p/27.0;
+    if (disc > 0.0)
+    {
+      modelica_real sq = sqrt(disc);
+      r[n++] = cbrt(-s/2.0 + sq) + cbrt(-s/2.0 - sq) - a/3.0;
+    }
+    else if (p == 0.0)
+    {
+      r[n++] = -a/3.0;
+    }
+    else
+    {
+      modelica_real m = 2.0*sqrt(-p/3.0);
+      modelica_real arg = 3.0*s/(p*m);
+      modelica_real phi = acos(fmax(-1.0, fmin(1.0, arg)))/3.0;
+      for (k = 0; k < 3; k++)
+        r[n++] = m*cos(phi - 2.0*M_PI*k/3.0) - a/3.0;
+    }
+    /* polish the roots, Cardano loses precision if c[3] is small */
+    for (k = 0; k < n; k++)
+    {
+      for (it = 0; it < 2; it++)
+      {
+        modelica_real v = ((c[3]*r[k] + c[2])*r[k] + c[1])*r[k] + c[0];
+        modelica_real dv = (3.0*c[3]*r[k] + 2.0*c[2])*r[k] + c[1];
+        if (dv != 0.0)
+          r[k] -= v/dv;
+      }
+    }
+    break;
+  }
+  }
+
+  for (k = 0; k < n; k++)
+  {
+    if (r[k] > 0.0 && r[k] < res)
+      res = r[k];
   }
-  return ind;
+  return res;
 }
@@ -52,6 +52,7 @@
 #if !defined(OMC_MINIMAL_RUNTIME)
 #include "simulation/solver/embedded_server.h"
 #include "simulation/solver/real_time_sync.h"
+#include "simulation/solver/initialization/snapshot.h"
 #endif
 
 /*! \fn updateContinuousSystem
@@ -223,6 +224,7 @@ static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt,
   embedded_server_update(data->embeddedServerState, data->localData[0]->timeValue);
   if (data->real_time_sync.enabled) {
     double time = data->localData[0]->timeValue;
+    double stepTime = rt_ext_tp_tock(&data->real_time_sync.stepClock);
     int64_t res = rt_ext_tp_sync_nanosec(&data->real_time_sync.clock, (uint64_t) (data->real_time_sync.scaling*(time-data->real_time_sync.time)*1e9));
     int64_t maxLateNano = data->simulationInfo->stepSize*1e9*0.1*data->real_time_sync.scaling /* Maximum late time: 10% of step size */;
     if (res > maxLateNano) {
@@ -231,9 +233,7 @@ static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt,
       const char *unit2 = prettyPrintNanoSec(maxLateNano, &tMaxLate);
       errorStreamPrint(LOG_RT, 0, "Missed deadline at time %g; delta was %d %s (maxLate=%d %s)", time, t, unit, tMaxLate, unit2);
     }
-    if (res > data->real_time_sync.maxLate) {
-      data->real_time_sync.maxLate = res;
-    }
+    omc_real_time_sync_step(data, stepTime, res, res > maxLateNano);
   }
 
   printAllVarsDebug(data, 0, LOG_DEBUG);  /* ??? */
@@ -256,11 +256,11 @@ static void fmtClose(MEASURE_TIME* mt)
 
 static void checkSimulationTerminated(DATA* data, SOLVER_INFO* solverInfo)
 {
-  if(terminationTerminate)
+  if(data->simulationInfo->terminationTerminate)
   {
-    printInfo(stdout, TermInfo);
+    printInfo(stdout, data->simulationInfo->terminationInfo);
     fputc('\n', stdout);
-    infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at time %f\nMessage : %s", data->localData[0]->timeValue, TermMsg);
+    infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at time %f\nMessage : %s", data->localData[0]->timeValue, data->simulationInfo->terminationMessage);
     data->simulationInfo->stopTime = solverInfo->currentTime;
   }
 }
@@ -333,6 +333,12 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
 
   modelica_boolean syncStep = 0;
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+  /* snapshots at or before the start time are written after the initialization */
+  double snapshotTime = omc_flag[FLAG_SAVE_SNAPSHOT] ? atof(omc_flagValue[FLAG_SAVE_SNAPSHOT]) : 0.0;
+  modelica_boolean snapshotPending = omc_flag[FLAG_SAVE_SNAPSHOT] && snapshotTime > simInfo->startTime;
+#endif
+
   /***** Start main simulation loop *****/
   while(solverInfo->currentTime < simInfo->stopTime || !simInfo->useStopTime)
   {
@@ -411,6 +417,16 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
       saveIntegratorStats(solverInfo);
       checkSimulationTerminated(data, solverInfo);
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+      if (snapshotPending && solverInfo->currentTime >= snapshotTime) {
+        char *snapshotFile = (char*) malloc(strlen(data->modelData->modelFilePrefix) + 14);
+        sprintf(snapshotFile, "%s_snapshot.bin", data->modelData->modelFilePrefix);
+        writeSnapshot(data, threadData, snapshotFile);
+        free(snapshotFile);
+        snapshotPending = 0;
+      }
+#endif
+
       /* terminate for some cases:
        * - integrator fails
        * - non-linear system failed to solve
@@ -0,0 +1,158 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*
+ * Benchmark of the QSS methods in perform_qss_simulation.c on a chain of
+ * n states (default 10^4)
+ *
+ *   der(x[1]) = 1 - x[1], der(x[i]) = x[i-1] - x[i], x(0) = 0
+ *
+ * with the exact solution x[i](t) = 1 - exp(-t)*sum(t^k/k!, k = 0..i-1).
+ * Only the first few states move, which is the kind of model QSS is meant
+ * for: a state is only updated when it changes by its quantum. The table
+ * shows the calls of functionODE, the time and the largest error over all
+ * states at the 500 output points until t = 10 (-qssGridOutput).
+ *
+ * Build with "make qss-benchmark" in SimulationRuntime/c, after the
+ * runtime libraries are built; run it as "./qss-benchmark [n]".
+ */
+
+/* included like in the generated code */
+#include "model_help.h"
+#include "linearSystem.h"
+#include "nonlinearSystem.h"
+#include "mixedSystem.h"
+#define prefixedName_performQSSSimulation benchmark_performQSSSimulation
+#include "perform_qss_simulation.c"
+
+#include <math.h>
+#include <time.h>
+
+#include "simulation/test/test_model.h"
+
+static int n;
+static long nCalls;
+static double maxError;
+static int nOutputs;
+
+static int chainODE(DATA *data, threadData_t *threadData)
+{
+  const double *x = data->localData[0]->realVars;
+  double *der = data->localData[0]->realVars + n;
+  int i;
+
+  der[0] = 1.0 - x[0];
+  for (i = 1; i < n; i++) {
+    der[i] = x[i-1] - x[i];
+  }
+  nCalls++;
+  return 0;
+}
+
+/* the largest error of the states x at time t */
+static double chainError(double t, const double *x)
+{
+  double term = exp(-t), sum = 0.0, err = 0.0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    sum += term;
+    err = fmax(err, fabs(x[i] - (1.0 - sum)));
+    term *= t/(i+1);
+  }
+  return err;
+}
+
+static void emitError(simulation_result *result, DATA *data, threadData_t *threadData)
+{
+  maxError = fmax(maxError, chainError(data->localData[0]->timeValue, data->localData[0]->realVars));
+  nOutputs++;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static void report(const char *method, double seconds)
+{
+  printf("%-8s %12ld %10.3f %12.3e %8d\n", method, nCalls, seconds, maxError, nOutputs);
+}
+
+static int runQSS(const char *method)
+{
+  TEST_MODEL model;
+  double t;
+  int rc;
+
+  initTestModel(&model, n, chainODE, 0.0, 10.0, 1e-6);
+  setTestModelBandPattern(&model, 1, 0);
+  omc_flag[FLAG_QSS_METHOD] = 1;
+  omc_flagValue[FLAG_QSS_METHOD] = method;
+  omc_flag[FLAG_QSS_GRID_OUTPUT] = 1;
+  sim_result.emit = emitError;
+  nCalls = 0;
+  maxError = 0.0;
+  nOutputs = 0;
+
+  t = now();
+  rc = benchmark_performQSSSimulation(&model.data, &model.threadData, &model.solverInfo);
+  t = now() - t;
+  report(method, t);
+
+  freeTestModel(&model);
+  return rc;
+}
+
+int main(int argc, char **argv)
+{
+  static const char *methods[] = {"qss1", "qss2", "qss3", "liqss2"};
+  int i;
+
+  n = argc > 1 ? atoi(argv[1]) : 10000;
+  if (n < 1) {
+    fprintf(stderr, "usage: %s [number of states]\n", argv[0]);
+    return 1;
+  }
+
+  mmc_init_nogc();
+
+  printf("chain of %d states until t = 10\n", n);
+  printf("%-8s %12s %10s %12s %8s\n", "method", "functionODE", "time [s]", "max error", "outputs");
+  for (i = 0; i < sizeof(methods)/sizeof(methods[0]); i++) {
+    if (runQSS(methods[i])) {
+      printf("%s failed\n", methods[i]);
+    }
+  }
+  return 0;
+}
@@ -70,13 +70,11 @@ static int boundsVars(KINODE *kinOde);
 
 static int radau1Coeff(KINODE *kinOd);
 static int radau3Coeff(KINODE *kinOde);
-static int radau5Coeff(KINODE *kinOd);
 static int lobatto4Coeff(KINODE *kinOd);
 static int lobatto6Coeff(KINODE *kinOd);
 
 static int radau1Res(N_Vector z, N_Vector f, void* user_data);
 static int radau3Res(N_Vector z, N_Vector f, void* user_data);
-static int radau5Res(N_Vector z, N_Vector f, void* user_data);
 static int lobatto2Res(N_Vector z, N_Vector f, void* user_data);
 static int lobatto4Res(N_Vector z, N_Vector f, void* user_data);
 static int lobatto6Res(N_Vector z, N_Vector f, void* user_data);
@@ -111,9 +109,6 @@ int allocateKinOde(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
   KINSetInfoHandlerFn(kinOde->kData->kmem, kinsol_infoHandler, NULL);
   switch(kinOde->flag)
   {
-    case S_RADAU5:
-      KINInit(kinOde->kData->kmem, radau5Res, kinOde->kData->x);
-      break;
     case S_RADAU3:
       KINInit(kinOde->kData->kmem, radau3Res, kinOde->kData->x);
       break;
@@ -151,9 +146,6 @@ static int allocateNlpOde(KINODE *kinOde)
 
   switch(kinOde->flag)
   {
-  case S_RADAU5:
-    radau5Coeff(kinOde);
-    break;
   case S_RADAU3:
     radau3Coeff(kinOde);
     break;
@@ -211,39 +203,6 @@ static int boundsVars(KINODE *kinOde)
   return 0;
 }
 
-static int radau5Coeff(KINODE *kinOde)
-{
-  int i;
-  const int N = 3;
-  NLPODE * nlp = (NLPODE*) kinOde->nlp;
-
-  nlp->c = (long double**) malloc(N * sizeof(long double*));
-  for(i = 0; i < N; i++)
-    nlp->c[i] = (long double*) calloc(N+1, sizeof(long double));
-
-  nlp->a = (double*) malloc(N * sizeof(double));
-
-  nlp->c[0][0] = 4.1393876913398137178367408896470696703591369767880;
-  nlp->c[0][1] = 3.2247448713915890490986420373529456959829737403284;
-  nlp->c[0][2] = 1.1678400846904054949240412722156950122337492313015;
-  nlp->c[0][3] = 0.25319726474218082618594241992157103785758599484179;
-
-  nlp->c[1][0] = 1.7393876913398137178367408896470696703591369767880;
-  nlp->c[1][1] = 3.5678400846904054949240412722156950122337492313015;
-  nlp->c[1][2] = 0.7752551286084109509013579626470543040170262596716;
-  nlp->c[1][3] = 1.0531972647421808261859424199215710378575859948418;
-
-  nlp->c[2][0] = 3.0;
-  nlp->c[2][1] = 5.5319726474218082618594241992157103785758599484179;
-  nlp->c[2][2] = 7.5319726474218082618594241992157103785758599484179;
-  nlp->c[2][3] = 5.0;
-
-  nlp->a[0]    = 0.15505102572168219018027159252941086080340525193433;
-  nlp->a[1]    = 0.64494897427831780981972840747058913919659474806567;
-  nlp->a[2]    = 1.0;
-  return 0;
-}
-
 static int radau3Coeff(KINODE *kinOde)
 {
   int i;
@@ -446,50 +405,6 @@ static int refreshModell(DATA* data, threadData_t *threadData, double* x, double
   return 0;
 }
 
-static int radau5Res(N_Vector x, N_Vector f, void* user_data)
-{
-  int i,k;
-  KINODE* kinOde = (KINODE*)user_data;
-  NLPODE *nlp = kinOde->nlp;
-  threadData_t *threadData = kinOde->threadData;
-
-  double *x0,*x1,*x2,*x3;
-  double*derx = nlp->derx;
-  double*a = nlp->a;
-  double* feq = NV_DATA_S(f);
-
-  x0 = nlp->x0;
-  x1 = NV_DATA_S(x);
-  x2 = x1 + nlp->nStates;
-  x3 = x2 + nlp->nStates;
-
-  refreshModell(kinOde->data, threadData, x1, nlp->t0 + a[0]*nlp->dt);
-  for(i = 0;i<nlp->nStates;i++)
-  {
-    feq[i] = (nlp->c[0][0]*x0[i] + nlp->c[0][3]*x3[i] + nlp->dt*derx[i]) -
-             (nlp->c[0][1]*x1[i] + nlp->c[0][2]*x2[i]);
-    if(isnan(feq[i])) return -1;
-  }
-
-  refreshModell(kinOde->data, threadData, x2, nlp->t0 + a[1]*nlp->dt);
-  for(i = 0, k=nlp->nStates; i<nlp->nStates; i++, k++)
-  {
-    feq[k] = (nlp->c[1][1]*x1[i] + nlp->dt*derx[i]) -
-                (nlp->c[1][0]*x0[i] + nlp->c[1][2]*x2[i] + nlp->c[1][3]*x3[i]);
-   if(isnan(feq[k])) return -1;
-  }
-
-  refreshModell(kinOde->data, threadData, x3, nlp->t0 + nlp->dt);
-  for(i = 0;i<nlp->nStates;i++,k++)
-  {
-    feq[k] =  (nlp->c[2][0]*x0[i] + nlp->c[2][2]*x2[i] + nlp->dt*derx[i]) -
-                 (nlp->c[2][1]*x1[i] + nlp->c[2][3]*x3[i]);
-    if(isnan(feq[k])) return -1;
-  }
-
-  return 0;
-}
-
 static int radau3Res(N_Vector x, N_Vector f, void* user_data)
 {
   int i,k;
@@ -0,0 +1,1144 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file radau5.c
+ *
+ *  Implicit Runge-Kutta method Radau IIA of order 5, following the
+ *  Fortran code RADAU5 of E. Hairer and G. Wanner:
+ *  "Solving Ordinary Differential Equations II. Stiff and
+ *  Differential-Algebraic Problems", Springer, 1996.
+ *
+ *  The stage equations are solved with a simplified Newton iteration on the
+ *  transformed system, which needs one real and one complex decomposition
+ *  of size nStates per step size. The Jacobian is approximated by colored
+ *  finite differences and is reused as long as the Newton iteration
+ *  converges fast. The step size is controlled with the embedded error
+ *  estimate and the predictive controller of Gustafsson. The integrator
+ *  takes its own steps across the output grid, output points are
+ *  interpolated with the collocation polynomial and state events are
+ *  located on it as well.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <float.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+
+#include "util/omc_error.h"
+#include "gc/omc_gc.h"
+
+#include "simulation/options.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/solver/solver_main.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/external_input.h"
+#include "simulation/solver/epsilon.h"
+
+#include "simulation/solver/radau5.h"
+#include "meta/meta_modelica.h"
+
+extern void dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern void dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+extern void zgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern void zgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+
+/* collocation points and error estimate */
+static const double RADAU5_C1 = 0.15505102572168222;   /* (4-sqrt(6))/10 */
+static const double RADAU5_C2 = 0.64494897427831781;   /* (4+sqrt(6))/10 */
+static const double RADAU5_DD1 = -10.048809399827414;  /* -(13+7*sqrt(6))/3 */
+static const double RADAU5_DD2 = 1.3821427331607489;   /* (-13+7*sqrt(6))/3 */
+static const double RADAU5_DD3 = -1.0/3.0;
+
+/* eigenvalues of the inverse coefficient matrix */
+static const double RADAU5_U1 = 3.6378342527444962;
+static const double RADAU5_ALPH = 2.6810828736277523;
+static const double RADAU5_BETA = 3.0504301992474105;
+
+/* transformation to block diagonal form T and its inverse TI */
+static const double T11 = 9.1232394870892942792e-02;
+static const double T12 = -0.14125529502095420843;
+static const double T13 = -3.0029194105147424492e-02;
+static const double T21 = 0.24171793270710701896;
+static const double T22 = 0.20412935229379993199;
+static const double T23 = 0.38294211275726193779;
+static const double T31 = 0.96604818261509293619;
+
+static const double TI11 = 4.3255798900631553510;
+static const double TI12 = 0.33919925181580986954;
+static const double TI13 = 0.54177053993587487119;
+static const double TI21 = -4.1787185915519047273;
+static const double TI22 = -0.32768282076106238708;
+static const double TI23 = 0.47662355450055045196;
+static const double TI31 = -0.50287263494578687595;
+static const double TI32 = 2.5719269498556054292;
+static const double TI33 = -0.59603920482822492497;
+
+/* parameters of the Newton iteration and the step size control */
+static const int RADAU5_NIT = 7;          /* maximum number of Newton iterations */
+static const double RADAU5_THET = 0.001;  /* reuse the Jacobian if the contraction is below */
+static const double RADAU5_SAFE = 0.9;    /* safety factor */
+static const double RADAU5_FACL = 5.0;    /* 1/FACL <= hnew/hold */
+static const double RADAU5_FACR = 0.125;  /* hnew/hold <= 1/FACR */
+static const double RADAU5_QUOT1 = 1.0;   /* keep the step size if QUOT1 <= hnew/hold <= QUOT2 */
+static const double RADAU5_QUOT2 = 1.2;
+static const int RADAU5_MAX_SINGULAR = 5; /* maximum number of consecutive singular matrices */
+
+/*! \fn radau5_f
+ *
+ *  evaluates the state derivatives f(t, y)
+ */
+static void radau5_f(DATA* data, threadData_t *threadData, DATA_RADAU5* rd, double t, const double* y, double* f)
+{
+  SIMULATION_DATA *sData = data->localData[0];
+  int ctx = data->simulationInfo->currentContext == CONTEXT_ALGEBRAIC;
+
+  if (ctx)
+  {
+    setContext(data, &t, CONTEXT_ODE);
+  }
+
+  memcpy(sData->realVars, y, rd->n*sizeof(double));
+  sData->timeValue = t;
+
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+
+  memcpy(f, sData->realVars + rd->n, rd->n*sizeof(double));
+  rd->evalFunctionODE++;
+
+  if (ctx)
+  {
+    unsetContext(data);
+  }
+}
+
+/*! \fn radau5_zeroCrossings
+ *
+ *  evaluates the zero crossing functions at (t, y)
+ */
+static void radau5_zeroCrossings(DATA* data, threadData_t *threadData, DATA_RADAU5* rd, double t, const double* y, double* gout)
+{
+  SIMULATION_DATA *sData = data->localData[0];
+  int saveJumpState = threadData->currentErrorStage;
+  int ctx = data->simulationInfo->currentContext == CONTEXT_ALGEBRAIC;
+
+  if (ctx)
+  {
+    setContext(data, &t, CONTEXT_EVENTS);
+  }
+  threadData->currentErrorStage = ERROR_EVENTSEARCH;
+
+  memcpy(sData->realVars, y, rd->n*sizeof(double));
+  sData->timeValue = t;
+
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->function_ZeroCrossingsEquations(data, threadData);
+  data->callback->function_ZeroCrossings(data, threadData, gout);
+
+  threadData->currentErrorStage = saveJumpState;
+  if (ctx)
+  {
+    unsetContext(data);
+  }
+}
+
+/*! \fn radau5_initPattern
+ *
+ *  sets up the sparsity pattern of the Jacobian in compressed column format
+ *  including all diagonal elements, either from the generated sparse pattern
+ *  of jacobian A or dense if that is not available.
+ */
+static void radau5_initPattern(DATA* data, threadData_t *threadData, DATA_RADAU5* rd)
+{
+  const int n = rd->n;
+  int i, j, k, l, nnz;
+  int hasDiag;
+  SPARSE_PATTERN *pattern = NULL;
+
+  if (0 == data->callback->initialAnalyticJacobianA(data, threadData))
+  {
+    pattern = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+  }
+  else
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "radau5: sparse pattern not available, use dense finite differences");
+  }
+
+  rd->colPtr = (int*) malloc((n+1)*sizeof(int));
+  rd->diagIdx = (int*) malloc(n*sizeof(int));
+  rd->colorCols = (unsigned int*) malloc(n*sizeof(unsigned int));
+
+  if (pattern)
+  {
+    rd->rowIdx = (int*) malloc((pattern->numberOfNoneZeros + n)*sizeof(int));
+    rd->structural = (int*) malloc((pattern->numberOfNoneZeros + n)*sizeof(int));
+    rd->nColors = pattern->maxColors;
+    memcpy(rd->colorCols, pattern->colorCols, n*sizeof(unsigned int));
+
+    for (j=0, nnz=0; j<n; j++)
+    {
+      rd->colPtr[j] = nnz;
+      hasDiag = 0;
+      for (k = j ? (int)pattern->leadindex[j-1] : 0; k < (int)pattern->leadindex[j]; k++)
+      {
+        rd->rowIdx[nnz] = pattern->index[k];
+        rd->structural[nnz] = 1;
+        hasDiag |= (int)pattern->index[k] == j;
+        nnz++;
+      }
+      if (!hasDiag)
+      {
+        rd->rowIdx[nnz] = j;
+        rd->structural[nnz] = 0;
+        nnz++;
+      }
+      /* sort the column by row indices */
+      for (k = rd->colPtr[j]+1; k < nnz; k++)
+      {
+        for (l = k; l > rd->colPtr[j] && rd->rowIdx[l-1] > rd->rowIdx[l]; l--)
+        {
+          i = rd->rowIdx[l]; rd->rowIdx[l] = rd->rowIdx[l-1]; rd->rowIdx[l-1] = i;
+          i = rd->structural[l]; rd->structural[l] = rd->structural[l-1]; rd->structural[l-1] = i;
+        }
+      }
+    }
+    rd->colPtr[n] = nnz;
+  }
+  else
+  {
+    rd->rowIdx = (int*) malloc(n*n*sizeof(int));
+    rd->structural = (int*) malloc(n*n*sizeof(int));
+    rd->nColors = n;
+    for (j=0, nnz=0; j<n; j++)
+    {
+      rd->colPtr[j] = nnz;
+      rd->colorCols[j] = j+1;
+      for (i=0; i<n; i++, nnz++)
+      {
+        rd->rowIdx[nnz] = i;
+        rd->structural[nnz] = 1;
+      }
+    }
+    rd->colPtr[n] = nnz;
+  }
+  rd->nnz = nnz;
+
+  for (j=0; j<n; j++)
+  {
+    for (k = rd->colPtr[j]; k < rd->colPtr[j+1]; k++)
+    {
+      if (rd->rowIdx[k] == j)
+      {
+        rd->diagIdx[j] = k;
+      }
+    }
+  }
+
+  rd->jac = (double*) calloc(nnz, sizeof(double));
+}
+
+/*! \fn allocateRadau5
+ *
+ *  allocates the memory of the integrator and decides between
+ *  the dense and the sparse linear algebra
+ */
+int allocateRadau5(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  DATA_RADAU5* rd = (DATA_RADAU5*) calloc(1, sizeof(DATA_RADAU5));
+  const int n = data->modelData->nStates;
+  double tol = data->simulationInfo->tolerance;
+  double density;
+  int i;
+
+  solverInfo->solverData = (void*) rd;
+  solverInfo->solverRootFinding = 1;
+  data->simulationInfo->currentContext = CONTEXT_ALGEBRAIC;
+
+  rd->n = n;
+  rd->y = (double*) calloc(n, sizeof(double));
+  rd->fx = (double*) calloc(n, sizeof(double));
+  rd->z1 = (double*) calloc(n, sizeof(double));
+  rd->z2 = (double*) calloc(n, sizeof(double));
+  rd->z3 = (double*) calloc(n, sizeof(double));
+  rd->f1 = (double*) calloc(n, sizeof(double));
+  rd->f2 = (double*) calloc(n, sizeof(double));
+  rd->f3 = (double*) calloc(n, sizeof(double));
+  rd->cont = (double*) calloc(4*n, sizeof(double));
+  rd->scal = (double*) calloc(n, sizeof(double));
+  rd->work = (double*) calloc(n, sizeof(double));
+  rd->fwork = (double*) calloc(n, sizeof(double));
+  rd->rhs = (double*) calloc(2*n, sizeof(double));
+  rd->atol = (double*) calloc(n, sizeof(double));
+
+  /* transform the tolerances, the error estimate is of order 3 */
+  rd->rtol = 0.1 * pow(tol, 2.0/3.0);
+  for (i=0; i<n; i++)
+  {
+    rd->atol[i] = rd->rtol * fmax(fabs(data->modelData->realVarsData[i].attribute.nominal), 1e-32);
+  }
+  rd->fnewt = fmax(10.0*DBL_EPSILON/rd->rtol, fmin(0.03, sqrt(rd->rtol)));
+
+  rd->hmax = data->simulationInfo->stopTime - data->simulationInfo->startTime;
+  if (rd->hmax <= 0)
+  {
+    rd->hmax = DBL_MAX;
+  }
+  if (omc_flag[FLAG_MAX_STEP_SIZE])
+  {
+    rd->hmax = atof(omc_flagValue[FLAG_MAX_STEP_SIZE]);
+    assertStreamPrint(threadData, rd->hmax >= MINIMAL_STEP_SIZE, "Selected maximum step size %e is too small.", rd->hmax);
+    infoStreamPrint(LOG_SOLVER, 0, "maximum step size %g", rd->hmax);
+  }
+  if (omc_flag[FLAG_INITIAL_STEP_SIZE])
+  {
+    rd->hinit = atof(omc_flagValue[FLAG_INITIAL_STEP_SIZE]);
+    assertStreamPrint(threadData, rd->hinit >= MINIMAL_STEP_SIZE, "Selected initial step size %e is too small.", rd->hinit);
+    infoStreamPrint(LOG_SOLVER, 0, "initial step size %g", rd->hinit);
+  }
+
+  radau5_initPattern(data, threadData, rd);
+  density = n > 0 ? rd->nnz/((double)n*n) : 1.0;
+
+#ifdef WITH_UMFPACK
+  rd->useSparse = density <= linearSparseSolverMaxDensity && n >= linearSparseSolverMinSize;
+#else
+  rd->useSparse = 0;
+#endif
+
+  if (rd->useSparse)
+  {
+#ifdef WITH_UMFPACK
+    infoStreamPrint(LOG_SOLVER, 0, "radau5: using KLU, density of the iteration matrix %.2f, size %d", density, n);
+    rd->e1x = (double*) calloc(rd->nnz, sizeof(double));
+    rd->e2x = (double*) calloc(2*rd->nnz, sizeof(double));
+    klu_defaults(&rd->common);
+    rd->symbolic = klu_analyze(n, rd->colPtr, rd->rowIdx, &rd->common);
+    assertStreamPrint(threadData, NULL != rd->symbolic, "radau5: symbolic analysis of the iteration matrix failed");
+#endif
+  }
+  else
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "radau5: using dense LAPACK, density of the iteration matrix %.2f, size %d", density, n);
+    rd->e1 = (double*) calloc(n*n, sizeof(double));
+    rd->e2 = (double*) calloc(2*n*n, sizeof(double));
+    rd->ipiv1 = (int*) calloc(n, sizeof(int));
+    rd->ipiv2 = (int*) calloc(n, sizeof(int));
+  }
+
+  rd->nZeroCrossings = data->modelData->nZeroCrossings;
+  rd->zcOld = (double*) calloc(rd->nZeroCrossings, sizeof(double));
+  rd->zcNew = (double*) calloc(rd->nZeroCrossings, sizeof(double));
+  rd->zcLeft = (double*) calloc(rd->nZeroCrossings, sizeof(double));
+  rd->zcMid = (double*) calloc(rd->nZeroCrossings, sizeof(double));
+
+  rd->restart = 1;
+
+  return 0;
+}
+
+/*! \fn freeRadau5
+ *
+ *  frees the memory of the integrator
+ */
+int freeRadau5(SOLVER_INFO* solverInfo)
+{
+  DATA_RADAU5* rd = (DATA_RADAU5*) solverInfo->solverData;
+
+#ifdef WITH_UMFPACK
+  if (rd->useSparse)
+  {
+    if (rd->numeric1)
+      klu_free_numeric(&rd->numeric1, &rd->common);
+    if (rd->numeric2)
+      klu_z_free_numeric(&rd->numeric2, &rd->common);
+    if (rd->symbolic)
+      klu_free_symbolic(&rd->symbolic, &rd->common);
+  }
+#endif
+
+  free(rd->y);
+  free(rd->fx);
+  free(rd->z1);
+  free(rd->z2);
+  free(rd->z3);
+  free(rd->f1);
+  free(rd->f2);
+  free(rd->f3);
+  free(rd->cont);
+  free(rd->scal);
+  free(rd->work);
+  free(rd->fwork);
+  free(rd->rhs);
+  free(rd->atol);
+
+  free(rd->colPtr);
+  free(rd->rowIdx);
+  free(rd->diagIdx);
+  free(rd->structural);
+  free(rd->colorCols);
+  free(rd->jac);
+
+  free(rd->e1);
+  free(rd->e2);
+  free(rd->ipiv1);
+  free(rd->ipiv2);
+  free(rd->e1x);
+  free(rd->e2x);
+
+  free(rd->zcOld);
+  free(rd->zcNew);
+  free(rd->zcLeft);
+  free(rd->zcMid);
+
+  free(rd);
+
+  return 0;
+}
+
+/*! \fn radau5_jacobian
+ *
+ *  approximates the Jacobian at (t, y) by colored finite differences
+ */
+static void radau5_jacobian(DATA* data, threadData_t *threadData, DATA_RADAU5* rd)
+{
+  const int n = rd->n;
+  unsigned int color;
+  int j, k;
+
+  setContext(data, &rd->t, CONTEXT_JACOBIAN);
+
+  memcpy(rd->work, rd->y, n*sizeof(double));
+  for (color=1; color<=rd->nColors; color++)
+  {
+    for (j=0; j<n; j++)
+    {
+      if (rd->colorCols[j] == color)
+      {
+        rd->work[j] = rd->y[j] + sqrt(DBL_EPSILON*fmax(1e-5, fabs(rd->y[j])));
+      }
+    }
+
+    radau5_f(data, threadData, rd, rd->t, rd->work, rd->fwork);
+    increaseJacContext(data);
+
+    for (j=0; j<n; j++)
+    {
+      if (rd->colorCols[j] == color)
+      {
+        double delta = rd->work[j] - rd->y[j];
+        for (k = rd->colPtr[j]; k < rd->colPtr[j+1]; k++)
+        {
+          if (rd->structural[k])
+          {
+            rd->jac[k] = (rd->fwork[rd->rowIdx[k]] - rd->fx[rd->rowIdx[k]]) / delta;
+          }
+        }
+        rd->work[j] = rd->y[j];
+      }
+    }
+  }
+
+  unsetContext(data);
+  rd->evalJacobian++;
+}
+
+/*! \fn radau5_decomposition
+ *
+ *  builds and decomposes the real iteration matrix E1 = fac1*I - J
+ *  and the complex iteration matrix E2 = (alphn + i*betan)*I - J
+ *
+ *  \return 0 on success, else the matrix is singular
+ */
+static int radau5_decomposition(DATA_RADAU5* rd, double fac1, double alphn, double betan)
+{
+  int n = rd->n;
+  int j, k, info = 0;
+
+  if (rd->useSparse)
+  {
+#ifdef WITH_UMFPACK
+    for (k=0; k<rd->nnz; k++)
+    {
+      rd->e1x[k] = -rd->jac[k];
+      rd->e2x[2*k] = -rd->jac[k];
+      rd->e2x[2*k+1] = 0.0;
+    }
+    for (j=0; j<n; j++)
+    {
+      k = rd->diagIdx[j];
+      rd->e1x[k] += fac1;
+      rd->e2x[2*k] += alphn;
+      rd->e2x[2*k+1] += betan;
+    }
+
+    if (rd->numeric1)
+      klu_free_numeric(&rd->numeric1, &rd->common);
+    if (rd->numeric2)
+      klu_z_free_numeric(&rd->numeric2, &rd->common);
+
+    rd->numeric1 = klu_factor(rd->colPtr, rd->rowIdx, rd->e1x, rd->symbolic, &rd->common);
+    if (NULL == rd->numeric1 || rd->common.status == KLU_SINGULAR)
+      return 1;
+    rd->numeric2 = klu_z_factor(rd->colPtr, rd->rowIdx, rd->e2x, rd->symbolic, &rd->common);
+    if (NULL == rd->numeric2 || rd->common.status == KLU_SINGULAR)
+      return 1;
+#endif
+  }
+  else
+  {
+    memset(rd->e1, 0, n*n*sizeof(double));
+    memset(rd->e2, 0, 2*n*n*sizeof(double));
+    for (j=0; j<n; j++)
+    {
+      for (k = rd->colPtr[j]; k < rd->colPtr[j+1]; k++)
+      {
+        rd->e1[rd->rowIdx[k] + j*n] = -rd->jac[k];
+        rd->e2[2*(rd->rowIdx[k] + j*n)] = -rd->jac[k];
+      }
+      rd->e1[j + j*n] += fac1;
+      rd->e2[2*(j + j*n)] += alphn;
+      rd->e2[2*(j + j*n)+1] += betan;
+    }
+
+    dgetrf_(&n, &n, rd->e1, &n, rd->ipiv1, &info);
+    if (info != 0)
+      return 1;
+    zgetrf_(&n, &n, rd->e2, &n, rd->ipiv2, &info);
+    if (info != 0)
+      return 1;
+  }
+
+  return 0;
+}
+
+/*! \fn radau5_solveReal
+ *
+ *  solves E1*x = b, b is overwritten with the solution
+ */
+static void radau5_solveReal(DATA_RADAU5* rd, double* b)
+{
+  int n = rd->n, nrhs = 1, info = 0;
+  char trans = 'N';
+
+  if (rd->useSparse)
+  {
+#ifdef WITH_UMFPACK
+    klu_solve(rd->symbolic, rd->numeric1, n, 1, b, &rd->common);
+#endif
+  }
+  else
+  {
+    dgetrs_(&trans, &n, &nrhs, rd->e1, &n, rd->ipiv1, b, &n, &info);
+  }
+}
+
+/*! \fn radau5_solveComplex
+ *
+ *  solves E2*(x + i*y) = (br + i*bi), br and bi are overwritten with the solution
+ */
+static void radau5_solveComplex(DATA_RADAU5* rd, double* br, double* bi)
+{
+  int n = rd->n, nrhs = 1, info = 0;
+  char trans = 'N';
+  int i;
+
+  for (i=0; i<n; i++)
+  {
+    rd->rhs[2*i] = br[i];
+    rd->rhs[2*i+1] = bi[i];
+  }
+
+  if (rd->useSparse)
+  {
+#ifdef WITH_UMFPACK
+    klu_z_solve(rd->symbolic, rd->numeric2, n, 1, rd->rhs, &rd->common);
+#endif
+  }
+  else
+  {
+    zgetrs_(&trans, &n, &nrhs, rd->e2, &n, rd->ipiv2, rd->rhs, &n, &info);
+  }
+
+  for (i=0; i<n; i++)
+  {
+    br[i] = rd->rhs[2*i];
+    bi[i] = rd->rhs[2*i+1];
+  }
+}
+
+/*! \fn radau5_interpolate
+ *
+ *  evaluates the collocation polynomial of the last step at time t
+ */
+static void radau5_interpolate(DATA_RADAU5* rd, double t, double* y)
+{
+  const int n = rd->n;
+  const double s = (t - rd->t) / rd->hOld;
+  int i;
+
+  for (i=0; i<n; i++)
+  {
+    y[i] = rd->cont[i] + s*(rd->cont[i+n] + (s - RADAU5_C2 + 1.0)*(rd->cont[i+2*n] + (s - RADAU5_C1 + 1.0)*rd->cont[i+3*n]));
+  }
+}
+
+/*! \fn radau5_norm
+ *
+ *  weighted root mean square norm
+ */
+static double radau5_norm(DATA_RADAU5* rd, const double* x)
+{
+  double sum = 0.0;
+  int i;
+
+  for (i=0; i<rd->n; i++)
+  {
+    sum += (x[i]/rd->scal[i]) * (x[i]/rd->scal[i]);
+  }
+
+  return rd->n > 0 ? sqrt(sum/rd->n) : 0.0;
+}
+
+/*! \fn radau5_errorEstimate
+ *
+ *  computes the embedded error estimate of the step (t, t+h)
+ */
+static double radau5_errorEstimate(DATA* data, threadData_t *threadData, DATA_RADAU5* rd)
+{
+  const int n = rd->n;
+  const double hee1 = RADAU5_DD1/rd->h, hee2 = RADAU5_DD2/rd->h, hee3 = RADAU5_DD3/rd->h;
+  double err;
+  int i;
+
+  for (i=0; i<n; i++)
+  {
+    rd->f2[i] = hee1*rd->z1[i] + hee2*rd->z2[i] + hee3*rd->z3[i];
+    rd->cont[i] = rd->f2[i] + rd->fx[i];
+  }
+  radau5_solveReal(rd, rd->cont);
+  err = fmax(radau5_norm(rd, rd->cont), 1e-10);
+
+  /* the estimate is not reliable for stiff components in the first or a rejected step */
+  if (err >= 1.0 && (rd->first || rd->reject))
+  {
+    for (i=0; i<n; i++)
+    {
+      rd->work[i] = rd->y[i] + rd->cont[i];
+    }
+    radau5_f(data, threadData, rd, rd->t, rd->work, rd->f1);
+    for (i=0; i<n; i++)
+    {
+      rd->cont[i] = rd->f1[i] + rd->f2[i];
+    }
+    radau5_solveReal(rd, rd->cont);
+    err = fmax(radau5_norm(rd, rd->cont), 1e-10);
+  }
+
+  return err;
+}
+
+/*! \fn radau5_restart
+ *
+ *  (re)starts the integration at the current time, e.g. after an event
+ */
+static void radau5_restart(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DATA_RADAU5* rd)
+{
+  const int n = rd->n;
+  double d0, d1;
+  int i;
+
+  memcpy(rd->y, data->localData[1]->realVars, n*sizeof(double));
+  rd->t = solverInfo->currentTime;
+  rd->tOld = rd->t;
+  rd->hOld = 0.0;
+
+  for (i=0; i<n; i++)
+  {
+    rd->scal[i] = rd->atol[i] + rd->rtol*fabs(rd->y[i]);
+  }
+
+  rd->restart = 0;
+  rd->first = 1;
+  rd->reject = 0;
+  rd->caljac = 0;
+  rd->needJac = 1;
+  rd->needDecomp = 1;
+  rd->nsing = 0;
+  rd->theta = 0.0;
+  rd->faccon = 1.0;
+  rd->hacc = 0.0;
+  rd->erracc = 1.0;
+  rd->rootFound = 0;
+
+  rd->stepsDone = 0;
+  rd->evalFunctionODE = 0;
+  rd->evalJacobian = 0;
+  rd->errorTestFailures = 0;
+  rd->convergenceFailures = 0;
+
+  radau5_f(data, threadData, rd, rd->t, rd->y, rd->fx);
+  if (rd->nZeroCrossings > 0)
+  {
+    radau5_zeroCrossings(data, threadData, rd, rd->t, rd->y, rd->zcOld);
+  }
+
+  if (rd->hinit > 0)
+  {
+    rd->h = rd->hinit;
+  }
+  else
+  {
+    d0 = radau5_norm(rd, rd->y);
+    d1 = radau5_norm(rd, rd->fx);
+    rd->h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+  }
+  rd->h = fmin(rd->h, rd->hmax);
+
+  infoStreamPrint(LOG_SOLVER, 0, "radau5: restart at time %g with step size %g", rd->t, rd->h);
+}
+
+/*! \fn radau5_doStep
+ *
+ *  performs one accepted step, which does not pass limit
+ *
+ *  \return 0 on success, else the step size became too small
+ */
+static int radau5_doStep(DATA* data, threadData_t *threadData, DATA_RADAU5* rd, double limit)
+{
+  const int n = rd->n;
+  const double cfac = RADAU5_SAFE*(1 + 2*RADAU5_NIT);
+  double fac1, alphn, betan, c3q, c1q, c2q, ak1, ak2, ak3, a1, a2, a3, s2, s3;
+  double dyno, dynold = 0.0, thq, thqold = 0.0, dyth, qnewt, err, fac, quot, hnew, facgus;
+  int i, newt, converged;
+
+  for (;;)
+  {
+    if (0.1*fabs(rd->h) <= fabs(rd->t)*DBL_EPSILON)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "radau5: step size %g too small at time %g", rd->h, rd->t);
+      return -1;
+    }
+
+    /* do not step across stop time or the next time event */
+    if (rd->t + 1.0001*rd->h >= limit)
+    {
+      rd->h = limit - rd->t;
+    }
+
+    if (rd->needJac)
+    {
+      radau5_jacobian(data, threadData, rd);
+      rd->needJac = 0;
+      rd->caljac = 1;
+      rd->needDecomp = 1;
+    }
+
+    fac1 = RADAU5_U1/rd->h;
+    alphn = RADAU5_ALPH/rd->h;
+    betan = RADAU5_BETA/rd->h;
+
+    if (rd->needDecomp || rd->h != rd->hFactored)
+    {
+      if (radau5_decomposition(rd, fac1, alphn, betan))
+      {
+        /* singular iteration matrix */
+        if (++rd->nsing >= RADAU5_MAX_SINGULAR)
+        {
+          warningStreamPrint(LOG_STDOUT, 0, "radau5: iteration matrix repeatedly singular at time %g", rd->t);
+          return -1;
+        }
+        rd->h *= 0.5;
+        rd->reject = 1;
+        rd->needJac = !rd->caljac;
+        rd->needDecomp = 1;
+        continue;
+      }
+      rd->needDecomp = 0;
+      rd->hFactored = rd->h;
+    }
+
+    /* starting values of the Newton iteration */
+    if (rd->first)
+    {
+      memset(rd->z1, 0, n*sizeof(double));
+      memset(rd->z2, 0, n*sizeof(double));
+      memset(rd->z3, 0, n*sizeof(double));
+      memset(rd->f1, 0, n*sizeof(double));
+      memset(rd->f2, 0, n*sizeof(double));
+      memset(rd->f3, 0, n*sizeof(double));
+    }
+    else
+    {
+      c3q = rd->h/rd->hOld;
+      c1q = RADAU5_C1*c3q;
+      c2q = RADAU5_C2*c3q;
+      for (i=0; i<n; i++)
+      {
+        ak1 = rd->cont[i+n];
+        ak2 = rd->cont[i+2*n];
+        ak3 = rd->cont[i+3*n];
+        rd->z1[i] = c1q*(ak1 + (c1q - RADAU5_C2 + 1.0)*(ak2 + (c1q - RADAU5_C1 + 1.0)*ak3));
+        rd->z2[i] = c2q*(ak1 + (c2q - RADAU5_C2 + 1.0)*(ak2 + (c2q - RADAU5_C1 + 1.0)*ak3));
+        rd->z3[i] = c3q*(ak1 + (c3q - RADAU5_C2 + 1.0)*(ak2 + (c3q - RADAU5_C1 + 1.0)*ak3));
+        rd->f1[i] = TI11*rd->z1[i] + TI12*rd->z2[i] + TI13*rd->z3[i];
+        rd->f2[i] = TI21*rd->z1[i] + TI22*rd->z2[i] + TI23*rd->z3[i];
+        rd->f3[i] = TI31*rd->z1[i] + TI32*rd->z2[i] + TI33*rd->z3[i];
+      }
+    }
+
+    /* simplified Newton iteration */
+    newt = 0;
+    converged = 0;
+    rd->faccon = pow(fmax(rd->faccon, DBL_EPSILON), 0.8);
+    rd->theta = RADAU5_THET;
+    while (newt < RADAU5_NIT)
+    {
+      for (i=0; i<n; i++)
+        rd->work[i] = rd->y[i] + rd->z1[i];
+      radau5_f(data, threadData, rd, rd->t + RADAU5_C1*rd->h, rd->work, rd->z1);
+      for (i=0; i<n; i++)
+        rd->work[i] = rd->y[i] + rd->z2[i];
+      radau5_f(data, threadData, rd, rd->t + RADAU5_C2*rd->h, rd->work, rd->z2);
+      for (i=0; i<n; i++)
+        rd->work[i] = rd->y[i] + rd->z3[i];
+      radau5_f(data, threadData, rd, rd->t + rd->h, rd->work, rd->z3);
+
+      /* transformed right hand side */
+      for (i=0; i<n; i++)
+      {
+        a1 = rd->z1[i];
+        a2 = rd->z2[i];
+        a3 = rd->z3[i];
+        s2 = -rd->f2[i];
+        s3 = -rd->f3[i];
+        rd->z1[i] = TI11*a1 + TI12*a2 + TI13*a3 - rd->f1[i]*fac1;
+        rd->z2[i] = TI21*a1 + TI22*a2 + TI23*a3 + s2*alphn - s3*betan;
+        rd->z3[i] = TI31*a1 + TI32*a2 + TI33*a3 + s3*alphn + s2*betan;
+      }
+      radau5_solveReal(rd, rd->z1);
+      radau5_solveComplex(rd, rd->z2, rd->z3);
+      newt++;
+
+      dyno = 0.0;
+      for (i=0; i<n; i++)
+      {
+        dyno += (rd->z1[i]/rd->scal[i])*(rd->z1[i]/rd->scal[i])
+              + (rd->z2[i]/rd->scal[i])*(rd->z2[i]/rd->scal[i])
+              + (rd->z3[i]/rd->scal[i])*(rd->z3[i]/rd->scal[i]);
+      }
+      dyno = n > 0 ? sqrt(dyno/(3*n)) : 0.0;
+      if (isnan(dyno) || isinf(dyno))
+        break;
+
+      /* bad convergence or number of iterations too large */
+      if (newt > 1 && newt < RADAU5_NIT)
+      {
+        thq = dyno/dynold;
+        rd->theta = (newt == 2) ? thq : sqrt(thq*thqold);
+        thqold = thq;
+        if (rd->theta < 0.99)
+        {
+          rd->faccon = rd->theta/(1.0 - rd->theta);
+          dyth = rd->faccon*dyno*pow(rd->theta, RADAU5_NIT - 1 - newt)/rd->fnewt;
+          if (dyth >= 1.0)
+          {
+            qnewt = fmax(1e-4, fmin(20.0, dyth));
+            rd->h *= 0.8*pow(qnewt, -1.0/(4 + RADAU5_NIT - 1 - newt));
+            converged = -1;
+            break;
+          }
+        }
+        else
+        {
+          break;
+        }
+      }
+      dynold = fmax(dyno, DBL_EPSILON);
+
+      for (i=0; i<n; i++)
+      {
+        rd->f1[i] += rd->z1[i];
+        rd->f2[i] += rd->z2[i];
+        rd->f3[i] += rd->z3[i];
+        rd->z1[i] = T11*rd->f1[i] + T12*rd->f2[i] + T13*rd->f3[i];
+        rd->z2[i] = T21*rd->f1[i] + T22*rd->f2[i] + T23*rd->f3[i];
+        rd->z3[i] = T31*rd->f1[i] + rd->f2[i];
+      }
+
+      if (rd->faccon*dyno <= rd->fnewt)
+      {
+        converged = 1;
+        break;
+      }
+    }
+
+    if (converged != 1)
+    {
+      /* Newton iteration failed, retry with smaller step size */
+      if (converged == 0)
+      {
+        rd->h *= 0.5;
+      }
+      rd->convergenceFailures++;
+      rd->reject = 1;
+      rd->needJac = !rd->caljac;
+      continue;
+    }
+
+    /* error estimate and new step size */
+    err = radau5_errorEstimate(data, threadData, rd);
+    fac = fmin(RADAU5_SAFE, cfac/(newt + 2*RADAU5_NIT));
+    quot = fmax(RADAU5_FACR, fmin(RADAU5_FACL, pow(err, 0.25)/fac));
+    hnew = rd->h/quot;
+
+    if (err < 1.0)
+    {
+      /* step is accepted */
+      rd->first = 0;
+      rd->nsing = 0;
+      rd->stepsDone++;
+
+      /* predictive controller of Gustafsson */
+      if (rd->stepsDone > 1)
+      {
+        facgus = (rd->hacc/rd->h)*pow(err*err/rd->erracc, 0.25)/RADAU5_SAFE;
+        facgus = fmax(RADAU5_FACR, fmin(RADAU5_FACL, facgus));
+        quot = fmax(quot, facgus);
+        hnew = rd->h/quot;
+      }
+      rd->hacc = rd->h;
+      rd->erracc = fmax(1e-2, err);
+
+      rd->tOld = rd->t;
+      rd->hOld = rd->h;
+      rd->t = (limit - rd->t - rd->h <= DBL_EPSILON*fabs(limit)) ? limit : rd->t + rd->h;
+
+      /* update the solution and the coefficients of the collocation polynomial */
+      for (i=0; i<n; i++)
+      {
+        double z1i = rd->z1[i], z2i = rd->z2[i], z3i = rd->z3[i], ak, acont3;
+        rd->y[i] += z3i;
+        rd->cont[i+n] = (z2i - z3i)/(RADAU5_C2 - 1.0);
+        ak = (z1i - z2i)/(RADAU5_C1 - RADAU5_C2);
+        acont3 = z1i/RADAU5_C1;
+        acont3 = (ak - acont3)/RADAU5_C2;
+        rd->cont[i+2*n] = (ak - rd->cont[i+n])/(RADAU5_C1 - 1.0);
+        rd->cont[i+3*n] = rd->cont[i+2*n] - acont3;
+        rd->cont[i] = rd->y[i];
+        rd->scal[i] = rd->atol[i] + rd->rtol*fabs(rd->y[i]);
+      }
+      radau5_f(data, threadData, rd, rd->t, rd->y, rd->fx);
+
+      hnew = fmin(hnew, rd->hmax);
+      if (rd->reject)
+      {
+        hnew = fmin(hnew, rd->h);
+      }
+      rd->reject = 0;
+      rd->caljac = 0;
+
+      /* keep step size and decomposition if the change is small */
+      if (!(rd->theta <= RADAU5_THET && hnew/rd->h >= RADAU5_QUOT1 && hnew/rd->h <= RADAU5_QUOT2))
+      {
+        rd->h = hnew;
+      }
+      rd->needJac = rd->theta > RADAU5_THET;
+
+      infoStreamPrint(LOG_SOLVER, 0, "radau5: step to %g accepted, err = %g, newt = %d, next step size %g", rd->t, err, newt, rd->h);
+      return 0;
+    }
+
+    /* step is rejected */
+    rd->reject = 1;
+    rd->errorTestFailures++;
+    rd->h = rd->first ? 0.1*rd->h : hnew;
+    rd->needJac = !rd->caljac;
+    infoStreamPrint(LOG_SOLVER, 0, "radau5: step at %g rejected, err = %g, retry with step size %g", rd->t, err, rd->h);
+  }
+}
+
+/*! \fn radau5_checkRoots
+ *
+ *  checks the zero crossings at the end of the last step for sign changes
+ *  and locates the first one by bisection on the collocation polynomial
+ */
+static void radau5_checkRoots(DATA* data, threadData_t *threadData, DATA_RADAU5* rd)
+{
+  const int nz = rd->nZeroCrossings;
+  double a = rd->tOld, b = rd->t, c;
+  int i, changed = 0;
+  unsigned int iter;
+
+  radau5_zeroCrossings(data, threadData, rd, rd->t, rd->y, rd->zcNew);
+  for (i=0; i<nz && !changed; i++)
+  {
+    changed = rd->zcOld[i]*rd->zcNew[i] < 0;
+  }
+
+  if (changed)
+  {
+    iter = 1 + (unsigned int) ceil(log(fmax(fabs(b - a)/MINIMAL_STEP_SIZE, 1.0))/log(2.0));
+    memcpy(rd->zcLeft, rd->zcOld, nz*sizeof(double));
+    while (fabs(b - a) > MINIMAL_STEP_SIZE && iter-- > 0)
+    {
+      c = 0.5*(a + b);
+      radau5_interpolate(rd, c, rd->work);
+      radau5_zeroCrossings(data, threadData, rd, c, rd->work, rd->zcMid);
+      for (i=0, changed=0; i<nz && !changed; i++)
+      {
+        changed = rd->zcLeft[i]*rd->zcMid[i] < 0;
+      }
+      if (changed)
+      {
+        b = c;
+      }
+      else
+      {
+        a = c;
+        memcpy(rd->zcLeft, rd->zcMid, nz*sizeof(double));
+      }
+    }
+    rd->rootFound = 1;
+    rd->tRoot = b;
+    infoStreamPrint(LOG_SOLVER, 0, "radau5: state event located at time %.15g", rd->tRoot);
+  }
+
+  memcpy(rd->zcOld, rd->zcNew, nz*sizeof(double));
+}
+
+/*! \fn radau5_step
+ *
+ *  integrates from solverInfo->currentTime to currentTime + currentStepSize,
+ *  or to the first state event in between
+ */
+int radau5_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  TRACE_PUSH
+  DATA_RADAU5* rd = (DATA_RADAU5*) solverInfo->solverData;
+  SIMULATION_DATA *sData = data->localData[0];
+  double target = solverInfo->currentTime + solverInfo->currentStepSize;
+  double limit, tout;
+  int retVal = 0;
+  int saveJumpState;
+
+  saveJumpState = threadData->currentErrorStage;
+  threadData->currentErrorStage = ERROR_INTEGRATOR;
+
+  /* try */
+#if !defined(OMC_EMCC)
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+
+  if (rd->restart || solverInfo->didEventStep)
+  {
+    radau5_restart(data, threadData, solverInfo, rd);
+  }
+
+  limit = data->simulationInfo->stopTime;
+  if (data->simulationInfo->nextSampleEvent > rd->t && data->simulationInfo->nextSampleEvent < limit)
+  {
+    limit = data->simulationInfo->nextSampleEvent;
+  }
+  if (target > limit)
+  {
+    target = limit;
+  }
+
+  while (!rd->rootFound && rd->t < target)
+  {
+    if (radau5_doStep(data, threadData, rd, limit))
+    {
+      retVal = -1;
+      break;
+    }
+    if (rd->nZeroCrossings > 0)
+    {
+      radau5_checkRoots(data, threadData, rd);
+    }
+    if (solverInfo->integratorSteps)
+    {
+      break;
+    }
+  }
+
+  if (0 == retVal)
+  {
+    if (rd->rootFound && rd->tRoot <= target)
+    {
+      tout = rd->tRoot;
+      rd->rootFound = 0;
+    }
+    else if (solverInfo->integratorSteps && rd->t < target)
+    {
+      tout = rd->t;
+    }
+    else
+    {
+      tout = target;
+    }
+
+    if (tout < rd->t)
+    {
+      radau5_interpolate(rd, tout, sData->realVars);
+    }
+    else
+    {
+      memcpy(sData->realVars, rd->y, rd->n*sizeof(double));
+    }
+    sData->timeValue = tout;
+    solverInfo->currentTime = tout;
+    solverInfo->solverStepSize = rd->hOld;
+  }
+
+#if !defined(OMC_EMCC)
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  threadData->currentErrorStage = saveJumpState;
+
+  /* if a state event occurs than no sample event does need to be activated  */
+  if (data->simulationInfo->sampleActivated && solverInfo->currentTime < data->simulationInfo->nextSampleEvent)
+  {
+    data->simulationInfo->sampleActivated = 0;
+  }
+
+  solverInfo->solverStatsTmp[0] = rd->stepsDone;
+  solverInfo->solverStatsTmp[1] = rd->evalFunctionODE;
+  solverInfo->solverStatsTmp[2] = rd->evalJacobian;
+  solverInfo->solverStatsTmp[3] = rd->errorTestFailures;
+  solverInfo->solverStatsTmp[4] = rd->convergenceFailures;
+
+  TRACE_POP
+  return retVal;
+}
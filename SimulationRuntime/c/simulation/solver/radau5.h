@@ -0,0 +1,122 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file radau5.h
+ *
+ *  Radau IIA of order 5 (three stages) with simplified Newton iteration,
+ *  step size control and dense output, following RADAU5 by Hairer and Wanner.
+ */
+
+#ifndef _RADAU5_H_
+#define _RADAU5_H_
+
+#include "simulation_data.h"
+#include "solver_main.h"
+#include "omc_config.h"
+
+#ifdef WITH_UMFPACK
+#include "suitesparse/Include/klu.h"
+#endif
+
+typedef struct DATA_RADAU5
+{
+  int n;                        /* number of states */
+
+  double *y;                    /* states at t */
+  double *fx;                   /* derivatives at (t, y) */
+  double *z1, *z2, *z3;         /* stage increments */
+  double *f1, *f2, *f3;         /* transformed stage increments */
+  double *cont;                 /* dense output coefficients, 4*n */
+  double *scal;                 /* error weights */
+  double *work;                 /* perturbed states */
+  double *fwork;                /* perturbed derivatives */
+  double *rhs;                  /* complex right hand side, 2*n */
+
+  /* jacobian in compressed column format, diagonal always included */
+  int nnz;
+  int *colPtr;
+  int *rowIdx;
+  int *diagIdx;                 /* position of the diagonal element in each column */
+  int *structural;              /* FALSE for diagonal elements added to the pattern */
+  double *jac;
+  unsigned int nColors;
+  unsigned int *colorCols;      /* 1-based color of each column */
+
+  int useSparse;                /* if TRUE then KLU is used, else dense LAPACK */
+  double *e1;                   /* dense real iteration matrix */
+  double *e2;                   /* dense complex iteration matrix, interleaved */
+  int *ipiv1, *ipiv2;
+  double *e1x;                  /* sparse values of the real iteration matrix */
+  double *e2x;                  /* sparse values of the complex iteration matrix, interleaved */
+#ifdef WITH_UMFPACK
+  klu_symbolic *symbolic;
+  klu_numeric *numeric1, *numeric2;
+  klu_common common;
+#endif
+
+  /* integrator state */
+  double t, tOld;
+  double h, hOld;
+  double hFactored;             /* step size of the current decomposition */
+  double hacc, erracc;          /* data of the predictive step size control */
+  double theta, faccon;
+  double rtol;                  /* transformed relative tolerance */
+  double *atol;                 /* transformed absolute tolerances */
+  double fnewt;
+  double hmax;
+  double hinit;
+  int restart;                  /* if TRUE the integrator is restarted at the next call */
+  int first;                    /* first step after a restart */
+  int reject;
+  int caljac;                   /* jacobian computed during current step */
+  int needJac;
+  int needDecomp;
+  int nsing;
+
+  /* event location */
+  int nZeroCrossings;
+  double *zcOld, *zcNew;        /* zero crossings at the begin and end of the last step */
+  double *zcLeft, *zcMid;       /* zero crossings during bisection */
+  int rootFound;
+  double tRoot;
+
+  /* statistics since last restart */
+  unsigned int stepsDone;
+  unsigned int evalFunctionODE;
+  unsigned int evalJacobian;
+  unsigned int errorTestFailures;
+  unsigned int convergenceFailures;
+} DATA_RADAU5;
+
+int allocateRadau5(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+int freeRadau5(SOLVER_INFO* solverInfo);
+int radau5_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+
+#endif /* _RADAU5_H_ */
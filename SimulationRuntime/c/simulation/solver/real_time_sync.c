@@ -29,15 +29,26 @@
  */
 
 #include "real_time_sync.h"
+#include "simulation/simulation_runtime.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 #if defined(__linux__)
 #include <sys/mman.h>
-#include <errno.h>
 #endif
 
 void omc_real_time_sync_init(threadData_t *threadData, DATA *data)
 {
   data->real_time_sync.maxLate = INT64_MIN;
+  data->real_time_sync.minLate = INT64_MAX;
+  data->real_time_sync.minStep = INT64_MAX;
+  data->real_time_sync.maxStep = 0;
+  data->real_time_sync.nSteps = 0;
+  data->real_time_sync.nOverruns = 0;
+  memset(data->real_time_sync.stepHistogram, 0, sizeof(data->real_time_sync.stepHistogram));
 
   omc_real_time_sync_update(data, data->real_time_sync.scaling);
 
@@ -66,4 +77,134 @@ void omc_real_time_sync_update(DATA *data, double scaling)
   data->real_time_sync.enabled = 1;
   data->real_time_sync.time = data->localData[0]->timeValue;
   rt_ext_tp_tick_realtime(&data->real_time_sync.clock);
+  rt_ext_tp_tick(&data->real_time_sync.stepClock);
+}
+
+/* bin i < 8 holds i ns, then 8 bins per power of two */
+static int latencyBin(int64_t ns)
+{
+  uint64_t v = ns > 0 ? (uint64_t) ns : 0;
+  int msb = 0;
+
+  if (v < 8) {
+    return (int) v;
+  }
+  while (v >> (msb+1)) {
+    msb++;
+  }
+  return (msb-2)*8 + (int) ((v >> (msb-3)) & 7);
+}
+
+static int64_t latencyBinUpperBound(int bin)
+{
+  int msb = bin/8 + 2;
+
+  if (bin < 8) {
+    return bin + 1;
+  }
+  if (msb >= 62) {
+    return INT64_MAX;
+  }
+  return (int64_t) ((uint64_t) (8 + bin%8 + 1) << (msb-3));
+}
+
+/*! \fn omc_real_time_sync_step
+ *
+ *  Records the statistics of a synchronized step and starts the next one.
+ *  Nothing is allocated, so this can be called in the real-time loop.
+ *
+ *  \param [in]  [stepTime] execution time of the step before the synchronization [s]
+ *  \param [in]  [late] positive if the synchronization point was missed [ns]
+ *  \param [in]  [missedDeadline]
+ */
+void omc_real_time_sync_step(DATA *data, double stepTime, int64_t late, int missedDeadline)
+{
+  real_time_sync_t *rt = &data->real_time_sync;
+  int64_t ns = (int64_t) (stepTime*1e9);
+
+  if (ns < rt->minStep) {
+    rt->minStep = ns;
+  }
+  if (ns > rt->maxStep) {
+    rt->maxStep = ns;
+  }
+  rt->stepHistogram[latencyBin(ns)]++;
+  rt->nSteps++;
+
+  if (late > rt->maxLate) {
+    rt->maxLate = late;
+  }
+  if (late < rt->minLate) {
+    rt->minLate = late;
+  }
+  if (missedDeadline) {
+    rt->nOverruns++;
+  }
+
+  rt_ext_tp_tick(&rt->stepClock);
+}
+
+/* upper bound of the bin which contains the p-quantile */
+static int64_t latencyPercentile(real_time_sync_t *rt, double p)
+{
+  uint64_t rank = (uint64_t) ceil(p*rt->nSteps), count = 0;
+  int i;
+
+  for (i=0; i<OMC_RT_LATENCY_BINS; i++) {
+    count += rt->stepHistogram[i];
+    if (count >= rank && count > 0) {
+      return latencyBinUpperBound(i);
+    }
+  }
+  return rt->maxStep;
+}
+
+/*! \fn omc_real_time_sync_statistics
+ *
+ *  Prints the latency statistics of the synchronized steps and writes the
+ *  histogram of the execution times to <model>_rt_latency.csv.
+ */
+void omc_real_time_sync_statistics(DATA *data)
+{
+  real_time_sync_t *rt = &data->real_time_sync;
+  static const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  char fileName[4096];
+  FILE *file;
+  int i, v = 0, v2 = 0;
+  const char *unit, *unit2;
+
+  unit = prettyPrintNanoSec(rt->maxLate, &v);
+  infoStreamPrint(LOG_RT, 0, "Maximum real-time latency was (positive=missed dealine, negative is slack): %d %s", v, unit);
+
+  if (rt->nSteps == 0) {
+    return;
+  }
+
+  infoStreamPrint(LOG_RT, 1, "Real-time statistics of %lu steps", (unsigned long) rt->nSteps);
+  unit = prettyPrintNanoSec(rt->minStep, &v);
+  unit2 = prettyPrintNanoSec(rt->maxStep, &v2);
+  infoStreamPrint(LOG_RT, 0, "execution time of a step: min %d %s, max %d %s", v, unit, v2, unit2);
+  for (i=0; i<sizeof(percentiles)/sizeof(percentiles[0]); i++) {
+    unit = prettyPrintNanoSec(latencyPercentile(rt, percentiles[i]), &v);
+    infoStreamPrint(LOG_RT, 0, "%g%% of the steps took at most %d %s", 100*percentiles[i], v, unit);
+  }
+  unit = prettyPrintNanoSec(rt->minLate, &v);
+  unit2 = prettyPrintNanoSec(rt->maxLate, &v2);
+  infoStreamPrint(LOG_RT, 0, "latency at the synchronization: min %d %s, max %d %s", v, unit, v2, unit2);
+  infoStreamPrint(LOG_RT, 0, "missed deadlines: %lu", (unsigned long) rt->nOverruns);
+  messageClose(LOG_RT);
+
+  snprintf(fileName, sizeof(fileName), "%s_rt_latency.csv", data->modelData->modelFilePrefix);
+  file = fopen(fileName, "w");
+  if (!file) {
+    warningStreamPrint(LOG_RT, 0, "Cannot open %s for writing the latency histogram: %s", fileName, strerror(errno));
+    return;
+  }
+  fprintf(file, "\"lower bound [ns]\",\"upper bound [ns]\",\"steps\"\n");
+  for (i=0; i<OMC_RT_LATENCY_BINS; i++) {
+    if (rt->stepHistogram[i] > 0) {
+      fprintf(file, "%lld,%lld,%lu\n", (long long) (i ? latencyBinUpperBound(i-1) : 0), (long long) latencyBinUpperBound(i), (unsigned long) rt->stepHistogram[i]);
+    }
+  }
+  fclose(file);
 }
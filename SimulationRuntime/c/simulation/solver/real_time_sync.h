@@ -40,6 +40,8 @@ extern "C" {
 
 void omc_real_time_sync_init(threadData_t *threadData, DATA *data);
 void omc_real_time_sync_update(DATA *data, double scaling);
+void omc_real_time_sync_step(DATA *data, double stepTime, int64_t late, int missedDeadline);
+void omc_real_time_sync_statistics(DATA *data);
 
 #if defined(__cplusplus)
 }
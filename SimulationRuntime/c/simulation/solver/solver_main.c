@@ -37,6 +37,7 @@
 #include "solver_main.h"
 #include "openmodelica_func.h"
 #include "initialization/initialization.h"
+#include "initialization/snapshot.h"
 #include "nonlinearSystem.h"
 #include "newtonIteration.h"
 #include "dassl.h"
@@ -51,6 +52,8 @@
 #include "simulation/solver/external_input.h"
 #include "linearSystem.h"
 #include "sym_imp_euler.h"
+#include "radau5.h"
+#include "multirate.h"
 #if !defined(OMC_MINIMAL_RUNTIME)
 #include "simulation/solver/embedded_server.h"
 #include "simulation/solver/real_time_sync.h"
@@ -62,6 +65,7 @@
  * #include "dopri45.h"
  */
 #include "util/rtclock.h"
+#include "util/alloc_tracking.h"
 #include "util/omc_error.h"
 #include "simulation/options.h"
 #include <math.h>
@@ -120,6 +124,18 @@ int solver_main_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
       data->simulationInfo->solverSteps = solverInfo->solverStats[0] + solverInfo->solverStatsTmp[0];
     TRACE_POP
     return retVal;
+  case S_RADAU5:
+    retVal = radau5_step(data, threadData, solverInfo);
+    if(omc_flag[FLAG_SOLVER_STEPS])
+      data->simulationInfo->solverSteps = solverInfo->solverStats[0] + solverInfo->solverStatsTmp[0];
+    TRACE_POP
+    return retVal;
+  case S_MULTIRATE:
+    retVal = multirate_step(data, threadData, solverInfo);
+    if(omc_flag[FLAG_SOLVER_STEPS])
+      data->simulationInfo->solverSteps = solverInfo->solverStats[0] + solverInfo->solverStatsTmp[0];
+    TRACE_POP
+    return retVal;
 #endif
 
 #ifdef WITH_IPOPT
@@ -136,7 +152,6 @@ int solver_main_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
     return retVal;
 #endif
 #ifdef WITH_SUNDIALS
-  case S_RADAU5:
   case S_RADAU3:
   case S_RADAU1:
   case S_LOBATTO2:
@@ -193,6 +208,7 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
   solverInfo->solverNoEquidistantGrid = 0;
   solverInfo->lastdesiredStep = solverInfo->currentTime + solverInfo->currentStepSize;
   solverInfo->eventLst = allocList(sizeof(long));
+  listReserve(solverInfo->eventLst, data->modelData->nZeroCrossings);
   solverInfo->didEventStep = 0;
   solverInfo->stateEvents = 0;
   solverInfo->sampleEvents = 0;
@@ -258,6 +274,20 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
     solverInfo->solverData = dasslData;
     break;
   }
+  case S_RADAU5:
+  {
+    /* Allocate Radau5 IIA work arrays */
+    infoStreamPrint(LOG_SOLVER, 0, "Initializing Radau IIA of order 5");
+    retValue = allocateRadau5(data, threadData, solverInfo);
+    break;
+  }
+  case S_MULTIRATE:
+  {
+    /* Allocate multirate work arrays */
+    infoStreamPrint(LOG_SOLVER, 0, "Initializing multirate Bogacki-Shampine 3(2)");
+    retValue = allocateMultirate(data, threadData, solverInfo);
+    break;
+  }
 #endif
 #ifdef WITH_IPOPT
   case S_OPTIMIZATION:
@@ -268,14 +298,6 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
   }
 #endif
 #ifdef WITH_SUNDIALS
-  case S_RADAU5:
-  {
-    /* Allocate Radau5 IIA work arrays */
-    infoStreamPrint(LOG_SOLVER, 0, "Initializing Radau IIA of order 5");
-    solverInfo->solverData = calloc(1, sizeof(KINODE));
-    allocateKinOde(data, threadData, solverInfo, solverInfo->solverMethod, 3);
-    break;
-  }
   case S_RADAU3:
   {
     /* Allocate Radau3 IIA work arrays */
@@ -371,6 +393,16 @@ int freeSolverData(DATA* data, SOLVER_INFO* solverInfo)
     /* De-Initial DASSL solver */
     dassl_deinitial(solverInfo->solverData);
   }
+  else if(solverInfo->solverMethod == S_RADAU5)
+  {
+    /* free  work arrays */
+    freeRadau5(solverInfo);
+  }
+  else if(solverInfo->solverMethod == S_MULTIRATE)
+  {
+    /* free  work arrays */
+    freeMultirate(solverInfo);
+  }
 #endif
 #ifdef WITH_IPOPT
   else if(solverInfo->solverMethod == S_OPTIMIZATION)
@@ -380,11 +412,6 @@ int freeSolverData(DATA* data, SOLVER_INFO* solverInfo)
   }
 #endif
 #ifdef WITH_SUNDIALS
-  else if(solverInfo->solverMethod == S_RADAU5)
-  {
-    /* free  work arrays */
-    freeKinOde(data, solverInfo, 3);
-  }
   else if(solverInfo->solverMethod == S_RADAU3)
   {
     /* free  work arrays */
@@ -468,6 +495,25 @@ int initializeModel(DATA* data, threadData_t *threadData, const char* init_initM
   {
     int success = 0;
     MMC_TRY_INTERNAL(simulationJumpBuffer)
+#if !defined(OMC_MINIMAL_RUNTIME)
+    if(omc_flag[FLAG_LOAD_SNAPSHOT])
+    {
+      if(loadSnapshot(data, threadData, omc_flagValue[FLAG_LOAD_SNAPSHOT]))
+      {
+        warningStreamPrint(LOG_STDOUT, 0, "Error in loading the snapshot. Storing results and exiting.");
+        simInfo->stopTime = simInfo->startTime;
+        retValue = -1;
+      }
+      else if(data->localData[0]->timeValue > simInfo->startTime)
+      {
+        /* resume at the snapshot time with the same output interval */
+        simInfo->startTime = data->localData[0]->timeValue;
+        simInfo->numSteps = (modelica_integer) fmax(1.0, floor((simInfo->stopTime - simInfo->startTime) / simInfo->stepSize + 0.5));
+        infoStreamPrint(LOG_STDOUT, 0, "Resuming simulation from snapshot at time %g.", simInfo->startTime);
+      }
+    }
+    else
+#endif
     if(initialization(data, threadData, init_initMethod, init_file, init_time, lambda_steps))
     {
       warningStreamPrint(LOG_STDOUT, 0, "Error in initialization. Storing results and exiting.\nUse -lv=LOG_INIT -w for more information.");
@@ -475,6 +521,16 @@ int initializeModel(DATA* data, threadData_t *threadData, const char* init_initM
       retValue = -1;
     }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+    if(0 == retValue && omc_flag[FLAG_SAVE_SNAPSHOT] && atof(omc_flagValue[FLAG_SAVE_SNAPSHOT]) <= simInfo->startTime)
+    {
+      char *snapshotFile = (char*) malloc(strlen(data->modelData->modelFilePrefix) + 14);
+      sprintf(snapshotFile, "%s_snapshot.bin", data->modelData->modelFilePrefix);
+      writeSnapshot(data, threadData, snapshotFile);
+      free(snapshotFile);
+    }
+#endif
+
     success = 1;
     MMC_CATCH_INTERNAL(simulationJumpBuffer)
     if (!success)
@@ -651,7 +707,6 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
 #ifndef WITH_SUNDIALS
   case S_RADAU1:
   case S_RADAU3:
-  case S_RADAU5:
   case S_LOBATTO2:
   case S_LOBATTO4:
   case S_LOBATTO6:
@@ -684,7 +739,7 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
   /*  initialize external input structure */
   externalInputallocate(data);
   /* set tolerance for ZeroCrossings */
-  setZCtol(fmin(data->simulationInfo->stepSize, data->simulationInfo->tolerance));
+  setZCtol(data, fmin(data->simulationInfo->stepSize, data->simulationInfo->tolerance));
 
   omc_alloc_interface.collect_a_little();
   /* initialize all parts of the model */
@@ -746,21 +801,30 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
       storeOldValues(data);
 
       infoStreamPrint(LOG_SOLVER, 0, "Start numerical solver from %g to %g", simInfo->startTime, simInfo->stopTime);
+      if (omc_flag[FLAG_RT_PREALLOC]) {
+        omc_alloc_reserve((size_t) atoi(omc_flagValue[FLAG_RT_PREALLOC]) * 1024 * 1024);
+      }
+      omc_alloc_tracking_start();
       retVal = data->callback->performSimulation(data, threadData, &solverInfo);
+      omc_alloc_tracking_stop();
       omc_alloc_interface.collect_a_little();
       /* terminate the simulation */
       if (solverInfo.solverMethod == S_SYM_IMP_EULER) data->callback->symEulerUpdate(data, 0);
       finishSimulation(data, threadData, &solverInfo, outputVariablesAtEnd);
+#if defined(WITH_SUNDIALS) && !defined(OMC_MINIMAL_RUNTIME)
+      /* adjoint sensitivities need the complete forward solution */
+      if (0 == retVal && S_IDA == solverInfo.solverMethod && omc_flag[FLAG_IDA_ADJOINT]) {
+        ida_solver_adjoint(data, threadData, &solverInfo);
+      }
+#endif
       omc_alloc_interface.collect_a_little();
     }
   }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
   if (data->real_time_sync.enabled) {
-    int tMaxLate=0;
-    const char *unit = prettyPrintNanoSec(data->real_time_sync.maxLate, &tMaxLate);
-    infoStreamPrint(LOG_RT, 0, "Maximum real-time latency was (positive=missed dealine, negative is slack): %d %s", tMaxLate, unit);
+    omc_real_time_sync_statistics(data);
   }
-#if !defined(OMC_MINIMAL_RUNTIME)
   embedded_server_deinit(data->embeddedServerState);
   embedded_server_unload_functions(dllHandle);
 #endif
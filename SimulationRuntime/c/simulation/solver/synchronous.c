@@ -43,6 +43,8 @@ void initSynchronous(DATA* data, threadData_t *threadData, modelica_real startTi
 
   data->callback->function_initSynchronous(data, threadData);
   data->simulationInfo->intvlTimers = allocList(sizeof(SYNC_TIMER));
+  /* every clock has at most one pending timer */
+  listReserve(data->simulationInfo->intvlTimers, data->modelData->nClocks + data->modelData->nSubClocks);
   long i;
 
   for(i=0; i<data->modelData->nClocks; i++)
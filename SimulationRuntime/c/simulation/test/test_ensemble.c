@@ -0,0 +1,373 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/* Runs the ensemble driver (-ensemble) on the model
+ *
+ *   model Decay
+ *     parameter Real k = 1;
+ *     Real x(start = 1, fixed = true);
+ *   equation
+ *     der(x) = -k*x;
+ *     assert(k >= 0, "k < 0");
+ *   end Decay;
+ *
+ * with the explicit Euler method of the generated simulation loop. Every run
+ * has to end with the x(1) of its own k and start value on one of two
+ * threads, a run failing its assert must not stop the others and a column
+ * that is no variable of the model is ignored.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "simulation/simulation_info_json.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/mixedSystem.h"
+
+#define prefixedName_performSimulation Decay_performSimulation
+#define prefixedName_updateContinuousSystem Decay_updateContinuousSystem
+#include "simulation/solver/perform_simulation.c"
+
+#define NUMBER_OF_RUNS 5
+
+static const char *ensembleFile = "Decay_ensemble.csv";
+static const char *ensembleCsv =
+  "k,x,y\n"
+  "0,1,7\n"
+  "1,1,7\n"
+  "2,1,7\n"
+  "-1,1,7\n"
+  "1,3,7\n";
+
+typedef struct RUN_RESULT
+{
+  double k;
+  double x0;
+  double x;
+  double time;
+  pthread_t thread;
+} RUN_RESULT;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static RUN_RESULT results[NUMBER_OF_RUNS];
+static int nResults = 0;
+
+/* the equations of the model */
+
+static int Decay_functionODE(DATA *data, threadData_t *threadData)
+{
+  double k = data->simulationInfo->realParameter[0];
+  if (k < 0) {
+    throwStreamPrint(threadData, "k < 0");
+  }
+  data->localData[0]->realVars[1] = -k * data->localData[0]->realVars[0];
+  return 0;
+}
+
+static int Decay_functionDAE(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->discreteCall = 1;
+  Decay_functionODE(data, threadData);
+  data->simulationInfo->discreteCall = 0;
+  return 0;
+}
+
+static int Decay_return0(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static int Decay_zeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  return 0;
+}
+
+static int Decay_updateRelations(DATA *data, threadData_t *threadData, int evalZeroCross)
+{
+  return 0;
+}
+
+static void Decay_constructors(DATA *data, threadData_t *threadData)
+{
+}
+
+/* the last call of a run, records its result */
+static void Decay_destructors(DATA *data, threadData_t *threadData)
+{
+  pthread_mutex_lock(&mutex);
+  if (nResults < NUMBER_OF_RUNS) {
+    results[nResults].k = data->simulationInfo->realParameter[0];
+    results[nResults].x0 = data->modelData->realVarsData[0].attribute.start;
+    results[nResults].x = data->localData[0]->realVars[0];
+    results[nResults].time = data->localData[0]->timeValue;
+    results[nResults].thread = pthread_self();
+  }
+  nResults++;
+  pthread_mutex_unlock(&mutex);
+}
+
+static void Decay_initialNonLinearSystem(int n, NONLINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initialLinearSystem(int n, LINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initialMixedSystem(int n, MIXED_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initializeStateSets(int n, STATE_SET_DATA *statesetData, DATA *data)
+{
+}
+
+static int Decay_initializeDAEmodeData(DATA *data, DAEMODE_DATA *daeModeData)
+{
+  return 0;
+}
+
+static void Decay_initSample(DATA *data, threadData_t *threadData)
+{
+}
+
+static void Decay_initSynchronous(DATA *data, threadData_t *threadData)
+{
+}
+
+static int Decay_initialAnalyticJacobian(void *data, threadData_t *threadData)
+{
+  return 1;
+}
+
+/* x = x.start, the parameter keeps its start value */
+static int Decay_functionInitialEquations(DATA *data, threadData_t *threadData)
+{
+  data->localData[0]->realVars[0] = data->modelData->realVarsData[0].attribute.start;
+  Decay_functionDAE(data, threadData);
+  return 0;
+}
+
+static int Decay_updateBoundParameters(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->realParameter[0] = data->modelData->realParameterData[0].attribute.start;
+  return 0;
+}
+
+static const char *Decay_description(int i)
+{
+  return "";
+}
+
+static const char *Decay_zeroCrossingDescription(int i, int **out_EquationIndexes)
+{
+  return "";
+}
+
+static struct OpenModelicaGeneratedFunctionCallbacks Decay_callback = {
+  .performSimulation = (int (*)(DATA*, threadData_t*, void*)) Decay_performSimulation,
+  .updateContinuousSystem = Decay_updateContinuousSystem,
+  .callExternalObjectConstructors = Decay_constructors,
+  .callExternalObjectDestructors = Decay_destructors,
+  .initialNonLinearSystem = Decay_initialNonLinearSystem,
+  .initialLinearSystem = Decay_initialLinearSystem,
+  .initialMixedSystem = Decay_initialMixedSystem,
+  .initializeStateSets = Decay_initializeStateSets,
+  .initializeDAEmodeData = Decay_initializeDAEmodeData,
+  .functionODE = Decay_functionODE,
+  .functionAlgebraics = Decay_return0,
+  .functionDAE = Decay_functionDAE,
+  .functionLocalKnownVars = Decay_return0,
+  .input_function = Decay_return0,
+  .input_function_init = Decay_return0,
+  .input_function_updateStartValues = Decay_return0,
+  .output_function = Decay_return0,
+  .function_storeDelayed = Decay_return0,
+  .updateBoundVariableAttributes = Decay_return0,
+  .functionInitialEquations = Decay_functionInitialEquations,
+  .functionInitialEquations_lambda0 = NULL,
+  .functionRemovedInitialEquations = Decay_return0,
+  .updateBoundParameters = Decay_updateBoundParameters,
+  .checkForAsserts = Decay_return0,
+  .function_ZeroCrossingsEquations = Decay_return0,
+  .function_ZeroCrossings = Decay_zeroCrossings,
+  .function_updateRelations = Decay_updateRelations,
+  .checkForDiscreteChanges = Decay_return0,
+  .zeroCrossingDescription = Decay_zeroCrossingDescription,
+  .relationDescription = Decay_description,
+  .function_initSample = Decay_initSample,
+  .INDEX_JAC_A = 0,
+  .initialAnalyticJacobianA = Decay_initialAnalyticJacobian,
+  .function_initSynchronous = Decay_initSynchronous
+};
+
+static const char Decay_infoJson[] = "{\"format\":\"Transformational debugger info\",\"version\":1,\n"
+  "\"info\":{\"name\":\"Decay\",\"description\":\"\"},\n"
+  "\"variables\":{},\n"
+  "\"equations\":[{\"eqIndex\":0,\"tag\":\"dummy\"}],\n"
+  "\"functions\":[]\n"
+  "}";
+
+static const VAR_INFO Decay_xInfo = {0,-1,"x","",omc_dummyFileInfo};
+static const VAR_INFO Decay_derxInfo = {1,-1,"der(x)","",omc_dummyFileInfo};
+static const VAR_INFO Decay_kInfo = {2,-1,"k","",omc_dummyFileInfo};
+
+/* what setupDataStruc and the init file do for the generated model */
+static void setupDecay(DATA *data, MODEL_DATA *modelData, SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+{
+  int i;
+
+  memset(data, 0, sizeof(DATA));
+  memset(modelData, 0, sizeof(MODEL_DATA));
+  memset(simulationInfo, 0, sizeof(SIMULATION_INFO));
+  data->modelData = modelData;
+  data->simulationInfo = simulationInfo;
+  data->callback = &Decay_callback;
+
+  modelData->modelName = "Decay";
+  modelData->modelFilePrefix = "Decay";
+  modelData->resultFileName = "Decay_res.mat";
+  modelData->modelDataXml.fileName = "Decay_info.json";
+  modelData->modelDataXml.infoXMLData = Decay_infoJson;
+  modelData->modelDataXml.modelInfoXmlLength = sizeof(Decay_infoJson) - 1;
+  modelData->modelDataXml.nEquations = 1;
+  modelData->nStates = 1;
+  modelData->nVariablesReal = 2;
+  modelData->nParametersReal = 1;
+
+  simulationInfo->startTime = 0;
+  simulationInfo->stopTime = 1;
+  simulationInfo->numSteps = 1000;
+  simulationInfo->stepSize = 1e-3;
+  simulationInfo->tolerance = 1e-6;
+  simulationInfo->solverMethod = "euler";
+  simulationInfo->outputFormat = "empty";
+  simulationInfo->variableFilter = ".*";
+
+  initializeDataStruc(data, threadData);
+  for (i = 0; i < 2; i++) {
+    modelData->realVarsData[i].info = i ? Decay_derxInfo : Decay_xInfo;
+    modelData->realVarsData[i].attribute.start = i ? 0 : 1;
+    modelData->realVarsData[i].attribute.fixed = !i;
+    modelData->realVarsData[i].attribute.nominal = 1;
+    modelData->realVarsData[i].attribute.min = -DBL_MAX;
+    modelData->realVarsData[i].attribute.max = DBL_MAX;
+  }
+  modelData->realParameterData[0].info = Decay_kInfo;
+  modelData->realParameterData[0].attribute.start = 1;
+  modelData->realParameterData[0].attribute.fixed = 1;
+  modelData->realParameterData[0].attribute.nominal = 1;
+  modelData->realParameterData[0].attribute.min = -DBL_MAX;
+  modelData->realParameterData[0].attribute.max = DBL_MAX;
+  modelData->sharedVarInfo = 1;
+}
+
+int test_ensemble()
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  threadData_t threadData;
+  char *argv[] = {"Decay"};
+  FILE *file;
+  int i, j, retVal, nFailed = 0;
+
+  file = fopen(ensembleFile, "w");
+  if (!file) return 1;
+  fputs(ensembleCsv, file);
+  fclose(file);
+
+  memset(&threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, &threadData);
+  setupDecay(&data, &modelData, &simulationInfo, &threadData);
+
+  omc_flag[FLAG_ENSEMBLE] = 1;
+  omc_flagValue[FLAG_ENSEMBLE] = ensembleFile;
+  omc_flag[FLAG_ENSEMBLE_THREADS] = 1;
+  omc_flagValue[FLAG_ENSEMBLE_THREADS] = "2";
+
+  retVal = runEnsemble(1, argv, &data, &threadData);
+  remove(ensembleFile);
+
+  /* the run with k = -1 failed */
+  if (retVal != 1) return 2;
+  if (nResults != NUMBER_OF_RUNS) return 3;
+
+  for (i = 0; i < NUMBER_OF_RUNS; i++) {
+    RUN_RESULT *r = &results[i];
+    /* (1 - k h)^n of the explicit Euler method */
+    double expected = r->x0 * pow(1.0 - r->k * simulationInfo.stepSize, simulationInfo.numSteps);
+    if (r->k < 0) {
+      nFailed++;
+      continue;
+    }
+    printf("k = %g, x.start = %g: x(%g) = %.10f, expected %.10f\n", r->k, r->x0, r->time, r->x, expected);
+    if (fabs(r->time - simulationInfo.stopTime) > 1e-12) return 4;
+    if (fabs(r->x - expected) > 1e-8 * r->x0) return 5;
+    /* every combination of the csv file ran once */
+    for (j = 0; j < i; j++) {
+      if (results[j].k == r->k && results[j].x0 == r->x0) return 6;
+    }
+  }
+  if (nFailed != 1) return 7;
+
+  /* the base model is unchanged */
+  if (modelData.realParameterData[0].attribute.start != 1) return 8;
+  if (modelData.realVarsData[0].attribute.start != 1) return 9;
+
+  deInitializeDataStruc(&data);
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_ensemble()) != 0) return 1000+rc;
+
+  /* everything OK */
+  return 0;
+}
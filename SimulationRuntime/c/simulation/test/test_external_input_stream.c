@@ -0,0 +1,333 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+/* The streaming reader of -inputStream with a window of 16 rows, which is
+ * much smaller than the input files. The inputs u1, u2 and u3 of the model
+ * are read from csv and raw binary files with the samples
+ *
+ *   time = 0.5*k,  u1 = 3*time + 1,  u2 = time^2,  u3 = -time
+ *
+ * The csv files do not contain u3, which keeps its start value 0.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulation_data.h"
+#include "meta/meta_modelica.h"
+#include "util/omc_init.h"
+#include "simulation/options.h"
+#include "simulation/solver/external_input.h"
+#include "simulation/solver/external_input_stream.h"
+#include "test_model.h"
+
+#define N_INPUTS 3
+#define N_ROWS 200
+
+static const char *inputNames[N_INPUTS] = {"u1", "u2", "u3"};
+
+/* the samples of the current file */
+static int nRows;
+static double sampleTime[N_ROWS];
+static double sampleValue[N_ROWS][N_INPUTS];
+
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  data->localData[0]->realVars[1] = data->simulationInfo->inputVars[0];
+  return 0;
+}
+
+static int getInputNames(DATA *data, char **names)
+{
+  int j;
+  for (j = 0; j < N_INPUTS; j++) {
+    names[j] = (char*) inputNames[j];
+  }
+  return 0;
+}
+
+static void initInputModel(TEST_MODEL *model, double *inputVars)
+{
+  initTestModel(model, 1, functionODE, 0.0, 1.0, 1e-6);
+  model->modelData.nInputVars = N_INPUTS;
+  model->simulationInfo.inputVars = inputVars;
+  model->callback.inputNames = getInputNames;
+  memset(inputVars, 0, N_INPUTS*sizeof(double));
+}
+
+static void setSamples(int rows, int withU3)
+{
+  int k;
+  nRows = rows;
+  for (k = 0; k < rows; k++) {
+    sampleTime[k] = 0.5*k;
+    sampleValue[k][0] = 3*sampleTime[k] + 1;
+    sampleValue[k][1] = sampleTime[k]*sampleTime[k];
+    sampleValue[k][2] = withU3 ? -sampleTime[k] : 0.0;
+  }
+}
+
+/* the samples as csv file with the columns in another order than the inputs,
+ * badRow > 0 replaces the value of u1 in this row by text, badColumns drops
+ * its last column */
+static void writeCsv(const char *fileName, int badRow, int badColumns)
+{
+  FILE *file = fopen(fileName, "w");
+  int k;
+
+  fputs("time,u2,u1\n", file);
+  for (k = 0; k < nRows; k++) {
+    if (k == badRow && !badColumns) {
+      fprintf(file, "%.17g,%.17g,abc\n", sampleTime[k], sampleValue[k][1]);
+    } else if (k == badRow) {
+      fprintf(file, "%.17g,%.17g\n", sampleTime[k], sampleValue[k][1]);
+    } else {
+      fprintf(file, "%.17g,%.17g,%.17g\n", sampleTime[k], sampleValue[k][1], sampleValue[k][0]);
+    }
+  }
+  fclose(file);
+}
+
+/* raw binary files hold rows of doubles with the time followed by all inputs */
+static void writeRaw(const char *fileName)
+{
+  FILE *file = fopen(fileName, "wb");
+  int k;
+
+  for (k = 0; k < nRows; k++) {
+    fwrite(&sampleTime[k], sizeof(double), 1, file);
+    fwrite(sampleValue[k], sizeof(double), N_INPUTS, file);
+  }
+  fclose(file);
+}
+
+/* linear interpolation of the samples, extrapolated with the last interval */
+static void expectedInputs(double t, double *u)
+{
+  int k = 0, j;
+  while (k < nRows-2 && t > sampleTime[k+1]) {
+    k++;
+  }
+  for (j = 0; j < N_INPUTS; j++) {
+    u[j] = sampleValue[k][j] + (t - sampleTime[k])*(sampleValue[k+1][j] - sampleValue[k][j])/(sampleTime[k+1] - sampleTime[k]);
+  }
+}
+
+static int allocateStream(TEST_MODEL *model, const char *fileName)
+{
+  threadData_t *threadData = &model->threadData;
+  int rc = 0;
+
+  MMC_TRY_TOP_INTERNAL()
+  rc = externalInputStreamAllocate(&model->data, fileName);
+  MMC_CATCH_TOP(rc = 2)
+  return rc;
+}
+
+/* updates the inputs at the times from, from+step, ... until to and compares
+ * them with the samples. Returns 1 for a wrong input and 2 if an error was
+ * thrown, reached is the last time with correct inputs. */
+static int walk(TEST_MODEL *model, double from, double to, double step, double *reached)
+{
+  threadData_t *threadData = &model->threadData;
+  volatile int rc = 0;
+  volatile double t;
+  double u[N_INPUTS];
+  int j;
+
+  *reached = from - step;
+  MMC_TRY_TOP_INTERNAL()
+  for (t = from; t <= to + 1e-9 && 0 == rc; t += step) {
+    model->localData[0]->timeValue = t;
+    externalInputUpdate(&model->data);
+    expectedInputs(t, u);
+    for (j = 0; j < N_INPUTS; j++) {
+      if (fabs(model->simulationInfo.inputVars[j] - u[j]) > 1e-9*fmax(1.0, fabs(u[j]))) {
+        printf("%s at time %g: %.17g instead of %.17g\n", inputNames[j], t, model->simulationInfo.inputVars[j], u[j]);
+        rc = 1;
+      }
+    }
+    if (0 == rc) {
+      *reached = t;
+    }
+  }
+  MMC_CATCH_TOP(rc = 2)
+  return rc;
+}
+
+/* the samples themselves are returned without interpolation */
+static int checkSamples(TEST_MODEL *model, int from, int to)
+{
+  int k, j;
+  for (k = from; k <= to; k++) {
+    model->localData[0]->timeValue = sampleTime[k];
+    if (1 != externalInputUpdate(&model->data)) return 1;
+    for (j = 0; j < N_INPUTS; j++) {
+      if (model->simulationInfo.inputVars[j] != sampleValue[k][j]) return 2;
+    }
+  }
+  return 0;
+}
+
+int test_csvInterpolation()
+{
+  TEST_MODEL model;
+  double inputVars[N_INPUTS], reached;
+  int rc = 0;
+
+  setSamples(N_ROWS, 0);
+  writeCsv("test_input_stream.csv", -1, 0);
+  initInputModel(&model, inputVars);
+
+  if (allocateStream(&model, "test_input_stream.csv")) return 1;
+  if (!model.simulationInfo.external_input.active) return 2;
+
+  /* between the samples, through many turns of the ring buffer */
+  if (walk(&model, 0.0, 60.0, 0.05, &reached)) rc = 3;
+  /* the rows kept behind the current interval for solvers stepping back */
+  else if (walk(&model, 59.3, 60.0, 0.1, &reached)) rc = 4;
+  else if (checkSamples(&model, 120, 140)) rc = 5;
+
+  externalInputFree(&model.data);
+  freeTestModel(&model);
+  remove("test_input_stream.csv");
+  return rc;
+}
+
+int test_endOfStream()
+{
+  TEST_MODEL model;
+  double inputVars[N_INPUTS], reached;
+  int rc = 0;
+
+  setSamples(N_ROWS, 0);
+  writeCsv("test_input_stream.csv", -1, 0);
+  initInputModel(&model, inputVars);
+
+  if (allocateStream(&model, "test_input_stream.csv")) return 1;
+
+  /* the last interval is extrapolated after the end of the file */
+  if (walk(&model, 90.0, 110.0, 0.25, &reached)) rc = 2;
+  else if (checkSamples(&model, N_ROWS-1, N_ROWS-1)) rc = 3;
+
+  externalInputFree(&model.data);
+  freeTestModel(&model);
+  remove("test_input_stream.csv");
+  return rc;
+}
+
+int test_rawFile()
+{
+  TEST_MODEL model;
+  double inputVars[N_INPUTS], reached;
+  int rc = 0;
+
+  setSamples(N_ROWS, 1);
+  writeRaw("test_input_stream.bin");
+  initInputModel(&model, inputVars);
+
+  if (allocateStream(&model, "test_input_stream.bin")) return 1;
+
+  if (walk(&model, 0.0, 105.0, 0.05, &reached)) rc = 2;
+  else if (checkSamples(&model, N_ROWS-3, N_ROWS-1)) rc = 3;
+
+  externalInputFree(&model.data);
+  freeTestModel(&model);
+  remove("test_input_stream.bin");
+  return rc;
+}
+
+/* a malformed row is reported when the simulation needs it, all inputs before are correct */
+static int malformedCsv(int badColumns)
+{
+  const int badRow = 100;
+  TEST_MODEL model;
+  double inputVars[N_INPUTS], reached;
+  int rc = 0;
+
+  setSamples(N_ROWS, 0);
+  writeCsv("test_input_stream.csv", badRow, badColumns);
+  initInputModel(&model, inputVars);
+
+  if (allocateStream(&model, "test_input_stream.csv")) return 1;
+
+  if (2 != walk(&model, 0.0, 100.0, 0.05, &reached)) rc = 2;
+  /* the error must not be reported before the rows are read ahead */
+  else if (reached < sampleTime[badRow-16]) rc = 3;
+
+  externalInputFree(&model.data);
+  freeTestModel(&model);
+  remove("test_input_stream.csv");
+  return rc;
+}
+
+int test_malformedInput()
+{
+  TEST_MODEL model;
+  double inputVars[N_INPUTS];
+  int rc;
+
+  if ((rc = malformedCsv(0))) return rc;
+  if ((rc = malformedCsv(1))) return 10 + rc;
+
+  /* a single row is ignored */
+  setSamples(1, 0);
+  writeCsv("test_input_stream.csv", -1, 0);
+  initInputModel(&model, inputVars);
+  rc = allocateStream(&model, "test_input_stream.csv");
+  if (1 != rc || model.simulationInfo.external_input.active || model.simulationInfo.external_input.stream) return 20;
+  freeTestModel(&model);
+  remove("test_input_stream.csv");
+
+  /* missing file */
+  initInputModel(&model, inputVars);
+  if (2 != allocateStream(&model, "test_input_stream_missing.csv")) return 30;
+  freeTestModel(&model);
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+  omc_flagValue[FLAG_INPUT_STREAM_WINDOW] = "16";
+
+  if ( (rc = test_csvInterpolation()) != 0) return 1000+rc;
+  if ( (rc = test_endOfStream()) != 0) return 2000+rc;
+  if ( (rc = test_rawFile()) != 0) return 3000+rc;
+  if ( (rc = test_malformedInput()) != 0) return 4000+rc;
+
+  /* everything OK */
+  return 0;
+}
@@ -0,0 +1,374 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/* Two instances of a model exchange FMU 2.0 in one process, the equations of
+ * the first one call terminate(). Like the code generated for an FMU, this
+ * file includes fmu2_model_interface.c after defining the model. Only the
+ * first instance may report terminateSimulation and fmi2Reset has to clear it.
+ *
+ *   model StopFMU
+ *     parameter Real stop = 0;
+ *     Real y = 2*time;
+ *   equation
+ *     when stop > 0 then
+ *       terminate("stop");
+ *     end when;
+ *   end StopFMU;
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/events.h"
+#include "fmu2_model_interface.h"
+
+#define MODEL_IDENTIFIER StopFMU
+#define MODEL_GUID "{8c4e810f-3df3-4a00-8276-176fa3c9f9e0}"
+
+#define NUMBER_OF_STATES 0
+#define NUMBER_OF_EVENT_INDICATORS 0
+#define NUMBER_OF_REALS 2
+#define NUMBER_OF_INTEGERS 0
+#define NUMBER_OF_STRINGS 0
+#define NUMBER_OF_BOOLEANS 0
+#define NUMBER_OF_EXTERNALFUNCTIONS 0
+
+#define STATES { }
+#define STATESDERIVATIVES { }
+
+#define y_vr 0
+#define stop_vr 1
+
+void setStartValues(ModelInstance *comp);
+void setDefaultStartValues(ModelInstance *comp);
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value);
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value);
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value);
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value);
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value);
+
+void StopFMU_setupDataStruc(DATA *data);
+#define fmu2_model_interface_setupDataStruc StopFMU_setupDataStruc
+#include "fmu2_model_interface.c"
+
+/* the equations of the model */
+
+static int StopFMU_functionDAE(DATA *data, threadData_t *threadData)
+{
+  FILE_INFO info = omc_dummyFileInfo;
+  data->localData[0]->realVars[0] = 2.0 * data->localData[0]->timeValue;
+  if (data->simulationInfo->realParameter[0] > 0) {
+    omc_terminate(info, "stop");
+  }
+  return 0;
+}
+
+static int StopFMU_return0(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static int StopFMU_zeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  return 0;
+}
+
+static int StopFMU_updateRelations(DATA *data, threadData_t *threadData, int evalZeroCross)
+{
+  return 0;
+}
+
+static void StopFMU_objects(DATA *data, threadData_t *threadData)
+{
+}
+
+static void StopFMU_initialNonLinearSystem(int n, NONLINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void StopFMU_initialLinearSystem(int n, LINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void StopFMU_initialMixedSystem(int n, MIXED_SYSTEM_DATA *data)
+{
+}
+
+static void StopFMU_initializeStateSets(int n, STATE_SET_DATA *statesetData, DATA *data)
+{
+}
+
+static int StopFMU_initializeDAEmodeData(DATA *data, DAEMODE_DATA *daeModeData)
+{
+  return 0;
+}
+
+static void StopFMU_initSample(DATA *data, threadData_t *threadData)
+{
+}
+
+static void StopFMU_initSynchronous(DATA *data, threadData_t *threadData)
+{
+}
+
+static int StopFMU_initialAnalyticJacobian(void *data, threadData_t *threadData)
+{
+  return 1;
+}
+
+static const VAR_INFO StopFMU_yInfo = {0,-1,"y","",omc_dummyFileInfo};
+static const VAR_INFO StopFMU_stopInfo = {1,-1,"stop","",omc_dummyFileInfo};
+
+static void StopFMU_read_input_fmu(MODEL_DATA *modelData, SIMULATION_INFO *simulationInfo)
+{
+  modelData->realVarsData[0].info = StopFMU_yInfo;
+  modelData->realVarsData[0].attribute.start = 0;
+  modelData->realVarsData[0].attribute.fixed = 0;
+  modelData->realVarsData[0].attribute.nominal = 1;
+  modelData->realVarsData[0].attribute.min = -DBL_MAX;
+  modelData->realVarsData[0].attribute.max = DBL_MAX;
+  modelData->realParameterData[0].info = StopFMU_stopInfo;
+  modelData->realParameterData[0].attribute.start = 0;
+  modelData->realParameterData[0].attribute.fixed = 1;
+  modelData->realParameterData[0].attribute.nominal = 1;
+  modelData->realParameterData[0].attribute.min = -DBL_MAX;
+  modelData->realParameterData[0].attribute.max = DBL_MAX;
+}
+
+static const char *StopFMU_relationDescription(int i)
+{
+  return "";
+}
+
+static const char *StopFMU_zeroCrossingDescription(int i, int **out_EquationIndexes)
+{
+  return "";
+}
+
+static struct OpenModelicaGeneratedFunctionCallbacks StopFMU_callback = {
+  .callExternalObjectConstructors = StopFMU_objects,
+  .callExternalObjectDestructors = StopFMU_objects,
+  .initialNonLinearSystem = StopFMU_initialNonLinearSystem,
+  .initialLinearSystem = StopFMU_initialLinearSystem,
+  .initialMixedSystem = StopFMU_initialMixedSystem,
+  .initializeStateSets = StopFMU_initializeStateSets,
+  .initializeDAEmodeData = StopFMU_initializeDAEmodeData,
+  .functionODE = StopFMU_return0,
+  .functionAlgebraics = StopFMU_return0,
+  .functionDAE = StopFMU_functionDAE,
+  .functionLocalKnownVars = StopFMU_return0,
+  .input_function = StopFMU_return0,
+  .input_function_init = StopFMU_return0,
+  .input_function_updateStartValues = StopFMU_return0,
+  .output_function = StopFMU_return0,
+  .function_storeDelayed = StopFMU_return0,
+  .updateBoundVariableAttributes = StopFMU_return0,
+  .functionInitialEquations = StopFMU_functionDAE,
+  .functionInitialEquations_lambda0 = NULL,
+  .functionRemovedInitialEquations = StopFMU_return0,
+  .updateBoundParameters = StopFMU_return0,
+  .checkForAsserts = StopFMU_return0,
+  .function_ZeroCrossingsEquations = StopFMU_return0,
+  .function_ZeroCrossings = StopFMU_zeroCrossings,
+  .function_updateRelations = StopFMU_updateRelations,
+  .checkForDiscreteChanges = StopFMU_return0,
+  .zeroCrossingDescription = StopFMU_zeroCrossingDescription,
+  .relationDescription = StopFMU_relationDescription,
+  .function_initSample = StopFMU_initSample,
+  .INDEX_JAC_A = 0,
+  .initialAnalyticJacobianA = StopFMU_initialAnalyticJacobian,
+  .function_initSynchronous = StopFMU_initSynchronous,
+  .read_input_fmu = StopFMU_read_input_fmu
+};
+
+static const char StopFMU_infoJson[] = "{\"format\":\"Transformational debugger info\",\"version\":1,\n"
+  "\"info\":{\"name\":\"StopFMU\",\"description\":\"\"},\n"
+  "\"variables\":{},\n"
+  "\"equations\":[{\"eqIndex\":0,\"tag\":\"dummy\"}],\n"
+  "\"functions\":[]\n"
+  "}";
+
+void StopFMU_setupDataStruc(DATA *data)
+{
+  memset(data->modelData, 0, sizeof(MODEL_DATA));
+  data->callback = &StopFMU_callback;
+  data->modelData->modelName = "StopFMU";
+  data->modelData->modelFilePrefix = "StopFMU";
+  data->modelData->modelGUID = MODEL_GUID;
+  data->modelData->modelDataXml.fileName = "StopFMU_info.json";
+  data->modelData->modelDataXml.infoXMLData = StopFMU_infoJson;
+  data->modelData->modelDataXml.modelInfoXmlLength = sizeof(StopFMU_infoJson) - 1;
+  data->modelData->nVariablesReal = 1;
+  data->modelData->nParametersReal = 1;
+  data->modelData->modelDataXml.nEquations = 1;
+}
+
+void setDefaultStartValues(ModelInstance *comp)
+{
+  comp->fmuData->modelData->realVarsData[0].attribute.start = 0;
+  comp->fmuData->modelData->realParameterData[0].attribute.start = 0;
+}
+
+void setStartValues(ModelInstance *comp)
+{
+  comp->fmuData->modelData->realParameterData[0].attribute.start = comp->fmuData->simulationInfo->realParameter[0];
+}
+
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  switch (vr) {
+    case y_vr: return comp->fmuData->localData[0]->realVars[0];
+    case stop_vr: return comp->fmuData->simulationInfo->realParameter[0];
+    default: return 0;
+  }
+}
+
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value)
+{
+  switch (vr) {
+    case y_vr: comp->fmuData->localData[0]->realVars[0] = value; return fmi2OK;
+    case stop_vr: comp->fmuData->simulationInfo->realParameter[0] = value; return fmi2OK;
+    default: return fmi2Error;
+  }
+}
+
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  return 0;
+}
+
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value)
+{
+  return fmi2Error;
+}
+
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  return fmi2False;
+}
+
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value)
+{
+  return fmi2Error;
+}
+
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  return "";
+}
+
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value)
+{
+  return fmi2Error;
+}
+
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value)
+{
+  return fmi2Error;
+}
+
+/* the importing tool */
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+}
+
+static const fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+
+static int runInstance(fmi2Component c, int stop, fmi2Boolean *terminated)
+{
+  const fmi2ValueReference vr = stop_vr;
+  const fmi2Real value = stop;
+  fmi2EventInfo eventInfo;
+
+  memset(&eventInfo, 0, sizeof(fmi2EventInfo));
+  if (fmi2SetupExperiment(c, fmi2False, 0, 0, fmi2False, 1) != fmi2OK) return 1;
+  if (fmi2SetReal(c, &vr, 1, &value) != fmi2OK) return 2;
+  if (fmi2EnterInitializationMode(c) != fmi2OK) return 3;
+  if (fmi2ExitInitializationMode(c) != fmi2OK) return 4;
+  if (fmi2NewDiscreteStates(c, &eventInfo) != fmi2OK) return 5;
+  if (fmi2GetBooleanStatus(c, fmi2Terminated, terminated) != fmi2OK) return 6;
+  /* both report the same */
+  if (eventInfo.terminateSimulation != *terminated) return 7;
+  return 0;
+}
+
+int test_fmuTermination()
+{
+  fmi2Component first, second;
+  fmi2Boolean terminated;
+  int rc;
+
+  first = fmi2Instantiate("first", fmi2ModelExchange, MODEL_GUID, "", &callbacks, fmi2False, fmi2False);
+  second = fmi2Instantiate("second", fmi2ModelExchange, MODEL_GUID, "", &callbacks, fmi2False, fmi2False);
+  if (!first || !second) return 1;
+
+  if ((rc = runInstance(first, 1, &terminated)) != 0) return 10 + rc;
+  if (!terminated) return 2;
+  if (strcmp(((ModelInstance*)first)->fmuData->simulationInfo->terminationMessage, "stop")) return 3;
+
+  /* the other instance keeps running */
+  if ((rc = runInstance(second, 0, &terminated)) != 0) return 20 + rc;
+  if (terminated) return 4;
+
+  /* a new run of the first instance starts without the termination of the previous one */
+  if (fmi2Terminate(first) != fmi2OK) return 5;
+  if (fmi2Reset(first) != fmi2OK) return 6;
+  if (fmi2GetBooleanStatus(first, fmi2Terminated, &terminated) != fmi2OK || terminated) return 7;
+  if ((rc = runInstance(first, 0, &terminated)) != 0) return 30 + rc;
+  if (terminated) return 8;
+
+  if (fmi2Terminate(first) != fmi2OK || fmi2Terminate(second) != fmi2OK) return 9;
+  fmi2FreeInstance(first);
+  fmi2FreeInstance(second);
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  if ( (rc = test_fmuTermination()) != 0) return 1000+rc;
+
+  /* everything OK */
+  return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+/* The gradients of -idaAdjoint compared with the forward sensitivities of
+ * -idaSensitivity and with central finite differences of whole simulations
+ * of the model
+ *
+ *   der(x1) = -p1*x1 + p2*x2,  x1(0) = 1
+ *   der(x2) = 1 - p2*x2^2,     x2(0) = 0.5
+ *   der(x3) = x2,              x3(0) = 0
+ *
+ * with p = (0.7, 0.4) until t = 2 and the objectives final(x1) and
+ * integral(x2). x3 is the integral of x2, so the forward sensitivities of
+ * x1 and x3 at the stop time are the gradients of both objectives.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulation_data.h"
+#include "util/omc_init.h"
+#include "simulation/options.h"
+#include "simulation/solver/ida_solver.h"
+#include "test_model.h"
+
+#define N_STATES 3
+#define N_PARAMS 2
+#define N_OBJECTIVES 2
+
+static const char *stateNames[2*N_STATES] = {"x1", "x2", "x3", "der(x1)", "der(x2)", "der(x3)"};
+static const char *paramNames[N_PARAMS] = {"p1", "p2"};
+
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  const double *x = data->localData[0]->realVars;
+  const double *p = data->simulationInfo->realParameter;
+  double *f = data->localData[0]->realVars + N_STATES;
+
+  f[0] = -p[0]*x[0] + p[1]*x[1];
+  f[1] = 1.0 - p[1]*x[1]*x[1];
+  f[2] = x[1];
+  return 0;
+}
+
+static int updateBoundParameters(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+/* the results of one simulation */
+typedef struct RESULT
+{
+  double objectives[N_OBJECTIVES];              /* x1(T) and x3(T) */
+  double sensitivities[N_OBJECTIVES][N_PARAMS]; /* -idaSensitivity */
+  double adjoint[N_OBJECTIVES][N_PARAMS+N_STATES]; /* -idaAdjoint, dG/dp and dG/dx(t0) */
+} RESULT;
+
+/* reads the gradients w.r.t. the parameters and the start values of each objective */
+static int readAdjointFile(const char *fileName, RESULT *result)
+{
+  char line[1024];
+  FILE *file = fopen(fileName, "r");
+  int k, j;
+
+  if (!file) return 1;
+  /* header */
+  if (!fgets(line, sizeof(line), file)) { fclose(file); return 2; }
+  for (k = 0; k < N_OBJECTIVES; k++) {
+    char *c;
+    double value;
+    if (!fgets(line, sizeof(line), file) || !(c = strchr(line, ','))) { fclose(file); return 3; }
+    value = strtod(c+1, &c);
+    /* the objective values are written too, they have to match the forward solution */
+    if (fabs(value - result->objectives[k]) > 1e-6) { fclose(file); return 4; }
+    for (j = 0; j < N_PARAMS+N_STATES; j++) {
+      if (*c != ',') { fclose(file); return 5; }
+      result->adjoint[k][j] = strtod(c+1, &c);
+    }
+  }
+  fclose(file);
+  return 0;
+}
+
+/* simulates until t = 2 with ida and the start value x1(0) = x10 */
+static int simulate(const double *p, double x10, double tolerance, int sensitivities, int adjoint, RESULT *result)
+{
+  static int sensitivityParList[N_PARAMS] = {0, 1};
+  TEST_MODEL model;
+  IDA_SOLVER *idaData = (IDA_SOLVER*) calloc(1, sizeof(IDA_SOLVER));
+  STATIC_REAL_DATA realParameterData[N_PARAMS];
+  double realParameter[N_PARAMS], sensitivityMatrix[N_STATES*N_PARAMS];
+  double *x;
+  int i, k, rc = 0;
+
+  initTestModel(&model, N_STATES, functionODE, 0.0, 2.0, tolerance);
+  setTestModelDensePattern(&model);
+  for (i = 0; i < 2*N_STATES; i++) {
+    model.modelData.realVarsData[i].info.name = stateNames[i];
+  }
+  memset(realParameterData, 0, sizeof(realParameterData));
+  for (i = 0; i < N_PARAMS; i++) {
+    realParameterData[i].info.name = paramNames[i];
+    realParameter[i] = p[i];
+  }
+  model.modelData.nParametersReal = N_PARAMS;
+  model.modelData.realParameterData = realParameterData;
+  model.simulationInfo.realParameter = realParameter;
+  model.callback.updateBoundParameters = updateBoundParameters;
+  model.modelData.nSensitivityParamVars = N_PARAMS;
+  model.simulationInfo.sensitivityParList = sensitivityParList;
+  model.simulationInfo.sensitivityMatrix = sensitivityMatrix;
+
+  x = model.localData[0]->realVars;
+  x[0] = x10;
+  x[1] = 0.5;
+  functionODE(&model.data, &model.threadData);
+
+  omc_flag[FLAG_IDA_LS] = 1;
+  omc_flagValue[FLAG_IDA_LS] = "dense";
+  omc_flag[FLAG_NO_ROOTFINDING] = 1;
+  omc_flag[FLAG_IDAS] = sensitivities;
+  omc_flag[FLAG_IDA_ADJOINT] = adjoint;
+  omc_flagValue[FLAG_IDA_ADJOINT] = "final(x1),integral(x2)";
+
+  model.solverInfo.solverData = idaData;
+  ida_solver_initial(&model.data, &model.threadData, &model.solverInfo, idaData);
+  for (k = 1; k <= model.simulationInfo.numSteps && 0 == rc; k++) {
+    beginTestModelStep(&model, 2.0*k/model.simulationInfo.numSteps);
+    rc = ida_solver_step(&model.data, &model.threadData, &model.solverInfo);
+    /* like the solver main loop, which evaluates the ODE after each step */
+    functionODE(&model.data, &model.threadData);
+  }
+  if (rc) rc = 1;
+
+  if (0 == rc) {
+    result->objectives[0] = x[0];
+    result->objectives[1] = x[2];
+    for (i = 0; i < N_PARAMS; i++) {
+      result->sensitivities[0][i] = sensitivityMatrix[i*N_STATES + 0];
+      result->sensitivities[1][i] = sensitivityMatrix[i*N_STATES + 2];
+    }
+  }
+  if (0 == rc && adjoint) {
+    if (ida_solver_adjoint(&model.data, &model.threadData, &model.solverInfo)) rc = 2;
+    else if (readAdjointFile("TestModel_adjoint.csv", result)) rc = 3;
+  }
+
+  ida_solver_deinitial(idaData);
+  free(idaData);
+  omc_flag[FLAG_IDA_LS] = 0;
+  omc_flag[FLAG_NO_ROOTFINDING] = 0;
+  omc_flag[FLAG_IDAS] = 0;
+  omc_flag[FLAG_IDA_ADJOINT] = 0;
+  freeTestModel(&model);
+  return rc;
+}
+
+static int agrees(double a, double b, double tolerance)
+{
+  return fabs(a - b) <= tolerance*fmax(1.0, fabs(b));
+}
+
+int test_forwardSensitivities()
+{
+  static const double p[N_PARAMS] = {0.7, 0.4};
+  RESULT adjoint, forward;
+  int k, j;
+
+  if (simulate(p, 1.0, 1e-8, 0, 1, &adjoint)) return 1;
+  if (simulate(p, 1.0, 1e-8, 1, 0, &forward)) return 2;
+
+  for (k = 0; k < N_OBJECTIVES; k++) {
+    for (j = 0; j < N_PARAMS; j++) {
+      printf("d%s/d%s: adjoint %.10f, forward %.10f\n", k ? "integral(x2)" : "x1(T)", paramNames[j],
+             adjoint.adjoint[k][j], forward.sensitivities[k][j]);
+      if (!agrees(adjoint.adjoint[k][j], forward.sensitivities[k][j], 1e-5)) return 10 + k*N_PARAMS + j;
+    }
+  }
+  return 0;
+}
+
+int test_finiteDifferences()
+{
+  static const double p[N_PARAMS] = {0.7, 0.4};
+  const double h = 1e-4;
+  RESULT adjoint, plus, minus;
+  double pp[N_PARAMS], fd;
+  int k, j;
+
+  if (simulate(p, 1.0, 1e-8, 0, 1, &adjoint)) return 1;
+
+  /* parameters */
+  for (j = 0; j < N_PARAMS; j++) {
+    memcpy(pp, p, sizeof(pp));
+    pp[j] = p[j] + h;
+    if (simulate(pp, 1.0, 1e-10, 0, 0, &plus)) return 2;
+    pp[j] = p[j] - h;
+    if (simulate(pp, 1.0, 1e-10, 0, 0, &minus)) return 3;
+    for (k = 0; k < N_OBJECTIVES; k++) {
+      fd = (plus.objectives[k] - minus.objectives[k]) / (2*h);
+      printf("d%s/d%s: adjoint %.10f, finite differences %.10f\n", k ? "integral(x2)" : "x1(T)", paramNames[j], adjoint.adjoint[k][j], fd);
+      if (!agrees(adjoint.adjoint[k][j], fd, 1e-4)) return 10 + k*N_PARAMS + j;
+    }
+  }
+
+  /* start value of x1 */
+  if (simulate(p, 1.0 + h, 1e-10, 0, 0, &plus)) return 4;
+  if (simulate(p, 1.0 - h, 1e-10, 0, 0, &minus)) return 5;
+  for (k = 0; k < N_OBJECTIVES; k++) {
+    fd = (plus.objectives[k] - minus.objectives[k]) / (2*h);
+    printf("d%s/dstart(x1): adjoint %.10f, finite differences %.10f\n", k ? "integral(x2)" : "x1(T)", adjoint.adjoint[k][N_PARAMS], fd);
+    if (!agrees(adjoint.adjoint[k][N_PARAMS], fd, 1e-4)) return 20 + k;
+  }
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_forwardSensitivities()) != 0) return 1000+rc;
+  if ( (rc = test_finiteDifferences()) != 0) return 2000+rc;
+
+  /* everything OK */
+  return 0;
+}
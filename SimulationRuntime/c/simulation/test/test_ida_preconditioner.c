@@ -0,0 +1,400 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+/* The preconditioners of the iterative linear solvers of ida (-idaPrec) and
+ * the jacobian-vector products with the directional derivative
+ * (-jacobian=coloredSymbolical) on the method of lines discretisation of
+ *
+ *   der(u) = laplace(u) - 5*der(u, x) - u^3  on (0,1)^2,  u = 0 on the boundary
+ *
+ * with mx x my interior grid points, centred diffusion and upwind
+ * convection. The factorizations are checked directly on M = J - cj*I, the
+ * simulations with spgmr against the dense direct solver and against spgmr
+ * without preconditioner. The Krylov iterations of each run are printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulation_data.h"
+#include "util/omc_init.h"
+#include "simulation/options.h"
+#include "simulation/solver/ida_solver.h"
+#include "test_model.h"
+
+#include <idas/idas_spils.h>
+
+#define DIFFUSION 1.0
+#define CONVECTION 5.0
+
+/* the grid of the model */
+static int mx, my;
+
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  const int n = mx*my;
+  const double *u = data->localData[0]->realVars;
+  double *f = data->localData[0]->realVars + n;
+  const double hx = 1.0/(mx+1), hy = 1.0/(my+1);
+  int i, j, k;
+
+  for (j = 0; j < my; j++) {
+    for (i = 0; i < mx; i++) {
+      double uw, ue, us, un;
+      k = i + mx*j;
+      uw = i > 0 ? u[k-1] : 0.0;
+      ue = i < mx-1 ? u[k+1] : 0.0;
+      us = j > 0 ? u[k-mx] : 0.0;
+      un = j < my-1 ? u[k+mx] : 0.0;
+      f[k] = DIFFUSION*((uw - 2*u[k] + ue)/(hx*hx) + (us - 2*u[k] + un)/(hy*hy))
+           - CONVECTION*(u[k] - uw)/hx - u[k]*u[k]*u[k];
+    }
+  }
+  return 0;
+}
+
+/* the directional derivative of functionODE like the generated one, resultVars = J*seedVars */
+static int functionJacA_column(void *inData, threadData_t *threadData)
+{
+  DATA *data = (DATA*) inData;
+  ANALYTIC_JACOBIAN *jac = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A];
+  const double *u = data->localData[0]->realVars;
+  const double *v = jac->seedVars;
+  const double hx = 1.0/(mx+1), hy = 1.0/(my+1);
+  int i, j, k;
+
+  for (j = 0; j < my; j++) {
+    for (i = 0; i < mx; i++) {
+      double vw, ve, vs, vn;
+      k = i + mx*j;
+      vw = i > 0 ? v[k-1] : 0.0;
+      ve = i < mx-1 ? v[k+1] : 0.0;
+      vs = j > 0 ? v[k-mx] : 0.0;
+      vn = j < my-1 ? v[k+mx] : 0.0;
+      jac->resultVars[k] = DIFFUSION*((vw - 2*v[k] + ve)/(hx*hx) + (vs - 2*v[k] + vn)/(hy*hy))
+                         - CONVECTION*(v[k] - vw)/hx - 3*u[k]*u[k]*v[k];
+    }
+  }
+  return 0;
+}
+
+/* the 5-point stencil, colored with (i + 3*j) mod 5 */
+static void setGridPattern(TEST_MODEL *model)
+{
+  SPARSE_PATTERN *pattern = &model->jacobian.sparsePattern;
+  const int n = mx*my;
+  int i, j, k, nz = 0;
+
+  pattern->leadindex = (unsigned int*) calloc(n, sizeof(unsigned int));
+  pattern->index = (unsigned int*) calloc(5*n, sizeof(unsigned int));
+  pattern->colorCols = (unsigned int*) calloc(n, sizeof(unsigned int));
+
+  /* column k holds the rows of its neighbours in increasing order, leadindex[k] is its end */
+  for (j = 0; j < my; j++) {
+    for (i = 0; i < mx; i++) {
+      k = i + mx*j;
+      if (j > 0) pattern->index[nz++] = k-mx;
+      if (i > 0) pattern->index[nz++] = k-1;
+      pattern->index[nz++] = k;
+      if (i < mx-1) pattern->index[nz++] = k+1;
+      if (j < my-1) pattern->index[nz++] = k+mx;
+      pattern->leadindex[k] = nz;
+      pattern->colorCols[k] = (i + 3*j) % 5 + 1;
+    }
+  }
+  pattern->sizeofIndex = nz;
+  pattern->numberOfNoneZeros = nz;
+  pattern->maxColors = n < 5 ? n : 5;
+}
+
+static void initGridModel(TEST_MODEL *model, int nx, int ny, double tolerance)
+{
+  int i, j, n;
+
+  mx = nx;
+  my = ny;
+  n = mx*my;
+  initTestModel(model, n, functionODE, 0.0, 0.1, tolerance);
+  setGridPattern(model);
+  model->callback.functionJacA_column = functionJacA_column;
+  model->jacobian.seedVars = (double*) calloc(n, sizeof(double));
+  model->jacobian.resultVars = (double*) calloc(n, sizeof(double));
+  model->simulationInfo.numSteps = 10;
+  model->simulationInfo.stepSize = 0.01;
+
+  for (j = 0; j < my; j++) {
+    for (i = 0; i < mx; i++) {
+      double x = (i+1.0)/(mx+1), y = (j+1.0)/(my+1);
+      model->localData[0]->realVars[i + mx*j] = 16*x*(1-x)*y*(1-y);
+    }
+  }
+  functionODE(&model->data, &model->threadData);
+}
+
+static void freeGridModel(TEST_MODEL *model)
+{
+  free(model->jacobian.seedVars);
+  free(model->jacobian.resultVars);
+  freeTestModel(model);
+}
+
+/* z = (J - cj*I)*v with the directional derivative */
+static void shiftedJacobianTimesVector(TEST_MODEL *model, double cj, const double *v, double *z)
+{
+  const int n = mx*my;
+  int k;
+
+  memcpy(model->jacobian.seedVars, v, n*sizeof(double));
+  functionJacA_column(&model->data, &model->threadData);
+  for (k = 0; k < n; k++) {
+    z[k] = model->jacobian.resultVars[k] - cj*v[k];
+  }
+}
+
+/* preconditioner of J - cj*I at the start values, J in the order of the sparsity pattern */
+static IDA_PRECONDITIONER* factorize(TEST_MODEL *model, int method, double cj)
+{
+  SPARSE_PATTERN *pattern = &model->jacobian.sparsePattern;
+  const int n = mx*my;
+  unsigned int *colPtr = (unsigned int*) malloc((n+1)*sizeof(unsigned int));
+  double *values = (double*) malloc(pattern->numberOfNoneZeros*sizeof(double));
+  double *e = (double*) calloc(n, sizeof(double));
+  IDA_PRECONDITIONER *prec;
+  unsigned int nth;
+  int k;
+
+  colPtr[0] = 0;
+  memcpy(colPtr + 1, pattern->leadindex, n*sizeof(unsigned int));
+  for (k = 0; k < n; k++) {
+    e[k] = 1.0;
+    memcpy(model->jacobian.seedVars, e, n*sizeof(double));
+    functionJacA_column(&model->data, &model->threadData);
+    for (nth = colPtr[k]; nth < colPtr[k+1]; nth++) {
+      values[nth] = model->jacobian.resultVars[pattern->index[nth]];
+    }
+    e[k] = 0.0;
+  }
+
+  prec = ida_prec_allocate(method, 0, n, colPtr, pattern->index);
+  ida_prec_setJacobian(prec, values);
+  if (ida_prec_factorize(prec, -cj)) {
+    ida_prec_free(prec);
+    prec = NULL;
+  }
+
+  free(colPtr);
+  free(values);
+  free(e);
+  return prec;
+}
+
+/* ||r - M*P^-1*r|| / ||r|| with M = J - cj*I */
+static double preconditionedResidual(TEST_MODEL *model, IDA_PRECONDITIONER *prec, double cj)
+{
+  const int n = mx*my;
+  double *r = (double*) malloc(n*sizeof(double));
+  double *z = (double*) malloc(n*sizeof(double));
+  double *Mz = (double*) malloc(n*sizeof(double));
+  double norm = 0.0, normDiff = 0.0;
+  int k;
+
+  for (k = 0; k < n; k++) {
+    r[k] = sin(1.0 + 7.0*k) + 0.5;
+  }
+  ida_prec_solve(prec, r, z);
+  shiftedJacobianTimesVector(model, cj, z, Mz);
+  for (k = 0; k < n; k++) {
+    norm += r[k]*r[k];
+    normDiff += (r[k] - Mz[k])*(r[k] - Mz[k]);
+  }
+
+  free(r);
+  free(z);
+  free(Mz);
+  return sqrt(normDiff/norm);
+}
+
+/* on a single grid line the jacobian is tridiagonal and one strong component
+ * of 20 variables, so every preconditioner is an exact LU decomposition */
+int test_exactFactorizations()
+{
+  TEST_MODEL model;
+  IDA_PRECONDITIONER *prec;
+  int method;
+  double residual;
+
+  initGridModel(&model, 20, 1, 1e-6);
+  for (method = IDA_PREC_BJAC; method <= IDA_PREC_ILUT; method++) {
+    if (!(prec = factorize(&model, method, 100.0))) return method;
+    residual = preconditionedResidual(&model, prec, 100.0);
+    printf("%s on a grid line: relative residual %g\n", IDA_PREC_METHOD[method], residual);
+    ida_prec_free(prec);
+    if (residual > 1e-12) return 10 + method;
+  }
+  freeGridModel(&model);
+  return 0;
+}
+
+/* on the 12 x 12 grid the preconditioners approximate J - cj*I */
+int test_approximateFactorizations()
+{
+  TEST_MODEL model;
+  IDA_PRECONDITIONER *prec;
+  int method;
+  double residual;
+
+  initGridModel(&model, 12, 12, 1e-6);
+  for (method = IDA_PREC_BJAC; method <= IDA_PREC_ILUT; method++) {
+    if (!(prec = factorize(&model, method, 10.0))) return method;
+    residual = preconditionedResidual(&model, prec, 10.0);
+    printf("%s on the 12 x 12 grid: relative residual %g\n", IDA_PREC_METHOD[method], residual);
+    ida_prec_free(prec);
+    if (residual > 0.9) return 10 + method;
+  }
+  freeGridModel(&model);
+  return 0;
+}
+
+/* the statistics of one simulation */
+typedef struct RUN
+{
+  const char *linearSolver;
+  const char *jacobian;
+  const char *preconditioner;    /* NULL without -idaPrec */
+  long steps;
+  long krylovIterations;
+  unsigned long precJacobians;
+} RUN;
+
+/* simulates the 12 x 12 grid until t = 0.1 with ida, u holds the final values */
+static int simulate(RUN *run, double *u)
+{
+  TEST_MODEL model;
+  IDA_SOLVER *idaData = (IDA_SOLVER*) calloc(1, sizeof(IDA_SOLVER));
+  int k, rc = 0;
+
+  initGridModel(&model, 12, 12, 1e-6);
+
+  omc_flag[FLAG_IDA_LS] = 1;
+  omc_flagValue[FLAG_IDA_LS] = run->linearSolver;
+  omc_flag[FLAG_JACOBIAN] = 1;
+  omc_flagValue[FLAG_JACOBIAN] = run->jacobian;
+  omc_flag[FLAG_IDA_PREC] = NULL != run->preconditioner;
+  omc_flagValue[FLAG_IDA_PREC] = run->preconditioner;
+  omc_flag[FLAG_NO_ROOTFINDING] = 1;
+
+  model.solverInfo.solverData = idaData;
+  ida_solver_initial(&model.data, &model.threadData, &model.solverInfo, idaData);
+  for (k = 1; k <= model.simulationInfo.numSteps && 0 == rc; k++) {
+    beginTestModelStep(&model, k*model.simulationInfo.stepSize);
+    rc = ida_solver_step(&model.data, &model.threadData, &model.solverInfo);
+    /* like the solver main loop, which evaluates the ODE after each step */
+    functionODE(&model.data, &model.threadData);
+  }
+
+  IDAGetNumSteps(idaData->ida_mem, &run->steps);
+  run->krylovIterations = 0;
+  if (strcmp(run->linearSolver, "dense")) {
+    IDASpilsGetNumLinIters(idaData->ida_mem, &run->krylovIterations);
+  }
+  run->precJacobians = idaData->preconditioner ? idaData->preconditioner->numJacobians : 0;
+  memcpy(u, model.localData[0]->realVars, mx*my*sizeof(double));
+
+  ida_solver_deinitial(idaData);
+  free(idaData);
+  omc_flag[FLAG_IDA_LS] = 0;
+  omc_flag[FLAG_JACOBIAN] = 0;
+  omc_flag[FLAG_IDA_PREC] = 0;
+  omc_flag[FLAG_NO_ROOTFINDING] = 0;
+  freeGridModel(&model);
+  return rc;
+}
+
+static int agrees(const double *u, const double *reference, int n)
+{
+  int k;
+  for (k = 0; k < n; k++) {
+    if (fabs(u[k] - reference[k]) > 1e-4*fmax(1.0, fabs(reference[k]))) return 0;
+  }
+  return 1;
+}
+
+int test_simulations()
+{
+  enum {NONE_NUMERICAL, NONE_SYMBOLICAL, BJAC, ILU0, ILUT, ILU0_NUMERICAL, N_RUNS};
+  RUN runs[N_RUNS] = {
+    {"spgmr", "coloredNumerical", NULL},
+    {"spgmr", "coloredSymbolical", NULL},
+    {"spgmr", "coloredSymbolical", "bjac"},
+    {"spgmr", "coloredSymbolical", "ilu0"},
+    {"spgmr", "coloredSymbolical", "ilut"},
+    {"spgmr", "coloredNumerical", "ilu0"}
+  };
+  RUN dense = {"dense", "coloredNumerical", NULL};
+  double reference[144], u[144];
+  int k;
+
+  if (simulate(&dense, reference)) return 1;
+  printf("dense: %ld steps\n", dense.steps);
+
+  for (k = 0; k < N_RUNS; k++) {
+    if (simulate(&runs[k], u)) return 10 + k;
+    printf("%s %s %s: %ld steps, %ld Krylov iterations, %lu preconditioner jacobians\n", runs[k].linearSolver,
+           runs[k].jacobian, runs[k].preconditioner ? runs[k].preconditioner : "none", runs[k].steps,
+           runs[k].krylovIterations, runs[k].precJacobians);
+    if (!agrees(u, reference, 144)) return 20 + k;
+  }
+
+  /* the incomplete factorizations need fewer Krylov iterations than unpreconditioned
+   * spgmr with the same jacobian-vector products. Block jacobi neglects the coupling of
+   * the grid lines at the block boundaries and is only checked for the results. */
+  for (k = BJAC; k <= ILU0_NUMERICAL; k++) {
+    if (0 == runs[k].precJacobians) return 30 + k;
+    if (k != BJAC && runs[k].krylovIterations >= runs[k == ILU0_NUMERICAL ? NONE_NUMERICAL : NONE_SYMBOLICAL].krylovIterations) return 40 + k;
+  }
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_exactFactorizations()) != 0) return 1000+rc;
+  if ( (rc = test_approximateFactorizations()) != 0) return 2000+rc;
+  if ( (rc = test_simulations()) != 0) return 3000+rc;
+
+  /* everything OK */
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_model.h"
+
+static int noFunction(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static int noZeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  return 0;
+}
+
+/* the pattern is set up by setTestModel*Pattern, a model without one has none */
+static int initialJacobianA(void *inData, threadData_t *threadData)
+{
+  DATA *data = (DATA*) inData;
+  return NULL == data->simulationInfo->analyticJacobians[0].sparsePattern.leadindex;
+}
+
+void initTestModel(TEST_MODEL *model, int nStates, int (*functionODE)(DATA*, threadData_t*), double startTime, double stopTime, double tolerance)
+{
+  int i;
+
+  memset(model, 0, sizeof(TEST_MODEL));
+
+  model->modelData.nStates = nStates;
+  model->modelData.nVariablesReal = 2*nStates;
+  model->modelData.realVarsData = (STATIC_REAL_DATA*) calloc(2*nStates, sizeof(STATIC_REAL_DATA));
+  for (i = 0; i < 2*nStates; i++) {
+    model->modelData.realVarsData[i].info.name = i < nStates ? "x" : "der(x)";
+    model->modelData.realVarsData[i].attribute.nominal = 1.0;
+    model->modelData.realVarsData[i].attribute.min = -DBL_MAX;
+    model->modelData.realVarsData[i].attribute.max = DBL_MAX;
+  }
+  model->modelData.modelFilePrefix = "TestModel";
+
+  model->simulationInfo.startTime = startTime;
+  model->simulationInfo.stopTime = stopTime;
+  model->simulationInfo.tolerance = tolerance;
+  model->simulationInfo.numSteps = 500;
+  model->simulationInfo.stepSize = (stopTime - startTime) / 500;
+  model->simulationInfo.nextSampleEvent = stopTime + 1.0;
+  model->simulationInfo.outputFormat = "empty";
+  model->simulationInfo.analyticJacobians = &model->jacobian;
+
+  for (i = 0; i < 2; i++) {
+    model->simulationData[i].realVars = (modelica_real*) calloc(2*nStates, sizeof(modelica_real));
+    model->simulationData[i].timeValue = startTime;
+    model->localData[i] = &model->simulationData[i];
+  }
+
+  /* INDEX_JAC_A is 0 */
+  model->callback.functionODE = functionODE;
+  model->callback.functionAlgebraics = noFunction;
+  model->callback.input_function = noFunction;
+  model->callback.output_function = noFunction;
+  model->callback.function_storeDelayed = noFunction;
+  model->callback.function_ZeroCrossingsEquations = noFunction;
+  model->callback.function_ZeroCrossings = noZeroCrossings;
+  model->callback.initialAnalyticJacobianA = initialJacobianA;
+
+  model->jacobian.sizeRows = nStates;
+  model->jacobian.sizeCols = nStates;
+
+  model->data.modelData = &model->modelData;
+  model->data.simulationInfo = &model->simulationInfo;
+  model->data.localData = model->localData;
+  model->data.callback = &model->callback;
+
+  model->solverInfo.currentTime = startTime;
+  model->solverInfo.solverStats = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
+  model->solverInfo.solverStatsTmp = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
+}
+
+void setTestModelBandPattern(TEST_MODEL *model, int lower, int upper)
+{
+  SPARSE_PATTERN *pattern = &model->jacobian.sparsePattern;
+  int n = model->modelData.nStates, i, j, k = 0;
+
+  pattern->leadindex = (unsigned int*) calloc(n, sizeof(unsigned int));
+  pattern->index = (unsigned int*) calloc(n*(lower+upper+1), sizeof(unsigned int));
+  pattern->colorCols = (unsigned int*) calloc(n, sizeof(unsigned int));
+
+  /* column j holds the rows j-upper .. j+lower, leadindex[j] is the end of column j */
+  for (j = 0; j < n; j++) {
+    for (i = j-upper; i <= j+lower; i++) {
+      if (i >= 0 && i < n) {
+        pattern->index[k++] = i;
+      }
+    }
+    pattern->leadindex[j] = k;
+    pattern->colorCols[j] = j % (lower+upper+1) + 1;
+  }
+  pattern->sizeofIndex = k;
+  pattern->numberOfNoneZeros = k;
+  pattern->maxColors = lower+upper+1 < n ? lower+upper+1 : n;
+}
+
+void setTestModelDensePattern(TEST_MODEL *model)
+{
+  int n = model->modelData.nStates;
+  setTestModelBandPattern(model, n-1, n-1);
+  model->jacobian.sparsePattern.maxColors = n;
+}
+
+void beginTestModelStep(TEST_MODEL *model, double tout)
+{
+  int n = model->modelData.nVariablesReal;
+
+  model->simulationData[1].timeValue = model->simulationData[0].timeValue;
+  memcpy(model->simulationData[1].realVars, model->simulationData[0].realVars, n*sizeof(modelica_real));
+  model->solverInfo.currentStepSize = tout - model->solverInfo.currentTime;
+}
+
+void freeTestModel(TEST_MODEL *model)
+{
+  free(model->modelData.realVarsData);
+  free(model->simulationData[0].realVars);
+  free(model->simulationData[1].realVars);
+  free(model->jacobian.sparsePattern.leadindex);
+  free(model->jacobian.sparsePattern.index);
+  free(model->jacobian.sparsePattern.colorCols);
+  free(model->solverInfo.solverStats);
+  free(model->solverInfo.solverStatsTmp);
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! \file test_model.h
+ *
+ *  A hand written model of nStates ODEs for the solver tests and benchmarks.
+ *  It provides just the parts of DATA, SOLVER_INFO and the generated
+ *  callbacks that the integrators use: two SIMULATION_DATA slots with
+ *  states followed by their derivatives, functionODE and the sparsity
+ *  pattern and coloring of the ODE jacobian (INDEX_JAC_A).
+ */
+
+#ifndef _TEST_MODEL_H_
+#define _TEST_MODEL_H_
+
+#include "simulation_data.h"
+#include "simulation/solver/solver_main.h"
+
+typedef struct TEST_MODEL
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  SIMULATION_DATA simulationData[2];
+  SIMULATION_DATA *localData[2];
+  struct OpenModelicaGeneratedFunctionCallbacks callback;
+  ANALYTIC_JACOBIAN jacobian;
+  SOLVER_INFO solverInfo;
+  threadData_t threadData;
+} TEST_MODEL;
+
+/* functionODE computes x[nStates..2*nStates-1] from the states x[0..nStates-1] */
+void initTestModel(TEST_MODEL *model, int nStates, int (*functionODE)(DATA*, threadData_t*), double startTime, double stopTime, double tolerance);
+/* the jacobian pattern of a band matrix, colored with lower+upper+1 colors */
+void setTestModelBandPattern(TEST_MODEL *model, int lower, int upper);
+/* a dense jacobian pattern, one color per column */
+void setTestModelDensePattern(TEST_MODEL *model);
+/* the last accepted step becomes localData[1], the integrator continues to tout */
+void beginTestModelStep(TEST_MODEL *model, double tout);
+void freeTestModel(TEST_MODEL *model);
+
+#endif
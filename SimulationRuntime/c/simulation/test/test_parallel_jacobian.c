@@ -0,0 +1,284 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/* The colored dassl Jacobian of a model with an algebraic loop and a delay
+ * has to be bitwise identical whether its colors are evaluated serially or on
+ * the workers of -jacobianThreads. The loop has three roots and is solved
+ * with Newton from the extrapolation of two earlier solutions, a worker that
+ * starts from other values ends up on another root. Models with external
+ * objects are always evaluated serially.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "simulation/options.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/dassl.h"
+#include "simulation/solver/parallel_jacobian.h"
+
+#define N_STATES 12
+#define INDEX_Z (2*N_STATES)
+
+typedef struct LOOP_MODEL
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  struct OpenModelicaGeneratedFunctionCallbacks callback;
+  SOLVER_INFO solverInfo;
+  threadData_t threadData;
+} LOOP_MODEL;
+
+/* z^3 - z = 0.05/n*sum(w_i*x_i), the right hand side stays below the local
+ * maximum of z^3 - z for |x_i| <= 1 */
+static void residual(void **dataIn, const double *z, double *res, const int *iflag)
+{
+  DATA *data = (DATA*) dataIn[0];
+  double *x = data->localData[0]->realVars, s = 0.0;
+  int i;
+
+  for (i = 0; i < N_STATES; i++) {
+    s += (1.0 + 0.1*i) * x[i];
+  }
+  res[0] = z[0]*z[0]*z[0] - z[0] - 0.05*s/N_STATES;
+}
+
+static void initializeStaticLoopData(void *inData, threadData_t *threadData, void *sysData)
+{
+  NONLINEAR_SYSTEM_DATA *nls = (NONLINEAR_SYSTEM_DATA*) sysData;
+  nls->nominal[0] = 1.0;
+  nls->min[0] = -1e10;
+  nls->max[0] = 1e10;
+}
+
+static void getIterationVars(DATA *data, double *z)
+{
+  z[0] = data->localData[0]->realVars[INDEX_Z];
+}
+
+static void initialNonLinearSystem(int nNonLinearSystems, NONLINEAR_SYSTEM_DATA *nls)
+{
+  memset(nls, 0, nNonLinearSystems*sizeof(NONLINEAR_SYSTEM_DATA));
+  nls[0].size = 1;
+  nls[0].jacobianIndex = -1;
+  nls[0].residualFunc = residual;
+  nls[0].initializeStaticNLSData = initializeStaticLoopData;
+  nls[0].getIterationVars = getIterationVars;
+}
+
+static void initialLinearSystem(int nLinearSystems, LINEAR_SYSTEM_DATA *data) {}
+static void initialMixedSystem(int nMixedSystems, MIXED_SYSTEM_DATA *data) {}
+static void initializeStateSets(int nStateSets, STATE_SET_DATA *statesetData, DATA *data) {}
+static int initializeDAEmodeData(DATA *data, DAEMODE_DATA *daeModeData) { return 0; }
+static int noFunction(DATA *data, threadData_t *threadData) { return 0; }
+static int initialJacobianA(void *inData, threadData_t *threadData) { return 0; }
+
+/* der(x_i) = -(1+i/n)*x_i + z/(1+i) + 0.5*delay(x_0, 0.1) for i = 0 */
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  double *x = data->localData[0]->realVars, d;
+  int i;
+
+  solve_nonlinear_system(data, threadData, 0);
+  x[INDEX_Z] = data->simulationInfo->nonlinearSystemData[0].nlsx[0];
+  d = delayImpl(data, threadData, 0, x[0], data->localData[0]->timeValue, 0.1, 0.1);
+  for (i = 0; i < N_STATES; i++) {
+    x[N_STATES+i] = -(1.0 + i/(double)N_STATES)*x[i] + x[INDEX_Z]/(1.0+i);
+  }
+  x[N_STATES] += 0.5*d;
+  return 0;
+}
+
+static void setStates(LOOP_MODEL *model, double time)
+{
+  int i;
+  model->data.localData[0]->timeValue = time;
+  for (i = 0; i < N_STATES; i++) {
+    model->data.localData[0]->realVars[i] = cos(time + 0.3*i);
+  }
+}
+
+static void initLoopModel(LOOP_MODEL *model)
+{
+  SPARSE_PATTERN *pattern;
+  int i, j;
+
+  memset(model, 0, sizeof(LOOP_MODEL));
+  model->modelData.nStates = N_STATES;
+  model->modelData.nVariablesReal = 2*N_STATES+1;
+  model->modelData.nNonLinearSystems = 1;
+  model->modelData.nDelayExpressions = 1;
+  model->modelData.nJacobians = 1;
+  model->modelData.modelFilePrefix = "LoopModel";
+  model->data.modelData = &model->modelData;
+  model->data.simulationInfo = &model->simulationInfo;
+  model->data.callback = &model->callback;
+
+  model->callback.functionODE = functionODE;
+  model->callback.input_function = noFunction;
+  model->callback.initialAnalyticJacobianA = initialJacobianA;
+  model->callback.initialNonLinearSystem = initialNonLinearSystem;
+  model->callback.initialLinearSystem = initialLinearSystem;
+  model->callback.initialMixedSystem = initialMixedSystem;
+  model->callback.initializeStateSets = initializeStateSets;
+  model->callback.initializeDAEmodeData = initializeDAEmodeData;
+
+  pthread_setspecific(mmc_thread_data_key, &model->threadData);
+  initializeDataStruc(&model->data, &model->threadData);
+  for (i = 0; i < model->modelData.nVariablesReal; i++) {
+    memset(&model->modelData.realVarsData[i], 0, sizeof(STATIC_REAL_DATA));
+    model->modelData.realVarsData[i].info.name = strdup("x");
+    model->modelData.realVarsData[i].attribute.nominal = 1.0;
+  }
+  model->simulationInfo.nlsMethod = NLS_NEWTON;
+  model->simulationInfo.tolerance = 1e-6;
+  model->simulationInfo.stepSize = 0.01;
+  initDelay(&model->data, 0.0);
+  initializeNonlinearSystems(&model->data, &model->threadData);
+  /* start on the root near 1 */
+  model->simulationInfo.nonlinearSystemData[0].nlsxOld[0] = 1.2;
+  model->simulationInfo.nonlinearSystemData[0].nlsxExtrapolation[0] = 1.2;
+
+  /* dense pattern, one color per column */
+  memset(model->simulationInfo.analyticJacobians, 0, sizeof(ANALYTIC_JACOBIAN));
+  model->simulationInfo.analyticJacobians[0].sizeRows = N_STATES;
+  model->simulationInfo.analyticJacobians[0].sizeCols = N_STATES;
+  pattern = &model->simulationInfo.analyticJacobians[0].sparsePattern;
+  pattern->leadindex = (unsigned int*) calloc(N_STATES, sizeof(unsigned int));
+  pattern->index = (unsigned int*) calloc(N_STATES*N_STATES, sizeof(unsigned int));
+  pattern->colorCols = (unsigned int*) calloc(N_STATES, sizeof(unsigned int));
+  for (j = 0; j < N_STATES; j++) {
+    for (i = 0; i < N_STATES; i++) {
+      pattern->index[j*N_STATES+i] = i;
+    }
+    pattern->leadindex[j] = (j+1)*N_STATES;
+    pattern->colorCols[j] = j+1;
+  }
+  pattern->sizeofIndex = N_STATES*N_STATES;
+  pattern->numberOfNoneZeros = N_STATES*N_STATES;
+  pattern->maxColors = N_STATES;
+}
+
+static void freeLoopModel(LOOP_MODEL *model)
+{
+  SPARSE_PATTERN *pattern = &model->simulationInfo.analyticJacobians[0].sparsePattern;
+
+  free(pattern->leadindex);
+  free(pattern->index);
+  free(pattern->colorCols);
+  freeNonlinearSystems(&model->data, &model->threadData);
+  deInitializeDataStruc(&model->data);
+}
+
+int test_parallel_jacobian()
+{
+  LOOP_MODEL model;
+  DASSL_DATA *dasslData = (DASSL_DATA*) calloc(1, sizeof(DASSL_DATA));
+  double *rpar[3];
+  double yprime[N_STATES], delta[N_STATES], wt[N_STATES];
+  double serial[N_STATES*N_STATES], parallel[N_STATES*N_STATES], again[N_STATES*N_STATES];
+  double t = 1.0, h = 1e-3, cj = 1e3, time;
+  int i, ires, rc = 0;
+
+  initLoopModel(&model);
+
+  /* history of the delay and two solutions of the loop for the extrapolation */
+  for (time = 0.0; time <= 1.0; time += 0.05) {
+    storeDelayedExpression(&model.data, &model.threadData, 0, sin(time), time, 0.1, 0.1);
+  }
+  setStates(&model, 0.98);
+  functionODE(&model.data, &model.threadData);
+  setStates(&model, 0.99);
+  functionODE(&model.data, &model.threadData);
+  setStates(&model, t);
+
+  omc_flag[FLAG_JACOBIAN_THREADS] = 1;
+  omc_flagValue[FLAG_JACOBIAN_THREADS] = "4";
+  omc_flag[FLAG_NO_ROOTFINDING] = 1;
+  dassl_initial(&model.data, &model.threadData, &model.solverInfo, dasslData);
+  if (dasslData->jacobianThreads != 4) { rc = 1; goto cleanup; }
+
+  rpar[0] = (double*) &model.data;
+  rpar[1] = (double*) dasslData;
+  rpar[2] = (double*) &model.threadData;
+  functionODE(&model.data, &model.threadData);
+  for (i = 0; i < N_STATES; i++) {
+    yprime[i] = model.data.localData[0]->realVars[N_STATES+i];
+    wt[i] = 1.0 / (1e-6*fabs(model.data.localData[0]->realVars[i]) + 1e-6);
+  }
+  dasslData->residualFunction(&t, model.data.localData[0]->realVars, yprime, &cj, delta, &ires, (double*) rpar, dasslData->ipar);
+
+  setContext(&model.data, &t, CONTEXT_JACOBIAN);
+  jacA_numColored(&model.data, &t, model.data.localData[0]->realVars, yprime, delta, parallel, &cj, &h, wt, (double*) rpar, dasslData->ipar);
+  if (!dasslData->jacobianPool || dasslData->jacobianPool->nThreads < 2) { rc = 2; goto cleanup; }
+
+  dasslData->jacobianThreads = 1;
+  jacA_numColored(&model.data, &t, model.data.localData[0]->realVars, yprime, delta, serial, &cj, &h, wt, (double*) rpar, dasslData->ipar);
+  dasslData->jacobianThreads = 4;
+  jacA_numColored(&model.data, &t, model.data.localData[0]->realVars, yprime, delta, again, &cj, &h, wt, (double*) rpar, dasslData->ipar);
+  unsetContext(&model.data);
+
+  if (fabs(model.data.localData[0]->realVars[INDEX_Z] - 1.0) > 0.1) { rc = 3; goto cleanup; }
+  if (memcmp(serial, parallel, sizeof(serial))) { rc = 4; goto cleanup; }
+  if (memcmp(serial, again, sizeof(serial))) { rc = 5; goto cleanup; }
+
+  /* opaque external objects can not be shared with the workers */
+  model.modelData.nExtObjs = 1;
+  if (getJacobianThreads(&model.data) != 1) { rc = 6; }
+  model.modelData.nExtObjs = 0;
+
+cleanup:
+  omc_flag[FLAG_JACOBIAN_THREADS] = 0;
+  omc_flag[FLAG_NO_ROOTFINDING] = 0;
+  dassl_deinitial(dasslData);
+  freeLoopModel(&model);
+  return rc;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_parallel_jacobian()) != 0) return 1000+rc;
+
+  /* everything OK */
+  return 0;
+}
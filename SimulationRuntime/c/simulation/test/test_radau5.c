@@ -0,0 +1,175 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/* Van der Pol, Robertson and HIRES from Hairer and Wanner, "Solving
+ * Ordinary Differential Equations II", integrated with radau5 and compared
+ * with the reference solutions given there and in the IVP test set.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "simulation_data.h"
+#include "util/omc_init.h"
+#include "simulation/solver/radau5.h"
+#include "test_model.h"
+
+static int vanDerPol(DATA *data, threadData_t *threadData)
+{
+  const double *y = data->localData[0]->realVars;
+  double *f = data->localData[0]->realVars + 2;
+
+  f[0] = y[1];
+  f[1] = ((1.0 - y[0]*y[0])*y[1] - y[0])/1e-6;
+  return 0;
+}
+
+static int robertson(DATA *data, threadData_t *threadData)
+{
+  const double *y = data->localData[0]->realVars;
+  double *f = data->localData[0]->realVars + 3;
+
+  f[0] = -0.04*y[0] + 1e4*y[1]*y[2];
+  f[2] = 3e7*y[1]*y[1];
+  f[1] = -f[0] - f[2];
+  return 0;
+}
+
+static int hires(DATA *data, threadData_t *threadData)
+{
+  const double *y = data->localData[0]->realVars;
+  double *f = data->localData[0]->realVars + 8;
+
+  f[0] = -1.71*y[0] + 0.43*y[1] + 8.32*y[2] + 0.0007;
+  f[1] = 1.71*y[0] - 8.75*y[1];
+  f[2] = -10.03*y[2] + 0.43*y[3] + 0.035*y[4];
+  f[3] = 8.32*y[1] + 1.71*y[2] - 1.12*y[3];
+  f[4] = -1.745*y[4] + 0.43*y[5] + 0.43*y[6];
+  f[5] = -280.0*y[5]*y[7] + 0.69*y[3] + 1.71*y[4] - 0.43*y[5] + 0.69*y[6];
+  f[6] = 280.0*y[5]*y[7] - 1.81*y[6];
+  f[7] = -f[6];
+  return 0;
+}
+
+/* integrates over 100 output intervals and returns the largest relative error of the end values */
+static int integrate(TEST_MODEL *model, const double *reference, double *maxError)
+{
+  double stopTime = model->simulationInfo.stopTime;
+  double *y = model->localData[0]->realVars;
+  int n = model->modelData.nStates, i, k;
+
+  model->callback.functionODE(&model->data, &model->threadData);
+  if (allocateRadau5(&model->data, &model->threadData, &model->solverInfo)) return 1;
+  for (k = 1; k <= 100; k++) {
+    beginTestModelStep(model, stopTime*k/100);
+    if (radau5_step(&model->data, &model->threadData, &model->solverInfo)) return 2;
+    if (fabs(model->solverInfo.currentTime - stopTime*k/100) > 1e-12*stopTime) return 3;
+  }
+  freeRadau5(&model->solverInfo);
+
+  *maxError = 0.0;
+  for (i = 0; i < n; i++) {
+    *maxError = fmax(*maxError, fabs(y[i] - reference[i])/fabs(reference[i]));
+  }
+  printf("%g relative error at t = %g, %u steps, %u jacobians\n", *maxError, stopTime,
+         model->solverInfo.solverStatsTmp[0], model->solverInfo.solverStatsTmp[2]);
+  return 0;
+}
+
+int test_vanDerPol()
+{
+  static const double reference[2] = {1.706167732170469, -0.8928097010248125};
+  TEST_MODEL model;
+  double err;
+  int rc;
+
+  initTestModel(&model, 2, vanDerPol, 0.0, 2.0, 1e-8);
+  model.localData[0]->realVars[0] = 2.0;
+  rc = integrate(&model, reference, &err);
+  freeTestModel(&model);
+  if (rc) return rc;
+  if (err > 1e-6) return 10;
+  return 0;
+}
+
+int test_robertson()
+{
+  static const double reference[3] = {0.7158270687, 0.9185534764e-5, 0.2841637457};
+  TEST_MODEL model;
+  double err, *y;
+  int rc;
+
+  initTestModel(&model, 3, robertson, 0.0, 40.0, 1e-8);
+  y = model.localData[0]->realVars;
+  y[0] = 1.0;
+  rc = integrate(&model, reference, &err);
+  if (0 == rc && err > 1e-6) rc = 10;
+  /* the sum of the concentrations is conserved */
+  if (0 == rc && fabs(y[0] + y[1] + y[2] - 1.0) > 1e-12) rc = 11;
+  freeTestModel(&model);
+  return rc;
+}
+
+int test_hires()
+{
+  static const double reference[8] = {0.7371312573325668e-3, 0.1442485726316185e-3, 0.5888729740967575e-4, 0.1175651343283149e-2,
+                                      0.2386356198831331e-2, 0.6238968252742796e-2, 0.2849998395185769e-2, 0.2850001604814231e-2};
+  TEST_MODEL model;
+  double err;
+  int rc;
+
+  /* with the coloring of a dense pattern, the other two use radau5's own dense jacobian */
+  initTestModel(&model, 8, hires, 0.0, 321.8122, 1e-8);
+  setTestModelDensePattern(&model);
+  model.localData[0]->realVars[0] = 1.0;
+  model.localData[0]->realVars[7] = 0.0057;
+  rc = integrate(&model, reference, &err);
+  freeTestModel(&model);
+  if (rc) return rc;
+  if (err > 1e-4) return 10;
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_vanDerPol()) != 0) return 1000+rc;
+  if ( (rc = test_robertson()) != 0) return 2000+rc;
+  if ( (rc = test_hires()) != 0) return 3000+rc;
+
+  /* everything OK */
+  return 0;
+}
@@ -0,0 +1,380 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+/* Real-time stepping of the model
+ *
+ *   model Threshold
+ *     parameter Real k = 1;
+ *     Real x(start = 1, fixed = true);
+ *   equation
+ *     der(x) = if x < 0.5 then -0.5*k*x else -k*x;
+ *   end Threshold;
+ *
+ * with the explicit Euler method, -rt and -rtPrealloc. The runtime is built
+ * with the OMC_RT_ALLOC_TRACKING interposition of malloc and free, which has
+ * to count no allocation in the main simulation loop, including the state
+ * event at x = 0.5. Every synchronized step has to be in the latency
+ * histogram and in <model>_rt_latency.csv.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "util/alloc_tracking.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/solver_main.h"
+
+#define prefixedName_performSimulation Threshold_performSimulation
+#define prefixedName_updateContinuousSystem Threshold_updateContinuousSystem
+#include "simulation/solver/perform_simulation.c"
+
+static const char *latencyFile = "Threshold_rt_latency.csv";
+
+/* the equations of the model */
+
+static int Threshold_functionODE(DATA *data, threadData_t *threadData)
+{
+  modelica_boolean tmp0;
+  double k = data->simulationInfo->realParameter[0];
+  RELATIONHYSTERESIS(tmp0, data->localData[0]->realVars[0], 0.5, 0, Less);
+  data->localData[0]->realVars[1] = (tmp0 ? -0.5*k : -k) * data->localData[0]->realVars[0];
+  return 0;
+}
+
+static int Threshold_functionDAE(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->discreteCall = 1;
+  Threshold_functionODE(data, threadData);
+  data->simulationInfo->discreteCall = 0;
+  return 0;
+}
+
+static int Threshold_return0(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static int Threshold_zeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  modelica_boolean tmp0;
+  tmp0 = LessZC(data->localData[0]->realVars[0], 0.5, data->simulationInfo->storedRelations[0]);
+  gout[0] = tmp0 ? 1 : -1;
+  return 0;
+}
+
+static int Threshold_updateRelations(DATA *data, threadData_t *threadData, int evalforZeroCross)
+{
+  if (evalforZeroCross) {
+    data->simulationInfo->relations[0] = LessZC(data->localData[0]->realVars[0], 0.5, data->simulationInfo->storedRelations[0]);
+  } else {
+    data->simulationInfo->relations[0] = data->localData[0]->realVars[0] < 0.5;
+  }
+  return 0;
+}
+
+static void Threshold_externalObjects(DATA *data, threadData_t *threadData)
+{
+}
+
+static void Threshold_initialNonLinearSystem(int n, NONLINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Threshold_initialLinearSystem(int n, LINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Threshold_initialMixedSystem(int n, MIXED_SYSTEM_DATA *data)
+{
+}
+
+static void Threshold_initializeStateSets(int n, STATE_SET_DATA *statesetData, DATA *data)
+{
+}
+
+static int Threshold_initializeDAEmodeData(DATA *data, DAEMODE_DATA *daeModeData)
+{
+  return 0;
+}
+
+static void Threshold_initSample(DATA *data, threadData_t *threadData)
+{
+}
+
+static void Threshold_initSynchronous(DATA *data, threadData_t *threadData)
+{
+}
+
+static int Threshold_initialAnalyticJacobian(void *data, threadData_t *threadData)
+{
+  return 1;
+}
+
+static int Threshold_functionInitialEquations(DATA *data, threadData_t *threadData)
+{
+  data->localData[0]->realVars[0] = data->modelData->realVarsData[0].attribute.start;
+  Threshold_functionDAE(data, threadData);
+  return 0;
+}
+
+static int Threshold_updateBoundParameters(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->realParameter[0] = data->modelData->realParameterData[0].attribute.start;
+  return 0;
+}
+
+static const char *Threshold_relationDescription(int i)
+{
+  return "x < 0.5";
+}
+
+static const char *Threshold_zeroCrossingDescription(int i, int **out_EquationIndexes)
+{
+  static int occurEqs[] = {1, 0};
+  *out_EquationIndexes = occurEqs;
+  return "x < 0.5";
+}
+
+static struct OpenModelicaGeneratedFunctionCallbacks Threshold_callback = {
+  .performSimulation = (int (*)(DATA*, threadData_t*, void*)) Threshold_performSimulation,
+  .updateContinuousSystem = Threshold_updateContinuousSystem,
+  .callExternalObjectConstructors = Threshold_externalObjects,
+  .callExternalObjectDestructors = Threshold_externalObjects,
+  .initialNonLinearSystem = Threshold_initialNonLinearSystem,
+  .initialLinearSystem = Threshold_initialLinearSystem,
+  .initialMixedSystem = Threshold_initialMixedSystem,
+  .initializeStateSets = Threshold_initializeStateSets,
+  .initializeDAEmodeData = Threshold_initializeDAEmodeData,
+  .functionODE = Threshold_functionODE,
+  .functionAlgebraics = Threshold_return0,
+  .functionDAE = Threshold_functionDAE,
+  .functionLocalKnownVars = Threshold_return0,
+  .input_function = Threshold_return0,
+  .input_function_init = Threshold_return0,
+  .input_function_updateStartValues = Threshold_return0,
+  .output_function = Threshold_return0,
+  .function_storeDelayed = Threshold_return0,
+  .updateBoundVariableAttributes = Threshold_return0,
+  .functionInitialEquations = Threshold_functionInitialEquations,
+  .functionInitialEquations_lambda0 = NULL,
+  .functionRemovedInitialEquations = Threshold_return0,
+  .updateBoundParameters = Threshold_updateBoundParameters,
+  .checkForAsserts = Threshold_return0,
+  .function_ZeroCrossingsEquations = Threshold_return0,
+  .function_ZeroCrossings = Threshold_zeroCrossings,
+  .function_updateRelations = Threshold_updateRelations,
+  .checkForDiscreteChanges = Threshold_return0,
+  .zeroCrossingDescription = Threshold_zeroCrossingDescription,
+  .relationDescription = Threshold_relationDescription,
+  .function_initSample = Threshold_initSample,
+  .INDEX_JAC_A = 0,
+  .initialAnalyticJacobianA = Threshold_initialAnalyticJacobian,
+  .function_initSynchronous = Threshold_initSynchronous
+};
+
+static const char Threshold_infoJson[] = "{\"format\":\"Transformational debugger info\",\"version\":1,\n"
+  "\"info\":{\"name\":\"Threshold\",\"description\":\"\"},\n"
+  "\"variables\":{},\n"
+  "\"equations\":[{\"eqIndex\":0,\"tag\":\"dummy\"},{\"eqIndex\":1,\"tag\":\"dummy\"}],\n"
+  "\"functions\":[]\n"
+  "}";
+
+static const VAR_INFO Threshold_xInfo = {0,-1,"x","",omc_dummyFileInfo};
+static const VAR_INFO Threshold_derxInfo = {1,-1,"der(x)","",omc_dummyFileInfo};
+static const VAR_INFO Threshold_kInfo = {2,-1,"k","",omc_dummyFileInfo};
+
+/* what setupDataStruc, the init file and _main_SimulationRuntime do for the generated model */
+static void setupThreshold(DATA *data, MODEL_DATA *modelData, SIMULATION_INFO *simulationInfo, threadData_t *threadData)
+{
+  int i;
+
+  memset(data, 0, sizeof(DATA));
+  memset(modelData, 0, sizeof(MODEL_DATA));
+  memset(simulationInfo, 0, sizeof(SIMULATION_INFO));
+  data->modelData = modelData;
+  data->simulationInfo = simulationInfo;
+  data->callback = &Threshold_callback;
+
+  modelData->modelName = "Threshold";
+  modelData->modelFilePrefix = "Threshold";
+  modelData->resultFileName = "Threshold_res.mat";
+  modelData->modelDataXml.fileName = "Threshold_info.json";
+  modelData->modelDataXml.infoXMLData = Threshold_infoJson;
+  modelData->modelDataXml.modelInfoXmlLength = sizeof(Threshold_infoJson) - 1;
+  modelData->modelDataXml.nEquations = 2;
+  modelData->nStates = 1;
+  modelData->nVariablesReal = 2;
+  modelData->nParametersReal = 1;
+  modelData->nZeroCrossings = 1;
+  modelData->nRelations = 1;
+
+  simulationInfo->startTime = 0;
+  simulationInfo->stopTime = 1;
+  simulationInfo->numSteps = 100;
+  simulationInfo->stepSize = 1e-2;
+  simulationInfo->tolerance = 1e-6;
+  simulationInfo->solverMethod = "euler";
+  simulationInfo->outputFormat = "empty";
+  simulationInfo->variableFilter = ".*";
+
+  initializeDataStruc(data, threadData);
+  initializeTermination(simulationInfo, threadData);
+  for (i = 0; i < 2; i++) {
+    modelData->realVarsData[i].info = i ? Threshold_derxInfo : Threshold_xInfo;
+    modelData->realVarsData[i].attribute.start = i ? 0 : 1;
+    modelData->realVarsData[i].attribute.fixed = !i;
+    modelData->realVarsData[i].attribute.nominal = 1;
+    modelData->realVarsData[i].attribute.min = -DBL_MAX;
+    modelData->realVarsData[i].attribute.max = DBL_MAX;
+  }
+  modelData->realParameterData[0].info = Threshold_kInfo;
+  modelData->realParameterData[0].attribute.start = 1;
+  modelData->realParameterData[0].attribute.fixed = 1;
+  modelData->realParameterData[0].attribute.nominal = 1;
+  modelData->realParameterData[0].attribute.min = -DBL_MAX;
+  modelData->realParameterData[0].attribute.max = DBL_MAX;
+  modelData->sharedVarInfo = 1;
+
+  initializeMixedSystems(data, threadData);
+  initializeLinearSystems(data, threadData);
+  initializeNonlinearSystems(data, threadData);
+}
+
+/* the tracking is active, otherwise the test proves nothing */
+int test_tracking()
+{
+  void *volatile p;
+
+  omc_alloc_tracking_start();
+  p = malloc(16);
+  free(p);
+  if (omc_alloc_tracking_stop() != 2) return 1;
+  return 0;
+}
+
+int test_preallocatedSteps()
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  threadData_t threadData;
+  real_time_sync_t *rt = &data.real_time_sync;
+  unsigned long nAllocations;
+  uint64_t nHistogram = 0, nFile = 0;
+  long long lower, upper;
+  unsigned long steps;
+  FILE *file;
+  char line[256];
+  int i;
+
+  memset(&threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, &threadData);
+  setupThreshold(&data, &modelData, &simulationInfo, &threadData);
+  remove(latencyFile);
+
+  /* stdio allocates its buffer on the first output, a missed deadline is logged during the steps */
+  printf("simulating Threshold with -rt=0.1 -rtPrealloc=1\n");
+  fflush(stdout);
+
+  /* 10 ms of real time per step */
+  data.real_time_sync.scaling = 0.1;
+  omc_flag[FLAG_RT_PREALLOC] = 1;
+  omc_flagValue[FLAG_RT_PREALLOC] = "1";
+  if (solver_main(&data, &threadData, "", "", 0.0, 1, S_EULER, NULL, "Threshold")) return 1;
+  omc_flag[FLAG_RT_PREALLOC] = 0;
+
+  /* the count of the run, stop only ends the tracking */
+  nAllocations = omc_alloc_tracking_stop();
+  printf("%lu allocations in the main loop, x(%g) = %g\n", nAllocations, data.localData[0]->timeValue, data.localData[0]->realVars[0]);
+  if (nAllocations != 0) return 2;
+
+  /* the state event happened during the tracked steps */
+  if (fabs(data.localData[0]->timeValue - 1.0) > 1e-12) return 3;
+  if (!data.simulationInfo->relations[0]) return 4;
+
+  /* every output step was synchronized and is in the histogram */
+  for (i = 0; i < OMC_RT_LATENCY_BINS; i++) {
+    nHistogram += rt->stepHistogram[i];
+  }
+  printf("%lu steps, %lu missed deadlines, execution time min %lld ns, max %lld ns\n", (unsigned long) rt->nSteps, (unsigned long) rt->nOverruns, (long long) rt->minStep, (long long) rt->maxStep);
+  if (rt->nSteps < (uint64_t) simulationInfo.numSteps) return 5;
+  if (nHistogram != rt->nSteps) return 6;
+  if (rt->minStep < 0 || rt->minStep > rt->maxStep) return 7;
+
+  /* and in the csv file, with ascending non-empty bins */
+  file = fopen(latencyFile, "r");
+  if (!file) return 8;
+  if (!fgets(line, sizeof(line), file) || strncmp(line, "\"lower bound [ns]\"", 18)) { fclose(file); return 9; }
+  upper = 0;
+  while (fgets(line, sizeof(line), file)) {
+    long long previous = upper;
+    if (3 != sscanf(line, "%lld,%lld,%lu", &lower, &upper, &steps)) { fclose(file); return 10; }
+    if (lower < previous || lower >= upper || steps == 0) { fclose(file); return 11; }
+    nFile += steps;
+  }
+  fclose(file);
+  remove(latencyFile);
+  if (nFile != rt->nSteps) return 12;
+
+  freeMixedSystems(&data, &threadData);
+  freeLinearSystems(&data, &threadData);
+  freeNonlinearSystems(&data, &threadData);
+  freeTermination(&simulationInfo, &threadData);
+  deInitializeDataStruc(&data);
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_tracking()) != 0) return 1000+rc;
+  if ( (rc = test_preallocatedSteps()) != 0) return 2000+rc;
+
+  /* everything OK */
+  return 0;
+}
@@ -0,0 +1,433 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+/* Warm-start snapshots (-saveSnapshot, -loadSnapshot) of the model
+ *
+ *   model Decay
+ *     parameter Real k = 1;
+ *     Real x(start = 1, fixed = true);
+ *   equation
+ *     der(x) = -k*x;
+ *   end Decay;
+ *
+ * simulated with the explicit Euler method of the generated simulation loop.
+ * A run resumed from the snapshot taken at t = 0.5 has to skip the initial
+ * equations and end with the x(1) of the uninterrupted run. Snapshots of
+ * another model, of another variable layout and truncated files have to be
+ * rejected.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/solver_main.h"
+#include "simulation/solver/initialization/snapshot.h"
+
+#define prefixedName_performSimulation Decay_performSimulation
+#define prefixedName_updateContinuousSystem Decay_updateContinuousSystem
+#include "simulation/solver/perform_simulation.c"
+
+static const char *snapshotFile = "Decay_snapshot.bin";
+static const char *truncatedFile = "Decay_truncated.bin";
+
+static int nInitialEquations = 0;
+
+/* the equations of the model */
+
+static int Decay_functionODE(DATA *data, threadData_t *threadData)
+{
+  data->localData[0]->realVars[1] = -data->simulationInfo->realParameter[0] * data->localData[0]->realVars[0];
+  return 0;
+}
+
+static int Decay_functionDAE(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->discreteCall = 1;
+  Decay_functionODE(data, threadData);
+  data->simulationInfo->discreteCall = 0;
+  return 0;
+}
+
+static int Decay_return0(DATA *data, threadData_t *threadData)
+{
+  return 0;
+}
+
+static int Decay_zeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  return 0;
+}
+
+static int Decay_updateRelations(DATA *data, threadData_t *threadData, int evalZeroCross)
+{
+  return 0;
+}
+
+static void Decay_externalObjects(DATA *data, threadData_t *threadData)
+{
+}
+
+static void Decay_initialNonLinearSystem(int n, NONLINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initialLinearSystem(int n, LINEAR_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initialMixedSystem(int n, MIXED_SYSTEM_DATA *data)
+{
+}
+
+static void Decay_initializeStateSets(int n, STATE_SET_DATA *statesetData, DATA *data)
+{
+}
+
+static int Decay_initializeDAEmodeData(DATA *data, DAEMODE_DATA *daeModeData)
+{
+  return 0;
+}
+
+static void Decay_initSample(DATA *data, threadData_t *threadData)
+{
+}
+
+static void Decay_initSynchronous(DATA *data, threadData_t *threadData)
+{
+}
+
+static int Decay_initialAnalyticJacobian(void *data, threadData_t *threadData)
+{
+  return 1;
+}
+
+/* x = x.start; counted, a resumed run must not solve the initial system */
+static int Decay_functionInitialEquations(DATA *data, threadData_t *threadData)
+{
+  nInitialEquations++;
+  data->localData[0]->realVars[0] = data->modelData->realVarsData[0].attribute.start;
+  Decay_functionDAE(data, threadData);
+  return 0;
+}
+
+static int Decay_updateBoundParameters(DATA *data, threadData_t *threadData)
+{
+  data->simulationInfo->realParameter[0] = data->modelData->realParameterData[0].attribute.start;
+  return 0;
+}
+
+static const char *Decay_description(int i)
+{
+  return "";
+}
+
+static const char *Decay_zeroCrossingDescription(int i, int **out_EquationIndexes)
+{
+  return "";
+}
+
+static struct OpenModelicaGeneratedFunctionCallbacks Decay_callback = {
+  .performSimulation = (int (*)(DATA*, threadData_t*, void*)) Decay_performSimulation,
+  .updateContinuousSystem = Decay_updateContinuousSystem,
+  .callExternalObjectConstructors = Decay_externalObjects,
+  .callExternalObjectDestructors = Decay_externalObjects,
+  .initialNonLinearSystem = Decay_initialNonLinearSystem,
+  .initialLinearSystem = Decay_initialLinearSystem,
+  .initialMixedSystem = Decay_initialMixedSystem,
+  .initializeStateSets = Decay_initializeStateSets,
+  .initializeDAEmodeData = Decay_initializeDAEmodeData,
+  .functionODE = Decay_functionODE,
+  .functionAlgebraics = Decay_return0,
+  .functionDAE = Decay_functionDAE,
+  .functionLocalKnownVars = Decay_return0,
+  .input_function = Decay_return0,
+  .input_function_init = Decay_return0,
+  .input_function_updateStartValues = Decay_return0,
+  .output_function = Decay_return0,
+  .function_storeDelayed = Decay_return0,
+  .updateBoundVariableAttributes = Decay_return0,
+  .functionInitialEquations = Decay_functionInitialEquations,
+  .functionInitialEquations_lambda0 = NULL,
+  .functionRemovedInitialEquations = Decay_return0,
+  .updateBoundParameters = Decay_updateBoundParameters,
+  .checkForAsserts = Decay_return0,
+  .function_ZeroCrossingsEquations = Decay_return0,
+  .function_ZeroCrossings = Decay_zeroCrossings,
+  .function_updateRelations = Decay_updateRelations,
+  .checkForDiscreteChanges = Decay_return0,
+  .zeroCrossingDescription = Decay_zeroCrossingDescription,
+  .relationDescription = Decay_description,
+  .function_initSample = Decay_initSample,
+  .INDEX_JAC_A = 0,
+  .initialAnalyticJacobianA = Decay_initialAnalyticJacobian,
+  .function_initSynchronous = Decay_initSynchronous
+};
+
+static const char Decay_infoJson[] = "{\"format\":\"Transformational debugger info\",\"version\":1,\n"
+  "\"info\":{\"name\":\"Decay\",\"description\":\"\"},\n"
+  "\"variables\":{},\n"
+  "\"equations\":[{\"eqIndex\":0,\"tag\":\"dummy\"}],\n"
+  "\"functions\":[]\n"
+  "}";
+
+static const VAR_INFO Decay_xInfo = {0,-1,"x","",omc_dummyFileInfo};
+static const VAR_INFO Decay_derxInfo = {1,-1,"der(x)","",omc_dummyFileInfo};
+static const VAR_INFO Decay_kInfo = {2,-1,"k","",omc_dummyFileInfo};
+
+typedef struct DECAY
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+} DECAY;
+
+/* what setupDataStruc, the init file and _main_SimulationRuntime do for the generated model */
+static void setupDecay(DECAY *model, const char *guid, threadData_t *threadData)
+{
+  DATA *data = &model->data;
+  MODEL_DATA *modelData = &model->modelData;
+  SIMULATION_INFO *simulationInfo = &model->simulationInfo;
+  int i;
+
+  memset(model, 0, sizeof(DECAY));
+  data->modelData = modelData;
+  data->simulationInfo = simulationInfo;
+  data->callback = &Decay_callback;
+
+  modelData->modelName = "Decay";
+  modelData->modelFilePrefix = "Decay";
+  modelData->modelGUID = guid;
+  modelData->resultFileName = "Decay_res.mat";
+  modelData->modelDataXml.fileName = "Decay_info.json";
+  modelData->modelDataXml.infoXMLData = Decay_infoJson;
+  modelData->modelDataXml.modelInfoXmlLength = sizeof(Decay_infoJson) - 1;
+  modelData->modelDataXml.nEquations = 1;
+  modelData->nStates = 1;
+  modelData->nVariablesReal = 2;
+  modelData->nParametersReal = 1;
+
+  simulationInfo->startTime = 0;
+  simulationInfo->stopTime = 1;
+  simulationInfo->numSteps = 1000;
+  simulationInfo->stepSize = 1e-3;
+  simulationInfo->tolerance = 1e-6;
+  simulationInfo->solverMethod = "euler";
+  simulationInfo->outputFormat = "empty";
+  simulationInfo->variableFilter = ".*";
+
+  initializeDataStruc(data, threadData);
+  initializeTermination(simulationInfo, threadData);
+  for (i = 0; i < 2; i++) {
+    modelData->realVarsData[i].info = i ? Decay_derxInfo : Decay_xInfo;
+    modelData->realVarsData[i].attribute.start = i ? 0 : 1;
+    modelData->realVarsData[i].attribute.fixed = !i;
+    modelData->realVarsData[i].attribute.nominal = 1;
+    modelData->realVarsData[i].attribute.min = -DBL_MAX;
+    modelData->realVarsData[i].attribute.max = DBL_MAX;
+  }
+  modelData->realParameterData[0].info = Decay_kInfo;
+  modelData->realParameterData[0].attribute.start = 1;
+  modelData->realParameterData[0].attribute.fixed = 1;
+  modelData->realParameterData[0].attribute.nominal = 1;
+  modelData->realParameterData[0].attribute.min = -DBL_MAX;
+  modelData->realParameterData[0].attribute.max = DBL_MAX;
+  modelData->sharedVarInfo = 1;
+
+  initializeMixedSystems(data, threadData);
+  initializeLinearSystems(data, threadData);
+  initializeNonlinearSystems(data, threadData);
+}
+
+static void freeDecay(DECAY *model, threadData_t *threadData)
+{
+  freeMixedSystems(&model->data, threadData);
+  freeLinearSystems(&model->data, threadData);
+  freeNonlinearSystems(&model->data, threadData);
+  freeTermination(&model->simulationInfo, threadData);
+  deInitializeDataStruc(&model->data);
+}
+
+static int simulateDecay(DECAY *model, threadData_t *threadData)
+{
+  return solver_main(&model->data, threadData, "", "", 0.0, 1, S_EULER, NULL, "Decay");
+}
+
+/* copies the first length bytes of the snapshot to truncatedFile */
+static int truncateSnapshot(long length)
+{
+  char buffer[4096];
+  FILE *in = fopen(snapshotFile, "rb"), *out;
+  size_t size;
+
+  if (!in) return 1;
+  size = fread(buffer, 1, sizeof(buffer), in);
+  fclose(in);
+  if (size == sizeof(buffer) || length >= (long) size) return 1;
+
+  out = fopen(truncatedFile, "wb");
+  if (!out) return 1;
+  fwrite(buffer, 1, length, out);
+  fclose(out);
+  return 0;
+}
+
+int test_roundTrip()
+{
+  DECAY full, resumed, restored;
+  threadData_t threadData;
+  /* (1 - k h)^n of the explicit Euler method */
+  double xHalf = pow(1.0 - 1e-3, 500), xEnd = pow(1.0 - 1e-3, 1000);
+
+  memset(&threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, &threadData);
+  remove(snapshotFile);
+
+  /* the uninterrupted run writes the snapshot at t = 0.5 */
+  setupDecay(&full, "{decay}", &threadData);
+  omc_flag[FLAG_SAVE_SNAPSHOT] = 1;
+  omc_flagValue[FLAG_SAVE_SNAPSHOT] = "0.5";
+  nInitialEquations = 0;
+  if (simulateDecay(&full, &threadData)) return 1;
+  omc_flag[FLAG_SAVE_SNAPSHOT] = 0;
+  if (nInitialEquations != 1) return 2;
+  printf("full run: x(%g) = %.12f, expected %.12f\n", full.data.localData[0]->timeValue, full.data.localData[0]->realVars[0], xEnd);
+  if (fabs(full.data.localData[0]->timeValue - 1.0) > 1e-12) return 3;
+  if (fabs(full.data.localData[0]->realVars[0] - xEnd) > 1e-12) return 4;
+
+  /* the snapshot holds the state at t = 0.5 */
+  setupDecay(&restored, "{decay}", &threadData);
+  if (loadSnapshot(&restored.data, &threadData, snapshotFile)) return 5;
+  printf("snapshot: x(%g) = %.12f, expected %.12f\n", restored.data.localData[0]->timeValue, restored.data.localData[0]->realVars[0], xHalf);
+  if (fabs(restored.data.localData[0]->timeValue - 0.5) > 1e-12) return 6;
+  if (fabs(restored.data.localData[0]->realVars[0] - xHalf) > 1e-12) return 7;
+  if (fabs(restored.data.localData[0]->realVars[1] + xHalf) > 1e-12) return 8;
+  freeDecay(&restored, &threadData);
+
+  /* the resumed run starts at t = 0.5 without the initial equations */
+  setupDecay(&resumed, "{decay}", &threadData);
+  omc_flag[FLAG_LOAD_SNAPSHOT] = 1;
+  omc_flagValue[FLAG_LOAD_SNAPSHOT] = snapshotFile;
+  nInitialEquations = 0;
+  if (simulateDecay(&resumed, &threadData)) return 9;
+  omc_flag[FLAG_LOAD_SNAPSHOT] = 0;
+  if (nInitialEquations != 0) return 10;
+  if (fabs(resumed.simulationInfo.startTime - 0.5) > 1e-12) return 11;
+  if (resumed.simulationInfo.numSteps != 500) return 12;
+  printf("resumed run: x(%g) = %.12f\n", resumed.data.localData[0]->timeValue, resumed.data.localData[0]->realVars[0]);
+  if (fabs(resumed.data.localData[0]->timeValue - 1.0) > 1e-12) return 13;
+  if (fabs(resumed.data.localData[0]->realVars[0] - full.data.localData[0]->realVars[0]) > 1e-12) return 14;
+
+  freeDecay(&resumed, &threadData);
+  freeDecay(&full, &threadData);
+  return 0;
+}
+
+/* uses the snapshot of test_roundTrip */
+int test_rejected()
+{
+  DECAY model;
+  threadData_t threadData;
+  int rc;
+
+  memset(&threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, &threadData);
+
+  /* another model, with a GUID of the same length */
+  setupDecay(&model, "{dekay}", &threadData);
+  rc = loadSnapshot(&model.data, &threadData, snapshotFile);
+  freeDecay(&model, &threadData);
+  if (!rc) return 1;
+
+  /* another translation with a renamed variable */
+  setupDecay(&model, "{decay}", &threadData);
+  model.modelData.realVarsData[0].info.name = "y";
+  rc = loadSnapshot(&model.data, &threadData, snapshotFile);
+  freeDecay(&model, &threadData);
+  if (!rc) return 2;
+
+  /* cut in the header and in the last value */
+  if (truncateSnapshot(20)) return 3;
+  setupDecay(&model, "{decay}", &threadData);
+  rc = loadSnapshot(&model.data, &threadData, truncatedFile);
+  freeDecay(&model, &threadData);
+  if (!rc) return 4;
+
+  {
+    FILE *file = fopen(snapshotFile, "rb");
+    long size;
+    if (!file) return 5;
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    if (truncateSnapshot(size - 1)) return 6;
+  }
+  setupDecay(&model, "{decay}", &threadData);
+  rc = loadSnapshot(&model.data, &threadData, truncatedFile);
+  freeDecay(&model, &threadData);
+  if (!rc) return 7;
+
+  /* the complete file is still accepted */
+  setupDecay(&model, "{decay}", &threadData);
+  rc = loadSnapshot(&model.data, &threadData, snapshotFile);
+  freeDecay(&model, &threadData);
+  if (rc) return 8;
+
+  remove(truncatedFile);
+  remove(snapshotFile);
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_roundTrip()) != 0) return 1000+rc;
+  if ( (rc = test_rejected()) != 0) return 2000+rc;
+
+  /* everything OK */
+  return 0;
+}
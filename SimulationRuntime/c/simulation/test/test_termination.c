@@ -0,0 +1,190 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/* Two ensemble members run at the same time on their own threads, only the
+ * first one calls terminate(). The second one has to keep running and a
+ * later run on the thread of the first one has to start without the
+ * termination of the previous run.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "util/omc_init.h"
+#include "simulation/simulation_runtime.h"
+#include "simulation/solver/model_help.h"
+
+typedef struct MEMBER
+{
+  int id;
+  SIMULATION_INFO simulationInfo;
+  SIMULATION_INFO nextRun;
+  DATA data;
+  int rc;
+} MEMBER;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int nBound = 0;
+static int nTerminateCalled = 0;
+
+static void* runMember(void *arg)
+{
+  MEMBER *member = (MEMBER*) arg;
+  threadData_t threadData;
+  FILE_INFO info = omc_dummyFileInfo;
+
+  memset(&threadData, 0, sizeof(threadData_t));
+  pthread_setspecific(mmc_thread_data_key, &threadData);
+  initializeTermination(&member->simulationInfo, &threadData);
+
+  /* both members are running before one of them terminates */
+  pthread_mutex_lock(&mutex);
+  nBound++;
+  pthread_cond_broadcast(&cond);
+  while (nBound < 2) {
+    pthread_cond_wait(&cond, &mutex);
+  }
+  pthread_mutex_unlock(&mutex);
+
+  if (member->id == 0) {
+    info.lineStart = 42;
+    omc_terminate(info, "member %d stops at %s", member->id, "t = 0.5");
+  }
+
+  pthread_mutex_lock(&mutex);
+  if (member->id == 0) {
+    nTerminateCalled = 1;
+    pthread_cond_broadcast(&cond);
+  }
+  while (!nTerminateCalled) {
+    pthread_cond_wait(&cond, &mutex);
+  }
+  pthread_mutex_unlock(&mutex);
+
+  if (member->id == 0) {
+    if (!member->simulationInfo.terminationTerminate) { member->rc = 1; return NULL; }
+    if (strcmp(member->simulationInfo.terminationMessage, "member 0 stops at t = 0.5")) { member->rc = 2; return NULL; }
+    if (member->simulationInfo.terminationInfo.lineStart != 42) { member->rc = 3; return NULL; }
+  } else {
+    if (member->simulationInfo.terminationTerminate) { member->rc = 4; return NULL; }
+    if (member->simulationInfo.terminationMessage) { member->rc = 5; return NULL; }
+  }
+  freeTermination(&member->simulationInfo, &threadData);
+  if (threadData.simulationInfo) { member->rc = 6; return NULL; }
+
+  /* the next run on this thread */
+  initializeTermination(&member->nextRun, &threadData);
+  if (member->nextRun.terminationTerminate || member->nextRun.terminationMessage) { member->rc = 7; return NULL; }
+  freeTermination(&member->nextRun, &threadData);
+
+  member->rc = 0;
+  return NULL;
+}
+
+int test_termination()
+{
+  MEMBER members[2];
+  pthread_t threads[2];
+  int i;
+
+  memset(members, 0, sizeof(members));
+  for (i = 0; i < 2; i++) {
+    members[i].id = i;
+    members[i].rc = -1;
+    if (pthread_create(&threads[i], NULL, runMember, &members[i])) return 1;
+  }
+  for (i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  for (i = 0; i < 2; i++) {
+    if (members[i].rc) return 10*(i+1)+members[i].rc;
+  }
+  return 0;
+}
+
+/* a relation as the C code generator emits it, with data in scope */
+static modelica_boolean greaterZCGenerated(DATA *data, double x)
+{
+  modelica_boolean tmp1;
+  tmp1 = GreaterZC(x, 1.0, data->simulationInfo->storedRelations[0]);
+  return tmp1;
+}
+
+static modelica_boolean lessZCGenerated(DATA *data, double x)
+{
+  modelica_boolean tmp1;
+  RELATIONHYSTERESIS(tmp1, x, 1.0, 0, Less);
+  return tmp1;
+}
+
+int test_tolZC()
+{
+  SIMULATION_INFO simulationInfo[2];
+  DATA data[2];
+  modelica_boolean storedRelations[2][1] = {{1}, {1}};
+  modelica_boolean relations[2][1];
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    memset(&simulationInfo[i], 0, sizeof(SIMULATION_INFO));
+    memset(&data[i], 0, sizeof(DATA));
+    data[i].simulationInfo = &simulationInfo[i];
+    simulationInfo[i].storedRelations = storedRelations[i];
+    simulationInfo[i].relations = relations[i];
+    simulationInfo[i].discreteCall = 1;
+  }
+  setZCtol(&data[0], 1e-2);
+  setZCtol(&data[1], 1e-6);
+
+  /* the hysteresis of one member must not change with the tolerance of the other */
+  if (!greaterZCGenerated(&data[0], 1.0 - 1e-7)) return 1;
+  if (greaterZCGenerated(&data[1], 1.0 - 1e-7)) return 2;
+  if (!lessZCGenerated(&data[0], 1.0 + 1e-7)) return 3;
+  if (lessZCGenerated(&data[1], 1.0 + 1e-7)) return 4;
+  return 0;
+}
+
+/* main */
+int main()
+{
+  /* return code */
+  int rc;
+
+  mmc_init_nogc();
+
+  if ( (rc = test_termination()) != 0) return 1000+rc;
+  if ( (rc = test_tolZC()) != 0) return 2000+rc;
+
+  /* everything OK */
+  return 0;
+}
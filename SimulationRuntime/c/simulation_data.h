@@ -168,6 +168,7 @@ typedef struct EXTERNAL_INPUT
   modelica_integer N;
   modelica_integer n;
   modelica_integer i;
+  struct EXTERNAL_INPUT_STREAM* stream;  /* non-NULL if the inputs are streamed (-inputStream) */
 }EXTERNAL_INPUT;
 
 /* Alias data with various types*/
@@ -276,6 +277,7 @@ typedef struct NONLINEAR_SYSTEM_DATA
   int (*strictTearingFunctionCall)(struct DATA*, threadData_t *threadData);
   void (*getIterationVars)(struct DATA*, double*);
 
+  modelica_boolean useSparseSolver;    /* 1: use sparse newton solver, - else any other */
   void *solverData;
   modelica_real *nlsx;                 /* x */
   modelica_real *nlsxOld;              /* previous x */
@@ -466,6 +468,7 @@ typedef struct MODEL_DATA
   const char* modelDir;
   const char* modelGUID;
   const char* initXMLData;
+  modelica_boolean sharedVarInfo;      /* the VAR_INFO of all variables is borrowed from another instance (-ensemble) and must not be freed */
 
   long nSamples;                       /* number of different sample-calls */
   SAMPLE_INFO* samplesInfo;            /* array containing each sample-call */
@@ -547,6 +550,14 @@ typedef struct SIMULATION_INFO
   int nlsMethod;                       /* nonlinear solver */
   int newtonStrategy;                  /* newton damping strategy solver */
   int nlsCsvInfomation;                /* = 1 csv files with detailed nonlinear solver process are generated */
+  modelica_boolean noEmit;             /* = 1 no result file is written (-noemit) */
+  modelica_real tolZC;                 /* tolerance of the zero-crossing hysteresis, see setZCtol */
+
+  /* terminate() of the model, see initializeTermination */
+  int terminationTerminate;            /* becomes non-zero when the model calls terminate() */
+  char *terminationMessage;            /* message of terminate() */
+  size_t terminationMessageSize;
+  FILE_INFO terminationInfo;           /* location of terminate() */
 
   /* current context evaluation, set by dassl and used for extrapolation
    * of next non-linear guess */
@@ -586,6 +597,9 @@ typedef struct SIMULATION_INFO
   modelica_boolean* storedRelations;   /* this array contains a copy of relations each time the event iteration starts */
   modelica_real* mathEventsValuePre;
   long* zeroCrossingIndex;             /* := {0, 1, 2, ..., data->modelData->nZeroCrossings-1}; pointer for a list events at event instants */
+  modelica_real* rootStatesLeft;       /* work arrays of findRoot in event.c */
+  modelica_real* rootStatesRight;
+  LIST* rootEventList;
 
   /* old vars for event handling */
   modelica_real timeValueOld;
@@ -649,12 +663,24 @@ typedef struct SIMULATION_DATA
 }SIMULATION_DATA;
 
 #if !defined(OMC_MINIMAL_RUNTIME)
+/* execution times of the steps; 8 bins per power of two up to 2^63 ns */
+#define OMC_RT_LATENCY_BINS 488
+
 typedef struct {
   int enabled;
   double scaling;
   double time;
   rtclock_t clock;
   int64_t maxLate;
+
+  /* per-step statistics, see omc_real_time_sync_step */
+  rtclock_t stepClock;                 /* start of the current step */
+  int64_t minLate;
+  int64_t minStep;                     /* execution time of the steps [ns] */
+  int64_t maxStep;
+  uint64_t nSteps;
+  uint64_t nOverruns;                  /* missed deadlines */
+  uint64_t stepHistogram[OMC_RT_LATENCY_BINS];
 } real_time_sync_t;
 #endif
 
@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "omc_inline.h"
 #include "ModelicaUtilities.h"
@@ -58,6 +59,7 @@ typedef struct InterpolationTable
   int ipoType;
   int expoType;
   double startTime;
+  int refCount;
 } InterpolationTable;
 
 typedef struct InterpolationTable2D
@@ -72,12 +74,61 @@ typedef struct InterpolationTable2D
   char colWise;
   int ipoType;
   int expoType;
+  int refCount;
 } InterpolationTable2D;
 
+/* The table registry is shared by all simulation instances of the process.
+ * Table ids are stable: closed tables leave a NULL entry. The arrays are
+ * reallocated when they grow, so readers look up the table of an id with the
+ * lock held as well; the table itself stays valid while its id is open.
+ */
+static pthread_mutex_t interpolationTablesMutex = PTHREAD_MUTEX_INITIALIZER;
 static InterpolationTable** interpolationTables=NULL;
 static int ninterpolationTables=0;
+static int capacityInterpolationTables=0;
 static InterpolationTable2D** interpolationTables2D=NULL;
 static int ninterpolationTables2D=0;
+static int capacityInterpolationTables2D=0;
+
+/* must be called with interpolationTablesMutex held; returns 0 if out of memory */
+static int growTableArray(void ***array, int n, int *capacity)
+{
+  void **tmp;
+  if(n < *capacity) {
+    return 1;
+  }
+  tmp = (void**)realloc(*array, (*capacity ? 2 * *capacity : 16)*sizeof(void*));
+  if(!tmp) {
+    return 0;
+  }
+  *capacity = *capacity ? 2 * *capacity : 16;
+  *array = tmp;
+  return 1;
+}
+
+/* the table of tableID or NULL */
+static InterpolationTable* lookupTable(int tableID)
+{
+  InterpolationTable *tpl = NULL;
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if(tableID >= 0 && tableID < ninterpolationTables) {
+    tpl = interpolationTables[tableID];
+  }
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  return tpl;
+}
+
+/* the 2D table of tableID or NULL */
+static InterpolationTable2D* lookupTable2D(int tableID)
+{
+  InterpolationTable2D *tpl = NULL;
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if(tableID >= 0 && tableID < ninterpolationTables2D) {
+    tpl = interpolationTables2D[tableID];
+  }
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  return tpl;
+}
 
 static InterpolationTable *InterpolationTable_init(double time,double startTime, int ipoType, int expoType,
          const char* tableName, const char* fileName,
@@ -132,41 +183,45 @@ int omcTableTimeIni(double timeIn, double startTime,int ipoType,int expoType,
         const double *table,int tableDim1, int tableDim2,int colWise)
 {
   int i = 0;
-  InterpolationTable** tmp = NULL;
+  InterpolationTable* tpl = NULL;
 #ifdef INFOS
   INFO10("Init Table \n timeIn %f \n startTime %f \n ipoType %d \n expoType %d \n tableName %s \n fileName %s \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", timeIn, startTime, ipoType, expoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
   /* if table is already initialized, find it */
+  pthread_mutex_lock(&interpolationTablesMutex);
   for(i = 0; i < ninterpolationTables; ++i)
-    if(InterpolationTable_compare(interpolationTables[i],fileName,tableName,table))
+    if(interpolationTables[i] && InterpolationTable_compare(interpolationTables[i],fileName,tableName,table))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
 #endif
+      interpolationTables[i]->refCount++;
+      pthread_mutex_unlock(&interpolationTablesMutex);
       return i;
     }
-#ifdef INFOS
-  infoStreamPrint("Table id = %d",ninterpolationTables);
-#endif
-  /* increase array */
-  tmp = (InterpolationTable**)malloc((ninterpolationTables+1)*sizeof(InterpolationTable*));
-  if (!tmp) {
-    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables, tableName, fileName);
-  }
-  for(i = 0; i < ninterpolationTables; ++i)
-  {
-    tmp[i] = interpolationTables[i];
-  }
-  free(interpolationTables);
-  interpolationTables = tmp;
-  ninterpolationTables++;
-  /* otherwise initialize new table */
-  interpolationTables[ninterpolationTables-1] = InterpolationTable_init(timeIn,startTime,
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  /* otherwise initialize new table; this may raise an error, so do it without holding the lock */
+  tpl = InterpolationTable_init(timeIn,startTime,
                    ipoType,expoType,
                    tableName, fileName,
                    table, tableDim1,
                    tableDim2, colWise);
-  return (ninterpolationTables-1);
+  tpl->refCount = 1;
+  /* increase array */
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if (!growTableArray((void***)&interpolationTables, ninterpolationTables, &capacityInterpolationTables)) {
+    pthread_mutex_unlock(&interpolationTablesMutex);
+    InterpolationTable_deinit(tpl);
+    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables, tableName, fileName);
+  }
+  i = ninterpolationTables;
+#ifdef INFOS
+  infoStreamPrint("Table id = %d",i);
+#endif
+  interpolationTables[i] = tpl;
+  ninterpolationTables++;
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  return i;
 }
 
 
@@ -175,14 +230,16 @@ void omcTableTimeIpoClose(int tableID)
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if(tableID >= 0 && tableID < (int)ninterpolationTables && interpolationTables[tableID])
   {
-    InterpolationTable_deinit(interpolationTables[tableID]);
-    interpolationTables[tableID] = NULL;
-    ninterpolationTables--;
+    if(--interpolationTables[tableID]->refCount == 0)
+    {
+      InterpolationTable_deinit(interpolationTables[tableID]);
+      interpolationTables[tableID] = NULL;
+    }
   }
-  if(ninterpolationTables <=0)
-    free(interpolationTables);
+  pthread_mutex_unlock(&interpolationTablesMutex);
 }
 
 
@@ -191,9 +248,10 @@ double omcTableTimeIpo(int tableID, int icol, double timeIn)
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,icol,timeIn);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  InterpolationTable *tpl = lookupTable(tableID);
+  if(tpl)
   {
-    return InterpolationTable_interpolate(interpolationTables[tableID],timeIn,icol-1);
+    return InterpolationTable_interpolate(tpl,timeIn,icol-1);
   }
   else
     return 0.0;
@@ -205,8 +263,9 @@ double omcTableTimeTmax(int tableID)
 #ifdef INFOS
   infoStreamPrint("Time max from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
-    return InterpolationTable_maxTime(interpolationTables[tableID]);
+  InterpolationTable *tpl = lookupTable(tableID);
+  if(tpl)
+    return InterpolationTable_maxTime(tpl);
   else
     return 0.0;
 }
@@ -217,8 +276,9 @@ double omcTableTimeTmin(int tableID)
 #ifdef INFOS
   infoStreamPrint("Time min from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
-    return InterpolationTable_minTime(interpolationTables[tableID]);
+  InterpolationTable *tpl = lookupTable(tableID);
+  if(tpl)
+    return InterpolationTable_minTime(tpl);
   else
     return 0.0;
 }
@@ -228,38 +288,42 @@ int omcTable2DIni(int ipoType, const char *tableName, const char* fileName,
       const double *table,int tableDim1,int tableDim2,int colWise)
 {
   int i=0;
-  InterpolationTable2D** tmp = NULL;
+  InterpolationTable2D* tpl = NULL;
 #ifdef INFOS
   infoStreamPrint("Init Table \n ipoType %f \n tableName %f \n fileName %d \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", ipoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
   /* if table is already initialized, find it */
+  pthread_mutex_lock(&interpolationTablesMutex);
   for(i = 0; i < ninterpolationTables2D; ++i)
-    if(InterpolationTable2D_compare(interpolationTables2D[i],fileName,tableName,table))
+    if(interpolationTables2D[i] && InterpolationTable2D_compare(interpolationTables2D[i],fileName,tableName,table))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
 #endif
+      interpolationTables2D[i]->refCount++;
+      pthread_mutex_unlock(&interpolationTablesMutex);
       return i;
     }
-#ifdef INFOS
-  infoStreamPrint("Table id = %d",ninterpolationTables2D);
-#endif
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  /* otherwise initialize new table; this may raise an error, so do it without holding the lock */
+  tpl = InterpolationTable2D_init(ipoType,tableName,
+                      fileName,table,tableDim1,tableDim2,colWise);
+  tpl->refCount = 1;
   /* increase array */
-  tmp = (InterpolationTable2D**)malloc((ninterpolationTables2D+1)*sizeof(InterpolationTable2D*));
-  if (!tmp) {
-    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables, tableName, fileName);
-  }
-  for(i = 0; i < ninterpolationTables2D; ++i)
-  {
-    tmp[i] = interpolationTables2D[i];
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if (!growTableArray((void***)&interpolationTables2D, ninterpolationTables2D, &capacityInterpolationTables2D)) {
+    pthread_mutex_unlock(&interpolationTablesMutex);
+    InterpolationTable2D_deinit(tpl);
+    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables2D, tableName, fileName);
   }
-  free(interpolationTables2D);
-  interpolationTables2D = tmp;
+  i = ninterpolationTables2D;
+#ifdef INFOS
+  infoStreamPrint("Table id = %d",i);
+#endif
+  interpolationTables2D[i] = tpl;
   ninterpolationTables2D++;
-  /* otherwise initialize new table */
-  interpolationTables2D[ninterpolationTables2D-1] = InterpolationTable2D_init(ipoType,tableName,
-                      fileName,table,tableDim1,tableDim2,colWise);
-  return (ninterpolationTables2D-1);
+  pthread_mutex_unlock(&interpolationTablesMutex);
+  return i;
 }
 
 
@@ -268,14 +332,16 @@ void omcTable2DIpoClose(int tableID)
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
+  pthread_mutex_lock(&interpolationTablesMutex);
+  if(tableID >= 0 && tableID < (int)ninterpolationTables2D && interpolationTables2D[tableID])
   {
-    InterpolationTable2D_deinit(interpolationTables2D[tableID]);
-    interpolationTables2D[tableID] = NULL;
-    ninterpolationTables2D--;
+    if(--interpolationTables2D[tableID]->refCount == 0)
+    {
+      InterpolationTable2D_deinit(interpolationTables2D[tableID]);
+      interpolationTables2D[tableID] = NULL;
+    }
   }
-  if(ninterpolationTables2D <=0)
-    free(interpolationTables2D);
+  pthread_mutex_unlock(&interpolationTablesMutex);
 }
 
 
@@ -284,8 +350,9 @@ double omcTable2DIpo(int tableID,double u1_, double u2_)
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,u1_,u2_);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
-    return InterpolationTable2D_interpolate(interpolationTables2D[tableID], u1_, u2_);
+  InterpolationTable2D *tpl = lookupTable2D(tableID);
+  if(tpl)
+    return InterpolationTable2D_interpolate(tpl, u1_, u2_);
   else
     return 0.0;
 }
@@ -0,0 +1,140 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "alloc_tracking.h"
+
+#if defined(OMC_RT_ALLOC_TRACKING)
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(__GLIBC__)
+#error "OMC_RT_ALLOC_TRACKING needs the GNU C library"
+#endif
+
+#include <execinfo.h>
+#include <unistd.h>
+
+#define MAX_TRACKED_FRAMES 32
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static volatile int tracking = 0;
+static volatile unsigned long nAllocations = 0;
+static __thread int reporting = 0;
+
+/* Only async-signal-safe output is used, since stdio allocates itself. */
+static void report(const char *function, size_t size)
+{
+  void *frames[MAX_TRACKED_FRAMES];
+  char buffer[128];
+  int n;
+
+  if (!tracking || reporting) {
+    return;
+  }
+  reporting = 1;
+  __sync_fetch_and_add(&nAllocations, 1);
+
+  if (size) {
+    n = snprintf(buffer, sizeof(buffer), "allocation after the initialization: %s(%lu)\n", function, (unsigned long) size);
+  } else {
+    n = snprintf(buffer, sizeof(buffer), "allocation after the initialization: %s\n", function);
+  }
+  if (n > 0 && write(STDERR_FILENO, buffer, n < (int) sizeof(buffer) ? n : (int) sizeof(buffer) - 1) < 0) {
+    /* nothing we can do about it */
+  }
+  n = backtrace(frames, MAX_TRACKED_FRAMES);
+  /* skip report itself */
+  backtrace_symbols_fd(frames + 1, n - 1, STDERR_FILENO);
+
+  reporting = 0;
+}
+
+void *malloc(size_t size)
+{
+  report("malloc", size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+  report("calloc", n*size);
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  report("realloc", size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+  if (ptr) {
+    report("free", 0);
+  }
+  __libc_free(ptr);
+}
+
+void omc_alloc_tracking_start(void)
+{
+  void *frames[2];
+
+  /* the first call of backtrace loads libgcc, which allocates */
+  backtrace(frames, 2);
+  nAllocations = 0;
+  tracking = 1;
+}
+
+unsigned long omc_alloc_tracking_stop(void)
+{
+  tracking = 0;
+  if (nAllocations > 0) {
+    fprintf(stderr, "%lu allocations after the initialization\n", nAllocations);
+  }
+  return nAllocations;
+}
+
+#else
+
+void omc_alloc_tracking_start(void)
+{
+}
+
+unsigned long omc_alloc_tracking_stop(void)
+{
+  return 0;
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Benchmark of the kernels in array_kernels.c over matrix sizes typical for
+ * Modelica functions, against the element-wise loops real_array.c used before
+ * and against calling BLAS directly. The "blocked" column is what the kernels
+ * do without BLAS; the thresholds in array_kernels.c are where it and the
+ * BLAS column cross.
+ *
+ * Build with "make array-benchmark" in SimulationRuntime/c; it links -lblas
+ * unless BLAS_LIBS is given (e.g. BLAS_LIBS=-lopenblas).
+ */
+
+/* The blocked loops alone, without BLAS dispatch */
+#define OMC_NO_BLAS
+#include "array_kernels.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+extern int dgemm_(char *transa, char *transb, int *m, int *n, int *k, double *alpha, double *a, int *lda,
+                  double *b, int *ldb, double *beta, double *c, int *ldc);
+extern int dgemv_(char *trans, int *m, int *n, double *alpha, double *a, int *lda, double *x, int *incx,
+                  double *beta, double *y, int *incy);
+
+static const int sizes[] = {3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 100, 128, 200, 256, 500};
+
+/* The loops of real_array.c before array_kernels.c */
+static void naive_gemm(size_t m, size_t n, size_t k, const double *A, const double *B, double *C)
+{
+  size_t i, j, p;
+  for (i = 0; i < m; i++) {
+    for (j = 0; j < n; j++) {
+      double tmp = 0;
+      for (p = 0; p < k; p++) {
+        tmp += A[i*k+p]*B[p*n+j];
+      }
+      C[i*n+j] = tmp;
+    }
+  }
+}
+
+static void naive_gemv(size_t m, size_t n, const double *A, const double *x, double *y)
+{
+  size_t i, j;
+  for (i = 0; i < m; i++) {
+    double tmp = 0;
+    for (j = 0; j < n; j++) {
+      tmp += A[i*n+j]*x[j];
+    }
+    y[i] = tmp;
+  }
+}
+
+static void naive_transpose(size_t m, size_t n, const double *A, double *B)
+{
+  size_t i, j;
+  for (i = 0; i < m; i++) {
+    for (j = 0; j < n; j++) {
+      B[j*m+i] = A[i*n+j];
+    }
+  }
+}
+
+static void blas_gemm(size_t m, size_t n, size_t k, const double *A, const double *B, double *C)
+{
+  int im = (int) m, in = (int) n, ik = (int) k;
+  double alpha = 1.0, beta = 0.0;
+  char trans = 'N';
+  dgemm_(&trans, &trans, &in, &im, &ik, &alpha, (double*) B, &in, (double*) A, &ik, &beta, C, &in);
+}
+
+static void blas_gemv(size_t m, size_t n, const double *A, const double *x, double *y)
+{
+  int im = (int) m, in = (int) n, inc = 1;
+  double alpha = 1.0, beta = 0.0;
+  char trans = 'T';
+  dgemv_(&trans, &in, &im, &alpha, (double*) A, &in, (double*) x, &inc, &beta, y, &inc);
+}
+
+static double max_diff(size_t len, const double *x, const double *y)
+{
+  double d = 0;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    d = fmax(d, fabs(x[i]-y[i]));
+  }
+  return d;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+/* Sets best to the time in ns per call of the best of 5 runs of reps calls */
+#define TIME_NS(reps, call) do { \
+    int run_, rep_; \
+    best = -1; \
+    for (run_ = 0; run_ < 5; run_++) { \
+      double t_; \
+      t_ = now(); \
+      for (rep_ = 0; rep_ < (reps); rep_++) { call; } \
+      t_ = (now() - t_) * 1e9 / (reps); \
+      if (best < 0 || t_ < best) best = t_; \
+    } \
+  } while (0)
+
+int main(void)
+{
+  const size_t nsizes = sizeof(sizes)/sizeof(sizes[0]);
+  size_t s, i, n, len;
+  double *A, *B, *C, *Cref, best, t_naive, t_blocked, t_blas, d_blocked, d_blas;
+  long reps;
+
+  len = (size_t) sizes[nsizes-1] * sizes[nsizes-1];
+  A = (double*) malloc(len*sizeof(double));
+  B = (double*) malloc(len*sizeof(double));
+  C = (double*) malloc(len*sizeof(double));
+  Cref = (double*) malloc(len*sizeof(double));
+  for (i = 0; i < len; i++) {
+    A[i] = (double) rand() / RAND_MAX - 0.5;
+    B[i] = (double) rand() / RAND_MAX - 0.5;
+  }
+
+  printf("# time per call [ns]; speedup is naive/best of blocked and BLAS; max diff of the result against naive\n");
+  printf("%-10s %6s %14s %14s %14s %8s %14s %14s\n", "kernel", "n", "naive", "blocked", "BLAS", "speedup", "diff blocked", "diff BLAS");
+  for (s = 0; s < nsizes; s++) {
+    n = sizes[s];
+    reps = (long) (5e7 / ((double) n*n*n)) + 1;
+    naive_gemm(n, n, n, A, B, Cref);
+    TIME_NS(reps, naive_gemm(n, n, n, A, B, C)); t_naive = best;
+    TIME_NS(reps, omc_real_gemm(n, n, n, A, B, C)); t_blocked = best;
+    d_blocked = max_diff(n*n, C, Cref);
+    TIME_NS(reps, blas_gemm(n, n, n, A, B, C)); t_blas = best;
+    d_blas = max_diff(n*n, C, Cref);
+    printf("%-10s %6d %14.1f %14.1f %14.1f %8.2f %14.2e %14.2e\n", "gemm", (int) n, t_naive, t_blocked, t_blas,
+           t_naive / fmin(t_blocked, t_blas), d_blocked, d_blas);
+    fflush(stdout);
+  }
+  for (s = 0; s < nsizes; s++) {
+    n = sizes[s];
+    reps = (long) (2e7 / ((double) n*n)) + 1;
+    naive_gemv(n, n, A, B, Cref);
+    TIME_NS(reps, naive_gemv(n, n, A, B, C)); t_naive = best;
+    TIME_NS(reps, omc_real_gemv(n, n, A, B, C)); t_blocked = best;
+    d_blocked = max_diff(n, C, Cref);
+    TIME_NS(reps, blas_gemv(n, n, A, B, C)); t_blas = best;
+    d_blas = max_diff(n, C, Cref);
+    printf("%-10s %6d %14.1f %14.1f %14.1f %8.2f %14.2e %14.2e\n", "gemv", (int) n, t_naive, t_blocked, t_blas,
+           t_naive / fmin(t_blocked, t_blas), d_blocked, d_blas);
+    fflush(stdout);
+  }
+  for (s = 0; s < nsizes; s++) {
+    n = sizes[s];
+    reps = (long) (2e7 / ((double) n*n)) + 1;
+    naive_transpose(n, n, A, Cref);
+    TIME_NS(reps, naive_transpose(n, n, A, C)); t_naive = best;
+    TIME_NS(reps, omc_real_transpose(n, n, A, C)); t_blocked = best;
+    d_blocked = max_diff(n*n, C, Cref);
+    printf("%-10s %6d %14.1f %14.1f %14s %8.2f %14.2e %14s\n", "transpose", (int) n, t_naive, t_blocked, "-",
+           t_naive / t_blocked, d_blocked, "-");
+    fflush(stdout);
+  }
+
+  free(A);
+  free(B);
+  free(C);
+  free(Cref);
+  return 0;
+}
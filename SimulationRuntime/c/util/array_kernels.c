@@ -0,0 +1,343 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file array_kernels.c
+ *
+ * See array_kernels.h. The integer kernels are the real ones without the
+ * BLAS dispatch.
+ */
+
+#include "array_kernels.h"
+
+#include <limits.h>
+#include <string.h>
+
+#if !defined(OMC_NO_BLAS)
+extern int dgemm_(char *transa, char *transb, int *m, int *n, int *k, double *alpha, double *a, int *lda,
+                  double *b, int *ldb, double *beta, double *c, int *ldc);
+extern int dgemv_(char *trans, int *m, int *n, double *alpha, double *a, int *lda, double *x, int *incx,
+                  double *beta, double *y, int *incy);
+#endif
+
+/* Below these numbers of multiplications plain loops beat the call overhead
+ * of BLAS; measured with util/array_benchmark.c and OpenBLAS. Above them the
+ * blocked loops are only used without BLAS */
+#define SMALL_GEMM_MAX_FLOPS (4*4*4)
+#define BLAS_GEMV_MIN_FLOPS (32*32)
+
+/* GEMM: size of the tile of C that is kept in registers */
+#define GEMM_MR 4
+#define GEMM_NR 4
+/* Transpose: tiles that fit in L1 together with their transpose; small
+ * matrices are not tiled */
+#define TRANSPOSE_BLOCK 32
+#define TRANSPOSE_MIN_BLOCKED (64*64)
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+#if !defined(OMC_NO_BLAS)
+static inline int fits_blas_int(size_t m, size_t n, size_t k)
+{
+  return m <= INT_MAX && n <= INT_MAX && k <= INT_MAX;
+}
+#endif
+
+/* One rows x cols tile of C = A*B with the tile of C in registers; rows and
+ * cols are at most GEMM_MR and GEMM_NR, and constant in the unrolled calls */
+#define GEMM_TILE(T, rows, cols) \
+  { \
+    T c[GEMM_MR][GEMM_NR] = {{0}}; \
+    size_t r_, s_, p_; \
+    for (p_ = 0; p_ < k; p_++) { \
+      const T *b_ = B+p_*n+j; \
+      for (r_ = 0; r_ < (rows); r_++) { \
+        const T a_ = A[(i+r_)*k+p_]; \
+        for (s_ = 0; s_ < (cols); s_++) { \
+          c[r_][s_] += a_*b_[s_]; \
+        } \
+      } \
+    } \
+    for (r_ = 0; r_ < (rows); r_++) { \
+      for (s_ = 0; s_ < (cols); s_++) { \
+        C[(i+r_)*n+j+s_] = c[r_][s_]; \
+      } \
+    } \
+  }
+
+static void real_gemm_blocked(size_t m, size_t n, size_t k, const modelica_real *A, const modelica_real *B, modelica_real *C)
+{
+  size_t i, j;
+  for (i = 0; i+GEMM_MR <= m; i += GEMM_MR) {
+    for (j = 0; j+GEMM_NR <= n; j += GEMM_NR) {
+      GEMM_TILE(modelica_real, GEMM_MR, GEMM_NR)
+    }
+    if (j < n) {
+      GEMM_TILE(modelica_real, GEMM_MR, n-j)
+    }
+  }
+  for (; i < m; i++) {
+    for (j = 0; j+GEMM_NR <= n; j += GEMM_NR) {
+      GEMM_TILE(modelica_real, 1, GEMM_NR)
+    }
+    if (j < n) {
+      GEMM_TILE(modelica_real, 1, n-j)
+    }
+  }
+}
+
+void omc_real_gemm(size_t m, size_t n, size_t k, const modelica_real *A, const modelica_real *B, modelica_real *C)
+{
+  if ((double)m*n*k < SMALL_GEMM_MAX_FLOPS) {
+    size_t i, j, p;
+    for (i = 0; i < m; i++) {
+      for (j = 0; j < n; j++) {
+        modelica_real tmp = 0;
+        for (p = 0; p < k; p++) {
+          tmp += A[i*k+p]*B[p*n+j];
+        }
+        C[i*n+j] = tmp;
+      }
+    }
+    return;
+  }
+#if !defined(OMC_NO_BLAS)
+  if (fits_blas_int(m, n, k)) {
+    /* Row-major C = A*B is column-major C' = B'*A' */
+    int im = (int) m, in = (int) n, ik = (int) k;
+    double alpha = 1.0, beta = 0.0;
+    char trans = 'N';
+    dgemm_(&trans, &trans, &in, &im, &ik, &alpha, (double*) B, &in, (double*) A, &ik, &beta, C, &in);
+    return;
+  }
+#endif
+  real_gemm_blocked(m, n, k, A, B, C);
+}
+
+void omc_real_gemv(size_t m, size_t n, const modelica_real *A, const modelica_real *x, modelica_real *y)
+{
+  size_t i, j;
+#if !defined(OMC_NO_BLAS)
+  if ((double)m*n >= BLAS_GEMV_MIN_FLOPS && fits_blas_int(m, n, 1)) {
+    /* Row-major A is column-major A' */
+    int im = (int) m, in = (int) n, inc = 1;
+    double alpha = 1.0, beta = 0.0;
+    char trans = 'T';
+    dgemv_(&trans, &in, &im, &alpha, (double*) A, &in, (double*) x, &inc, &beta, y, &inc);
+    return;
+  }
+#endif
+  for (i = 0; i+4 <= m; i += 4) {
+    const modelica_real *a0 = A+i*n, *a1 = a0+n, *a2 = a1+n, *a3 = a2+n;
+    modelica_real s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (j = 0; j < n; j++) {
+      s0 += a0[j]*x[j];
+      s1 += a1[j]*x[j];
+      s2 += a2[j]*x[j];
+      s3 += a3[j]*x[j];
+    }
+    y[i] = s0;
+    y[i+1] = s1;
+    y[i+2] = s2;
+    y[i+3] = s3;
+  }
+  for (; i < m; i++) {
+    y[i] = omc_real_dot(n, A+i*n, x);
+  }
+}
+
+void omc_real_gevm(size_t m, size_t n, const modelica_real *x, const modelica_real *A, modelica_real *y)
+{
+  size_t i, j;
+#if !defined(OMC_NO_BLAS)
+  if ((double)m*n >= BLAS_GEMV_MIN_FLOPS && fits_blas_int(m, n, 1)) {
+    int im = (int) m, in = (int) n, inc = 1;
+    double alpha = 1.0, beta = 0.0;
+    char trans = 'N';
+    dgemv_(&trans, &in, &im, &alpha, (double*) A, &in, (double*) x, &inc, &beta, y, &inc);
+    return;
+  }
+#endif
+  memset(y, 0, n*sizeof(modelica_real));
+  for (i = 0; i+4 <= m; i += 4) {
+    const modelica_real *a0 = A+i*n, *a1 = a0+n, *a2 = a1+n, *a3 = a2+n;
+    const modelica_real s0 = x[i], s1 = x[i+1], s2 = x[i+2], s3 = x[i+3];
+    for (j = 0; j < n; j++) {
+      y[j] += s0*a0[j] + s1*a1[j] + s2*a2[j] + s3*a3[j];
+    }
+  }
+  for (; i < m; i++) {
+    const modelica_real *a0 = A+i*n;
+    const modelica_real s0 = x[i];
+    for (j = 0; j < n; j++) {
+      y[j] += s0*a0[j];
+    }
+  }
+}
+
+void omc_real_transpose(size_t m, size_t n, const modelica_real *A, modelica_real *B)
+{
+  size_t i, j, ib, jb, iend, jend;
+  if (m*n < TRANSPOSE_MIN_BLOCKED) {
+    for (i = 0; i < m; i++) {
+      for (j = 0; j < n; j++) {
+        B[j*m+i] = A[i*n+j];
+      }
+    }
+    return;
+  }
+  for (ib = 0; ib < m; ib += TRANSPOSE_BLOCK) {
+    iend = MIN(ib+TRANSPOSE_BLOCK, m);
+    for (jb = 0; jb < n; jb += TRANSPOSE_BLOCK) {
+      jend = MIN(jb+TRANSPOSE_BLOCK, n);
+      for (i = ib; i < iend; i++) {
+        for (j = jb; j < jend; j++) {
+          B[j*m+i] = A[i*n+j];
+        }
+      }
+    }
+  }
+}
+
+void omc_real_outer(size_t m, size_t n, const modelica_real *x, const modelica_real *y, modelica_real *C)
+{
+  size_t i, j;
+  for (i = 0; i < m; i++) {
+    const modelica_real s = x[i];
+    modelica_real *c = C+i*n;
+    for (j = 0; j < n; j++) {
+      c[j] = s*y[j];
+    }
+  }
+}
+
+modelica_real omc_real_dot(size_t n, const modelica_real *x, const modelica_real *y)
+{
+  /* Four partial sums so the additions do not wait for each other */
+  modelica_real s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i;
+  for (i = 0; i+4 <= n; i += 4) {
+    s0 += x[i]*y[i];
+    s1 += x[i+1]*y[i+1];
+    s2 += x[i+2]*y[i+2];
+    s3 += x[i+3]*y[i+3];
+  }
+  for (; i < n; i++) {
+    s0 += x[i]*y[i];
+  }
+  return (s0+s1)+(s2+s3);
+}
+
+void omc_integer_gemm(size_t m, size_t n, size_t k, const modelica_integer *A, const modelica_integer *B, modelica_integer *C)
+{
+  size_t i, j;
+  for (i = 0; i+GEMM_MR <= m; i += GEMM_MR) {
+    for (j = 0; j+GEMM_NR <= n; j += GEMM_NR) {
+      GEMM_TILE(modelica_integer, GEMM_MR, GEMM_NR)
+    }
+    if (j < n) {
+      GEMM_TILE(modelica_integer, GEMM_MR, n-j)
+    }
+  }
+  for (; i < m; i++) {
+    for (j = 0; j+GEMM_NR <= n; j += GEMM_NR) {
+      GEMM_TILE(modelica_integer, 1, GEMM_NR)
+    }
+    if (j < n) {
+      GEMM_TILE(modelica_integer, 1, n-j)
+    }
+  }
+}
+
+void omc_integer_gemv(size_t m, size_t n, const modelica_integer *A, const modelica_integer *x, modelica_integer *y)
+{
+  size_t i;
+  for (i = 0; i < m; i++) {
+    y[i] = omc_integer_dot(n, A+i*n, x);
+  }
+}
+
+void omc_integer_gevm(size_t m, size_t n, const modelica_integer *x, const modelica_integer *A, modelica_integer *y)
+{
+  size_t i, j;
+  memset(y, 0, n*sizeof(modelica_integer));
+  for (i = 0; i < m; i++) {
+    const modelica_integer *a0 = A+i*n;
+    const modelica_integer s0 = x[i];
+    for (j = 0; j < n; j++) {
+      y[j] += s0*a0[j];
+    }
+  }
+}
+
+void omc_integer_transpose(size_t m, size_t n, const modelica_integer *A, modelica_integer *B)
+{
+  size_t i, j, ib, jb, iend, jend;
+  if (m*n < TRANSPOSE_MIN_BLOCKED) {
+    for (i = 0; i < m; i++) {
+      for (j = 0; j < n; j++) {
+        B[j*m+i] = A[i*n+j];
+      }
+    }
+    return;
+  }
+  for (ib = 0; ib < m; ib += TRANSPOSE_BLOCK) {
+    iend = MIN(ib+TRANSPOSE_BLOCK, m);
+    for (jb = 0; jb < n; jb += TRANSPOSE_BLOCK) {
+      jend = MIN(jb+TRANSPOSE_BLOCK, n);
+      for (i = ib; i < iend; i++) {
+        for (j = jb; j < jend; j++) {
+          B[j*m+i] = A[i*n+j];
+        }
+      }
+    }
+  }
+}
+
+void omc_integer_outer(size_t m, size_t n, const modelica_integer *x, const modelica_integer *y, modelica_integer *C)
+{
+  size_t i, j;
+  for (i = 0; i < m; i++) {
+    const modelica_integer s = x[i];
+    modelica_integer *c = C+i*n;
+    for (j = 0; j < n; j++) {
+      c[j] = s*y[j];
+    }
+  }
+}
+
+modelica_integer omc_integer_dot(size_t n, const modelica_integer *x, const modelica_integer *y)
+{
+  modelica_integer s = 0;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    s += x[i]*y[i];
+  }
+  return s;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file array_kernels.h
+ *
+ * Dense kernels behind the matrix operations in real_array.c and
+ * integer_array.c. Matrices are contiguous and row-major, as in base_array_t,
+ * and the destination must not overlap the operands.
+ *
+ * Real products above a size threshold are passed to BLAS dgemm/dgemv,
+ * unless the runtime is compiled with OMC_NO_BLAS. Everything else uses loops
+ * blocked for registers and cache, with unit-stride inner loops that the
+ * compiler can vectorise.
+ */
+
+#ifndef ARRAY_KERNELS_H_
+#define ARRAY_KERNELS_H_
+
+#include "openmodelica.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* C[m,n] = A[m,k] * B[k,n] */
+void omc_real_gemm(size_t m, size_t n, size_t k, const modelica_real *A, const modelica_real *B, modelica_real *C);
+/* y[m] = A[m,n] * x[n] */
+void omc_real_gemv(size_t m, size_t n, const modelica_real *A, const modelica_real *x, modelica_real *y);
+/* y[n] = x[m] * A[m,n] */
+void omc_real_gevm(size_t m, size_t n, const modelica_real *x, const modelica_real *A, modelica_real *y);
+/* B[n,m] = transpose(A[m,n]) */
+void omc_real_transpose(size_t m, size_t n, const modelica_real *A, modelica_real *B);
+/* C[m,n] = x[m] * y[n]' */
+void omc_real_outer(size_t m, size_t n, const modelica_real *x, const modelica_real *y, modelica_real *C);
+modelica_real omc_real_dot(size_t n, const modelica_real *x, const modelica_real *y);
+
+void omc_integer_gemm(size_t m, size_t n, size_t k, const modelica_integer *A, const modelica_integer *B, modelica_integer *C);
+void omc_integer_gemv(size_t m, size_t n, const modelica_integer *A, const modelica_integer *x, modelica_integer *y);
+void omc_integer_gevm(size_t m, size_t n, const modelica_integer *x, const modelica_integer *A, modelica_integer *y);
+void omc_integer_transpose(size_t m, size_t n, const modelica_integer *A, modelica_integer *B);
+void omc_integer_outer(size_t m, size_t n, const modelica_integer *x, const modelica_integer *y, modelica_integer *C);
+modelica_integer omc_integer_dot(size_t n, const modelica_integer *x, const modelica_integer *y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
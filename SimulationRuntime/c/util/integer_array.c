@@ -40,6 +40,7 @@
 #include <math.h>
 
 #include "omc_error.h"
+#include "array_kernels.h"
 #include "meta/meta_modelica.h"
 
 static OMC_INLINE modelica_integer *integer_ptrget(const integer_array_t *a, size_t i)
@@ -942,58 +943,24 @@ integer_array_t mul_alloc_integer_array_scalar(const integer_array_t a, modelica
 
 modelica_integer mul_integer_scalar_product(const integer_array_t a, const integer_array_t b)
 {
-    size_t nr_of_elements;
-    size_t i;
-    modelica_integer res;
-
     /* Assert that a and b are vectors */
     omc_assert_macro(a.ndims == 1);
     omc_assert_macro(b.ndims == 1);
     /* Assert that vectors are of matching size */
     omc_assert_macro(a.dim_size[0] == b.dim_size[0]);
 
-    nr_of_elements = base_array_nr_of_elements(a);
-    res = 0;
-    for(i = 0; i < nr_of_elements; ++i) {
-        res += integer_get(a, i)*integer_get(b, i);
-    }
-    return res;
+    return omc_integer_dot(base_array_nr_of_elements(a), (const modelica_integer*) a.data, (const modelica_integer*) b.data);
 }
 
 void mul_integer_matrix_product(const integer_array_t * a,const integer_array_t * b,integer_array_t* dest)
 {
-    modelica_integer tmp;
-    size_t i_size;
-    size_t j_size;
-    size_t k_size;
-    size_t i;
-    size_t j;
-    size_t k;
-
-    /* Assert that dest har correct size */
-    i_size = dest->dim_size[0];
-    j_size = dest->dim_size[1];
-    k_size = a->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        for(j = 0; j < j_size; ++j) {
-            tmp = 0;
-            for(k = 0; k < k_size; ++k) {
-                tmp += integer_get(*a, (i * k_size) + k)*integer_get(*b, (k * j_size) + j);
-            }
-            integer_set(dest, (i * j_size) + j, tmp);
-        }
-    }
+    /* Assert that dest has correct size */
+    omc_integer_gemm(dest->dim_size[0], dest->dim_size[1], a->dim_size[1],
+                     (const modelica_integer*) a->data, (const modelica_integer*) b->data, (modelica_integer*) dest->data);
 }
 
 void mul_integer_matrix_vector(const integer_array_t * a, const integer_array_t * b,integer_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    size_t i_size;
-    size_t j_size;
-    modelica_integer tmp;
-
     /* Assert a matrix */
     omc_assert_macro(a->ndims == 2);
     /* Assert b vector */
@@ -1001,43 +968,19 @@ void mul_integer_matrix_vector(const integer_array_t * a, const integer_array_t
     /* Assert dest correct size (a vector)*/
     omc_assert_macro(dest->ndims == 1);
 
-    i_size = a->dim_size[0];
-    j_size = a->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        tmp = 0;
-        for(j = 0; j < j_size; ++j) {
-            tmp += integer_get(*a, (i * j_size) + j)*integer_get(*b, j);
-        }
-        integer_set(dest, i, tmp);
-    }
+    omc_integer_gemv(a->dim_size[0], a->dim_size[1], (const modelica_integer*) a->data, (const modelica_integer*) b->data, (modelica_integer*) dest->data);
 }
 
 
 void mul_integer_vector_matrix(const integer_array_t * a, const integer_array_t * b,integer_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    size_t i_size;
-    size_t j_size;
-    modelica_integer tmp;
-
     /* Assert a vector */
     omc_assert_macro(a->ndims == 1);
     /* Assert b matrix */
     omc_assert_macro(b->ndims == 2);
     /* Assert dest vector of correct size */
 
-    i_size = a->dim_size[0];
-    j_size = b->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        tmp = 0;
-        for(j = 0; j < j_size; ++j) {
-            tmp += integer_get(*a, j) * integer_get(*b, (j * j_size) + i);
-        }
-        integer_set(dest, i, tmp);
-    }
+    omc_integer_gevm(a->dim_size[0], b->dim_size[1], (const modelica_integer*) a->data, (const modelica_integer*) b->data, (modelica_integer*) dest->data);
 }
 
 integer_array_t mul_alloc_integer_matrix_product_smart(const integer_array_t a, const integer_array_t b)
@@ -1358,9 +1301,6 @@ void transpose_alloc_integer_array(const integer_array_t * a, integer_array_t* d
  */
 void transpose_integer_array(const integer_array_t * a, integer_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    /*  size_t k;*/
     size_t n,m;
 
     if(a->ndims == 1) {
@@ -1375,17 +1315,11 @@ void transpose_integer_array(const integer_array_t * a, integer_array_t* dest)
 
     omc_assert_macro(dest->dim_size[0] == m && dest->dim_size[1] == n);
 
-    for(i = 0; i < n; ++i) {
-        for(j = 0; j < m; ++j) {
-            integer_set(dest, (j * n) + i, integer_get(*a, (i * m) + j));
-        }
-    }
+    omc_integer_transpose(n, m, (const modelica_integer*) a->data, (modelica_integer*) dest->data);
 }
 
 void outer_product_integer_array(const integer_array_t * v1,const integer_array_t * v2, integer_array_t* dest)
 {
-  size_t i;
-  size_t j;
   size_t number_of_elements_a;
   size_t number_of_elements_b;
 
@@ -1395,11 +1329,7 @@ void outer_product_integer_array(const integer_array_t * v1,const integer_array_
   /* Assert a is a vector */
   /* Assert b is a vector */
 
-  for(i = 0; i < number_of_elements_a; ++i) {
-    for(j = 0; i < number_of_elements_b; ++j) {
-      integer_set(dest, (i * number_of_elements_b) + j, integer_get(*v1, i)*integer_get(*v2, j));
-    }
-  }
+  omc_integer_outer(number_of_elements_a, number_of_elements_b, (const modelica_integer*) v1->data, (const modelica_integer*) v2->data, (modelica_integer*) dest->data);
 }
 
 void outer_product_alloc_integer_array(const integer_array_t* v1, const integer_array_t* v2, integer_array_t* dest)
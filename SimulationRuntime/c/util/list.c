@@ -52,6 +52,9 @@ struct LIST
   LIST_NODE *last;
   unsigned int itemSize;
   unsigned int length;
+  LIST_NODE *freeNodes;   /* unused nodes of a reserved list, see listReserve */
+  unsigned int nFreeNodes;
+  int reserved;           /* if TRUE released nodes are kept for reuse */
 };
 
 LIST *allocList(unsigned int itemSize)
@@ -63,15 +66,90 @@ LIST *allocList(unsigned int itemSize)
   list->last = NULL;
   list->itemSize = itemSize;
   list->length = 0;
+  list->freeNodes = NULL;
+  list->nFreeNodes = 0;
+  list->reserved = 0;
 
   return list;
 }
 
+/*! \fn listReserve
+ *
+ *  Preallocates nodes, so that the list can hold n elements without
+ *  allocating memory. From now on, removed nodes are kept and reused.
+ *
+ *  \param [ref] [list]
+ *  \param [in]  [n]
+ */
+void listReserve(LIST *list, unsigned int n)
+{
+  assertStreamPrint(NULL, 0 != list, "invalid list-pointer");
+
+  list->reserved = 1;
+  while(list->length + list->nFreeNodes < n)
+  {
+    LIST_NODE *tmpNode = (LIST_NODE*)malloc(sizeof(LIST_NODE));
+    assertStreamPrint(NULL, 0 != tmpNode, "out of memory");
+
+    tmpNode->data = malloc(list->itemSize);
+    assertStreamPrint(NULL, 0 != tmpNode->data, "out of memory");
+
+    tmpNode->next = list->freeNodes;
+    list->freeNodes = tmpNode;
+    ++(list->nFreeNodes);
+  }
+}
+
+static LIST_NODE *newNode(LIST *list)
+{
+  LIST_NODE *tmpNode = list->freeNodes;
+
+  if(tmpNode)
+  {
+    list->freeNodes = tmpNode->next;
+    --(list->nFreeNodes);
+    return tmpNode;
+  }
+
+  tmpNode = (LIST_NODE*)malloc(sizeof(LIST_NODE));
+  assertStreamPrint(NULL, 0 != tmpNode, "out of memory");
+
+  tmpNode->data = malloc(list->itemSize);
+  assertStreamPrint(NULL, 0 != tmpNode->data, "out of memory");
+
+  return tmpNode;
+}
+
+/*! \fn listReleaseNode
+ *
+ *  Frees a node which is no longer part of the list, or keeps it for
+ *  reuse if the list is reserved.
+ */
+void listReleaseNode(LIST *list, LIST_NODE *node)
+{
+  if(list->reserved)
+  {
+    node->next = list->freeNodes;
+    list->freeNodes = node;
+    ++(list->nFreeNodes);
+  }
+  else
+  {
+    freeNode(node);
+  }
+}
+
 void freeList(LIST *list)
 {
   if(list)
   {
     listClear(list);
+    while(list->freeNodes)
+    {
+      LIST_NODE *tmpNode = list->freeNodes->next;
+      freeNode(list->freeNodes);
+      list->freeNodes = tmpNode;
+    }
     free(list);
   }
 }
@@ -87,12 +165,7 @@ void listPushFront(LIST *list, const void *data)
   LIST_NODE *tmpNode = NULL;
   assertStreamPrint(NULL, 0 != list, "invalid list-pointer");
 
-  tmpNode = (LIST_NODE*)malloc(sizeof(LIST_NODE));
-  assertStreamPrint(NULL, 0 != tmpNode, "out of memory");
-
-  tmpNode->data = malloc(list->itemSize);
-  assertStreamPrint(NULL, 0 != tmpNode->data, "out of memory");
-
+  tmpNode = newNode(list);
   memcpy(tmpNode->data, data, list->itemSize);
   tmpNode->next = list->first;
   ++(list->length);
@@ -107,12 +180,7 @@ void listPushBack(LIST *list, const void *data)
   LIST_NODE *tmpNode = NULL;
   assertStreamPrint(NULL, 0 != list, "invalid list-pointer");
 
-  tmpNode = (LIST_NODE*)malloc(sizeof(LIST_NODE));
-  assertStreamPrint(NULL, 0 != tmpNode, "out of memory");
-
-  tmpNode->data = malloc(list->itemSize);
-  assertStreamPrint(NULL, 0 != tmpNode->data, "out of memory");
-
+  tmpNode = newNode(list);
   memcpy(tmpNode->data, data, list->itemSize);
   tmpNode->next = NULL;
   ++(list->length);
@@ -128,11 +196,7 @@ void listPushBack(LIST *list, const void *data)
 
 void listInsert(LIST *list, LIST_NODE* prevNode, const void *data)
 {
-  LIST_NODE *tmpNode = (LIST_NODE*)malloc(sizeof(LIST_NODE));
-  assertStreamPrint(NULL, 0 != tmpNode, "out of memory");
-
-  tmpNode->data = malloc(list->itemSize);
-  assertStreamPrint(NULL, 0 != tmpNode->data, "out of memory");
+  LIST_NODE *tmpNode = newNode(list);
   memcpy(tmpNode->data, data, list->itemSize);
 
   tmpNode->next = prevNode->next;
@@ -170,7 +234,7 @@ void listPopFront(LIST *list)
     if(list->first)
     {
       LIST_NODE *tmpNode = list->first->next;
-      freeNode(list->first);
+      listReleaseNode(list, list->first);
 
       list->first = tmpNode;
       --(list->length);
@@ -191,7 +255,7 @@ void listClear(LIST *list)
   while(delNode)
   {
     LIST_NODE *tmpNode = delNode->next;
-    freeNode(delNode);
+    listReleaseNode(list, delNode);
     delNode = tmpNode;
   }
 
@@ -205,7 +269,7 @@ void removeNodes(LIST* list, LIST_NODE *node)
   while(node)
   {
     LIST_NODE *tmpNode = node->next;
-    freeNode(node);
+    listReleaseNode(list, node);
     node = tmpNode;
     --(list->length);
   }
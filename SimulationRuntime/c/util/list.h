@@ -50,6 +50,7 @@ extern "C" {
 
   LIST *allocList(unsigned int itemSize);
   void freeList(LIST *list);
+  void listReserve(LIST *list, unsigned int n);
 
   void listPushFront(LIST *list, const void *data);
   void listPushBack(LIST *list, const void *data);
@@ -64,6 +65,8 @@ extern "C" {
 
   void listClear(LIST *list);
   void freeNode(LIST_NODE *node);
+  void listReleaseNode(LIST *list, LIST_NODE *node);
+  void removeNodes(LIST* list, LIST_NODE *node);
 
   LIST_NODE *listFirstNode(LIST *list);
   LIST_NODE *listNextNode(LIST_NODE *node);
@@ -40,7 +40,7 @@
 
 extern modelica_string stringAppend(modelica_string s1, modelica_string s2);
 #define stringCompare(x,y) mmc_stringCompare(x,y)
-#define stringEqual(x,y) (MMC_STRLEN(x) == MMC_STRLEN(y) && !stringCompare(x,y))
+#define stringEqual(x,y) ((x) == (y) || (MMC_STRLEN(x) == MMC_STRLEN(y) && !stringCompare(x,y)))
 
 #define modelica_string_length(STR) MMC_STRLEN(STR)
 
@@ -687,6 +687,79 @@ int omc_matlab4_read_all_vals(ModelicaMatReader *reader)
   return 0;
 }
 
+int omc_matlab4_read_vars_vals(ModelicaMatReader *reader, const int *varIndices, int n)
+{
+  size_t nvar = reader->nvar, nrows = reader->nrows;
+  size_t elemSize = reader->doublePrecision==1 ? sizeof(double) : sizeof(float);
+  size_t blockRows, row, r, ncols = 0;
+  uint32_t *cols;
+  char *block;
+  int i, k;
+
+  if (n == 0 || nvar == 0 || nrows == 0) {
+    return 0;
+  }
+  /* The columns that are not in memory yet; each is allocated once */
+  cols = (uint32_t*) malloc(n*sizeof(uint32_t));
+  for (i=0; i<n; i++) {
+    size_t c = abs(varIndices[i]) - 1;
+    assert(c < nvar);
+    if (reader->vars[c] || (varIndices[i] < 0 && reader->vars[c+nvar])) continue;
+    reader->vars[c] = (double*) malloc(nrows*sizeof(double));
+    cols[ncols++] = c;
+  }
+
+  if (ncols) {
+    /* Read the row-major data in blocks of about 1 MB */
+    blockRows = (1<<20) / (nvar*elemSize);
+    if (blockRows == 0) blockRows = 1;
+    if (blockRows > nrows) blockRows = nrows;
+    block = (char*) malloc(blockRows*nvar*elemSize);
+    fseek(reader->file, reader->var_offset, SEEK_SET);
+    for (row=0; row<nrows; row+=blockRows) {
+      size_t nblock = row+blockRows > nrows ? nrows-row : blockRows;
+      if (nblock*nvar != fread(block, elemSize, nblock*nvar, reader->file)) {
+        for (k=0; k<ncols; k++) {
+          free(reader->vars[cols[k]]);
+          reader->vars[cols[k]] = NULL;
+        }
+        free(block);
+        free(cols);
+        return 1;
+      }
+      if (reader->doublePrecision==1) {
+        const double *data = (const double*) block;
+        for (r=0; r<nblock; r++) {
+          for (k=0; k<ncols; k++) {
+            reader->vars[cols[k]][row+r] = data[r*nvar + cols[k]];
+          }
+        }
+      } else {
+        const float *data = (const float*) block;
+        for (r=0; r<nblock; r++) {
+          for (k=0; k<ncols; k++) {
+            reader->vars[cols[k]][row+r] = data[r*nvar + cols[k]];
+          }
+        }
+      }
+    }
+    free(block);
+  }
+  free(cols);
+
+  /* Negative aliases */
+  for (i=0; i<n; i++) {
+    size_t c = abs(varIndices[i]) - 1;
+    if (varIndices[i] < 0 && !reader->vars[c+nvar]) {
+      reader->vars[c+nvar] = (double*) malloc(nrows*sizeof(double));
+      for (row=0; row<nrows; row++) {
+        reader->vars[c+nvar][row] = -reader->vars[c][row];
+      }
+    }
+  }
+  return 0;
+}
+
 double omc_matlab4_read_single_val(double *res, ModelicaMatReader *reader, int varIndex, int timeIndex)
 {
   size_t absVarIndex = abs(varIndex);
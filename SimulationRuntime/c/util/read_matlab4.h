@@ -89,6 +89,10 @@ double omc_matlab4_stopTime(ModelicaMatReader *reader);
 void matrix_transpose(double *m, int w, int h);
 void matrix_transpose_uint32(uint32_t *m, int w, int h);
 int omc_matlab4_read_all_vals(ModelicaMatReader *reader);
+/* Reads the values of the variables with the given indices (as in
+ * omc_matlab4_read_vals) in one sequential pass over the file.
+ * Returns 0 on success */
+int omc_matlab4_read_vars_vals(ModelicaMatReader *reader, const int *varIndices, int n);
 
 /* Fix the placement of a.der(b) -> der(a.b) */
 char* openmodelicaStyleVariableName(const char *varName);
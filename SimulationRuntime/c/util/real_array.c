@@ -35,6 +35,7 @@
 #include "division.h"
 #include "integer_array.h"
 #include "omc_error.h"
+#include "array_kernels.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -920,93 +921,35 @@ real_array_t mul_alloc_real_array(const real_array_t a,const real_array_t b)
 
 modelica_real mul_real_scalar_product(const real_array_t a, const real_array_t b)
 {
-    size_t nr_of_elements;
-    size_t i;
-    modelica_real res;
     /* Assert that a and b are vectors */
     /* Assert that vectors are of matching size */
-
-    nr_of_elements = real_array_nr_of_elements(a);
-    res = 0.0;
-    for(i = 0; i < nr_of_elements; ++i) {
-        res += real_get(a, i)*real_get(b, i);
-    }
-    return res;
+    return omc_real_dot(real_array_nr_of_elements(a), (const modelica_real*) a.data, (const modelica_real*) b.data);
 }
 
 void mul_real_matrix_product(const real_array_t * a,const real_array_t * b,real_array_t* dest)
 {
-    modelica_real tmp;
-    size_t i_size;
-    size_t j_size;
-    size_t k_size;
-    size_t i;
-    size_t j;
-    size_t k;
-
     /* Assert that dest has correct size */
-    i_size = dest->dim_size[0];
-    j_size = dest->dim_size[1];
-    k_size = a->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        for(j = 0; j < j_size; ++j) {
-            tmp = 0;
-            for(k = 0; k < k_size; ++k) {
-                tmp += real_get(*a, (i * k_size) + k)*real_get(*b, (k * j_size) + j);
-            }
-            real_set(dest, (i * j_size) + j, tmp);
-        }
-    }
+    omc_real_gemm(dest->dim_size[0], dest->dim_size[1], a->dim_size[1],
+                  (const modelica_real*) a->data, (const modelica_real*) b->data, (modelica_real*) dest->data);
 }
 
 void mul_real_matrix_vector(const real_array_t * a, const real_array_t * b,real_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    size_t i_size;
-    size_t j_size;
-    modelica_real tmp;
-
     /* Assert a matrix */
     /* Assert b vector */
     /* Assert dest correct size (a vector)*/
 
-    i_size = a->dim_size[0];
-    j_size = a->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        tmp = 0;
-        for(j = 0; j < j_size; ++j) {
-            tmp += real_get(*a, (i * j_size) + j) * real_get(*b, j);
-        }
-        real_set(dest, i, tmp);
-    }
+    omc_real_gemv(a->dim_size[0], a->dim_size[1], (const modelica_real*) a->data, (const modelica_real*) b->data, (modelica_real*) dest->data);
 }
 
 
 void mul_real_vector_matrix(const real_array_t * a, const real_array_t * b,real_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    size_t i_size;
-    size_t j_size;
-    modelica_real tmp;
-
     /* Assert a vector */
     /* Assert b matrix */
     /* Assert dest vector of correct size */
 
-    i_size = a->dim_size[0];
-    j_size = b->dim_size[1];
-
-    for(i = 0; i < i_size; ++i) {
-        tmp = 0;
-        for(j = 0; j < j_size; ++j) {
-            tmp += real_get(*a, j) * real_get(*b, (j * j_size) + i);
-        }
-        real_set(dest, i, tmp);
-    }
+    omc_real_gevm(a->dim_size[0], b->dim_size[1], (const modelica_real*) a->data, (const modelica_real*) b->data, (modelica_real*) dest->data);
 }
 
 real_array_t mul_alloc_real_matrix_product_smart(const real_array_t a, const real_array_t b)
@@ -1343,9 +1286,6 @@ void transpose_alloc_real_array(const real_array_t * a, real_array_t* dest)
  */
 void transpose_real_array(const real_array_t * a, real_array_t* dest)
 {
-    size_t i;
-    size_t j;
-    /*  size_t k;*/
     size_t n,m;
 
     if(a->ndims == 1) {
@@ -1360,18 +1300,12 @@ void transpose_real_array(const real_array_t * a, real_array_t* dest)
 
     omc_assert_macro(dest->dim_size[0] == m && dest->dim_size[1] == n);
 
-    for(i = 0; i < n; ++i) {
-        for(j = 0; j < m; ++j) {
-            real_set(dest, (j * n) + i, real_get(*a, (i * m) + j));
-        }
-    }
+    omc_real_transpose(n, m, (const modelica_real*) a->data, (modelica_real*) dest->data);
 }
 
 void outer_product_real_array(const real_array_t * v1, const real_array_t * v2,
                               real_array_t* dest)
 {
-    size_t i;
-    size_t j;
     size_t number_of_elements_a;
     size_t number_of_elements_b;
 
@@ -1381,12 +1315,7 @@ void outer_product_real_array(const real_array_t * v1, const real_array_t * v2,
     /* Assert a is a vector */
     /* Assert b is a vector */
 
-    for(i = 0; i < number_of_elements_a; ++i) {
-        for(j = 0; i < number_of_elements_b; ++j) {
-            real_set(dest, (i * number_of_elements_b) + j,
-                     real_get(*v1, i) * real_get(*v2, j));
-        }
-    }
+    omc_real_outer(number_of_elements_a, number_of_elements_b, (const modelica_real*) v1->data, (const modelica_real*) v2->data, (modelica_real*) dest->data);
 }
 
 void outer_product_alloc_real_array(real_array_t* v1, real_array_t* v2, real_array_t* dest)
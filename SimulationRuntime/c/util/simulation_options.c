@@ -41,13 +41,19 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_DAE_MODE */              "daeMode",
   /* FLAG_EMBEDDED_SERVER */       "embeddedServer",
   /* FLAG_EMIT_PROTECTED */        "emit_protected",
+  /* FLAG_ENSEMBLE */              "ensemble",
+  /* FLAG_ENSEMBLE_THREADS */      "ensembleThreads",
   /* FLAG_F */                     "f",
   /* FLAG_HELP */                  "help",
+  /* FLAG_IDA_ADJOINT */           "idaAdjoint",
+  /* FLAG_IDA_ADJOINT_PARAMS */    "idaAdjointParams",
   /* FLAG_IDA_MAXERRORTESTFAIL */  "idaMaxErrorTestFails",
   /* FLAG_IDA_MAXNONLINITERS */    "idaMaxNonLinIters",
   /* FLAG_IDA_MAXCONVFAILS */      "idaMaxConvFails",
   /* FLAG_IDA_NONLINCONVCOEF */    "idaNonLinConvCoef",
   /* FLAG_IDA_LS */                "idaLS",
+  /* FLAG_IDA_PREC */              "idaPrec",
+  /* FLAG_IDA_PREC_REFRESH */      "idaPrecRefresh",
   /* FLAG_IDAS */                  "idaSensitivity",
   /* FLAG_IGNORE_HIDERESULT */     "ignoreHideResult",
   /* FLAG_IIF */                   "iif",
@@ -58,12 +64,15 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_INPUT_CSV */             "csvInput",
   /* FLAG_INPUT_FILE */            "exInputFile",
   /* FLAG_INPUT_FILE_STATES */     "stateFile",
+  /* FLAG_INPUT_STREAM */          "inputStream",
+  /* FLAG_INPUT_STREAM_WINDOW */   "inputStreamWindow",
   /* FLAG_IPOPT_HESSE*/            "ipopt_hesse",
   /* FLAG_IPOPT_INIT*/             "ipopt_init",
   /* FLAG_IPOPT_JAC*/              "ipopt_jac",
   /* FLAG_IPOPT_MAX_ITER */        "ipopt_max_iter",
   /* FLAG_IPOPT_WARM_START */      "ipopt_warm_start",
   /* FLAG_JACOBIAN */              "jacobian",
+  /* FLAG_JACOBIAN_THREADS */      "jacobianThreads",
   /* FLAG_L */                     "l",
   /* FLAG_L_DATA_RECOVERY */       "l_datarec",
   /* FLAG_LOG_FORMAT */            "logFormat",
@@ -72,17 +81,23 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_LSS */                   "lss",
   /* FLAG_LSS_MAX_DENSITY */       "lssMaxDensity",
   /* FLAG_LSS_MIN_SIZE */          "lssMinSize",
+  /* FLAG_LOAD_SNAPSHOT */         "loadSnapshot",
   /* FLAG_LV */                    "lv",
   /* FLAG_MAX_BISECTION_ITERATIONS */  "mbi",
   /* FLAG_MAX_EVENT_ITERATIONS */  "mei",
   /* FLAG_MAX_ORDER */             "maxIntegrationOrder",
   /* FLAG_MAX_STEP_SIZE */         "maxStepSize",
   /* FLAG_MEASURETIMEPLOTFORMAT */ "measureTimePlotFormat",
+  /* FLAG_MR_IMPLICIT */           "mrImplicit",
+  /* FLAG_MR_MAX_FAST */           "mrMaxFast",
+  /* FLAG_MR_PARTITION_INTERVAL */ "mrPartitionInterval",
   /* FLAG_NEWTON_FTOL */           "newtonFTol",
   /* FLAG_NEWTON_XTOL */           "newtonXTol",
   /* FLAG_NEWTON_STRATEGY */       "newton",
   /* FLAG_NLS */                   "nls",
   /* FLAG_NLS_INFO */              "nlsInfo",
+  /* FLAG_NLSS_MAX_DENSITY */      "nlssMaxDensity",
+  /* FLAG_NLSS_MIN_SIZE */         "nlssMinSize",
   /* FLAG_NOEMIT */                "noemit",
   /* FLAG_NOEQUIDISTANT_GRID */    "noEquidistantTimeGrid",
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/ "noEquidistantOutputFrequency",
@@ -98,9 +113,13 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_OVERRIDE */              "override",
   /* FLAG_OVERRIDE_FILE */         "overrideFile",
   /* FLAG_PORT */                  "port",
+  /* FLAG_QSS_GRID_OUTPUT */       "qssGridOutput",
+  /* FLAG_QSS_METHOD */            "qssMethod",
   /* FLAG_R */                     "r",
   /* FLAG_RT */                    "rt",
+  /* FLAG_RT_PREALLOC */           "rtPrealloc",
   /* FLAG_S */                     "s",
+  /* FLAG_SAVE_SNAPSHOT */         "saveSnapshot",
   /* FLAG_SOLVER_STEPS */          "steps",
   /* FLAG_UP_HESSIAN */            "keepHessian",
   /* FLAG_W */                     "w",
@@ -119,13 +138,19 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_DAE_MODE */              "flag to let the integrator use daeResiduals",
   /* FLAG_EMBEDDED_SERVER */       "enables an embedded server. Valid values: none, opc-da [broken], opc-ua [experimental], or the path to a shared object.",
   /* FLAG_EMIT_PROTECTED */        "emits protected variables to the result-file",
+  /* FLAG_ENSEMBLE */              "value specifies a csv-file with parameter variants that are simulated concurrently in this process",
+  /* FLAG_ENSEMBLE_THREADS */      "[int (default number of processors)] value specifies the number of threads used by -ensemble",
   /* FLAG_F */                     "value specifies a new setup XML file to the generated simulation code",
   /* FLAG_HELP */                  "get detailed information that specifies the command-line flag",
+  /* FLAG_IDA_ADJOINT */           "[string list] objectives for an adjoint sensitivity analysis with ida",
+  /* FLAG_IDA_ADJOINT_PARAMS */    "[string list] parameters of the adjoint sensitivity analysis",
   /* FLAG_IDA_MAXERRORTESTFAIL */  "value specifies the maximum number of error test failures in attempting one step. The default value is 7.",
   /* FLAG_IDA_MAXNONLINITERS */    "value specifies the maximum number of nonlinear solver iterations at one step. The default value is 3.",
   /* FLAG_IDA_MAXCONVFAILS */      "value specifies the maximum number of nonlinear solver convergence failures at one step. The default value is 10.",
   /* FLAG_IDA_NONLINCONVCOEF */    "value specifies the safety factor in the nonlinear convergence test. The default value is 0.33.",
   /* FLAG_IDA_LS */                "selects the linear solver used by ida",
+  /* FLAG_IDA_PREC */              "selects the preconditioner of the iterative linear solvers of ida",
+  /* FLAG_IDA_PREC_REFRESH */      "value specifies how often the jacobian of the ida preconditioner is evaluated",
   /* FLAG_IDAS */                  "flag to add sensitivity information to the result files",
   /* FLAG_IGNORE_HIDERESULT */     "ignore HideResult=true annotation",
   /* FLAG_IIF */                   "value specifies an external file for the initialization of the model",
@@ -136,12 +161,15 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_INPUT_CSV */             "value specifies an csv-file with inputs for the simulation/optimization of the model",
   /* FLAG_INPUT_FILE */            "value specifies an external file with inputs for the simulation/optimization of the model",
   /* FLAG_INPUT_FILE_STATES */     "value specifies an file with states start values for the optimization of the model",
+  /* FLAG_INPUT_STREAM */          "value specifies an input file (csv, mat or raw binary) that is streamed in a bounded window during the simulation",
+  /* FLAG_INPUT_STREAM_WINDOW */   "[int (default 4096)] value specifies the number of rows kept in memory by -inputStream",
   /* FLAG_IPOPT_HESSE */           "value specifies the hessian for Ipopt",
   /* FLAG_IPOPT_INIT */            "value specifies the initial guess for optimization",
   /* FLAG_IPOPT_JAC */             "value specifies the jacobian for Ipopt",
   /* FLAG_IPOPT_MAX_ITER */        "value specifies the max number of iteration for ipopt",
   /* FLAG_IPOPT_WARM_START */      "value specifies lvl for a warm start in ipopt: 1,2,3,...",
   /* FLAG_JACOBIAN */              "selects the type of the jacobians that is used for the integrator.\n  jacobian=[coloredNumerical (default) |numerical|internalNumerical|coloredSymbolical|symbolical].",
+  /* FLAG_JACOBIAN_THREADS */      "[int (default 1)] value specifies the number of threads used to evaluate colored numerical Jacobians",
   /* FLAG_L */                     "value specifies a time where the linearization of the model should be performed",
   /* FLAG_L_DATA_RECOVERY */       "emit data recovery matrices with model linearization",
   /* FLAG_LOG_FORMAT */            "value specifies the log format of the executable. -logFormat=text (default) or -logFormat=xml",
@@ -150,17 +178,23 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_LSS */                   "value specifies the linear sparse solver method (default: umfpack)",
   /* FLAG_LSS_MAX_DENSITY */       "[double (default 0.2)] value specifies the maximum density for using a linear sparse solver",
   /* FLAG_LSS_MIN_SIZE */          "[int (default 4001)] value specifies the minimum system size for using a linear sparse solver",
+  /* FLAG_LOAD_SNAPSHOT */         "[string] warm-start the simulation from a snapshot file",
   /* FLAG_LV */                    "[string list] value specifies the logging level",
   /* FLAG_MAX_BISECTION_ITERATIONS */  "[int (default 0)] value specifies the maximum number of bisection iterations for state event detection or zero for default behavior",
   /* FLAG_MAX_EVENT_ITERATIONS */  "[int (default 20)] value specifies the maximum number of event iterations",
   /* FLAG_MAX_ORDER */             "value specifies maximum integration order, used by dassl solver",
   /* FLAG_MAX_STEP_SIZE */         "value specifies maximum absolute step size, used by dassl solver",
   /* FLAG_MEASURETIMEPLOTFORMAT */ "value specifies the output format of the measure time functionality",
+  /* FLAG_MR_IMPLICIT */           "integrate the fast partition of the multirate solver with linearly implicit sub-steps",
+  /* FLAG_MR_MAX_FAST */           "[double (default 0.3)] value specifies the maximum share of fast states for the multirate solver",
+  /* FLAG_MR_PARTITION_INTERVAL */ "[int (default 10)] value specifies the number of macro steps between re-partitioning for the multirate solver",
   /* FLAG_NEWTON_FTOL */           "[double (default 1e-12)] tolerance respecting residuals for updating solution vector in Newton solver",
   /* FLAG_NEWTON_XTOL */           "[double (default 1e-12)] tolerance respecting newton correction (delta_x) for updating solution vector in Newton solver",
   /* FLAG_NEWTON_STRATEGY */       "value specifies the damping strategy for the newton solver",
   /* FLAG_NLS */                   "value specifies the nonlinear solver",
   /* FLAG_NLS_INFO */              "outputs detailed information about solving process of non-linear systems into csv files.",
+  /* FLAG_NLSS_MAX_DENSITY */      "[double (default 0.1)] value specifies the maximum density for using a nonlinear sparse solver",
+  /* FLAG_NLSS_MIN_SIZE */         "[int (default 1001)] value specifies the minimum system size for using a nonlinear sparse solver",
   /* FLAG_NOEMIT */                "do not emit any results to the result file",
   /* FLAG_NOEQUIDISTANT_GRID */    "stores results not in equidistant time grid as given by stepSize or numberOfIntervals, instead the variable step size of dassl is used.",
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/ "value controls the output frequency in noEquidistantTimeGrid mode",
@@ -176,9 +210,13 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_OVERRIDE */              "override the variables or the simulation settings in the XML setup file",
   /* FLAG_OVERRIDE_FILE */         "will override the variables or the simulation settings in the XML setup file with the values from the file",
   /* FLAG_PORT */                  "value specifies the port for simulation status (default disabled)",
+  /* FLAG_QSS_GRID_OUTPUT */       "emits the results of the qss solver on the output grid instead of after every step",
+  /* FLAG_QSS_METHOD */            "value specifies the QSS method of the qss solver: qss1 (default), qss2, qss3 or liqss2",
   /* FLAG_R */                     "value specifies a new result file than the default Model_res.mat",
   /* FLAG_RT */                    "value specifies the scaling factor for real-time synchronization (0 disables)",
+  /* FLAG_RT_PREALLOC */           "value specifies the memory pool size in MB; preallocates all step workspaces during the initialization (real-time mode)",
   /* FLAG_S */                     "value specifies the solver",
+  /* FLAG_SAVE_SNAPSHOT */         "[double] write a snapshot at the given time",
   /* FLAG_SOLVER_STEPS */          "dumps the number of integration steps into the result file",
   /* FLAG_UP_HESSIAN */            "value specifies the number of steps, which keep hessian matrix constant",
   /* FLAG_W */                     "shows all warnings even if a related log-stream is inactive",
@@ -211,11 +249,27 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * filename - path to a shared object implementing the embedded server interface (requires access to internal OMC data-structures if you want to read or write data)",
   /* FLAG_EMIT_PROTECTED */
   "  Emits protected variables to the result-file.",
+  /* FLAG_ENSEMBLE */
+  "  Value specifies a csv-file with one column per parameter (or start value) to override\n"
+  "  and one row per simulation run. All runs share the model data read from the init file\n"
+  "  and are simulated concurrently (see -ensembleThreads). The results of run k (counted from 0)\n"
+  "  are written to <result>_k.<format>, e.g. model_res_0.mat.",
+  /* FLAG_ENSEMBLE_THREADS */
+  "  Value specifies the number of threads used to simulate the runs given by -ensemble.\n"
+  "  The default is the number of processors.",
   /* FLAG_F */
   "  Value specifies a new setup XML file to the generated simulation code.\n",
   /* FLAG_HELP */
   "  Get detailed information that specifies the command-line flag\n"
   "  For example, -help=f prints detailed information for command-line flag f.",
+  /* FLAG_IDA_ADJOINT */
+  "  Value (a comma-separated list) specifies scalar objectives for an adjoint sensitivity analysis with the ida solver.\n"
+  "  Each objective is final(name) for the value of a real variable at the stop time or integral(name) for its integral over the simulation interval.\n"
+  "  The forward integration is checkpointed and afterwards one backward problem is solved per objective.\n"
+  "  The gradients with respect to the parameters (see -idaAdjointParams) and to the start values of the states are written to <model>_adjoint.csv.\n"
+  "  Events after the start time are not supported.",
+  /* FLAG_IDA_ADJOINT_PARAMS */
+  "  Value (a comma-separated list) specifies the real parameters for -idaAdjoint. By default all real parameters are used.",
   /* FLAG_IDA_MAXERRORTESTFAIL */
   "  value specifies the maximum number of error test failures in attempting one step. The default value is 7.",
   /* FLAG_IDA_MAXNONLINITERS */
@@ -231,6 +285,14 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * spgmr - sparse iterative linear solver based on generalized minimal residual method, convergance is not guaranteed, sundials method\n"
   "  * spbcg - sparse iterative linear solver based on biconjugate gradient method, convergance is not guaranteed, sundials method\n"
   "  * spgmr - sparse iterative linear solver based on transpose free quasi-minimal residual method, convergance is not guaranteed, sundials method\n",
+  /* FLAG_IDA_PREC */
+  "  Value specifies the preconditioner of the iterative linear solvers spgmr, spbcg and sptfqmr of the IDA integrator. Valid values:\n\n"
+  "  * none - default, no preconditioner\n"
+  "  * bjac - block jacobi, dense LU decomposition of the strong components of the jacobian sparsity pattern\n"
+  "  * ilu0 - incomplete LU decomposition without fill-in on the colored jacobian sparsity pattern\n"
+  "  * ilut - incomplete LU decomposition with threshold dropping and limited fill-in\n",
+  /* FLAG_IDA_PREC_REFRESH */
+  "  Value specifies the maximum number of preconditioner setups of the IDA integrator between two evaluations of the jacobian used by -idaPrec. Between the evaluations only the decomposition is updated for the new step size and order. A value of 1 evaluates the jacobian at every setup, a value of 0 only after convergence failures of the nonlinear solver. In DAE mode the jacobian is evaluated at every setup. The default value is 10.",
   /* FLAG_IDAS */
   "  Enables sensitivity analysis with respect to parameters if the model is compiled with omc flag --calculateSensitivities.",
   /* FLAG_IGNORE_HIDERESULT */
@@ -252,6 +314,15 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies an external file with inputs for the simulation/optimization of the model.",
   /* FLAG_INPUT_FILE_STATES */
   "  Value specifies an file with states start values for the optimization of the model.",
+  /* FLAG_INPUT_STREAM */
+  "  Value specifies an input file that is read and parsed ahead on a background thread\n"
+  "  instead of being loaded completely into memory. Only a bounded window of rows is kept\n"
+  "  (see -inputStreamWindow). The format is chosen by the file extension:\n"
+  "  .csv (header line with the input names), .mat (MAT v4 result file) and\n"
+  "  .bin (raw native-endian doubles, one row [time, u_1, ..., u_n] per time point in model input order).",
+  /* FLAG_INPUT_STREAM_WINDOW */
+  "  Value specifies the number of rows of the input file kept in memory by -inputStream.\n"
+  "  The default value is 4096.",
   /* FLAG_IPOPT_HESSE */
   "  Value specifies the hessematrix for Ipopt(OMC, BFGS, const).",
   /* FLAG_IPOPT_INIT */
@@ -269,6 +340,13 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * coloredSymbolical (colored symbolical Jacobian. Only usable if the simulation is compiled with --generateSymbolicJacobian or --generateSymbolicLinearization.\n"
   "  * numerical - numerical Jacobian.\n\n"
   "  * symbolical - symbolical Jacobian. Only usable if the simulation is compiled with --generateSymbolicJacobian or --generateSymbolicLinearization.",
+  /* FLAG_JACOBIAN_THREADS */
+  "  Value specifies the number of threads used to evaluate the columns of colored\n"
+  "  numerical Jacobians (dassl and ida with -jacobian=coloredNumerical).\n"
+  "  Every thread works on its own copy of the model data, the color groups are\n"
+  "  distributed dynamically over the threads. The default 1 evaluates the\n"
+  "  Jacobian on the integrator thread. External functions called by the model\n"
+  "  need to be thread-safe if more than one thread is used.",
   /* FLAG_L */
   "  Value specifies a time where the linearization of the model should be performed.",
   /* FLAG_L_DATA_RECOVERY */
@@ -290,6 +368,10 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   /* FLAG_LSS_MIN_SIZE */
   "  Value specifies the minimum system size for using a linear sparse solver.\n"
   "  The value is an Integer with default value 4001.",
+  /* FLAG_LOAD_SNAPSHOT */
+  "  Value specifies a binary snapshot file written by -saveSnapshot.\n"
+  "  The stored state replaces the initialization, so the simulation resumes at the snapshot time without solving the initial system.\n"
+  "  The snapshot must belong to the same model (GUID) and variable layout; changed parameters only give a warning.",
   /* FLAG_LV */
   "  Value (a comma-separated String list) specifies which logging levels to\n"
   "  enable. Multiple options can be enabled at the same time.",
@@ -310,6 +392,19 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * ps\n"
   "  * gif\n"
   "  * ...",
+  /* FLAG_MR_IMPLICIT */
+  "  The multirate solver (-s=multirate) integrates the fast partition with the\n"
+  "  linearly implicit Rosenbrock method of Shampine and Reichelt instead of explicit\n"
+  "  sub-steps. This is meant for fast states that are stiff, whose explicit sub-steps\n"
+  "  would be limited by stability instead of accuracy.",
+  /* FLAG_MR_MAX_FAST */
+  "  Value specifies the maximum share of states in the fast partition of the multirate\n"
+  "  solver (-s=multirate). If more states would have to be integrated with small sub-steps,\n"
+  "  the whole system takes a common step of reduced size instead. Default is 0.3.",
+  /* FLAG_MR_PARTITION_INTERVAL */
+  "  Value specifies the number of accepted macro steps after which the multirate solver\n"
+  "  (-s=multirate) re-evaluates the partition into fast and slow states. In between,\n"
+  "  states are only moved from the slow to the fast partition. Default is 10.",
   /* FLAG_NEWTON_FTOL */
   "  Tolerance respecting residuals for updating solution vector in Newton solver."
   "  Solution is accepted if the (scaled) 2-norm of the residuals is smaller than the tolerance newtonFTol and the (scaled) newton correction (delta_x) is smaller than the tolerance newtonXTol."
@@ -328,6 +423,12 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * mixed",
   /* FLAG_NLS_INFO */
   "  Outputs detailed information about solving process of non-linear systems into csv files.",
+  /* FLAG_NLSS_MAX_DENSITY */
+  "  Value specifies the maximum density for using a nonlinear sparse solver.\n"
+  "  The value is a Double with default value 0.1.",
+  /* FLAG_NLSS_MIN_SIZE */
+  "  Value specifies the minimum system size for using a nonlinear sparse solver.\n"
+  "  The value is an Integer with default value 1001.",
   /* FLAG_NOEMIT */
   "  Do not emit any results to the result file.",
   /* FLAG_NOEQUIDISTANT_GRID */
@@ -371,6 +472,16 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  overrideFileName contains lines of the form: var1=start1",
   /* FLAG_PORT */
   "  Value specifies the port for simulation status (default disabled).",
+  /* FLAG_QSS_GRID_OUTPUT */
+  "  Only for the QSS solver (-s=qss). The results are emitted at the points of\n"
+  "  the output grid, with the states evaluated from their trajectories.\n"
+  "  By default they are emitted after every QSS step.",
+  /* FLAG_QSS_METHOD */
+  "  Value specifies the integration method of the QSS solver (-s=qss):\n\n"
+  "  * qss1 - first order QSS, the default\n"
+  "  * qss2 - second order QSS with linear state trajectories of the quantized states\n"
+  "  * qss3 - third order QSS with parabolic trajectories of the quantized states\n"
+  "  * liqss2 - second order linearly implicit QSS for stiff systems",
   /* FLAG_R */
   "  Value specifies the name of the output result file.\n"
   "  The default file-name is based on the model name and output format.\n"
@@ -378,8 +489,16 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   /* FLAG_RT */
   "  Value specifies the scaling factor for real-time synchronization (0 disables).\n"
   "  A value > 1 means the simulation takes a longer time to simulate.\n",
+  /* FLAG_RT_PREALLOC */
+  "  Value specifies the size of the memory pool in MB which is reserved during the initialization.\n"
+  "  In addition, the event lists and the history of the nonlinear systems are preallocated and reused, so that the steady-state simulation steps do not allocate memory (real-time mode).\n"
+  "  Build the runtime with -DOMC_RT_ALLOC_TRACKING to report every allocation after the initialization together with its stack.\n",
   /* FLAG_S */
   "  Value specifies the solver (integration method).",
+  /* FLAG_SAVE_SNAPSHOT */
+  "  Value specifies the time at which the complete simulation state is written to <model>_snapshot.bin.\n"
+  "  A value less or equal to the start time writes the snapshot right after the initialization.\n"
+  "  The file can be used with -loadSnapshot to skip the initialization in repeated simulations.",
   /* FLAG_SOLVER_STEPS */
   "  dumps the number of integration steps into the result file",
   /* FLAG_UP_HESSIAN */
@@ -401,13 +520,19 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_DAE_SOLVING */           FLAG_TYPE_FLAG,
   /* FLAG_EMBEDDED_SERVER */       FLAG_TYPE_OPTION,
   /* FLAG_EMIT_PROTECTED */        FLAG_TYPE_FLAG,
+  /* FLAG_ENSEMBLE */              FLAG_TYPE_OPTION,
+  /* FLAG_ENSEMBLE_THREADS */      FLAG_TYPE_OPTION,
   /* FLAG_F */                     FLAG_TYPE_OPTION,
   /* FLAG_HELP */                  FLAG_TYPE_OPTION,
+  /* FLAG_IDA_ADJOINT */           FLAG_TYPE_OPTION,
+  /* FLAG_IDA_ADJOINT_PARAMS */    FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXERRORTESTFAIL */  FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXNONLINITERS */    FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXCONVFAILS */      FLAG_TYPE_OPTION,
   /* FLAG_IDA_NONLINCONVCOEF */    FLAG_TYPE_OPTION,
   /* FLAG_IDA_LS */                FLAG_TYPE_OPTION,
+  /* FLAG_IDA_PREC */              FLAG_TYPE_OPTION,
+  /* FLAG_IDA_PREC_REFRESH */      FLAG_TYPE_OPTION,
   /* FLAG_IDAS */                  FLAG_TYPE_FLAG,
   /* FLAG_IGNORE_HIDERESULT */     FLAG_TYPE_FLAG,
   /* FLAG_IIF */                   FLAG_TYPE_OPTION,
@@ -418,12 +543,15 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_INPUT_CSV */             FLAG_TYPE_OPTION,
   /* FLAG_INPUT_FILE */            FLAG_TYPE_OPTION,
   /* FLAG_INPUT_FILE_STATES */     FLAG_TYPE_OPTION,
+  /* FLAG_INPUT_STREAM */          FLAG_TYPE_OPTION,
+  /* FLAG_INPUT_STREAM_WINDOW */   FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_HESSE */           FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_INIT */            FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_JAC */             FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_MAX_ITER */        FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_WARM_START */      FLAG_TYPE_OPTION,
   /* FLAG_JACOBIAN */              FLAG_TYPE_OPTION,
+  /* FLAG_JACOBIAN_THREADS */      FLAG_TYPE_OPTION,
   /* FLAG_L */                     FLAG_TYPE_OPTION,
   /* FLAG_L_DATA_RECOVERY */       FLAG_TYPE_FLAG,
   /* FLAG_LOG_FORMAT */            FLAG_TYPE_OPTION,
@@ -432,17 +560,23 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_LSS */                   FLAG_TYPE_OPTION,
   /* FLAG_LSS_MAX_DENSITY */       FLAG_TYPE_OPTION,
   /* FLAG_LSS_MIN_SIZE */          FLAG_TYPE_OPTION,
+  /* FLAG_LOAD_SNAPSHOT */         FLAG_TYPE_OPTION,
   /* FLAG_LV */                    FLAG_TYPE_OPTION,
   /* FLAG_MAX_BISECTION_ITERATIONS */  FLAG_TYPE_OPTION,
   /* FLAG_MAX_EVENT_ITERATIONS */  FLAG_TYPE_OPTION,
   /* FLAG_MAX_ORDER */             FLAG_TYPE_OPTION,
   /* FLAG_MAX_STEP_SIZE */         FLAG_TYPE_OPTION,
   /* FLAG_MEASURETIMEPLOTFORMAT */ FLAG_TYPE_OPTION,
+  /* FLAG_MR_IMPLICIT */           FLAG_TYPE_FLAG,
+  /* FLAG_MR_MAX_FAST */           FLAG_TYPE_OPTION,
+  /* FLAG_MR_PARTITION_INTERVAL */ FLAG_TYPE_OPTION,
   /* FLAG_NEWTON_FTOL */           FLAG_TYPE_OPTION,
   /* FLAG_NEWTON_XTOL */           FLAG_TYPE_OPTION,
   /* FLAG_NEWTON_STRATEGY */       FLAG_TYPE_OPTION,
   /* FLAG_NLS */                   FLAG_TYPE_OPTION,
   /* FLAG_NLS_INFO */              FLAG_TYPE_FLAG,
+  /* FLAG_NLSS_MAX_DENSITY */      FLAG_TYPE_OPTION,
+  /* FLAG_NLSS_MIN_SIZE */         FLAG_TYPE_OPTION,
   /* FLAG_NOEMIT */                FLAG_TYPE_FLAG,
   /* FLAG_NOEQUIDISTANT_GRID*/     FLAG_TYPE_FLAG,
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/ FLAG_TYPE_OPTION,
@@ -458,9 +592,13 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_OVERRIDE */              FLAG_TYPE_OPTION,
   /* FLAG_OVERRIDE_FILE */         FLAG_TYPE_OPTION,
   /* FLAG_PORT */                  FLAG_TYPE_OPTION,
+  /* FLAG_QSS_GRID_OUTPUT */       FLAG_TYPE_FLAG,
+  /* FLAG_QSS_METHOD */            FLAG_TYPE_OPTION,
   /* FLAG_R */                     FLAG_TYPE_OPTION,
   /* FLAG_RT */                    FLAG_TYPE_OPTION,
+  /* FLAG_RT_PREALLOC */           FLAG_TYPE_OPTION,
   /* FLAG_S */                     FLAG_TYPE_OPTION,
+  /* FLAG_SAVE_SNAPSHOT */         FLAG_TYPE_OPTION,
   /* FLAG_SOLVER_STEPS */          FLAG_TYPE_FLAG,
   /* FLAG_UP_HESSIAN */            FLAG_TYPE_OPTION,
   /* FLAG_W */                     FLAG_TYPE_FLAG
@@ -482,7 +620,8 @@ const char *SOLVER_METHOD_NAME[S_MAX] = {
   "symEulerSsc",
   "heun",
   "ida",
-  "qss"
+  "qss",
+  "multirate"
 };
 
 const char *SOLVER_METHOD_DESC[S_MAX] = {
@@ -491,7 +630,7 @@ const char *SOLVER_METHOD_DESC[S_MAX] = {
   "rungekutta - Runge-Kutta (fixed step, order 4)",
   "dassl - BDF solver with colored numerical jacobian, with interval root finding - default",
   "optimization - Special solver for dynamic optimization",
-  "radau5 - Radau IIA with 3 points, \"Implicit Runge-Kutta\", order 5 [sundial/kinsol needed]",
+  "radau5 - Radau IIA with 3 points, \"Implicit Runge-Kutta\", order 5 with step size control and dense output",
   "radau3 - Radau IIA with 2 points, \"Implicit Runge-Kutta\", order 3 [sundial/kinsol needed]",
   "impeuler - Implicit Euler (actually Radau IIA, order 1) [sundial/kinsol needed]",
   "trapezoid - Trapezoidal rule (actually Lobatto IIA with 2 points) [sundial/kinsol needed]",
@@ -501,7 +640,8 @@ const char *SOLVER_METHOD_DESC[S_MAX] = {
   "symEulerSsc - symbolic implicit euler with step-size control, [compiler flag +symEuler needed]",
   "heun - Heun's method (Runge-Kutta fixed step, order 2)",
   "ida - Sundials ida solver",
-  "qss - A QSS solver [experimental]"
+  "qss - A QSS solver [experimental]",
+  "multirate - Multirate Bogacki-Shampine 3(2) with automatic fast/slow partitioning and step size control"
 };
 
 const char *INIT_METHOD_NAME[IIM_MAX] = {
@@ -674,3 +814,47 @@ const char *IDA_LS_METHOD_DESC[IDA_LS_MAX+1] = {
 
   "IDA_LS_MAX"
 };
+
+const char *IDA_PREC_METHOD[IDA_PREC_MAX+1] = {
+  "unknown",
+
+  "none",
+  "bjac",
+  "ilu0",
+  "ilut",
+
+  "IDA_PREC_MAX"
+};
+
+const char *IDA_PREC_METHOD_DESC[IDA_PREC_MAX+1] = {
+  "unknown",
+
+  "no preconditioner",
+  "block jacobi on the strong components of the jacobian",
+  "incomplete LU decomposition without fill-in",
+  "incomplete LU decomposition with threshold dropping",
+
+  "IDA_PREC_MAX"
+};
+
+const char *QSS_METHOD_NAME[QSS_MAX+1] = {
+  "unknown",
+
+  "qss1",
+  "qss2",
+  "qss3",
+  "liqss2",
+
+  "QSS_MAX"
+};
+
+const char *QSS_METHOD_DESC[QSS_MAX+1] = {
+  "unknown",
+
+  "first order QSS",
+  "second order QSS",
+  "third order QSS",
+  "second order linearly implicit QSS",
+
+  "QSS_MAX"
+};
@@ -49,13 +49,19 @@ enum _FLAG
   FLAG_DAE_MODE,
   FLAG_EMBEDDED_SERVER,
   FLAG_EMIT_PROTECTED,
+  FLAG_ENSEMBLE,
+  FLAG_ENSEMBLE_THREADS,
   FLAG_F,
   FLAG_HELP,
+  FLAG_IDA_ADJOINT,
+  FLAG_IDA_ADJOINT_PARAMS,
   FLAG_IDA_MAXERRORTESTFAIL,
   FLAG_IDA_MAXNONLINITERS,
   FLAG_IDA_MAXCONVFAILS,
   FLAG_IDA_NONLINCONVCOEF,
   FLAG_IDA_LS,
+  FLAG_IDA_PREC,
+  FLAG_IDA_PREC_REFRESH,
   FLAG_IDAS,
   FLAG_IGNORE_HIDERESULT,
   FLAG_IIF,
@@ -66,12 +72,15 @@ enum _FLAG
   FLAG_INPUT_CSV,
   FLAG_INPUT_FILE,
   FLAG_INPUT_FILE_STATES,
+  FLAG_INPUT_STREAM,
+  FLAG_INPUT_STREAM_WINDOW,
   FLAG_IPOPT_HESSE,
   FLAG_IPOPT_INIT,
   FLAG_IPOPT_JAC,
   FLAG_IPOPT_MAX_ITER,
   FLAG_IPOPT_WARM_START,
   FLAG_JACOBIAN,
+  FLAG_JACOBIAN_THREADS,
   FLAG_L,
   FLAG_L_DATA_RECOVERY,
   FLAG_LOG_FORMAT,
@@ -80,17 +89,23 @@ enum _FLAG
   FLAG_LSS,
   FLAG_LSS_MAX_DENSITY,
   FLAG_LSS_MIN_SIZE,
+  FLAG_LOAD_SNAPSHOT,
   FLAG_LV,
   FLAG_MAX_BISECTION_ITERATIONS,
   FLAG_MAX_EVENT_ITERATIONS,
   FLAG_MAX_ORDER,
   FLAG_MAX_STEP_SIZE,
   FLAG_MEASURETIMEPLOTFORMAT,
+  FLAG_MR_IMPLICIT,
+  FLAG_MR_MAX_FAST,
+  FLAG_MR_PARTITION_INTERVAL,
   FLAG_NEWTON_FTOL,
   FLAG_NEWTON_XTOL,
   FLAG_NEWTON_STRATEGY,
   FLAG_NLS,
   FLAG_NLS_INFO,
+  FLAG_NLSS_MAX_DENSITY,
+  FLAG_NLSS_MIN_SIZE,
   FLAG_NOEMIT,
   FLAG_NOEQUIDISTANT_GRID,
   FLAG_NOEQUIDISTANT_OUT_FREQ,
@@ -106,9 +121,13 @@ enum _FLAG
   FLAG_OVERRIDE,
   FLAG_OVERRIDE_FILE,
   FLAG_PORT,
+  FLAG_QSS_GRID_OUTPUT,
+  FLAG_QSS_METHOD,
   FLAG_R,
   FLAG_RT,
+  FLAG_RT_PREALLOC,
   FLAG_S,
+  FLAG_SAVE_SNAPSHOT,
   FLAG_SOLVER_STEPS,
   FLAG_UP_HESSIAN,
   FLAG_W,
@@ -150,6 +169,7 @@ enum SOLVER_METHOD
   S_HEUN,          /* 13 */
   S_IDA,           /* 14 */
   S_QSS,
+  S_MULTIRATE,
 
   S_MAX
 };
@@ -270,6 +290,36 @@ enum IDA_LS
 extern const char *IDA_LS_METHOD[IDA_LS_MAX+1];
 extern const char *IDA_LS_METHOD_DESC[IDA_LS_MAX+1];
 
+enum IDA_PREC
+{
+  IDA_PREC_UNKNOWN = 0,
+
+  IDA_PREC_NONE,
+  IDA_PREC_BJAC,
+  IDA_PREC_ILU0,
+  IDA_PREC_ILUT,
+
+  IDA_PREC_MAX
+};
+
+extern const char *IDA_PREC_METHOD[IDA_PREC_MAX+1];
+extern const char *IDA_PREC_METHOD_DESC[IDA_PREC_MAX+1];
+
+enum QSS_METHOD
+{
+  QSS_UNKNOWN = 0,
+
+  QSS_QSS1,
+  QSS_QSS2,
+  QSS_QSS3,
+  QSS_LIQSS2,
+
+  QSS_MAX
+};
+
+extern const char *QSS_METHOD_NAME[QSS_MAX+1];
+extern const char *QSS_METHOD_DESC[QSS_MAX+1];
+
 
 
 
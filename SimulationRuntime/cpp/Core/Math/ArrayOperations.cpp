@@ -6,6 +6,7 @@
 #include <Core/Modelica.h>
 #include <Core/Math/ArrayOperations.h>
 #include <Core/Math/ArraySlice.h>
+#include <Core/Math/IBlas.h>
 #include <sstream>
 #include <stdio.h>
 
@@ -266,49 +267,153 @@ void multiply_array(const BaseArray<T>& inputArray, const T &b, BaseArray<T>& ou
   }
 };
 
+/**
+ * helper for multiply_array and usub_array
+ * true if getData() of the array holds its elements in column-major order
+ * and, if write is set, can be written; reference arrays hold row-major
+ * references and slices only support element access for writing
+ */
+template <typename T>
+static bool hasColumnMajorData(const BaseArray<T>& a, bool write)
+{
+  return !a.isRefArray() &&
+    (!write || dynamic_cast<const ArraySliceConst<T>*>(&a) == NULL);
+}
+
+/**
+ * helper for get_column_major and set_column_major
+ * advances idx to the next element in column-major order
+ */
+template <typename T>
+static void next_column_major(const BaseArray<T>& a, vector<size_t>& idx)
+{
+  for (size_t d = 0; d < idx.size() && ++idx[d] > (size_t)a.getDim(d + 1); d++)
+    idx[d] = 1;
+}
+
+/**
+ * helper for multiply_array and usub_array
+ * copies the elements of an array of any kind in column-major order to data
+ */
+template <typename T>
+static void get_column_major(const BaseArray<T>& a, T* data)
+{
+  size_t nelems = a.getNumElems();
+  vector<size_t> idx(a.getNumDims(), 1);
+  for (size_t n = 0; n < nelems; n++, next_column_major(a, idx))
+    data[n] = a(idx);
+}
+
+/**
+ * helper for multiply_array and usub_array
+ * copies column-major data element-wise into an array of any kind
+ */
+template <typename T>
+static void set_column_major(const T* data, BaseArray<T>& a)
+{
+  size_t nelems = a.getNumElems();
+  vector<size_t> idx(a.getNumDims(), 1);
+  for (size_t n = 0; n < nelems; n++, next_column_major(a, idx))
+    a(idx) = data[n];
+}
+
+/**
+ * helper for multiply_array
+ * column-major product C(m,n) = A(m,k) * B(k,n) of contiguous data
+ */
+template <typename T>
+static void multiply_array_data(size_t m, size_t n, size_t k,
+                                const T* A, const T* B, T* C)
+{
+  for (size_t j = 0; j < n; j++) {
+    T* c = C + j*m;
+    std::fill(c, c + m, T());
+    for (size_t l = 0; l < k; l++) {
+      const T* a = A + l*m;
+      T b = B[l + j*k];
+      for (size_t i = 0; i < m; i++)
+        c[i] += a[i] * b;
+    }
+  }
+}
+
+/**
+ * helper for multiply_array
+ * uses BLAS for all but the smallest double products
+ */
+static void multiply_array_data(size_t m, size_t n, size_t k,
+                                const double* A, const double* B, double* C)
+{
+  if (m*n*k <= 64 || k == 0) {
+    multiply_array_data<double>(m, n, k, A, B, C);
+    return;
+  }
+  long int lm = m, ln = n, lk = k, inc = 1;
+  double alpha = 1.0, beta = 0.0;
+  char N = 'N', T = 'T';
+  if (n == 1)
+    dgemv_(&N, &lm, &lk, &alpha, const_cast<double*>(A), &lm,
+           const_cast<double*>(B), &inc, &beta, C, &inc);
+  else if (m == 1)
+    dgemv_(&T, &lk, &ln, &alpha, const_cast<double*>(B), &lk,
+           const_cast<double*>(A), &inc, &beta, C, &inc);
+  else
+    dgemm_(&N, &N, &lm, &ln, &lk, &alpha, const_cast<double*>(A), &lm,
+           const_cast<double*>(B), &lk, &beta, C, &lm);
+}
+
 template <typename T>
 void multiply_array(const BaseArray<T> &leftArray, const BaseArray<T> &rightArray, BaseArray<T> &resultArray)
 {
   size_t leftNumDims = leftArray.getNumDims();
   size_t rightNumDims = rightArray.getNumDims();
+  if (leftNumDims < 1 || leftNumDims > 2 || rightNumDims < 1 || rightNumDims > 2 ||
+      leftNumDims + rightNumDims < 3)
+    throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
+                                  "Unsupported dimensions in multiply_array");
   size_t matchDim = rightArray.getDim(1);
-  resultArray.setDims(leftArray.getDims());
   if (leftArray.getDim(leftNumDims) != matchDim)
     throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
                                   "Wrong sizes in multiply_array");
-  if (leftNumDims == 1 && rightNumDims == 2) {
-    size_t rightDim = rightArray.getDim(2);
-    for (size_t j = 1; j <= rightDim; j++) {
-      T val = T();
-      for (size_t k = 1; k <= matchDim; k++)
-        val += leftArray(k) * rightArray(k, j);
-      resultArray(j) = val;
-    }
+  // a vector on the left is a row, a vector on the right a column
+  size_t leftDim = leftNumDims == 2 ? leftArray.getDim(1) : 1;
+  size_t rightDim = rightNumDims == 2 ? rightArray.getDim(2) : 1;
+  vector<size_t> dims;
+  if (leftNumDims == 2)
+    dims.push_back(leftDim);
+  if (rightNumDims == 2)
+    dims.push_back(rightDim);
+  // reference arrays and slices go through column-major copies
+  DynArrayDim1<T> leftCopy, rightCopy, resultCopy;
+  const T* leftData;
+  const T* rightData;
+  if (hasColumnMajorData(leftArray, false))
+    leftData = leftArray.getData();
+  else {
+    leftCopy.setDims(leftArray.getNumElems());
+    get_column_major(leftArray, leftCopy.getData());
+    leftData = leftCopy.getData();
   }
-  else if (leftNumDims == 2 && rightNumDims == 1) {
-    size_t leftDim = leftArray.getDim(1);
-    for (size_t i = 1; i <= leftDim; i++) {
-      T val = T();
-      for (size_t k = 1; k <= matchDim; k++)
-        val += leftArray(i, k) * rightArray(k);
-      resultArray(i) = val;
-    }
+  if (hasColumnMajorData(rightArray, false))
+    rightData = rightArray.getData();
+  else {
+    rightCopy.setDims(rightArray.getNumElems());
+    get_column_major(rightArray, rightCopy.getData());
+    rightData = rightCopy.getData();
   }
-  else if (leftNumDims == 2 && rightNumDims == 2) {
-    size_t leftDim = leftArray.getDim(1);
-    size_t rightDim = rightArray.getDim(2);
-    for (size_t i = 1; i <= leftDim; i++) {
-      for (size_t j = 1; j <= rightDim; j++) {
-        T val = T();
-        for (size_t k = 1; k <= matchDim; k++)
-          val += leftArray(i, k) * rightArray(k, j);
-        resultArray(i, j) = val;
-      }
-    }
+  if (hasColumnMajorData(resultArray, true)) {
+    resultArray.setDims(dims);
+    multiply_array_data(leftDim, rightDim, matchDim, leftData, rightData,
+                        resultArray.getData());
+  }
+  else {
+    if (resultArray.getNumElems() != leftDim * rightDim)
+      resultArray.setDims(dims);
+    resultCopy.setDims(leftDim * rightDim);
+    multiply_array_data(leftDim, rightDim, matchDim, leftData, rightData,
+                        resultCopy.getData());
+    set_column_major(resultCopy.getData(), resultArray);
   }
-  else
-    throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
-                                  "Unsupported dimensions in multiply_array");
 }
 
 template <typename T>
@@ -447,11 +552,20 @@ void add_array_scalar(const BaseArray<T>& inputArray, T b, BaseArray<T>& outputA
 template <typename T>
 void usub_array(const BaseArray<T>& a, BaseArray<T>& b)
 {
-  b.setDims(a.getDims());
-  size_t numEle =  a.getNumElems();
-  for (size_t i = 1; i <= numEle; i++)
-  {
-    b(i) = -a(i);
+  size_t numEle = a.getNumElems();
+  if (hasColumnMajorData(a, false) && hasColumnMajorData(b, true)) {
+    b.setDims(a.getDims());
+    const T* data = a.getData();
+    std::transform(data, data + numEle, b.getData(), std::negate<T>());
+  }
+  else {
+    // reference arrays and slices go through a column-major copy
+    DynArrayDim1<T> copy(numEle);
+    get_column_major(a, copy.getData());
+    std::transform(copy.getData(), copy.getData() + numEle, copy.getData(), std::negate<T>());
+    if (b.getNumElems() != numEle)
+      b.setDims(a.getDims());
+    set_column_major(copy.getData(), b);
   }
 }
 
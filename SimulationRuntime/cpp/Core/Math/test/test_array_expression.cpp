@@ -0,0 +1,116 @@
+/** @addtogroup math
+ *
+ *  @{
+ */
+
+/* Evaluates elementwise expressions with mixed array kinds: static and dynamic
+ * arrays hold their elements in column-major order, reference arrays in
+ * row-major order.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+
+#include <cstdio>
+
+/* element access that all array kinds implement */
+static std::vector<size_t> idx2(size_t i, size_t j)
+{
+    std::vector<size_t> idx(2);
+    idx[0] = i;
+    idx[1] = j;
+    return idx;
+}
+
+/* 2x2 matrix with a(i,j) = 10*i + j */
+static void fill(BaseArray<double>& a)
+{
+    for (size_t i = 1; i <= 2; i++)
+        for (size_t j = 1; j <= 2; j++)
+            a(idx2(i, j)) = 10. * i + j;
+}
+
+static int check(const BaseArray<double>& a, double scale, double offset)
+{
+    for (size_t i = 1; i <= 2; i++)
+        for (size_t j = 1; j <= 2; j++)
+            if (a(idx2(i, j)) != scale * (10. * i + j) + offset)
+            {
+                printf("element (%zu,%zu) is %g, expected %g\n", i, j, a(idx2(i, j)), scale * (10. * i + j) + offset);
+                return 1;
+            }
+    return 0;
+}
+
+/* reference array operand, static and dynamic results */
+static int test_refOperand()
+{
+    double simvars[4];
+    RefArrayDim2<double, 2, 2> r(simvars);
+    StatArrayDim2<double, 2, 2> zeros;
+    StatArrayDim2<double, 2, 2> s;
+    DynArrayDim2<double> d(2, 2);
+
+    fill(r);
+    for (size_t i = 1; i <= 2; i++)
+        for (size_t j = 1; j <= 2; j++)
+            zeros(i, j) = 0;
+    assign_array_expr(s, add_array_expr(zeros, r));
+    if (check(s, 1, 0)) return 1;
+    assign_array_expr(d, subtract_array_expr(multiply_array_expr(2., r), zeros));
+    if (check(d, 2, 0)) return 2;
+    assign_array_expr(d, usub_array_expr(r));
+    if (check(d, -1, 0)) return 3;
+    return 0;
+}
+
+/* reference array result, static and reference operands */
+static int test_refResult()
+{
+    double simvars[4], simvars2[4];
+    RefArrayDim2<double, 2, 2> r(simvars);
+    RefArrayDim2<double, 2, 2> r2(simvars2);
+    StatArrayDim2<double, 2, 2> s;
+
+    fill(s);
+    assign_array_expr(r, add_array_expr(s, 1.));
+    if (check(r, 1, 1)) return 1;
+    fill(r2);
+    assign_array_expr(r, add_array_expr(s, r2));
+    if (check(r, 2, 0)) return 2;
+    return 0;
+}
+
+/* slices of a static array as operand and result */
+static int test_slice()
+{
+    StatArrayDim2<double, 2, 3> a;
+    DynArrayDim2<double> d(2, 2);
+    vector<Slice> sl;
+
+    for (size_t i = 1; i <= 2; i++)
+        for (size_t j = 1; j <= 3; j++)
+            a(i, j) = j == 3 ? 0 : 10. * i + j;
+    sl.push_back(Slice());
+    sl.push_back(Slice(1, 1, 2));
+    ArraySlice<double> first(a, sl);
+    assign_array_expr(d, multiply_array_expr(first, 3.));
+    if (check(d, 3, 0)) return 1;
+    assign_array_expr(first, add_array_expr(d, 1.));
+    if (check(a, 3, 1)) return 2;
+    return 0;
+}
+
+/* main */
+int main()
+{
+    /* return code */
+    int rc;
+
+    if ((rc = test_refOperand()) != 0) return 1000 + rc;
+    if ((rc = test_refResult()) != 0) return 2000 + rc;
+    if ((rc = test_slice()) != 0) return 3000 + rc;
+
+    return 0;
+}
+/** @} */ // end of math
@@ -13,7 +13,7 @@
 SimManager::SimManager(shared_ptr<IMixedSystem> system, Configuration* config)
   : _mixed_system      (system)
   , _config            (config)
-  , _tStops            ()
+  , _timeEventQueue    ()
   , _dimtimeevent      (0)
   , _dimZeroFunc       (0)
   , _timeEventCounter  (NULL)
@@ -442,108 +442,38 @@ void SimManager::writeProperties()
 }
 
 /**
-    Computes all stops for the time events before starting the simulation
-
-    @param A vector of all time event stop times.
+    Sets up the time event queue before starting the simulation. The queue holds the next
+    occurrence of each time event; occurrences are generated one by one while the simulation
+    proceeds, see countTimeEvents. Time events at the start time are counted immediately.
 */
-void SimManager::computeEndTimes(std::vector<std::pair<double, int> > &tStopsSub)
+void SimManager::computeEndTimes()
 {
-	int counterTimes = 0;
-    int counterEvents = 0;
     time_event_type timeEventPairs;// <startTime, intervalLength> of the time events
-    _writeFinalState = true;
 
-    //calculate time event stops till stopTime
-    if (tStopsSub.size() == 0)
-    {
-        _timeevent_system->getTimeEvent(timeEventPairs);
-        std::vector<std::pair<double, double> >::iterator iter;
-        iter = timeEventPairs.begin();
-        for (; iter != timeEventPairs.end(); ++iter)
-        {
-            if (iter->second != 0)
-            {
-                counterTimes = 0;
-                if (iter->first <= UROUND)
-                {
-                    _timeEventCounter[counterEvents]++;
-                    counterTimes++;
-                    _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
-                }
-                //compute time event times for the whole simulation including the end time
-                while (iter->first + counterTimes * (iter->second) <= _tEnd+UROUND)
-                {
-                    tStopsSub.push_back(std::make_pair(iter->first + counterTimes * (iter->second), counterEvents));
-                    counterTimes++;
-                }
-            }
-            else
-            {
-                if (iter->first <= UROUND)
-                {
-                    _timeEventCounter[counterEvents]++;
-                    counterTimes++;
-                    _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
-                }
-                else
-                {
-                    if (iter->first <= _tEnd)
-                        tStopsSub.push_back(std::make_pair(iter->first, counterEvents));
-                }
-            }
-            counterEvents++;
-        }  // end for iter tStops
-        sort(tStopsSub.begin(), tStopsSub.end());
-        if (tStopsSub.size() == 0)
-        {
-            tStopsSub.push_back(std::make_pair(_tEnd, 0));
-            _writeFinalState = false;
-        }
-    }  // end if endlessSim
-    else
-    {
-        tStopsSub.erase(tStopsSub.begin(), tStopsSub.end());
-        std::vector<std::pair<double, double> >::iterator iter;
-        iter = timeEventPairs.begin();
-        for (; iter != timeEventPairs.end(); ++iter)
-        {
-            if (iter->second != 0)
-            {
-                counterTimes = 1;
-                if (abs(iter->first) <= UROUND)
-                {
-                    counterTimes++;
-                    _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
-                }
-                while (_tStart + iter->first + counterTimes * (iter->second) < _tEnd)
-                {
-                    tStopsSub.push_back(std::make_pair(_tStart + iter->first + counterTimes * (iter->second), counterEvents));
-                    counterTimes++;
-                }
-            }
-            else
-            {
-                if (iter->first < _tStart)
-                {
-                    continue;
-                }
-                else
-                {
-                    if (iter->first <= _tEnd)
-                        tStopsSub.push_back(std::make_pair(iter->first, counterEvents));
-                    if (abs(iter->first) <= UROUND)
-                        _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
-                }
-            }
-            counterEvents++;
-        }  // end for iter tStops
-        sort(tStopsSub.begin(), tStopsSub.end());
-        if (tStopsSub.size() == 0)
-        {
-            tStopsSub.push_back(std::make_pair(_tEnd, 0));
-            _writeFinalState = false;
-        }
-    }
+    _timeevent_system->getTimeEvent(timeEventPairs);
+    if (_timeEventQueue.initialize(timeEventPairs, _tEnd, _timeEventCounter) > 0)
+        _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
+
+    double time;
+    _writeFinalState = getNextTimeEvent(time);
+}
+
+/**
+    Gets the time of the next time event up to the end time
+
+    @return false if there are no more time events until the end time
+*/
+bool SimManager::getNextTimeEvent(double& time)
+{
+    return _timeEventQueue.getNextTimeEvent(time);
+}
+
+/**
+    Increments the counters of all time events occurring at the given time
+*/
+void SimManager::countTimeEvents(double time)
+{
+    _timeEventQueue.countTimeEvents(time, _timeEventCounter);
 }
 
 void SimManager::runSingleProcess()
@@ -551,8 +481,6 @@ void SimManager::runSingleProcess()
     double startTime, endTime, *zeroVal_0, *zeroVal_new;
     int dimZeroF;
 
-    std::vector<std::pair<double, int> > tStopsSub;
-
     _H = _tEnd;
     //nw _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECORDCALL);
     _solver->setStartTime(_tStart);
@@ -568,8 +496,7 @@ void SimManager::runSingleProcess()
     LOGGER_WRITE("SimManager: Run single process",LC_SOLV,LL_DEBUG);
 
     memset(_timeEventCounter, 0, _dimtimeevent * sizeof(int));
-    computeEndTimes(tStopsSub);
-    _tStops.push_back(tStopsSub);
+    computeEndTimes();
     dimZeroF = _event_system->getDimZeroFunc();
     zeroVal_new = new double[dimZeroF];
     _timeevent_system->setTime(_tStart);
@@ -597,21 +524,18 @@ void SimManager::runSingleProcess()
     _solverTask = ISolver::SOLVERCALL(_solverTask ^ ISolver::RECORDCALL);
 
 
-    std::vector<std::pair<double, int> >::iterator iter;
-    iter = _tStops[0].begin();
     /* time measurement temporary disabled
      // Startzeit messen
      _tClockStart = Time::Time().getSeconds();
      */
     startTime = _tStart;
+    endTime = _tStart;
     bool user_stop = false;
 
     while (_continueSimulation)
     {
-        for (; iter != _tStops[0].end(); ++iter)
+        while (getNextTimeEvent(endTime))
         {
-            endTime = iter->first;
-
             // Set start time, end time, initial step size
             _solver->setStartTime(startTime);
             _solver->setEndTime(endTime);
@@ -624,17 +548,10 @@ void SimManager::runSingleProcess()
                 _solverTask = ISolver::SOLVERCALL(_solverTask | ISolver::RECALL);
             }
             startTime = endTime;
+            // Count all time events at the current time and schedule their next occurrences
+            countTimeEvents(endTime);
             if (_dimtimeevent)
             {
-              // Find all time events at the current time
-              while((iter !=_tStops[0].end()) && (abs(iter->first - endTime) <1e4*UROUND))
-              {
-                _timeEventCounter[iter->second]++;
-                iter++;
-              }
-              // Set the iterator back to the current end time
-              iter--;
-
                     // Then handle time events
                     _timeevent_system->handleTimeEvent(_timeEventCounter);
 
@@ -651,7 +568,7 @@ void SimManager::runSingleProcess()
             user_stop = (_solver->getSolverStatus() & ISolver::USER_STOP);
             if (user_stop)
               break;
-        }  // end for time events
+        }  // end while time events
 
         if (abs(_tEnd - endTime) > _config->getSimControllerSettings()->dTendTol && !user_stop)
         {
@@ -691,8 +608,10 @@ void SimManager::runSingleProcess()
             _tStart = _tEnd;
             _tEnd += _H;
 
-            computeEndTimes(tStopsSub);
-            _tStops.push_back(tStopsSub);
+            // The time event queue continues with the next occurrences
+            double nextTime;
+            _writeFinalState = getNextTimeEvent(nextTime);
+            startTime = endTime = _tStart;
             if (_dimtimeevent)
             {
                 if (zeroVal_new)
@@ -710,8 +629,6 @@ void SimManager::runSingleProcess()
 					_event_system->saveAll();
                 }
             }
-
-            iter = _tStops[0].begin();
         }
 
     }  // end while continue
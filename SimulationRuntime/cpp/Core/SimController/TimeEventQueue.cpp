@@ -0,0 +1,176 @@
+/** @addtogroup coreSimcontroller
+ *
+ *  @{
+ */
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/SimController/TimeEventQueue.h>
+
+TimeEventQueue::TimeEventQueue()
+  : _timeEventPairs ()
+  , _timeEventQueue ()
+  , _timeEventScale (0)
+  , _tEnd           (0)
+{
+}
+
+TimeEventQueue::~TimeEventQueue()
+{
+}
+
+bool TimeEventQueue::TimeEventOccurrence::operator>(const TimeEventOccurrence& other) const
+{
+    if (tick != other.tick)
+        return tick > other.tick;
+    if (time != other.time)
+        return time > other.time;
+    return index > other.index;
+}
+
+/**
+    Checks if x is an integer up to the rounding errors of a scaled decimal number
+*/
+static bool isTimeEventTick(double x)
+{
+    return abs(x - floor(x + 0.5)) <= 64 * UROUND * max(1.0, abs(x));
+}
+
+/**
+    Computes the smallest power of ten, such that all start times and intervals of the time events
+    are integer multiples of its inverse. Coinciding occurrences are then found by comparing integer ticks.
+
+    @return The number of ticks per second, 0 if there is no such resolution.
+*/
+static double computeTimeEventScale(const time_event_type& timeEventPairs, double tEnd)
+{
+    double scale = 1.0;
+    for (int p = 0; p <= 12; p++, scale *= 10.0)
+    {
+        // ticks must stay exact in double arithmetic
+        bool common = abs(tEnd) * scale < 1e12;
+        time_event_type::const_iterator iter = timeEventPairs.begin();
+        for (; common && iter != timeEventPairs.end(); ++iter)
+            common = isTimeEventTick(iter->first * scale) && isTimeEventTick(iter->second * scale);
+        if (common)
+            return scale;
+    }
+    return 0.0;
+}
+
+/**
+    Inserts an occurrence of a time event into the queue
+
+    @param index Index of the time event
+    @param count Number of the occurrence
+*/
+void TimeEventQueue::scheduleTimeEvent(int index, long long count)
+{
+    TimeEventOccurrence occurrence;
+    const std::pair<double, double>& timeEvent = _timeEventPairs[index];
+
+    occurrence.index = index;
+    occurrence.count = count;
+    if (_timeEventScale > 0)
+    {
+        occurrence.tick = (long long)floor(timeEvent.first * _timeEventScale + 0.5)
+                        + count * (long long)floor(timeEvent.second * _timeEventScale + 0.5);
+        occurrence.time = occurrence.tick / _timeEventScale;
+    }
+    else
+    {
+        occurrence.tick = 0;
+        occurrence.time = timeEvent.first + count * timeEvent.second;
+    }
+    _timeEventQueue.push(occurrence);
+}
+
+/**
+    Sets up the queue before starting the simulation. Time events at the start time are counted immediately.
+
+    @param timeEventPairs <startTime, intervalLength> of the time events
+    @param tEnd End time of the simulation
+    @param timeEventCounter Counters of the time events
+    @return Number of time events at the start time
+*/
+int TimeEventQueue::initialize(const time_event_type& timeEventPairs, double tEnd, int* timeEventCounter)
+{
+    int startEvents = 0;
+
+    _timeEventQueue = time_event_queue_type();
+    _timeEventPairs = timeEventPairs;
+    _tEnd = tEnd;
+    _timeEventScale = computeTimeEventScale(_timeEventPairs, _tEnd);
+
+    for (int i = 0; i < (int)_timeEventPairs.size(); i++)
+    {
+        if (_timeEventPairs[i].first <= UROUND)
+        {
+            timeEventCounter[i]++;
+            startEvents++;
+            if (_timeEventPairs[i].second != 0)
+                scheduleTimeEvent(i, 1);
+        }
+        else
+            scheduleTimeEvent(i, 0);
+    }
+    return startEvents;
+}
+
+/**
+    Gets the time of the next time event up to the end time
+
+    @return false if there are no more time events until the end time
+*/
+bool TimeEventQueue::getNextTimeEvent(double& time) const
+{
+    if (_timeEventQueue.empty())
+        return false;
+
+    const TimeEventOccurrence& next = _timeEventQueue.top();
+    // sample events are also handled at the end time if they are within the rounding error
+    if (next.time > _tEnd + (_timeEventPairs[next.index].second != 0 ? UROUND : 0.0))
+        return false;
+
+    time = next.time;
+    return true;
+}
+
+/**
+    Increments the counters of all time events occurring at the given time
+    and reinserts the next occurrences of the cyclic ones.
+
+    @return Number of time events occurring at the given time
+*/
+int TimeEventQueue::countTimeEvents(double time, int* timeEventCounter)
+{
+    int events = 0;
+
+    if (_timeEventQueue.empty())
+        return 0;
+
+    const long long tick = _timeEventQueue.top().tick;
+    while (!_timeEventQueue.empty())
+    {
+        TimeEventOccurrence occurrence = _timeEventQueue.top();
+        if (_timeEventScale > 0 ? occurrence.tick != tick : abs(occurrence.time - time) >= 1e4*UROUND)
+            break;
+
+        _timeEventQueue.pop();
+        timeEventCounter[occurrence.index]++;
+        events++;
+        if (_timeEventPairs[occurrence.index].second != 0)
+            scheduleTimeEvent(occurrence.index, occurrence.count + 1);
+    }
+    return events;
+}
+
+double TimeEventQueue::getTimeEventScale() const
+{
+    return _timeEventScale;
+}
+
+size_t TimeEventQueue::getPendingTimeEvents() const
+{
+    return _timeEventQueue.size();
+}
+/** @} */ // end of coreSimcontroller
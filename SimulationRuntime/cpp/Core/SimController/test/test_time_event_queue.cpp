@@ -0,0 +1,210 @@
+/** @addtogroup coreSimcontroller
+ *
+ *  @{
+ */
+
+/* Compares the time events generated by the TimeEventQueue with the stops that
+ * the SimManager computed in advance for the whole simulation before.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/SimController/TimeEventQueue.h>
+
+#include <cstdio>
+
+/* the former SimManager::computeEndTimes: all occurrences up to the end time,
+ * with a stop at the end time counting time event 0 if there was no other one */
+static std::vector<std::pair<double, int> > computeEagerStops(const time_event_type& timeEventPairs, double tEnd, int* timeEventCounter, bool* writeFinalState)
+{
+    std::vector<std::pair<double, int> > tStops;
+
+    for (int i = 0; i < (int)timeEventPairs.size(); i++)
+    {
+        const std::pair<double, double>& timeEvent = timeEventPairs[i];
+        int counterTimes = 0;
+        if (timeEvent.second != 0)
+        {
+            if (timeEvent.first <= UROUND)
+            {
+                timeEventCounter[i]++;
+                counterTimes++;
+            }
+            while (timeEvent.first + counterTimes * timeEvent.second <= tEnd + UROUND)
+            {
+                tStops.push_back(std::make_pair(timeEvent.first + counterTimes * timeEvent.second, i));
+                counterTimes++;
+            }
+        }
+        else
+        {
+            if (timeEvent.first <= UROUND)
+                timeEventCounter[i]++;
+            else if (timeEvent.first <= tEnd)
+                tStops.push_back(std::make_pair(timeEvent.first, i));
+        }
+    }
+    sort(tStops.begin(), tStops.end());
+    *writeFinalState = true;
+    if (tStops.size() == 0)
+    {
+        tStops.push_back(std::make_pair(tEnd, 0));
+        *writeFinalState = false;
+    }
+    return tStops;
+}
+
+/* simulates the time event handling of both versions up to tEnd and compares times and counters after each stop */
+static int compareTimeEvents(const char* name, const time_event_type& timeEventPairs, double tEnd, long* steps)
+{
+    const int n = timeEventPairs.size();
+    std::vector<int> eagerCounter(n, 0), counter(n, 0);
+    TimeEventQueue queue;
+    double time;
+    bool writeFinalState;
+
+    std::vector<std::pair<double, int> > tStops = computeEagerStops(timeEventPairs, tEnd, &eagerCounter[0], &writeFinalState);
+    queue.initialize(timeEventPairs, tEnd, &counter[0]);
+    if (counter != eagerCounter)
+        return 1;
+    if (queue.getNextTimeEvent(time) != writeFinalState)
+        return 7;
+    // without time events until the end time the final stop is no time event, it must not count time event 0
+    if (!writeFinalState)
+        tStops.clear();
+
+    *steps = 0;
+    std::vector<std::pair<double, int> >::iterator iter = tStops.begin();
+
+    while (iter != tStops.end())
+    {
+        double endTime = iter->first;
+        while (iter != tStops.end() && abs(iter->first - endTime) < 1e4*UROUND)
+        {
+            eagerCounter[iter->second]++;
+            iter++;
+        }
+
+        if (!queue.getNextTimeEvent(time))
+            return 2;
+        if (abs(time - endTime) > 1e4*UROUND*max(1.0, abs(endTime)))
+        {
+            printf("%s: time event at %.17g instead of %.17g\n", name, time, endTime);
+            return 3;
+        }
+        queue.countTimeEvents(time, &counter[0]);
+        if (counter != eagerCounter)
+        {
+            printf("%s: different counters at %.17g\n", name, time);
+            return 4;
+        }
+        // only the next occurrence of each time event is stored
+        if (queue.getPendingTimeEvents() > (size_t)n)
+            return 5;
+        (*steps)++;
+    }
+
+    if (queue.getNextTimeEvent(time))
+    {
+        printf("%s: additional time event at %.17g\n", name, time);
+        return 6;
+    }
+    printf("%s: %ld stops, %g ticks per second\n", name, *steps, queue.getTimeEventScale());
+    return 0;
+}
+
+/* samples, single time events and a time event at the start time with a common decimal resolution */
+static int test_decimal()
+{
+    time_event_type timeEventPairs;
+    long steps;
+
+    timeEventPairs.push_back(std::make_pair(0.0, 0.1));
+    timeEventPairs.push_back(std::make_pair(0.05, 0.2));
+    timeEventPairs.push_back(std::make_pair(0.3, 0.0));
+    timeEventPairs.push_back(std::make_pair(0.0, 0.3));
+    timeEventPairs.push_back(std::make_pair(0.7, 0.35));
+    timeEventPairs.push_back(std::make_pair(0.0, 0.0));
+    return compareTimeEvents("decimal", timeEventPairs, 5.0, &steps);
+}
+
+/* intervals without a decimal resolution fall back to merging by the rounding error */
+static int test_nonDecimal()
+{
+    time_event_type timeEventPairs;
+    long steps;
+
+    timeEventPairs.push_back(std::make_pair(1.0/3, 1.0/3));
+    timeEventPairs.push_back(std::make_pair(0.0, 0.1));
+    timeEventPairs.push_back(std::make_pair(0.0, 1.0/7));
+    timeEventPairs.push_back(std::make_pair(2.5, 0.0));
+    return compareTimeEvents("non-decimal", timeEventPairs, 5.0, &steps);
+}
+
+/* time events at the end time are counted, the ones after it are not */
+static int test_endTime()
+{
+    time_event_type timeEventPairs;
+    int rc;
+    long steps;
+
+    timeEventPairs.push_back(std::make_pair(0.0, 0.1));
+    timeEventPairs.push_back(std::make_pair(0.25, 0.25));
+    timeEventPairs.push_back(std::make_pair(1.0, 0.0));
+    timeEventPairs.push_back(std::make_pair(1.0 + 1e-9, 0.0));
+    if ((rc = compareTimeEvents("end time", timeEventPairs, 1.0, &steps)) != 0)
+        return rc;
+    if (steps != 12)
+        return 10;
+
+    // 3*0.1 > 0.3 in double arithmetic, the sample is still counted at the end time
+    timeEventPairs.clear();
+    timeEventPairs.push_back(std::make_pair(0.0, 0.1));
+    if ((rc = compareTimeEvents("rounded end time", timeEventPairs, 0.3, &steps)) != 0)
+        return 20 + rc;
+    if (steps != 3)
+        return 30;
+
+    // no time event until the end time, the former final stop counted time event 0 at tEnd
+    timeEventPairs.clear();
+    timeEventPairs.push_back(std::make_pair(0.0, 0.0));
+    timeEventPairs.push_back(std::make_pair(2.0, 0.0));
+    if ((rc = compareTimeEvents("no time event", timeEventPairs, 1.0, &steps)) != 0)
+        return 40 + rc;
+    if (steps != 0)
+        return 50;
+    return 0;
+}
+
+/* millions of sample occurrences, compared with the stops computed in advance */
+static int test_manySamples()
+{
+    time_event_type timeEventPairs;
+    int rc;
+    long steps;
+
+    timeEventPairs.push_back(std::make_pair(0.0, 1e-5));
+    timeEventPairs.push_back(std::make_pair(0.0, 1e-3));
+    timeEventPairs.push_back(std::make_pair(0.5, 0.25));
+    timeEventPairs.push_back(std::make_pair(7.5, 0.0));
+    if ((rc = compareTimeEvents("many samples", timeEventPairs, 20.0, &steps)) != 0)
+        return rc;
+    if (steps != 2000000)
+        return 10;
+    return 0;
+}
+
+/* main */
+int main()
+{
+    /* return code */
+    int rc;
+
+    if ((rc = test_decimal()) != 0) return 1000 + rc;
+    if ((rc = test_nonDecimal()) != 0) return 2000 + rc;
+    if ((rc = test_endTime()) != 0) return 3000 + rc;
+    if ((rc = test_manySamples()) != 0) return 4000 + rc;
+
+    return 0;
+}
+/** @} */ // end of coreSimcontroller
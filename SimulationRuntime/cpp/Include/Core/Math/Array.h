@@ -74,6 +74,8 @@ struct CopyRefArray2RefArray
 template<typename T> class BaseArray
 {
 public:
+  typedef T value_type;
+
   BaseArray(bool isStatic, bool isRefArray)
     :_isStatic(isStatic)
     ,_isRefArray(isRefArray)
@@ -0,0 +1,424 @@
+#pragma once
+/** @addtogroup math
+ *  @{
+ */
+
+/*****************************************************************************/
+/**
+
+Expression templates for elementwise array arithmetic.
+
+A chain like y = a*x + b .* c - d is built into a tree of lightweight nodes
+by add_array_expr, subtract_array_expr, multiply_array_expr,
+divide_array_expr, pow_array_expr and usub_array_expr and evaluated by
+assign_array_expr in one loop over the contiguous column-major array data, without
+temporaries and without virtual element access. Operands can be arrays,
+scalars or other expressions; all arrays of an expression must have the
+same number of elements. Matrix products are not elementwise and are
+evaluated with multiply_array.
+
+*/
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/mpl/if.hpp>
+
+/**
+ * Tag base of all expression nodes
+ */
+struct ArrayExprTag {};
+
+/**
+ * CRTP base of all expression nodes
+ */
+template <typename E>
+struct ArrayExpr : public ArrayExprTag
+{
+  const E& self() const
+  {
+    return static_cast<const E&>(*this);
+  }
+};
+
+/**
+ * Helper for ArrayExprRef and assign_array_expr,
+ * advances idx to the next element in column-major order
+ */
+template <typename T>
+inline void nextArrayExprIndex(const BaseArray<T>& a, std::vector<size_t>& idx)
+{
+  for (size_t d = 0; d < idx.size() && ++idx[d] > (size_t)a.getDim(d + 1); d++)
+    idx[d] = 1;
+}
+
+/**
+ * Leaf node for an array operand; holds its data in column-major order.
+ * Reference arrays keep their elements in row-major order, multi-dimensional
+ * ones are copied element-wise.
+ */
+template <typename T>
+class ArrayExprRef : public ArrayExpr<ArrayExprRef<T> >
+{
+ public:
+  typedef T value_type;
+  enum { is_scalar = 0 };
+
+  ArrayExprRef(const BaseArray<T>& array)
+    :_array(array)
+    ,_data(NULL)
+    ,_nelems(array.getNumElems())
+  {
+    if (array.isRefArray() && array.getNumDims() > 1) {
+      _copy.reset(new std::vector<T>(_nelems));
+      std::vector<size_t> idx(array.getNumDims(), 1);
+      for (size_t i = 0; i < _nelems; i++, nextArrayExprIndex(array, idx))
+        (*_copy)[i] = array(idx);
+      if (_nelems > 0)
+        _data = &(*_copy)[0];
+    }
+    else
+      _data = array.getData();
+  }
+
+  T operator[](size_t i) const
+  {
+    return _data[i];
+  }
+
+  size_t size() const
+  {
+    return _nelems;
+  }
+
+  std::vector<size_t> getDims() const
+  {
+    return _array.getDims();
+  }
+
+ private:
+  const BaseArray<T>& _array;
+  const T* _data;
+  size_t _nelems;
+  shared_ptr<std::vector<T> > _copy; // column-major copy, shared by copies of the node
+};
+
+/**
+ * Leaf node for a scalar operand
+ */
+template <typename T>
+class ArrayExprScalar : public ArrayExpr<ArrayExprScalar<T> >
+{
+ public:
+  typedef T value_type;
+  enum { is_scalar = 1 };
+
+  ArrayExprScalar(T value)
+    :_value(value)
+  {
+  }
+
+  T operator[](size_t i) const
+  {
+    return _value;
+  }
+
+  size_t size() const
+  {
+    return 0;
+  }
+
+  std::vector<size_t> getDims() const
+  {
+    return std::vector<size_t>();
+  }
+
+ private:
+  T _value;
+};
+
+/**
+ * Elementwise operations
+ */
+struct ArrayExprAdd
+{
+  template <typename T>
+  static T apply(T a, T b) { return a + b; }
+};
+
+struct ArrayExprSub
+{
+  template <typename T>
+  static T apply(T a, T b) { return a - b; }
+};
+
+struct ArrayExprMul
+{
+  template <typename T>
+  static T apply(T a, T b) { return a * b; }
+};
+
+struct ArrayExprDiv
+{
+  template <typename T>
+  static T apply(T a, T b) { return a / b; }
+};
+
+struct ArrayExprPow
+{
+  template <typename T>
+  static T apply(T a, T b) { return std::pow(a, b); }
+};
+
+/**
+ * Node for a binary elementwise operation
+ */
+template <typename L, typename R, typename Op>
+class ArrayExprBinary : public ArrayExpr<ArrayExprBinary<L, R, Op> >
+{
+ public:
+  typedef typename L::value_type value_type;
+  enum { is_scalar = L::is_scalar && R::is_scalar };
+
+  ArrayExprBinary(const L& left, const R& right)
+    :_left(left)
+    ,_right(right)
+  {
+    if (!L::is_scalar && !R::is_scalar && left.size() != right.size())
+      throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
+                                    "Right and left array must have the same size for element wise operation");
+  }
+
+  value_type operator[](size_t i) const
+  {
+    return Op::apply(_left[i], _right[i]);
+  }
+
+  size_t size() const
+  {
+    return L::is_scalar ? _right.size() : _left.size();
+  }
+
+  std::vector<size_t> getDims() const
+  {
+    return L::is_scalar ? _right.getDims() : _left.getDims();
+  }
+
+ private:
+  // leaves and subexpressions are held by value, they only store pointers
+  const L _left;
+  const R _right;
+};
+
+/**
+ * Node for unary minus
+ */
+template <typename E>
+class ArrayExprNeg : public ArrayExpr<ArrayExprNeg<E> >
+{
+ public:
+  typedef typename E::value_type value_type;
+  enum { is_scalar = E::is_scalar };
+
+  ArrayExprNeg(const E& expr)
+    :_expr(expr)
+  {
+  }
+
+  value_type operator[](size_t i) const
+  {
+    return -_expr[i];
+  }
+
+  size_t size() const
+  {
+    return _expr.size();
+  }
+
+  std::vector<size_t> getDims() const
+  {
+    return _expr.getDims();
+  }
+
+ private:
+  const E _expr;
+};
+
+/**
+ * Maps an operand type X to its expression node:
+ * arrays to ArrayExprRef, expressions to themselves and
+ * scalars to ArrayExprScalar of the element type T of the other operand
+ */
+template <typename X, typename Enable = void>
+struct ArrayExprOperand
+{
+  typedef typename X::value_type value_type;
+  template <typename T>
+  struct node
+  {
+    typedef typename boost::mpl::if_<boost::is_base_of<ArrayExprTag, X>,
+                                     X, ArrayExprRef<value_type> >::type type;
+  };
+
+  static const X& get(const X& x)
+  {
+    return x;
+  }
+};
+
+template <typename X>
+struct ArrayExprOperand<X, typename boost::enable_if<boost::is_arithmetic<X> >::type>
+{
+  typedef void value_type;
+  template <typename T>
+  struct node
+  {
+    typedef ArrayExprScalar<T> type;
+  };
+
+  static X get(X x)
+  {
+    return x;
+  }
+};
+
+/**
+ * Result type of a binary elementwise operation on operands L and R
+ */
+template <typename L, typename R, typename Op>
+struct ArrayExprBinaryOf
+{
+  typedef typename boost::mpl::if_<boost::is_arithmetic<L>,
+                                   typename ArrayExprOperand<R>::value_type,
+                                   typename ArrayExprOperand<L>::value_type>::type value_type;
+  typedef typename ArrayExprOperand<L>::template node<value_type>::type left_type;
+  typedef typename ArrayExprOperand<R>::template node<value_type>::type right_type;
+  typedef ArrayExprBinary<left_type, right_type, Op> type;
+
+  static type make(const L& left, const R& right)
+  {
+    return type(left_type(ArrayExprOperand<L>::get(left)),
+                right_type(ArrayExprOperand<R>::get(right)));
+  }
+};
+
+/**
+ * Elementwise addition a .+ b
+ */
+template <typename L, typename R>
+typename ArrayExprBinaryOf<L, R, ArrayExprAdd>::type
+add_array_expr(const L& left, const R& right)
+{
+  return ArrayExprBinaryOf<L, R, ArrayExprAdd>::make(left, right);
+}
+
+/**
+ * Elementwise subtraction a .- b
+ */
+template <typename L, typename R>
+typename ArrayExprBinaryOf<L, R, ArrayExprSub>::type
+subtract_array_expr(const L& left, const R& right)
+{
+  return ArrayExprBinaryOf<L, R, ArrayExprSub>::make(left, right);
+}
+
+/**
+ * Elementwise multiplication a .* b
+ */
+template <typename L, typename R>
+typename ArrayExprBinaryOf<L, R, ArrayExprMul>::type
+multiply_array_expr(const L& left, const R& right)
+{
+  return ArrayExprBinaryOf<L, R, ArrayExprMul>::make(left, right);
+}
+
+/**
+ * Elementwise division a ./ b
+ */
+template <typename L, typename R>
+typename ArrayExprBinaryOf<L, R, ArrayExprDiv>::type
+divide_array_expr(const L& left, const R& right)
+{
+  return ArrayExprBinaryOf<L, R, ArrayExprDiv>::make(left, right);
+}
+
+/**
+ * Elementwise exponentiation a .^ b
+ */
+template <typename L, typename R>
+typename ArrayExprBinaryOf<L, R, ArrayExprPow>::type
+pow_array_expr(const L& left, const R& right)
+{
+  return ArrayExprBinaryOf<L, R, ArrayExprPow>::make(left, right);
+}
+
+/**
+ * Unary minus of an array or expression
+ */
+template <typename X>
+ArrayExprNeg<typename ArrayExprOperand<X>::template node<typename ArrayExprOperand<X>::value_type>::type>
+usub_array_expr(const X& x)
+{
+  typedef typename ArrayExprOperand<X>::template node<typename ArrayExprOperand<X>::value_type>::type node_type;
+  return ArrayExprNeg<node_type>(node_type(ArrayExprOperand<X>::get(x)));
+}
+
+/**
+ * Helper for assign_array_expr, evaluates expr into contiguous data
+ */
+template <typename T, typename E>
+inline void evalArrayExpr(const E& expr, T* data, size_t nelems)
+{
+  for (size_t i = 0; i < nelems; i++)
+    data[i] = expr[i];
+}
+
+/**
+ * Evaluates expr into a dynamic array, resizing it if needed
+ */
+template <typename T, size_t ndims, typename E>
+void assign_array_expr(DynArray<T, ndims>& d, const ArrayExpr<E>& expr)
+{
+  const E& e = expr.self();
+  size_t nelems = e.size();
+  if (d.getNumElems() != nelems)
+    d.setDims(e.getDims());
+  evalArrayExpr(e, d.getData(), nelems);
+}
+
+/**
+ * Evaluates expr into a static array
+ */
+template <typename T, size_t nelems, bool external, typename E>
+void assign_array_expr(StatArray<T, nelems, external>& d, const ArrayExpr<E>& expr)
+{
+  const E& e = expr.self();
+  if (e.size() != nelems)
+    throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
+                                  "Wrong number of elements in assign_array_expr");
+  evalArrayExpr(e, d.getData(), nelems);
+}
+
+/**
+ * Evaluates expr into any other array, e.g. a reference array or slice,
+ * through a temporary that is written element-wise in column-major order
+ */
+template <typename T, typename E>
+void assign_array_expr(BaseArray<T>& d, const ArrayExpr<E>& expr)
+{
+  const E& e = expr.self();
+  size_t nelems = e.size();
+  if (d.getNumElems() != nelems)
+    d.setDims(e.getDims());
+  if (d.getNumElems() != nelems)
+    throw ModelicaSimulationError(MODEL_ARRAY_FUNCTION,
+                                  "Wrong number of elements in assign_array_expr");
+  std::vector<T> data(nelems);
+  if (nelems > 0) {
+    evalArrayExpr(e, &data[0], nelems);
+    std::vector<size_t> idx(d.getNumDims(), 1);
+    for (size_t i = 0; i < nelems; i++, nextArrayExprIndex(d, idx))
+      d(idx) = data[i];
+  }
+}
+/** @} */ // end of math
@@ -223,6 +223,7 @@ typedef ublas::matrix<double, ublas::column_major> matrix_t;
 #include <Core/Math/Functions.h>
 #include <Core/Math/ArrayOperations.h>
 #include <Core/Math/ArraySlice.h>
+#include <Core/Math/ArrayExpression.h>
 #include <Core/Math/Utility.h>
 #include <Core/DataExchange/IPropertyReader.h>
 #include <Core/DataExchange/SimDouble.h>
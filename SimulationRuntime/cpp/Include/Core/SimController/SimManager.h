@@ -5,6 +5,7 @@
  */
 #include <Core/SimController/Configuration.h>
 #include <Core/SimController/Initialization.h>
+#include <Core/SimController/TimeEventQueue.h>
 //#include <Core/SimController/FactoryExport.h>
 //#include <Core/Utils/extension/logger.hpp>
 
@@ -25,7 +26,9 @@ public:
     void runSingleStep();
 
 private:
-    void computeEndTimes(std::vector<std::pair<double,int> > &tStopsSub);
+    void computeEndTimes();
+    bool getNextTimeEvent(double& time);
+    void countTimeEvents(double time);
     void computeSampleCycles();
 
     void runSingleProcess();
@@ -34,7 +37,7 @@ private:
     shared_ptr<IMixedSystem> _mixed_system;
     Configuration* _config;
 
-    std::vector<std::vector<std::pair<double,int> > > _tStops;            ///< - Stopzeitpunkte aufgrund von Time-Events
+    TimeEventQueue                                    _timeEventQueue;    ///< - Pending occurrences of the time events
     shared_ptr<ISolver>                        _solver;            ///< - Solver
     int                                               _dimtimeevent,      ///< Temp - Timeevent-Dimensionen-Array
                                                       _dimZeroFunc;       ///< - Number of zero functions
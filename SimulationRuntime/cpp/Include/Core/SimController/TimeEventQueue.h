@@ -0,0 +1,45 @@
+#pragma once
+/** @addtogroup coreSimcontroller
+ *
+ *  @{
+ */
+#include <queue>
+
+/**
+ * Merges the occurrences of the time events of a system in time order. Only the next occurrence
+ * of each time event is kept, the following ones are generated while the simulation proceeds.
+ */
+class TimeEventQueue
+{
+public:
+    TimeEventQueue();
+    ~TimeEventQueue();
+
+    int initialize(const time_event_type& timeEventPairs, double tEnd, int* timeEventCounter);
+    bool getNextTimeEvent(double& time) const;
+    int countTimeEvents(double time, int* timeEventCounter);
+
+    double getTimeEventScale() const;
+    size_t getPendingTimeEvents() const;
+
+private:
+    /// Next occurrence of a time event
+    struct TimeEventOccurrence
+    {
+        double time;
+        long long tick;     ///< time in multiples of 1/_timeEventScale, if _timeEventScale > 0
+        long long count;    ///< number of the occurrence, time = start + count * interval
+        int index;          ///< index of the time event
+
+        bool operator>(const TimeEventOccurrence& other) const;
+    };
+    typedef std::priority_queue<TimeEventOccurrence, std::vector<TimeEventOccurrence>, std::greater<TimeEventOccurrence> > time_event_queue_type;
+
+    void scheduleTimeEvent(int index, long long count);
+
+    time_event_type       _timeEventPairs;    ///< <startTime, intervalLength> of the time events
+    time_event_queue_type _timeEventQueue;    ///< Next occurrence of each pending time event
+    double                _timeEventScale;    ///< Ticks per second of all time events, 0 if they have no common decimal resolution
+    double                _tEnd;
+};
+/** @} */ // end of coreSimcontroller
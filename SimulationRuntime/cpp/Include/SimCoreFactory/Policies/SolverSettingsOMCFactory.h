@@ -85,6 +85,19 @@ public:
             }
             solver_settings_key.assign("createPeerSettings");
         }
+        else if((solvername.compare("bs32")==0)||(solvername.compare("dopri45")==0)||(solvername.compare("verner65")==0)
+               ||(solvername.compare("trbdf2")==0)||(solvername.compare("esdirk43")==0)||(solvername.compare("sdirk43")==0))
+        {
+            fs::path rungekutta_path = ObjectFactory<CreationPolicy>::_library_path;
+            fs::path rungekutta_name(RUNGEKUTTA_LIB);
+            rungekutta_path/=rungekutta_name;
+            LOADERRESULT result = ObjectFactory<CreationPolicy>::_factory->LoadLibrary(rungekutta_path.string(),*_solver_type_map);
+            if (result != LOADER_SUCCESS)
+            {
+                throw ModelicaSimulationError(MODEL_FACTORY,"Failed loading RungeKutta solver library!");
+            }
+            solver_settings_key.assign("createRungeKuttaSettings");
+        }
         else if(solvername.compare("rtrk")==0)
         {
             fs::path rtrk_path = ObjectFactory<CreationPolicy>::_library_path;
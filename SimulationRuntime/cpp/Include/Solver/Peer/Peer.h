@@ -5,6 +5,7 @@
 
 #include <Core/Solver/SolverDefaultImplementation.h>
 #include <Core/Utils/extension/measure_time.hpp>
+#include <Core/Utils/extension/logger.hpp>
 
 
 /*****************************************************************************/
@@ -81,6 +82,20 @@ private:
   void evalD(const double& t, const double* y, double* T, IContinuous *continuousSystem, ITime *timeSystem);
   void setcycletime(double cycletime);
   void ros2(double * y, double& tstart, double tend, IContinuous *continuousSystem, ITime *timeSystem);
+#ifndef MPIPEER
+  /// Anlaufrechnung der Peer-Stufen ab t0 (auch nach Nullstellen)
+  void startPeer(double t0);
+  /// Peer-Schritt der Weite h, liefert die gewichtete Fehlernorm (<0 bei singulärer Iterationsmatrix)
+  double doPeerStep(double h);
+  /// Stufenwerte des Predictors für das Schrittweitenverhältnis sigma = h/_hStages
+  void computeTheta(double sigma);
+  /// Zustände zur Zeit t aus dem Interpolationspolynom der Stufenwerte
+  void interpolate(double t, double* y);
+  /// Ausgabe und Nullstellensuche für das Intervall (tLeft, tRight], liefert true nach einem Zustandsereignis
+  bool completeStep(double tLeft, double tRight);
+  void giveZeroVal(double t, double* zeroValue);
+  void synchronizeClones();
+#endif
 
   ISolverSettings
     *_peersettings;              ///< Input      - Solver settings
@@ -113,6 +128,24 @@ private:
         _h,
         _hOut;
 
+    double
+        *_J,                     ///< Jacobimatrizen der Stufen (wiederverwendet über _reuseJacobi Schritte)
+        *_yInterp,               ///< Zustände an Ausgabe- und Nullstellensuchpunkten
+        *_zeroValLeft,           ///< Nullstellenfunktionen am linken Rand des Suchintervalls
+        *_zeroValTry,            ///< Nullstellenfunktionen am Testpunkt der Nullstellensuche
+        _tStages,                ///< Mittelpunkt der akzeptierten Stufenwerte (Stufe i liegt bei _tStages+_c[i]*_hStages)
+        _hStages,                ///< Schrittweite der akzeptierten Stufenwerte
+        _hFactored,              ///< Schrittweite der faktorisierten Iterationsmatrizen (0 = neu faktorisieren)
+        _errOld,                 ///< Fehlernorm des letzten akzeptierten Schrittes (PI-Regler)
+        _tLastWrite,
+        _zeroTol;
+
+    int
+        _stepsSinceJacobian,
+        _numJacobians,
+        _numDecompositions,
+        _numRestarts;
+
 
 
   // Variables for Coloured Jacobians
@@ -134,7 +167,7 @@ private:
 
 //   ISystemProperties* _properties;
    IContinuous* _continuous_system[5];
-//   IEvent* _event_system;
+   IEvent* _event_system;
 //   IMixedSystem* _mixed_system;
    ITime* _time_system[5];
 
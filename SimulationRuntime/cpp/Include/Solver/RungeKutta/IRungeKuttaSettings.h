@@ -0,0 +1,45 @@
+#pragma once
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+
+/*****************************************************************************/
+/**
+
+Encapsulation of settings for the Runge-Kutta solver
+
+*/
+class IRungeKuttaSettings
+{
+public:
+    /// Enum to choose the Butcher tableau of the integration method
+    enum RKMETHOD
+    {
+        BOGACKI_SHAMPINE_32  = 0,    ///< Explicit Bogacki-Shampine 3(2), solver name "bs32"
+        DORMAND_PRINCE_45    = 1,    ///< Explicit Dormand-Prince 5(4), solver name "dopri45"
+        VERNER_65            = 2,    ///< Explicit Verner 6(5), solver name "verner65"
+        TR_BDF2              = 3,    ///< L-stable ESDIRK 2(3) (TR-BDF2), solver name "trbdf2"
+        ESDIRK_43            = 4,    ///< L-stable ESDIRK 4(3) of Kennedy and Carpenter, solver name "esdirk43"
+        SDIRK_43             = 5,    ///< L-stable SDIRK 4(3) of Hairer and Wanner, solver name "sdirk43"
+    };
+
+    virtual ~IRungeKuttaSettings() {};
+
+    /**
+    Choice of the Butcher tableau according to RKMETHOD ([0,1,2,3,4,5]; default: 1)
+    */
+    virtual unsigned int getRKMethod() = 0;
+    virtual void setRKMethod(unsigned int) = 0;
+    /**
+    Implicit methods only. Tolerance of the simplified newton iteration relative to the error tolerance (default: 0.05)
+    */
+    virtual double getNewtonTol() = 0;
+    virtual void setNewtonTol(double) = 0;
+    /**
+    Implicit methods only. Maximum number of newton iterations per stage (default: 7)
+    */
+    virtual unsigned int getMaxNewtonIterations() = 0;
+    virtual void setMaxNewtonIterations(unsigned int) = 0;
+};
+/** @} */ // end of solverRungeKutta
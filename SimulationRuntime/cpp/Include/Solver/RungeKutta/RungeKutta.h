@@ -0,0 +1,153 @@
+#pragma once
+/** @defgroup solverRungeKutta Solver.RungeKutta
+ *  Module for table-driven Runge-Kutta integration methods
+ *  @{
+ */
+#include "FactoryExport.h"
+#include <Core/Solver/SolverDefaultImplementation.h>
+#include <Core/Utils/extension/logger.hpp>
+
+class IRungeKuttaSettings;
+
+/// Butcher tableau of an embedded Runge-Kutta pair
+struct ButcherTableau
+{
+  const char* name;
+  int stages;
+  int order;                  ///< Order of the solution given by b
+  int embeddedOrder;          ///< Order of the embedded solution given by bHat
+  const double* A;            ///< Coefficients (stages x stages, row wise), strictly lower triangular or lower triangular with constant diagonal
+  const double* b;
+  const double* bHat;
+  const double* c;
+};
+
+/*****************************************************************************/
+/**
+
+Embedded Runge-Kutta methods for the solution of an initial value problem of
+a system of ordinary differential equations of the form
+
+z' = f(t,z).
+
+Every method is given by its Butcher tableau only, one engine integrates
+explicit pairs as well as SDIRK/ESDIRK methods. The stages of diagonally
+implicit methods are solved by a simplified newton iteration, the LU
+decomposition of I - h*gamma*J is shared by all stages and reused over steps
+as long as the step size is unchanged. The step size is controlled by a PI
+controller on the embedded error estimate.
+Dense output and the location of zero crossings use the cubic Hermite
+interpolation of the states and derivatives at both ends of a step.
+
+*/
+class RungeKutta : public ISolver, public SolverDefaultImplementation
+{
+public:
+    RungeKutta(IMixedSystem* system, ISolverSettings* settings);
+    virtual ~RungeKutta();
+
+    /// Set start time for numerical solution
+    virtual void setStartTime(const double& t);
+
+    /// Set end time for numerical solution
+    virtual void setEndTime(const double& t);
+
+    /// Set the initial step size (needed for reinitialization after external zero search)
+    virtual void setInitStepSize(const double& h);
+
+    /// (Re-) initialize the solver
+    virtual void initialize();
+
+    /// Approximation of the numerical solution in a given time interval
+    virtual void solve(const SOLVERCALL command = UNDEF_CALL);
+
+    /// Provides the status of the solver after returning
+    virtual ISolver::SOLVERSTATUS getSolverStatus();
+
+    /// Write out statistical information (statistical information of last simulation, e.g. time, number of steps, etc.)
+    virtual void writeSimulationInfo();
+    virtual void setTimeOut(unsigned int time_out);
+    virtual void stop();
+    /// Indicates whether a solver error occurred during integration, returns type of error and provides error message
+    virtual int reportErrorMessage(ostream& messageStream);
+    virtual bool stateSelection();
+
+private:
+    /// Derivatives f(t,z)
+    void evalF(double t, const double* z, double* f);
+
+    /// Jacobian of f at the beginning of the step by finite differences
+    void evalJ(double t);
+
+    /// Initial step size and derivatives after the start or an event at time t
+    void restart(double t);
+
+    /// Runge-Kutta step of size h from _tStep, returns the weighted error norm (<0 if the newton iteration failed)
+    double doRKStep(double h);
+
+    /// Simplified newton iteration for the implicit stage z = base + h*gamma*f(t,z), stores f(t,z) in k
+    bool solveStage(double t, double h, const double* base, double* k);
+
+    /// States at time t in [_tStep, _tStep+_hStep] from the Hermite interpolation of the last step
+    void interpolate(double t, double* y);
+
+    /// Output and zero search in (tLeft, tRight], returns true after a state event
+    bool completeStep(double tLeft, double tRight);
+    void giveZeroVal(double t, double* zeroValue);
+
+    IRungeKuttaSettings
+        *_rkSettings;            ///< Settings of the Runge-Kutta method
+
+    const ButcherTableau
+        *_tableau;               ///< Tableau of the selected method
+
+    IContinuous
+        *_continuous_system;
+    ITime
+        *_time_system;
+    IEvent
+        *_event_system;
+
+    double
+        *_y,                     ///< States at the end of the last accepted step
+        *_yOld,                  ///< States at the beginning of the last accepted step
+        *_f,                     ///< Derivatives at the end of the last accepted step
+        *_fOld,                  ///< Derivatives at the beginning of the last accepted step
+        *_yNew,                  ///< Solution of the current step
+        *_k,                     ///< Stage derivatives (stages x _dimSys, stored contiguously per stage)
+        *_yStage,                ///< Stage values
+        *_delta,                 ///< Newton correction and error estimate of the current step
+        *_fNewton,               ///< Derivatives in the newton iteration
+        *_J,                     ///< Jacobian (column major)
+        *_M,                     ///< LU decomposition of I - h*gamma*J
+        *_yInterp,               ///< States at output and zero search points
+        *_zeroValLeft,           ///< Zero functions at the left end of the search interval
+        *_zeroValTry;            ///< Zero functions at the test point of the zero search
+
+    long int
+        *_pivot;
+
+    double
+        _gamma,                  ///< Diagonal element of implicit tableaus, 0 for explicit methods
+        _tStep,                  ///< Beginning of the last accepted step
+        _hStep,                  ///< Size of the last accepted step
+        _hFactored,              ///< Step size of the decomposed iteration matrix (0 = decompose again)
+        _errOld,                 ///< Error norm of the last accepted step (PI controller)
+        _rate,                   ///< Estimated convergence rate of the newton iteration
+        _maxRate,                ///< Maximum newton convergence rate in the current step
+        _hOut,
+        _tLastWrite,
+        _zeroTol;
+
+    bool
+        _fsal,                   ///< Last stage equals the derivatives at the end of the step (first same as last)
+        _jacobianCurrent,        ///< Jacobian was evaluated at the beginning of the current step
+        _needJacobian;           ///< Jacobian has to be evaluated before the next step
+
+    int
+        _numJacobians,
+        _numDecompositions,
+        _numNewtonFailures,
+        _numRestarts;
+};
+/** @} */ // end of solverRungeKutta
@@ -0,0 +1,49 @@
+#pragma once
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+#include "FactoryExport.h"
+#include <Core/Solver/SolverSettings.h>
+#include <Solver/RungeKutta/IRungeKuttaSettings.h>
+
+/*****************************************************************************/
+/**
+
+Encapsulation of settings for the Runge-Kutta solver
+
+*/
+class RungeKuttaSettings : public IRungeKuttaSettings, public SolverSettings
+{
+public:
+    RungeKuttaSettings(IGlobalSettings* globalSettings);
+    virtual ~RungeKuttaSettings();
+
+    virtual unsigned int getRKMethod();
+    virtual void setRKMethod(unsigned int);
+    virtual double getNewtonTol();
+    virtual void setNewtonTol(double);
+    virtual unsigned int getMaxNewtonIterations();
+    virtual void setMaxNewtonIterations(unsigned int);
+
+private:
+    unsigned int
+        _method,                 ///< Choice of the Butcher tableau according to RKMETHOD (default: DORMAND_PRINCE_45)
+        _maxNewtonIterations;    ///< Maximum number of newton iterations per stage (default: 7)
+
+    double
+        _newtonTol;              ///< Tolerance of the simplified newton iteration relative to the error tolerance (default: 0.05)
+};
+
+/// Settings preset to one method, the factory registers one of them for every solver name
+template<IRungeKuttaSettings::RKMETHOD METHOD>
+class RungeKuttaMethodSettings : public RungeKuttaSettings
+{
+public:
+    RungeKuttaMethodSettings(IGlobalSettings* globalSettings)
+      : RungeKuttaSettings(globalSettings)
+    {
+        setRKMethod(METHOD);
+    }
+};
+/** @} */ // end of solverRungeKutta
@@ -20,7 +20,33 @@ Peer::Peer(IMixedSystem* system, ISolverSettings* settings)
       _continuous_system(),
       _time_system(),
       _hOut(0.0),
-      _reuseJacobi(5000)
+      _reuseJacobi(5000),
+      _G(NULL),
+      _E(NULL),
+      _Theta(NULL),
+      _c(NULL),
+      _F(NULL),
+      _y(NULL),
+      _Y1(NULL),
+      _Y2(NULL),
+      _Y3(NULL),
+      _T(NULL),
+      _P(NULL),
+      _J(NULL),
+      _yInterp(NULL),
+      _zeroValLeft(NULL),
+      _zeroValTry(NULL),
+      _tStages(0.0),
+      _hStages(0.0),
+      _hFactored(0.0),
+      _errOld(1.0),
+      _tLastWrite(0.0),
+      _zeroTol(1e-10),
+      _stepsSinceJacobian(0),
+      _numJacobians(0),
+      _numDecompositions(0),
+      _numRestarts(0),
+      _event_system(NULL)
 /*      _cvodeMem(NULL),
       _z(NULL),
       _zInit(NULL),
@@ -73,6 +99,14 @@ Peer::~Peer()
     delete [] _P;
   if (_y)
     delete [] _y;
+  if (_J)
+    delete [] _J;
+  if (_yInterp)
+    delete [] _yInterp;
+  if (_zeroValLeft)
+    delete [] _zeroValLeft;
+  if (_zeroValTry)
+    delete [] _zeroValTry;
 
 #ifndef MPIPEER
   for(int i = 1; i < 5; i++)
@@ -108,6 +142,7 @@ void Peer::initialize()
 #else
     _time_system[0] = time_system;
     _continuous_system[0] = continuous_system;
+    _event_system = dynamic_cast<IEvent*>(_system);
 
     for(int i = 1; i < 5; i++)
     {
@@ -212,6 +247,10 @@ void Peer::initialize()
     _Y1=new double[_dimSys*_rstages];
     _Y2=new double[_dimSys*_rstages];
     _Y3=new double[_dimSys*_rstages];
+    _J=new double[_dimSys*_dimSys*5];
+    _yInterp=new double[_dimSys];
+    _zeroValLeft=new double[_dimZeroFunc];
+    _zeroValTry=new double[_dimZeroFunc];
 #endif
 
     _continuous_system[0]->evaluateAll(IContinuous::ALL);
@@ -294,9 +333,16 @@ void Peer::ros2(double * y, double& tstart, double tend, IContinuous *continuous
         for(int i=0; i<_dimSys;++ i)  k2[i]+= hu*gamma*D[i]-2.*k1[i];
         dgetrs_(&trans, &_dimSys, &dim, T, &_dimSys, P, k2, &_dimSys, &info);
         for(int i=0; i<_dimSys;++ i) y[i]+=0.5*hu*(k1[i]+k2[i]);
+        t+=hu;
     }
+    delete [] T;
+    delete [] D;
+    delete [] k1;
+    delete [] k2;
+    delete [] P;
 }
 
+#ifdef MPIPEER
 void Peer::solve(const SOLVERCALL action)
 {
     double twrite=_hOut;
@@ -312,12 +358,11 @@ void Peer::solve(const SOLVERCALL action)
         SolverDefaultImplementation::writeToFile(0, t, _h);
     }
 
-#ifdef MPIPEER
     std::copy(_y,_y+_dimSys,_Y1);
     if (abs(_c[_rank]+1.)>1e-12)
     {
 
-        ros2(_Y1,_tCurrent,_tCurrent+_h*(_c[_rank]+1.));
+        ros2(_Y1,_tCurrent,_tCurrent+_h*(_c[_rank]+1.),_continuous_system[0],_time_system[0]);
         t=_tCurrent;
     }
     MPI_Barrier(MPI_COMM_WORLD);
@@ -327,27 +372,6 @@ void Peer::solve(const SOLVERCALL action)
         MPI_Gather(_Y1,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
     }
     t+=_h;
-#else
-#pragma omp parallel for num_threads(_numThreads)
-    for(int _rank=0; _rank<5; ++_rank) {
-        std::copy(_y,_y+_dimSys,&_Y1[_rank*_dimSys]);
-        if (abs(_c[_rank]+1.)>1e-12)
-        {
-            ros2(&_Y1[_rank*_dimSys],_tCurrent,_tCurrent+_h*(_c[_rank]+1.), _continuous_system[_rank], _time_system[_rank]);
-            t=_tCurrent;
-        }
-    }
-    t+=_h;
-    _time_system[0]->setTime(t);
-    _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
-    if(writeOutput) {
-        if(t>=twrite) {
-            _continuous_system[0]->evaluateAll(IContinuous::ALL);
-            SolverDefaultImplementation::writeToFile(0, t, _h);
-            twrite+=_hOut;
-        }
-    }
-#endif
 
 
 
@@ -356,10 +380,9 @@ void Peer::solve(const SOLVERCALL action)
     t+=_h;
     char trans='N';
     long int dim=1;
-    int count=0;
+    long int info;
     while(std::abs(t-_tEnd)>1e-8)
     {
-#ifdef MPIPEER
         if(_rank==0)
         {
             for(int i=0; i<_rstages; ++i)
@@ -372,12 +395,6 @@ void Peer::solve(const SOLVERCALL action)
                 }
  //               Y2.vector(i)=Y1*mtl::vector::trans(Theta[i][iall]);
             }
-            std::cout<<"_Y2 vals on rank "<<_rank<<": ";
-              for(int i=0; i<_rstages*_dimSys;++i) {
-                  if(!(i%20)) std::cout<<std::endl;
-                std::cout<<_Y2[i]<<" ";
-            }
-            std::cout<<std::endl;
             for(int i=0; i<_rstages; i++)
             {
                  for(int j=0; j<_dimSys; ++j) {
@@ -399,16 +416,8 @@ void Peer::solve(const SOLVERCALL action)
             MPI_Scatter(_Y3,_dimSys,MPI_DOUBLE,_Y3,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
         }
 
-        evalF(t+_c[_rank]*_h,_Y2,_F);
-        evalJ(t+_c[_rank]*_h,_Y2,_T);
-        if(_rank==0) {
-            std::cout<<"Jac: ";
-            for(int i(0); i<_dimSys*_dimSys;++i) {
-                if(!(i%20)) std::cout<<std::endl;
-                std::cout<<_T[i]<<" ";
-            }
-            std::cout<<std::endl;
-        }
+        evalF(t+_c[_rank]*_h,_Y2,_F,_continuous_system[0],_time_system[0]);
+        evalJ(t+_c[_rank]*_h,_Y2,_T,_continuous_system[0],_time_system[0]);
         for(int i=0; i<_dimSys; ++i) {
             for(int j=0; j<_dimSys; ++j) {
                 _T[i*_dimSys+j]*=-_h*_G[_rank];
@@ -440,94 +449,413 @@ void Peer::solve(const SOLVERCALL action)
             SolverDefaultImplementation::writeToFile(0, t, _h);
         }
         t+=_h;
+
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if(_rank==0)
+    {
+        for(int i=0; i<_dimSys; i++) _y[i]=_Y1[(_rstages-1)*_dimSys+i];
+    }
+    MPI_Bcast(_y, _dimSys, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    _tCurrent=_tEnd;
+    _time_system[0]->setTime(_tCurrent);
+    _continuous_system[0]->setContinuousStates(_y);
+    if(writeOutput) {
+        _continuous_system[0]->evaluateAll(IContinuous::ALL);
+        SolverDefaultImplementation::writeToFile(0, t, _h);
+    }
+    _solverStatus = ISolver::DONE;
+}
 #else
-        for(int i=0; i<_rstages; ++i)
-        {
-            for(int j=0; j<_dimSys; ++j) {
-                _Y2[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
-                    }
-                }
- //               Y2.vector(i)=Y1*mtl::vector::trans(Theta[i][iall]);
-            }
-            for(int i=0; i<_rstages; i++)
-            {
-                 for(int j=0; j<_dimSys; ++j) {
-                    _Y3[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
-                    }
-                }
-//                Y3.vector(i)=Y2*mtl::vector::trans(E[i][iall]);
-            }
+/// Lagrange-Basispolynome zu den Knoten c, ausgewertet an der Stelle x
+static void lagrangeBasis(const double* c, int s, double x, double* w)
+{
+    for(int j=0; j<s; ++j) {
+        w[j]=1.;
+        for(int k=0; k<s; ++k) {
+            if(k!=j) w[j]*=(x-c[k])/(c[j]-c[k]);
+        }
+    }
+}
 
-#pragma omp parallel for num_threads(_numThreads)
-        for(int _rank=0; _rank<5; ++_rank) {
-            long int info;
-            evalF(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_F[_rank*_dimSys],_continuous_system[_rank], _time_system[_rank]);
-            if(!(count%_reuseJacobi)) {
-               evalJ(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_T[_rank*_dimSys*_dimSys], _continuous_system[_rank], _time_system[_rank]);
-                for(int i=0; i<_dimSys; ++i) {
-                    for(int j=0; j<_dimSys; ++j) {
-                        _T[_rank*_dimSys*_dimSys+i*_dimSys+j]*=-_h*_G[_rank];
-                    }
-                    _T[_rank*_dimSys*_dimSys+i*_dimSys+i]+=1.;
-                }
+/// Vorzeichenwechsel einer Nullstellenfunktion zwischen a und b (ein Nulldurchgang bei b zählt als Wechsel)
+static bool zeroCrossed(double a, double b)
+{
+    return (a < 0. && b >= 0.) || (a > 0. && b <= 0.);
+}
 
-                dgetrf_(&_dimSys, &_dimSys, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &info);
+void Peer::solve(const SOLVERCALL action)
+{
+    bool writeEventOutput = (_settings->getGlobalSettings()->getOutputPointType() == OPT_ALL);
+    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
+
+    if ((action & RECORDCALL) && (action & FIRST_CALL)) {
+        initialize();
+        if(writeOutput)
+            SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
+        _tLastWrite = _tCurrent;
+        return;
+    }
+    if ((action & RECORDCALL) && !(action & FIRST_CALL)) {
+        SolverDefaultImplementation::writeToFile(_accStps, _tCurrent, _h);
+        return;
+    }
+    // Nach einem TimeEvent wird der neue Zustand recorded
+    if ((action & RECALL) && writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
+
+    const double safety=0.9, facMin=0.2, facMax=2.;
+    const double endTimeTol=_peersettings->getEndTimeTol();
+    bool restart=true, rejected=false;
+    double tFront=_tCurrent;
+
+    // Zustände und diskrete Variablen können sich durch TimeEvents des SimManagers geändert haben
+    _continuous_system[0]->getContinuousStates(_y);
+    _continuous_system[0]->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(_zeroValLastSuccess);
+    synchronizeClones();
+
+    _solverStatus = ISolver::CONTINUE;
+    while((_solverStatus & ISolver::CONTINUE) && !_interrupt)
+    {
+        if(_tEnd-tFront<=endTimeTol) {
+            _solverStatus = ISolver::DONE;
+            break;
+        }
+        double tLeft=tFront;
+        if(restart) {
+            startPeer(tFront);
+            restart=false;
+            rejected=false;
+        } else {
+            double h=std::min(_h, _tEnd-tFront);
+            double err=doPeerStep(h);
+            ++_totStps;
+            if(err<0. || err>1.) {
+                // Schritt verwerfen, bei singulärer Iterationsmatrix oder wiederholter Ablehnung mit neuer Jacobimatrix
+                ++_rejStps;
+                _h=h*(err<0. ? 0.25 : max(facMin, safety*pow(err, -0.2)));
+                if(_stepsSinceJacobian>0)
+                    _stepsSinceJacobian=_reuseJacobi;
+                rejected=true;
+                if(_h<max(_peersettings->getLowerLimit(), 10.*UROUND*abs(tFront)))
+                    throw ModelicaSimulationError(SOLVER,"Peer: step size too small at time " + to_string(tFront));
+                continue;
             }
+            // PI-Regler (Gustafsson), nach Ablehnung kein Vergrößern der Schrittweite
+            err=max(err, 1e-4);
+            double fac=safety*pow(err, -0.7/5.)*pow(_errOld, 0.4/5.);
+            fac=std::min(facMax, max(facMin, fac));
+            if(rejected)
+                fac=std::min(fac, 1.);
+            // kleine Änderungen unterdrücken, damit die Iterationsmatrizen wiederverwendet werden
+            if(fac>=1. && fac<=1.2)
+                fac=1.;
+            _h=std::min(h*fac, _peersettings->getUpperLimit());
+            _errOld=err;
+            rejected=false;
+            ++_accStps;
+            ++_stepsSinceJacobian;
+            _tStages=tFront;
+            _hStages=h;
+            std::swap(_Y1, _F);
+        }
+        tFront=_tStages+_hStages;
+        std::copy(&_Y1[4*_dimSys], &_Y1[5*_dimSys], _y);
+        if(completeStep(tLeft, tFront)) {
+            // Zustandsereignis: Neustart der Peer-Stufen am Ereigniszeitpunkt
+            tFront=_tCurrent;
+            restart=true;
+        } else {
+            _tCurrent=tFront;
+        }
+        if(_continuous_system[0]->stepCompleted(_tCurrent))
+            _solverStatus = ISolver::DONE;
+    }
+    if(_interrupt)
+        _solverStatus = ISolver::DONE;
 
+    if(_tEnd-_tCurrent<=endTimeTol)
+        _tCurrent=_tEnd;
+    _time_system[0]->setTime(_tCurrent);
+    _continuous_system[0]->setContinuousStates(_y);
+    _continuous_system[0]->evaluateAll(IContinuous::CONTINUOUS);
+    if(writeOutput && _peersettings->getDenseOutput() && _tLastWrite<_tCurrent)
+        SolverDefaultImplementation::writeToFile(_accStps, _tCurrent, _hStages);
+}
+
+void Peer::startPeer(double t0)
+{
+    const double atol=_peersettings->getATol(), rtol=_peersettings->getRTol();
+    double d0=0., d1=0.;
+
+    // Anfangsschrittweite aus dem Verhältnis von Zustand und Ableitung
+    evalF(t0, _y, _F, _continuous_system[0], _time_system[0]);
+    for(int i=0; i<_dimSys; ++i) {
+        double sk=atol+rtol*abs(_y[i]);
+        d0+=(_y[i]/sk)*(_y[i]/sk);
+        d1+=(_F[i]/sk)*(_F[i]/sk);
+    }
+    d0=sqrt(d0/max(_dimSys, 1L));
+    d1=sqrt(d1/max(_dimSys, 1L));
+    double h=(d0<1e-5 || d1<1e-5) ? 1e-6 : 1e-2*d0/d1;
+    h=std::min(h, std::min(_peersettings->getUpperLimit(), 0.5*(_tEnd-t0)));
+
+#pragma omp parallel for num_threads(_numThreads)
+    for(int _rank=0; _rank<5; ++_rank) {
+        double tStart=t0;
+        std::copy(_y,_y+_dimSys,&_Y1[_rank*_dimSys]);
+        if (abs(_c[_rank]+1.)>1e-12)
+        {
+            ros2(&_Y1[_rank*_dimSys],tStart,t0+h*(_c[_rank]+1.), _continuous_system[_rank], _time_system[_rank]);
+        }
+    }
+    _tStages=t0+h;
+    _hStages=h;
+    _h=h;
+    _hFactored=0.;
+    _stepsSinceJacobian=_reuseJacobi;
+    _errOld=1.;
+    ++_numRestarts;
+}
 
-    //        std::cerr << "Finished iteration matrix calculation step at rank  " << _rank<<std::endl;
+double Peer::doPeerStep(double h)
+{
+    const double t=_tStages+_hStages;
+    const double atol=_peersettings->getATol(), rtol=_peersettings->getRTol();
+    const bool newJacobian=(_stepsSinceJacobian>=_reuseJacobi);
+    const bool factorize=newJacobian || (h!=_hFactored);
+    char trans='N';
+    long int dim=1;
+    int singular=0;
 
-            for(int i=0; i<_dimSys; ++i) {
-                _F[_rank*_dimSys+i]*=_h;
-                _F[_rank*_dimSys+i]-=_Y3[_rank*_dimSys+i];
-                _F[_rank*_dimSys+i]*=_G[_rank];
+    // Predictor: Interpolation der alten Stufenwerte an den neuen Knoten t+c_i*h
+    computeTheta(h/_hStages);
+    for(int i=0; i<_rstages; ++i)
+    {
+        for(int j=0; j<_dimSys; ++j) {
+            _Y2[i*_dimSys+j]=0.;
+            for(int k=0; k<_rstages;++k) {
+                _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
             }
-            dgetrs_(&trans, &_dimSys, &dim, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &_F[_rank*_dimSys], &_dimSys, &info);
-            for(int i=0; i<_dimSys; ++i) {
-                _Y1[_rank*_dimSys+i]=_F[_rank*_dimSys+i]+_Y2[_rank*_dimSys+i];
+        }
+    }
+    for(int i=0; i<_rstages; i++)
+    {
+        for(int j=0; j<_dimSys; ++j) {
+            _Y3[i*_dimSys+j]=0.;
+            for(int k=0; k<_rstages;++k) {
+                _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
             }
         }
+    }
 
-        count++;
-        if(t+_h>_tEnd) _h=_tEnd-t;
-        _time_system[0]->setTime(t);
-        _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
-
-        if(writeOutput) {
-            if(t>=twrite) {
-                _continuous_system[0]->evaluateAll(IContinuous::ALL);
-                SolverDefaultImplementation::writeToFile(0, t, _h);
-                twrite+=_hOut;
+#pragma omp parallel for num_threads(_numThreads) reduction(+:singular)
+    for(int _rank=0; _rank<5; ++_rank) {
+        long int info=0;
+        double *T=&_T[_rank*_dimSys*_dimSys];
+        double *J=&_J[_rank*_dimSys*_dimSys];
+        evalF(t+_c[_rank]*h,&_Y2[_rank*_dimSys],&_F[_rank*_dimSys],_continuous_system[_rank], _time_system[_rank]);
+        if(newJacobian)
+            evalJ(t+_c[_rank]*h,&_Y2[_rank*_dimSys],J, _continuous_system[_rank], _time_system[_rank]);
+        if(factorize) {
+            for(int i=0; i<_dimSys*_dimSys; ++i)
+                T[i]=-h*_G[_rank]*J[i];
+            for(int i=0; i<_dimSys; ++i)
+                T[i*_dimSys+i]+=1.;
+            dgetrf_(&_dimSys, &_dimSys, T, &_dimSys, &_P[_rank*_dimSys], &info);
+            if(info!=0) {
+                singular++;
+                continue;
             }
         }
-        t+=_h;
-#endif
+        for(int i=0; i<_dimSys; ++i) {
+            _F[_rank*_dimSys+i]*=h;
+            _F[_rank*_dimSys+i]-=_Y3[_rank*_dimSys+i];
+            _F[_rank*_dimSys+i]*=_G[_rank];
+        }
+        dgetrs_(&trans, &_dimSys, &dim, T, &_dimSys, &_P[_rank*_dimSys], &_F[_rank*_dimSys], &_dimSys, &info);
+        for(int i=0; i<_dimSys; ++i) {
+            _F[_rank*_dimSys+i]+=_Y2[_rank*_dimSys+i];
+        }
+    }
 
+    if(newJacobian) {
+        _stepsSinceJacobian=0;
+        ++_numJacobians;
     }
-#ifdef MPIPEER
-    MPI_Barrier(MPI_COMM_WORLD);
-    if(_rank==0)
-    {
-        for(int i=0; i<_dimSys; i++) _y[i]=_Y1[(_rstages-1)*_dimSys+i];
+    if(singular) {
+        _hFactored=0.;
+        return -1.;
     }
-    MPI_Bcast(_y, _dimSys, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-#else
-    for(int i=0; i<_dimSys; i++) _y[i]=_Y1[(_rstages-1)*_dimSys+i];
-#endif
-    _tCurrent=_tEnd;
-    _time_system[0]->setTime(_tCurrent);
-    _continuous_system[0]->setContinuousStates(&_Y1[4*_dimSys]);
+    if(factorize) {
+        _hFactored=h;
+        ++_numDecompositions;
+    }
+
+    // eingebettete Fehlerschätzung: Differenz von Predictor und Lösung in der letzten Stufe
+    double err=0.;
+    const double *yNew=&_F[4*_dimSys], *yPred=&_Y2[4*_dimSys];
+    for(int i=0; i<_dimSys; ++i) {
+        double e=(yNew[i]-yPred[i])/(atol+rtol*max(abs(_y[i]), abs(yNew[i])));
+        err+=e*e;
+    }
+    return _dimSys>0 ? sqrt(err/_dimSys) : 0.;
+}
+
+void Peer::computeTheta(double sigma)
+{
+    for(int i=0; i<_rstages; ++i)
+        lagrangeBasis(_c, _rstages, 1.+sigma*_c[i], &_Theta[i*_rstages]);
+}
+
+void Peer::interpolate(double t, double* y)
+{
+    double w[5];
+    lagrangeBasis(_c, _rstages, (t-_tStages)/_hStages, w);
+    for(int j=0; j<_dimSys; ++j) {
+        y[j]=0.;
+        for(int k=0; k<_rstages; ++k)
+            y[j]+=w[k]*_Y1[k*_dimSys+j];
+    }
+}
+
+void Peer::giveZeroVal(double t, double* zeroValue)
+{
+    interpolate(t, _yInterp);
+    _time_system[0]->setTime(t);
+    _continuous_system[0]->setContinuousStates(_yInterp);
+    _continuous_system[0]->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(zeroValue);
+}
+
+bool Peer::completeStep(double tLeft, double tRight)
+{
+    bool writeEventOutput = (_settings->getGlobalSettings()->getOutputPointType() == OPT_ALL);
+    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
+    bool zeroFound=false;
+    double tEvent=tRight;
+
+    if(_dimZeroFunc>0) {
+        giveZeroVal(tRight, _zeroVal);
+        for(int i=0; i<_dimZeroFunc; ++i)
+            zeroFound=zeroFound || zeroCrossed(_zeroValLastSuccess[i], _zeroVal[i]);
+    }
+    if(zeroFound) {
+        // Illinois-Verfahren auf dem Interpolationspolynom, gesucht ist der erste Nulldurchgang in (tLeft, tRight]
+        double tL=tLeft, tR=tRight;
+        int side=0;
+        memcpy(_zeroValLeft, _zeroValLastSuccess, _dimZeroFunc*sizeof(double));
+        while(tR-tL>max(_zeroTol, 4.*UROUND*abs(tR))) {
+            double tTry=tR;
+            for(int i=0; i<_dimZeroFunc; ++i) {
+                if(zeroCrossed(_zeroValLeft[i], _zeroVal[i]) && _zeroVal[i]!=_zeroValLeft[i])
+                    tTry=std::min(tTry, tL-_zeroValLeft[i]*(tR-tL)/(_zeroVal[i]-_zeroValLeft[i]));
+            }
+            tTry=std::min(max(tTry, tL+0.5*_zeroTol), tR-0.5*_zeroTol);
+            giveZeroVal(tTry, _zeroValTry);
+            bool crossed=false;
+            for(int i=0; i<_dimZeroFunc; ++i)
+                crossed=crossed || zeroCrossed(_zeroValLeft[i], _zeroValTry[i]);
+            if(crossed) {
+                tR=tTry;
+                memcpy(_zeroVal, _zeroValTry, _dimZeroFunc*sizeof(double));
+                if(side==-1) {
+                    for(int i=0; i<_dimZeroFunc; ++i)
+                        _zeroValLeft[i]*=0.5;
+                }
+                side=-1;
+            } else {
+                tL=tTry;
+                memcpy(_zeroValLeft, _zeroValTry, _dimZeroFunc*sizeof(double));
+                if(side==1) {
+                    for(int i=0; i<_dimZeroFunc; ++i)
+                        _zeroVal[i]*=0.5;
+                }
+                side=1;
+            }
+            ++_zeroStps;
+        }
+        for(int i=0; i<_dimZeroFunc; ++i)
+            _events[i]=zeroCrossed(_zeroValLeft[i], _zeroVal[i]);
+        tEvent=tR;
+    }
+
+    // Ausgabe an den äquidistanten Ausgabepunkten über das Interpolationspolynom
     if(writeOutput) {
-        _continuous_system[0]->evaluateAll(IContinuous::ALL);
-        SolverDefaultImplementation::writeToFile(0, t, _h);
+        if(_peersettings->getDenseOutput() && _hOut>0.) {
+            while(_tLastWrite+_hOut<=tEvent) {
+                _tLastWrite+=_hOut;
+                interpolate(_tLastWrite, _yInterp);
+                _time_system[0]->setTime(_tLastWrite);
+                _continuous_system[0]->setContinuousStates(_yInterp);
+                _continuous_system[0]->evaluateAll(IContinuous::CONTINUOUS);
+                SolverDefaultImplementation::writeToFile(_accStps, _tLastWrite, _hStages);
+            }
+        } else if(!zeroFound) {
+            _time_system[0]->setTime(tRight);
+            _continuous_system[0]->setContinuousStates(_y);
+            _continuous_system[0]->evaluateAll(IContinuous::CONTINUOUS);
+            SolverDefaultImplementation::writeToFile(_accStps, tRight, _hStages);
+        }
     }
-    _solverStatus = ISolver::DONE;
+
+    if(!zeroFound) {
+        if(_dimZeroFunc>0)
+            memcpy(_zeroValLastSuccess, _zeroVal, _dimZeroFunc*sizeof(double));
+        _time_system[0]->setTime(tRight);
+        _continuous_system[0]->setContinuousStates(_y);
+        return false;
+    }
+
+    interpolate(tEvent, _y);
+    _tCurrent=tEvent;
+    _time_system[0]->setTime(tEvent);
+    _continuous_system[0]->setContinuousStates(_y);
+    _continuous_system[0]->evaluateAll(IContinuous::CONTINUOUS);
+    // Werte vor dem Ereignis (P1) und nach dem Ereignis (P2) schreiben, siehe Cvode
+    if(writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, tEvent, _hStages);
+    if(_system->handleSystemEvents(_events))
+        _continuous_system[0]->getContinuousStates(_y);
+    _continuous_system[0]->evaluateAll(IContinuous::CONTINUOUS);
+    if(writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, tEvent, _hStages);
+    _continuous_system[0]->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(_zeroValLastSuccess);
+    synchronizeClones();
+    ++_zeros;
+    return true;
 }
 
+/// Übernahme der Variablen und Bedingungen des Hauptsystems in die Kopien der übrigen Stufen
+void Peer::synchronizeClones()
+{
+    IContinuous* continuous_system=_continuous_system[0];
+    double* realVars=new double[continuous_system->getDimReal()];
+    int* intVars=new int[continuous_system->getDimInteger()];
+    bool* boolVars=new bool[continuous_system->getDimBoolean()];
+    bool* conditions=new bool[_dimZeroFunc];
+
+    continuous_system->getReal(realVars);
+    continuous_system->getInteger(intVars);
+    continuous_system->getBoolean(boolVars);
+    _event_system->getConditions(conditions);
+    for(int i = 1; i < 5; i++)
+    {
+        IEvent* event_system=dynamic_cast<IEvent*>(_continuous_system[i]);
+        _continuous_system[i]->setReal(realVars);
+        _continuous_system[i]->setInteger(intVars);
+        _continuous_system[i]->setBoolean(boolVars);
+        event_system->setConditions(conditions);
+        event_system->saveAll();
+    }
+    delete [] realVars;
+    delete [] intVars;
+    delete [] boolVars;
+    delete [] conditions;
+}
+#endif
 
 
 void Peer::writePeerOutput(const double &time, const double &h, const int &stp)
@@ -597,7 +925,17 @@ void Peer::setTimeOut(unsigned int time_out)
 
 
 void Peer::setcycletime(double cycletime){}
-void Peer::writeSimulationInfo(){}
+void Peer::writeSimulationInfo()
+{
+#ifndef MPIPEER
+    LOGGER_WRITE("Peer: number steps = " + to_string(_accStps), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("Peer: rejected steps = " + to_string(_rejStps), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("Peer: jacobian evaluations = " + to_string(_numJacobians), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("Peer: decompositions = " + to_string(_numDecompositions), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("Peer: restarts = " + to_string(_numRestarts), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("Peer: state events = " + to_string(_zeros), LC_SOLV, LL_INFO);
+#endif
+}
 int Peer::reportErrorMessage(std::ostream& messageStream) {
     return 0;
 }
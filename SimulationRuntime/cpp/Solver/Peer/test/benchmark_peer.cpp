@@ -0,0 +1,107 @@
+/* Work-precision comparison of the Peer solver at 1, 2, 4 and 8 threads with
+ * Cvode on the systems of test_model.h. For every tolerance the error at the
+ * output points, the number of right hand side evaluations and the wall clock
+ * time are printed.
+ *
+ * Usage: benchmark_peer [tEnd]
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/SimulationSettings/IGlobalSettings.h>
+#include <Core/SimulationSettings/GlobalSettings.h>
+#include <Solver/Peer/Peer.h>
+#include <Solver/Peer/PeerSettings.h>
+#include <Solver/CVode/CVode.h>
+#include <Solver/CVode/CVodeSettings.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <omp.h>
+
+#include <Solver/test/test_model.h>
+
+/* x(20) of Van der Pol with mu = 10 from Dormand-Prince at tolerance 1e-13 */
+static const double vanDerPolReference = 1.9393585328;
+
+/* simulates from 0 to tEnd and returns the error, -1 if the solver failed */
+template<class SOLVER, class SETTINGS>
+static double simulate(TestModel& model, double tol, int threads, double tEnd, double* seconds)
+{
+    GlobalSettings globalSettings;
+    globalSettings.setSolverThreads(threads);
+    globalSettings.sethOutput(0.1);
+    globalSettings.setOutputPointType(OPT_ALL);
+    SETTINGS settings(&globalSettings);
+    settings.setATol(tol);
+    settings.setRTol(tol);
+    settings.setLowerLimit(1e-14);
+    settings.setUpperLimit(1e9);
+    settings.setDenseOutput(true);
+
+    double start = omp_get_wtime();
+    try
+    {
+        SOLVER solver(&model, &settings);
+        solver.setStartTime(0);
+        solver.setEndTime(tEnd);
+        solver.solve(ISolver::SOLVERCALL(ISolver::FIRST_CALL | ISolver::RECORDCALL));
+        solver.setStartTime(0);
+        solver.setEndTime(tEnd);
+        solver.solve(ISolver::FIRST_CALL);
+        if (solver.getSolverStatus() != ISolver::DONE)
+            return -1;
+    }
+    catch (std::exception& ex)
+    {
+        printf("%s\n", ex.what());
+        return -1;
+    }
+    *seconds = omp_get_wtime() - start;
+
+    if (model._problem == TestModel::VAN_DER_POL)
+        return fabs(model._y[0] - vanDerPolReference);
+    double err = 0;
+    for (size_t k = 0; k < model._outputTimes.size(); k++)
+        err = std::max(err, fabs(model._outputValues[k] - TestModel::exactSolution(model._outputTimes[k])));
+    return err;
+}
+
+static void printResult(const char* solverName, int threads, double tol, double err, const TestModel& model, double seconds)
+{
+    if (err < 0)
+        printf("%-6s %7d %8.0e   failed\n", solverName, threads, tol);
+    else
+        printf("%-6s %7d %8.0e %10.3e %10ld %10.4f\n", solverName, threads, tol, err, *model._numRHS, seconds);
+}
+
+int main(int argc, char** argv)
+{
+    const char* names[] = { "oscillator", "Van der Pol (mu = 10)", "Prothero-Robinson" };
+    const TestModel::PROBLEM problems[] = { TestModel::OSCILLATOR, TestModel::VAN_DER_POL, TestModel::PROTHERO_ROBINSON };
+    const int threadCounts[] = { 1, 2, 4, 8 };
+    double tEnd = argc > 1 ? atof(argv[1]) : 20.;
+    double seconds, err;
+
+    for (int p = 0; p < 3; p++)
+    {
+        // the reference of Van der Pol is only known at t = 20
+        double tEndProblem = problems[p] == TestModel::VAN_DER_POL ? 20. : tEnd;
+        printf("\n%s, t = 0 ... %g\n", names[p], tEndProblem);
+        printf("solver threads      tol      error        rhs   time [s]\n");
+        for (double tol = 1e-3; tol > 1e-10; tol *= 1e-2)
+        {
+            TestModel cvodeModel(problems[p]);
+            err = simulate<Cvode, CVodeSettings>(cvodeModel, tol, 1, tEndProblem, &seconds);
+            printResult("Cvode", 1, tol, err, cvodeModel, seconds);
+
+            for (int i = 0; i < 4; i++)
+            {
+                TestModel peerModel(problems[p]);
+                err = simulate<Peer, PeerSettings>(peerModel, tol, threadCounts[i], tEndProblem, &seconds);
+                printResult("Peer", threadCounts[i], tol, err, peerModel, seconds);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/* Runs the Peer solver on the systems of test_model.h and compares with
+ * the exact solutions, tolerance proportionality and analytic event times.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/SimulationSettings/IGlobalSettings.h>
+#include <Core/SimulationSettings/GlobalSettings.h>
+#include <Solver/Peer/Peer.h>
+#include <Solver/Peer/PeerSettings.h>
+
+#include <cstdio>
+
+#include <Solver/test/test_model.h>
+
+/* simulates from 0 to tEnd with output interval hOut */
+static int simulate(TestModel& model, double tol, int threads, double tEnd, double hOut)
+{
+    GlobalSettings globalSettings;
+    globalSettings.setSolverThreads(threads);
+    globalSettings.sethOutput(hOut);
+    globalSettings.setOutputPointType(OPT_ALL);
+    PeerSettings settings(&globalSettings);
+    settings.setATol(tol);
+    settings.setRTol(tol);
+    settings.setLowerLimit(1e-14);
+    settings.setUpperLimit(1e9);
+
+    try
+    {
+        Peer peer(&model, &settings);
+        peer.setStartTime(0);
+        peer.setEndTime(tEnd);
+        peer.solve(ISolver::SOLVERCALL(ISolver::FIRST_CALL | ISolver::RECORDCALL));
+        peer.setStartTime(0);
+        peer.setEndTime(tEnd);
+        peer.solve(ISolver::FIRST_CALL);
+        if (peer.getSolverStatus() != ISolver::DONE)
+            return 1;
+    }
+    catch (std::exception& ex)
+    {
+        printf("%s\n", ex.what());
+        return 2;
+    }
+    if (fabs(model._t - tEnd) > 1e-12 * tEnd)
+        return 3;
+    return 0;
+}
+
+/* largest error of the first state at the output points */
+static double maxOutputError(const TestModel& model)
+{
+    double err = 0;
+    for (size_t k = 0; k < model._outputTimes.size(); k++)
+        err = std::max(err, fabs(model._outputValues[k] - TestModel::exactSolution(model._outputTimes[k])));
+    return err;
+}
+
+/* the global error of the oscillator decreases with the tolerance, dense output hits the output grid */
+static int test_oscillator()
+{
+    double lastErr = 1;
+    int rc;
+
+    for (double tol = 1e-3; tol > 1e-10; tol *= 1e-2)
+    {
+        TestModel model(TestModel::OSCILLATOR);
+        if ((rc = simulate(model, tol, 2, 10., 0.1)) != 0)
+            return rc;
+        double err = maxOutputError(model);
+        printf("oscillator: tol %g error %.3e, %ld rhs, %zu outputs\n", tol, err, *model._numRHS, model._outputTimes.size());
+        if (err > 100 * tol || err > lastErr)
+            return 10;
+        if (model._outputTimes.size() < 101)
+            return 11;
+        for (int k = 0; k <= 100; k++)
+        {
+            bool found = false;
+            for (size_t i = 0; i < model._outputTimes.size() && !found; i++)
+                found = fabs(model._outputTimes[i] - 0.1 * k) < 1e-10;
+            if (!found)
+                return 12;
+        }
+        lastErr = err;
+    }
+    return 0;
+}
+
+/* the stiff Prothero-Robinson equation must not force step sizes of the order 1e-4 */
+static int test_protheroRobinson()
+{
+    TestModel model(TestModel::PROTHERO_ROBINSON);
+    int rc;
+
+    if ((rc = simulate(model, 1e-6, 2, 10., 0.1)) != 0)
+        return rc;
+    double err = maxOutputError(model);
+    printf("Prothero-Robinson: error %.3e, %ld rhs\n", err, *model._numRHS);
+    if (err > 1e-4)
+        return 10;
+    if (*model._numRHS > 100000)
+        return 11;
+    return 0;
+}
+
+/* Van der Pol with mu = 10, compared with x(20) from Dormand-Prince at tolerance 1e-13 */
+static int test_vanDerPol()
+{
+    TestModel model(TestModel::VAN_DER_POL);
+    const double reference = 1.9393585328;
+    int rc;
+
+    if ((rc = simulate(model, 1e-8, 2, 20., 0.1)) != 0)
+        return rc;
+    printf("Van der Pol: x(20) = %.10f, error %.3e, %ld rhs\n", model._y[0], fabs(model._y[0] - reference), *model._numRHS);
+    if (fabs(model._y[0] - reference) > 1e-5)
+        return 10;
+    return 0;
+}
+
+/* the impact times of the bouncing ball are known analytically */
+static int test_bouncingBall()
+{
+    TestModel model(TestModel::BOUNCING_BALL);
+    const double g = 9.81, e = 0.8;
+    int rc;
+
+    if ((rc = simulate(model, 1e-8, 2, 3., 0.1)) != 0)
+        return rc;
+    if (model._eventTimes.size() < 3)
+        return 10;
+
+    double tImpact = sqrt(2. / g), v = sqrt(2. * g);
+    for (size_t k = 0; k < 3; k++)
+    {
+        printf("bouncing ball: impact %zu at %.12f, exact %.12f\n", k, model._eventTimes[k], tImpact);
+        if (fabs(model._eventTimes[k] - tImpact) > 1e-6)
+            return 11;
+        v *= e;
+        tImpact += 2. * v / g;
+    }
+    return 0;
+}
+
+/* main */
+int main()
+{
+    /* return code */
+    int rc;
+
+    if ((rc = test_oscillator()) != 0) return 1000 + rc;
+    if ((rc = test_protheroRobinson()) != 0) return 2000 + rc;
+    if ((rc = test_vanDerPol()) != 0) return 3000 + rc;
+    if ((rc = test_bouncingBall()) != 0) return 4000 + rc;
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#if defined(__vxworks)
+
+#include <Solver/RungeKutta/RungeKutta.h>
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+extern "C" ISolver* createRungeKutta(IMixedSystem* system, ISolverSettings* settings)
+{
+    return new RungeKutta(system,settings);
+}
+
+extern "C" ISolverSettings* createRungeKuttaSettings(IGlobalSettings* globalSettings)
+{
+    return new RungeKuttaSettings(globalSettings);
+}
+
+#elif defined(SIMSTER_BUILD)
+
+#include <Policies/FactoryConfig.h>
+#include <Solver/RungeKutta/RungeKutta.h>
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+/*Simster factory*/
+extern "C" void BOOST_EXTENSION_EXPORT_DECL extension_export_rungekutta(boost::extensions::factory_map & fm)
+{
+    fm.get<ISolver,int,IMixedSystem*, ISolverSettings*>()[1].set<RungeKutta>();
+    fm.get<ISolverSettings,int, IGlobalSettings* >()[2].set<RungeKuttaSettings>();
+}
+
+#elif defined(OMC_BUILD)
+
+#include <SimCoreFactory/OMCFactory/OMCFactory.h>
+#include <Solver/RungeKutta/RungeKutta.h>
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+    /* OMC factory, every method is selected by its own solver name */
+    using boost::extensions::factory;
+
+    BOOST_EXTENSION_TYPE_MAP_FUNCTION {
+    std::map<std::string, factory<ISolver,IMixedSystem*, ISolverSettings*> >& solvers
+      = types.get<std::map<std::string, factory<ISolver,IMixedSystem*, ISolverSettings*> > >();
+    std::map<std::string, factory<ISolverSettings, IGlobalSettings* > >& settings
+      = types.get<std::map<std::string, factory<ISolverSettings, IGlobalSettings* > > >();
+
+    solvers["bs32Solver"].set<RungeKutta>();
+    solvers["dopri45Solver"].set<RungeKutta>();
+    solvers["verner65Solver"].set<RungeKutta>();
+    solvers["trbdf2Solver"].set<RungeKutta>();
+    solvers["esdirk43Solver"].set<RungeKutta>();
+    solvers["sdirk43Solver"].set<RungeKutta>();
+
+    settings["bs32Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::BOGACKI_SHAMPINE_32> >();
+    settings["dopri45Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::DORMAND_PRINCE_45> >();
+    settings["verner65Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::VERNER_65> >();
+    settings["trbdf2Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::TR_BDF2> >();
+    settings["esdirk43Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::ESDIRK_43> >();
+    settings["sdirk43Settings"].set<RungeKuttaMethodSettings<IRungeKuttaSettings::SDIRK_43> >();
+    }
+
+#else
+error "operating system not supported"
+#endif
+
+/** @} */ // end of solverRungeKutta
@@ -0,0 +1,779 @@
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+
+#include <Core/Math/ILapack.h>
+#include <Solver/RungeKutta/RungeKutta.h>
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+/// Bogacki-Shampine 3(2), first same as last
+static const double bs32A[] = {
+  0.,      0.,      0.,      0.,
+  1./2.,   0.,      0.,      0.,
+  0.,      3./4.,   0.,      0.,
+  2./9.,   1./3.,   4./9.,   0.};
+static const double bs32b[] = {2./9., 1./3., 4./9., 0.};
+static const double bs32bHat[] = {7./24., 1./4., 1./3., 1./8.};
+static const double bs32c[] = {0., 1./2., 3./4., 1.};
+
+/// Dormand-Prince 5(4), first same as last
+static const double dopri45A[] = {
+  0.,              0.,               0.,              0.,            0.,                0.,          0.,
+  1./5.,           0.,               0.,              0.,            0.,                0.,          0.,
+  3./40.,          9./40.,           0.,              0.,            0.,                0.,          0.,
+  44./45.,         -56./15.,         32./9.,          0.,            0.,                0.,          0.,
+  19372./6561.,    -25360./2187.,    64448./6561.,    -212./729.,    0.,                0.,          0.,
+  9017./3168.,     -355./33.,        46732./5247.,    49./176.,      -5103./18656.,     0.,          0.,
+  35./384.,        0.,               500./1113.,      125./192.,     -2187./6784.,      11./84.,     0.};
+static const double dopri45b[] = {35./384., 0., 500./1113., 125./192., -2187./6784., 11./84., 0.};
+static const double dopri45bHat[] = {5179./57600., 0., 7571./16695., 393./640., -92097./339200., 187./2100., 1./40.};
+static const double dopri45c[] = {0., 1./5., 3./10., 4./5., 8./9., 1., 1.};
+
+/// Verner 6(5) (DVERK)
+static const double verner65A[] = {
+  0.,               0.,           0.,                 0.,            0.,                0.,   0.,               0.,
+  1./6.,            0.,           0.,                 0.,            0.,                0.,   0.,               0.,
+  4./75.,           16./75.,      0.,                 0.,            0.,                0.,   0.,               0.,
+  5./6.,            -8./3.,       5./2.,              0.,            0.,                0.,   0.,               0.,
+  -165./64.,        55./6.,       -425./64.,          85./96.,       0.,                0.,   0.,               0.,
+  12./5.,           -8.,          4015./612.,         -11./36.,      88./255.,          0.,   0.,               0.,
+  -8263./15000.,    124./75.,     -643./680.,         -81./250.,     2484./10625.,      0.,   0.,               0.,
+  3501./1720.,      -300./43.,    297275./52632.,     -319./2322.,   24068./84065.,     0.,   3850./26703.,     0.};
+static const double verner65b[] = {3./40., 0., 875./2244., 23./72., 264./1955., 0., 125./11592., 43./616.};
+static const double verner65bHat[] = {13./160., 0., 2375./5984., 5./16., 12./85., 3./44., 0., 0.};
+static const double verner65c[] = {0., 1./6., 4./15., 2./3., 5./6., 1., 1./15., 1.};
+
+/// TR-BDF2 as ESDIRK 2(3) with the third order estimator of Hosea and Shampine, gamma = 1-sqrt(2)/2
+#define TRBDF2_D 0.29289321881345247560
+#define TRBDF2_W 0.35355339059327376220
+static const double trbdf2A[] = {
+  0.,          0.,          0.,
+  TRBDF2_D,    TRBDF2_D,    0.,
+  TRBDF2_W,    TRBDF2_W,    TRBDF2_D};
+static const double trbdf2b[] = {TRBDF2_W, TRBDF2_W, TRBDF2_D};
+static const double trbdf2bHat[] = {(1.-TRBDF2_W)/3., (3.*TRBDF2_W+1.)/3., TRBDF2_D/3.};
+static const double trbdf2c[] = {0., 2.*TRBDF2_D, 1.};
+#undef TRBDF2_D
+#undef TRBDF2_W
+
+/// ESDIRK 4(3), implicit part of ARK4(3)6L[2]SA of Kennedy and Carpenter, gamma = 1/4
+static const double esdirk43A[] = {
+  0.,                              0.,                         0.,                        0.,                  0.,              0.,
+  1./4.,                           1./4.,                      0.,                        0.,                  0.,              0.,
+  8611./62500.,                    -1743./31250.,              1./4.,                     0.,                  0.,              0.,
+  5012029./34652500.,              -654441./2922500.,          174375./388108.,           1./4.,               0.,              0.,
+  15267082809./155376265600.,      -71443401./120774400.,      730878875./902184768.,     2285395./8070912.,   1./4.,           0.,
+  82889./524892.,                  0.,                         15625./83664.,             69875./102672.,      -2260./8211.,    1./4.};
+static const double esdirk43b[] = {82889./524892., 0., 15625./83664., 69875./102672., -2260./8211., 1./4.};
+static const double esdirk43bHat[] = {4586570599./29645900160., 0., 178811875./945068544., 814220225./1159782912., -3700637./11593932., 61727./225920.};
+static const double esdirk43c[] = {0., 1./2., 83./250., 31./50., 17./20., 1.};
+
+/// SDIRK 4(3) of Hairer and Wanner, gamma = 1/4
+static const double sdirk43A[] = {
+  1./4.,           0.,              0.,          0.,          0.,
+  1./2.,           1./4.,           0.,          0.,          0.,
+  17./50.,         -1./25.,         1./4.,       0.,          0.,
+  371./1360.,      -137./2720.,     15./544.,    1./4.,       0.,
+  25./24.,         -49./48.,        125./16.,    -85./12.,    1./4.};
+static const double sdirk43b[] = {25./24., -49./48., 125./16., -85./12., 1./4.};
+static const double sdirk43bHat[] = {59./48., -17./96., 225./32., -85./12., 0.};
+static const double sdirk43c[] = {1./4., 3./4., 11./20., 1./2., 1.};
+
+/// Tableaus in the order of IRungeKuttaSettings::RKMETHOD
+static const ButcherTableau tableaus[] = {
+  {"bs32",     4, 3, 2, bs32A,     bs32b,     bs32bHat,     bs32c},
+  {"dopri45",  7, 5, 4, dopri45A,  dopri45b,  dopri45bHat,  dopri45c},
+  {"verner65", 8, 6, 5, verner65A, verner65b, verner65bHat, verner65c},
+  {"trbdf2",   3, 2, 3, trbdf2A,   trbdf2b,   trbdf2bHat,   trbdf2c},
+  {"esdirk43", 6, 4, 3, esdirk43A, esdirk43b, esdirk43bHat, esdirk43c},
+  {"sdirk43",  5, 4, 3, sdirk43A,  sdirk43b,  sdirk43bHat,  sdirk43c}};
+
+/// Sign change of a zero function between a and b (a zero at b counts as change)
+static bool zeroCrossed(double a, double b)
+{
+    return (a < 0. && b >= 0.) || (a > 0. && b <= 0.);
+}
+
+/// y += a*x
+static inline void axpy(int n, double a, const double* x, double* y)
+{
+    for(int i = 0; i < n; ++i)
+        y[i] += a*x[i];
+}
+
+RungeKutta::RungeKutta(IMixedSystem* system, ISolverSettings* settings)
+    : SolverDefaultImplementation(system, settings)
+    , _rkSettings           (dynamic_cast<IRungeKuttaSettings*>(_settings))
+    , _tableau              (NULL)
+    , _continuous_system    (NULL)
+    , _time_system          (NULL)
+    , _event_system         (NULL)
+    , _y                    (NULL)
+    , _yOld                 (NULL)
+    , _f                    (NULL)
+    , _fOld                 (NULL)
+    , _yNew                 (NULL)
+    , _k                    (NULL)
+    , _yStage               (NULL)
+    , _delta                (NULL)
+    , _fNewton              (NULL)
+    , _J                    (NULL)
+    , _M                    (NULL)
+    , _yInterp              (NULL)
+    , _zeroValLeft          (NULL)
+    , _zeroValTry           (NULL)
+    , _pivot                (NULL)
+    , _gamma                (0.0)
+    , _tStep                (0.0)
+    , _hStep                (0.0)
+    , _hFactored            (0.0)
+    , _errOld               (1.0)
+    , _rate                 (1.0)
+    , _maxRate              (0.0)
+    , _hOut                 (0.0)
+    , _tLastWrite           (0.0)
+    , _zeroTol              (1e-10)
+    , _fsal                 (false)
+    , _jacobianCurrent      (false)
+    , _needJacobian         (true)
+    , _numJacobians         (0)
+    , _numDecompositions    (0)
+    , _numNewtonFailures    (0)
+    , _numRestarts          (0)
+{
+}
+
+RungeKutta::~RungeKutta()
+{
+    if(_y)
+        delete [] _y;
+    if(_yOld)
+        delete [] _yOld;
+    if(_f)
+        delete [] _f;
+    if(_fOld)
+        delete [] _fOld;
+    if(_yNew)
+        delete [] _yNew;
+    if(_k)
+        delete [] _k;
+    if(_yStage)
+        delete [] _yStage;
+    if(_delta)
+        delete [] _delta;
+    if(_fNewton)
+        delete [] _fNewton;
+    if(_J)
+        delete [] _J;
+    if(_M)
+        delete [] _M;
+    if(_yInterp)
+        delete [] _yInterp;
+    if(_zeroValLeft)
+        delete [] _zeroValLeft;
+    if(_zeroValTry)
+        delete [] _zeroValTry;
+    if(_pivot)
+        delete [] _pivot;
+}
+
+bool RungeKutta::stateSelection()
+{
+    return SolverDefaultImplementation::stateSelection();
+}
+
+void RungeKutta::initialize()
+{
+    _continuous_system = dynamic_cast<IContinuous*>(_system);
+    _event_system = dynamic_cast<IEvent*>(_system);
+    _time_system = dynamic_cast<ITime*>(_system);
+    ISystemProperties* properties = dynamic_cast<ISystemProperties*>(_system);
+
+    //(Re-) Initialization of solver -> call default implementation service
+    SolverDefaultImplementation::initialize();
+
+    _dimSys = _continuous_system->getDimContinuousStates();
+    if(_dimSys <= 0 || !properties->isODE())
+        throw ModelicaSimulationError(SOLVER, "RungeKutta::initialize() error: invalid system dimension");
+    if(!_rkSettings)
+        throw ModelicaSimulationError(SOLVER, "RungeKutta::initialize() error: no valid settings available");
+    if(_rkSettings->getRKMethod() >= sizeof(tableaus)/sizeof(tableaus[0]))
+        throw ModelicaSimulationError(SOLVER, "RungeKutta::initialize() error: method " + to_string(_rkSettings->getRKMethod()) + " not implemented");
+
+    _tableau = &tableaus[_rkSettings->getRKMethod()];
+    const int s = _tableau->stages;
+    const double *A = _tableau->A, *b = _tableau->b;
+
+    // implicit tableaus have the constant diagonal gamma, an explicit first stage is allowed (ESDIRK)
+    _gamma = A[(s-1)*s + s-1];
+    // the last stage equals f(t+h, y+h) if it is evaluated at the new solution
+    _fsal = (_tableau->c[s-1] == 1.);
+    for(int j = 0; j < s; ++j)
+        _fsal = _fsal && (A[(s-1)*s + j] == b[j]);
+
+    if(_y)           delete [] _y;
+    if(_yOld)        delete [] _yOld;
+    if(_f)           delete [] _f;
+    if(_fOld)        delete [] _fOld;
+    if(_yNew)        delete [] _yNew;
+    if(_k)           delete [] _k;
+    if(_yStage)      delete [] _yStage;
+    if(_delta)       delete [] _delta;
+    if(_fNewton)     delete [] _fNewton;
+    if(_J)           delete [] _J;
+    if(_M)           delete [] _M;
+    if(_pivot)       delete [] _pivot;
+    if(_yInterp)     delete [] _yInterp;
+    if(_zeroValLeft) delete [] _zeroValLeft;
+    if(_zeroValTry)  delete [] _zeroValTry;
+
+    _y = new double[_dimSys];
+    _yOld = new double[_dimSys];
+    _f = new double[_dimSys];
+    _fOld = new double[_dimSys];
+    _yNew = new double[_dimSys];
+    _k = new double[s*_dimSys];
+    _yStage = new double[_dimSys];
+    _delta = new double[_dimSys];
+    _yInterp = new double[_dimSys];
+    _zeroValLeft = new double[_dimZeroFunc];
+    _zeroValTry = new double[_dimZeroFunc];
+    if(_gamma != 0.)
+    {
+        _fNewton = new double[_dimSys];
+        _J = new double[_dimSys*_dimSys];
+        _M = new double[_dimSys*_dimSys];
+        _pivot = new long int[_dimSys];
+    }
+    else
+    {
+        _fNewton = NULL;
+        _J = NULL;
+        _M = NULL;
+        _pivot = NULL;
+    }
+
+    _hOut = _settings->getGlobalSettings()->gethOutput();
+    _h = std::max(std::min(_settings->gethInit(), _settings->getUpperLimit()), _settings->getLowerLimit());
+    _numJacobians = 0;
+    _numDecompositions = 0;
+    _numNewtonFailures = 0;
+    _numRestarts = 0;
+
+    _continuous_system->evaluateAll(IContinuous::ALL);
+    _continuous_system->getContinuousStates(_y);
+    LOGGER_WRITE("RungeKutta: method " + string(_tableau->name) + " of order " + to_string(_tableau->order), LC_SOLV, LL_INFO);
+}
+
+/// Set start time for numerical solution
+void RungeKutta::setStartTime(const double& t)
+{
+    SolverDefaultImplementation::setStartTime(t);
+}
+
+/// Set end time for numerical solution
+void RungeKutta::setEndTime(const double& t)
+{
+    SolverDefaultImplementation::setEndTime(t);
+}
+
+/// Set the initial step size (needed for reinitialization after external zero search)
+void RungeKutta::setInitStepSize(const double& h)
+{
+    SolverDefaultImplementation::setInitStepSize(h);
+}
+
+/// Provides the status of the solver after returning
+ISolver::SOLVERSTATUS RungeKutta::getSolverStatus()
+{
+    return (SolverDefaultImplementation::getSolverStatus());
+}
+
+void RungeKutta::evalF(double t, const double* z, double* f)
+{
+    _time_system->setTime(t);
+    _continuous_system->setContinuousStates(z);
+    _continuous_system->evaluateODE(IContinuous::CONTINUOUS);
+    _continuous_system->getRHS(f);
+}
+
+void RungeKutta::evalJ(double t)
+{
+    // forward differences around the states at the beginning of the step, the derivatives are evaluated
+    // again because _f may be the last stage of the previous step which contains the newton error
+    evalF(t, _y, _delta);
+    std::copy(_y, _y + _dimSys, _yStage);
+    for(int j = 0; j < _dimSys; ++j)
+    {
+        double delta = sqrt(UROUND*max(1e-5, abs(_y[j])));
+        _yStage[j] = _y[j] + delta;
+        delta = _yStage[j] - _y[j];
+        evalF(t, _yStage, _fNewton);
+        double* column = &_J[j*_dimSys];
+        for(int i = 0; i < _dimSys; ++i)
+            column[i] = (_fNewton[i] - _delta[i])/delta;
+        _yStage[j] = _y[j];
+    }
+    _jacobianCurrent = true;
+    _needJacobian = false;
+    _hFactored = 0.;
+    ++_numJacobians;
+}
+
+void RungeKutta::restart(double t)
+{
+    const double atol = _settings->getATol(), rtol = _settings->getRTol();
+    double d0 = 0., d1 = 0.;
+
+    // initial step size from the ratio of states and derivatives
+    evalF(t, _y, _f);
+    for(int i = 0; i < _dimSys; ++i)
+    {
+        double sk = atol + rtol*abs(_y[i]);
+        d0 += (_y[i]/sk)*(_y[i]/sk);
+        d1 += (_f[i]/sk)*(_f[i]/sk);
+    }
+    d0 = sqrt(d0/_dimSys);
+    d1 = sqrt(d1/_dimSys);
+    double h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 1e-2*d0/d1;
+    _h = std::min(h, std::min(_settings->getUpperLimit(), 0.5*(_tEnd - t)));
+    _h = max(_h, _settings->getLowerLimit());
+
+    std::copy(_y, _y + _dimSys, _yOld);
+    std::copy(_f, _f + _dimSys, _fOld);
+    _tStep = t;
+    _hStep = 0.;
+    _errOld = 1.;
+    _rate = 1.;
+    _jacobianCurrent = false;
+    _needJacobian = true;
+    _hFactored = 0.;
+    ++_numRestarts;
+}
+
+bool RungeKutta::solveStage(double t, double h, const double* base, double* k)
+{
+    const double atol = _settings->getATol(), rtol = _settings->getRTol();
+    const double kappa = _rkSettings->getNewtonTol();
+    const int maxIter = _rkSettings->getMaxNewtonIterations();
+    const double hg = h*_gamma;
+    long int n = _dimSys, dim = 1, info = 0;
+    char trans = 'N';
+    double normOld = 0.;
+
+    if(h != _hFactored)
+    {
+        for(int i = 0; i < _dimSys*_dimSys; ++i)
+            _M[i] = -hg*_J[i];
+        for(int i = 0; i < _dimSys; ++i)
+            _M[i*_dimSys + i] += 1.;
+        dgetrf_(&n, &n, _M, &n, _pivot, &info);
+        ++_numDecompositions;
+        if(info != 0)
+        {
+            _hFactored = 0.;
+            return false;
+        }
+        _hFactored = h;
+    }
+
+    _rate = 1.;
+    // predictor: stage value with the derivatives at the beginning of the step
+    std::copy(base, base + _dimSys, _yStage);
+    axpy(_dimSys, hg, _f, _yStage);
+
+    for(int iter = 0; iter < maxIter; ++iter)
+    {
+        evalF(t, _yStage, _fNewton);
+        for(int i = 0; i < _dimSys; ++i)
+            _delta[i] = base[i] + hg*_fNewton[i] - _yStage[i];
+        dgetrs_(&trans, &n, &dim, _M, &n, _pivot, _delta, &n, &info);
+
+        double norm = 0.;
+        for(int i = 0; i < _dimSys; ++i)
+        {
+            _yStage[i] += _delta[i];
+            double e = _delta[i]/(atol + rtol*abs(_yStage[i]));
+            norm += e*e;
+        }
+        norm = sqrt(norm/_dimSys);
+
+        // convergence rate estimate damped by the previous iterations as in CVode
+        if(iter > 0)
+        {
+            double rate = norm/normOld;
+            _maxRate = max(_maxRate, rate);
+            if(rate >= 0.9)
+                return false;
+            _rate = max(0.3*_rate, rate);
+        }
+        normOld = norm;
+
+        if(norm*std::min(1., _rate) <= kappa)
+        {
+            // derivatives of the stage without amplifying the iteration error by f
+            for(int i = 0; i < _dimSys; ++i)
+                k[i] = (_yStage[i] - base[i])/hg;
+            return true;
+        }
+    }
+    return false;
+}
+
+double RungeKutta::doRKStep(double h)
+{
+    const int s = _tableau->stages;
+    const double *A = _tableau->A, *b = _tableau->b, *bHat = _tableau->bHat, *c = _tableau->c;
+    const double atol = _settings->getATol(), rtol = _settings->getRTol();
+    const double t = _tStep + _hStep;
+
+    _maxRate = 0.;
+    if(_gamma != 0. && _needJacobian)
+        evalJ(t);
+
+    for(int i = 0; i < s; ++i)
+    {
+        double* k = &_k[i*_dimSys];
+        if(i == 0 && A[0] == 0.)
+        {
+            // explicit first stage f(t,y)
+            std::copy(_f, _f + _dimSys, k);
+            continue;
+        }
+        std::copy(_y, _y + _dimSys, _yNew);
+        for(int j = 0; j < i; ++j)
+        {
+            if(A[i*s + j] != 0.)
+                axpy(_dimSys, h*A[i*s + j], &_k[j*_dimSys], _yNew);
+        }
+        if(A[i*s + i] == 0.)
+            evalF(t + c[i]*h, _yNew, k);
+        else if(!solveStage(t + c[i]*h, h, _yNew, k))
+            return -1.;
+    }
+
+    // solution and embedded error estimate
+    std::copy(_y, _y + _dimSys, _yNew);
+    std::fill(_delta, _delta + _dimSys, 0.);
+    for(int j = 0; j < s; ++j)
+    {
+        const double* k = &_k[j*_dimSys];
+        if(b[j] != 0.)
+            axpy(_dimSys, h*b[j], k, _yNew);
+        if(b[j] != bHat[j])
+            axpy(_dimSys, h*(b[j] - bHat[j]), k, _delta);
+    }
+    if(_gamma != 0. && _hFactored == h)
+    {
+        // filter the estimate of implicit methods with the iteration matrix to damp stiff components (Shampine)
+        long int n = _dimSys, dim = 1, info = 0;
+        char trans = 'N';
+        dgetrs_(&trans, &n, &dim, _M, &n, _pivot, _delta, &n, &info);
+    }
+
+    double err = 0.;
+    for(int i = 0; i < _dimSys; ++i)
+    {
+        double e = _delta[i]/(atol + rtol*max(abs(_y[i]), abs(_yNew[i])));
+        err += e*e;
+    }
+    return sqrt(err/_dimSys);
+}
+
+void RungeKutta::interpolate(double t, double* y)
+{
+    if(_hStep <= 0.)
+    {
+        std::copy(_y, _y + _dimSys, y);
+        return;
+    }
+    // cubic Hermite polynomial of the states and derivatives at both ends of the step
+    const double theta = (t - _tStep)/_hStep;
+    const double w0 = (1. - theta)*(1. - theta)*(1. + 2.*theta);
+    const double w1 = theta*theta*(3. - 2.*theta);
+    const double v0 = _hStep*theta*(1. - theta)*(1. - theta);
+    const double v1 = -_hStep*theta*theta*(1. - theta);
+    for(int i = 0; i < _dimSys; ++i)
+        y[i] = w0*_yOld[i] + w1*_y[i] + v0*_fOld[i] + v1*_f[i];
+}
+
+void RungeKutta::giveZeroVal(double t, double* zeroValue)
+{
+    interpolate(t, _yInterp);
+    _time_system->setTime(t);
+    _continuous_system->setContinuousStates(_yInterp);
+    _continuous_system->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(zeroValue);
+}
+
+/// Does time integration loop
+void RungeKutta::solve(const SOLVERCALL action)
+{
+    bool writeEventOutput = (_settings->getGlobalSettings()->getOutputPointType() == OPT_ALL);
+    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
+
+    if((action & RECORDCALL) && (action & FIRST_CALL))
+    {
+        initialize();
+        if(writeOutput)
+            SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
+        _tLastWrite = _tCurrent;
+        return;
+    }
+    if((action & RECORDCALL) && !(action & FIRST_CALL))
+    {
+        SolverDefaultImplementation::writeToFile(_accStps, _tCurrent, _h);
+        return;
+    }
+    // the new state after a time event is recorded
+    if((action & RECALL) && writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
+
+    const int s = _tableau->stages;
+    const double safety = 0.9, facMin = 0.2, facMax = 5.;
+    const double endTimeTol = _settings->getEndTimeTol();
+    // exponent of the error controller from the order of the error estimate
+    const double exponent = 1./(std::min(_tableau->order, _tableau->embeddedOrder) + 1.);
+    bool rejected = false;
+    double tFront = _tCurrent;
+
+    // states and discrete variables may have been changed by time events of the SimManager
+    _continuous_system->getContinuousStates(_y);
+    _continuous_system->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(_zeroValLastSuccess);
+    restart(tFront);
+
+    _solverStatus = ISolver::CONTINUE;
+    while((_solverStatus & ISolver::CONTINUE) && !_interrupt)
+    {
+        if(_tEnd - tFront <= endTimeTol)
+        {
+            _solverStatus = ISolver::DONE;
+            break;
+        }
+        double h = std::min(_h, _tEnd - tFront);
+        double err = doRKStep(h);
+        ++_totStps;
+        if(err < 0. || err > 1.)
+        {
+            ++_rejStps;
+            if(err < 0.)
+            {
+                // newton iteration failed: first with a new jacobian, then with a smaller step
+                ++_numNewtonFailures;
+                if(!_jacobianCurrent)
+                {
+                    _needJacobian = true;
+                    continue;
+                }
+                _h = 0.25*h;
+            }
+            else
+                _h = h*max(facMin, safety*pow(err, -exponent));
+            rejected = true;
+            if(_h < max(_settings->getLowerLimit(), 10.*UROUND*abs(tFront)))
+                throw ModelicaSimulationError(SOLVER, "RungeKutta: step size too small at time " + to_string(tFront));
+            continue;
+        }
+
+        // PI controller (Gustafsson), no increase of the step size after a rejection
+        err = max(err, 1e-4);
+        double fac = safety*pow(err, -0.7*exponent)*pow(_errOld, 0.4*exponent);
+        fac = std::min(facMax, max(facMin, fac));
+        if(rejected)
+            fac = std::min(fac, 1.);
+        // keep the step size for small changes to reuse the decomposition of implicit methods
+        if(_gamma != 0. && fac >= 1. && fac <= 1.2)
+            fac = 1.;
+        _h = std::min(h*fac, _settings->getUpperLimit());
+        _errOld = err;
+        rejected = false;
+        ++_accStps;
+
+        // the jacobian is kept as long as the newton iteration converges fast
+        _jacobianCurrent = false;
+        _needJacobian = (_maxRate > 0.5);
+
+        std::swap(_yOld, _y);
+        std::swap(_y, _yNew);
+        std::swap(_fOld, _f);
+        _tStep = tFront;
+        _hStep = h;
+        tFront = _tStep + h;
+        if(_fsal)
+            std::copy(&_k[(s - 1)*_dimSys], &_k[s*_dimSys], _f);
+        else
+            evalF(tFront, _y, _f);
+
+        if(completeStep(_tStep, tFront))
+        {
+            // state event: restart at the event time
+            tFront = _tCurrent;
+            restart(tFront);
+            rejected = false;
+        }
+        else
+            _tCurrent = tFront;
+        if(_continuous_system->stepCompleted(_tCurrent))
+            _solverStatus = ISolver::DONE;
+    }
+    if(_interrupt)
+        _solverStatus = ISolver::DONE;
+
+    if(_tEnd - _tCurrent <= endTimeTol)
+        _tCurrent = _tEnd;
+    _time_system->setTime(_tCurrent);
+    _continuous_system->setContinuousStates(_y);
+    _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
+    if(writeOutput && _settings->getDenseOutput() && _tLastWrite < _tCurrent)
+        SolverDefaultImplementation::writeToFile(_accStps, _tCurrent, _hStep);
+}
+
+bool RungeKutta::completeStep(double tLeft, double tRight)
+{
+    bool writeEventOutput = (_settings->getGlobalSettings()->getOutputPointType() == OPT_ALL);
+    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
+    bool zeroFound = false;
+    double tEvent = tRight;
+
+    if(_dimZeroFunc > 0)
+    {
+        giveZeroVal(tRight, _zeroVal);
+        for(int i = 0; i < _dimZeroFunc; ++i)
+            zeroFound = zeroFound || zeroCrossed(_zeroValLastSuccess[i], _zeroVal[i]);
+    }
+    if(zeroFound)
+    {
+        // Illinois method on the interpolation polynomial, searching the first zero crossing in (tLeft, tRight]
+        double tL = tLeft, tR = tRight;
+        int side = 0;
+        memcpy(_zeroValLeft, _zeroValLastSuccess, _dimZeroFunc*sizeof(double));
+        while(tR - tL > max(_zeroTol, 4.*UROUND*abs(tR)))
+        {
+            double tTry = tR;
+            for(int i = 0; i < _dimZeroFunc; ++i)
+            {
+                if(zeroCrossed(_zeroValLeft[i], _zeroVal[i]) && _zeroVal[i] != _zeroValLeft[i])
+                    tTry = std::min(tTry, tL - _zeroValLeft[i]*(tR - tL)/(_zeroVal[i] - _zeroValLeft[i]));
+            }
+            tTry = std::min(max(tTry, tL + 0.5*_zeroTol), tR - 0.5*_zeroTol);
+            giveZeroVal(tTry, _zeroValTry);
+            bool crossed = false;
+            for(int i = 0; i < _dimZeroFunc; ++i)
+                crossed = crossed || zeroCrossed(_zeroValLeft[i], _zeroValTry[i]);
+            if(crossed)
+            {
+                tR = tTry;
+                memcpy(_zeroVal, _zeroValTry, _dimZeroFunc*sizeof(double));
+                if(side == -1)
+                {
+                    for(int i = 0; i < _dimZeroFunc; ++i)
+                        _zeroValLeft[i] *= 0.5;
+                }
+                side = -1;
+            }
+            else
+            {
+                tL = tTry;
+                memcpy(_zeroValLeft, _zeroValTry, _dimZeroFunc*sizeof(double));
+                if(side == 1)
+                {
+                    for(int i = 0; i < _dimZeroFunc; ++i)
+                        _zeroVal[i] *= 0.5;
+                }
+                side = 1;
+            }
+            ++_zeroStps;
+        }
+        for(int i = 0; i < _dimZeroFunc; ++i)
+            _events[i] = zeroCrossed(_zeroValLeft[i], _zeroVal[i]);
+        tEvent = tR;
+    }
+
+    // output at the equidistant output points from the interpolation polynomial
+    if(writeOutput)
+    {
+        if(_settings->getDenseOutput() && _hOut > 0.)
+        {
+            while(_tLastWrite + _hOut <= tEvent)
+            {
+                _tLastWrite += _hOut;
+                interpolate(_tLastWrite, _yInterp);
+                _time_system->setTime(_tLastWrite);
+                _continuous_system->setContinuousStates(_yInterp);
+                _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
+                SolverDefaultImplementation::writeToFile(_accStps, _tLastWrite, _hStep);
+            }
+        }
+        else if(!zeroFound)
+        {
+            _time_system->setTime(tRight);
+            _continuous_system->setContinuousStates(_y);
+            _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
+            SolverDefaultImplementation::writeToFile(_accStps, tRight, _hStep);
+        }
+    }
+
+    if(!zeroFound)
+    {
+        if(_dimZeroFunc > 0)
+            memcpy(_zeroValLastSuccess, _zeroVal, _dimZeroFunc*sizeof(double));
+        _time_system->setTime(tRight);
+        _continuous_system->setContinuousStates(_y);
+        return false;
+    }
+
+    interpolate(tEvent, _y);
+    _tCurrent = tEvent;
+    _time_system->setTime(tEvent);
+    _continuous_system->setContinuousStates(_y);
+    _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
+    // values before (P1) and after (P2) the event, see CVode
+    if(writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, tEvent, _hStep);
+    if(_system->handleSystemEvents(_events))
+        _continuous_system->getContinuousStates(_y);
+    _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
+    if(writeEventOutput)
+        SolverDefaultImplementation::writeToFile(0, tEvent, _hStep);
+    _continuous_system->evaluateZeroFuncs(IContinuous::CONTINUOUS);
+    _event_system->getZeroFunc(_zeroValLastSuccess);
+    ++_zeros;
+    return true;
+}
+
+void RungeKutta::setTimeOut(unsigned int time_out)
+{
+    SimulationMonitor::setTimeOut(time_out);
+}
+
+void RungeKutta::stop()
+{
+    SimulationMonitor::stop();
+}
+
+void RungeKutta::writeSimulationInfo()
+{
+    LOGGER_WRITE("RungeKutta: method = " + string(_tableau ? _tableau->name : ""), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("RungeKutta: number steps = " + to_string(_accStps), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("RungeKutta: rejected steps = " + to_string(_rejStps), LC_SOLV, LL_INFO);
+    if(_gamma != 0.)
+    {
+        LOGGER_WRITE("RungeKutta: jacobian evaluations = " + to_string(_numJacobians), LC_SOLV, LL_INFO);
+        LOGGER_WRITE("RungeKutta: decompositions = " + to_string(_numDecompositions), LC_SOLV, LL_INFO);
+        LOGGER_WRITE("RungeKutta: newton failures = " + to_string(_numNewtonFailures), LC_SOLV, LL_INFO);
+    }
+    LOGGER_WRITE("RungeKutta: restarts = " + to_string(_numRestarts), LC_SOLV, LL_INFO);
+    LOGGER_WRITE("RungeKutta: state events = " + to_string(_zeros), LC_SOLV, LL_INFO);
+}
+
+int RungeKutta::reportErrorMessage(ostream& messageStream)
+{
+    if(_solverStatus == ISolver::USER_STOP)
+        messageStream << "Simulation terminated by user at t: " << _tCurrent << std::endl;
+    return 0;
+}
+/** @} */ // end of solverRungeKutta
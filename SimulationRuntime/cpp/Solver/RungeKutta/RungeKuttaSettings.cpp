@@ -0,0 +1,48 @@
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+RungeKuttaSettings::RungeKuttaSettings(IGlobalSettings* globalSettings)
+  : SolverSettings          (globalSettings)
+  , _method                 (DORMAND_PRINCE_45)
+  , _maxNewtonIterations    (7)
+  , _newtonTol              (0.05)
+{
+}
+
+RungeKuttaSettings::~RungeKuttaSettings()
+{
+}
+
+unsigned int RungeKuttaSettings::getRKMethod()
+{
+    return _method;
+}
+void RungeKuttaSettings::setRKMethod(unsigned int method)
+{
+    _method = method;
+}
+
+double RungeKuttaSettings::getNewtonTol()
+{
+    return _newtonTol;
+}
+void RungeKuttaSettings::setNewtonTol(double tol)
+{
+    _newtonTol = tol;
+}
+
+unsigned int RungeKuttaSettings::getMaxNewtonIterations()
+{
+    return _maxNewtonIterations;
+}
+void RungeKuttaSettings::setMaxNewtonIterations(unsigned int iterations)
+{
+    _maxNewtonIterations = iterations;
+}
+/** @} */ // end of solverRungeKutta
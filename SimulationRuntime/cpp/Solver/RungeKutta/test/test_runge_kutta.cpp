@@ -0,0 +1,208 @@
+/** @addtogroup solverRungeKutta
+ *
+ *  @{
+ */
+
+/* Runs the Butcher tableaus of the RungeKutta solver on the systems of
+ * test_model.h: the convergence order with constant step sizes, the location
+ * of state events and the step counts on stiff problems.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/SimulationSettings/IGlobalSettings.h>
+#include <Core/SimulationSettings/GlobalSettings.h>
+#include <Solver/RungeKutta/RungeKutta.h>
+#include <Solver/RungeKutta/RungeKuttaSettings.h>
+
+#include <cstdio>
+
+#include <Solver/test/test_model.h>
+
+static const char* methodNames[] = { "bs32", "dopri45", "verner65", "trbdf2", "esdirk43", "sdirk43" };
+static const int methodOrders[] = { 3, 5, 6, 2, 4, 4 };
+static const int numMethods = 6;
+
+/* simulates from 0 to tEnd with step sizes between hMin and hMax, output at the steps */
+static int simulate(TestModel& model, unsigned int method, double atol, double rtol, double newtonTol,
+                    double hMin, double hMax, double tEnd)
+{
+    GlobalSettings globalSettings;
+    globalSettings.setOutputPointType(OPT_ALL);
+    RungeKuttaSettings settings(&globalSettings);
+    settings.setRKMethod(method);
+    settings.setATol(atol);
+    settings.setRTol(rtol);
+    settings.setNewtonTol(newtonTol);
+    settings.setMaxNewtonIterations(20);
+    settings.setLowerLimit(hMin);
+    settings.setUpperLimit(hMax);
+    settings.setDenseOutput(false);
+
+    try
+    {
+        RungeKutta solver(&model, &settings);
+        solver.setStartTime(0);
+        solver.setEndTime(tEnd);
+        solver.solve(ISolver::SOLVERCALL(ISolver::FIRST_CALL | ISolver::RECORDCALL));
+        solver.setStartTime(0);
+        solver.setEndTime(tEnd);
+        solver.solve(ISolver::FIRST_CALL);
+        if (solver.getSolverStatus() != ISolver::DONE)
+            return 1;
+    }
+    catch (std::exception& ex)
+    {
+        printf("%s: %s\n", methodNames[method], ex.what());
+        return 2;
+    }
+    if (fabs(model._t - tEnd) > 1e-12 * tEnd)
+        return 3;
+    return 0;
+}
+
+/* error of the Kepler orbit at t = 2 with n constant steps: the lower and upper
+ * limit of the step size coincide and the tolerance never rejects a step */
+static int keplerError(unsigned int method, int n, double* err)
+{
+    TestModel model(TestModel::KEPLER);
+    const double tEnd = 2.;
+    int rc;
+
+    if ((rc = simulate(model, method, 1., 0., 1e-12, tEnd / n, tEnd / n, tEnd)) != 0)
+        return rc;
+    *err = std::max(fabs(model._y[0] - cos(tEnd)), fabs(model._y[1] - sin(tEnd)));
+    return 0;
+}
+
+/* halving the step size reduces the global error by 2^order */
+static int test_convergenceOrder()
+{
+    // step counts with errors between the start of the asymptotic range and the rounding errors
+    const int numSteps[] = { 40, 40, 10, 40, 20, 20 };
+    int rc;
+
+    for (int method = 0; method < numMethods; method++)
+    {
+        double errCoarse, errFine;
+        if ((rc = keplerError(method, numSteps[method], &errCoarse)) != 0)
+            return rc;
+        for (int n = 2 * numSteps[method]; n <= 4 * numSteps[method]; n *= 2)
+        {
+            if ((rc = keplerError(method, n, &errFine)) != 0)
+                return rc;
+            double order = log(errCoarse / errFine) / log(2.);
+            printf("%s: %d steps, error %.3e, order %.2f\n", methodNames[method], n, errFine, order);
+            if (fabs(order - methodOrders[method]) > 0.5)
+                return 10 + method;
+            errCoarse = errFine;
+        }
+    }
+    return 0;
+}
+
+/* the impact times of the bouncing ball are known analytically */
+static int test_bouncingBall()
+{
+    const double g = 9.81, e = 0.8;
+    int rc;
+
+    for (int method = 0; method < numMethods; method++)
+    {
+        TestModel model(TestModel::BOUNCING_BALL);
+        if ((rc = simulate(model, method, 1e-8, 1e-8, 0.05, 1e-12, 1e9, 3.)) != 0)
+            return rc;
+        if (model._eventTimes.size() < 3)
+            return 10 + method;
+
+        double tImpact = sqrt(2. / g), v = sqrt(2. * g);
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (fabs(model._eventTimes[k] - tImpact) > 1e-6)
+            {
+                printf("%s: impact %zu at %.12f, exact %.12f\n", methodNames[method], k, model._eventTimes[k], tImpact);
+                return 20 + method;
+            }
+            v *= e;
+            tImpact += 2. * v / g;
+        }
+        printf("%s: %zu impacts, last one at %.12f\n", methodNames[method], model._eventTimes.size(), model._eventTimes.back());
+    }
+    return 0;
+}
+
+/* largest error of Prothero-Robinson at the steps, the cubic Hermite dense output
+ * is less accurate on the long steps of the implicit methods */
+static int protheroRobinson(unsigned int method, double* err, long* numRHS)
+{
+    TestModel model(TestModel::PROTHERO_ROBINSON);
+    int rc;
+
+    if ((rc = simulate(model, method, 1e-6, 1e-6, 0.05, 1e-12, 1e9, 10.)) != 0)
+        return rc;
+    *err = 0;
+    for (size_t k = 0; k < model._outputTimes.size(); k++)
+        *err = std::max(*err, fabs(model._outputValues[k] - TestModel::exactSolution(model._outputTimes[k])));
+    *numRHS = *model._numRHS;
+    printf("%s: Prothero-Robinson error %.3e, %ld rhs\n", methodNames[method], *err, *numRHS);
+    return 0;
+}
+
+/* the implicit methods are not restricted by the stability of the stiff Prothero-Robinson
+ * equation and need far fewer evaluations than dopri45 for the same tolerance */
+static int test_protheroRobinson()
+{
+    double err;
+    long explicitRHS, numRHS;
+    int rc;
+
+    if ((rc = protheroRobinson(IRungeKuttaSettings::DORMAND_PRINCE_45, &err, &explicitRHS)) != 0)
+        return rc;
+    for (int method = IRungeKuttaSettings::TR_BDF2; method < numMethods; method++)
+    {
+        if ((rc = protheroRobinson(method, &err, &numRHS)) != 0)
+            return rc;
+        if (err > 1e-5)
+            return 10 + method;
+        if (10 * numRHS > explicitRHS)
+            return 20 + method;
+    }
+    return 0;
+}
+
+/* Van der Pol with mu = 1000, compared with x(400) from a Rosenbrock method at tolerance 1e-12 */
+static int test_vanDerPolStiff()
+{
+    const double reference = 1.69320942683;
+    int rc;
+
+    for (int method = IRungeKuttaSettings::TR_BDF2; method < numMethods; method++)
+    {
+        TestModel model(TestModel::VAN_DER_POL_STIFF);
+        if ((rc = simulate(model, method, 1e-8, 1e-8, 0.05, 1e-12, 1e9, 400.)) != 0)
+            return rc;
+        double err = fabs(model._y[0] - reference);
+        printf("%s: Van der Pol x(400) = %.10f, error %.3e, %ld rhs\n", methodNames[method], model._y[0], err, *model._numRHS);
+        if (err > 1e-5)
+            return 10 + method;
+        // explicit methods need about 2e6 evaluations
+        if (*model._numRHS > 20000)
+            return 20 + method;
+    }
+    return 0;
+}
+
+/* main */
+int main()
+{
+    /* return code */
+    int rc;
+
+    if ((rc = test_convergenceOrder()) != 0) return 1000 + rc;
+    if ((rc = test_bouncingBall()) != 0) return 2000 + rc;
+    if ((rc = test_protheroRobinson()) != 0) return 3000 + rc;
+    if ((rc = test_vanDerPolStiff()) != 0) return 4000 + rc;
+
+    return 0;
+}
+/** @} */ // end of solverRungeKutta
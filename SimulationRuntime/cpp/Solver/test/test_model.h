@@ -0,0 +1,219 @@
+#pragma once
+
+/* A small system with a fixed right hand side for driving the solvers without
+ * generated code: harmonic oscillator, Van der Pol, bouncing ball, Kepler orbit
+ * and the stiff Prothero-Robinson equation.
+ */
+
+#include <cmath>
+#include <vector>
+
+class TestModel : public IMixedSystem, public IContinuous, public ITime, public IEvent,
+                  public ISystemInitialization, public IWriteOutput, public IStateSelection, public ISystemProperties
+{
+public:
+    enum PROBLEM
+    {
+        OSCILLATOR,         ///< x'' = -x, x(0) = 1
+        VAN_DER_POL,        ///< x'' = mu (1 - x^2) x' - x, mu = 10
+        BOUNCING_BALL,      ///< h'' = -g, v := -0.8 v at h = 0
+        PROTHERO_ROBINSON,  ///< y' = -1e4 (y - cos t) - sin t
+        KEPLER,             ///< r'' = -r/|r|^3 on the unit circle
+        VAN_DER_POL_STIFF   ///< Van der Pol with mu = 1000
+    };
+
+    TestModel(PROBLEM problem)
+      : _problem(problem)
+      , _t(0)
+      , _n(problem == PROTHERO_ROBINSON ? 1 : problem == KEPLER ? 4 : 2)
+      , _numZeroFuncs(problem == BOUNCING_BALL ? 1 : 0)
+      , _numRHS(&_rhsCount)
+      , _rhsCount(0)
+    {
+        _y[0] = problem == VAN_DER_POL || problem == VAN_DER_POL_STIFF ? 2 : 1;
+        _y[1] = 0;
+        _y[2] = 0;
+        _y[3] = problem == KEPLER ? 1 : 0;
+    }
+
+    /// Exact solution of the first state, for the oscillator, Prothero-Robinson and Kepler
+    static double exactSolution(double t)
+    {
+        return cos(t);
+    }
+
+    PROBLEM _problem;
+    double _t;
+    double _y[4];
+    double _f[4];
+    int _n;
+    int _numZeroFuncs;
+    long* _numRHS;                  ///< Number of right hand side evaluations, shared with the clones
+    std::vector<double> _outputTimes;
+    std::vector<double> _outputValues;
+    std::vector<double> _eventTimes;
+
+    // IMixedSystem
+    const matrix_t& getJacobian() { return _matrix; }
+    const matrix_t& getJacobian(unsigned int index) { return _matrix; }
+    const sparsematrix_t& getSparseJacobian() { return _sparseMatrix; }
+    const sparsematrix_t& getSparseJacobian(unsigned int index) { return _sparseMatrix; }
+    const matrix_t& getStateSetJacobian(unsigned int index) { return _matrix; }
+    const sparsematrix_t& getStateSetSparseJacobian(unsigned int index) { return _sparseMatrix; }
+    bool handleSystemEvents(bool* events)
+    {
+        if (_problem == BOUNCING_BALL && events[0] && _y[1] < 0)
+        {
+            _eventTimes.push_back(_t);
+            _y[0] = 0;
+            _y[1] = -0.8 * _y[1];
+            return true;
+        }
+        return false;
+    }
+    void getAlgebraicDAEVars(double* y) {}
+    void setAlgebraicDAEVars(const double* y) {}
+    void getResidual(double* f) {}
+    string getModelName() { return "TestModel"; }
+    void getAColorOfColumn(int* aSparsePatternColorCols, int size) {}
+    int getAMaxColors() { return 0; }
+    IMixedSystem* clone() { return new TestModel(*this); }
+
+    // IContinuous
+    int getDimBoolean() const { return 0; }
+    int getDimContinuousStates() const { return _n; }
+    int getDimAE() const { return 0; }
+    int getDimInteger() const { return 0; }
+    int getDimReal() const { return 4; }
+    int getDimString() const { return 0; }
+    int getDimRHS() const { return _n; }
+    void getBoolean(bool* z) {}
+    void getContinuousStates(double* z) { std::copy(_y, _y + _n, z); }
+    void getNominalStates(double* z) { std::fill(z, z + _n, 1.0); }
+    void getInteger(int* z) {}
+    void getReal(double* z) { std::copy(_y, _y + 4, z); }
+    void getString(std::string* z) {}
+    void getRHS(double* f) { std::copy(_f, _f + _n, f); }
+    void setBoolean(const bool* z) {}
+    void setContinuousStates(const double* z) { std::copy(z, z + _n, _y); }
+    void setInteger(const int* z) {}
+    void setReal(const double* z) { std::copy(z, z + 4, _y); }
+    void setString(const std::string* z) {}
+    void setStateDerivatives(const double* f) {}
+    void restoreOldValues() {}
+    void restoreNewValues() {}
+    bool evaluateAll(const UPDATETYPE command) { evaluateRHS(); return false; }
+    void evaluateODE(const UPDATETYPE command) { evaluateRHS(); }
+    void evaluateZeroFuncs(const UPDATETYPE command) {}
+    bool evaluateConditions(const UPDATETYPE command) { return false; }
+    void evaluateDAE(const UPDATETYPE command) {}
+    bool stepCompleted(double time) { return false; }
+    bool stepStarted(double time) { return false; }
+    double& getRealStartValue(double& var) { return var; }
+    bool& getBoolStartValue(bool& var) { return var; }
+    int& getIntStartValue(int& var) { return var; }
+    string& getStringStartValue(string& var) { return var; }
+    void setRealStartValue(double& var, double val) {}
+    void setBoolStartValue(bool& var, bool val) {}
+    void setIntStartValue(int& var, int val) {}
+    void setStringStartValue(string& var, string val) {}
+    void setNumPartitions(int numPartitions) {}
+    int getNumPartitions() { return 0; }
+    void setPartitionActivation(bool* partitions) {}
+    void getPartitionActivation(bool* partitions) {}
+    int getActivator(int state) { return 0; }
+
+    // ITime
+    int getDimTimeEvent() const { return 0; }
+    void getTimeEvent(time_event_type& time_events) {}
+    void handleTimeEvent(int* time_events) {}
+    void setTime(const double& time) { _t = time; }
+
+    // IEvent
+    int getDimZeroFunc() { return _numZeroFuncs; }
+    int getDimClock() { return 0; }
+    void getZeroFunc(double* f) { if (_numZeroFuncs) f[0] = _y[0]; }
+    void setConditions(bool* c) {}
+    void getConditions(bool* c) {}
+    void getClockConditions(bool* c) {}
+    void saveAll() {}
+    void handleEvent(const bool* events) {}
+    bool checkForDiscreteEvents() { return false; }
+    bool getCondition(unsigned int index) { return false; }
+
+    // ISystemInitialization
+    void initialize() {}
+    void initEquations() {}
+    void setInitial(bool status) {}
+    bool initial() { return false; }
+
+    // IWriteOutput
+    void writeOutput(const OUTPUT command)
+    {
+        if (command & HEAD_LINE)
+            return;
+        _outputTimes.push_back(_t);
+        _outputValues.push_back(_y[0]);
+    }
+    IHistory* getHistory() { return NULL; }
+
+    // IStateSelection
+    int getDimStateSets() const { return 0; }
+    int getDimStates(unsigned int index) const { return 0; }
+    int getDimCanditates(unsigned int index) const { return 0; }
+    int getDimDummyStates(unsigned int index) const { return 0; }
+    void getStates(unsigned int index, double* z) {}
+    void setStates(unsigned int index, const double* z) {}
+    void getStateCanditates(unsigned int index, double* z) {}
+    bool getAMatrix(unsigned int index, DynArrayDim2<int>& A) { return false; }
+    void setAMatrix(unsigned int index, DynArrayDim2<int>& A) {}
+    bool getAMatrix(unsigned int index, DynArrayDim1<int>& A) { return false; }
+    void setAMatrix(unsigned int index, DynArrayDim1<int>& A) {}
+
+    // ISystemProperties
+    bool isODE() { return true; }
+    bool isAlgebraic() { return false; }
+    bool provideSymbolicJacobian() { return false; }
+
+private:
+    void evaluateRHS()
+    {
+        #pragma omp atomic
+        (*_numRHS)++;
+        switch (_problem)
+        {
+        case OSCILLATOR:
+            _f[0] = _y[1];
+            _f[1] = -_y[0];
+            break;
+        case VAN_DER_POL:
+            _f[0] = _y[1];
+            _f[1] = 10. * (1 - _y[0] * _y[0]) * _y[1] - _y[0];
+            break;
+        case BOUNCING_BALL:
+            _f[0] = _y[1];
+            _f[1] = -9.81;
+            break;
+        case PROTHERO_ROBINSON:
+            _f[0] = -1e4 * (_y[0] - cos(_t)) - sin(_t);
+            break;
+        case KEPLER:
+        {
+            double r3 = pow(_y[0] * _y[0] + _y[1] * _y[1], 1.5);
+            _f[0] = _y[2];
+            _f[1] = _y[3];
+            _f[2] = -_y[0] / r3;
+            _f[3] = -_y[1] / r3;
+            break;
+        }
+        case VAN_DER_POL_STIFF:
+            _f[0] = _y[1];
+            _f[1] = 1000. * (1 - _y[0] * _y[0]) * _y[1] - _y[0];
+            break;
+        }
+    }
+
+    long _rhsCount;
+    matrix_t _matrix;
+    sparsematrix_t _sparseMatrix;
+};
@@ -37,11 +37,41 @@
 #include "simulation/solver/delay.h"
 #include "simulation/simulation_info_json.h"
 #include "simulation/simulation_input_xml.h"
+#include "simulation/simulation_runtime.h"
 
 /*
 DLLExport pthread_key_t fmu1_thread_data_key;
 */
 
+static pthread_once_t fmu1_thread_data_once = PTHREAD_ONCE_INIT;
+
+/* mmc_thread_data_key is created by mmc_init in simulation executables only */
+static void fmu1_create_thread_data_key()
+{
+  pthread_key_create(&mmc_thread_data_key, NULL);
+}
+
+/* Makes comp the instance of the calling thread before the model code runs,
+ * so that terminate() of the model reaches its SIMULATION_INFO, see
+ * initializeTermination */
+static void setThreadData(ModelInstance *comp)
+{
+  pthread_once(&fmu1_thread_data_once, fmu1_create_thread_data_key);
+  pthread_setspecific(mmc_thread_data_key, comp->threadData);
+}
+
+/* fmiTrue if the model called terminate() */
+static fmiBoolean terminateCalled(ModelInstance *comp, const char *f)
+{
+  SIMULATION_INFO *simulationInfo = comp->fmuData->simulationInfo;
+  if (!simulationInfo->terminationTerminate)
+    return fmiFalse;
+  if (comp->loggingOn) comp->functions.logger(comp, comp->instanceName, fmiOK, "log",
+      "%s: terminate() at time %g: %s", f, comp->fmuData->localData[0]->timeValue,
+      simulationInfo->terminationMessage ? simulationInfo->terminationMessage : "");
+  return fmiTrue;
+}
+
 // array of value references of states
 #if NUMBER_OF_STATES>0
 fmiValueReference vrStates[NUMBER_OF_STATES] = STATES;
@@ -186,6 +216,8 @@ fmiComponent fmiInstantiateModel(fmiString instanceName, fmiString GUID, fmiCall
   useStream[LOG_STDOUT] = 1;
   useStream[LOG_ASSERT] = 1;
   initializeDataStruc(comp->fmuData, comp->threadData);
+  initializeTermination(comp->fmuData->simulationInfo, comp->threadData);
+  setThreadData(comp);
   /* setup model data with default start data */
   setDefaultStartValues(comp);
   setAllVarsToStart(comp->fmuData);
@@ -543,6 +575,7 @@ fmiStatus fmiGetDerivatives(fmiComponent c, fmiReal derivatives[], size_t nx)
   if (nullPointer(comp, "fmiGetDerivatives", "derivatives[]", derivatives))
     return fmiError;
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -575,6 +608,7 @@ fmiStatus fmiGetEventIndicators(fmiComponent c, fmiReal eventIndicators[], size_
   if (invalidNumber(comp, "fmiGetEventIndicators", "ni", ni, NUMBER_OF_EVENT_INDICATORS))
     return fmiError;
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -621,11 +655,12 @@ fmiStatus fmiInitialize(fmiComponent c, fmiBoolean toleranceControlled, fmiReal
       toleranceControlled, relativeTolerance);
 
   /* set zero-crossing tolerance */
-  setZCtol(relativeTolerance);
+  setZCtol(comp->fmuData, relativeTolerance);
 
   setStartValues(comp);
   copyStartValuestoInitValues(comp->fmuData);
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -653,7 +688,7 @@ fmiStatus fmiInitialize(fmiComponent c, fmiBoolean toleranceControlled, fmiReal
     eventInfo->iterationConverged = fmiTrue;
     eventInfo->stateValueReferencesChanged = fmiFalse;
     eventInfo->stateValuesChanged = fmiTrue;
-    eventInfo->terminateSimulation = fmiFalse;
+    eventInfo->terminateSimulation = terminateCalled(comp, "fmiInitialize");
 
     /* Get next event time (sample calls)*/
     nextSampleEvent = getNextSampleTimeFMU(comp->fmuData);
@@ -688,6 +723,7 @@ fmiStatus fmiEventUpdate(fmiComponent c, fmiBoolean intermediateResults, fmiEven
   if (comp->loggingOn) comp->functions.logger(c, comp->instanceName, fmiOK, "log",
       "fmiEventUpdate: Start Event Update! Next Sample Event %g", eventInfo->nextEventTime);
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -735,15 +771,14 @@ fmiStatus fmiEventUpdate(fmiComponent c, fmiBoolean intermediateResults, fmiEven
       eventInfo->iterationConverged  = fmiTrue;
       eventInfo->stateValueReferencesChanged = fmiFalse;
       eventInfo->stateValuesChanged  = fmiTrue;
-      eventInfo->terminateSimulation = fmiFalse;
     }
     else
     {
       intermediateResults = fmiFalse;
       eventInfo->iterationConverged  = fmiTrue;
       eventInfo->stateValueReferencesChanged = fmiFalse;
-      eventInfo->terminateSimulation = fmiFalse;
     }
+    eventInfo->terminateSimulation = terminateCalled(comp, "fmiEventUpdate");
 
     /* due to an event overwrite old values */
     overwriteOldSimulationData(comp->fmuData);
@@ -793,6 +828,7 @@ fmiStatus fmiCompletedIntegratorStep(fmiComponent c, fmiBoolean* callEventUpdate
   if (comp->loggingOn) comp->functions.logger(c, comp->instanceName, fmiOK, "log",
       "fmiCompletedIntegratorStep");
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -800,7 +836,8 @@ fmiStatus fmiCompletedIntegratorStep(fmiComponent c, fmiBoolean* callEventUpdate
     comp->fmuData->callback->output_function(comp->fmuData, comp->threadData);
     comp->fmuData->callback->function_storeDelayed(comp->fmuData, comp->threadData);
     storePreValues(comp->fmuData);
-    *callEventUpdate  = fmiFalse;
+    /* fmiEventUpdate reports terminate() of the model */
+    *callEventUpdate  = comp->fmuData->simulationInfo->terminationTerminate ? fmiTrue : fmiFalse;
     /******** check state selection ********/
     if (stateSelection(comp->fmuData, comp->threadData, 1, 0))
     {
@@ -839,10 +876,12 @@ fmiStatus fmiTerminate(fmiComponent c)
   freeLinearSystems(comp->fmuData, comp->threadData);
 
   /* call external objects destructors */
+  setThreadData(comp);
   comp->fmuData->callback->callExternalObjectDestructors(comp->fmuData, comp->threadData);
   /* free stateset data */
   freeStateSetData(comp->fmuData);
   deInitializeDataStruc(comp->fmuData);
+  freeTermination(comp->fmuData->simulationInfo, comp->threadData);
   /* free simuation data */
   comp->functions.freeMemory(comp->fmuData->modelData);
   comp->functions.freeMemory(comp->fmuData->simulationInfo);
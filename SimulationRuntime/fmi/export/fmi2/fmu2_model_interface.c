@@ -37,12 +37,31 @@
 #include "simulation/solver/delay.h"
 #include "simulation/simulation_info_json.h"
 #include "simulation/simulation_input_xml.h"
+#include "simulation/simulation_runtime.h"
 /*
 DLLExport pthread_key_t fmu2_thread_data_key;
 */
 
 fmi2Boolean isCategoryLogged(ModelInstance *comp, int categoryIndex);
 
+static pthread_once_t fmu2_thread_data_once = PTHREAD_ONCE_INIT;
+
+/* mmc_thread_data_key is created by mmc_init in simulation executables only */
+static void fmu2_create_thread_data_key()
+{
+  pthread_key_create(&mmc_thread_data_key, NULL);
+}
+
+/* Makes comp the instance of the calling thread before the model code runs.
+ * terminate() and asserts of the model find their threadData through
+ * mmc_thread_data_key, and the SIMULATION_INFO through the threadData, see
+ * initializeTermination. */
+static void setThreadData(ModelInstance *comp)
+{
+  pthread_once(&fmu2_thread_data_once, fmu2_create_thread_data_key);
+  pthread_setspecific(mmc_thread_data_key, comp->threadData);
+}
+
 static fmi2String logCategoriesNames[] = {"logEvents", "logSingularLinearSystems", "logNonlinearSystems", "logDynamicStateSelection",
     "logStatusWarning", "logStatusDiscard", "logStatusError", "logStatusFatal", "logStatusPending", "logAll", "logFmi2Call"};
 
@@ -52,6 +71,17 @@ static fmi2String logCategoriesNames[] = {"logEvents", "logSingularLinearSystems
     instance->functions->logger(instance->functions->componentEnvironment, instance->instanceName, status, \
         logCategoriesNames[categoryIndex], message, ##__VA_ARGS__);
 
+/* fmi2True if the model called terminate() */
+static fmi2Boolean terminateCalled(ModelInstance *comp, const char *f)
+{
+  SIMULATION_INFO *simulationInfo = comp->fmuData->simulationInfo;
+  if (!simulationInfo->terminationTerminate)
+    return fmi2False;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "%s: terminate() at time %g: %s", f, comp->fmuData->localData[0]->timeValue,
+    simulationInfo->terminationMessage ? simulationInfo->terminationMessage : "")
+  return fmi2True;
+}
+
 // array of value references of states
 #if NUMBER_OF_REALS>0
 fmi2ValueReference vrStates[NUMBER_OF_STATES] = STATES;
@@ -147,6 +177,7 @@ fmi2Status fmi2EventUpdate(fmi2Component c, fmi2EventInfo* eventInfo)
 
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2EventUpdate: Start Event Update! Next Sample Event %g", eventInfo->nextEventTime)
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -191,14 +222,13 @@ fmi2Status fmi2EventUpdate(fmi2Component c, fmi2EventInfo* eventInfo)
       eventInfo->newDiscreteStatesNeeded  = fmi2True;
       eventInfo->nominalsOfContinuousStatesChanged = fmi2False;
       eventInfo->valuesOfContinuousStatesChanged  = fmi2True;
-      eventInfo->terminateSimulation = fmi2False;
     }
     else
     {
       eventInfo->newDiscreteStatesNeeded  = fmi2False;
       eventInfo->nominalsOfContinuousStatesChanged = fmi2False;
-      eventInfo->terminateSimulation = fmi2False;
     }
+    eventInfo->terminateSimulation = terminateCalled(comp, "fmi2EventUpdate");
     FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2EventUpdate: newDiscreteStatesNeeded %s",eventInfo->newDiscreteStatesNeeded?"true":"false");
 
     /* due to an event overwrite old values */
@@ -332,6 +362,10 @@ fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2Str
 
     comp->threadData = threadData;
     comp->fmuData = fmudata;
+    comp->states = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
+    comp->states_der = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
+    comp->event_indicators = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
+    comp->event_indicators_prev = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
     if (!comp->fmuData) {
       functions->logger(functions->componentEnvironment, instanceName, fmi2Error, "error", "fmi2Instantiate: Could not initialize the global data structure file.");
       return NULL;
@@ -357,6 +391,8 @@ fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2Str
   useStream[LOG_STDOUT] = 1;
   useStream[LOG_ASSERT] = 1;
   initializeDataStruc(comp->fmuData, comp->threadData);
+  initializeTermination(comp->fmuData->simulationInfo, comp->threadData);
+  setThreadData(comp);
   /* setup model data with default start data */
   setDefaultStartValues(comp);
   setAllVarsToStart(comp->fmuData);
@@ -393,10 +429,17 @@ void fmi2FreeInstance(fmi2Component c) {
     return;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2FreeInstance")
 
+  freeTermination(comp->fmuData->simulationInfo, comp->threadData);
   /* free simuation data */
   comp->functions->freeMemory(comp->fmuData->modelData);
   comp->functions->freeMemory(comp->fmuData->simulationInfo);
 
+  /* free work arrays of fmi2DoStep */
+  comp->functions->freeMemory(comp->states);
+  comp->functions->freeMemory(comp->states_der);
+  comp->functions->freeMemory(comp->event_indicators);
+  comp->functions->freeMemory(comp->event_indicators_prev);
+
   /* free fmuData */
   comp->functions->freeMemory(comp->threadData);
   comp->functions->freeMemory(comp->fmuData);
@@ -432,11 +475,12 @@ fmi2Status fmi2EnterInitializationMode(fmi2Component c) {
     return fmi2Error;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2EnterInitializationMode...")
   /* set zero-crossing tolerance */
-  setZCtol(comp->tolerance);
+  setZCtol(comp->fmuData, comp->tolerance);
 
   setStartValues(comp);
   copyStartValuestoInitValues(comp->fmuData);
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -455,7 +499,7 @@ fmi2Status fmi2EnterInitializationMode(fmi2Component c) {
       /* due to an event overwrite old values */
       overwriteOldSimulationData(comp->fmuData);
 
-      comp->eventInfo.terminateSimulation = fmi2False;
+      comp->eventInfo.terminateSimulation = terminateCalled(comp, "fmi2EnterInitializationMode");
       comp->eventInfo.valuesOfContinuousStatesChanged = fmi2True;
 
       /* Get next event time (sample calls)*/
@@ -497,6 +541,7 @@ fmi2Status fmi2Terminate(fmi2Component c) {
     return fmi2Error;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2Terminate")
 
+  setThreadData(comp);
   /* call external objects destructors */
   comp->fmuData->callback->callExternalObjectDestructors(comp->fmuData, comp->threadData);
   /* free nonlinear system data */
@@ -529,6 +574,9 @@ fmi2Status fmi2Reset(fmi2Component c) {
     fmu2_model_interface_setupDataStruc(comp->fmuData);
     initializeDataStruc(comp->fmuData, comp->threadData);
   }
+  /* a new run starts without terminate() */
+  freeTermination(comp->fmuData->simulationInfo, comp->threadData);
+  initializeTermination(comp->fmuData->simulationInfo, comp->threadData);
   /* reset the values to start */
   setDefaultStartValues(comp);
   setAllVarsToStart(comp->fmuData);
@@ -816,6 +864,7 @@ fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStat
     return fmi2Error;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL,"fmi2CompletedIntegratorStep")
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -824,7 +873,7 @@ fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStat
     comp->fmuData->callback->function_storeDelayed(comp->fmuData, comp->threadData);
     storePreValues(comp->fmuData);
     *enterEventMode = fmi2False;
-    *terminateSimulation = fmi2False;
+    *terminateSimulation = terminateCalled(comp, "fmi2CompletedIntegratorStep");
     /******** check state selection ********/
     if (stateSelection(comp->fmuData, comp->threadData, 1, 0))
     {
@@ -892,6 +941,7 @@ fmi2Status fmi2GetDerivatives(fmi2Component c, fmi2Real derivatives[], size_t nx
   if (nullPointer(comp, "fmi2GetDerivatives", "derivatives[]", derivatives))
     return fmi2Error;
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -930,6 +980,7 @@ fmi2Status fmi2GetEventIndicators(fmi2Component c, fmi2Real eventIndicators[], s
   if (invalidNumber(comp, "fmi2GetEventIndicators", "nx", nx, NUMBER_OF_EVENT_INDICATORS))
     return fmi2Error;
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -1004,13 +1055,13 @@ fmi2Status fmi2GetRealOutputDerivatives (fmi2Component c, const fmi2ValueReferen
 
 fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
   ModelInstance *comp = (ModelInstance *)c;
-  fmi2CallbackFunctions* functions = (fmi2CallbackFunctions*)comp->functions;
   int i, zc_event = 0, time_event = 0;
   fmi2Status status = fmi2OK;
-  fmi2Real* states = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
-  fmi2Real* states_der = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
-  fmi2Real* event_indicators = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
-  fmi2Real* event_indicators_prev = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
+  /* work arrays are allocated in fmi2Instantiate, so that stepping does not allocate */
+  fmi2Real* states = comp->states;
+  fmi2Real* states_der = comp->states_der;
+  fmi2Real* event_indicators = comp->event_indicators;
+  fmi2Real* event_indicators_prev = comp->event_indicators_prev;
   fmi2Real t = comp->fmuData->localData[0]->timeValue;
   fmi2Real tNext, tEnd;
   fmi2Boolean enterEventMode = fmi2False, terminateSimulation = fmi2False;
@@ -1026,6 +1077,8 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
 
   fmi2EnterEventMode(c);
   fmi2EventIteration(c, &eventInfo);
+  if (eventInfo.terminateSimulation)
+    return fmi2Discard;
   fmi2EnterContinuousTimeMode(c);
 
   if (NUMBER_OF_STATES > 0)
@@ -1033,20 +1086,12 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     status = fmi2GetDerivatives(c, states_der, NUMBER_OF_STATES);
     if (status != fmi2OK)
     {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
     }
 
     status = fmi2GetContinuousStates(c, states, NUMBER_OF_STATES);
     if (status != fmi2OK)
     {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
     }
   }
@@ -1056,10 +1101,6 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     status = fmi2GetEventIndicators(c, event_indicators_prev, NUMBER_OF_EVENT_INDICATORS);
     if (status != fmi2OK)
     {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
     }
   }
@@ -1098,10 +1139,6 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     status = fmi2SetContinuousStates(c, states, NUMBER_OF_STATES);
     if (status != fmi2OK)
     {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
     }
   }
@@ -1110,12 +1147,13 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
   status = fmi2CompletedIntegratorStep(c, fmi2True, &enterEventMode, &terminateSimulation);
   if (status != fmi2OK)
   {
-    functions->freeMemory(states);
-    functions->freeMemory(states_der);
-    functions->freeMemory(event_indicators);
-    functions->freeMemory(event_indicators_prev);
     return fmi2Error;
   }
+  /* the model called terminate(), see fmi2GetBooleanStatus */
+  if (terminateSimulation)
+  {
+    return fmi2Discard;
+  }
 
   /* check for events */
   if (NUMBER_OF_EVENT_INDICATORS > 0)
@@ -1123,10 +1161,6 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     status = fmi2GetEventIndicators(c, event_indicators, NUMBER_OF_EVENT_INDICATORS);
     if (status != fmi2OK)
     {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
     }
 
@@ -1144,6 +1178,8 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
       fmi2EnterEventMode(c);
 
       fmi2EventIteration(c, &eventInfo);
+      if (eventInfo.terminateSimulation)
+        return fmi2Discard;
 
       if(eventInfo.valuesOfContinuousStatesChanged)
          fmi2GetContinuousStates(c, states, NUMBER_OF_STATES);
@@ -1157,10 +1193,6 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     }
   }
 
-  functions->freeMemory(states);
-  functions->freeMemory(states_der);
-  functions->freeMemory(event_indicators);
-  functions->freeMemory(event_indicators_prev);
 
   return fmi2OK;
 }
@@ -1186,6 +1218,12 @@ fmi2Status fmi2GetIntegerStatus(fmi2Component c, const fmi2StatusKind s, fmi2Int
 }
 
 fmi2Status fmi2GetBooleanStatus(fmi2Component c, const fmi2StatusKind s, fmi2Boolean* value) {
+  ModelInstance *comp = (ModelInstance *)c;
+  /* fmi2DoStep returned fmi2Discard since the model called terminate() */
+  if (s == fmi2Terminated) {
+    *value = comp->fmuData->simulationInfo->terminationTerminate ? fmi2True : fmi2False;
+    return fmi2OK;
+  }
   // TODO Write code here
   return fmi2OK;
 }
@@ -1235,6 +1273,7 @@ fmi2Status fmi2GetSpecificDerivatives(fmi2Component c, fmi2Real derivatives[], c
     return fmi2Error;
   */
 
+  setThreadData(comp);
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
@@ -82,6 +82,12 @@ typedef struct {
   fmi2Boolean stopTimeDefined;
   fmi2Real stopTime;
 
+  /* work arrays of fmi2DoStep */
+  fmi2Real *states;
+  fmi2Real *states_der;
+  fmi2Real *event_indicators;
+  fmi2Real *event_indicators_prev;
+
   int _need_update;
 #ifdef FMU_EXPERIMENTAL
   int _has_jacobian;